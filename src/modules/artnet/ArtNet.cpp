@@ -11,7 +11,7 @@
 #include "yuri/core/Module.h"
 #include "yuri/event/EventHelpers.h"
 #include "yuri/core/socket/DatagramSocketGenerator.h"
-#include <boost/regex.hpp>
+#include "yuri/exception/InitializationFailed.h"
 namespace yuri {
 namespace artnet {
 
@@ -29,6 +29,8 @@ core::Parameters ArtNet::configure()
 	p["socket"]["Socket implementation"]="yuri_udp";
 	p["address"]["Target address"]="127.0.01";
 	p["port"]["Target port"]=6454;
+	p["refresh_rate"]["Rate (in Hz) at which changed universes are sent"]=44.0;
+	p["keepalive"]["Interval (in seconds) to resend universes that didn't change. Set to 0 to disable."]=1.0;
 	return p;
 }
 
@@ -37,9 +39,12 @@ ArtNet::ArtNet(const log::Log &log_, core::pwThreadBase parent, const core::Para
 core::IOThread(log_,parent,0,0,std::string("artnet")),
 event::BasicEventConsumer(log),
 socket_impl_("yuri_udp"),address_("127.0.0.1"),port_(6454),
-changed_(true)
+refresh_rate_(44.0),keepalive_(1_s)
 {
 	IOTHREAD_INIT(parameters)
+	if (refresh_rate_ <= 0.0) {
+		throw exception::InitializationFailed("Refresh rate has to be positive");
+	}
 }
 
 ArtNet::~ArtNet() noexcept
@@ -50,66 +55,105 @@ void ArtNet::run()
 {
 	socket_ = core::DatagramSocketGenerator::get_instance().generate(socket_impl_,log,"");
 	socket_->connect(address_, port_);
+	const auto period = duration_t{static_cast<int64_t>(1e6 / refresh_rate_)};
+	timestamp_t next_tick;
 	while(still_running()){
-		wait_for_events(get_latency());
-		process_events();
-		if (changed_) {
-			changed_ = false;
-			for (auto& universe: universes_) {
-				log[log::debug] << "Updating universe " << universe.first;
-				universe.second.send(socket_);
-			}
+		const timestamp_t now;
+		if (now < next_tick) {
+			wait_for_events(std::min(next_tick - now, get_latency()));
+			process_events();
+			continue;
 		}
+		process_events();
+		send_universes(now);
+		next_tick += period;
+		// Don't try to catch up after a stall
+		if (next_tick < now) next_tick = now + period;
 	}
 
 }
 
-bool ArtNet::do_process_event(const std::string& event_name, const event::pBasicEvent& event)
+void ArtNet::send_universes(timestamp_t now)
 {
-	boost::regex universe_value("/([0-9]+)/([0-9]+)");
-	boost::regex universe_value_range("/([0-9]+)/([0-9]+)-([0-9]+)");
-	boost::smatch what;
-	if (boost::regex_match(event_name,what,universe_value, boost::match_default)) {
-		const uint16_t universe = static_cast<uint16_t>(std::stoul(std::string{what[1].first, what[1].second}));
-		const uint16_t channel = static_cast<uint16_t>(std::stoul(std::string{what[2].first, what[2].second}));
-		const uint8_t value = event::lex_cast_value<uint8_t>(event);
-		auto u = universes_.find(universe);
-		if (u != universes_.end()) {
-			u->second[channel]=value;
-		} else {
-			universes_[universe] = ArtNetPacket(universe);
-			universes_[universe][channel]=value;
-		}
-//		universes_[universe][channel]=value;
-		changed_ = true;
-	} else if (boost::regex_match(event_name,what,universe_value_range, boost::match_default)) {
-		const uint16_t universe = static_cast<uint16_t>(std::stoul(std::string{what[1].first, what[1].second}));
-		const uint16_t channel_start = static_cast<uint16_t>(std::stoul(std::string{what[2].first, what[2].second}));
-		const uint16_t channel_end = static_cast<uint16_t>(std::stoul(std::string{what[3].first, what[3].second}));
-
-		std::vector<uint8_t> values;
-		if (event->get_type() != event::event_type_t::vector_event) {
-			values.push_back(event::lex_cast_value<uint8_t>(event));
-		} else {
-			const auto& vec = event::get_value<event::EventVector>(event);
-			for (const auto& v: vec) {
-				values.push_back(event::lex_cast_value<uint8_t>(v));
-			}
-			log[log::verbose_debug] << "Routing " << values.size() << " values to channels " << channel_start << " to " << channel_end;
+	// All universes are sent together
+	datagrams_.clear();
+	sent_universes_.clear();
+	for (size_t i = 0; i < universes_.size(); ++i) {
+		auto& universe = universes_[i];
+		bool send = universe.unsent;
+		if (universe.dirty) {
+			universe.dirty = false;
+			if (universe.packet.set_data(universe.values.data(), universe.channels)) send = true;
 		}
-		auto u = universes_.find(universe);
-		if (u == universes_.end()) {
-			universes_[universe] = ArtNetPacket(universe);
+		if (!universe.packet.size()) continue;
+		if (!send && keepalive_.value > 0 && now - universe.last_sent >= keepalive_) send = true;
+		if (send) {
+			datagrams_.push_back(universe.packet.get_datagram());
+			sent_universes_.push_back(i);
 		}
-		auto& target_universe = universes_[universe];
-		auto it = values.cbegin();
-		for (auto i = channel_start; i < channel_end + 1; ++i) {
-			target_universe[i]=*it++;
-			if (it >= values.cend()) it = values.cbegin();
+	}
+	if (datagrams_.empty()) return;
+	log[log::verbose_debug] << "Sending " << datagrams_.size() << " universes";
+	const auto sent = socket_->send_datagrams(datagrams_);
+	for (size_t i = 0; i < sent_universes_.size(); ++i) {
+		auto& universe = universes_[sent_universes_[i]];
+		universe.unsent = i >= sent;
+		if (!universe.unsent) {
+			universe.packet.increment_sequence();
+			universe.last_sent = now;
 		}
+	}
+	if (sent < datagrams_.size()) {
+		log[log::warning] << "Failed to send " << (datagrams_.size() - sent) << " universes";
+	}
+}
 
-		changed_ = true;
+size_t ArtNet::get_universe(uint16_t universe)
+{
+	auto it = universe_index_.find(universe);
+	if (it != universe_index_.end()) return it->second;
+	universes_.emplace_back(universe);
+	universe_index_[universe] = universes_.size() - 1;
+	return universes_.size() - 1;
+}
+
+const ArtNet::route_entry_t& ArtNet::get_route(const std::string& event_name)
+{
+	auto it = routes_.find(event_name);
+	if (it != routes_.end()) return it->second;
+	route_entry_t entry{false, {}, 0};
+	if (parse_route(event_name, entry.route)) {
+		entry.valid = true;
+		entry.universe = get_universe(entry.route.universe);
+		log[log::debug] << "Routing " << event_name << " to universe " << entry.route.universe
+				<< ", channels " << entry.route.first_channel << " to " << entry.route.last_channel;
+	} else {
+		log[log::warning] << "Ignoring event " << event_name << ", expected /universe/channel or /universe/first-last";
+	}
+	return routes_.emplace(event_name, entry).first->second;
+}
+
+bool ArtNet::do_process_event(const std::string& event_name, const event::pBasicEvent& event)
+{
+	const auto& entry = get_route(event_name);
+	if (!entry.valid) return false;
+	const auto& route = entry.route;
+	auto& universe = universes_[entry.universe];
+	const uint16_t count = route.last_channel - route.first_channel + 1;
+	if (route.range && event->get_type() == event::event_type_t::vector_event) {
+		const auto& vec = event::get_value<event::EventVector>(event);
+		if (vec.empty()) return false;
+		log[log::verbose_debug] << "Routing " << vec.size() << " values to channels " << route.first_channel << " to " << route.last_channel;
+		// Values are repeated when the vector is shorter than the range
+		for (uint16_t i = 0; i < count; ++i) {
+			universe.values[route.first_channel + i] = event::lex_cast_value<uint8_t>(vec[i % vec.size()]);
+		}
+	} else {
+		const uint8_t value = event::lex_cast_value<uint8_t>(event);
+		std::fill_n(universe.values.begin() + route.first_channel, count, value);
 	}
+	universe.channels = std::max<uint16_t>(universe.channels, route.last_channel + 1);
+	universe.dirty = true;
 	return false;
 }
 
@@ -118,7 +162,9 @@ bool ArtNet::set_param(const core::Parameter& param)
 	if (assign_parameters(param)
 			(socket_impl_, "socket")
 			(address_, "address")
-			(port_, "port"))
+			(port_, "port")
+			(refresh_rate_, "refresh_rate")
+			(keepalive_, "keepalive", [](const core::Parameter& p){ return 1_s * p.get<double>(); }))
 		return true;
 	return core::IOThread::set_param(param);
 }
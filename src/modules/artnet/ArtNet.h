@@ -11,8 +11,10 @@
 #define ARTNET_H_
 
 #include "ArtNetPacket.h"
+#include "ArtNetRoute.h"
 #include "yuri/core/thread/IOThread.h"
 #include "yuri/event/BasicEventConsumer.h"
+#include <array>
 #include <unordered_map>
 namespace yuri {
 namespace artnet {
@@ -29,15 +31,44 @@ private:
 	virtual void run() override;
 	virtual bool set_param(const core::Parameter& param) override;
 	virtual bool do_process_event(const std::string& event_name, const event::pBasicEvent& event) override;
+
+	struct universe_t {
+		universe_t(uint16_t universe):packet(universe),values(),channels(0),dirty(false),unsent(false) {}
+		//! Packet that was sent last
+		ArtNetPacket packet;
+		//! Values updated by events, copied into the packet at each tick
+		std::array<uint8_t, max_values> values;
+		uint16_t channels;
+		bool dirty;
+		//! Sending of the packet failed and should be repeated
+		bool unsent;
+		timestamp_t last_sent;
+	};
+	struct route_entry_t {
+		bool valid;
+		artnet_route_t route;
+		//! Index into universes_
+		size_t universe;
+	};
+
+	//! Returns routing for the event, parsing its name when seen for the first time
+	const route_entry_t& get_route(const std::string& event_name);
+	size_t get_universe(uint16_t universe);
+	//! Sends all universes that changed since last tick or need to be refreshed
+	void send_universes(timestamp_t now);
+
 	std::string socket_impl_;
 	core::socket::pDatagramSocket socket_;
 	std::string address_;
 	core::socket::port_t port_;
-	bool changed_;
-
-	std::unordered_map<uint16_t, ArtNetPacket> universes_;
-
+	double refresh_rate_;
+	duration_t keepalive_;
 
+	std::unordered_map<std::string, route_entry_t> routes_;
+	std::vector<universe_t> universes_;
+	std::unordered_map<uint16_t, size_t> universe_index_;
+	std::vector<core::socket::datagram_t> datagrams_;
+	std::vector<size_t> sent_universes_;
 };
 
 } /* namespace artnet */
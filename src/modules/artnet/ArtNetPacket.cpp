@@ -9,6 +9,8 @@
 
 #include "ArtNetPacket.h"
 #include <array>
+#include <algorithm>
+#include <stdexcept>
 
 namespace yuri {
 namespace artnet {
@@ -42,6 +44,11 @@ void write_universe_into_header_16(std::vector<uint8_t>& header_, uint16_t posit
 	header_[position+1]=(value>>8)&0x7F;
 }
 
+//! ArtDmx packets has to carry even number of channels, at least 2
+uint16_t packet_length(uint16_t count)
+{
+	return std::max<uint16_t>(2, (count + 1) & ~1);
+}
 
 }
 
@@ -53,15 +60,14 @@ ArtNetPacket::ArtNetPacket(uint16_t universe):data_(default_artnet_header.begin(
 
 uint8_t& ArtNetPacket::operator[] (uint16_t index)
 {
+	if (index >= max_values) {
+		throw std::out_of_range("Index out of range");
+	}
 	const uint16_t array_index = index + header_size;
 	if (array_index >= data_.size()) {
-		if (index > max_values) {
-			throw std::out_of_range("Index out of range");
-		}
-		data_.resize(array_index+1,0);
-		write_into_header_16(data_, length_offset, index);
-//		data_[header_size-1]=index&0xFF;
-//		data_[header_size-2]=(index>>8)&0xFF;
+		const uint16_t length = packet_length(index + 1);
+		data_.resize(header_size + length, 0);
+		write_into_header_16(data_, length_offset, length);
 	}
 	return data_[array_index];
 }
@@ -72,14 +78,36 @@ uint8_t ArtNetPacket::operator[] (uint16_t index) const
 	return data_[array_index];
 }
 
+bool ArtNetPacket::set_data(const uint8_t* values, uint16_t count)
+{
+	count = std::min(count, max_values);
+	const uint16_t length = packet_length(count);
+	bool changed = false;
+	if (data_.size() != static_cast<size_t>(header_size + length)) {
+		data_.resize(header_size + length, 0);
+		write_into_header_16(data_, length_offset, length);
+		changed = true;
+	}
+	auto dest = data_.begin() + header_size;
+	if (!changed && std::equal(values, values + count, dest)) return false;
+	std::copy(values, values + count, dest);
+	std::fill(dest + count, data_.end(), 0);
+	return true;
+}
+
 bool ArtNetPacket::send(core::socket::pDatagramSocket socket)
 {
 	if (socket->send_datagram(data_)) {
-		data_[sequence_offset] = (data_[sequence_offset]+1)&0xFF;
+		increment_sequence();
 		return true;
 	}
 	return false;
 }
 
+void ArtNetPacket::increment_sequence()
+{
+	data_[sequence_offset] = (data_[sequence_offset]+1)&0xFF;
+}
+
 }
 }
@@ -28,8 +28,19 @@ public:
 	~ArtNetPacket() noexcept = default;
 	uint8_t& operator[] (uint16_t index);
 	uint8_t operator[] (uint16_t index) const;
+	/*!
+	 * Replaces the channel values, the packet is padded to even length.
+	 * @return true if the packet changed
+	 */
+	bool set_data(const uint8_t* values, uint16_t count);
+	//! Number of channels in the packet
+	uint16_t size() const { return static_cast<uint16_t>(data_.size() - header_size); }
 
 	bool send(core::socket::pDatagramSocket socket);
+	//! Returns the packet data, valid until the packet is modified
+	core::socket::datagram_t get_datagram() const { return {data_.data(), data_.size()}; }
+	//! Should be called after the packet was sent
+	void increment_sequence();
 private:
 	std::vector<uint8_t> data_;
 
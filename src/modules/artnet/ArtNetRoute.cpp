@@ -0,0 +1,56 @@
+/*!
+ * @file 		ArtNetRoute.cpp
+ * @author 		agent <agent@local>
+ * @date 		19.10.2026
+ * @copyright	Institute of Intermedia, CTU in Prague, 2026
+ * 				Distributed under modified BSD Licence, details in file doc/LICENSE
+ *
+ */
+
+#include "ArtNetRoute.h"
+#include "ArtNetPacket.h"
+
+namespace yuri {
+namespace artnet {
+
+namespace {
+//! Universe is stored in 15 bits
+const uint32_t max_universe = 0x7FFF;
+
+//! Reads decimal number, stopping at the first non-digit
+bool read_number(const char*& pos, const char* end, uint32_t max, uint16_t& value)
+{
+	uint32_t result = 0;
+	const char* start = pos;
+	while (pos < end && *pos >= '0' && *pos <= '9') {
+		result = result * 10 + (*pos - '0');
+		if (result > max) return false;
+		++pos;
+	}
+	if (pos == start) return false;
+	value = static_cast<uint16_t>(result);
+	return true;
+}
+}
+
+bool parse_route(const std::string& name, artnet_route_t& route)
+{
+	const char* pos = name.data();
+	const char* end = pos + name.size();
+	if (pos == end || *pos++ != '/') return false;
+	if (!read_number(pos, end, max_universe, route.universe)) return false;
+	if (pos == end || *pos++ != '/') return false;
+	if (!read_number(pos, end, max_values - 1, route.first_channel)) return false;
+	route.last_channel = route.first_channel;
+	route.range = false;
+	if (pos != end) {
+		if (*pos++ != '-') return false;
+		if (!read_number(pos, end, max_values - 1, route.last_channel)) return false;
+		if (route.last_channel < route.first_channel) return false;
+		route.range = true;
+	}
+	return pos == end;
+}
+
+}
+}
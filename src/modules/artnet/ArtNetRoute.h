@@ -0,0 +1,38 @@
+/*!
+ * @file 		ArtNetRoute.h
+ * @author 		agent <agent@local>
+ * @date 		19.10.2026
+ * @copyright	Institute of Intermedia, CTU in Prague, 2026
+ * 				Distributed under modified BSD Licence, details in file doc/LICENSE
+ *
+ */
+
+#ifndef SRC_MODULES_ARTNET_ARTNETROUTE_H_
+#define SRC_MODULES_ARTNET_ARTNETROUTE_H_
+
+#include <cstdint>
+#include <string>
+
+namespace yuri {
+namespace artnet {
+
+//! Target of an event, parsed from its name
+struct artnet_route_t {
+	uint16_t	universe;
+	uint16_t	first_channel;
+	//! Last channel, inclusive
+	uint16_t	last_channel;
+	//! True for /universe/first-last routes, that accept vectors
+	bool		range;
+};
+
+/*!
+ * Parses event name in the form /universe/channel or /universe/first-last
+ * @return false if the name is not a valid route
+ */
+bool parse_route(const std::string& name, artnet_route_t& route);
+
+}
+}
+
+#endif /* SRC_MODULES_ARTNET_ARTNETROUTE_H_ */
@@ -0,0 +1,94 @@
+/*!
+ * @file 		artnet_test.cpp
+ * @author 		agent <agent@local>
+ * @date 		19.10.2026
+ * @copyright	Institute of Intermedia, CTU in Prague, 2026
+ * 				Distributed under modified BSD Licence, details in file doc/LICENSE
+ *
+ */
+
+#include "tests/catch.hpp"
+#include "ArtNetRoute.h"
+#include "ArtNetPacket.h"
+
+namespace yuri {
+namespace artnet {
+
+namespace {
+	uint16_t packet_length(const ArtNetPacket& packet)
+	{
+		const auto datagram = packet.get_datagram();
+		const auto data = datagram.data;
+		return (data[16] << 8) | data[17];
+	}
+}
+
+TEST_CASE( "ArtNet routes", "[module]" ) {
+	artnet_route_t route;
+	SECTION("single channel") {
+		REQUIRE( parse_route("/3/17", route) );
+		REQUIRE( route.universe == 3 );
+		REQUIRE( route.first_channel == 17 );
+		REQUIRE( route.last_channel == 17 );
+		REQUIRE( !route.range );
+	}
+	SECTION("channel range") {
+		REQUIRE( parse_route("/0/10-19", route) );
+		REQUIRE( route.universe == 0 );
+		REQUIRE( route.first_channel == 10 );
+		REQUIRE( route.last_channel == 19 );
+		REQUIRE( route.range );
+	}
+	SECTION("limits") {
+		REQUIRE( parse_route("/32767/511", route) );
+		REQUIRE( !parse_route("/32768/0", route) );
+		REQUIRE( !parse_route("/0/512", route) );
+		REQUIRE( !parse_route("/0/0-512", route) );
+		REQUIRE( !parse_route("/0/10-9", route) );
+	}
+	SECTION("invalid names") {
+		REQUIRE( !parse_route("", route) );
+		REQUIRE( !parse_route("/", route) );
+		REQUIRE( !parse_route("/1", route) );
+		REQUIRE( !parse_route("/1/", route) );
+		REQUIRE( !parse_route("1/2", route) );
+		REQUIRE( !parse_route("/1/2-", route) );
+		REQUIRE( !parse_route("/1/2/3", route) );
+		REQUIRE( !parse_route("/a/2", route) );
+	}
+}
+
+TEST_CASE( "ArtNet packet", "[module]" ) {
+	ArtNetPacket packet(0x1234);
+	const auto datagram = packet.get_datagram();
+	const auto header = datagram.data;
+	REQUIRE( header[14] == 0x34 );
+	REQUIRE( header[15] == 0x12 );
+
+	SECTION("length is even") {
+		packet[2] = 5;
+		REQUIRE( packet.size() == 4 );
+		REQUIRE( packet_length(packet) == 4 );
+		REQUIRE( packet[2] == 5 );
+		packet[0] = 1;
+		REQUIRE( packet_length(packet) == 4 );
+		REQUIRE_THROWS( packet[512] );
+	}
+	SECTION("set data") {
+		const uint8_t values[] = {1, 2, 3};
+		REQUIRE( packet.set_data(values, 3) );
+		REQUIRE( packet_length(packet) == 4 );
+		REQUIRE( packet[2] == 3 );
+		REQUIRE( packet[3] == 0 );
+		REQUIRE( !packet.set_data(values, 3) );
+		const uint8_t values2[] = {1, 2, 4};
+		REQUIRE( packet.set_data(values2, 3) );
+		REQUIRE( packet[2] == 4 );
+		REQUIRE( packet.set_data(values2, 1) );
+		REQUIRE( packet_length(packet) == 2 );
+		REQUIRE( packet[1] == 0 );
+	}
+}
+
+}
+}
@@ -29,6 +29,11 @@ core::Parameters AVOutput::configure() {
     p["video_codec"]["Specify codec for video output."] = std::string("");
     p["audio_codec"]["Specify codec for audio output."] = std::string("");
 	p["audio"]["Allow audio in stream."] = true;
+    p["queue_packets"]["Maximal number of encoded packets waiting for the output."] = 512;
+    p["queue_bytes"]["Maximal size of encoded packets waiting for the output (in bytes). 0 for unlimited."] = 32*1024*1024;
+    p["drop_policy"]["What to do when the output can't keep up: block (stall encoding), disposable (drop non-reference frames), gop (drop non-reference frames, then whole GOPs). Local files always block."] = std::string("gop");
+    p["file_buffer"]["Size of buffers used to write local files from a separate thread (in bytes). 0 to write files directly."] = 4*1024*1024;
+    p["metrics_interval"]["Interval for emitting queue and write latency metrics as events (in seconds). 0 to disable."] = 1.0;
 	return p;
 }
 
@@ -141,7 +146,7 @@ AVFrame *alloc_audio_frame(enum AVSampleFormat sample_fmt, uint64_t channel_layo
     return frame;
 }
 
-bool write_frame(AVFormatContext *fmt_ctx, AVCodecContext *codec_ctx, AVStream *st, AVFrame *frame, AVPacket *pkt) {
+bool write_frame(PacketQueue& queue, AVCodecContext *codec_ctx, AVStream *st, AVFrame *frame, AVPacket *pkt) {
     auto ret = avcodec_send_frame(codec_ctx, frame);
     if (ret < 0)
         throw(std::runtime_error("Error sending a frame to the encoder."));
@@ -155,15 +160,17 @@ bool write_frame(AVFormatContext *fmt_ctx, AVCodecContext *codec_ctx, AVStream *
         av_packet_rescale_ts(pkt, codec_ctx->time_base, st->time_base);
         pkt->stream_index = st->index;
 
-        ret = av_interleaved_write_frame(fmt_ctx, pkt);
-
-        if (ret < 0)
-            throw(std::runtime_error("Error while writing output packet."));
+        // The packet is written by the muxer thread, encoder continues with a new one
+        AVPacket* queued = av_packet_alloc();
+        if (!queued)
+            throw(std::runtime_error("Could not allocate AVPacket."));
+        av_packet_move_ref(queued, pkt);
+        queue.push(queued);
     }
     return ret == AVERROR_EOF ? false : true;
 }
 
-bool write_video_frame(AVFormatContext *fmt_ctx, StreamDescription *output_stream) {
+bool write_video_frame(PacketQueue& queue, StreamDescription *output_stream) {
     AVCodecContext *codec_ctx = output_stream->enc;
 
     if (!output_stream->sws_ctx) {
@@ -180,10 +187,10 @@ bool write_video_frame(AVFormatContext *fmt_ctx, StreamDescription *output_strea
     sws_scale(output_stream->sws_ctx, output_stream->tmp_frame->data, output_stream->tmp_frame->linesize, 0, output_stream->tmp_frame->height, output_stream->frame->data, output_stream->frame->linesize);
 
     output_stream->frame->pts = output_stream->next_pts++; 
-    return write_frame(fmt_ctx, codec_ctx, output_stream->stream, output_stream->frame, output_stream->tmp_pkt);
+    return write_frame(queue, codec_ctx, output_stream->stream, output_stream->frame, output_stream->tmp_pkt);
 }
 
-bool write_audio_frame(AVFormatContext *fmt_ctx, StreamDescription *output_stream) {
+bool write_audio_frame(PacketQueue& queue, StreamDescription *output_stream) {
     AVCodecContext *codec_ctx;
     int dst_nb_samples;
     codec_ctx = output_stream->enc;
@@ -203,7 +210,7 @@ bool write_audio_frame(AVFormatContext *fmt_ctx, StreamDescription *output_strea
         output_stream->tmp_frame->pts = av_rescale_q(output_stream->next_pts, av_make_q(1, codec_ctx->sample_rate), codec_ctx->time_base);
         output_stream->next_pts += dst_nb_samples;
     }
-    return write_frame(fmt_ctx, codec_ctx, output_stream->stream, output_stream->tmp_frame, output_stream->tmp_pkt);
+    return write_frame(queue, codec_ctx, output_stream->stream, output_stream->tmp_frame, output_stream->tmp_pkt);
 }
 
 void open_video(const AVCodec *codec, StreamDescription *output_stream, AVDictionary *opt_arg) {
@@ -269,8 +276,18 @@ void open_audio(const AVCodec *codec, StreamDescription *output_stream, AVDictio
         throw(std::runtime_error("Failed to initialize the resampling context."));
 }
 
+bool is_local_file(const std::string& address) {
+    return address.find("://") == std::string::npos || address.compare(0, 5, "file:") == 0;
+}
+
+std::string get_file_path(const std::string& address) {
+    if (address.compare(0, 7, "file://") == 0) return address.substr(7);
+    if (address.compare(0, 5, "file:") == 0) return address.substr(5);
+    return address;
+}
+
 void start_stream(AVFormatContext *fmt_ctx, AVDictionary *opt_arg, std::string address) {
-	if (!(fmt_ctx->oformat->flags & AVFMT_NOFILE)) {
+	if (!fmt_ctx->pb && !(fmt_ctx->oformat->flags & AVFMT_NOFILE)) {
 		auto ret = avio_open2(&fmt_ctx->pb, address.c_str(), AVIO_FLAG_WRITE, nullptr, nullptr);
 		if (ret < 0)
             throw(std::runtime_error("Could not connect to the destination."));
@@ -295,6 +312,7 @@ static void close_stream(StreamDescription *output_stream) {
 
 AVOutput::AVOutput(const log::Log& _log, core::pwThreadBase parent, const core::Parameters& parameters)
     : base_type(_log, parent, 1, 1, "av_output"),
+    event::BasicEventProducer(log),
 	av_initialized_(false),
 	url_(""),
 	fps_(30),
@@ -302,7 +320,14 @@ AVOutput::AVOutput(const log::Log& _log, core::pwThreadBase parent, const core::
 	video_bitrate_(3584000),
 	audio_(true),
     yuri_audio_frame_(nullptr),
-    yuri_video_frame_(nullptr) {
+    yuri_video_frame_(nullptr),
+    queue_packets_(512),
+    queue_bytes_(32*1024*1024),
+    drop_policy_(drop_policy_t::gop),
+    file_buffer_(4*1024*1024),
+    metrics_interval_(1_s),
+    muxer_failed_(false),
+    written_packets_(0) {
     IOTHREAD_INIT(parameters)
 	if (audio_) resize(2,0);
     set_latency(10_us);
@@ -348,20 +373,98 @@ void AVOutput::initialize() {
 	if (yuri_video_frame_) open_video(video_codec, &video_st_, opt);
 	if (yuri_audio_frame_) open_audio(audio_codec, &audio_st_, opt);
 
+    const bool local_file = is_local_file(url_);
+    if (local_file && file_buffer_) {
+        file_writer_ = make_unique<AsyncFileWriter>(get_file_path(url_), file_buffer_);
+        fmt_ctx_->pb = file_writer_->get_context();
+        fmt_ctx_->flags |= AVFMT_FLAG_CUSTOM_IO;
+    }
     start_stream(fmt_ctx_, opt, url_);
 
+    // Local files shouldn't lose any data
+    queue_ = make_unique<PacketQueue>(queue_packets_, queue_bytes_,
+        local_file ? drop_policy_t::block : drop_policy_,
+        yuri_video_frame_ ? video_st_.stream->index : -1);
+    muxer_failed_ = false;
+    muxer_ = std::thread(&AVOutput::run_muxer, this);
+
     av_initialized_ = true;
 }
 
+void AVOutput::run_muxer() {
+    while (AVPacket* pkt = queue_->pop()) {
+        timestamp_t start;
+        auto ret = av_interleaved_write_frame(fmt_ctx_, pkt);
+        const duration_t write_time = timestamp_t{} - start;
+        av_packet_free(&pkt);
+        if (ret < 0) {
+            log[log::error] << "Error while writing output packet.";
+            muxer_failed_ = true;
+            // Unblocks the encoder, following packets are discarded
+            queue_->close();
+            break;
+        }
+        std::unique_lock<std::mutex> lock(stats_mutex_);
+        ++written_packets_;
+        write_time_ += write_time;
+        max_write_time_ = std::max(max_write_time_, write_time);
+    }
+}
+
+void AVOutput::stop_muxer() {
+    if (!queue_) return;
+    // Remaining packets are still written before the muxer finishes
+    queue_->close();
+    if (muxer_.joinable())
+        muxer_.join();
+}
+
+void AVOutput::emit_metrics() {
+    if (!queue_) return;
+    const auto stats = queue_->get_stats();
+    emit_event("queue_packets", stats.packets);
+    emit_event("queue_bytes", stats.bytes);
+    emit_event("dropped_packets", stats.dropped_packets);
+    emit_event("dropped_bytes", stats.dropped_bytes);
+    size_t packets;
+    duration_t write_time, max_write_time;
+    {
+        std::unique_lock<std::mutex> lock(stats_mutex_);
+        packets = written_packets_;
+        write_time = write_time_;
+        max_write_time = max_write_time_;
+        written_packets_ = 0;
+        write_time_ = duration_t{};
+        max_write_time_ = duration_t{};
+    }
+    emit_event("written_packets", packets);
+    emit_event("write_latency", packets ? duration_t{write_time.value / static_cast<int64_t>(packets)} : duration_t{});
+    emit_event("write_latency_max", max_write_time);
+    log[log::debug] << "Queue: " << stats.packets << " packets, " << stats.bytes << " B, dropped "
+        << stats.dropped_packets << " packets, " << packets << " packets written";
+}
+
 void AVOutput::deinitialize() {
     if (av_initialized_) {
-        av_write_trailer(fmt_ctx_);
+        stop_muxer();
+        if (!muxer_failed_)
+            av_write_trailer(fmt_ctx_);
         close_stream(&video_st_);
         close_stream(&audio_st_);
-        if (fmt_ctx_->pb)
+        if (file_writer_) {
+            try {
+                file_writer_->close();
+            } catch (std::runtime_error& e) {
+                log[log::error] << e.what();
+            }
+            file_writer_.reset();
+            fmt_ctx_->pb = nullptr;
+        } else if (fmt_ctx_->pb) {
             avio_closep(&fmt_ctx_->pb);
+        }
         if (fmt_ctx_)
             avformat_free_context(fmt_ctx_);
+        queue_.reset();
     }
     av_initialized_ = false;
 }
@@ -370,6 +473,15 @@ bool AVOutput::step() {
     auto yuri_video_frame = std::dynamic_pointer_cast<core::RawVideoFrame>(pop_frame(0));
     auto yuri_audio_frame = std::dynamic_pointer_cast<core::RawAudioFrame>(pop_frame(1));
 
+    if (av_initialized_ && muxer_failed_) {
+        log[log::warning] << "Output failed, we have to repeat the initialization.";
+        deinitialize();
+    }
+    if (metrics_interval_.value > 0 && timestamp_t{} - last_metrics_ >= metrics_interval_) {
+        emit_metrics();
+        last_metrics_ = timestamp_t{};
+    }
+
     if (av_initialized_ && yuri_video_frame &&
         (  last_video_format != yuri_video_frame->get_format()
         || last_video_width  != yuri_video_frame->get_width()
@@ -416,7 +528,7 @@ bool AVOutput::step() {
 			}
 		}
         try {
-            if (!write_video_frame(fmt_ctx_, &video_st_))
+            if (!write_video_frame(*queue_, &video_st_))
                 log[log::warning] << "Temporary error in sending video frame.";
             last_video_format = yuri_video_frame_->get_format();
             last_video_width  = yuri_video_frame_->get_width();
@@ -437,7 +549,7 @@ bool AVOutput::step() {
             log[log::warning] << "Codec samples are not the same as source samples (" << frame->nb_samples << " != " << yuri_audio_frame->get_sample_count() << ")!";
         std::copy(src_data,src_data+max_samples*(yuri_audio_frame->get_sample_size()/8),dst_data);
         try {
-            if (!write_audio_frame(fmt_ctx_, &audio_st_))
+            if (!write_audio_frame(*queue_, &audio_st_))
                 log[log::warning] << "Temporary error in sending audio frame.";
             yuri_audio_frame_ = nullptr;
         } catch(const std::exception& e) {
@@ -456,6 +568,11 @@ bool AVOutput::set_param(const core::Parameter &parameter) {
 		(audio_bitrate_, "audio_bitrate")
         (video_bitrate_, "video_bitrate")
 		(audio_,         "audio")
+        (queue_packets_, "queue_packets")
+        (queue_bytes_,   "queue_bytes")
+        (drop_policy_,   "drop_policy", [](const core::Parameter& p) { return parse_drop_policy(p.get<std::string>()); })
+        (file_buffer_,   "file_buffer")
+        (metrics_interval_, "metrics_interval", [](const core::Parameter& p) { return duration_t{static_cast<int64_t>(p.get<double>() * 1e6)}; })
         )
         return true;
     return IOThread::set_param(parameter);
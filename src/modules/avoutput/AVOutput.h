@@ -12,6 +12,12 @@
 #include "yuri/core/frame/RawVideoFrame.h"
 #include "yuri/core/frame/RawAudioFrame.h"
 #include "yuri/core/utils/managed_resource.h"
+#include "yuri/event/BasicEventProducer.h"
+#include "PacketQueue.h"
+#include "AsyncFileWriter.h"
+#include <atomic>
+#include <memory>
+#include <thread>
 
 extern "C" {
 #include <libavcodec/avcodec.h>
@@ -46,7 +52,7 @@ struct StreamDescription {
     AVSampleFormat audio_format;   // Audio only
 };
 
-class AVOutput: public yuri::core::IOThread {
+class AVOutput: public yuri::core::IOThread, public event::BasicEventProducer {
     using base_type = yuri::core::IOThread;
 
 public:
@@ -60,6 +66,10 @@ private:
     virtual bool step() override;
 	void initialize();
 	void deinitialize();
+    //! Writes packets from the queue to the output, runs in a separate thread
+    void run_muxer();
+    void stop_muxer();
+    void emit_metrics();
 
     bool                av_initialized_;
 
@@ -79,6 +89,25 @@ private:
     size_t   last_video_width;
     size_t   last_video_height;
     format_t last_video_format;
+
+    size_t              queue_packets_;
+    size_t              queue_bytes_;
+    drop_policy_t       drop_policy_;
+    size_t              file_buffer_;
+    duration_t          metrics_interval_;
+
+    //! Encoded packets waiting for the muxer
+    std::unique_ptr<PacketQueue>        queue_;
+    std::thread                         muxer_;
+    std::atomic<bool>                   muxer_failed_;
+    std::unique_ptr<AsyncFileWriter>    file_writer_;
+
+    //! Write statistics since the last metrics were emitted, guarded by stats_mutex_
+    std::mutex          stats_mutex_;
+    size_t              written_packets_;
+    duration_t          write_time_;
+    duration_t          max_write_time_;
+    timestamp_t         last_metrics_;
 };
 
 } /* namespace rtmp */
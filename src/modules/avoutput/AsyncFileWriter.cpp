@@ -0,0 +1,167 @@
+/*!
+ * @file 		AsyncFileWriter.cpp
+ * @author 		agent <agent@local>
+ * @date 		18.10.2026
+ * @copyright	Institute of Intermedia, CTU in Prague, 2026
+ * 				Distributed under modified BSD Licence, details in file doc/LICENSE
+ *
+ */
+
+#include "AsyncFileWriter.h"
+#include <algorithm>
+#include <cerrno>
+#include <stdexcept>
+
+extern "C" {
+#include <libavutil/error.h>
+#include <libavutil/mem.h>
+}
+
+namespace yuri {
+namespace avoutput {
+
+namespace {
+//! Size of the buffer used by AVIOContext itself
+constexpr int avio_buffer_size = 64 * 1024;
+}
+
+AsyncFileWriter::AsyncFileWriter(const std::string& path, size_t buffer_size, size_t max_buffers)
+    : file_(std::fopen(path.c_str(), "wb")),
+    buffer_size_(std::max<size_t>(buffer_size, avio_buffer_size)),
+    max_buffers_(std::max<size_t>(max_buffers, 1)),
+    avio_(nullptr),
+    writing_(false),
+    closing_(false),
+    failed_(false) {
+    if (!file_)
+        throw(std::runtime_error("Could not open output file " + path));
+    // The data are buffered here, so there's no point in buffering them in libc too
+    std::setvbuf(file_, nullptr, _IONBF, 0);
+    auto buffer = reinterpret_cast<unsigned char*>(av_malloc(avio_buffer_size));
+    if (buffer)
+        avio_ = avio_alloc_context(buffer, avio_buffer_size, 1, this, nullptr, &AsyncFileWriter::write_packet, &AsyncFileWriter::seek);
+    if (!avio_) {
+        av_free(buffer);
+        std::fclose(file_);
+        throw(std::runtime_error("Could not allocate IO context."));
+    }
+    current_.reserve(buffer_size_);
+    thread_ = std::thread(&AsyncFileWriter::run, this);
+}
+
+AsyncFileWriter::~AsyncFileWriter() noexcept {
+    try {
+        close();
+    } catch (std::runtime_error&) {}
+}
+
+#if LIBAVFORMAT_VERSION_MAJOR >= 61
+int AsyncFileWriter::write_packet(void* opaque, const uint8_t* buf, int buf_size) {
+#else
+int AsyncFileWriter::write_packet(void* opaque, uint8_t* buf, int buf_size) {
+#endif
+    auto& writer = *reinterpret_cast<AsyncFileWriter*>(opaque);
+    if (!writer.append(buf, buf_size))
+        return AVERROR(EIO);
+    return buf_size;
+}
+
+int64_t AsyncFileWriter::seek(void* opaque, int64_t offset, int whence) {
+    auto& writer = *reinterpret_cast<AsyncFileWriter*>(opaque);
+    std::unique_lock<std::mutex> lock(writer.mutex_);
+    // AVIOContext flushes its own buffer before seeking, the queued buffers have to be written too
+    if (!writer.flush(lock))
+        return AVERROR(EIO);
+    return writer.seek_file(offset, whence & ~AVSEEK_FORCE);
+}
+
+int64_t AsyncFileWriter::seek_file(int64_t offset, int whence) {
+    if (whence == AVSEEK_SIZE) {
+        const auto position = ftello(file_);
+        if (position < 0 || fseeko(file_, 0, SEEK_END) != 0)
+            return AVERROR(errno);
+        const auto size = ftello(file_);
+        if (fseeko(file_, position, SEEK_SET) != 0)
+            return AVERROR(errno);
+        return size;
+    }
+    if (fseeko(file_, offset, whence) != 0)
+        return AVERROR(errno);
+    return ftello(file_);
+}
+
+bool AsyncFileWriter::append(const uint8_t* data, size_t size) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (size) {
+        if (failed_) return false;
+        const size_t count = std::min(size, buffer_size_ - current_.size());
+        current_.insert(current_.end(), data, data + count);
+        data += count;
+        size -= count;
+        if (current_.size() >= buffer_size_)
+            submit_current(lock);
+    }
+    return !failed_;
+}
+
+void AsyncFileWriter::submit_current(std::unique_lock<std::mutex>& lock) {
+    // Blocks when the disk can't keep up, instead of buffering unlimited amount of data
+    cond_.wait(lock, [this]() { return full_.size() < max_buffers_ || failed_; });
+    full_.push_back(std::move(current_));
+    if (!free_.empty()) {
+        current_ = std::move(free_.back());
+        free_.pop_back();
+    } else {
+        current_ = std::vector<uint8_t>();
+        current_.reserve(buffer_size_);
+    }
+    current_.clear();
+    cond_.notify_all();
+}
+
+bool AsyncFileWriter::flush(std::unique_lock<std::mutex>& lock) {
+    if (!current_.empty())
+        submit_current(lock);
+    cond_.wait(lock, [this]() { return (full_.empty() && !writing_) || failed_; });
+    return !failed_;
+}
+
+void AsyncFileWriter::run() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+        cond_.wait(lock, [this]() { return !full_.empty() || closing_; });
+        if (full_.empty()) break;
+        auto buffer = std::move(full_.front());
+        full_.pop_front();
+        writing_ = true;
+        lock.unlock();
+        const bool ok = std::fwrite(buffer.data(), 1, buffer.size(), file_) == buffer.size();
+        lock.lock();
+        writing_ = false;
+        if (!ok) failed_ = true;
+        free_.push_back(std::move(buffer));
+        cond_.notify_all();
+    }
+}
+
+void AsyncFileWriter::close() {
+    if (!avio_) return;
+    avio_flush(avio_);
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        if (!current_.empty())
+            full_.push_back(std::move(current_));
+        closing_ = true;
+        cond_.notify_all();
+    }
+    thread_.join();
+    av_freep(&avio_->buffer);
+    avio_context_free(&avio_);
+    const bool failed = std::fclose(file_) != 0 || failed_;
+    file_ = nullptr;
+    if (failed)
+        throw(std::runtime_error("Failed to write output file."));
+}
+
+} /* namespace avoutput */
+} /* namespace yuri */
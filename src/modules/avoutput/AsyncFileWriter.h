@@ -0,0 +1,91 @@
+/*!
+ * @file 		AsyncFileWriter.h
+ * @author 		agent <agent@local>
+ * @date 		18.10.2026
+ * @copyright	Institute of Intermedia, CTU in Prague, 2026
+ * 				Distributed under modified BSD Licence, details in file doc/LICENSE
+ *
+ */
+
+#ifndef ASYNCFILEWRITER_H_
+#define ASYNCFILEWRITER_H_
+
+#include <condition_variable>
+#include <cstdio>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+extern "C" {
+#include <libavformat/avio.h>
+#include <libavformat/version.h>
+}
+
+namespace yuri {
+namespace avoutput {
+
+/*!
+ * Output to a local file with large buffers written from a separate thread.
+ *
+ * Provides AVIOContext collecting the muxed data into buffers of @em buffer_size bytes,
+ * that are written to the file by a background thread. Seeking waits until all queued
+ * buffers are written, so the muxers can still update the headers and write indices.
+ */
+class AsyncFileWriter {
+public:
+    /*!
+     * @param max_buffers   Maximal number of buffers waiting for write, before the muxer gets blocked
+     * @throw std::runtime_error if the file can't be opened
+     */
+    AsyncFileWriter(const std::string& path, size_t buffer_size, size_t max_buffers = 4);
+    ~AsyncFileWriter() noexcept;
+    AsyncFileWriter(const AsyncFileWriter&) = delete;
+    AsyncFileWriter& operator=(const AsyncFileWriter&) = delete;
+
+    AVIOContext* get_context() { return avio_; }
+
+    /*!
+     * Writes all remaining data and closes the file.
+     * @throw std::runtime_error if any write failed
+     */
+    void close();
+private:
+#if LIBAVFORMAT_VERSION_MAJOR >= 61
+    static int write_packet(void* opaque, const uint8_t* buf, int buf_size);
+#else
+    static int write_packet(void* opaque, uint8_t* buf, int buf_size);
+#endif
+    static int64_t seek(void* opaque, int64_t offset, int whence);
+    //! Returns false if the writer thread failed
+    bool append(const uint8_t* data, size_t size);
+    void submit_current(std::unique_lock<std::mutex>& lock);
+    //! Waits until all the data are written to the file. Returns false if the writer thread failed
+    bool flush(std::unique_lock<std::mutex>& lock);
+    //! Seeks in the file, all data have to be written already
+    int64_t seek_file(int64_t offset, int whence);
+    void run();
+
+    std::FILE* file_;
+    const size_t buffer_size_;
+    const size_t max_buffers_;
+    AVIOContext* avio_;
+
+    std::mutex mutex_;
+    std::condition_variable cond_;
+    std::vector<uint8_t> current_;
+    std::deque<std::vector<uint8_t>> full_;
+    //! Buffers returned by the writer thread, reused for new data
+    std::vector<std::vector<uint8_t>> free_;
+    //! The writer thread is writing a buffer, that's no longer in full_
+    bool writing_;
+    bool closing_;
+    bool failed_;
+    std::thread thread_;
+};
+
+} /* namespace avoutput */
+} /* namespace yuri */
+
+#endif /* ASYNCFILEWRITER_H_ */
@@ -0,0 +1,162 @@
+/*!
+ * @file 		PacketQueue.cpp
+ * @author 		agent <agent@local>
+ * @date 		18.10.2026
+ * @copyright	Institute of Intermedia, CTU in Prague, 2026
+ * 				Distributed under modified BSD Licence, details in file doc/LICENSE
+ *
+ */
+
+#include "PacketQueue.h"
+#include <algorithm>
+#include <map>
+
+namespace yuri {
+namespace avoutput {
+
+drop_policy_t parse_drop_policy(const std::string& name)
+{
+    static const std::map<std::string, drop_policy_t> policies = {
+        {"block", drop_policy_t::block},
+        {"disposable", drop_policy_t::disposable},
+        {"gop", drop_policy_t::gop},
+    };
+    auto it = policies.find(name);
+    if (it == policies.end()) return drop_policy_t::block;
+    return it->second;
+}
+
+PacketQueue::PacketQueue(size_t max_packets, size_t max_bytes, drop_policy_t policy, int video_stream)
+    : max_packets_(std::max<size_t>(max_packets, 1)),
+    max_bytes_(max_bytes),
+    policy_(policy),
+    video_stream_(video_stream),
+    bytes_(0),
+    dropped_packets_(0),
+    dropped_bytes_(0),
+    closed_(false),
+    wait_for_key_(false) {
+}
+
+PacketQueue::~PacketQueue() noexcept {
+    for (auto& e: queue_) {
+        av_packet_free(&e.packet);
+    }
+}
+
+bool PacketQueue::is_full(size_t incoming) const {
+    if (queue_.empty()) return false;
+    return queue_.size() >= max_packets_ || (max_bytes_ && bytes_ + incoming > max_bytes_);
+}
+
+void PacketQueue::drop_packet(AVPacket* packet) {
+    ++dropped_packets_;
+    dropped_bytes_ += packet->size;
+    av_packet_free(&packet);
+}
+
+void PacketQueue::drop(std::deque<entry_t>::iterator it) {
+    bytes_ -= it->packet->size;
+    drop_packet(it->packet);
+    queue_.erase(it);
+}
+
+bool PacketQueue::make_space() {
+    if (policy_ == drop_policy_t::block) return false;
+    // Non-reference frames can be dropped without affecting other frames
+    auto it = std::find_if(queue_.begin(), queue_.end(), [](const entry_t& e) { return e.disposable; });
+    if (it != queue_.end()) {
+        drop(it);
+        return true;
+    }
+    if (policy_ != drop_policy_t::gop) return false;
+
+    // Drop the oldest GOP, up to the next key frame
+    it = std::find_if(queue_.begin(), queue_.end(), [](const entry_t& e) { return e.video; });
+    if (it == queue_.end()) return false;
+    bool dropped = false;
+    while (it != queue_.end()) {
+        if (!it->video) {
+            ++it;
+            continue;
+        }
+        if (it->key && dropped) return true;
+        dropped = true;
+        bytes_ -= it->packet->size;
+        drop_packet(it->packet);
+        it = queue_.erase(it);
+    }
+    // There was no complete GOP in the queue, so the rest of the current one has to go too
+    wait_for_key_ = true;
+    return true;
+}
+
+bool PacketQueue::push(AVPacket* packet) {
+    const bool video = packet->stream_index == video_stream_;
+    const bool key = (packet->flags & AV_PKT_FLAG_KEY) != 0;
+#ifdef AV_PKT_FLAG_DISPOSABLE
+    const bool disposable = video && (packet->flags & AV_PKT_FLAG_DISPOSABLE);
+#else
+    const bool disposable = false;
+#endif
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (closed_) {
+        av_packet_free(&packet);
+        return false;
+    }
+    if (video && wait_for_key_ && !key) {
+        drop_packet(packet);
+        return false;
+    }
+    while (is_full(packet->size) && !closed_) {
+        if (make_space()) continue;
+        if (policy_ == drop_policy_t::gop && video) {
+            // Nothing else to drop, so let's drop the rest of current GOP
+            drop_packet(packet);
+            wait_for_key_ = !key;
+            return false;
+        }
+        not_full_.wait(lock);
+    }
+    if (closed_) {
+        av_packet_free(&packet);
+        return false;
+    }
+    if (video && wait_for_key_) {
+        if (!key) {
+            drop_packet(packet);
+            return false;
+        }
+        wait_for_key_ = false;
+    }
+    bytes_ += packet->size;
+    queue_.push_back({packet, video, key, disposable});
+    not_empty_.notify_one();
+    return true;
+}
+
+AVPacket* PacketQueue::pop() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    not_empty_.wait(lock, [this]() { return closed_ || !queue_.empty(); });
+    if (queue_.empty()) return nullptr;
+    AVPacket* packet = queue_.front().packet;
+    queue_.pop_front();
+    bytes_ -= packet->size;
+    not_full_.notify_one();
+    return packet;
+}
+
+void PacketQueue::close() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    closed_ = true;
+    not_empty_.notify_all();
+    not_full_.notify_all();
+}
+
+queue_stats_t PacketQueue::get_stats() const {
+    std::unique_lock<std::mutex> lock(mutex_);
+    return {queue_.size(), bytes_, dropped_packets_, dropped_bytes_};
+}
+
+} /* namespace avoutput */
+} /* namespace yuri */
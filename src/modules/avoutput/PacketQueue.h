@@ -0,0 +1,112 @@
+/*!
+ * @file 		PacketQueue.h
+ * @author 		agent <agent@local>
+ * @date 		18.10.2026
+ * @copyright	Institute of Intermedia, CTU in Prague, 2026
+ * 				Distributed under modified BSD Licence, details in file doc/LICENSE
+ *
+ */
+
+#ifndef PACKETQUEUE_H_
+#define PACKETQUEUE_H_
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+
+extern "C" {
+#include <libavcodec/avcodec.h>
+}
+
+namespace yuri {
+namespace avoutput {
+
+//! What to do, when the queue is full
+enum class drop_policy_t {
+    //! Wait until there's space in the queue
+    block,
+    //! Drop non-reference video packets, wait when there are none
+    disposable,
+    //! Drop non-reference video packets, then whole GOPs
+    gop
+};
+
+//! Parses policy name (block, disposable, gop). Returns block for unknown names.
+drop_policy_t parse_drop_policy(const std::string& name);
+
+struct queue_stats_t {
+    size_t packets;
+    size_t bytes;
+    size_t dropped_packets;
+    size_t dropped_bytes;
+};
+
+/*!
+ * Bounded queue of encoded packets between the encoder and the muxer.
+ *
+ * The queue is limited both by number of packets and by their total size.
+ * When dropping, the stream stays decodable - after a part of GOP is dropped,
+ * all video packets are dropped until the next key frame.
+ */
+class PacketQueue {
+public:
+    /*!
+     * @param video_stream  Index of the video stream, only its packets are dropped
+     */
+    PacketQueue(size_t max_packets, size_t max_bytes, drop_policy_t policy, int video_stream);
+    ~PacketQueue() noexcept;
+    PacketQueue(const PacketQueue&) = delete;
+    PacketQueue& operator=(const PacketQueue&) = delete;
+
+    /*!
+     * Stores a packet into the queue, taking ownership of it.
+     * May block, depending on the drop policy.
+     * @return false if the packet was dropped (and freed)
+     */
+    bool push(AVPacket* packet);
+
+    /*!
+     * Waits for a packet. The packet has to be freed by av_packet_free().
+     * @return Next packet or nullptr when the queue was closed and all packets were consumed.
+     */
+    AVPacket* pop();
+
+    //! Closes the queue. Following pushes fail, remaining packets can still be popped.
+    void close();
+
+    queue_stats_t get_stats() const;
+private:
+    struct entry_t {
+        AVPacket* packet;
+        bool video;
+        bool key;
+        bool disposable;
+    };
+    bool is_full(size_t incoming) const;
+    //! Drops packets to make space. Returns false if nothing could be dropped
+    bool make_space();
+    void drop(std::deque<entry_t>::iterator it);
+    void drop_packet(AVPacket* packet);
+
+    const size_t max_packets_;
+    const size_t max_bytes_;
+    const drop_policy_t policy_;
+    const int video_stream_;
+
+    mutable std::mutex mutex_;
+    std::condition_variable not_empty_;
+    std::condition_variable not_full_;
+    std::deque<entry_t> queue_;
+    size_t bytes_;
+    size_t dropped_packets_;
+    size_t dropped_bytes_;
+    bool closed_;
+    //! Part of a GOP was dropped, so video packets have to be dropped until next key frame
+    bool wait_for_key_;
+};
+
+} /* namespace avoutput */
+} /* namespace yuri */
+
+#endif /* PACKETQUEUE_H_ */
@@ -42,7 +42,7 @@ BlankGenerator::BlankGenerator(log::Log &log_, core::pwThreadBase parent, const
 IOThread(log_, parent, 0, 1, "BlankGenerator"),
 BasicEventConsumer(log),
 fps_(25),resolution_{640,480},format_(core::raw_format::yuyv422),
-color_(core::color_t::create_rgb(0,0,0))
+color_(core::color_t::create_rgb(0,0,0)),first_sent_(false)
 {
 	set_latency(10_ms);
 	IOTHREAD_INIT(parameters)
@@ -335,12 +335,20 @@ void BlankGenerator::run()
 		if (!frame_cache_ && resolution_) {
 			Timer t0;
 			frame_cache_ = generate_frame(format_, resolution_, color_);
+			if (frame_cache_) {
+				frame_cache_->set_damage({resolution_.get_geometry()});
+				unchanged_cache_ = std::dynamic_pointer_cast<core::RawVideoFrame>(frame_cache_->get_copy());
+				unchanged_cache_->set_damage({});
+			}
+			first_sent_ = false;
 			log[log::debug] << "Generated frame in " << t0.get_duration();
 		}
 
 
 		if (frame_cache_) {
-			push_frame(0, frame_cache_);
+			// Only the first frame after (re)generation is marked as changed
+			push_frame(0, first_sent_ ? unchanged_cache_ : frame_cache_);
+			first_sent_ = true;
 		}
 		next_time_ = next_time_ + (1_s / fps_);
 	}
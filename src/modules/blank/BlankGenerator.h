@@ -36,6 +36,9 @@ private:
 	yuri::format_t format_;
 	core::color_t color_;
 	core::pRawVideoFrame frame_cache_;
+	//! Copy of frame_cache_ marked as unchanged, sent after the first frame
+	core::pRawVideoFrame unchanged_cache_;
+	bool first_sent_;
 };
 
 }
@@ -14,14 +14,10 @@
 #include "yuri/core/frame/RawVideoFrame.h"
 #include "yuri/event/BasicEventConsumer.h"
 #include "yuri/core/utils/color.h"
+#include "key_kernels.h"
 namespace yuri {
 namespace color_key {
 
-enum diff_types_ {
-	linear,
-	quadratic
-};
-
 
 class ColorKey: public core::SpecializedIOFilter<core::RawVideoFrame>, public event::BasicEventConsumer
 {
@@ -38,14 +34,18 @@ private:
 	virtual bool set_param(const core::Parameter& param) override;
 	virtual bool do_process_event(const std::string& event_name, const event::pBasicEvent& event) override;
 
-	template<class kernel>
-	core::pRawVideoFrame find_key(const core::pRawVideoFrame& frame);
-	template<format_t format>
-	core::pRawVideoFrame dispatch_find_key(const core::pRawVideoFrame& frame);
+	const KeyLUT& get_lut(bool yuv);
+
 	core::color_t color_;
 	size_t y_cutoff_;
 	ssize_t delta_, delta2_;
 	diff_types_ diff_type_;
+	int lut_bits_;
+	double spill_;
+	size_t soften_;
+	size_t threads_;
+	KeyLUT rgb_lut_;
+	KeyLUT yuv_lut_;
 };
 
 } /* namespace color_key */
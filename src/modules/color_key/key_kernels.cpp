@@ -0,0 +1,352 @@
+/*!
+ * @file 		key_kernels.cpp
+ * @author 		agent <agent@local>
+ * @date 		18.10.2026
+ * @copyright	Institute of Intermedia, CTU in Prague, 2026
+ * 				Distributed under modified BSD Licence, details in file doc/LICENSE
+ *
+ */
+
+#include "key_kernels.h"
+#include "yuri/core/frame/raw_frame_types.h"
+#include "yuri/core/utils/parallel_for.h"
+#include <algorithm>
+
+namespace yuri {
+namespace color_key {
+
+namespace {
+
+inline ssize_t diff(uint8_t a, uint8_t b)
+{
+	return a>b?a-b:b-a;
+}
+
+//! Exact division by 255 for values up to 255*255
+inline uint8_t div255(unsigned x)
+{
+	return static_cast<uint8_t>((x + 1 + ((x + 1) >> 8)) >> 8);
+}
+
+inline uint8_t clip(int64_t x)
+{
+	return static_cast<uint8_t>(std::min<int64_t>(std::max<int64_t>(x, 0), 255));
+}
+
+struct pixel_t {
+	uint8_t c[3];
+	uint8_t a;
+};
+
+/*!
+ * Packed format with one pixel in @em bpp bytes.
+ * Components are at offsets i0, i1, i2, alpha at offset ia (or -1 if there's no alpha)
+ */
+template<int i0, int i1, int i2, int ia, size_t bpp>
+struct packed {
+	static pixel_t read(const uint8_t* src, size_t x)
+	{
+		const uint8_t* p = src + x * bpp;
+		return {{p[i0], p[i1], p[i2]}, static_cast<uint8_t>(ia < 0 ? 255 : p[ia < 0 ? 0 : ia])};
+	}
+	static void write(uint8_t* dst, size_t x, const pixel_t& pix)
+	{
+		uint8_t* p = dst + x * bpp;
+		p[i0] = pix.c[0];
+		p[i1] = pix.c[1];
+		p[i2] = pix.c[2];
+		if (ia >= 0) p[ia < 0 ? 0 : ia] = pix.a;
+	}
+};
+
+/*!
+ * 4:2:2 format with luma at offsets y0 and y0 + 2 and chroma at offsets u and v
+ */
+template<int y0, int u, int v>
+struct packed422 {
+	static pixel_t read(const uint8_t* src, size_t x)
+	{
+		const uint8_t* p = src + (x & ~static_cast<size_t>(1)) * 2;
+		return {{p[y0 + (x & 1) * 2], p[u], p[v]}, 255};
+	}
+};
+
+using rgb_in 	= packed<0, 1, 2, -1, 3>;
+using bgr_in 	= packed<2, 1, 0, -1, 3>;
+using rgba 		= packed<0, 1, 2, 3, 4>;
+using bgra 		= packed<2, 1, 0, 3, 4>;
+using argb 		= packed<1, 2, 3, 0, 4>;
+using abgr 		= packed<3, 2, 1, 0, 4>;
+
+template<format_t fmt>
+struct key_format {};
+
+template<class in_type, class out_type, format_t out_fmt, bool yuv_vals>
+struct key_format_base {
+	using in = in_type;
+	using out = out_type;
+	static constexpr format_t out_format = out_fmt;
+	static constexpr bool yuv = yuv_vals;
+};
+
+using namespace core::raw_format;
+
+template<> struct key_format<rgb24>: key_format_base<rgb_in, rgba, rgba32, false> {};
+template<> struct key_format<bgr24>: key_format_base<bgr_in, bgra, bgra32, false> {};
+template<> struct key_format<rgba32>: key_format_base<rgba, rgba, rgba32, false> {};
+template<> struct key_format<bgra32>: key_format_base<bgra, bgra, bgra32, false> {};
+template<> struct key_format<argb32>: key_format_base<argb, argb, argb32, false> {};
+template<> struct key_format<abgr32>: key_format_base<abgr, abgr, abgr32, false> {};
+template<> struct key_format<yuv444>: key_format_base<rgb_in, rgba, yuva4444, true> {};
+template<> struct key_format<yuva4444>: key_format_base<rgba, rgba, yuva4444, true> {};
+template<> struct key_format<yuyv422>: key_format_base<packed422<0, 1, 3>, rgba, yuva4444, true> {};
+template<> struct key_format<uyvy422>: key_format_base<packed422<1, 0, 2>, rgba, yuva4444, true> {};
+
+/*!
+ * Spill suppression.
+ *
+ * In RGB the dominant component of the key is limited to the average of the other two,
+ * in YUV the projection of the chroma to the direction of the key chroma is removed.
+ */
+class spill_t {
+public:
+	spill_t(const key_params_t& params, int strength):strength_(strength),yuv_(params.yuv),
+		k_(0),ku_(0),kv_(0),norm_(0)
+	{
+		if (yuv_) {
+			ku_ = params.key[1] - 128;
+			kv_ = params.key[2] - 128;
+			norm_ = static_cast<int64_t>(ku_) * ku_ + static_cast<int64_t>(kv_) * kv_;
+			if (!norm_) strength_ = 0;
+		} else {
+			k_ = static_cast<int>(std::max_element(params.key.begin(), params.key.end()) - params.key.begin());
+		}
+	}
+	bool enabled() const { return strength_ > 0; }
+	void apply(pixel_t& p) const
+	{
+		if (yuv_) {
+			const int64_t dot = static_cast<int64_t>(p.c[1] - 128) * ku_ + static_cast<int64_t>(p.c[2] - 128) * kv_;
+			if (dot <= 0) return;
+			const int64_t f = dot * strength_;
+			p.c[1] = clip(p.c[1] - f * ku_ / (norm_ * 256));
+			p.c[2] = clip(p.c[2] - f * kv_ / (norm_ * 256));
+		} else {
+			const int limit = (p.c[(k_ + 1) % 3] + p.c[(k_ + 2) % 3]) / 2;
+			const int val = p.c[k_];
+			if (val > limit) {
+				p.c[k_] = static_cast<uint8_t>(val - ((val - limit) * strength_ >> 8));
+			}
+		}
+	}
+private:
+	int strength_;
+	bool yuv_;
+	int k_;
+	int ku_, kv_;
+	int64_t norm_;
+};
+
+template<format_t fmt>
+void compute_alpha_lines(const uint8_t* src, size_t linesize_in, dimension_t width,
+		size_t start, size_t end, const KeyLUT& lut, uint8_t* alpha)
+{
+	using in = typename key_format<fmt>::in;
+	for (size_t line = start; line < end; ++line) {
+		const uint8_t* s = src + line * linesize_in;
+		uint8_t* a = alpha + line * width;
+		for (dimension_t x = 0; x < width; ++x) {
+			const auto p = in::read(s, x);
+			a[x] = lut(p.c[0], p.c[1], p.c[2]);
+		}
+	}
+}
+
+/*!
+ * Writes output lines. Alpha is either taken from @em alpha, or read from the table.
+ */
+template<format_t fmt>
+void key_lines(const uint8_t* src, size_t linesize_in, uint8_t* dst, size_t linesize_out,
+		dimension_t width, size_t start, size_t end, const KeyLUT& lut, const spill_t& spill,
+		const uint8_t* alpha)
+{
+	using in = typename key_format<fmt>::in;
+	using out = typename key_format<fmt>::out;
+	const pixel_t keyed = key_format<fmt>::yuv ? pixel_t{{255, 128, 128}, 0} : pixel_t{{255, 255, 255}, 0};
+	for (size_t line = start; line < end; ++line) {
+		const uint8_t* s = src + line * linesize_in;
+		uint8_t* d = dst + line * linesize_out;
+		const uint8_t* a = alpha ? alpha + line * width : nullptr;
+		for (dimension_t x = 0; x < width; ++x) {
+			auto p = in::read(s, x);
+			const uint8_t val = a ? a[x] : lut(p.c[0], p.c[1], p.c[2]);
+			if (!val) {
+				out::write(d, x, keyed);
+				continue;
+			}
+			if (spill.enabled()) spill.apply(p);
+			if (val != 255) p.a = div255(p.a * val);
+			out::write(d, x, p);
+		}
+	}
+}
+
+/*!
+ * Separable box filter with radius @em radius. Pixels outside of the image are ignored.
+ */
+void box_filter(std::vector<uint8_t>& alpha, resolution_t res, size_t radius, size_t threads)
+{
+	const size_t w = res.width;
+	const size_t h = res.height;
+	std::vector<uint8_t> tmp(alpha.size());
+	core::utils::parallel_for(threads, 0, h, [&](size_t start, size_t end) {
+		for (size_t line = start; line < end; ++line) {
+			const uint8_t* a = &alpha[line * w];
+			uint8_t* t = &tmp[line * w];
+			unsigned sum = 0;
+			size_t lo = 0, hi = 0; // window is [lo, hi)
+			for (size_t x = 0; x < w; ++x) {
+				const size_t new_hi = std::min(x + radius + 1, w);
+				const size_t new_lo = x > radius ? x - radius : 0;
+				for (; hi < new_hi; ++hi) sum += a[hi];
+				for (; lo < new_lo; ++lo) sum -= a[lo];
+				t[x] = static_cast<uint8_t>(sum / (hi - lo));
+			}
+		}
+	}, 16);
+	core::utils::parallel_for(threads, 0, h, [&](size_t start, size_t end) {
+		std::vector<unsigned> sums(w, 0);
+		size_t lo = start > radius ? start - radius : 0;
+		size_t hi = lo;
+		for (size_t line = start; line < end; ++line) {
+			const size_t new_hi = std::min(line + radius + 1, h);
+			const size_t new_lo = line > radius ? line - radius : 0;
+			for (; hi < new_hi; ++hi) {
+				const uint8_t* t = &tmp[hi * w];
+				for (size_t x = 0; x < w; ++x) sums[x] += t[x];
+			}
+			for (; lo < new_lo; ++lo) {
+				const uint8_t* t = &tmp[lo * w];
+				for (size_t x = 0; x < w; ++x) sums[x] -= t[x];
+			}
+			const unsigned count = static_cast<unsigned>(hi - lo);
+			uint8_t* a = &alpha[line * w];
+			for (size_t x = 0; x < w; ++x) a[x] = static_cast<uint8_t>(sums[x] / count);
+		}
+	}, 16);
+}
+
+template<format_t fmt>
+void process_key(const uint8_t* src, size_t linesize_in, uint8_t* dst, size_t linesize_out,
+		resolution_t res, const KeyLUT& lut, const key_options_t& options)
+{
+	const spill_t spill(lut.get_params(), options.spill);
+	if (!options.soften) {
+		core::utils::parallel_for(options.threads, 0, res.height, [&](size_t start, size_t end) {
+			key_lines<fmt>(src, linesize_in, dst, linesize_out, res.width, start, end, lut, spill, nullptr);
+		}, 16);
+		return;
+	}
+	std::vector<uint8_t> alpha(res.width * res.height);
+	core::utils::parallel_for(options.threads, 0, res.height, [&](size_t start, size_t end) {
+		compute_alpha_lines<fmt>(src, linesize_in, res.width, start, end, lut, alpha.data());
+	}, 16);
+	box_filter(alpha, res, options.soften, options.threads);
+	core::utils::parallel_for(options.threads, 0, res.height, [&](size_t start, size_t end) {
+		key_lines<fmt>(src, linesize_in, dst, linesize_out, res.width, start, end, lut, spill, alpha.data());
+	}, 16);
+}
+
+}
+
+bool operator==(const key_params_t& a, const key_params_t& b)
+{
+	return a.key == b.key && a.yuv == b.yuv && a.y_cutoff == b.y_cutoff &&
+			a.delta == b.delta && a.delta2 == b.delta2 && a.diff == b.diff;
+}
+
+uint8_t compute_alpha(const key_params_t& params, uint8_t c0, uint8_t c1, uint8_t c2)
+{
+	const ssize_t d0 = params.yuv ? diff(c0, params.key[0]) / std::max(params.y_cutoff, 1) : diff(c0, params.key[0]);
+	const ssize_t d1 = diff(c1, params.key[1]);
+	const ssize_t d2 = diff(c2, params.key[2]);
+	const ssize_t total = params.diff == quadratic ? d0 * d0 + d1 * d1 + d2 * d2 : d0 + d1 + d2;
+	if (total < params.delta) return 0;
+	if (total >= params.delta + params.delta2) return 255;
+	return static_cast<uint8_t>(255 * (total - params.delta) / params.delta2);
+}
+
+void KeyLUT::build(const key_params_t& params, int bits, size_t threads)
+{
+	params_ = params;
+	bits_ = std::min(std::max(bits, 4), 8);
+	shift_ = 8 - bits_;
+	const size_t cells = 1 << bits_;
+	const int half = (1 << shift_) >> 1;
+	table_.resize(cells * cells * cells);
+	core::utils::parallel_for(threads, 0, cells, [&](size_t start, size_t end) {
+		for (size_t i0 = start; i0 < end; ++i0) {
+			uint8_t* t = &table_[i0 * cells * cells];
+			const auto c0 = static_cast<uint8_t>((i0 << shift_) + half);
+			for (size_t i1 = 0; i1 < cells; ++i1) {
+				const auto c1 = static_cast<uint8_t>((i1 << shift_) + half);
+				for (size_t i2 = 0; i2 < cells; ++i2) {
+					*t++ = compute_alpha(params_, c0, c1, static_cast<uint8_t>((i2 << shift_) + half));
+				}
+			}
+		}
+	});
+}
+
+format_t get_key_output_format(format_t fmt)
+{
+	switch (fmt) {
+		case rgb24: return key_format<rgb24>::out_format;
+		case bgr24: return key_format<bgr24>::out_format;
+		case rgba32: return key_format<rgba32>::out_format;
+		case bgra32: return key_format<bgra32>::out_format;
+		case argb32: return key_format<argb32>::out_format;
+		case abgr32: return key_format<abgr32>::out_format;
+		case yuv444: return key_format<yuv444>::out_format;
+		case yuva4444: return key_format<yuva4444>::out_format;
+		case yuyv422: return key_format<yuyv422>::out_format;
+		case uyvy422: return key_format<uyvy422>::out_format;
+		default: return 0;
+	}
+}
+
+bool is_yuv_key_format(format_t fmt)
+{
+	switch (fmt) {
+		case yuv444:
+		case yuva4444:
+		case yuyv422:
+		case uyvy422:
+			return true;
+		default:
+			return false;
+	}
+}
+
+bool apply_key(const uint8_t* src, size_t linesize_in, format_t fmt,
+		uint8_t* dst, size_t linesize_out, resolution_t res,
+		const KeyLUT& lut, const key_options_t& options)
+{
+	switch (fmt) {
+		case rgb24: process_key<rgb24>(src, linesize_in, dst, linesize_out, res, lut, options); break;
+		case bgr24: process_key<bgr24>(src, linesize_in, dst, linesize_out, res, lut, options); break;
+		case rgba32: process_key<rgba32>(src, linesize_in, dst, linesize_out, res, lut, options); break;
+		case bgra32: process_key<bgra32>(src, linesize_in, dst, linesize_out, res, lut, options); break;
+		case argb32: process_key<argb32>(src, linesize_in, dst, linesize_out, res, lut, options); break;
+		case abgr32: process_key<abgr32>(src, linesize_in, dst, linesize_out, res, lut, options); break;
+		case yuv444: process_key<yuv444>(src, linesize_in, dst, linesize_out, res, lut, options); break;
+		case yuva4444: process_key<yuva4444>(src, linesize_in, dst, linesize_out, res, lut, options); break;
+		case yuyv422: process_key<yuyv422>(src, linesize_in, dst, linesize_out, res, lut, options); break;
+		case uyvy422: process_key<uyvy422>(src, linesize_in, dst, linesize_out, res, lut, options); break;
+		default: return false;
+	}
+	return true;
+}
+
+}
+}
@@ -0,0 +1,121 @@
+/*!
+ * @file 		key_kernels.h
+ * @author 		agent <agent@local>
+ * @date 		18.10.2026
+ * @copyright	Institute of Intermedia, CTU in Prague, 2026
+ * 				Distributed under modified BSD Licence, details in file doc/LICENSE
+ *
+ */
+
+#ifndef KEY_KERNELS_H_
+#define KEY_KERNELS_H_
+
+#include "yuri/core/utils/new_types.h"
+#include <array>
+#include <vector>
+
+namespace yuri {
+namespace color_key {
+
+enum diff_types_ {
+	linear,
+	quadratic
+};
+
+/*!
+ * Parameters determining alpha for a single pixel.
+ * The key and the pixels are either in RGB or in YUV, depending on @em yuv.
+ */
+struct key_params_t {
+	std::array<uint8_t, 3> key;
+	bool yuv;
+	int y_cutoff;
+	ssize_t delta;
+	ssize_t delta2;
+	diff_types_ diff;
+};
+
+bool operator==(const key_params_t& a, const key_params_t& b);
+inline bool operator!=(const key_params_t& a, const key_params_t& b) { return !(a == b); }
+
+/*!
+ * Computes alpha for a single pixel.
+ * Pixels closer to the key than delta are fully transparent,
+ * pixels further than delta + delta2 are fully opaque.
+ */
+uint8_t compute_alpha(const key_params_t& params, uint8_t c0, uint8_t c1, uint8_t c2);
+
+/*!
+ * Three dimensional table with precomputed alpha values.
+ *
+ * Every component is quantised to @em bits bits and the alpha is evaluated
+ * for the center of every cell. With 6 bits the table takes 256kB and stays in L2 cache,
+ * with 8 bits the results are exact.
+ */
+class KeyLUT {
+public:
+	KeyLUT():params_(),bits_(0),shift_(0) {}
+	void build(const key_params_t& params, int bits, size_t threads);
+	bool matches(const key_params_t& params, int bits) const
+	{
+		return bits_ == bits && params_ == params;
+	}
+	const key_params_t& get_params() const { return params_; }
+	uint8_t operator()(uint8_t c0, uint8_t c1, uint8_t c2) const
+	{
+		return table_[(static_cast<size_t>(c0 >> shift_) << (2 * bits_)) |
+					  (static_cast<size_t>(c1 >> shift_) << bits_) |
+					  (c2 >> shift_)];
+	}
+private:
+	key_params_t params_;
+	int bits_;
+	int shift_;
+	std::vector<uint8_t> table_;
+};
+
+struct key_options_t {
+	//! Strength of spill suppression, 0 - 256
+	int spill;
+	//! Radius of the box filter applied to alpha, 0 to disable
+	size_t soften;
+	size_t threads;
+};
+
+/*!
+ * Returns format of the keyed image for format @em fmt,
+ * or 0 if the format is not supported.
+ */
+format_t get_key_output_format(format_t fmt);
+
+/*!
+ * Returns true if @em fmt is keyed in YUV
+ */
+bool is_yuv_key_format(format_t fmt);
+
+/*!
+ * Keys an image.
+ *
+ * Alpha for every pixel is read from @em lut, so the per pixel work consists
+ * of a single table load. Keyed out pixels are replaced by white color,
+ * spill of the key color is removed from the rest of the pixels.
+ * The image is processed in horizontal bands in parallel.
+ *
+ * @param src			Input image
+ * @param linesize_in	Line size (in bytes) of the input image
+ * @param fmt			Format of the input image
+ * @param dst			Output image in format get_key_output_format(fmt)
+ * @param linesize_out	Line size (in bytes) of the output image
+ * @param res			Image resolution
+ * @param lut			Table built for parameters corresponding to the format
+ * @param options		Additional processing options
+ * @return false if the format is not supported
+ */
+bool apply_key(const uint8_t* src, size_t linesize_in, format_t fmt,
+		uint8_t* dst, size_t linesize_out, resolution_t res,
+		const KeyLUT& lut, const key_options_t& options);
+
+}
+}
+
+#endif /* KEY_KERNELS_H_ */
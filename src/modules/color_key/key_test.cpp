@@ -0,0 +1,159 @@
+/*!
+ * @file 		key_test.cpp
+ * @author 		agent <agent@local>
+ * @date 		18.10.2026
+ * @copyright	Institute of Intermedia, CTU in Prague, 2026
+ * 				Distributed under modified BSD Licence, details in file doc/LICENSE
+ *
+ */
+
+#include "tests/catch.hpp"
+#include "key_kernels.h"
+#include "yuri/core/frame/raw_frame_types.h"
+
+namespace yuri {
+namespace color_key {
+
+namespace {
+
+const key_params_t rgb_params = {{{40, 200, 60}}, false, 1, 90, 30, linear};
+const key_params_t yuv_params = {{{150, 60, 50}}, true, 5, 60, 40, quadratic};
+
+std::vector<uint8_t> make_image(size_t size)
+{
+	std::vector<uint8_t> img(size);
+	uint8_t val = 17;
+	for (auto& v: img) {
+		v = val;
+		val = static_cast<uint8_t>(val * 31 + 11);
+	}
+	return img;
+}
+
+}
+
+TEST_CASE( "key lookup table", "[module]" ) {
+	for (const auto& params: {rgb_params, yuv_params}) {
+		KeyLUT lut;
+		lut.build(params, 8, 3);
+		REQUIRE( lut.matches(params, 8) );
+		REQUIRE( !lut.matches(params, 6) );
+		for (int c0 = 0; c0 < 256; c0 += 3) {
+			for (int c1 = 0; c1 < 256; c1 += 5) {
+				for (int c2 = 0; c2 < 256; c2 += 7) {
+					REQUIRE( lut(c0, c1, c2) == compute_alpha(params, c0, c1, c2) );
+				}
+			}
+		}
+		// Quantised table has to give exact values for centers of the cells
+		lut.build(params, 6, 1);
+		for (int c = 2; c < 256; c += 4) {
+			REQUIRE( lut(c, c, c) == compute_alpha(params, c, c, c) );
+			REQUIRE( lut(c, c ^ 0xfc, c) == compute_alpha(params, c, c ^ 0xfc, c) );
+		}
+	}
+}
+
+TEST_CASE( "key application", "[module]" ) {
+	using namespace core::raw_format;
+	const resolution_t res{68, 41};
+	KeyLUT lut;
+	lut.build(rgb_params, 8, 1);
+
+	SECTION("rgb24") {
+		auto input = make_image(res.width * res.height * 3);
+		// Make part of the image the key color
+		for (size_t i = 0; i < input.size() / 3; i += 2) {
+			std::copy(rgb_params.key.begin(), rgb_params.key.end(), &input[i * 3]);
+		}
+		REQUIRE( get_key_output_format(rgb24) == rgba32 );
+		std::vector<uint8_t> expected(res.width * res.height * 4);
+		for (size_t i = 0; i < input.size() / 3; ++i) {
+			const uint8_t* p = &input[i * 3];
+			const uint8_t a = compute_alpha(rgb_params, p[0], p[1], p[2]);
+			uint8_t* e = &expected[i * 4];
+			if (a) {
+				std::copy(p, p + 3, e);
+			} else {
+				std::fill(e, e + 3, 255);
+			}
+			e[3] = a;
+		}
+		for (size_t threads: {1, 3}) {
+			std::vector<uint8_t> output(expected.size());
+			REQUIRE( apply_key(input.data(), res.width * 3, rgb24, output.data(), res.width * 4, res, lut, {0, 0, threads}) );
+			REQUIRE( output == expected );
+		}
+	}
+	SECTION("yuyv422") {
+		KeyLUT yuv_lut;
+		yuv_lut.build(yuv_params, 8, 1);
+		const auto input = make_image(res.width * res.height * 2);
+		std::vector<uint8_t> output(res.width * res.height * 4);
+		REQUIRE( apply_key(input.data(), res.width * 2, yuyv422, output.data(), res.width * 4, res, yuv_lut, {0, 0, 2}) );
+		for (size_t i = 0; i < res.width * res.height; ++i) {
+			const uint8_t* p = &input[(i & ~1) * 2];
+			const uint8_t y = p[(i & 1) * 2];
+			const uint8_t a = compute_alpha(yuv_params, y, p[1], p[3]);
+			REQUIRE( output[i * 4 + 3] == a );
+			if (a) {
+				REQUIRE( output[i * 4 + 0] == y );
+				REQUIRE( output[i * 4 + 1] == p[1] );
+				REQUIRE( output[i * 4 + 2] == p[3] );
+			}
+		}
+	}
+	SECTION("unsupported format") {
+		std::vector<uint8_t> data(res.width * res.height * 4);
+		REQUIRE( get_key_output_format(y8) == 0 );
+		REQUIRE( !apply_key(data.data(), res.width, y8, data.data(), res.width * 4, res, lut, {0, 0, 1}) );
+	}
+}
+
+TEST_CASE( "key spill suppression", "[module]" ) {
+	using namespace core::raw_format;
+	const resolution_t res{1, 1};
+	KeyLUT lut;
+	lut.build(rgb_params, 8, 1);
+	const std::vector<uint8_t> input = {160, 180, 60};
+	std::vector<uint8_t> output(4);
+	REQUIRE( apply_key(input.data(), 3, rgb24, output.data(), 4, res, lut, {256, 0, 1}) );
+	REQUIRE( output == (std::vector<uint8_t>{160, 110, 60, 255}) );
+	REQUIRE( apply_key(input.data(), 3, rgb24, output.data(), 4, res, lut, {128, 0, 1}) );
+	REQUIRE( output == (std::vector<uint8_t>{160, 145, 60, 255}) );
+	// Pixels without spill are kept intact
+	const std::vector<uint8_t> red = {200, 50, 60};
+	REQUIRE( apply_key(red.data(), 3, rgb24, output.data(), 4, res, lut, {256, 0, 1}) );
+	REQUIRE( output == (std::vector<uint8_t>{200, 50, 60, 255}) );
+}
+
+TEST_CASE( "key edge softening", "[module]" ) {
+	using namespace core::raw_format;
+	const resolution_t res{40, 30};
+	KeyLUT lut;
+	lut.build(rgb_params, 8, 1);
+	// Left half of the image is the key, right half is red
+	std::vector<uint8_t> input(res.width * res.height * 3);
+	for (size_t i = 0; i < res.width * res.height; ++i) {
+		const uint8_t red[] = {255, 0, 0};
+		const uint8_t* p = (i % res.width) < res.width / 2 ? rgb_params.key.data() : red;
+		std::copy(p, p + 3, &input[i * 3]);
+	}
+	std::vector<uint8_t> output(res.width * res.height * 4);
+	REQUIRE( apply_key(input.data(), res.width * 3, rgb24, output.data(), res.width * 4, res, lut, {0, 2, 1}) );
+	for (size_t line = 0; line < res.height; ++line) {
+		const uint8_t* l = &output[line * res.width * 4];
+		REQUIRE( l[(res.width / 2 - 3) * 4 + 3] == 0 );
+		REQUIRE( l[(res.width / 2 - 2) * 4 + 3] == 51 );
+		REQUIRE( l[(res.width / 2 - 1) * 4 + 3] == 102 );
+		REQUIRE( l[(res.width / 2) * 4 + 3] == 153 );
+		REQUIRE( l[(res.width / 2 + 1) * 4 + 3] == 204 );
+		REQUIRE( l[(res.width / 2 + 2) * 4 + 3] == 255 );
+	}
+	std::vector<uint8_t> output2(output.size());
+	REQUIRE( apply_key(input.data(), res.width * 3, rgb24, output2.data(), res.width * 4, res, lut, {0, 2, 3}) );
+	REQUIRE( output == output2 );
+}
+
+}
+}
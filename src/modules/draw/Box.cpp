@@ -85,7 +85,8 @@ core::Parameters Box::configure() {
 
 
 Box::Box(const log::Log &log_, core::pwThreadBase parent, const core::Parameters &parameters):
-base_type(log_,parent,std::string("box")), BasicEventConsumer(log), thickness_(5) {
+base_type(log_,parent,std::string("box")), BasicEventConsumer(log), thickness_(5),
+last_thickness_(0), last_resolution_{0, 0} {
 	IOTHREAD_INIT(parameters)
 	set_supported_formats(supported_formats);
 }
@@ -95,6 +96,25 @@ Box::~Box() noexcept {
 
 core::pFrame Box::do_special_single_step(core::pRawVideoFrame frame) {
 	process_events();
+	const auto res = frame->get_resolution();
+	if (thickness_ != last_thickness_ || res != last_resolution_) {
+		// The border changed, so it has to be reported as damaged
+		if (frame->has_damage_info()) {
+			auto unique = core::get_frame_unique(frame);
+			// The copy draws the same border as the original, so its damage still applies
+			if (unique != frame) unique->copy_damage_info(*frame);
+			frame = unique;
+			if (res != last_resolution_) {
+				frame->clear_damage_info();
+			} else {
+				const auto border = static_cast<dimension_t>(std::min(std::max(thickness_, last_thickness_), res.height));
+				frame->add_damage({res.width, border, 0, 0});
+				frame->add_damage({res.width, border, 0, static_cast<position_t>(res.height - border)});
+			}
+		}
+		last_thickness_ = thickness_;
+		last_resolution_ = res;
+	}
 	if (!thickness_) return frame;
 	switch (frame->get_format()) {
 		case core::raw_format::yuyv422:
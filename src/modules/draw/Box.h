@@ -29,6 +29,8 @@ private:
 
 
 	size_t thickness_;
+	size_t last_thickness_;
+	resolution_t last_resolution_;
 };
 
 } /* namespace draw */
@@ -2,89 +2,93 @@
  * @file 		DXTCompress.cpp
  * @author 		Zdenek Travnicek
  * @date 		11.2.2013
- * @date		16.2.2013
- * @copyright	Institute of Intermedia, CTU in Prague, 2013
+ * @date		18.10.2026
+ * @copyright	Institute of Intermedia, CTU in Prague, 2013 - 2026
  * 				Distributed under modified BSD Licence, details in file doc/LICENSE
  *
  */
 
 #include "DXTCompress.h"
 #include "yuri/core/Module.h"
-#include "squish.h"
+#include "yuri/core/frame/CompressedVideoFrame.h"
+#include "yuri/core/frame/raw_frame_types.h"
+#include "yuri/core/frame/compressed_frame_types.h"
+#include "yuri/core/frame/compressed_frame_params.h"
+#include "yuri/core/thread/ConverterRegister.h"
+#include "yuri/core/thread/FixedMemoryAllocator.h"
+
 namespace yuri {
 namespace dxt_compress {
 
-REGISTER("dxt_compress",DXTCompress)
-
-IO_THREAD_GENERATOR(DXTCompress)
+IOTHREAD_GENERATOR(DXTCompress)
 
+MODULE_REGISTRATION_BEGIN("dxt_compress")
+		REGISTER_IOTHREAD("dxt_compress",DXTCompress)
+		for (const auto fmt: {core::compressed_frame::dxt1, core::compressed_frame::dxt5,
+				core::compressed_frame::ycocg_dxt5}) {
+			REGISTER_CONVERTER(core::raw_format::rgba32, fmt, "dxt_compress", 60)
+			REGISTER_CONVERTER(core::raw_format::rgb24, fmt, "dxt_compress", 60)
+		}
+MODULE_REGISTRATION_END()
 
-//using boost::iequals;
-core::pParameters DXTCompress::configure()
+core::Parameters DXTCompress::configure()
 {
-	core::pParameters p = IOThread::configure();
-	p->set_description("Dummy module. For testing only.");
-	(*p)["type"]["Set type of compression (DXT1, DXT3, DXT5)"]="DXT1";
-	p->set_max_pipes(1,1);
+	core::Parameters p = base_type::configure();
+	p.set_description("Compresses RGB(A) images to DXT1, DXT5 or YCoCg-DXT5 (as used in Hap).");
+	p["format"]["Output format (DXT1, DXT5, YCoCg_DXT)"]="DXT1";
+	p["quality"]["Compression quality. fast is usable in real time, normal and high use squish range fit and cluster fit"]="fast";
+	p["threads"]["Number of threads used to compress a frame"]=1;
 	return p;
 }
 
-DXTCompress::DXTCompress(log::Log &log_,core::pwThreadBase parent, core::Parameters &parameters):
-core::IOThread(log_,parent,1,1,std::string("dxt_compress")),dxt_type(squish::kDxt1),
-format(YURI_FMT_DXT1)
+DXTCompress::DXTCompress(const log::Log &log_, core::pwThreadBase parent, const core::Parameters &parameters):
+base_type(log_,parent,std::string("dxt_compress")),format_(core::compressed_frame::dxt1),
+quality_(dxt_quality_t::fast),threads_(1)
 {
-	IO_THREAD_INIT("DXTCompress")
+	IOTHREAD_INIT(parameters)
+	set_supported_formats({core::raw_format::rgba32, core::raw_format::rgb24});
 }
 
-DXTCompress::~DXTCompress()
+DXTCompress::~DXTCompress() noexcept
 {
 }
 
-bool DXTCompress::step()
+core::pFrame DXTCompress::do_convert_frame(core::pFrame input_frame, format_t target_format)
 {
-	core::pBasicFrame frame = in[0]->pop_frame();
-	if (frame) {
-		yuri::format_t fmt = frame->get_format();
-		if (fmt!=YURI_FMT_RGBA) {
-			log[log::warning] << "Unsupported format " << core::BasicPipe::get_format_string(fmt)
-				<< ". Only RGBA (RGB32) supported\n";
-			return true;
-		}
-		yuri::size_t width  = frame->get_width();
-		yuri::size_t height = frame->get_height();
-		if ((width % 4) || (height % 4)) {
-			// The library can accept even weird size images, so we silently ignore it
-			log[log::debug] << "Input image has to be divisible by 4 in both directions ("
-					<< width << "x" << height << "\n";
-		}
-		log[log::verbose_debug] << "Converting a frame " << width << "x" << height << "\n";
-		const yuri::size_t image_size = squish::GetStorageRequirements(width,height,dxt_type);
-		core::pBasicFrame output(new core::BasicFrame(1));
-		PLANE_DATA(output,0).resize(image_size);
-		squish::CompressImage(PLANE_RAW_DATA(frame,0),width,height,PLANE_RAW_DATA(output,0),dxt_type|squish::kColourRangeFit);
-		if (width&3) width=(width&~3)+4;
-		if (height&3) height=(height&~3)+4;
-		push_video_frame(0, output, format, width, height);
-		log[log::verbose_debug] << "Frame pushed, " << output->get_width() << "x" << output->get_height() << ", size: " << image_size <<" bytes\n";
+	format_ = target_format;
+	auto frame = std::dynamic_pointer_cast<core::RawVideoFrame>(input_frame);
+	if (!frame) return {};
+	return do_special_single_step(frame);
+}
+
+core::pFrame DXTCompress::do_special_single_step(core::pRawVideoFrame frame)
+{
+	if (!is_dxt_compress_supported(frame->get_format(), format_)) {
+		log[log::warning] << "Unsupported format " << frame->get_format_name() << ". Only RGBA32 and RGB24 are supported";
+		return {};
+	}
+	const auto res = frame->get_resolution();
+	const size_t size = dxt_compressed_size(format_, res);
+	auto block = core::FixedMemoryAllocator::get_block(size);
+	auto output = core::CompressedVideoFrame::create_empty(format_, res);
+	output->get_data().set(block.first, size, block.second);
+	if (!dxt_compress(*frame, format_, quality_, output->data(), size, threads_)) {
+		log[log::warning] << "Failed to compress frame " << res;
+		return {};
 	}
-	return true;
+	output->copy_video_params(*frame);
+	return output;
 }
+
 bool DXTCompress::set_param(const core::Parameter& param)
 {
-	if (param.name == "type") {
-		if (iequals(param.get<std::string>(),"DXT5")) {
-			dxt_type = squish::kDxt5; format = YURI_FMT_DXT5;
-			log[log::info] << "Using format DXT5\n";
-		} else if (iequals(param.get<std::string>(),"DXT3")) {
-			dxt_type = squish::kDxt3; format = YURI_FMT_DXT3;
-			log[log::info] << "Using format DXT3\n";
-		} else {
-			dxt_type = squish::kDxt1; format = YURI_FMT_DXT1;
-			log[log::info] << "Using format DXT1\n";
-		}
-	} else return IOThread::set_param(param);
-	return true;
+	if (assign_parameters(param)
+			(format_, "format", [](const core::Parameter& p){ return core::compressed_frame::parse_format(p.get<std::string>()); })
+			(quality_, "quality", [](const core::Parameter& p){ return parse_dxt_quality(p.get<std::string>()); })
+			(threads_, "threads"))
+		return true;
+	return base_type::set_param(param);
 }
 
-} /* namespace dummy_module */
+} /* namespace dxt_compress */
 } /* namespace yuri */
@@ -2,8 +2,8 @@
  * @file 		DXTCompress.h
  * @author 		Zdenek Travnicek
  * @date 		11.2.2013
- * @date		16.2.2013
- * @copyright	Institute of Intermedia, CTU in Prague, 2013
+ * @date		18.10.2026
+ * @copyright	Institute of Intermedia, CTU in Prague, 2013 - 2026
  * 				Distributed under modified BSD Licence, details in file doc/LICENSE
  *
  */
@@ -11,26 +11,33 @@
 #ifndef DXTCompress_H_
 #define DXTCompress_H_
 
-#include "yuri/core/IOThread.h"
+#include "yuri/core/thread/SpecializedIOFilter.h"
+#include "yuri/core/thread/ConverterThread.h"
+#include "yuri/core/frame/RawVideoFrame.h"
+#include "dxt_encode.h"
 
 namespace yuri {
 namespace dxt_compress {
 
 
-class DXTCompress: public yuri::core::IOThread
+class DXTCompress: public core::SpecializedIOFilter<core::RawVideoFrame>, public core::ConverterThread
 {
+	using base_type = core::SpecializedIOFilter<core::RawVideoFrame>;
 public:
-	IO_THREAD_GENERATOR_DECLARATION
-	static core::pParameters configure();
-	virtual ~DXTCompress();
+	IOTHREAD_GENERATOR_DECLARATION
+	static core::Parameters configure();
+	DXTCompress(const log::Log &log_, core::pwThreadBase parent, const core::Parameters &parameters);
+	virtual ~DXTCompress() noexcept;
 private:
-	DXTCompress(log::Log &log_,core::pwThreadBase parent, core::Parameters &parameters);
-	virtual bool step();
-	virtual bool set_param(const core::Parameter& param);
-	int dxt_type;
-	yuri::format_t format;
+	virtual core::pFrame do_special_single_step(core::pRawVideoFrame frame) override;
+	virtual core::pFrame do_convert_frame(core::pFrame input_frame, format_t target_format) override;
+	virtual bool set_param(const core::Parameter& param) override;
+
+	format_t format_;
+	dxt_quality_t quality_;
+	size_t threads_;
 };
 
-} /* namespace dummy_module */
+} /* namespace dxt_compress */
 } /* namespace yuri */
 #endif /* DXTCompress_H_ */
@@ -0,0 +1,297 @@
+/*!
+ * @file 		dxt_encode.cpp
+ * @author 		agent <agent@local>
+ * @date 		18.10.2026
+ * @copyright	Institute of Intermedia, CTU in Prague, 2026
+ * 				Distributed under modified BSD Licence, details in file doc/LICENSE
+ *
+ */
+
+#include "dxt_encode.h"
+#include "squish.h"
+#include "yuri/core/frame/raw_frame_types.h"
+#include "yuri/core/frame/compressed_frame_types.h"
+#include "yuri/core/utils/parallel_for.h"
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+
+namespace yuri {
+namespace dxt_compress {
+
+namespace {
+
+//! 4x4 block of RGBA pixels in row order
+using block_t = uint8_t[64];
+
+//! Minimal number of block rows processed by a single thread
+constexpr size_t min_band = 2;
+
+size_t block_size(format_t format)
+{
+	switch (format) {
+		case core::compressed_frame::dxt1:
+			return 8;
+		case core::compressed_frame::dxt5:
+		case core::compressed_frame::ycocg_dxt5:
+			return 16;
+		default:
+			return 0;
+	}
+}
+
+//! Reads a block from the image, pixels outside of the image are replaced by the nearest edge pixel
+void load_block(const core::RawVideoFrame& frame, size_t bx, size_t by, uint8_t* block)
+{
+	const auto& plane = frame[0];
+	const auto res = plane.get_resolution();
+	const size_t linesize = plane.get_line_size();
+	const bool alpha = frame.get_format() == core::raw_format::rgba32;
+	const size_t bpp = alpha ? 4 : 3;
+	for (size_t y = 0; y < 4; ++y) {
+		const size_t sy = std::min<size_t>(by * 4 + y, res.height - 1);
+		const uint8_t* row = plane.data() + sy * linesize;
+		for (size_t x = 0; x < 4; ++x) {
+			const size_t sx = std::min<size_t>(bx * 4 + x, res.width - 1);
+			const uint8_t* p = row + sx * bpp;
+			uint8_t* d = block + 16 * y + 4 * x;
+			d[0] = p[0];
+			d[1] = p[1];
+			d[2] = p[2];
+			d[3] = alpha ? p[3] : 255;
+		}
+	}
+}
+
+inline uint8_t clip(int value)
+{
+	return static_cast<uint8_t>(std::min(std::max(value, 0), 255));
+}
+
+/*!
+ * Converts the block to scaled YCoCg. Co and Cg are stored in red and green,
+ * scale in blue and luma in alpha, so the block can be encoded as plain DXT5.
+ */
+void rgb_to_ycocg(uint8_t* block)
+{
+	int co[16], cg[16];
+	int range = 0;
+	for (int i = 0; i < 16; ++i) {
+		uint8_t* p = block + 4 * i;
+		const int r = p[0], g = p[1], b = p[2];
+		co[i] = (r - b) / 2;
+		cg[i] = (2 * g - r - b) / 4;
+		range = std::max({range, std::abs(co[i]), std::abs(cg[i])});
+		p[3] = static_cast<uint8_t>((r + 2 * g + b + 2) / 4);
+	}
+	// Small chroma gets scaled up, to use more of the 5 and 6 bits available for it
+	const int scale = range < 32 ? 4 : range < 64 ? 2 : 1;
+	for (int i = 0; i < 16; ++i) {
+		uint8_t* p = block + 4 * i;
+		p[0] = clip(co[i] * scale + 128);
+		p[1] = clip(cg[i] * scale + 128);
+		p[2] = static_cast<uint8_t>((scale - 1) << 3);
+	}
+}
+
+inline uint16_t to_565(const int* color)
+{
+	return static_cast<uint16_t>((color[0] >> 3) << 11 | (color[1] >> 2) << 5 | (color[2] >> 3));
+}
+
+inline void expand_565(uint16_t color, int* out)
+{
+	const int r = (color >> 11) & 0x1F;
+	const int g = (color >> 5) & 0x3F;
+	const int b = color & 0x1F;
+	out[0] = r << 3 | r >> 2;
+	out[1] = g << 2 | g >> 4;
+	out[2] = b << 3 | b >> 2;
+}
+
+inline void write16(uint8_t* dest, uint16_t value)
+{
+	dest[0] = value & 0xFF;
+	dest[1] = value >> 8;
+}
+
+/*!
+ * Encodes colours of the block into 4 colour DXT block. Endpoints are the corners
+ * of the bounding box (slightly inset), on the diagonal that follows the colours.
+ */
+void encode_color_fast(const uint8_t* block, uint8_t* dest)
+{
+	int min[3] = {255, 255, 255};
+	int max[3] = {0, 0, 0};
+	for (int i = 0; i < 16; ++i) {
+		for (int c = 0; c < 3; ++c) {
+			min[c] = std::min<int>(min[c], block[4 * i + c]);
+			max[c] = std::max<int>(max[c], block[4 * i + c]);
+		}
+	}
+	// Pick the diagonal by the sign of covariance with the channel with the biggest range
+	int axis = 0;
+	for (int c = 1; c < 3; ++c) {
+		if (max[c] - min[c] > max[axis] - min[axis]) axis = c;
+	}
+	int center[3];
+	for (int c = 0; c < 3; ++c) {
+		center[c] = (min[c] + max[c]) / 2;
+	}
+	int covariance[3] = {0, 0, 0};
+	for (int i = 0; i < 16; ++i) {
+		const int d = block[4 * i + axis] - center[axis];
+		for (int c = 0; c < 3; ++c) {
+			covariance[c] += d * (block[4 * i + c] - center[c]);
+		}
+	}
+	int ep0[3], ep1[3];
+	for (int c = 0; c < 3; ++c) {
+		const int inset = (max[c] - min[c]) >> 4;
+		const int hi = max[c] - inset;
+		const int lo = min[c] + inset;
+		ep0[c] = covariance[c] < 0 ? lo : hi;
+		ep1[c] = covariance[c] < 0 ? hi : lo;
+	}
+	uint16_t c0 = to_565(ep0);
+	uint16_t c1 = to_565(ep1);
+	// c0 > c1 selects 4 colour mode in DXT1
+	if (c0 < c1) std::swap(c0, c1);
+	write16(dest, c0);
+	write16(dest + 2, c1);
+	if (c0 == c1) {
+		std::fill(dest + 4, dest + 8, 0);
+		return;
+	}
+	int palette[4][3];
+	expand_565(c0, palette[0]);
+	expand_565(c1, palette[1]);
+	for (int c = 0; c < 3; ++c) {
+		palette[2][c] = (2 * palette[0][c] + palette[1][c] + 1) / 3;
+		palette[3][c] = (palette[0][c] + 2 * palette[1][c] + 1) / 3;
+	}
+	uint32_t indices = 0;
+	for (int i = 0; i < 16; ++i) {
+		const uint8_t* p = block + 4 * i;
+		int best = 0;
+		int best_error = 0x7FFFFFFF;
+		for (int j = 0; j < 4; ++j) {
+			const int dr = p[0] - palette[j][0];
+			const int dg = p[1] - palette[j][1];
+			const int db = p[2] - palette[j][2];
+			const int error = dr * dr + dg * dg + db * db;
+			if (error < best_error) {
+				best_error = error;
+				best = j;
+			}
+		}
+		indices |= static_cast<uint32_t>(best) << (2 * i);
+	}
+	for (int i = 0; i < 4; ++i) {
+		dest[4 + i] = (indices >> (8 * i)) & 0xFF;
+	}
+}
+
+//! Encodes alpha of the block into DXT5 alpha block, using 8 value mode
+void encode_alpha_fast(const uint8_t* block, uint8_t* dest)
+{
+	int min = 255, max = 0;
+	for (int i = 0; i < 16; ++i) {
+		min = std::min<int>(min, block[4 * i + 3]);
+		max = std::max<int>(max, block[4 * i + 3]);
+	}
+	const int inset = (max - min) >> 5;
+	max -= inset;
+	min += inset;
+	dest[0] = static_cast<uint8_t>(max);
+	dest[1] = static_cast<uint8_t>(min);
+	const int range = max - min;
+	uint64_t indices = 0;
+	if (range > 0) {
+		for (int i = 0; i < 16; ++i) {
+			// Level 0 is min, 7 is max. The palette is max, min and 6 values from max to min
+			const int level = std::min(std::max((2 * 7 * (block[4 * i + 3] - min) + range) / (2 * range), 0), 7);
+			const uint64_t index = level == 7 ? 0 : level == 0 ? 1 : 8 - level;
+			indices |= index << (3 * i);
+		}
+	}
+	for (int i = 0; i < 6; ++i) {
+		dest[2 + i] = (indices >> (8 * i)) & 0xFF;
+	}
+}
+
+void encode_block(uint8_t* block, format_t format, dxt_quality_t quality, uint8_t* dest)
+{
+	const bool dxt1 = format == core::compressed_frame::dxt1;
+	if (format == core::compressed_frame::ycocg_dxt5) {
+		rgb_to_ycocg(block);
+	}
+	if (quality == dxt_quality_t::fast) {
+		if (dxt1) {
+			encode_color_fast(block, dest);
+		} else {
+			encode_alpha_fast(block, dest);
+			encode_color_fast(block, dest + 8);
+		}
+		return;
+	}
+	if (dxt1) {
+		// Otherwise squish would use transparent black for pixels with alpha < 128
+		for (int i = 0; i < 16; ++i) block[4 * i + 3] = 255;
+	}
+	int flags = dxt1 ? squish::kDxt1 : squish::kDxt5;
+	flags |= quality == dxt_quality_t::normal ? squish::kColourRangeFit : squish::kColourClusterFit;
+	// Perceptual weights make no sense for chroma
+	if (format == core::compressed_frame::ycocg_dxt5) flags |= squish::kColourMetricUniform;
+	squish::Compress(block, dest, flags);
+}
+
+}
+
+dxt_quality_t parse_dxt_quality(const std::string& name)
+{
+	static const std::map<std::string, dxt_quality_t> qualities = {
+			{"fast", dxt_quality_t::fast},
+			{"normal", dxt_quality_t::normal},
+			{"high", dxt_quality_t::high},
+	};
+	auto it = qualities.find(name);
+	if (it == qualities.end()) return dxt_quality_t::fast;
+	return it->second;
+}
+
+size_t dxt_compressed_size(format_t format, resolution_t resolution)
+{
+	return ((resolution.width + 3) / 4) * ((resolution.height + 3) / 4) * block_size(format);
+}
+
+bool is_dxt_compress_supported(format_t source, format_t target)
+{
+	return (source == core::raw_format::rgba32 || source == core::raw_format::rgb24) && block_size(target);
+}
+
+bool dxt_compress(const core::RawVideoFrame& frame, format_t format, dxt_quality_t quality,
+		uint8_t* dest, size_t size, size_t threads)
+{
+	if (!is_dxt_compress_supported(frame.get_format(), format)) return false;
+	const auto res = frame.get_resolution();
+	if (!res.width || !res.height || size < dxt_compressed_size(format, res)) return false;
+	const size_t bsize = block_size(format);
+	const size_t blocks_x = (res.width + 3) / 4;
+	const size_t blocks_y = (res.height + 3) / 4;
+	core::utils::parallel_for(threads, 0, blocks_y, [&](size_t start, size_t end) {
+		block_t block;
+		for (size_t by = start; by < end; ++by) {
+			uint8_t* out = dest + by * blocks_x * bsize;
+			for (size_t bx = 0; bx < blocks_x; ++bx, out += bsize) {
+				load_block(frame, bx, by, block);
+				encode_block(block, format, quality, out);
+			}
+		}
+	}, min_band);
+	return true;
+}
+
+}
+}
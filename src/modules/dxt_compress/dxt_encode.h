@@ -0,0 +1,52 @@
+/*!
+ * @file 		dxt_encode.h
+ * @author 		agent <agent@local>
+ * @date 		18.10.2026
+ * @copyright	Institute of Intermedia, CTU in Prague, 2026
+ * 				Distributed under modified BSD Licence, details in file doc/LICENSE
+ *
+ */
+
+#ifndef DXT_ENCODE_H_
+#define DXT_ENCODE_H_
+
+#include "yuri/core/frame/RawVideoFrame.h"
+#include <string>
+
+namespace yuri {
+namespace dxt_compress {
+
+enum class dxt_quality_t {
+	//! Bounding box endpoints and nearest palette entry, suitable for real-time encoding
+	fast,
+	//! squish range fit
+	normal,
+	//! squish cluster fit, very slow
+	high
+};
+
+//! Parses quality name (fast, normal, high). Returns fast for unknown names.
+dxt_quality_t parse_dxt_quality(const std::string& name);
+
+//! Size of DXT1, DXT5 or YCoCg-DXT5 data for given resolution, padded to whole 4x4 blocks
+size_t dxt_compressed_size(format_t format, resolution_t resolution);
+
+//! Returns true if frames in @em source format can be compressed into @em target
+bool is_dxt_compress_supported(format_t source, format_t target);
+
+/*!
+ * Compresses rgba32 or rgb24 @em frame into DXT1, DXT5 or YCoCg-DXT5 (scaled, as used by Hap Q).
+ *
+ * Image sizes not divisible by 4 are padded by repeating the last row and column.
+ * Rows of blocks are split among @em threads threads.
+ *
+ * @param dest		Output buffer, at least dxt_compressed_size() bytes
+ * @return false if the formats are not supported or the buffer is too small
+ */
+bool dxt_compress(const core::RawVideoFrame& frame, format_t format, dxt_quality_t quality,
+		uint8_t* dest, size_t size, size_t threads = 1);
+
+}
+}
+
+#endif /* DXT_ENCODE_H_ */
@@ -0,0 +1,109 @@
+/*!
+ * @file 		dxt_test.cpp
+ * @author 		agent <agent@local>
+ * @date 		18.10.2026
+ * @copyright	Institute of Intermedia, CTU in Prague, 2026
+ * 				Distributed under modified BSD Licence, details in file doc/LICENSE
+ *
+ */
+
+#include "tests/catch.hpp"
+#include "dxt_encode.h"
+#include "squish.h"
+#include "yuri/core/frame/raw_frame_types.h"
+#include "yuri/core/frame/compressed_frame_types.h"
+#include <cmath>
+#include <vector>
+
+namespace yuri {
+namespace dxt_compress {
+
+namespace {
+
+core::pRawVideoFrame make_frame(format_t format, resolution_t res)
+{
+	auto frame = core::RawVideoFrame::create_empty(format, res);
+	const size_t bpp = format == core::raw_format::rgba32 ? 4 : 3;
+	const size_t linesize = PLANE_DATA(frame, 0).get_line_size();
+	for (dimension_t y = 0; y < res.height; ++y) {
+		uint8_t* row = PLANE_RAW_DATA(frame, 0) + y * linesize;
+		for (dimension_t x = 0; x < res.width; ++x) {
+			// Smooth gradients, that should be compressed with small error
+			row[x * bpp + 0] = static_cast<uint8_t>(x * 255 / res.width);
+			row[x * bpp + 1] = static_cast<uint8_t>(y * 255 / res.height);
+			row[x * bpp + 2] = static_cast<uint8_t>(128 + (x + y) % 64);
+			if (bpp == 4) row[x * bpp + 3] = static_cast<uint8_t>(255 - y * 255 / res.height);
+		}
+	}
+	return frame;
+}
+
+//! Decompresses the image using squish and returns mean absolute error per channel
+double compare(const core::RawVideoFrame& frame, format_t format, const std::vector<uint8_t>& data)
+{
+	const auto res = frame.get_resolution();
+	const size_t blocks_x = (res.width + 3) / 4;
+	const size_t block_size = format == core::compressed_frame::dxt1 ? 8 : 16;
+	const int flags = format == core::compressed_frame::dxt1 ? squish::kDxt1 : squish::kDxt5;
+	const bool alpha = frame.get_format() == core::raw_format::rgba32;
+	const size_t bpp = alpha ? 4 : 3;
+	const size_t channels = alpha && format == core::compressed_frame::dxt5 ? 4 : 3;
+	double error = 0.0;
+	for (dimension_t y = 0; y < res.height; ++y) {
+		for (dimension_t x = 0; x < res.width; ++x) {
+			uint8_t block[64];
+			squish::Decompress(block, data.data() + ((y / 4) * blocks_x + x / 4) * block_size, flags);
+			uint8_t* p = block + 16 * (y % 4) + 4 * (x % 4);
+			if (format == core::compressed_frame::ycocg_dxt5) {
+				const int scale = (p[2] >> 3) + 1;
+				const int co = (p[0] - 128) / scale;
+				const int cg = (p[1] - 128) / scale;
+				const int luma = p[3];
+				p[0] = static_cast<uint8_t>(std::min(std::max(luma + co - cg, 0), 255));
+				p[1] = static_cast<uint8_t>(std::min(std::max(luma + cg, 0), 255));
+				p[2] = static_cast<uint8_t>(std::min(std::max(luma - co - cg, 0), 255));
+			}
+			const uint8_t* s = frame[0].data() + y * frame[0].get_line_size() + x * bpp;
+			for (size_t c = 0; c < channels; ++c) {
+				error += std::abs(static_cast<int>(s[c]) - p[c]);
+			}
+		}
+	}
+	return error / (res.width * res.height * channels);
+}
+
+}
+
+TEST_CASE( "dxt options", "[module]" ) {
+	REQUIRE( parse_dxt_quality("high") == dxt_quality_t::high );
+	REQUIRE( parse_dxt_quality("nonsense") == dxt_quality_t::fast );
+	REQUIRE( dxt_compressed_size(core::compressed_frame::dxt1, {5, 4}) == 16 );
+	REQUIRE( dxt_compressed_size(core::compressed_frame::ycocg_dxt5, {8, 5}) == 64 );
+	REQUIRE( is_dxt_compress_supported(core::raw_format::rgb24, core::compressed_frame::dxt5) );
+	REQUIRE( !is_dxt_compress_supported(core::raw_format::yuyv422, core::compressed_frame::dxt5) );
+	REQUIRE( !is_dxt_compress_supported(core::raw_format::rgb24, core::compressed_frame::jpeg) );
+}
+
+TEST_CASE( "dxt compression", "[module]" ) {
+	const resolution_t res{66, 37};
+	for (format_t input: {core::raw_format::rgb24, core::raw_format::rgba32}) {
+		const auto frame = make_frame(input, res);
+		for (format_t format: {core::compressed_frame::dxt1, core::compressed_frame::dxt5, core::compressed_frame::ycocg_dxt5}) {
+			const size_t size = dxt_compressed_size(format, res);
+			REQUIRE( !dxt_compress(*frame, format, dxt_quality_t::fast, nullptr, size - 1) );
+			std::vector<uint8_t> reference;
+			for (auto quality: {dxt_quality_t::fast, dxt_quality_t::normal, dxt_quality_t::high}) {
+				std::vector<uint8_t> data(size);
+				REQUIRE( dxt_compress(*frame, format, quality, data.data(), data.size()) );
+				REQUIRE( compare(*frame, format, data) < 3.5 );
+				if (quality == dxt_quality_t::fast) reference = data;
+			}
+			std::vector<uint8_t> threaded(size);
+			REQUIRE( dxt_compress(*frame, format, dxt_quality_t::fast, threaded.data(), threaded.size(), 4) );
+			REQUIRE( threaded == reference );
+		}
+	}
+}
+
+}
+}
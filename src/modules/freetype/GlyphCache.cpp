@@ -0,0 +1,68 @@
+/*!
+ * @file 		GlyphCache.cpp
+ * @author 		agent <agent@local>
+ * @date		18.10.2026
+ * @copyright	Institute of Intermedia, 2026
+ * 				Distributed BSD License
+ *
+ */
+
+#include "GlyphCache.h"
+#include <algorithm>
+#include <cstdlib>
+
+namespace yuri {
+namespace freetype {
+
+GlyphCache::GlyphCache(size_t capacity) : glyphs_(capacity)
+{
+}
+
+pGlyph GlyphCache::get_glyph(FT_Face face, size_t size, FT_UInt index)
+{
+    const key_t key{ face, size, index };
+    if (auto glyph = glyphs_.get(key)) {
+        return *glyph;
+    }
+    if (FT_Load_Glyph(face, index, FT_LOAD_RENDER)) {
+        return {};
+    }
+    const auto& slot   = *face->glyph;
+    const auto& bitmap = slot.bitmap;
+    auto        glyph  = std::make_shared<glyph_t>();
+    glyph->width       = bitmap.width;
+    glyph->rows        = bitmap.rows;
+    glyph->pitch       = bitmap.width;
+    glyph->left        = slot.bitmap_left;
+    glyph->top         = slot.bitmap_top;
+    glyph->advance     = ((slot.linearHoriAdvance & 0xFFFF0000) >> 16) + static_cast<double>(slot.linearHoriAdvance & 0xFFFF) / 0xFFFF;
+    glyph->buffer.resize(glyph->pitch * glyph->rows);
+    for (dimension_t row = 0; row < glyph->rows; ++row) {
+        const uint8_t* src = bitmap.buffer + static_cast<position_t>(row) * bitmap.pitch;
+        std::copy(src, src + glyph->width, glyph->buffer.begin() + row * glyph->pitch);
+    }
+    return glyphs_.put(key, std::move(glyph));
+}
+
+double GlyphCache::get_kerning(FT_Face face, FT_UInt left, FT_UInt right)
+{
+    const auto key = std::make_tuple(face, left, right);
+    auto       it  = kerning_.find(key);
+    if (it != kerning_.end()) {
+        return it->second;
+    }
+    FT_Vector delta{ 0, 0 };
+    FT_Get_Kerning(face, left, right, FT_KERNING_UNFITTED, &delta);
+    const double kern = (delta.x >> 6) + static_cast<double>(delta.x & 0x3F) / 0x3F;
+    kerning_[key]     = kern;
+    return kern;
+}
+
+void GlyphCache::clear()
+{
+    glyphs_.clear();
+    kerning_.clear();
+}
+
+} /* namespace freetype */
+} /* namespace yuri */
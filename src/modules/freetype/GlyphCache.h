@@ -0,0 +1,166 @@
+/*!
+ * @file 		GlyphCache.h
+ * @author 		agent <agent@local>
+ * @date		18.10.2026
+ * @copyright	Institute of Intermedia, 2026
+ * 				Distributed BSD License
+ *
+ */
+
+#ifndef GLYPHCACHE_H_
+#define GLYPHCACHE_H_
+
+#include "yuri/core/utils/new_types.h"
+#include <ft2build.h>
+#include FT_FREETYPE_H
+#include <list>
+#include <map>
+#include <memory>
+#include <string>
+#include <tuple>
+#include <unordered_map>
+#include <vector>
+
+namespace yuri {
+namespace freetype {
+
+/*!
+ * Rendered glyph, with the bitmap copied out of freetype.
+ */
+struct glyph_t {
+    std::vector<uint8_t> buffer;
+    dimension_t          width;
+    dimension_t          rows;
+    //! Number of bytes between two lines of the bitmap
+    size_t pitch;
+    //! Offset of the bitmap from the pen position
+    position_t left;
+    position_t top;
+    //! Horizontal advance in pixels
+    double advance;
+};
+
+using pGlyph = std::shared_ptr<const glyph_t>;
+
+/*!
+ * Glyph positioned relatively to the start of a line
+ */
+struct placed_glyph_t {
+    pGlyph        glyph;
+    coordinates_t position;
+};
+
+using line_layout_t = std::vector<placed_glyph_t>;
+
+/*!
+ * Simple LRU cache.
+ * Retrieving a value moves it to the front, inserting into a full cache drops the last used value.
+ */
+template <class Key, class Value, class Hash = std::hash<Key>>
+class LRUCache {
+public:
+    LRUCache(size_t capacity) : capacity_(capacity) {}
+
+    /*!
+     * Returns pointer to the cached value or nullptr
+     */
+    const Value* get(const Key& key)
+    {
+        auto it = index_.find(key);
+        if (it == index_.end())
+            return nullptr;
+        values_.splice(values_.begin(), values_, it->second);
+        return &it->second->second;
+    }
+
+    const Value& put(const Key& key, Value value)
+    {
+        auto it = index_.find(key);
+        if (it != index_.end()) {
+            values_.erase(it->second);
+            index_.erase(it);
+        }
+        values_.emplace_front(key, std::move(value));
+        index_[key] = values_.begin();
+        shrink();
+        return values_.front().second;
+    }
+
+    void set_capacity(size_t capacity)
+    {
+        capacity_ = capacity;
+        shrink();
+    }
+
+    size_t size() const { return values_.size(); }
+
+    void clear()
+    {
+        index_.clear();
+        values_.clear();
+    }
+
+private:
+    void shrink()
+    {
+        while (values_.size() > std::max<size_t>(capacity_, 1)) {
+            index_.erase(values_.back().first);
+            values_.pop_back();
+        }
+    }
+    using list_t = std::list<std::pair<Key, Value>>;
+    size_t                                                   capacity_;
+    list_t                                                   values_;
+    std::unordered_map<Key, typename list_t::iterator, Hash> index_;
+};
+
+/*!
+ * Cache of rendered glyphs and kerning pairs.
+ *
+ * Glyphs are keyed by (face, size, glyph index), so the cache can be shared for
+ * several faces. Glyphs are returned as shared pointers and stay valid even after
+ * they're evicted from the cache.
+ */
+class GlyphCache {
+public:
+    GlyphCache(size_t capacity);
+
+    /*!
+     * Returns rendered glyph, rendering it if it's not in the cache.
+     * @param face  Font face, it has to have pixel size set to @em size
+     * @param size  Font size in pixels
+     * @param index Glyph index
+     * @return Rendered glyph or nullptr if freetype failed to render it
+     */
+    pGlyph get_glyph(FT_Face face, size_t size, FT_UInt index);
+
+    /*!
+     * Returns horizontal kerning (in pixels) for a pair of glyph indices.
+     */
+    double get_kerning(FT_Face face, FT_UInt left, FT_UInt right);
+
+    void   set_capacity(size_t capacity) { glyphs_.set_capacity(capacity); }
+    size_t size() const { return glyphs_.size(); }
+    void   clear();
+
+private:
+    struct key_t {
+        FT_Face face;
+        size_t  size;
+        FT_UInt index;
+        bool    operator==(const key_t& other) const { return face == other.face && size == other.size && index == other.index; }
+    };
+    struct key_hash {
+        size_t operator()(const key_t& key) const
+        {
+            return std::hash<const void*>()(key.face) ^ (std::hash<size_t>()(key.size) << 1) ^ (std::hash<FT_UInt>()(key.index) << 7);
+        }
+    };
+    LRUCache<key_t, pGlyph, key_hash>                  glyphs_;
+    std::map<std::tuple<FT_Face, FT_UInt, FT_UInt>, double> kerning_;
+};
+
+} /* namespace freetype */
+} /* namespace yuri */
+
+#endif /* GLYPHCACHE_H_ */
@@ -16,6 +16,9 @@
 #include "yuri/core/utils/assign_events.h"
 #include "yuri/core/utils/string_generator.h"
 #include "yuri/core/utils/utf8.h"
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
 namespace yuri {
 namespace freetype {
 
@@ -43,6 +46,7 @@ core::Parameters RenderText::configure()
     p["blend"]["Blend edged - nicer output, but slower"]                                                 = true;
     p["utf8"]["Handle text as utf8"]                                                                     = true;
     p["color"]["Text color"]                                                                             = core::color_t::create_rgb(0xFF, 0xFF, 0xFF);
+    p["glyph_cache"]["Maximal number of rendered glyphs kept in cache"]                                  = 512;
     return p;
 }
 
@@ -56,10 +60,17 @@ RenderText::RenderText(const log::Log& log_, core::pwThreadBase parent, const co
       edge_blend_{ true },
       modified_{ true },
       utf8_{ true },
-      color_(core::color_t::create_rgb(0xFF, 0xFF, 0xFF))
+      color_(core::color_t::create_rgb(0xFF, 0xFF, 0xFF)),
+      dirty_{ true },
+      first_frame_{ true },
+      last_bounds_{ 0, 0, 0, 0 },
+      glyph_cache_size_{ 512 },
+      glyph_cache_(glyph_cache_size_),
+      layout_cache_(64)
 {
     set_latency(50_ms);
     IOTHREAD_INIT(parameters)
+    glyph_cache_.set_capacity(glyph_cache_size_);
     FT_Init_FreeType(&library_);
     if (FT_New_Face(library_, font_file_.c_str(), 0, &face_)) {
         throw exception::InitializationFailed("Failed to load font face");
@@ -117,6 +128,72 @@ struct compute_value<false> {
     }
 };
 
+#if defined(__SSE2__)
+/*
+ * SSE2 versions of the blending kernels.
+ * They process as many pixels as possible, advancing the pointers,
+ * and leave the rest for the scalar kernels.
+ * The division by 255 is exact, so the results are identical to compute_value<true>.
+ */
+namespace simd {
+
+inline __m128i div255(__m128i x)
+{
+    x = _mm_add_epi16(x, _mm_set1_epi16(1));
+    return _mm_srli_epi16(_mm_add_epi16(x, _mm_srli_epi16(x, 8)), 8);
+}
+
+//! Blends 8 pixels in 16bit lanes
+inline __m128i blend8(__m128i out, __m128i p, __m128i color)
+{
+    const __m128i inv = _mm_sub_epi16(_mm_set1_epi16(255), p);
+    return div255(_mm_add_epi16(_mm_mullo_epi16(out, inv), _mm_mullo_epi16(color, p)));
+}
+
+inline void blend_y8(const uint8_t*& in, const uint8_t* in_end, uint8_t*& out, uint8_t color)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i c    = _mm_set1_epi16(color);
+    for (; in_end - in >= 16; in += 16, out += 16) {
+        const __m128i p = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in));
+        if (_mm_movemask_epi8(_mm_cmpeq_epi8(p, zero)) == 0xFFFF)
+            continue;
+        const __m128i o  = _mm_loadu_si128(reinterpret_cast<const __m128i*>(out));
+        const __m128i lo = blend8(_mm_unpacklo_epi8(o, zero), _mm_unpacklo_epi8(p, zero), c);
+        const __m128i hi = blend8(_mm_unpackhi_epi8(o, zero), _mm_unpackhi_epi8(p, zero), c);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out), _mm_packus_epi16(lo, hi));
+    }
+}
+
+/*!
+ * Blends into 4 byte pixels with alpha at position @em alpha_pos.
+ * Alpha is set to 255 for all pixels covered by the glyph.
+ * @param color color for each of 4 bytes of a pixel (value for alpha is ignored)
+ */
+template <int alpha_pos>
+void blend_4byte(const uint8_t*& in, const uint8_t* in_end, uint8_t*& out, const std::array<uint8_t, 4>& color)
+{
+    const __m128i zero       = _mm_setzero_si128();
+    const __m128i c          = _mm_setr_epi16(color[0], color[1], color[2], color[3], color[0], color[1], color[2], color[3]);
+    const __m128i alpha_mask = _mm_set1_epi32(0xFF << (alpha_pos * 8));
+    for (; in_end - in >= 4; in += 4, out += 16) {
+        int32_t cover;
+        std::copy(in, in + 4, reinterpret_cast<uint8_t*>(&cover));
+        if (!cover)
+            continue;
+        __m128i p = _mm_cvtsi32_si128(cover);
+        p         = _mm_unpacklo_epi8(p, p);
+        p         = _mm_unpacklo_epi16(p, p);
+        const __m128i o   = _mm_loadu_si128(reinterpret_cast<const __m128i*>(out));
+        const __m128i lo  = blend8(_mm_unpacklo_epi8(o, zero), _mm_unpacklo_epi8(p, zero), c);
+        const __m128i hi  = blend8(_mm_unpackhi_epi8(o, zero), _mm_unpackhi_epi8(p, zero), c);
+        const __m128i set = _mm_andnot_si128(_mm_cmpeq_epi8(p, zero), alpha_mask);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out), _mm_or_si128(_mm_packus_epi16(lo, hi), set));
+    }
+}
+}
+#endif
+
 template <format_t fmt, bool blend>
 struct draw_kernel;
 
@@ -125,6 +202,10 @@ struct draw_kernel<y8, blend> {
     template <typename T, typename T2>
     static void draw(T in, const T in_end, T2 out, const std::array<uint8_t, 4>& color, bool)
     {
+#if defined(__SSE2__)
+        if (blend)
+            simd::blend_y8(in, in_end, out, color[0]);
+#endif
         while (in != in_end) {
             const auto p = *in;
             if (p)
@@ -185,6 +266,10 @@ struct draw_kernel<rgba32, blend> {
     template <typename T, typename T2>
     static void draw(T in, const T in_end, T2 out, const std::array<uint8_t, 4>& color, bool)
     {
+#if defined(__SSE2__)
+        if (blend)
+            simd::blend_4byte<3>(in, in_end, out, color);
+#endif
         const auto out_max = std::numeric_limits<typename std::remove_reference<decltype(*out)>::type>::max();
         while (in != in_end) {
             const auto p = *in;
@@ -214,6 +299,10 @@ struct draw_kernel<argb32, blend> {
     template <typename T, typename T2>
     static void draw(T in, const T in_end, T2 out, const std::array<uint8_t, 4>& color, bool)
     {
+#if defined(__SSE2__)
+        if (blend)
+            simd::blend_4byte<0>(in, in_end, out, { { 0, color[0], color[1], color[2] } });
+#endif
         const auto out_max = std::numeric_limits<typename std::remove_reference<decltype(*out)>::type>::max();
         while (in != in_end) {
             const auto p = *in;
@@ -239,7 +328,7 @@ struct draw_kernel<abgr32, blend> {
 };
 
 template <format_t fmt, bool blend>
-void draw_glyph_impl(core::pRawVideoFrame frame, const FT_Bitmap& bmp, coordinates_t position, geometry_t draw_rect, const std::array<uint8_t, 4>& color)
+void draw_glyph_impl(core::pRawVideoFrame frame, const glyph_t& bmp, coordinates_t position, geometry_t draw_rect, const std::array<uint8_t, 4>& color)
 {
     auto       data     = PLANE_RAW_DATA(frame, 0);
     const auto linesize = PLANE_DATA(frame, 0).get_line_size();
@@ -359,6 +448,10 @@ struct draw_kernel<yuva4444, blend> {
     template <typename T, typename T2>
     static void draw(T in, const T in_end, T2 out, const std::array<uint8_t, 4>& color, bool)
     {
+#if defined(__SSE2__)
+        if (blend)
+            simd::blend_4byte<3>(in, in_end, out, color);
+#endif
         const auto out_max = std::numeric_limits<typename std::remove_reference<decltype(*out)>::type>::max();
         while (in != in_end) {
             const auto p = *in;
@@ -375,7 +468,7 @@ struct draw_kernel<yuva4444, blend> {
 };
 
 template <format_t fmt>
-void draw_glyph_impl(core::pRawVideoFrame frame, const FT_Bitmap& bmp, coordinates_t position, geometry_t draw_rect, bool blend,
+void draw_glyph_impl(core::pRawVideoFrame frame, const glyph_t& bmp, coordinates_t position, geometry_t draw_rect, bool blend,
                      const std::array<uint8_t, 4>& color)
 {
     if (blend)
@@ -384,16 +477,19 @@ void draw_glyph_impl(core::pRawVideoFrame frame, const FT_Bitmap& bmp, coordinat
         draw_glyph_impl<fmt, false>(frame, bmp, position, draw_rect, color);
 }
 
-bool draw_glyph(FT_GlyphSlot glyph, core::pRawVideoFrame frame, coordinates_t position, bool blend, const core::color_t& color)
+/*!
+ * Draws glyph into the frame
+ * @return rectangle actually drawn into
+ */
+geometry_t draw_glyph(const glyph_t& bitmap, core::pRawVideoFrame frame, coordinates_t position, bool blend, const core::color_t& color)
 {
-    const auto& bitmap       = glyph->bitmap;
     const auto  bmp_geometry = geometry_t{ static_cast<dimension_t>(bitmap.width), static_cast<dimension_t>(bitmap.rows), position.x, position.y };
 
     const auto frame_resolution = frame->get_resolution();
 
     const auto draw_rect = intersection(frame_resolution, bmp_geometry);
     if (!draw_rect)
-        return false;
+        return draw_rect;
     switch (frame->get_format()) {
     case y8:
         draw_glyph_impl<y8>(frame, bitmap, position, draw_rect, blend, color.get_yuva());
@@ -435,21 +531,15 @@ bool draw_glyph(FT_GlyphSlot glyph, core::pRawVideoFrame frame, coordinates_t po
         draw_glyph_impl<yuva4444>(frame, bitmap, position, draw_rect, blend, color.get_yuva());
         break;
     default:
-        return false;
+        return geometry_t{ 0, 0, 0, 0 };
     }
 
-    return true;
+    return draw_rect;
 }
 }
 
 void RenderText::run()
 {
-    core::pRawVideoFrame gframe;
-    if (generate_) {
-        // Create an empty frame for generate(
-        gframe = core::RawVideoFrame::create_empty(core::raw_format::y8, resolution_);
-        std::fill(PLANE_DATA(gframe, 0).begin(), PLANE_DATA(gframe, 0).end(), 0);
-    }
     Timer timer;
     bool  fps_valid   = fps_ != 0.0;
     auto  frame_delta = fps_valid ? 1_s / fps_ : 0_s;
@@ -463,7 +553,8 @@ void RenderText::run()
             process_events();
             if (modified_ || (fps_valid && timer.get_duration() > frame_delta)) {
                 timer.reset();
-                push_frame(0, do_special_single_step(gframe));
+                generated_ = std::dynamic_pointer_cast<core::RawVideoFrame>(do_special_single_step(get_blank_frame()));
+                push_frame(0, generated_);
                 modified_ = false;
             } else {
                 if (fps_valid)
@@ -479,21 +570,45 @@ void RenderText::run()
 
 core::pFrame RenderText::do_special_single_step(core::pRawVideoFrame frame)
 {
-    auto f    = get_frame_unique(frame);
-    auto text = core::utils::generate_string(text_, 0, frame);
-    draw_text(text, f);
+    auto       f       = get_frame_unique(frame);
+    // Damage of the input still applies, the text bounds are added below
+    if (f != frame)
+        f->copy_damage_info(*frame);
+    auto       text    = core::utils::generate_string(text_, 0, frame);
+    const auto bounds  = draw_text(text, f);
+    const bool changed = dirty_ || text != last_text_;
+    if (generate_ && !first_frame_) {
+        // Generated frames always start from a blank image, so only the text changes.
+        f->set_damage({});
+    }
+    if (changed) {
+        f->add_damage(last_bounds_);
+        f->add_damage(bounds);
+    }
+    dirty_       = false;
+    first_frame_ = false;
+    last_text_   = std::move(text);
+    last_bounds_ = bounds;
     return f;
 }
 
-void RenderText::draw_text(const std::string& text, core::pRawVideoFrame& frame)
+geometry_t RenderText::draw_text(const std::string& text, core::pRawVideoFrame& frame)
 {
-    coordinates_t position          = position_;
-    double        horiz_pos         = 0.0;
-    char32_t      prev              = 0;
-    bool          do_kerning        = kerning_ && FT_HAS_KERNING(face_);
-    char32_t      unicode_character = 0;
-    int           remaining         = 0;
-    bool          backslash         = false;
+    geometry_t     bounds            = { 0, 0, 0, 0 };
+    coordinates_t  position          = position_;
+    const bool     blend             = edge_blend_ && !generate_;
+    char32_t       unicode_character = 0;
+    int            remaining         = 0;
+    bool           backslash         = false;
+    std::u32string line;
+
+    auto draw_line = [&]() {
+        for (const auto& g : get_line_layout(line)) {
+            bounds = bounding_box(bounds, draw_glyph(*g.glyph, frame, g.position + position, blend, color_));
+        }
+        line.clear();
+    };
+
     for (auto c : text) {
         if (utf8_) {
             std::tie(unicode_character, remaining) = utils::utf8_char(c, unicode_character, remaining);
@@ -513,46 +628,76 @@ void RenderText::draw_text(const std::string& text, core::pRawVideoFrame& frame)
             backslash = false;
             switch (unicode_character) {
             case 'n':
-                horiz_pos = 0;
+                draw_line();
                 position.y += line_height_ ? line_height_ : font_size_;
                 continue;
             case 'r':
-                horiz_pos = 0;
+                draw_line();
                 continue;
             default:
                 break;
             }
         }
+        line.push_back(unicode_character);
+    }
+    draw_line();
+    return bounds;
+}
 
-        FT_GlyphSlot glyph = nullptr;
-        auto         idx   = FT_Get_Char_Index(face_, unicode_character);
+const line_layout_t& RenderText::get_line_layout(const std::u32string& line)
+{
+    if (auto layout = layout_cache_.get(line)) {
+        return *layout;
+    }
+    line_layout_t layout;
+    layout.reserve(line.size());
+    const bool do_kerning = kerning_ && FT_HAS_KERNING(face_);
+    double     horiz_pos  = 0.0;
+    FT_UInt    prev       = 0;
+    for (auto c : line) {
+        const auto idx   = FT_Get_Char_Index(face_, c);
+        pGlyph     glyph;
         if (idx == 0 && !font_file2_.empty()) {
-            idx = FT_Get_Char_Index(face2_, unicode_character);
-            if (idx == 0) {
+            const auto idx2 = FT_Get_Char_Index(face2_, c);
+            if (idx2 == 0) {
                 log[log::debug] << "Unsupported character found";
             }
-            FT_Load_Glyph(face2_, idx, FT_LOAD_RENDER);
-            glyph = face2_->glyph;
+            glyph = glyph_cache_.get_glyph(face2_, font_size_, idx2);
         } else {
-            FT_Load_Glyph(face_, idx, FT_LOAD_RENDER);
-            glyph = face_->glyph;
+            glyph = glyph_cache_.get_glyph(face_, font_size_, idx);
         }
+        if (!glyph)
+            continue;
 
         if (do_kerning) {
-            uint32_t idx = FT_Get_Char_Index(face_, unicode_character);
             if (prev) {
-                FT_Vector delta;
-                FT_Get_Kerning(face_, prev, idx, FT_KERNING_UNFITTED, &delta);
-                const double kern = (delta.x >> 6) + static_cast<double>(delta.x & 0x3F) / 0x3F;
-                horiz_pos += kern;
+                horiz_pos += glyph_cache_.get_kerning(face_, prev, idx);
             }
             prev = idx;
         }
-        auto coord = coordinates_t{ static_cast<position_t>(horiz_pos) + glyph->bitmap_left, -glyph->bitmap_top } + position;
-        draw_glyph(glyph, frame, coord, edge_blend_ && !generate_, color_);
-        const double advance = ((glyph->linearHoriAdvance & 0xFFFF0000) >> 16) + static_cast<double>(glyph->linearHoriAdvance & 0xFFFF) / 0xFFFF;
-        horiz_pos += advance;
+        layout.push_back({ glyph, coordinates_t{ static_cast<position_t>(horiz_pos) + glyph->left, -glyph->top } });
+        horiz_pos += glyph->advance;
     }
+    return layout_cache_.put(line, std::move(layout));
+}
+
+core::pRawVideoFrame RenderText::get_blank_frame()
+{
+    auto frame = std::move(generated_);
+    if (frame && is_frame_unique(frame) && frame->get_resolution() == resolution_) {
+        // Nobody else holds the last frame, so it's enough to clear the previous text
+        const auto rect     = intersection(last_bounds_, resolution_);
+        const auto linesize = PLANE_DATA(frame, 0).get_line_size();
+        for (auto line : irange(rect.y, rect.y + static_cast<position_t>(rect.height))) {
+            auto start = PLANE_RAW_DATA(frame, 0) + line * linesize + rect.x;
+            std::fill(start, start + rect.width, 0);
+        }
+        frame->set_timestamp(timestamp_t{});
+        return frame;
+    }
+    frame = core::RawVideoFrame::create_empty(core::raw_format::y8, resolution_);
+    std::fill(PLANE_DATA(frame, 0).begin(), PLANE_DATA(frame, 0).end(), 0);
+    return frame;
 }
 
 bool RenderText::set_param(const core::Parameter& param)
@@ -571,7 +716,8 @@ bool RenderText::set_param(const core::Parameter& param)
         (edge_blend_, "blend")        //
         (fps_, "fps")                 //
         (utf8_, "utf8")               //
-        (color_, "color"))
+        (color_, "color")             //
+        (glyph_cache_size_, "glyph_cache"))
         return true;
     return base_type::set_param(param);
 }
@@ -582,18 +728,22 @@ bool RenderText::do_process_event(const std::string& event_name, const event::pB
         (text_, "text", "message")       //
         (color_, "color")) {
         modified_ = true;
+        dirty_    = true;
         return true;
     }
     if (iequals(event_name, "delete")) {
         text_     = "";
         modified_ = true;
+        dirty_    = true;
         return true;
     }
     if (assign_events(event_name, event) //
         (position_, "position")          //
         (position_.x, "x")               //
-        (position_.y, "y"))
+        (position_.y, "y")) {
+        dirty_ = true;
         return true;
+    }
     return false;
 }
 } /* namespace freetype */
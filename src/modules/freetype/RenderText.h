@@ -14,6 +14,7 @@
 #include "yuri/core/frame/RawVideoFrame.h"
 #include "yuri/event/BasicEventConsumer.h"
 #include "yuri/core/utils/color.h"
+#include "GlyphCache.h"
 #include <ft2build.h>
 //#include <freetype/freetype.h>
 #include FT_FREETYPE_H
@@ -36,7 +37,15 @@ private:
     virtual core::pFrame do_special_single_step(core::pRawVideoFrame frame) override;
     virtual bool set_param(const core::Parameter& param) override;
     virtual bool do_process_event(const std::string& event_name, const event::pBasicEvent& event) override;
-    void draw_text(const std::string& text, core::pRawVideoFrame& frame);
+    geometry_t draw_text(const std::string& text, core::pRawVideoFrame& frame);
+    /*!
+     * Returns layout of a single line of text, using cached layout if possible
+     */
+    const line_layout_t& get_line_layout(const std::u32string& line);
+    /*!
+     * Returns blank frame for generate mode. Last generated frame is reused when possible.
+     */
+    core::pRawVideoFrame get_blank_frame();
 
 private:
     FT_Library library_;
@@ -58,6 +67,16 @@ private:
     bool          modified_;
     bool          utf8_;
     core::color_t color_;
+    //! Set when any parameter affecting rendered text changed
+    bool        dirty_;
+    bool        first_frame_;
+    std::string last_text_;
+    geometry_t  last_bounds_;
+    size_t      glyph_cache_size_;
+    GlyphCache  glyph_cache_;
+    LRUCache<std::u32string, line_layout_t>
+                         layout_cache_;
+    core::pRawVideoFrame generated_;
 };
 
 } /* namespace freetype */
@@ -0,0 +1,71 @@
+/*!
+ * @file 		DXTDecoder.cpp
+ * @author 		agent <agent@local>
+ * @date 		18.10.2026
+ * @copyright	Institute of Intermedia, CTU in Prague, 2026
+ * 				Distributed under modified BSD Licence, details in file doc/LICENSE
+ *
+ */
+
+#include "DXTDecoder.h"
+#include "dxt_decompress.h"
+#include "yuri/core/Module.h"
+#include "yuri/core/frame/raw_frame_types.h"
+#include "yuri/core/frame/raw_frame_params.h"
+#include "yuri/core/frame/RawVideoFrame.h"
+
+namespace yuri {
+    namespace hap_decoder {
+
+        IOTHREAD_GENERATOR(DXTDecoder)
+
+        core::Parameters DXTDecoder::configure() {
+            core::Parameters p = core::SpecializedIOFilter<core::CompressedVideoFrame>::configure();
+            p.set_description("Decompresses DXT1, DXT5 and YCoCg-DXT5 frames on CPU.");
+            p["format"]["Output format (RGBA32, RGB24, YUV444, YUV420P)"] = "RGBA32";
+            p["threads"]["Number of threads used to decompress a frame"] = 1;
+            return p;
+        }
+
+        DXTDecoder::DXTDecoder(const log::Log &log_, core::pwThreadBase parent, const core::Parameters &parameters)
+                : core::SpecializedIOFilter<core::CompressedVideoFrame>(log_, parent, std::string("dxt_decoder")),
+                  output_format_(core::raw_format::rgba32), threads_(1) {
+            IOTHREAD_INIT(parameters)
+        }
+
+        DXTDecoder::~DXTDecoder() noexcept {
+        }
+
+        core::pFrame DXTDecoder::do_convert_frame(core::pFrame input_frame, format_t target_format) {
+            output_format_ = target_format;
+            auto frame = std::dynamic_pointer_cast<core::CompressedVideoFrame>(input_frame);
+            if (!frame) return {};
+            return do_special_single_step(frame);
+        }
+
+        core::pFrame DXTDecoder::do_special_single_step(core::pCompressedVideoFrame frame) {
+            if (!is_dxt_decompress_supported(frame->get_format(), output_format_)) {
+                log[log::warning] << "Unsupported conversion from " << frame->get_format_name() << " to "
+                                  << core::raw_format::get_format_name(output_format_);
+                return {};
+            }
+            auto out_frame = core::RawVideoFrame::create_empty(output_format_, frame->get_resolution(), true);
+            if (!dxt_decompress(frame->get_format(), frame->data(), frame->size(), *out_frame, threads_)) {
+                log[log::warning] << "Not enough data in the frame";
+                return {};
+            }
+            out_frame->copy_video_params(*frame);
+            return out_frame;
+        }
+
+        bool DXTDecoder::set_param(const core::Parameter &param) {
+            if (assign_parameters(param)
+                    (output_format_, "format",
+                     [](const core::Parameter &p) { return core::raw_format::parse_format(p.get<std::string>()); })
+                    (threads_, "threads"))
+                return true;
+            return core::SpecializedIOFilter<core::CompressedVideoFrame>::set_param(param);
+        }
+
+    } /* namespace hap_decoder */
+} /* namespace yuri */
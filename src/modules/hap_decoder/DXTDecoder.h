@@ -0,0 +1,47 @@
+/*!
+ * @file 		DXTDecoder.h
+ * @author 		agent <agent@local>
+ * @date 		18.10.2026
+ * @copyright	Institute of Intermedia, CTU in Prague, 2026
+ * 				Distributed under modified BSD Licence, details in file doc/LICENSE
+ *
+ */
+
+#ifndef DXTDECODER_H_
+#define DXTDECODER_H_
+
+#include "yuri/core/thread/SpecializedIOFilter.h"
+#include "yuri/core/thread/ConverterThread.h"
+#include "yuri/core/frame/CompressedVideoFrame.h"
+
+namespace yuri {
+    namespace hap_decoder {
+
+        /*!
+         * Decompresses DXT1, DXT5 and YCoCg-DXT5 frames (as output by HapDecoder) on CPU,
+         * so they can be processed without OpenGL.
+         */
+        class DXTDecoder : public core::SpecializedIOFilter<core::CompressedVideoFrame>, public core::ConverterThread {
+        public:
+            IOTHREAD_GENERATOR_DECLARATION
+
+            static core::Parameters configure();
+
+            DXTDecoder(const log::Log &log_, core::pwThreadBase parent, const core::Parameters &parameters);
+
+            virtual ~DXTDecoder() noexcept;
+
+        private:
+            virtual core::pFrame do_special_single_step(core::pCompressedVideoFrame frame) override;
+
+            virtual core::pFrame do_convert_frame(core::pFrame input_frame, format_t target_format) override;
+
+            virtual bool set_param(const core::Parameter &param) override;
+
+            format_t output_format_;
+            size_t threads_;
+        };
+
+    } /* namespace hap_decoder */
+} /* namespace yuri */
+#endif /* DXTDECODER_H_ */
@@ -8,11 +8,17 @@
  */
 
 #include "HapDecoder.h"
+#include "DXTDecoder.h"
+#include "dxt_decompress.h"
 #include "yuri/core/Module.h"
+#include "yuri/core/thread/ConverterRegister.h"
+#include "yuri/core/frame/raw_frame_types.h"
 #include "yuri/core/frame/compressed_frame_types.h"
 #include "yuri/core/frame/CompressedVideoFrame.h"
 #include "yuri/core/utils/irange.h"
+#include "yuri/core/utils/parallel_for.h"
 
+#include <atomic>
 #include <numeric>
 
 #ifdef HAP_USE_SNAPPY
@@ -30,17 +36,26 @@ namespace yuri {
 
         MODULE_REGISTRATION_BEGIN("hap_decoder")
             REGISTER_IOTHREAD("hap_decoder", HapDecoder)
+            REGISTER_IOTHREAD("dxt_decoder", DXTDecoder)
+            for (const auto fmt: {core::compressed_frame::dxt1, core::compressed_frame::dxt5,
+                                  core::compressed_frame::ycocg_dxt5}) {
+                REGISTER_CONVERTER(fmt, core::raw_format::rgba32, "dxt_decoder", 20)
+                REGISTER_CONVERTER(fmt, core::raw_format::rgb24, "dxt_decoder", 20)
+                REGISTER_CONVERTER(fmt, core::raw_format::yuv444, "dxt_decoder", 25)
+                REGISTER_CONVERTER(fmt, core::raw_format::yuv420p, "dxt_decoder", 25)
+            }
         MODULE_REGISTRATION_END()
 
         core::Parameters HapDecoder::configure() {
             core::Parameters p = core::IOThread::configure();
             p.set_description("HapDecoder");
+            p["threads"]["Number of threads used to decompress chunks of a frame"] = 1;
             return p;
         }
 
 
         HapDecoder::HapDecoder(const log::Log &log_, core::pwThreadBase parent, const core::Parameters &parameters) :
-                core::IOFilter(log_, parent, std::string("hap_decoder")) {
+                core::IOFilter(log_, parent, std::string("hap_decoder")), threads_(1) {
             IOTHREAD_INIT(parameters)
         }
 
@@ -124,19 +139,6 @@ namespace yuri {
                 return info;
             }
 
-            size_t dxt_size(format_t fmt, resolution_t resolution) {
-                switch (fmt) {
-                    case core::compressed_frame::dxt1:
-                        return resolution.width * resolution.height / 2;
-                    case core::compressed_frame::dxt5:
-                    case core::compressed_frame::ycocg_dxt5:
-                        return resolution.width * resolution.height;
-                    default:
-                        return 0;
-                }
-
-            }
-
 #ifdef HAP_USE_SNAPPY
 
             uint32_t snappy_uncompressed_size(log::Log &log, const uint8_t *data, size_t size) {
@@ -191,7 +193,7 @@ namespace yuri {
                 case core::compressed_frame::dxt1:
                 case core::compressed_frame::dxt5:
                 case core::compressed_frame::ycocg_dxt5: {
-                    const auto expected_size = dxt_size(info.format, cframe->get_resolution());
+                    const auto expected_size = dxt_compressed_size(info.format, cframe->get_resolution());
                     if (info.size != expected_size) {
                         log[log::warning] << "Wrong size! Expected " << expected_size << ", got " << info.size;
                         return {};
@@ -218,7 +220,7 @@ namespace yuri {
             if (uncompressed_size == 0) {
                 return {};
             }
-            const auto expected_size = dxt_size(info.format, cframe->get_resolution());
+            const auto expected_size = dxt_compressed_size(info.format, cframe->get_resolution());
             if (uncompressed_size != expected_size) {
                 log[log::warning] << "Wrong uncompressed size! Expected " << expected_size << ", got "
                                   << uncompressed_size;
@@ -248,6 +250,9 @@ namespace yuri {
         }
 
         bool HapDecoder::set_param(const core::Parameter &param) {
+            if (assign_parameters(param)
+                    (threads_, "threads"))
+                return true;
             return core::IOThread::set_param(param);
         }
 
@@ -306,7 +311,7 @@ namespace yuri {
                 }
             }
 
-            const auto expected_size = dxt_size(info.format, cframe->get_resolution());
+            const auto expected_size = dxt_compressed_size(info.format, cframe->get_resolution());
 
             info.size = std::distance(head.data_start + head.size, info.data_start + info.size);
             info.data_start = head.data_start + head.size;
@@ -318,6 +323,10 @@ namespace yuri {
                 if (chunk.offset == 0) {
                     chunk.offset = offset;
                 }
+                if (chunk.offset + chunk.size > info.size) {
+                    log[log::error] << "Chunk exceeds frame data!";
+                    return {};
+                }
                 chunk.data_start = info.data_start + chunk.offset;
                 offset += chunk.size;
                 if (chunk.snappy) {
@@ -354,24 +363,35 @@ namespace yuri {
                     auto out_frame = core::CompressedVideoFrame::create_empty(info.format, cframe->get_resolution(),
                                                                               uncompressed_size);
                     uint8_t *out_ptr = &out_frame->get_data()[0];
-                    for (auto &chunk: info.chunks) {
-                        if (chunk.snappy) {
+                    std::vector<uint8_t *> chunk_out(info.chunks.size());
+                    for (auto i: irange(info.chunks.size())) {
+                        chunk_out[i] = out_ptr;
+                        out_ptr += info.chunks[i].uncompressed_size;
+                    }
+                    // The chunks are independent, so they can be decompressed concurrently
+                    std::atomic<bool> failed{false};
+                    core::utils::parallel_for(threads_, 0, info.chunks.size(), [&](size_t start, size_t end) {
+                        for (auto i = start; i < end && !failed; ++i) {
+                            const auto &chunk = info.chunks[i];
+                            if (chunk.snappy) {
 #ifdef HAP_USE_SNAPPY
-                            snappy::ByteArraySource src(reinterpret_cast<const char *>(chunk.data_start), chunk.size);
-                            snappy::UncheckedByteArraySink sink(
-                                    reinterpret_cast<char *>(out_ptr));
-                            if (!snappy::Uncompress(&src, &sink)) {
-                                log[log::warning] << "Failed to decompress data!";
-                                return {};
-                            }
+                                snappy::ByteArraySource src(reinterpret_cast<const char *>(chunk.data_start),
+                                                            chunk.size);
+                                snappy::UncheckedByteArraySink sink(reinterpret_cast<char *>(chunk_out[i]));
+                                if (!snappy::Uncompress(&src, &sink)) {
+                                    failed = true;
+                                }
 #else
-                            log[log::error] << "Not supported compression!";
-                            return {};
+                                failed = true;
 #endif
-                        } else {
-                            std::copy_n(chunk.data_start, chunk.uncompressed_size, out_ptr);
+                            } else {
+                                std::copy_n(chunk.data_start, chunk.uncompressed_size, chunk_out[i]);
+                            }
                         }
-                        out_ptr += chunk.uncompressed_size;
+                    });
+                    if (failed) {
+                        log[log::warning] << "Failed to decompress data!";
+                        return {};
                     }
                     return out_frame;
                 }
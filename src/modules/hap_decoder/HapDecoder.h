@@ -66,6 +66,8 @@ namespace yuri {
 
             core::pFrame
             process_chunked_frame(const core::pCompressedVideoFrame &cframe, yuri::hap_decoder::hap_info_t info);
+
+            size_t threads_;
         };
 
     } /* namespace hap_decoder */
@@ -0,0 +1,392 @@
+/*!
+ * @file 		dxt_decompress.cpp
+ * @author 		agent <agent@local>
+ * @date 		18.10.2026
+ * @copyright	Institute of Intermedia, CTU in Prague, 2026
+ * 				Distributed under modified BSD Licence, details in file doc/LICENSE
+ *
+ */
+
+#include "dxt_decompress.h"
+#include "yuri/core/frame/raw_frame_types.h"
+#include "yuri/core/frame/compressed_frame_types.h"
+#include "yuri/core/utils/parallel_for.h"
+#include <algorithm>
+#include <cstring>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#define YURI_HAP_SSE2 1
+#endif
+
+namespace yuri {
+    namespace hap_decoder {
+
+        namespace {
+            //! Decoded 4x4 block, 16 RGBA pixels in row order
+            using block_t = uint8_t[64];
+
+            //! Minimal number of block rows processed by a single thread
+            constexpr size_t min_band = 4;
+
+            size_t block_size(format_t format) {
+                switch (format) {
+                    case core::compressed_frame::dxt1:
+                        return 8;
+                    case core::compressed_frame::dxt5:
+                    case core::compressed_frame::ycocg_dxt5:
+                        return 16;
+                    default:
+                        return 0;
+                }
+            }
+
+            inline uint16_t read16(const uint8_t *src) {
+                return static_cast<uint16_t>(src[0] | src[1] << 8);
+            }
+
+            inline void expand_565(uint16_t color, uint8_t *out) {
+                const int r = (color >> 11) & 0x1F;
+                const int g = (color >> 5) & 0x3F;
+                const int b = color & 0x1F;
+                out[0] = static_cast<uint8_t>(r << 3 | r >> 2);
+                out[1] = static_cast<uint8_t>(g << 2 | g >> 4);
+                out[2] = static_cast<uint8_t>(b << 3 | b >> 2);
+                out[3] = 255;
+            }
+
+            /*!
+             * Decodes colour part of a block (8 bytes). DXT5 blocks always use 4 colours,
+             * DXT1 blocks with c0 <= c1 use 3 colours and transparent black.
+             */
+            inline void decode_color_block(const uint8_t *src, bool dxt1, uint8_t *out) {
+                const uint16_t c0 = read16(src);
+                const uint16_t c1 = read16(src + 2);
+                uint8_t palette[4][4];
+                expand_565(c0, palette[0]);
+                expand_565(c1, palette[1]);
+                if (!dxt1 || c0 > c1) {
+                    for (int i = 0; i < 3; ++i) {
+                        palette[2][i] = static_cast<uint8_t>((2 * palette[0][i] + palette[1][i] + 1) / 3);
+                        palette[3][i] = static_cast<uint8_t>((palette[0][i] + 2 * palette[1][i] + 1) / 3);
+                    }
+                    palette[2][3] = 255;
+                    palette[3][3] = 255;
+                } else {
+                    for (int i = 0; i < 3; ++i) {
+                        palette[2][i] = static_cast<uint8_t>((palette[0][i] + palette[1][i] + 1) / 2);
+                        palette[3][i] = 0;
+                    }
+                    palette[2][3] = 255;
+                    palette[3][3] = 0;
+                }
+                uint32_t indices = static_cast<uint32_t>(src[4]) | static_cast<uint32_t>(src[5]) << 8 |
+                                   static_cast<uint32_t>(src[6]) << 16 | static_cast<uint32_t>(src[7]) << 24;
+                for (int i = 0; i < 16; ++i, indices >>= 2) {
+                    std::memcpy(out + 4 * i, palette[indices & 3], 4);
+                }
+            }
+
+            //! Computes the 8 alpha values of DXT5 block
+            inline void alpha_table(const uint8_t *src, uint8_t *table) {
+                const int a0 = src[0];
+                const int a1 = src[1];
+                table[0] = static_cast<uint8_t>(a0);
+                table[1] = static_cast<uint8_t>(a1);
+                if (a0 > a1) {
+                    for (int i = 1; i < 7; ++i) {
+                        table[i + 1] = static_cast<uint8_t>(((7 - i) * a0 + i * a1 + 3) / 7);
+                    }
+                } else {
+                    for (int i = 1; i < 5; ++i) {
+                        table[i + 1] = static_cast<uint8_t>(((5 - i) * a0 + i * a1 + 2) / 5);
+                    }
+                    table[6] = 0;
+                    table[7] = 255;
+                }
+            }
+
+            //! Decodes alpha part of DXT5 block (8 bytes) into the alpha channel of @em out
+            inline void decode_alpha_block(const uint8_t *src, uint8_t *out) {
+                uint8_t table[8];
+                alpha_table(src, table);
+                uint64_t indices = 0;
+                for (int i = 0; i < 6; ++i) {
+                    indices |= static_cast<uint64_t>(src[2 + i]) << (8 * i);
+                }
+                for (int i = 0; i < 16; ++i, indices >>= 3) {
+                    out[4 * i + 3] = table[indices & 7];
+                }
+            }
+
+#ifdef YURI_HAP_SSE2
+            /*
+             * SSE2 versions of the block decoders. They give the same results as the scalar ones,
+             * the palettes are interpolated for all channels at once and the pixels are selected
+             * from them by comparing the indices.
+             */
+
+            //! Selects one of the four @em entries for every 32 bit index in @em indices
+            inline __m128i select_4(__m128i indices, const __m128i (&entries)[4]) {
+                const __m128i lo = _mm_or_si128(_mm_and_si128(_mm_cmpeq_epi32(indices, _mm_set1_epi32(0)), entries[0]),
+                                                _mm_and_si128(_mm_cmpeq_epi32(indices, _mm_set1_epi32(1)), entries[1]));
+                const __m128i hi = _mm_or_si128(_mm_and_si128(_mm_cmpeq_epi32(indices, _mm_set1_epi32(2)), entries[2]),
+                                                _mm_and_si128(_mm_cmpeq_epi32(indices, _mm_set1_epi32(3)), entries[3]));
+                return _mm_or_si128(lo, hi);
+            }
+
+            inline void decode_color_block_sse2(const uint8_t *src, bool dxt1, uint8_t *out) {
+                const uint16_t c0 = read16(src);
+                const uint16_t c1 = read16(src + 2);
+                uint8_t p0[4], p1[4];
+                expand_565(c0, p0);
+                expand_565(c1, p1);
+                // 16 bit lanes with c0 in the low half and c1 in the high half, and the other way round
+                const __m128i e = _mm_setr_epi16(p0[0], p0[1], p0[2], 255, p1[0], p1[1], p1[2], 255);
+                const __m128i swapped = _mm_shuffle_epi32(e, _MM_SHUFFLE(1, 0, 3, 2));
+                const __m128i one = _mm_set1_epi16(1);
+                __m128i interpolated;
+                if (!dxt1 || c0 > c1) {
+                    // (2 * c0 + c1 + 1) / 3 and (c0 + 2 * c1 + 1) / 3, v / 3 == (v * 21846) >> 16 for v < 768
+                    const __m128i sum = _mm_add_epi16(_mm_add_epi16(_mm_add_epi16(e, e), swapped), one);
+                    interpolated = _mm_mulhi_epu16(sum, _mm_set1_epi16(21846));
+                } else {
+                    // (c0 + c1 + 1) / 2 and transparent black
+                    const __m128i sum = _mm_add_epi16(_mm_add_epi16(e, swapped), one);
+                    interpolated = _mm_and_si128(_mm_srli_epi16(sum, 1), _mm_setr_epi32(-1, -1, 0, 0));
+                }
+                const __m128i palette = _mm_packus_epi16(e, interpolated);
+                const __m128i entries[4] = {_mm_shuffle_epi32(palette, 0x00), _mm_shuffle_epi32(palette, 0x55),
+                                            _mm_shuffle_epi32(palette, 0xAA), _mm_shuffle_epi32(palette, 0xFF)};
+                // Each row has 4 two bit indices, they're moved to the top of 16 bit lanes and shifted down
+                const __m128i shifts = _mm_setr_epi16(1 << 14, 1 << 12, 1 << 10, 1 << 8, 1 << 14, 1 << 12, 1 << 10, 1 << 8);
+                const __m128i zero = _mm_setzero_si128();
+                for (int row = 0; row < 4; row += 2) {
+                    const __m128i bits = _mm_setr_epi16(src[4 + row], src[4 + row], src[4 + row], src[4 + row],
+                                                        src[5 + row], src[5 + row], src[5 + row], src[5 + row]);
+                    const __m128i indices = _mm_srli_epi16(_mm_mullo_epi16(bits, shifts), 14);
+                    _mm_storeu_si128(reinterpret_cast<__m128i *>(out + 16 * row),
+                                     select_4(_mm_unpacklo_epi16(indices, zero), entries));
+                    _mm_storeu_si128(reinterpret_cast<__m128i *>(out + 16 * row + 16),
+                                     select_4(_mm_unpackhi_epi16(indices, zero), entries));
+                }
+            }
+
+            inline void decode_alpha_block_sse2(const uint8_t *src, uint8_t *out) {
+                uint8_t table[8];
+                alpha_table(src, table);
+                uint64_t bits = 0;
+                for (int i = 0; i < 6; ++i) {
+                    bits |= static_cast<uint64_t>(src[2 + i]) << (8 * i);
+                }
+                alignas(16) uint8_t indices[16];
+                for (int i = 0; i < 16; ++i, bits >>= 3) {
+                    indices[i] = static_cast<uint8_t>(bits & 7);
+                }
+                const __m128i index = _mm_load_si128(reinterpret_cast<const __m128i *>(indices));
+                __m128i alpha = _mm_setzero_si128();
+                for (int k = 0; k < 8; ++k) {
+                    const __m128i mask = _mm_cmpeq_epi8(index, _mm_set1_epi8(static_cast<char>(k)));
+                    alpha = _mm_or_si128(alpha, _mm_and_si128(mask, _mm_set1_epi8(static_cast<char>(table[k]))));
+                }
+                // Alpha values are moved to the top byte of every pixel
+                const __m128i zero = _mm_setzero_si128();
+                const __m128i alpha_lo = _mm_unpacklo_epi8(zero, alpha);
+                const __m128i alpha_hi = _mm_unpackhi_epi8(zero, alpha);
+                const __m128i rows[4] = {_mm_unpacklo_epi16(zero, alpha_lo), _mm_unpackhi_epi16(zero, alpha_lo),
+                                         _mm_unpacklo_epi16(zero, alpha_hi), _mm_unpackhi_epi16(zero, alpha_hi)};
+                const __m128i color_mask = _mm_set1_epi32(0x00FFFFFF);
+                for (int row = 0; row < 4; ++row) {
+                    __m128i *dest = reinterpret_cast<__m128i *>(out + 16 * row);
+                    _mm_storeu_si128(dest, _mm_or_si128(_mm_and_si128(_mm_loadu_si128(dest), color_mask), rows[row]));
+                }
+            }
+#endif
+
+            inline uint8_t clip(int value) {
+                return static_cast<uint8_t>(std::min(std::max(value, 0), 255));
+            }
+
+            /*!
+             * Converts scaled YCoCg (as used by Hap Q) to RGB.
+             * Co and Cg are stored in red and green, scale in blue and luma in alpha.
+             */
+            inline void ycocg_to_rgb(uint8_t *block) {
+                for (int i = 0; i < 16; ++i) {
+                    uint8_t *p = block + 4 * i;
+                    const int scale = (p[2] >> 3) + 1;
+                    const int co = (p[0] - 128) / scale;
+                    const int cg = (p[1] - 128) / scale;
+                    const int y = p[3];
+                    p[0] = clip(y + co - cg);
+                    p[1] = clip(y + cg);
+                    p[2] = clip(y - co - cg);
+                    p[3] = 255;
+                }
+            }
+
+            void decode_block(format_t format, const uint8_t *src, uint8_t *block) {
+#ifdef YURI_HAP_SSE2
+                const auto decode_color = decode_color_block_sse2;
+                const auto decode_alpha = decode_alpha_block_sse2;
+#else
+                const auto decode_color = decode_color_block;
+                const auto decode_alpha = decode_alpha_block;
+#endif
+                switch (format) {
+                    case core::compressed_frame::dxt1:
+                        decode_color(src, true, block);
+                        break;
+                    case core::compressed_frame::dxt5:
+                        decode_color(src + 8, false, block);
+                        decode_alpha(src, block);
+                        break;
+                    case core::compressed_frame::ycocg_dxt5:
+                        decode_color(src + 8, false, block);
+                        decode_alpha(src, block);
+                        ycocg_to_rgb(block);
+                        break;
+                }
+            }
+
+            // BT.709, full range, coefficients scaled by 2^13
+            inline uint8_t rgb_to_y(int r, int g, int b) {
+                return static_cast<uint8_t>((1742 * r + 5859 * g + 591 * b + 4096) >> 13);
+            }
+
+            inline uint8_t rgb_to_u(int r, int g, int b) {
+                return static_cast<uint8_t>(((128 << 13) + 4096 - 939 * r - 3157 * g + 4096 * b) >> 13);
+            }
+
+            inline uint8_t rgb_to_v(int r, int g, int b) {
+                return static_cast<uint8_t>(((128 << 13) + 4096 + 4096 * r - 3721 * g - 375 * b) >> 13);
+            }
+
+            /*!
+             * Writes decoded block to packed formats.
+             * @param width     Number of valid columns in the block
+             * @param height    Number of valid rows in the block
+             */
+            template<size_t bpp, class F>
+            void write_packed(const uint8_t *block, uint8_t *dest, size_t linesize,
+                              size_t width, size_t height, F convert) {
+                for (size_t y = 0; y < height; ++y) {
+                    uint8_t *row = dest + y * linesize;
+                    const uint8_t *src = block + 16 * y;
+                    for (size_t x = 0; x < width; ++x) {
+                        convert(src + 4 * x, row + bpp * x);
+                    }
+                }
+            }
+
+            void write_yuv420p(const uint8_t *block, core::RawVideoFrame &frame, size_t bx, size_t by) {
+                auto &py = frame[0];
+                auto &pu = frame[1];
+                auto &pv = frame[2];
+                const auto res = py.get_resolution();
+                const size_t height = std::min<size_t>(4, res.height - by * 4);
+                const size_t width = std::min<size_t>(4, res.width - bx * 4);
+                const size_t y_linesize = py.get_line_size();
+                uint8_t *dest_y = py.data() + by * 4 * y_linesize + bx * 4;
+                for (size_t y = 0; y < height; ++y) {
+                    for (size_t x = 0; x < width; ++x) {
+                        const uint8_t *p = block + 16 * y + 4 * x;
+                        dest_y[y * y_linesize + x] = rgb_to_y(p[0], p[1], p[2]);
+                    }
+                }
+                const auto cres = pu.get_resolution();
+                const size_t cheight = std::min<size_t>(2, cres.height - std::min<size_t>(cres.height, by * 2));
+                const size_t cwidth = std::min<size_t>(2, cres.width - std::min<size_t>(cres.width, bx * 2));
+                const size_t u_linesize = pu.get_line_size();
+                const size_t v_linesize = pv.get_line_size();
+                uint8_t *dest_u = pu.data() + by * 2 * u_linesize + bx * 2;
+                uint8_t *dest_v = pv.data() + by * 2 * v_linesize + bx * 2;
+                for (size_t y = 0; y < cheight; ++y) {
+                    for (size_t x = 0; x < cwidth; ++x) {
+                        const uint8_t *p = block + 32 * y + 8 * x;
+                        // Average of 2x2 pixels
+                        const int r = (p[0] + p[4] + p[16] + p[20] + 2) / 4;
+                        const int g = (p[1] + p[5] + p[17] + p[21] + 2) / 4;
+                        const int b = (p[2] + p[6] + p[18] + p[22] + 2) / 4;
+                        dest_u[y * u_linesize + x] = rgb_to_u(r, g, b);
+                        dest_v[y * v_linesize + x] = rgb_to_v(r, g, b);
+                    }
+                }
+            }
+
+            void write_block(const uint8_t *block, core::RawVideoFrame &frame, size_t bx, size_t by) {
+                const auto format = frame.get_format();
+                if (format == core::raw_format::yuv420p) {
+                    write_yuv420p(block, frame, bx, by);
+                    return;
+                }
+                auto &plane = frame[0];
+                const auto res = plane.get_resolution();
+                const size_t linesize = plane.get_line_size();
+                const size_t height = std::min<size_t>(4, res.height - by * 4);
+                const size_t width = std::min<size_t>(4, res.width - bx * 4);
+                switch (format) {
+                    case core::raw_format::rgba32: {
+                        // Rows of the block are already in the output layout
+                        uint8_t *dest = plane.data() + by * 4 * linesize + bx * 16;
+                        for (size_t y = 0; y < height; ++y) {
+                            std::memcpy(dest + y * linesize, block + 16 * y, 4 * width);
+                        }
+                        break;
+                    }
+                    case core::raw_format::rgb24:
+                        write_packed<3>(block, plane.data() + by * 4 * linesize + bx * 12, linesize, width, height,
+                                        [](const uint8_t *src, uint8_t *dest) { std::memcpy(dest, src, 3); });
+                        break;
+                    case core::raw_format::yuv444:
+                        write_packed<3>(block, plane.data() + by * 4 * linesize + bx * 12, linesize, width, height,
+                                        [](const uint8_t *src, uint8_t *dest) {
+                                            dest[0] = rgb_to_y(src[0], src[1], src[2]);
+                                            dest[1] = rgb_to_u(src[0], src[1], src[2]);
+                                            dest[2] = rgb_to_v(src[0], src[1], src[2]);
+                                        });
+                        break;
+                }
+            }
+        }
+
+        size_t dxt_compressed_size(format_t format, resolution_t resolution) {
+            return ((resolution.width + 3) / 4) * ((resolution.height + 3) / 4) * block_size(format);
+        }
+
+        bool is_dxt_decompress_supported(format_t source, format_t target) {
+            if (!block_size(source)) return false;
+            switch (target) {
+                case core::raw_format::rgba32:
+                case core::raw_format::rgb24:
+                case core::raw_format::yuv444:
+                case core::raw_format::yuv420p:
+                    return true;
+                default:
+                    return false;
+            }
+        }
+
+        bool dxt_decompress(format_t format, const uint8_t *data, size_t size, core::RawVideoFrame &frame,
+                            size_t threads) {
+            if (!is_dxt_decompress_supported(format, frame.get_format())) return false;
+            const auto res = frame.get_resolution();
+            if (size < dxt_compressed_size(format, res)) return false;
+            const size_t bsize = block_size(format);
+            const size_t blocks_x = (res.width + 3) / 4;
+            const size_t blocks_y = (res.height + 3) / 4;
+            core::utils::parallel_for(threads, 0, blocks_y, [&](size_t start, size_t end) {
+                alignas(16) block_t block;
+                for (size_t by = start; by < end; ++by) {
+                    const uint8_t *src = data + by * blocks_x * bsize;
+                    for (size_t bx = 0; bx < blocks_x; ++bx, src += bsize) {
+                        decode_block(format, src, block);
+                        write_block(block, frame, bx, by);
+                    }
+                }
+            }, min_band);
+            return true;
+        }
+
+    } /* namespace hap_decoder */
+} /* namespace yuri */
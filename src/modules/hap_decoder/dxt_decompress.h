@@ -0,0 +1,39 @@
+/*!
+ * @file 		dxt_decompress.h
+ * @author 		agent <agent@local>
+ * @date 		18.10.2026
+ * @copyright	Institute of Intermedia, CTU in Prague, 2026
+ * 				Distributed under modified BSD Licence, details in file doc/LICENSE
+ *
+ */
+
+#ifndef DXT_DECOMPRESS_H_
+#define DXT_DECOMPRESS_H_
+
+#include "yuri/core/frame/RawVideoFrame.h"
+
+namespace yuri {
+    namespace hap_decoder {
+
+        //! Size of DXT1, DXT5 or YCoCg-DXT5 data for given resolution, padded to whole 4x4 blocks
+        size_t dxt_compressed_size(format_t format, resolution_t resolution);
+
+        //! Returns true if @em source can be decompressed directly into @em target
+        bool is_dxt_decompress_supported(format_t source, format_t target);
+
+        /*!
+         * Decompresses DXT1, DXT5 or YCoCg-DXT5 data into @em frame.
+         *
+         * Supported output formats are rgba32, rgb24, yuv444 and yuv420p.
+         * YUV output uses BT.709 in full range, same as yuri_convert by default.
+         * Rows of blocks are split among @em threads threads.
+         *
+         * @return false if the formats are not supported or there's not enough data
+         */
+        bool dxt_decompress(format_t format, const uint8_t *data, size_t size, core::RawVideoFrame &frame,
+                            size_t threads = 1);
+
+    } /* namespace hap_decoder */
+} /* namespace yuri */
+
+#endif /* DXT_DECOMPRESS_H_ */
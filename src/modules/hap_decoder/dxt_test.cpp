@@ -0,0 +1,151 @@
+/*!
+ * @file 		dxt_test.cpp
+ * @author 		agent <agent@local>
+ * @date 		18.10.2026
+ * @copyright	Institute of Intermedia, CTU in Prague, 2026
+ * 				Distributed under modified BSD Licence, details in file doc/LICENSE
+ *
+ */
+
+#include "tests/catch.hpp"
+#include "dxt_decompress.h"
+#include "yuri/core/frame/raw_frame_types.h"
+#include "yuri/core/frame/compressed_frame_types.h"
+#include <vector>
+
+namespace yuri {
+namespace hap_decoder {
+
+namespace {
+
+uint16_t pack_565(int r, int g, int b)
+{
+	return static_cast<uint16_t>(r << 11 | g << 5 | b);
+}
+
+void put_color_block(uint8_t* dest, uint16_t c0, uint16_t c1, uint32_t indices)
+{
+	dest[0] = c0 & 0xFF;
+	dest[1] = c0 >> 8;
+	dest[2] = c1 & 0xFF;
+	dest[3] = c1 >> 8;
+	for (int i = 0; i < 4; ++i) dest[4 + i] = (indices >> (8 * i)) & 0xFF;
+}
+
+void put_alpha_block(uint8_t* dest, uint8_t a0, uint8_t a1, uint64_t indices)
+{
+	dest[0] = a0;
+	dest[1] = a1;
+	for (int i = 0; i < 6; ++i) dest[2 + i] = (indices >> (8 * i)) & 0xFF;
+}
+
+const uint8_t* pixel(const core::pRawVideoFrame& frame, dimension_t x, dimension_t y)
+{
+	const size_t bpp = frame->get_format() == core::raw_format::rgba32 ? 4 : 3;
+	return PLANE_RAW_DATA(frame, 0) + y * PLANE_DATA(frame, 0).get_line_size() + x * bpp;
+}
+
+}
+
+TEST_CASE( "dxt1 decompression", "[module]" ) {
+	using namespace core::raw_format;
+	std::vector<uint8_t> data(8);
+	// Pure red and blue with interpolated colours, indices 0,1,2,3 in every row
+	put_color_block(data.data(), pack_565(31, 0, 0), pack_565(0, 0, 31), 0xE4E4E4E4);
+	REQUIRE( dxt_compressed_size(core::compressed_frame::dxt1, {4, 4}) == data.size() );
+	REQUIRE( is_dxt_decompress_supported(core::compressed_frame::dxt1, rgba32) );
+	REQUIRE( !is_dxt_decompress_supported(core::compressed_frame::dxt1, yuyv422) );
+
+	auto frame = core::RawVideoFrame::create_empty(rgba32, {4, 4});
+	REQUIRE( dxt_decompress(core::compressed_frame::dxt1, data.data(), data.size(), *frame) );
+	for (dimension_t y = 0; y < 4; ++y) {
+		REQUIRE( std::vector<uint8_t>(pixel(frame, 0, y), pixel(frame, 0, y) + 4) == std::vector<uint8_t>({255, 0, 0, 255}) );
+		REQUIRE( std::vector<uint8_t>(pixel(frame, 1, y), pixel(frame, 1, y) + 4) == std::vector<uint8_t>({0, 0, 255, 255}) );
+		REQUIRE( std::vector<uint8_t>(pixel(frame, 2, y), pixel(frame, 2, y) + 4) == std::vector<uint8_t>({170, 0, 85, 255}) );
+		REQUIRE( std::vector<uint8_t>(pixel(frame, 3, y), pixel(frame, 3, y) + 4) == std::vector<uint8_t>({85, 0, 170, 255}) );
+	}
+
+	// c0 <= c1 selects 3 colour mode with transparent black
+	put_color_block(data.data(), pack_565(0, 0, 31), pack_565(31, 0, 0), 0xFFFFFFF8);
+	REQUIRE( dxt_decompress(core::compressed_frame::dxt1, data.data(), data.size(), *frame) );
+	REQUIRE( std::vector<uint8_t>(pixel(frame, 0, 0), pixel(frame, 0, 0) + 4) == std::vector<uint8_t>({0, 0, 255, 255}) );
+	REQUIRE( std::vector<uint8_t>(pixel(frame, 1, 0), pixel(frame, 1, 0) + 4) == std::vector<uint8_t>({128, 0, 128, 255}) );
+	REQUIRE( std::vector<uint8_t>(pixel(frame, 2, 0), pixel(frame, 2, 0) + 4) == std::vector<uint8_t>({0, 0, 0, 0}) );
+
+	// Not enough data
+	REQUIRE( !dxt_decompress(core::compressed_frame::dxt1, data.data(), data.size() - 1, *frame) );
+}
+
+TEST_CASE( "dxt5 decompression", "[module]" ) {
+	using namespace core::raw_format;
+	std::vector<uint8_t> data(16);
+	// Alpha indices 0..7 in the first two rows, then 0
+	uint64_t alpha_indices = 0;
+	for (int i = 0; i < 8; ++i) alpha_indices |= static_cast<uint64_t>(i) << (3 * i);
+	put_alpha_block(data.data(), 210, 0, alpha_indices);
+	// DXT5 always uses 4 colours, even when c0 <= c1
+	put_color_block(data.data() + 8, pack_565(0, 0, 0), pack_565(0, 63, 0), 0xFFFFFFFF);
+
+	auto frame = core::RawVideoFrame::create_empty(rgba32, {4, 4});
+	REQUIRE( dxt_decompress(core::compressed_frame::dxt5, data.data(), data.size(), *frame) );
+	const uint8_t expected_alpha[8] = {210, 0, 180, 150, 120, 90, 60, 30};
+	for (int i = 0; i < 8; ++i) {
+		const auto p = pixel(frame, i % 4, i / 4);
+		REQUIRE( p[1] == 170 );
+		REQUIRE( p[3] == expected_alpha[i] );
+	}
+}
+
+TEST_CASE( "ycocg dxt5 decompression", "[module]" ) {
+	using namespace core::raw_format;
+	std::vector<uint8_t> data(16);
+	// Luma 100, Co = 165 - 128, Cg = 130 - 128, scale 1
+	put_alpha_block(data.data(), 100, 100, 0);
+	put_color_block(data.data() + 8, pack_565(20, 32, 0), pack_565(20, 32, 0), 0);
+
+	auto frame = core::RawVideoFrame::create_empty(rgb24, {3, 3});
+	REQUIRE( dxt_decompress(core::compressed_frame::ycocg_dxt5, data.data(), data.size(), *frame) );
+	for (dimension_t y = 0; y < 3; ++y) {
+		for (dimension_t x = 0; x < 3; ++x) {
+			REQUIRE( std::vector<uint8_t>(pixel(frame, x, y), pixel(frame, x, y) + 3) == std::vector<uint8_t>({135, 102, 61}) );
+		}
+	}
+}
+
+TEST_CASE( "dxt decompression to yuv", "[module]" ) {
+	using namespace core::raw_format;
+	const resolution_t res{70, 38};
+	std::vector<uint8_t> data(dxt_compressed_size(core::compressed_frame::dxt5, res));
+	uint32_t seed = 12345;
+	for (auto& d: data) {
+		seed = seed * 1103515245 + 12345;
+		d = static_cast<uint8_t>(seed >> 16);
+	}
+
+	auto rgb = core::RawVideoFrame::create_empty(rgb24, res);
+	REQUIRE( dxt_decompress(core::compressed_frame::dxt5, data.data(), data.size(), *rgb) );
+	auto rgb_threaded = core::RawVideoFrame::create_empty(rgb24, res);
+	REQUIRE( dxt_decompress(core::compressed_frame::dxt5, data.data(), data.size(), *rgb_threaded, 3) );
+	for (dimension_t y = 0; y < res.height; ++y) {
+		REQUIRE( std::equal(pixel(rgb, 0, y), pixel(rgb, res.width, y), pixel(rgb_threaded, 0, y)) );
+	}
+
+	auto yuv = core::RawVideoFrame::create_empty(yuv444, res);
+	REQUIRE( dxt_decompress(core::compressed_frame::dxt5, data.data(), data.size(), *yuv, 2) );
+	auto yuvp = core::RawVideoFrame::create_empty(yuv420p, res);
+	REQUIRE( dxt_decompress(core::compressed_frame::dxt5, data.data(), data.size(), *yuvp, 2) );
+	for (dimension_t y = 0; y < res.height; ++y) {
+		for (dimension_t x = 0; x < res.width; ++x) {
+			const auto p = pixel(rgb, x, y);
+			const auto q = pixel(yuv, x, y);
+			const double luma = 0.2126 * p[0] + 0.7152 * p[1] + 0.0722 * p[2];
+			REQUIRE( std::abs(q[0] - luma) <= 1.0 );
+			REQUIRE( std::abs(q[1] - (128 + (p[2] - luma) / 1.8556)) <= 1.0 );
+			REQUIRE( std::abs(q[2] - (128 + (p[0] - luma) / 1.5748)) <= 1.0 );
+			REQUIRE( PLANE_RAW_DATA(yuvp, 0)[y * PLANE_DATA(yuvp, 0).get_line_size() + x] == q[0] );
+		}
+	}
+}
+
+}
+}
@@ -0,0 +1,290 @@
+/*!
+ * @file 		JpegDecodeContext.cpp
+ * @author 		agent <agent@local>
+ * @date 		18.10.2026
+ * @copyright	Institute of Intermedia, CTU in Prague, 2026
+ * 				Distributed under modified BSD Licence, details in file doc/LICENSE
+ *
+ */
+
+#include "JpegDecodeContext.h"
+#include "yuri/core/utils/parallel_for.h"
+#include "yuri/core/frame/raw_frame_types.h"
+#include "yuri/core/frame/raw_frame_params.h"
+#include <algorithm>
+#include <stdexcept>
+
+namespace yuri {
+namespace jpeg {
+
+namespace {
+
+void error_exit(jpeg_common_struct* /*cinfo*/)
+{
+	throw std::runtime_error("Error");
+}
+
+#if JPEG_LIB_VERSION >= 70
+inline int scaled_size(const jpeg_component_info& comp) { return comp.DCT_v_scaled_size; }
+inline int scaled_width(const jpeg_component_info& comp) { return comp.DCT_h_scaled_size; }
+inline int min_scaled_size(const jpeg_decompress_struct& cinfo) { return cinfo.min_DCT_v_scaled_size; }
+#else
+inline int scaled_size(const jpeg_component_info& comp) { return comp.DCT_scaled_size; }
+inline int scaled_width(const jpeg_component_info& comp) { return comp.DCT_scaled_size; }
+inline int min_scaled_size(const jpeg_decompress_struct& cinfo) { return cinfo.min_DCT_scaled_size; }
+#endif
+
+}
+
+JpegDecodeContext::JpegDecodeContext()
+{
+	cinfo_.err = jpeg_std_error(&jerr_);
+	jerr_.error_exit = error_exit;
+	jpeg_create_decompress(&cinfo_);
+}
+
+JpegDecodeContext::~JpegDecodeContext() noexcept
+{
+	jpeg_destroy_decompress(&cinfo_);
+}
+
+resolution_t JpegDecodeContext::read_header(const uint8_t* data, size_t size)
+{
+	// Resets the context in case the previous image wasn't decoded
+	jpeg_abort_decompress(&cinfo_);
+	try {
+		jpeg_mem_src(&cinfo_, const_cast<unsigned char*>(data), static_cast<unsigned long>(size));
+		if (jpeg_read_header(&cinfo_, true) != JPEG_HEADER_OK) {
+			jpeg_abort_decompress(&cinfo_);
+			return {0, 0};
+		}
+	}
+	catch (std::runtime_error&) {
+		jpeg_abort_decompress(&cinfo_);
+		throw;
+	}
+	return {cinfo_.image_width, cinfo_.image_height};
+}
+
+resolution_t JpegDecodeContext::scale_to(resolution_t requested)
+{
+	const resolution_t res = {cinfo_.image_width, cinfo_.image_height};
+	unsigned int num = 8;
+	if (requested.width && requested.height) {
+		while (num > 1 &&
+				(res.width * (num - 1) + 7) / 8 >= requested.width &&
+				(res.height * (num - 1) + 7) / 8 >= requested.height) {
+			--num;
+		}
+	}
+	cinfo_.scale_num = num;
+	cinfo_.scale_denom = 8;
+	jpeg_calc_output_dimensions(&cinfo_);
+	return {cinfo_.output_width, cinfo_.output_height};
+}
+
+void JpegDecodeContext::decode(format_t format, bool fast, uint8_t* out, size_t linesize)
+{
+	try {
+		cinfo_.out_color_space = yuri_to_jpeg(format);
+		cinfo_.dct_method = JDCT_FLOAT;
+		cinfo_.do_fancy_upsampling = !fast;
+		cinfo_.do_block_smoothing = !fast;
+		jpeg_start_decompress(&cinfo_);
+
+		const dimension_t height = cinfo_.output_height;
+		rows_.resize(height);
+		for (dimension_t line = 0; line < height; ++line) {
+			rows_[line] = out + line * linesize;
+		}
+		while (cinfo_.output_scanline < height) {
+			const auto processed = jpeg_read_scanlines(&cinfo_, &rows_[cinfo_.output_scanline],
+					static_cast<JDIMENSION>(height - cinfo_.output_scanline));
+			if (!processed) {
+				throw std::runtime_error("No lines processed ... corrupted file?");
+			}
+		}
+		jpeg_finish_decompress(&cinfo_);
+	}
+	catch (std::runtime_error&) {
+		jpeg_abort_decompress(&cinfo_);
+		throw;
+	}
+}
+
+bool JpegDecodeContext::supports_planar(format_t format)
+{
+	using namespace core::raw_format;
+	return format == yuv444p || format == yuv422p || format == yuv420p || format == yuv411p;
+}
+
+void JpegDecodeContext::decode_planar(bool fast, core::RawVideoFrame& frame)
+{
+	const auto& info = core::raw_format::get_format_info(frame.get_format());
+	const size_t sub_x = info.planes[1].sub_x;
+	const size_t sub_y = info.planes[1].sub_y;
+	try {
+		cinfo_.dct_method = JDCT_FLOAT;
+		cinfo_.do_block_smoothing = !fast;
+		if (raw_compatible(sub_x, sub_y)) {
+			decode_raw(frame);
+		} else {
+			decode_resampled(fast, frame, sub_x, sub_y);
+		}
+	}
+	catch (std::runtime_error&) {
+		jpeg_abort_decompress(&cinfo_);
+		throw;
+	}
+}
+
+bool JpegDecodeContext::raw_compatible(size_t sub_x, size_t sub_y) const
+{
+	if (cinfo_.num_components == 1) return cinfo_.jpeg_color_space == JCS_GRAYSCALE;
+	if (cinfo_.num_components != 3 || cinfo_.jpeg_color_space != JCS_YCbCr) return false;
+	const auto* comp = cinfo_.comp_info;
+	const auto max_h = static_cast<size_t>(cinfo_.max_h_samp_factor);
+	const auto max_v = static_cast<size_t>(cinfo_.max_v_samp_factor);
+	if (static_cast<size_t>(comp[0].h_samp_factor) != max_h ||
+			static_cast<size_t>(comp[0].v_samp_factor) != max_v) return false;
+	for (int c = 1; c < 3; ++c) {
+		if (static_cast<size_t>(comp[c].h_samp_factor) * sub_x != max_h ||
+				static_cast<size_t>(comp[c].v_samp_factor) * sub_y != max_v) return false;
+	}
+	return true;
+}
+
+void JpegDecodeContext::decode_raw(core::RawVideoFrame& frame)
+{
+	cinfo_.raw_data_out = TRUE;
+	jpeg_start_decompress(&cinfo_);
+	const int components = cinfo_.num_components;
+	const JDIMENSION lines_per_call = cinfo_.max_v_samp_factor * min_scaled_size(cinfo_);
+	size_t rows[3], widths[3];
+	JSAMPARRAY planes[3];
+	for (int c = 0; c < components; ++c) {
+		const auto& comp = cinfo_.comp_info[c];
+		rows[c] = comp.v_samp_factor * scaled_size(comp);
+		widths[c] = comp.width_in_blocks * scaled_width(comp);
+		raw_buffers_[c].resize(rows[c] * widths[c]);
+		raw_rows_[c].resize(rows[c]);
+		planes[c] = raw_rows_[c].data();
+	}
+	while (cinfo_.output_scanline < cinfo_.output_height) {
+		const size_t imcu_row = cinfo_.output_scanline / lines_per_call;
+		for (int c = 0; c < components; ++c) {
+			auto& plane = frame[c];
+			const size_t linesize = plane.get_line_size();
+			const size_t height = plane.get_resolution().height;
+			// Lines can be decoded directly to the frame only if the padded width fits into them
+			const bool direct = linesize >= widths[c];
+			for (size_t r = 0; r < rows[c]; ++r) {
+				const size_t line = imcu_row * rows[c] + r;
+				raw_rows_[c][r] = (direct && line < height) ?
+						plane.data() + line * linesize :
+						raw_buffers_[c].data() + r * widths[c];
+			}
+		}
+		if (!jpeg_read_raw_data(&cinfo_, planes, lines_per_call)) {
+			throw std::runtime_error("No lines processed ... corrupted file?");
+		}
+		for (int c = 0; c < components; ++c) {
+			auto& plane = frame[c];
+			const size_t linesize = plane.get_line_size();
+			const size_t height = plane.get_resolution().height;
+			if (linesize >= widths[c]) continue;
+			const size_t width = std::min<size_t>(plane.get_resolution().width, widths[c]);
+			for (size_t r = 0; r < rows[c]; ++r) {
+				const size_t line = imcu_row * rows[c] + r;
+				if (line >= height) break;
+				std::copy(raw_rows_[c][r], raw_rows_[c][r] + width, plane.data() + line * linesize);
+			}
+		}
+	}
+	jpeg_finish_decompress(&cinfo_);
+	// Grayscale images have neutral chroma
+	for (int c = components; c < 3; ++c) {
+		std::fill(frame[c].begin(), frame[c].end(), 128);
+	}
+}
+
+void JpegDecodeContext::decode_resampled(bool fast, core::RawVideoFrame& frame, size_t sub_x, size_t sub_y)
+{
+	const resolution_t res = frame.get_resolution();
+	packed_.resize(res.width * res.height * 3);
+	decode(core::raw_format::yuv444, fast, packed_.data(), res.width * 3);
+
+	auto& y_plane = frame[0];
+	for (dimension_t line = 0; line < res.height; ++line) {
+		const uint8_t* in = packed_.data() + line * res.width * 3;
+		uint8_t* out = y_plane.data() + line * y_plane.get_line_size();
+		for (dimension_t x = 0; x < res.width; ++x) {
+			out[x] = in[3 * x];
+		}
+	}
+	const size_t count = sub_x * sub_y;
+	for (int c = 1; c < 3; ++c) {
+		auto& plane = frame[c];
+		const resolution_t plane_res = plane.get_resolution();
+		for (dimension_t line = 0; line < plane_res.height; ++line) {
+			uint8_t* out = plane.data() + line * plane.get_line_size();
+			for (dimension_t x = 0; x < plane_res.width; ++x) {
+				size_t sum = count / 2;
+				for (size_t dy = 0; dy < sub_y; ++dy) {
+					const uint8_t* in = packed_.data() + ((line * sub_y + dy) * res.width + x * sub_x) * 3 + c;
+					for (size_t dx = 0; dx < sub_x; ++dx) {
+						sum += in[3 * dx];
+					}
+				}
+				out[x] = static_cast<uint8_t>(sum / count);
+			}
+		}
+	}
+}
+
+bool JpegDecodeContext::decode_sliced(const uint8_t* data, size_t size, const jpeg_layout_t& layout,
+		format_t format, bool fast, uint8_t* out, size_t linesize,
+		size_t slices, std::vector<std::unique_ptr<JpegDecodeContext>>& helpers)
+{
+	const size_t interval = layout.restart_interval;
+	if (!interval) return false;
+	const size_t mcus_per_row = (layout.resolution.width + layout.mcu.width - 1) / layout.mcu.width;
+	const size_t mcu_rows = (layout.resolution.height + layout.mcu.height - 1) / layout.mcu.height;
+	// Every restart interval has to consist of whole MCU rows
+	if (interval % mcus_per_row) return false;
+	const size_t rows_per_segment = interval / mcus_per_row;
+	const auto segments = find_restart_segments(data, size, layout);
+	if (segments.size() != (mcu_rows + rows_per_segment - 1) / rows_per_segment) return false;
+
+	slices = std::min(slices, segments.size());
+	if (slices < 2) return false;
+	const size_t segments_per_slice = (segments.size() + slices - 1) / slices;
+	slices = (segments.size() + segments_per_slice - 1) / segments_per_slice;
+	while (helpers.size() < slices - 1) {
+		helpers.emplace_back(new JpegDecodeContext());
+	}
+	const dimension_t slice_height = static_cast<dimension_t>(segments_per_slice * rows_per_segment * layout.mcu.height);
+	core::utils::parallel_for(slices, 0, slices, [&](size_t start, size_t end) {
+		for (size_t i = start; i < end; ++i) {
+			JpegDecodeContext& context = i ? *helpers[i - 1] : *this;
+			const size_t first_segment = i * segments_per_slice;
+			const size_t count = std::min(segments_per_slice, segments.size() - first_segment);
+			const dimension_t first_line = static_cast<dimension_t>(i * slice_height);
+			const dimension_t lines = std::min(slice_height, layout.resolution.height - first_line);
+
+			auto& slice = context.slice_;
+			slice.resize(get_header_size(layout) + get_segments_size(&segments[first_segment], count));
+			size_t slice_size = write_header(data, layout, lines, static_cast<uint16_t>(interval), slice.data());
+			slice_size += write_segments(&segments[first_segment], count, slice.data() + slice_size);
+
+			if (context.read_header(slice.data(), slice_size) != resolution_t{layout.resolution.width, lines}) {
+				throw std::runtime_error("Failed to read slice header");
+			}
+			context.decode(format, fast, out + first_line * linesize, linesize);
+		}
+	});
+	return true;
+}
+
+}
+}
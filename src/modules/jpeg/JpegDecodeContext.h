@@ -0,0 +1,113 @@
+/*!
+ * @file 		JpegDecodeContext.h
+ * @author 		agent <agent@local>
+ * @date 		18.10.2026
+ * @copyright	Institute of Intermedia, CTU in Prague, 2026
+ * 				Distributed under modified BSD Licence, details in file doc/LICENSE
+ *
+ */
+
+#ifndef JPEGDECODECONTEXT_H_
+#define JPEGDECODECONTEXT_H_
+
+#include "yuri/core/frame/RawVideoFrame.h"
+#include "jpeg_common.h"
+#include "jpeg_slices.h"
+#include <memory>
+
+namespace yuri {
+namespace jpeg {
+
+/*!
+ * Persistent libjpeg decompressor.
+ *
+ * The decompress structure is created once and reused for all decoded images.
+ * Images can be decoded either to packed formats supported by libjpeg,
+ * or directly to planar YUV formats (see supports_planar()).
+ */
+class JpegDecodeContext {
+public:
+	JpegDecodeContext();
+	~JpegDecodeContext() noexcept;
+	JpegDecodeContext(const JpegDecodeContext&) = delete;
+	JpegDecodeContext& operator=(const JpegDecodeContext&) = delete;
+
+	/*!
+	 * Reads headers of an image.
+	 * @return Resolution of the image or empty resolution if the headers are invalid
+	 * @throw std::runtime_error when libjpeg fails to read the headers
+	 */
+	resolution_t read_header(const uint8_t* data, size_t size);
+
+	/*!
+	 * Sets up scaling in DCT domain for the image, whose headers were read by read_header().
+	 * Selects the smallest scale M/8 that produces image not smaller than @em requested.
+	 * @return Resolution of the decoded image
+	 */
+	resolution_t scale_to(resolution_t requested);
+
+	/*!
+	 * Decodes an image, whose headers were read by read_header().
+	 * @param format	Output format, has to be supported by yuri_to_jpeg()
+	 * @param fast		Use faster decoding with slightly worse quality
+	 * @param out		Output buffer, large enough for the whole image
+	 * @param linesize	Line size of the output buffer
+	 * @throw std::runtime_error when libjpeg fails to decode the image
+	 */
+	void decode(format_t format, bool fast, uint8_t* out, size_t linesize);
+
+	/*!
+	 * Decodes an image, whose headers were read by read_header(), into a planar YUV frame.
+	 *
+	 * When the sampling of the image matches the format of the frame,
+	 * the planes are read directly from libjpeg without any color conversion or resampling.
+	 * Otherwise the image is decoded to YUV 4:4:4 and the chroma planes are subsampled.
+	 * @param frame		Output frame in a format supported by supports_planar(),
+	 * 					with resolution of the decoded image
+	 * @throw std::runtime_error when libjpeg fails to decode the image
+	 */
+	void decode_planar(bool fast, core::RawVideoFrame& frame);
+
+	//! Returns true for planar formats supported by decode_planar()
+	static bool supports_planar(format_t format);
+
+	/*!
+	 * Decodes an image with restart markers in horizontal slices in parallel.
+	 *
+	 * The image is split on restart markers into several standalone images,
+	 * that are decoded by separate contexts. This context decodes the first slice,
+	 * @em helpers are used for the others (and created if there's not enough of them).
+	 * Only images with restart interval aligned to whole MCU rows can be decoded this way.
+	 *
+	 * Note that without @em fast, chroma upsampling at slice boundaries can differ
+	 * slightly from decoding the image at once.
+	 *
+	 * @param layout	Layout of the image, as returned by parse_jpeg_layout()
+	 * @param slices	Maximal number of slices
+	 * @return false if the image can't be decoded in slices (nothing is decoded then)
+	 * @throw std::runtime_error when libjpeg fails to decode the image
+	 */
+	bool decode_sliced(const uint8_t* data, size_t size, const jpeg_layout_t& layout,
+			format_t format, bool fast, uint8_t* out, size_t linesize,
+			size_t slices, std::vector<std::unique_ptr<JpegDecodeContext>>& helpers);
+private:
+	bool raw_compatible(size_t sub_x, size_t sub_y) const;
+	void decode_raw(core::RawVideoFrame& frame);
+	void decode_resampled(bool fast, core::RawVideoFrame& frame, size_t sub_x, size_t sub_y);
+
+	jpeg_decompress_struct cinfo_;
+	jpeg_error_mgr jerr_;
+	std::vector<JSAMPROW> rows_;
+	//! Buffer for the slice image
+	std::vector<uint8_t> slice_;
+	//! Buffers for rows of raw planes, that can't be written directly to the output frame
+	std::vector<uint8_t> raw_buffers_[3];
+	std::vector<JSAMPROW> raw_rows_[3];
+	//! Image decoded to YUV 4:4:4, when it has to be resampled
+	std::vector<uint8_t> packed_;
+};
+
+}
+}
+
+#endif /* JPEGDECODECONTEXT_H_ */
@@ -27,22 +27,16 @@ core::Parameters JpegDecoder::configure()
 	core::Parameters p = core::SpecializedIOFilter<core::CompressedVideoFrame>::configure();
 	p.set_description("JpegDecoder");
 	p["format"]["Output format"]="RGB24";
-	p["fast"]["Faster decoding with slightly worse quality"]=false;
+	p["fast"]["Faster decoding with slightly worse quality. Enables scaling in DCT domain, when resolution is set."]=false;
+	p["resolution"]["Requested output resolution. With fast decoding, images are downscaled by a factor of M/8 to the smallest size not smaller than this. Set to 0x0 to keep original size."]=resolution_t{0,0};
+	p["slices"]["Maximal number of slices decoded in parallel. Only images with restart markers at MCU row boundaries can be decoded in slices"]=1;
 	return p;
 }
 
-namespace {
-
-void error_exit(jpeg_common_struct* /*cinfo*/)
-{
-	throw std::runtime_error("Error");
-}
-}
-
-
 JpegDecoder::JpegDecoder(const log::Log &log_, core::pwThreadBase parent, const core::Parameters &parameters)
 :core::SpecializedIOFilter<core::CompressedVideoFrame>(log_, parent, std::string("jpeg_decoder")),
- fast_(false),output_format_(core::raw_format::rgb24)
+ fast_(false),output_format_(core::raw_format::rgb24),resolution_{0,0},slices_(1),
+ context_(make_unique<JpegDecodeContext>())
 {
 	IOTHREAD_INIT(parameters)
 }
@@ -69,87 +63,41 @@ core::pFrame JpegDecoder::do_special_single_step(core::pCompressedVideoFrame fra
 		return {};
 	}
 
-	std::unique_ptr<jpeg_decompress_struct, std::function<void(jpeg_decompress_struct*)>> cinfox
-			(new jpeg_decompress_struct,[](jpeg_decompress_struct* cinfo){
-		jpeg_destroy_decompress(cinfo);
-		delete cinfo;
-	});
-
-	// Pointer to decompress info owned by cinfox
-	// It' not neccessary, but it makes the code more eclipse friendly and it costs nothing.
-	jpeg_decompress_struct* const cinfo = cinfox.get();
-	try{
-		cinfo->client_data=reinterpret_cast<void*>(this);
-		struct jpeg_error_mgr jerr;
-		cinfo->err = jpeg_std_error(&jerr);
-		cinfo->err->error_exit=error_exit;
-
-		jpeg_create_decompress(cinfo);
-
-		jpeg_mem_src(cinfo, frame->data(), static_cast<unsigned long>(frame->size()));
-
-
-		if (jpeg_read_header(cinfo,true)!=JPEG_HEADER_OK) {
-			log[log::warning] << "Unrecognized file header!!";
-			return {};
+	const bool planar = JpegDecodeContext::supports_planar(output_format_);
+	if (!planar && yuri_to_jpeg(output_format_) == JCS_UNKNOWN) {
+		log[log::error] << "Unsupported color space";
+		return {};
+	}
+	const bool scale = fast_ && resolution_.width && resolution_.height;
+
+	try {
+		if (slices_ > 1 && !planar && !scale) {
+			jpeg_layout_t layout;
+			if (parse_jpeg_layout(frame->data(), frame->size(), layout)) {
+				core::pRawVideoFrame out_frame = core::RawVideoFrame::create_empty(output_format_, layout.resolution);
+				if (context_->decode_sliced(frame->data(), frame->size(), layout, output_format_, fast_,
+						PLANE_RAW_DATA(out_frame, 0), PLANE_DATA(out_frame, 0).get_line_size(), slices_, slice_contexts_)) {
+					out_frame->copy_video_params(*frame);
+					return out_frame;
+				}
+			}
 		}
 
-		cinfo->out_color_space = yuri_to_jpeg(output_format_);
-		if (cinfo->out_color_space == JCS_UNKNOWN) {
-			log[log::error] << "Unsupported color space";
+		resolution_t res = context_->read_header(frame->data(), frame->size());
+		if (!res.width || !res.height) {
+			log[log::warning] << "Unrecognized file header!!";
 			return {};
 		}
-		cinfo->dct_method = JDCT_FLOAT;
-		if (fast_) {
-			cinfo->do_fancy_upsampling= false;
-			cinfo->do_block_smoothing = false;
+		if (scale) {
+			res = context_->scale_to(resolution_);
 		}
-		jpeg_start_decompress(cinfo);
-
-
-		resolution_t res = {cinfo->image_width, cinfo->image_height};
 		core::pRawVideoFrame out_frame = core::RawVideoFrame::create_empty(output_format_, res);
 		out_frame->copy_video_params(*frame);
-		size_t out_linesize = PLANE_DATA(out_frame, 0).get_line_size();
-		size_t planes = 1; // Only 1 plane supported
-
-		std::vector<std::vector<JSAMPROW> > row_pointers(planes);
-		for (size_t p=0;p<planes;++p) {
-			size_t plane_height = res.height * cinfo->comp_info[p].h_samp_factor/cinfo->comp_info[0].h_samp_factor;
-			row_pointers[p].resize(plane_height);
-			auto ls = out_linesize*cinfo->comp_info[p].v_samp_factor/cinfo->comp_info[0].v_samp_factor;
-			for (size_t h = 0; h < plane_height; ++h) {
-				row_pointers[p][h]=PLANE_RAW_DATA(out_frame,p) + h*ls;
-			}
+		if (planar) {
+			context_->decode_planar(fast_, *out_frame);
+		} else {
+			context_->decode(output_format_, fast_, PLANE_RAW_DATA(out_frame, 0), PLANE_DATA(out_frame, 0).get_line_size());
 		}
-		std::vector<JSAMPARRAY> arrays_pointers(planes);
-		for (size_t p=0;p<planes;++p) {
-			arrays_pointers[p]=&(row_pointers[p][0]);
-		}
-		yuri::size_t processed=0;
-
-		while (cinfo->output_scanline < cinfo->image_height) {
-			/*if (!raw_)*/ processed = jpeg_read_scanlines(cinfo, &row_pointers[0][cinfo->output_scanline], static_cast<JDIMENSION>(res.height - cinfo->output_scanline));
-	//		else {
-	//			log[log::info] << "processing raw line " << cinfo.output_scanline;
-	//			//JSAMPARRAY arr_pointer = &row_pointers[0];
-	//			for (int p=0;p<planes;++p) {
-	//				size_t off = cinfo.output_scanline*cinfo.comp_info[p].v_samp_factor/cinfo.comp_info[0].v_samp_factor;
-	//				arrays_pointers[p]=&row_pointers[p][off];
-	//				log[log::info] << p<< " Setting ptr at offset " << std::distance(row_pointers[p][0],row_pointers[p][off]);
-	//			}
-	//			JSAMPIMAGE img = &arrays_pointers[0];
-	//			processed = jpeg_read_raw_data(&cinfo, img, height-cinfo.output_scanline);
-	//			log[log::info] << "processed " << processed;
-	//		}
-
-			if (!processed) {
-				log[log::error] << "No lines processed ... corrupted file?";
-				return {};
-			}
-		}
-
-		jpeg_finish_decompress(cinfo);
 		return out_frame;
 	}
 	catch (std::runtime_error& ) {
@@ -162,7 +110,9 @@ bool JpegDecoder::set_param(const core::Parameter& param)
 {
 	if (assign_parameters(param)
 			(output_format_, "format", [](const core::Parameter&p){ return core::raw_format::parse_format(p.get<std::string>()); })
-			(fast_, "fast"))
+			(fast_, "fast")
+			(resolution_, "resolution")
+			(slices_, "slices"))
 		return true;
 	return core::SpecializedIOFilter<core::CompressedVideoFrame>::set_param(param);
 }
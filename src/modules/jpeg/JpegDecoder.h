@@ -13,6 +13,7 @@
 #include "yuri/core/thread/SpecializedIOFilter.h"
 #include "yuri/core/frame/CompressedVideoFrame.h"
 #include "yuri/core/thread/ConverterThread.h"
+#include "JpegDecodeContext.h"
 
 
 namespace yuri {
@@ -33,6 +34,12 @@ private:
 
 	bool fast_;
 	format_t output_format_;
+	//! Requested output resolution, used for scaling in DCT domain with fast decoding
+	resolution_t resolution_;
+	size_t slices_;
+	std::unique_ptr<JpegDecodeContext> context_;
+	//! Contexts used to decode slices other than the first one
+	std::vector<std::unique_ptr<JpegDecodeContext>> slice_contexts_;
 };
 
 } /* namespace jpeg */
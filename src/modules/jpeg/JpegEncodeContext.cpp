@@ -0,0 +1,240 @@
+/*!
+ * @file 		JpegEncodeContext.cpp
+ * @author 		agent <agent@local>
+ * @date 		18.10.2026
+ * @copyright	Institute of Intermedia, CTU in Prague, 2026
+ * 				Distributed under modified BSD Licence, details in file doc/LICENSE
+ *
+ */
+
+#include "JpegEncodeContext.h"
+#include "yuri/core/thread/FixedMemoryAllocator.h"
+#include "yuri/core/frame/raw_frame_types.h"
+#include "yuri/core/utils.h"
+#include "yuri/core/utils/parallel_for.h"
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+namespace yuri {
+namespace jpeg {
+
+namespace {
+
+//! Smallest block requested from the allocator
+constexpr size_t min_block_size = 64 * 1024;
+
+void error_exit(jpeg_common_struct* /*cinfo*/)
+{
+	throw std::runtime_error("Error");
+}
+
+/*!
+ * Blocks are allocated in power of 2 sizes only,
+ * so the pool doesn't get fragmented into many different sizes.
+ */
+size_t get_block_size(size_t size)
+{
+	return next_power_2(std::max(size, min_block_size));
+}
+
+void return_block(uint8_t* data, size_t size)
+{
+	core::FixedMemoryAllocator::Deleter(size, data)(data);
+}
+
+}
+
+JpegEncodeContext::JpegEncodeContext():
+dest_{{}, nullptr, 0},size_hint_(min_block_size)
+{
+	cinfo_.err = jpeg_std_error(&jerr_);
+	jerr_.error_exit = error_exit;
+	jpeg_create_compress(&cinfo_);
+	dest_.mgr.init_destination = &JpegEncodeContext::init_destination;
+	dest_.mgr.empty_output_buffer = &JpegEncodeContext::empty_output_buffer;
+	dest_.mgr.term_destination = &JpegEncodeContext::term_destination;
+	cinfo_.dest = &dest_.mgr;
+}
+
+JpegEncodeContext::~JpegEncodeContext() noexcept
+{
+	jpeg_destroy_compress(&cinfo_);
+	release_buffer();
+}
+
+void JpegEncodeContext::release_buffer()
+{
+	if (dest_.data) {
+		return_block(dest_.data, dest_.capacity);
+		dest_.data = nullptr;
+		dest_.capacity = 0;
+	}
+}
+
+void JpegEncodeContext::init_destination(j_compress_ptr cinfo)
+{
+	auto& dest = *reinterpret_cast<destination_t*>(cinfo->dest);
+	dest.mgr.next_output_byte = dest.data;
+	dest.mgr.free_in_buffer = dest.capacity;
+}
+
+boolean JpegEncodeContext::empty_output_buffer(j_compress_ptr cinfo)
+{
+	// The buffer is full, so let's get twice as big one and copy the data there.
+	auto& dest = *reinterpret_cast<destination_t*>(cinfo->dest);
+	const size_t new_capacity = get_block_size(dest.capacity * 2);
+	auto block = core::FixedMemoryAllocator::get_block(new_capacity);
+	std::memcpy(block.first, dest.data, dest.capacity);
+	return_block(dest.data, dest.capacity);
+	dest.mgr.next_output_byte = block.first + dest.capacity;
+	dest.mgr.free_in_buffer = new_capacity - dest.capacity;
+	dest.data = block.first;
+	dest.capacity = new_capacity;
+	return TRUE;
+}
+
+void JpegEncodeContext::term_destination(j_compress_ptr /*cinfo*/)
+{
+}
+
+void JpegEncodeContext::set_parameters(format_t fmt, resolution_t res, int quality)
+{
+	const auto& fi = core::raw_format::get_format_info(fmt);
+	cinfo_.image_width = static_cast<JDIMENSION>(res.width);
+	cinfo_.image_height = static_cast<JDIMENSION>(res.height);
+	// This is probably not correct for all formats, but it should work for all formats supported here.
+	cinfo_.input_components = static_cast<int>(fi.planes[0].components.size());
+	cinfo_.in_color_space = yuri_to_jpeg(fmt);
+
+	jpeg_set_defaults(&cinfo_);
+	jpeg_set_quality(&cinfo_, quality, true);
+}
+
+size_t JpegEncodeContext::compress(const core::RawVideoFrame& frame, dimension_t first_line, dimension_t lines, int quality)
+{
+	if (!dest_.data) {
+		dest_.capacity = get_block_size(size_hint_);
+		dest_.data = core::FixedMemoryAllocator::get_block(dest_.capacity).first;
+	}
+	try {
+		set_parameters(frame.get_format(), {frame.get_width(), lines}, quality);
+		jpeg_start_compress(&cinfo_, true);
+
+		const uint8_t* data = frame[0].data() + first_line * frame[0].get_line_size();
+		const size_t line_size = frame[0].get_line_size();
+		std::vector<JSAMPROW> rows(lines);
+		for (dimension_t line = 0; line < lines; ++line) {
+			rows[line] = const_cast<JSAMPROW>(data + line * line_size);
+		}
+		while (cinfo_.next_scanline < cinfo_.image_height) {
+			jpeg_write_scanlines(&cinfo_, &rows[cinfo_.next_scanline], cinfo_.image_height - cinfo_.next_scanline);
+		}
+		jpeg_finish_compress(&cinfo_);
+	}
+	catch (std::runtime_error&) {
+		jpeg_abort_compress(&cinfo_);
+		release_buffer();
+		throw;
+	}
+	const size_t size = dest_.capacity - dest_.mgr.free_in_buffer;
+	// Next frame will most probably have similar size, let's leave some space for it to grow
+	size_hint_ = size + size / 4;
+	return size;
+}
+
+core::pCompressedVideoFrame JpegEncodeContext::create_frame(const core::RawVideoFrame& frame, format_t out_format, size_t size)
+{
+	auto outframe = core::CompressedVideoFrame::create_empty(out_format, frame.get_resolution());
+	outframe->get_data().set(dest_.data, size, core::FixedMemoryAllocator::Deleter(dest_.capacity, dest_.data));
+	dest_.data = nullptr;
+	dest_.capacity = 0;
+	outframe->copy_video_params(frame);
+	outframe->copy_damage_info(frame);
+	return outframe;
+}
+
+core::pCompressedVideoFrame JpegEncodeContext::encode(const core::RawVideoFrame& frame, format_t out_format, int quality)
+{
+	const size_t size = compress(frame, 0, frame.get_height(), quality);
+	return create_frame(frame, out_format, size);
+}
+
+segment_t JpegEncodeContext::encode_lines(const core::RawVideoFrame& frame, dimension_t first_line, dimension_t lines, int quality)
+{
+	// The buffer from the last call is reused
+	const size_t size = compress(frame, first_line, lines, quality);
+	return {dest_.data, size};
+}
+
+resolution_t JpegEncodeContext::get_mcu_size(format_t fmt)
+{
+	set_parameters(fmt, {16, 16}, 90);
+	if (cinfo_.num_components == 1) return {DCTSIZE, DCTSIZE};
+	int max_h = 1, max_v = 1;
+	for (int i = 0; i < cinfo_.num_components; ++i) {
+		max_h = std::max(max_h, cinfo_.comp_info[i].h_samp_factor);
+		max_v = std::max(max_v, cinfo_.comp_info[i].v_samp_factor);
+	}
+	return {static_cast<dimension_t>(max_h * DCTSIZE), static_cast<dimension_t>(max_v * DCTSIZE)};
+}
+
+core::pCompressedVideoFrame JpegEncodeContext::encode_sliced(const core::RawVideoFrame& frame, format_t out_format, int quality,
+		size_t slices, std::vector<std::unique_ptr<JpegEncodeContext>>& helpers)
+{
+	const resolution_t res = frame.get_resolution();
+	const resolution_t mcu = get_mcu_size(frame.get_format());
+	const size_t mcu_rows = (res.height + mcu.height - 1) / mcu.height;
+	const size_t mcus_per_row = (res.width + mcu.width - 1) / mcu.width;
+	slices = std::max<size_t>(std::min(slices, mcu_rows), 1);
+	size_t rows_per_slice = (mcu_rows + slices - 1) / slices;
+	// Restart interval is limited to 16 bits
+	rows_per_slice = std::max<size_t>(std::min(rows_per_slice, 0xFFFF / mcus_per_row), 1);
+	slices = (mcu_rows + rows_per_slice - 1) / rows_per_slice;
+	if (slices < 2 || rows_per_slice * mcus_per_row > 0xFFFF) {
+		return encode(frame, out_format, quality);
+	}
+
+	while (helpers.size() < slices - 1) {
+		helpers.emplace_back(new JpegEncodeContext());
+	}
+	std::vector<segment_t> parts(slices);
+	const dimension_t slice_height = static_cast<dimension_t>(rows_per_slice * mcu.height);
+	core::utils::parallel_for(slices, 0, slices, [&](size_t start, size_t end) {
+		for (size_t i = start; i < end; ++i) {
+			JpegEncodeContext& context = i ? *helpers[i - 1] : *this;
+			const dimension_t first_line = static_cast<dimension_t>(i * slice_height);
+			parts[i] = context.encode_lines(frame, first_line, std::min(slice_height, res.height - first_line), quality);
+		}
+	});
+
+	// All slices use the same tables, so the headers from the first one can be used for the whole image.
+	jpeg_layout_t layout;
+	if (!parse_jpeg_layout(parts[0].data, parts[0].size, layout)) {
+		throw std::runtime_error("Failed to parse encoded slice");
+	}
+	std::vector<segment_t> segments(slices);
+	for (size_t i = 0; i < slices; ++i) {
+		jpeg_layout_t slice_layout;
+		if (!parse_jpeg_layout(parts[i].data, parts[i].size, slice_layout)) {
+			throw std::runtime_error("Failed to parse encoded slice");
+		}
+		segments[i] = find_restart_segments(parts[i].data, parts[i].size, slice_layout).front();
+	}
+
+	const size_t size = get_header_size(layout) + get_segments_size(segments.data(), slices);
+	const size_t capacity = get_block_size(size);
+	auto block = core::FixedMemoryAllocator::get_block(capacity);
+	size_t written = write_header(parts[0].data, layout, res.height,
+			static_cast<uint16_t>(rows_per_slice * mcus_per_row), block.first);
+	written += write_segments(segments.data(), slices, block.first + written);
+
+	auto outframe = core::CompressedVideoFrame::create_empty(out_format, res);
+	outframe->get_data().set(block.first, written, block.second);
+	outframe->copy_video_params(frame);
+	outframe->copy_damage_info(frame);
+	return outframe;
+}
+
+}
+}
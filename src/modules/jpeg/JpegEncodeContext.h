@@ -0,0 +1,90 @@
+/*!
+ * @file 		JpegEncodeContext.h
+ * @author 		agent <agent@local>
+ * @date 		18.10.2026
+ * @copyright	Institute of Intermedia, CTU in Prague, 2026
+ * 				Distributed under modified BSD Licence, details in file doc/LICENSE
+ *
+ */
+
+#ifndef JPEGENCODECONTEXT_H_
+#define JPEGENCODECONTEXT_H_
+
+#include "yuri/core/frame/RawVideoFrame.h"
+#include "yuri/core/frame/CompressedVideoFrame.h"
+#include "jpeg_common.h"
+#include "jpeg_slices.h"
+#include <memory>
+
+namespace yuri {
+namespace jpeg {
+
+/*!
+ * Persistent libjpeg compressor.
+ *
+ * The compress structure is created once and reused for all encoded frames.
+ * Encoded data are written directly to blocks from FixedMemoryAllocator,
+ * that are then passed to the output frame without any copy.
+ */
+class JpegEncodeContext {
+public:
+	JpegEncodeContext();
+	~JpegEncodeContext() noexcept;
+	JpegEncodeContext(const JpegEncodeContext&) = delete;
+	JpegEncodeContext& operator=(const JpegEncodeContext&) = delete;
+
+	/*!
+	 * Encodes a frame.
+	 * The frame has to be in a format supported by yuri_to_jpeg().
+	 * @throw std::runtime_error when libjpeg fails to encode the frame
+	 */
+	core::pCompressedVideoFrame encode(const core::RawVideoFrame& frame, format_t out_format, int quality);
+
+	/*!
+	 * Encodes a frame in horizontal slices, each slice encoded by a separate context in parallel.
+	 *
+	 * The slices are encoded as independent images, that are then joined into a single image
+	 * with restart interval equal to the size of a slice.
+	 * This context encodes the first slice, @em helpers are used for the others
+	 * (and created if there's not enough of them).
+	 *
+	 * @param slices	Requested number of slices
+	 * @throw std::runtime_error when libjpeg fails to encode the frame
+	 */
+	core::pCompressedVideoFrame encode_sliced(const core::RawVideoFrame& frame, format_t out_format, int quality,
+			size_t slices, std::vector<std::unique_ptr<JpegEncodeContext>>& helpers);
+
+	/*!
+	 * Encodes a range of lines of a frame as a standalone image.
+	 * Returned data are valid until next call to any of the encode methods.
+	 */
+	segment_t encode_lines(const core::RawVideoFrame& frame, dimension_t first_line, dimension_t lines, int quality);
+
+	//! Returns size of a MCU for images encoded from format @em fmt
+	resolution_t get_mcu_size(format_t fmt);
+private:
+	//! Destination manager, has to be the first member so it can be cast from cinfo->dest
+	struct destination_t {
+		jpeg_destination_mgr mgr;
+		uint8_t* data;
+		size_t capacity;
+	};
+	static void init_destination(j_compress_ptr cinfo);
+	static boolean empty_output_buffer(j_compress_ptr cinfo);
+	static void term_destination(j_compress_ptr cinfo);
+	void release_buffer();
+	void set_parameters(format_t fmt, resolution_t res, int quality);
+	size_t compress(const core::RawVideoFrame& frame, dimension_t first_line, dimension_t lines, int quality);
+	core::pCompressedVideoFrame create_frame(const core::RawVideoFrame& frame, format_t out_format, size_t size);
+
+	jpeg_compress_struct cinfo_;
+	jpeg_error_mgr jerr_;
+	destination_t dest_;
+	//! Expected size of the encoded image, based on the previous frames
+	size_t size_hint_;
+};
+
+}
+}
+
+#endif /* JPEGENCODECONTEXT_H_ */
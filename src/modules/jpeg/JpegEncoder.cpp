@@ -25,111 +25,150 @@ core::Parameters JpegEncoder::configure()
 	p.set_description("JpegEncoder");
 	p["quality"]["Jpeg quality"]=90;
 	p["force_mjpeg"]["Force MJPEG format"]=false;
+	p["threads"]["Number of frames encoded concurrently. Values above 1 add latency of up to (threads - 1) frames"]=1;
+	p["slices"]["Number of horizontal slices encoded in parallel. The slices are separated by restart markers. Ignored when threads > 1"]=1;
 	return p;
 }
-namespace {
-
-void error_exit(jpeg_common_struct* /*cinfo*/)
-{
-	throw std::runtime_error("Error");
-}
-
-}
 
 JpegEncoder::JpegEncoder(const log::Log &log_, core::pwThreadBase parent, const core::Parameters &parameters):
 core::SpecializedIOFilter<core::RawVideoFrame>(log_,parent,std::string("jpeg_encoder")),
 BasicEventConsumer(log),
-quality_(90),force_mjpeg_(false)
+quality_(90),force_mjpeg_(false),threads_(1),slices_(1),last_valid_(false),last_format_(0),
+last_out_format_(0),last_resolution_{0, 0},last_quality_(0),
+context_(make_unique<JpegEncodeContext>())
 {
 	IOTHREAD_INIT(parameters)
     log[log::info] << "sf: " << get_jpeg_supported_formats().size();
 	set_supported_formats(get_jpeg_supported_formats());
+	if (threads_ > 1) {
+		pool_ = make_unique<pool_type>(threads_, []() { return make_unique<JpegEncodeContext>(); });
+	}
 }
 
 JpegEncoder::~JpegEncoder() noexcept
 {
 }
 
-core::pFrame JpegEncoder::do_special_single_step(core::pRawVideoFrame frame)
+bool JpegEncoder::step()
 {
-	process_events();
-	std::unique_ptr<jpeg_compress_struct, std::function<void(jpeg_compress_struct*)>> cinfox(
-			new jpeg_compress_struct, [](jpeg_compress_struct* ptr)
-			{
-				jpeg_destroy_compress(ptr);
-				delete ptr;
-			});
-	jpeg_compress_struct* cinfo = cinfox.get();
-	cinfo->client_data=reinterpret_cast<void*>(this);
-	struct jpeg_error_mgr jerr;
-	cinfo->err = jpeg_std_error(&jerr);
-	cinfo->err->error_exit=error_exit;
-	try {
-		jpeg_create_compress(cinfo);
+	const bool ret = core::SpecializedIOFilter<core::RawVideoFrame>::step();
+	if (pool_) push_finished(pending_.size());
+	return ret;
+}
 
-		format_t fmt = frame->get_format();
-		J_COLOR_SPACE cs = yuri_to_jpeg(fmt);
-		if (cs == JCS_UNKNOWN) {
-			log[log::warning] << "Unsupported format";
-			return {};
-		}
+void JpegEncoder::finish_output()
+{
+	// Frames still being encoded are pushed before the output is closed
+	if (pool_) push_finished(0);
+}
 
-		uint8_t *buffer = nullptr;
-		unsigned long buffer_size = 0;
-		// Jpeg_mem_dest allocated buffer and it WILL BE LEAKED when an exception occurs...
-		jpeg_mem_dest(cinfo, &buffer, &buffer_size);
-		const auto& fi = core::raw_format::get_format_info(fmt);
-//		size_t bpp = core::raw_format::get_fmt_bpp(fmt)/8;
-		resolution_t res = frame->get_resolution();
-		cinfo->image_width = static_cast<JDIMENSION>(res.width);
-		cinfo->image_height = static_cast<JDIMENSION>(res.height);
-
-		// This is probably not correct for all formats, but it should work for all formats supported here.
-		cinfo->input_components = static_cast<int>(fi.planes[0].components.size());
-		cinfo->in_color_space = cs;
-
-		jpeg_set_defaults(cinfo);
-		jpeg_set_quality(cinfo, static_cast<int>(quality_), true);
-		jpeg_start_compress(cinfo, true);
-
-		uint8_t* data = PLANE_RAW_DATA(frame,0);
-		size_t line_size = PLANE_DATA(frame,0).get_line_size();
-		JSAMPROW row_pointer;
-
-		while (cinfo->next_scanline < cinfo->image_height) {
-			row_pointer = reinterpret_cast<JSAMPROW>(data+cinfo->next_scanline*line_size);
-			jpeg_write_scanlines(cinfo, &row_pointer, 1);
-		}
-		jpeg_finish_compress(cinfo);
-
-		log[log::verbose_debug] << "Buffer is now " << buffer_size << " bytes long";
-		auto out_fmt = force_mjpeg_?core::compressed_frame::mjpg:core::compressed_frame::jpeg;
-		if (buffer_size) {
-			auto outframe = core::CompressedVideoFrame::create_empty(out_fmt, res, buffer, buffer_size);
-			outframe->copy_video_params(*frame);
-			::free(buffer);
-			return outframe;
+core::pFrame JpegEncoder::encode(JpegEncodeContext& context, const core::pRawVideoFrame& frame, format_t out_format)
+{
+	try {
+		if (slices_ > 1) {
+			return context.encode_sliced(*frame, out_format, static_cast<int>(quality_), slices_, slice_contexts_);
 		}
-		::free(buffer);
-
+		return context.encode(*frame, out_format, static_cast<int>(quality_));
 	}
 	catch (std::runtime_error& ) {
 		log[log::error] << "Failed to encode frame";
 	}
 	return {};
 }
+
+core::pFrame JpegEncoder::get_unchanged_output()
+{
+	if (!last_output_) return {};
+	auto cached = std::dynamic_pointer_cast<core::VideoFrame>(last_output_);
+	if (cached->is_damaged()) {
+		cached = std::dynamic_pointer_cast<core::VideoFrame>(cached->get_copy());
+		cached->set_damage({});
+		last_output_ = cached;
+	}
+	return last_output_;
+}
+
+core::pFrame JpegEncoder::finish_output(core::pFrame outframe, const pending_frame_t& flags)
+{
+	if (flags.repeat) return get_unchanged_output();
+	if (outframe && flags.cacheable) {
+		last_output_ = outframe;
+	} else {
+		last_output_.reset();
+	}
+	return outframe;
+}
+
+void JpegEncoder::push_finished(size_t max_pending)
+{
+	pool_->pop_finished(max_pending, [this](core::pFrame outframe) {
+		const auto flags = pending_.front();
+		pending_.pop_front();
+		outframe = finish_output(std::move(outframe), flags);
+		if (outframe) push_frame(0, std::move(outframe));
+	}, [this](const std::exception&) {
+		log[log::error] << "Failed to encode frame";
+	});
+}
+
+core::pFrame JpegEncoder::do_special_single_step(core::pRawVideoFrame frame)
+{
+	process_events();
+	const format_t out_fmt = force_mjpeg_?core::compressed_frame::mjpg:core::compressed_frame::jpeg;
+	const format_t fmt = frame->get_format();
+	const resolution_t res = frame->get_resolution();
+	if (yuri_to_jpeg(fmt) == JCS_UNKNOWN) {
+		log[log::warning] << "Unsupported format";
+		return {};
+	}
+	// Input that didn't change since the last frame doesn't have to be encoded again.
+	const pending_frame_t flags = {
+			last_valid_ && frame->has_damage_info() && !frame->is_damaged() &&
+			last_out_format_ == out_fmt && last_format_ == fmt &&
+			last_resolution_ == res && last_quality_ == quality_,
+			frame->has_damage_info()};
+	last_valid_ = flags.cacheable;
+	last_format_ = fmt;
+	last_out_format_ = out_fmt;
+	last_resolution_ = res;
+	last_quality_ = quality_;
+
+	if (!pool_) {
+		if (flags.repeat && last_output_) return get_unchanged_output();
+		return finish_output(encode(*context_, frame, out_fmt), {false, flags.cacheable});
+	}
+
+	if (flags.repeat) {
+		pool_->submit([](JpegEncodeContext&) { return core::pFrame{}; });
+	} else {
+		const int quality = static_cast<int>(quality_);
+		pool_->submit([frame, out_fmt, quality](JpegEncodeContext& context) -> core::pFrame {
+			return context.encode(*frame, out_fmt, quality);
+		});
+	}
+	pending_.push_back(flags);
+	// Keep at most one frame per worker in flight, so the reordering latency stays bounded.
+	push_finished(threads_);
+	return {};
+}
+
 core::pFrame JpegEncoder::do_convert_frame(core::pFrame input_frame, format_t target_format)
 {
 	if (target_format != core::compressed_frame::jpeg) return {};
 	core::pRawVideoFrame frame = std::dynamic_pointer_cast<core::RawVideoFrame>(input_frame);
-	if (!frame) return {};
-	return do_special_single_step(frame);
+	if (!frame || yuri_to_jpeg(frame->get_format()) == JCS_UNKNOWN) return {};
+	// Converter can be used for unrelated frames, so the cached output can't be used
+	last_output_.reset();
+	last_valid_ = false;
+	return encode(*context_, frame, force_mjpeg_?core::compressed_frame::mjpg:core::compressed_frame::jpeg);
 }
 bool JpegEncoder::set_param(const core::Parameter& param)
 {
 	if (assign_parameters(param)
 			(quality_, "quality")
-			(force_mjpeg_, "force_mjpeg"))
+			(force_mjpeg_, "force_mjpeg")
+			(threads_, "threads")
+			(slices_, "slices"))
 		return true;
 	return core::SpecializedIOFilter<core::RawVideoFrame>::set_param(param);
 }
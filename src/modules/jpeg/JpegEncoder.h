@@ -16,6 +16,9 @@
 #include "yuri/core/thread/Convert.h"
 #include "yuri/core/frame/raw_frame_types.h"
 #include "yuri/event/BasicEventConsumer.h"
+#include "yuri/core/utils/ordered_pool.h"
+#include "JpegEncodeContext.h"
+#include <deque>
 namespace yuri {
 namespace jpeg {
 
@@ -29,13 +32,45 @@ public:
 	JpegEncoder(const log::Log &log_, core::pwThreadBase parent, const core::Parameters &parameters);
 	virtual ~JpegEncoder() noexcept;
 private:
-	
+	using pool_type = core::utils::ordered_pool<core::pFrame, JpegEncodeContext>;
+	//! Flags of a frame submitted to the worker pool
+	struct pending_frame_t {
+		//! Frame was unchanged, so the previous output should be repeated
+		bool repeat;
+		//! Output can be reused for following unchanged frames
+		bool cacheable;
+	};
+
+	virtual bool step() override;
+	virtual void finish_output() override;
 	virtual core::pFrame do_special_single_step(core::pRawVideoFrame frame) override;
 	virtual core::pFrame do_convert_frame(core::pFrame input_frame, format_t target_format) override;
 	virtual bool set_param(const core::Parameter& param) override;
 	virtual bool do_process_event(const std::string& event_name, const event::pBasicEvent& event) override;
+	core::pFrame encode(JpegEncodeContext& context, const core::pRawVideoFrame& frame, format_t out_format);
+	core::pFrame get_unchanged_output();
+	core::pFrame finish_output(core::pFrame outframe, const pending_frame_t& flags);
+	//! Pushes frames finished by the worker pool in input order
+	void push_finished(size_t max_pending);
+
 	size_t quality_;
 	bool force_mjpeg_;
+	size_t threads_;
+	size_t slices_;
+	//! Last encoded frame, reused for input frames marked as unchanged
+	core::pFrame last_output_;
+	//! Parameters of the last input frame
+	bool last_valid_;
+	format_t last_format_;
+	format_t last_out_format_;
+	resolution_t last_resolution_;
+	size_t last_quality_;
+	//! Context used to encode frames in the main thread
+	std::unique_ptr<JpegEncodeContext> context_;
+	//! Contexts used to encode slices other than the first one
+	std::vector<std::unique_ptr<JpegEncodeContext>> slice_contexts_;
+	std::unique_ptr<pool_type> pool_;
+	std::deque<pending_frame_t> pending_;
 };
 
 } /* namespace jpeg */
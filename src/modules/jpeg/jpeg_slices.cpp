@@ -0,0 +1,189 @@
+/*!
+ * @file 		jpeg_slices.cpp
+ * @author 		agent <agent@local>
+ * @date 		18.10.2026
+ * @copyright	Institute of Intermedia, CTU in Prague, 2026
+ * 				Distributed under modified BSD Licence, details in file doc/LICENSE
+ *
+ */
+
+#include "jpeg_slices.h"
+#include <algorithm>
+#include <cstring>
+
+namespace yuri {
+namespace jpeg {
+
+namespace {
+
+enum marker_t : uint8_t {
+	marker_sof0 = 0xC0,
+	marker_sof1 = 0xC1,
+	marker_sof15 = 0xCF,
+	marker_dht = 0xC4,
+	marker_jpg = 0xC8,
+	marker_dac = 0xCC,
+	marker_rst0 = 0xD0,
+	marker_rst7 = 0xD7,
+	marker_soi = 0xD8,
+	marker_eoi = 0xD9,
+	marker_sos = 0xDA,
+	marker_dri = 0xDD,
+	marker_tem = 0x01,
+};
+
+inline uint16_t read_be16(const uint8_t* data)
+{
+	return static_cast<uint16_t>((data[0] << 8) | data[1]);
+}
+
+inline void write_be16(uint8_t* data, uint16_t value)
+{
+	data[0] = static_cast<uint8_t>(value >> 8);
+	data[1] = static_cast<uint8_t>(value & 0xFF);
+}
+
+inline bool is_sof(uint8_t marker)
+{
+	return marker >= marker_sof0 && marker <= marker_sof15 &&
+			marker != marker_dht && marker != marker_jpg && marker != marker_dac;
+}
+
+inline bool is_rst(uint8_t marker)
+{
+	return marker >= marker_rst0 && marker <= marker_rst7;
+}
+
+}
+
+bool parse_jpeg_layout(const uint8_t* data, size_t size, jpeg_layout_t& layout)
+{
+	layout = jpeg_layout_t{};
+	if (size < 4 || data[0] != 0xFF || data[1] != marker_soi) return false;
+	size_t components = 0;
+	size_t pos = 2;
+	while (pos + 4 <= size) {
+		if (data[pos] != 0xFF) return false;
+		const uint8_t marker = data[pos + 1];
+		if (marker == 0xFF) { // Fill byte
+			++pos;
+			continue;
+		}
+		if (is_rst(marker) || marker == marker_tem) {
+			pos += 2;
+			continue;
+		}
+		const size_t length = read_be16(data + pos + 2);
+		if (length < 2 || pos + 2 + length > size) return false;
+		const uint8_t* segment = data + pos + 4;
+		if (is_sof(marker)) {
+			// Only sequential huffman coded images have a single scan
+			if (marker != marker_sof0 && marker != marker_sof1) return false;
+			if (length < 8) return false;
+			components = segment[5];
+			if (!components || length < 8 + 3 * components) return false;
+			layout.sof = pos;
+			layout.resolution = {read_be16(segment + 3), read_be16(segment + 1)};
+			int max_h = 1, max_v = 1;
+			if (components > 1) {
+				for (size_t i = 0; i < components; ++i) {
+					max_h = std::max(max_h, segment[7 + 3 * i] >> 4);
+					max_v = std::max(max_v, segment[7 + 3 * i] & 0x0F);
+				}
+			}
+			layout.mcu = {static_cast<dimension_t>(max_h * 8), static_cast<dimension_t>(max_v * 8)};
+		} else if (marker == marker_dri) {
+			if (length < 4) return false;
+			layout.dri = pos;
+			layout.restart_interval = read_be16(segment);
+		} else if (marker == marker_sos) {
+			// Scans with a subset of components mean there will be more scans
+			if (!components || segment[0] != components) return false;
+			layout.sos = pos;
+			layout.scan_start = pos + 2 + length;
+			return layout.resolution.width && layout.resolution.height;
+		} else if (marker == marker_eoi) {
+			return false;
+		}
+		pos += 2 + length;
+	}
+	return false;
+}
+
+std::vector<segment_t> find_restart_segments(const uint8_t* data, size_t size, const jpeg_layout_t& layout)
+{
+	std::vector<segment_t> segments;
+	size_t start = layout.scan_start;
+	size_t pos = start;
+	while (pos + 1 < size) {
+		const uint8_t* ff = static_cast<const uint8_t*>(std::memchr(data + pos, 0xFF, size - pos - 1));
+		if (!ff) break;
+		pos = ff - data;
+		const uint8_t next = data[pos + 1];
+		if (next == 0x00 || next == 0xFF) {
+			// Stuffed byte or fill byte
+			pos += 1 + (next == 0x00);
+			continue;
+		}
+		segments.push_back({data + start, pos - start});
+		if (!is_rst(next)) return segments;
+		pos += 2;
+		start = pos;
+	}
+	// Missing EOI
+	segments.push_back({data + start, size - start});
+	return segments;
+}
+
+size_t get_header_size(const jpeg_layout_t& layout)
+{
+	return layout.scan_start + (layout.dri ? 0 : 6);
+}
+
+size_t write_header(const uint8_t* data, const jpeg_layout_t& layout, dimension_t height,
+		uint16_t restart_interval, uint8_t* out)
+{
+	uint8_t* o = out;
+	std::copy(data, data + layout.sos, o);
+	write_be16(o + layout.sof + 5, static_cast<uint16_t>(height));
+	if (layout.dri) {
+		write_be16(o + layout.dri + 4, restart_interval);
+	}
+	o += layout.sos;
+	if (!layout.dri) {
+		*o++ = 0xFF;
+		*o++ = marker_dri;
+		write_be16(o, 4);
+		write_be16(o + 2, restart_interval);
+		o += 4;
+	}
+	o = std::copy(data + layout.sos, data + layout.scan_start, o);
+	return o - out;
+}
+
+size_t get_segments_size(const segment_t* segments, size_t count)
+{
+	size_t size = 2 * count;
+	for (size_t i = 0; i < count; ++i) {
+		size += segments[i].size;
+	}
+	return size;
+}
+
+size_t write_segments(const segment_t* segments, size_t count, uint8_t* out)
+{
+	uint8_t* o = out;
+	for (size_t i = 0; i < count; ++i) {
+		if (i > 0) {
+			*o++ = 0xFF;
+			*o++ = static_cast<uint8_t>(marker_rst0 + ((i - 1) & 7));
+		}
+		o = std::copy(segments[i].data, segments[i].data + segments[i].size, o);
+	}
+	*o++ = 0xFF;
+	*o++ = marker_eoi;
+	return o - out;
+}
+
+}
+}
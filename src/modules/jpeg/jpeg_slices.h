@@ -0,0 +1,84 @@
+/*!
+ * @file 		jpeg_slices.h
+ * @author 		agent <agent@local>
+ * @date 		18.10.2026
+ * @copyright	Institute of Intermedia, CTU in Prague, 2026
+ * 				Distributed under modified BSD Licence, details in file doc/LICENSE
+ *
+ */
+
+#ifndef JPEG_SLICES_H_
+#define JPEG_SLICES_H_
+
+#include "yuri/core/utils/new_types.h"
+#include <vector>
+
+namespace yuri {
+namespace jpeg {
+
+/*!
+ * Positions of the important parts of a baseline (single scan) JPEG image.
+ */
+struct jpeg_layout_t {
+	//! Offset of the SOF marker
+	size_t sof;
+	//! Offset of the DRI marker, or 0 if there's none
+	size_t dri;
+	//! Offset of the SOS marker
+	size_t sos;
+	//! First byte of the entropy coded data
+	size_t scan_start;
+	uint16_t restart_interval;
+	resolution_t resolution;
+	//! Size of a MCU in pixels
+	resolution_t mcu;
+};
+
+//! Part of the entropy coded data between two restart markers
+struct segment_t {
+	const uint8_t* data;
+	size_t size;
+};
+
+/*!
+ * Parses headers of a JPEG image.
+ * @return false for invalid images and images with more than one scan (progressive).
+ */
+bool parse_jpeg_layout(const uint8_t* data, size_t size, jpeg_layout_t& layout);
+
+/*!
+ * Splits entropy coded data of an image on restart markers.
+ * The markers themselves are not part of the segments.
+ */
+std::vector<segment_t> find_restart_segments(const uint8_t* data, size_t size, const jpeg_layout_t& layout);
+
+/*!
+ * Returns size of the header written by write_header()
+ */
+size_t get_header_size(const jpeg_layout_t& layout);
+
+/*!
+ * Writes all headers of an image (up to the start of entropy coded data),
+ * with image height and restart interval replaced.
+ * The DRI segment is added if the original image doesn't contain it.
+ * @return Number of bytes written
+ */
+size_t write_header(const uint8_t* data, const jpeg_layout_t& layout, dimension_t height,
+		uint16_t restart_interval, uint8_t* out);
+
+/*!
+ * Returns size of the data written by write_segments()
+ */
+size_t get_segments_size(const segment_t* segments, size_t count);
+
+/*!
+ * Writes entropy coded segments separated by restart markers (numbered from 0)
+ * followed by the EOI marker.
+ * @return Number of bytes written
+ */
+size_t write_segments(const segment_t* segments, size_t count, uint8_t* out);
+
+}
+}
+
+#endif /* JPEG_SLICES_H_ */
@@ -0,0 +1,198 @@
+/*!
+ * @file 		jpeg_test.cpp
+ * @author 		agent <agent@local>
+ * @date 		18.10.2026
+ * @copyright	Institute of Intermedia, CTU in Prague, 2026
+ * 				Distributed under modified BSD Licence, details in file doc/LICENSE
+ *
+ */
+
+#include "tests/catch.hpp"
+#include "JpegEncodeContext.h"
+#include "JpegDecodeContext.h"
+#include "yuri/core/frame/raw_frame_types.h"
+#include "yuri/core/frame/compressed_frame_types.h"
+#include <cstdlib>
+
+namespace yuri {
+namespace jpeg {
+
+namespace {
+
+core::pRawVideoFrame make_frame(format_t format, resolution_t res)
+{
+	auto frame = core::RawVideoFrame::create_empty(format, res);
+	const size_t linesize = PLANE_DATA(frame, 0).get_line_size();
+	const size_t bpp = core::raw_format::get_fmt_bpp(format, 0) / 8;
+	uint8_t* data = PLANE_RAW_DATA(frame, 0);
+	for (dimension_t y = 0; y < res.height; ++y) {
+		for (dimension_t x = 0; x < res.width; ++x) {
+			for (size_t i = 0; i < bpp; ++i) {
+				data[y * linesize + x * bpp + i] = static_cast<uint8_t>(x * (i + 1) + y * 3 + ((x * y) % 7) * 5);
+			}
+		}
+	}
+	return frame;
+}
+
+std::vector<uint8_t> decode(const uint8_t* data, size_t size, format_t format, bool fast)
+{
+	JpegDecodeContext context;
+	const resolution_t res = context.read_header(data, size);
+	const size_t bpp = core::raw_format::get_fmt_bpp(format, 0) / 8;
+	std::vector<uint8_t> out(res.width * res.height * bpp);
+	context.decode(format, fast, out.data(), res.width * bpp);
+	return out;
+}
+
+std::vector<uint8_t> decode(const core::pCompressedVideoFrame& frame, format_t format, bool fast)
+{
+	return decode(frame->data(), frame->size(), format, fast);
+}
+
+}
+
+TEST_CASE( "jpeg layout", "[module]" ) {
+	using namespace core::raw_format;
+	JpegEncodeContext context;
+	SECTION("rgb") {
+		auto jpeg = context.encode(*make_frame(rgb24, {100, 60}), core::compressed_frame::jpeg, 90);
+		jpeg_layout_t layout;
+		REQUIRE( parse_jpeg_layout(jpeg->data(), jpeg->size(), layout) );
+		REQUIRE( layout.resolution == resolution_t{100, 60} );
+		REQUIRE( layout.mcu == resolution_t{16, 16} );
+		REQUIRE( layout.restart_interval == 0 );
+		REQUIRE( find_restart_segments(jpeg->data(), jpeg->size(), layout).size() == 1 );
+	}
+	SECTION("gray") {
+		auto jpeg = context.encode(*make_frame(y8, {100, 60}), core::compressed_frame::jpeg, 90);
+		jpeg_layout_t layout;
+		REQUIRE( parse_jpeg_layout(jpeg->data(), jpeg->size(), layout) );
+		REQUIRE( layout.mcu == resolution_t{8, 8} );
+	}
+	SECTION("invalid data") {
+		const std::vector<uint8_t> data = {0xFF, 0xD8, 0xFF, 0xC0, 0x00};
+		jpeg_layout_t layout;
+		REQUIRE( !parse_jpeg_layout(data.data(), data.size(), layout) );
+		REQUIRE( !parse_jpeg_layout(data.data(), 1, layout) );
+	}
+}
+
+TEST_CASE( "jpeg slices", "[module]" ) {
+	using namespace core::raw_format;
+	const resolution_t res{203, 157};
+	for (format_t format: {rgb24, y8}) {
+		const auto frame = make_frame(format, res);
+		JpegEncodeContext context;
+		std::vector<std::unique_ptr<JpegEncodeContext>> helpers;
+		const auto mcu = context.get_mcu_size(format);
+		const auto plain = context.encode(*frame, core::compressed_frame::jpeg, 85);
+		const auto sliced = context.encode_sliced(*frame, core::compressed_frame::jpeg, 85, 4, helpers);
+		REQUIRE( sliced->get_resolution() == res );
+
+		jpeg_layout_t layout;
+		REQUIRE( parse_jpeg_layout(sliced->data(), sliced->size(), layout) );
+		const size_t mcu_rows = (res.height + mcu.height - 1) / mcu.height;
+		const size_t mcus_per_row = (res.width + mcu.width - 1) / mcu.width;
+		const size_t rows_per_slice = (mcu_rows + 3) / 4;
+		REQUIRE( layout.resolution == res );
+		REQUIRE( layout.restart_interval == rows_per_slice * mcus_per_row );
+		const auto segments = find_restart_segments(sliced->data(), sliced->size(), layout);
+		REQUIRE( segments.size() == (mcu_rows + rows_per_slice - 1) / rows_per_slice );
+
+		// Slices are encoded exactly as the whole image, so decoding has to give the same result
+		const auto expected = decode(plain, format, false);
+		REQUIRE( decode(sliced, format, false) == expected );
+
+		for (bool fast: {true, false}) {
+			const size_t bpp = core::raw_format::get_fmt_bpp(format, 0) / 8;
+			const auto serial = decode(sliced, format, fast);
+			std::vector<uint8_t> parallel(serial.size());
+			JpegDecodeContext decoder;
+			std::vector<std::unique_ptr<JpegDecodeContext>> decode_helpers;
+			REQUIRE( decoder.decode_sliced(sliced->data(), sliced->size(), layout, format, fast,
+					parallel.data(), res.width * bpp, 3, decode_helpers) );
+			if (fast || format == y8) {
+				REQUIRE( parallel == serial );
+			} else {
+				// Chroma upsampling can differ at the slice boundaries
+				for (size_t i = 0; i < serial.size(); ++i) {
+					REQUIRE( std::abs(parallel[i] - serial[i]) < 32 );
+				}
+			}
+		}
+		// Image without restart markers can't be decoded in slices
+		jpeg_layout_t plain_layout;
+		REQUIRE( parse_jpeg_layout(plain->data(), plain->size(), plain_layout) );
+		JpegDecodeContext decoder;
+		std::vector<std::unique_ptr<JpegDecodeContext>> decode_helpers;
+		std::vector<uint8_t> out(expected.size());
+		REQUIRE( !decoder.decode_sliced(plain->data(), plain->size(), plain_layout, format, false,
+				out.data(), res.width, 3, decode_helpers) );
+	}
+}
+
+TEST_CASE( "jpeg planar decoding", "[module]" ) {
+	using namespace core::raw_format;
+	const resolution_t res{203, 157};
+	JpegEncodeContext encoder;
+	const auto jpeg = encoder.encode(*make_frame(rgb24, res), core::compressed_frame::jpeg, 90);
+	JpegDecodeContext context;
+
+	for (format_t format: {yuv420p, yuv422p, yuv444p}) {
+		REQUIRE( JpegDecodeContext::supports_planar(format) );
+		// The image is encoded as 4:2:0, so without fancy upsampling the chroma is just replicated
+		const bool fast = format == yuv420p;
+		const auto yuv = decode(jpeg, yuv444, fast);
+		REQUIRE( context.read_header(jpeg->data(), jpeg->size()) == res );
+		auto frame = core::RawVideoFrame::create_empty(format, res);
+		context.decode_planar(fast, *frame);
+		const auto& info = get_format_info(format);
+		for (int p = 0; p < 3; ++p) {
+			const auto& plane = (*frame)[p];
+			const auto sub_x = info.planes[p].sub_x;
+			const auto sub_y = info.planes[p].sub_y;
+			for (dimension_t y = 0; y < plane.get_resolution().height; ++y) {
+				for (dimension_t x = 0; x < plane.get_resolution().width; ++x) {
+					size_t sum = sub_x * sub_y / 2;
+					for (size_t dy = 0; dy < sub_y; ++dy) {
+						for (size_t dx = 0; dx < sub_x; ++dx) {
+							sum += yuv[((y * sub_y + dy) * res.width + x * sub_x + dx) * 3 + p];
+						}
+					}
+					REQUIRE( plane.data()[y * plane.get_line_size() + x] == sum / (sub_x * sub_y) );
+				}
+			}
+		}
+	}
+	SECTION("gray") {
+		const auto gray = encoder.encode(*make_frame(y8, res), core::compressed_frame::jpeg, 90);
+		const auto expected = decode(gray, y8, false);
+		REQUIRE( context.read_header(gray->data(), gray->size()) == res );
+		auto frame = core::RawVideoFrame::create_empty(yuv420p, res);
+		context.decode_planar(false, *frame);
+		for (dimension_t y = 0; y < res.height; ++y) {
+			REQUIRE( std::equal(expected.begin() + y * res.width, expected.begin() + (y + 1) * res.width,
+					PLANE_RAW_DATA(frame, 0) + y * PLANE_DATA(frame, 0).get_line_size()) );
+		}
+		REQUIRE( PLANE_RAW_DATA(frame, 1)[0] == 128 );
+		REQUIRE( PLANE_RAW_DATA(frame, 2)[10] == 128 );
+	}
+	SECTION("scaled") {
+		REQUIRE( context.read_header(jpeg->data(), jpeg->size()) == res );
+		const auto scaled = context.scale_to({100, 70});
+		REQUIRE( scaled == resolution_t{102, 79} );
+		auto frame = core::RawVideoFrame::create_empty(yuv420p, scaled);
+		context.decode_planar(true, *frame);
+
+		REQUIRE( context.read_header(jpeg->data(), jpeg->size()) == res );
+		REQUIRE( context.scale_to({1000, 1000}) == res );
+		REQUIRE( context.read_header(jpeg->data(), jpeg->size()) == res );
+		REQUIRE( context.scale_to({1, 1}) == resolution_t{26, 20} );
+		std::vector<uint8_t> out(26 * 20 * 3);
+		context.decode(rgb24, true, out.data(), 26 * 3);
+	}
+}
+
+}
+}
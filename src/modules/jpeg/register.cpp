@@ -23,6 +23,10 @@ MODULE_REGISTRATION_BEGIN("jpeg")
 		REGISTER_CONVERTER(compressed_frame::jpeg, raw_format::rgb24, "jpeg_decoder", 30)
 		REGISTER_CONVERTER(compressed_frame::jpeg, raw_format::yuv444, "jpeg_decoder", 25)
 		REGISTER_CONVERTER(compressed_frame::jpeg, raw_format::y8, "jpeg_decoder", 35)
+		REGISTER_CONVERTER(compressed_frame::jpeg, raw_format::yuv420p, "jpeg_decoder", 20)
+		REGISTER_CONVERTER(compressed_frame::jpeg, raw_format::yuv422p, "jpeg_decoder", 20)
+		REGISTER_CONVERTER(compressed_frame::jpeg, raw_format::yuv444p, "jpeg_decoder", 25)
+		REGISTER_CONVERTER(compressed_frame::jpeg, raw_format::yuv411p, "jpeg_decoder", 25)
 #if defined(JCS_EXTENSIONS) && defined(JCS_ALPHA_EXTENSIONS)
 		REGISTER_CONVERTER(compressed_frame::jpeg, raw_format::bgr24, "jpeg_decoder", 30)
 
@@ -11,6 +11,8 @@
 #include "yuri/core/Module.h"
 #include "yuri/core/frame/raw_frame_types.h"
 #include "yuri/event/EventHelpers.h"
+#include "yuri/core/utils/parallel_for.h"
+#include <cstring>
 
 namespace yuri {
 namespace magnify {
@@ -28,6 +30,7 @@ core::Parameters Magnify::configure()
 	p.set_description("Magnify");
 	p["geometry"]["Rectangle to magnify"]=geometry_t{50,50,0,0};
 	p["zoom"]["Magnification"]=5;
+	p["threads"]["Number of threads to use"]=1;
 	return p;
 }
 
@@ -35,46 +38,85 @@ core::Parameters Magnify::configure()
 Magnify::Magnify(const log::Log &log_, core::pwThreadBase parent, const core::Parameters &parameters):
 base_type(log_,parent,std::string("magnify")),
 event::BasicEventConsumer(log),
-geometry_(geometry_t{50,50,0,0}),zoom_(5)
+geometry_(geometry_t{50,50,0,0}),zoom_(5),threads_(1)
 {
 	IOTHREAD_INIT(parameters)
-	set_supported_formats({core::raw_format::rgb24});
+	using namespace core::raw_format;
+	set_supported_formats({rgb24, bgr24, rgba32, bgra32, argb32, abgr32, yuv444, yuva4444, y8});
 }
 
 Magnify::~Magnify() noexcept
 {
 }
 
+namespace {
+
+/*!
+ * Repeats every pixel of a line @em zoom times
+ */
+template<size_t bpp>
+void expand_line(const uint8_t* in, uint8_t* out, dimension_t width, size_t zoom)
+{
+	for (dimension_t col = 0; col < width; ++col) {
+		for (size_t z = 0; z < zoom; ++z) {
+			std::memcpy(out, in, bpp);
+			out += bpp;
+		}
+		in += bpp;
+	}
+}
+
+void expand_line(const uint8_t* in, uint8_t* out, dimension_t width, size_t zoom, size_t bpp)
+{
+	switch (bpp) {
+		case 1:
+			for (dimension_t col = 0; col < width; ++col, out += zoom) std::memset(out, in[col], zoom);
+			break;
+		case 3: expand_line<3>(in, out, width, zoom); break;
+		case 4: expand_line<4>(in, out, width, zoom); break;
+		default: break;
+	}
+}
+
+}
+
 core::pFrame Magnify::do_special_single_step(core::pRawVideoFrame frame)
 {
 	process_events();
-	const resolution_t out_res = {geometry_.width*zoom_, geometry_.height*zoom_};
-	auto outframe = core::RawVideoFrame::create_empty(core::raw_format::rgb24, out_res);
+	const auto rect = intersection(geometry_, frame->get_resolution());
+	if (!rect || !zoom_) return {};
+	const format_t fmt = frame->get_format();
+	const size_t bpp = core::raw_format::get_fmt_bpp(fmt, 0) / 8;
+	const resolution_t out_res = {rect.width*zoom_, rect.height*zoom_};
+	auto outframe = core::RawVideoFrame::create_empty(fmt, out_res);
+	outframe->copy_video_params(*frame);
 	const size_t linesize = PLANE_DATA(frame,0).get_line_size();
-	auto out = PLANE_RAW_DATA(outframe, 0);
-	for (dimension_t line = 0; line < geometry_.height; ++line) {
-
-		for (size_t z=0;z<zoom_;++z) {
-			auto in = PLANE_RAW_DATA(frame, 0) + line * linesize;
-			for (dimension_t col = 0; col < geometry_.width; ++col) {
-				for (size_t z2=0;z2<zoom_;++z2) {
-					std::copy(in, in+3, out);
-					out+=3;
-				}
-				in+=3;
+	const size_t out_linesize = PLANE_DATA(outframe,0).get_line_size();
+	const uint8_t* in = PLANE_RAW_DATA(frame, 0) + rect.y * linesize + rect.x * bpp;
+	uint8_t* out = PLANE_RAW_DATA(outframe, 0);
+	const size_t zoom = zoom_;
+
+	// Every input line is expanded once and the result is copied to the remaining output lines
+	core::utils::parallel_for(threads_, 0, rect.height, [=](size_t start, size_t end) {
+		for (size_t line = start; line < end; ++line) {
+			uint8_t* first = out + line * zoom * out_linesize;
+			expand_line(in + line * linesize, first, rect.width, zoom, bpp);
+			for (size_t z = 1; z < zoom; ++z) {
+				std::memcpy(first + z * out_linesize, first, rect.width * zoom * bpp);
 			}
 		}
-	}
-
-
+	}, 16);
 	return outframe;
 }
+
 bool Magnify::set_param(const core::Parameter& param)
 {
 	if (param.get_name() == "geometry") {
 		geometry_=param.get<geometry_t>();
 	} else if (param.get_name() == "zoom") {
 		zoom_ = param.get<size_t>();
+	} else if (param.get_name() == "threads") {
+		threads_ = param.get<size_t>();
 	} else return base_type::set_param(param);
 	return true;
 }
@@ -32,6 +32,7 @@ private:
 
 	geometry_t geometry_;
 	size_t	zoom_;
+	size_t	threads_;
 };
 
 } /* namespace magnify */
@@ -13,6 +13,7 @@
 #include "yuri/core/frame/RawVideoFrame.h"
 #include "yuri/core/utils/assign_events.h"
 #include <cmath>
+#include <algorithm>
 namespace yuri {
 namespace mosaic {
 
@@ -30,76 +31,36 @@ core::Parameters Mosaic::configure()
 	p["center"]["Center of mosaic"]=coordinates_t{128,128};
 	p["radius"]["Radius of mosaic"]=128;
 	p["tile_size"]["Size of a single tile in the mosaic"]=16;
+	p["threads"]["Number of threads to use"]=1;
 	return p;
 }
 
 namespace {
-inline position_t get_distance(coordinates_t a, coordinates_t b) {
-	position_t x = a.x - b.x;
-	position_t y = a.y - b.y;
-	return static_cast<position_t>(std::sqrt(x*x + y*y));
-}
-template<size_t size, class dist_func>
-void apply_mosaic(const uint8_t* data_in, uint8_t* data_out, size_t linesize, const coordinates_t& dest_lu, const coordinates_t& dest_rb, dist_func dist)
+bool same_bounds(const geometry_t& a, const geometry_t& b)
 {
-	size_t vals[size];
-	std::fill(vals, vals+size, 0);
-	size_t count = 0;
-	for (position_t line = dest_lu.y; line < dest_rb.y; ++line) {
-		const uint8_t* d = data_in + line*linesize + dest_lu.x* size;
-		for (position_t col = dest_lu.x; col < dest_rb.x; ++col) {
-			for (size_t i = 0; i<size;++i) {
-				vals[i] += *d++;
-			}
-			count ++;
-		}
-	}
-
-	uint8_t vals2[size];
-	for (size_t i = 0; i<size;++i) {
-		vals2[i] = count?static_cast<uint8_t>(vals[i] / count):0;
-	}
-	for (position_t line = dest_lu.y; line < dest_rb.y; ++line) {
-		uint8_t* d = data_out + line*linesize + dest_lu.x * size;
-		for (position_t col = dest_lu.x; col < dest_rb.x; ++col) {
-			if (dist({col, line})) {
-				d+=size;
-			} else {
-				for (size_t i = 0; i<size;++i) {
-					*d++ = vals2[i];
-				}
-			}
-		}
-	}
+	return a.x == b.x && a.y == b.y && a.width == b.width && a.height == b.height;
 }
-void process_mosaic(const uint8_t* data_in, uint8_t* data_out, size_t linesize, size_t bpp, coordinates_t img, coordinates_t center, position_t radius, position_t tile_size)
+
+/*!
+ * Updates damage info of the output frame.
+ * Mosaic area is damaged if it moved or if any part of input under it changed.
+ */
+void update_damage(core::RawVideoFrame& frame, const std::vector<geometry_t>& bounds, const std::vector<geometry_t>& last_bounds)
 {
-	//	log[log::info] << "Number of tiles " << tile_count;
-
-	coordinates_t lu_corner = center - coordinates_t{radius, radius};
-	size_t tile_count = tile_size?(2*radius / tile_size):0;
-	for (size_t x = 0; x < tile_count+1; ++x) {
-		for (size_t y = 0; y < tile_count+1; ++y) {
-			coordinates_t corner = lu_corner + coordinates_t{static_cast<position_t>(x*tile_size), static_cast<position_t>(y*tile_size)};
-
-			if (corner.x > img.x) continue;
-			if (corner.y > img.y) continue;
-			if (corner.x + tile_size < 0) continue;
-			if (corner.y + tile_size < 0) continue;
-			coordinates_t dest_lu {std::max<position_t>(corner.x, 0L), std::max<position_t>(corner.y, 0L)};
-			coordinates_t dest_rb {std::min<position_t>(corner.x+ tile_size, img.x), std::min<position_t>(corner.y + tile_size, img.y)};
-
-			switch (bpp) {
-				case 1:	apply_mosaic<1>(data_in, data_out, linesize, dest_lu, dest_rb, [&](const coordinates_t& c)
-							{return get_distance(center, c) > radius;}); break;
-				case 2:	apply_mosaic<2>(data_in, data_out, linesize, dest_lu, dest_rb, [&](const coordinates_t& c)
-							{return get_distance(center, c) > radius;}); break;
-				case 3:	apply_mosaic<3>(data_in, data_out, linesize, dest_lu, dest_rb, [&](const coordinates_t& c)
-							{return get_distance(center, c) > radius;}); break;
-				case 4:	apply_mosaic<4>(data_in, data_out, linesize, dest_lu, dest_rb, [&](const coordinates_t& c)
-							{return get_distance(center, c) > radius;}); break;
+	if (!frame.has_damage_info()) return;
+	const bool moved = !std::equal(bounds.begin(), bounds.end(), last_bounds.begin(), last_bounds.end(), same_bounds);
+	if (moved) {
+		for (const auto& b: last_bounds) frame.add_damage(b);
+		for (const auto& b: bounds) frame.add_damage(b);
+		return;
+	}
+	const auto damage = frame.get_damage();
+	for (const auto& b: bounds) {
+		for (const auto& d: damage) {
+			if (intersection(b, d)) {
+				frame.add_damage(b);
+				break;
 			}
-
 		}
 	}
 }
@@ -135,7 +96,7 @@ const std::vector<format_t> supported_formats = {
 Mosaic::Mosaic(const log::Log &log_, core::pwThreadBase parent, const core::Parameters &parameters):
 core::SpecializedIOFilter<core::RawVideoFrame>(log_,parent,std::string("mosaic")),
 BasicEventConsumer(log),
-mosaics_{{300,50,{100,100}}}
+mosaics_{{300,50,{100,100}}},threads_(1)
 {
 	IOTHREAD_INIT(parameters)
 	set_supported_formats(supported_formats);
@@ -151,12 +112,11 @@ core::pFrame Mosaic::do_special_single_step(core::pRawVideoFrame frame)
 	using namespace core::raw_format;
 
 	resolution_t image_size = frame->get_resolution();
-	coordinates_t img = {static_cast<position_t>(image_size.width), static_cast<position_t>(image_size.height)};
 
-//	resolution_t rb_corner = center_ + resolution_t{radius_, radius_};
-
-	core::pRawVideoFrame frame_out = std::dynamic_pointer_cast<core::RawVideoFrame>(get_frame_unique(frame));//core::RawVideoFrame::create_empty(frame->get_format(), image_size);
-//	size_t tiles = 2*radius_ / tile_size_;
+	// Unique frames are processed in place
+	core::pRawVideoFrame frame_out = std::dynamic_pointer_cast<core::RawVideoFrame>(get_frame_unique(frame));
+	// Damage of the input applies to the output as well, update_damage() adds the mosaics
+	if (frame_out != frame) frame_out->copy_damage_info(*frame);
 
 	const uint8_t * data_in = PLANE_RAW_DATA(frame,0);
 	uint8_t * data_out = PLANE_RAW_DATA(frame_out,0);
@@ -165,12 +125,13 @@ core::pFrame Mosaic::do_special_single_step(core::pRawVideoFrame frame)
 //	const auto& fi = core::raw_format::get_format_info(frame->get_format());
 	size_t bpp = core::raw_format::get_fmt_bpp(frame->get_format(),0)/8;
 	log[log::verbose_debug] << "Mosaicing " << core::raw_format::get_format_name(frame->get_format());
+	apply_mosaics(data_in, data_out, linesize, bpp, image_size, mosaics_, threads_);
+	std::vector<geometry_t> bounds;
 	for (const auto& x: mosaics_) {
-		process_mosaic(data_in, data_out, linesize, bpp, img, x.center, x.radius, x.tile_size);
+		bounds.push_back(get_mosaic_bounds(x));
 	}
-
-
-
+	update_damage(*frame_out, bounds, last_bounds_);
+	last_bounds_ = std::move(bounds);
 	return frame_out;
 }
 
@@ -179,7 +140,8 @@ bool Mosaic::set_param(const core::Parameter& param)
 	if (assign_parameters(param)
 			(mosaics_[0].center, "center")
 			(mosaics_[0].radius, "radius")
-			(mosaics_[0].tile_size, "tile_size"))
+			(mosaics_[0].tile_size, "tile_size")
+			(threads_, "threads"))
 		return true;
 	return core::SpecializedIOFilter<core::RawVideoFrame>::set_param(param);
 }
@@ -13,16 +13,11 @@
 #include "yuri/core/thread/SpecializedIOFilter.h"
 #include "yuri/core/frame/RawVideoFrame.h"
 #include "yuri/event/BasicEventConsumer.h"
+#include "mosaic_kernels.h"
 
 namespace yuri {
 namespace mosaic {
 
-struct mosaic_detail_t {
-	position_t radius;
-	position_t tile_size;
-	coordinates_t center;
-};
-
 class Mosaic: public core::SpecializedIOFilter<core::RawVideoFrame>, public event::BasicEventConsumer
 {
 public:
@@ -37,6 +32,9 @@ private:
 	virtual bool do_process_event(const std::string& event_name, const event::pBasicEvent& event) override;
 
 	std::vector<mosaic_detail_t> mosaics_;
+	//! Areas affected by mosaics in previous frame
+	std::vector<geometry_t> last_bounds_;
+	size_t threads_;
 };
 
 } /* namespace mosaic */
@@ -0,0 +1,171 @@
+/*!
+ * @file 		mosaic_kernels.cpp
+ * @author 		agent <agent@local>
+ * @date 		18.10.2026
+ * @copyright	Institute of Intermedia, CTU in Prague, 2026
+ * 				Distributed under modified BSD Licence, details in file doc/LICENSE
+ *
+ */
+
+#include "mosaic_kernels.h"
+#include "yuri/core/utils/parallel_for.h"
+#include <algorithm>
+#include <cmath>
+
+namespace yuri {
+namespace mosaic {
+
+namespace {
+
+//! Single row of tiles of a mosaic
+struct tile_row_t {
+	const mosaic_detail_t* mosaic;
+	position_t top;
+};
+
+/*!
+ * Returns largest dx such that a pixel at distance (dx, dy) from the center belongs to the mosaic,
+ * or -1 if there's no such pixel.
+ * A pixel belongs to the mosaic if its distance, truncated to an integer, is not greater than radius.
+ */
+position_t half_span(position_t radius, position_t dy)
+{
+	const position_t limit = (radius + 1) * (radius + 1) - dy * dy;
+	if (limit <= 0) return -1;
+	auto h = static_cast<position_t>(std::sqrt(static_cast<double>(limit)));
+	while (h > 0 && h * h >= limit) --h;
+	while ((h + 1) * (h + 1) < limit) ++h;
+	return h;
+}
+
+template<size_t bpp>
+void process_tile_row(const uint8_t* data_in, uint8_t* data_out, size_t linesize, resolution_t res,
+		const tile_row_t& row, std::vector<uint32_t>& sums, std::vector<uint8_t>& averages)
+{
+	const auto& m = *row.mosaic;
+	const position_t ts = m.tile_size;
+	const position_t img_w = static_cast<position_t>(res.width);
+	const position_t img_h = static_cast<position_t>(res.height);
+	const position_t y0 = std::max<position_t>(row.top, 0);
+	const position_t y1 = std::min<position_t>(row.top + ts, img_h);
+	if (y1 <= y0) return;
+	const position_t tile_count = 2 * m.radius / ts;
+	const position_t left = m.center.x - m.radius;
+	const position_t x0 = std::max<position_t>(left, 0);
+	const position_t x1 = std::min<position_t>(left + (tile_count + 1) * ts, img_w);
+	if (x1 <= x0) return;
+
+	// Column sums over the whole row of tiles. This loop is trivially vectorized.
+	const size_t width = (x1 - x0) * bpp;
+	sums.assign(width, 0);
+	for (position_t line = y0; line < y1; ++line) {
+		const uint8_t* src = data_in + line * linesize + x0 * bpp;
+		for (size_t i = 0; i < width; ++i) {
+			sums[i] += src[i];
+		}
+	}
+
+	const position_t first_tile = (x0 - left) / ts;
+	const position_t last_tile = (x1 - 1 - left) / ts;
+	averages.resize((last_tile - first_tile + 1) * bpp);
+	for (position_t t = first_tile; t <= last_tile; ++t) {
+		const position_t tx0 = std::max<position_t>(left + t * ts, x0);
+		const position_t tx1 = std::min<position_t>(left + (t + 1) * ts, x1);
+		const uint32_t count = static_cast<uint32_t>((tx1 - tx0) * (y1 - y0));
+		uint32_t vals[bpp] = {};
+		for (position_t col = tx0; col < tx1; ++col) {
+			const uint32_t* s = &sums[(col - x0) * bpp];
+			for (size_t i = 0; i < bpp; ++i) {
+				vals[i] += s[i];
+			}
+		}
+		for (size_t i = 0; i < bpp; ++i) {
+			averages[(t - first_tile) * bpp + i] = static_cast<uint8_t>(vals[i] / count);
+		}
+	}
+
+	for (position_t line = y0; line < y1; ++line) {
+		const position_t h = half_span(m.radius, line - m.center.y);
+		if (h < 0) continue;
+		const position_t sx0 = std::max<position_t>(m.center.x - h, x0);
+		const position_t sx1 = std::min<position_t>(m.center.x + h + 1, x1);
+		if (sx1 <= sx0) continue;
+		uint8_t* dst = data_out + line * linesize;
+		for (position_t t = (sx0 - left) / ts; t <= (sx1 - 1 - left) / ts; ++t) {
+			const position_t a = std::max<position_t>(sx0, left + t * ts);
+			const position_t b = std::min<position_t>(sx1, left + (t + 1) * ts);
+			const uint8_t* pixel = &averages[(t - first_tile) * bpp];
+			uint8_t* d = dst + a * bpp;
+			for (position_t col = a; col < b; ++col) {
+				for (size_t i = 0; i < bpp; ++i) {
+					*d++ = pixel[i];
+				}
+			}
+		}
+	}
+}
+
+void process_tile_rows(const uint8_t* data_in, uint8_t* data_out, size_t linesize, size_t bpp, resolution_t res,
+		const tile_row_t* rows, size_t count)
+{
+	std::vector<uint32_t> sums;
+	std::vector<uint8_t> averages;
+	for (size_t i = 0; i < count; ++i) {
+		switch (bpp) {
+			case 1: process_tile_row<1>(data_in, data_out, linesize, res, rows[i], sums, averages); break;
+			case 2: process_tile_row<2>(data_in, data_out, linesize, res, rows[i], sums, averages); break;
+			case 3: process_tile_row<3>(data_in, data_out, linesize, res, rows[i], sums, averages); break;
+			case 4: process_tile_row<4>(data_in, data_out, linesize, res, rows[i], sums, averages); break;
+			default: return;
+		}
+	}
+}
+
+}
+
+geometry_t get_mosaic_bounds(const mosaic_detail_t& mosaic)
+{
+	const position_t tile_count = mosaic.tile_size?(2*mosaic.radius / mosaic.tile_size):0;
+	const auto size = static_cast<dimension_t>(std::max<position_t>((tile_count + 1) * mosaic.tile_size, 0));
+	return {size, size, mosaic.center.x - mosaic.radius, mosaic.center.y - mosaic.radius};
+}
+
+void apply_mosaics(const uint8_t* data_in, uint8_t* data_out, size_t linesize, size_t bpp,
+		resolution_t res, const std::vector<mosaic_detail_t>& mosaics, size_t threads)
+{
+	std::vector<tile_row_t> rows;
+	// Index of first row for every mosaic (and one past the last)
+	std::vector<size_t> first_rows;
+	std::vector<geometry_t> bounds;
+	bool overlapping = false;
+	for (const auto& m: mosaics) {
+		first_rows.push_back(rows.size());
+		if (m.tile_size <= 0 || m.radius < 0) continue;
+		const auto b = intersection(get_mosaic_bounds(m), res);
+		if (!b) continue;
+		for (const auto& b2: bounds) {
+			if (intersection(b, b2)) overlapping = true;
+		}
+		bounds.push_back(b);
+		const position_t tile_count = 2 * m.radius / m.tile_size;
+		for (position_t y = 0; y <= tile_count; ++y) {
+			rows.push_back({&m, m.center.y - m.radius + y * m.tile_size});
+		}
+	}
+	first_rows.push_back(rows.size());
+
+	auto process = [&](size_t start, size_t end) {
+		process_tile_rows(data_in, data_out, linesize, bpp, res, rows.data() + start, end - start);
+	};
+	if (!overlapping) {
+		core::utils::parallel_for(threads, 0, rows.size(), process);
+	} else {
+		// Overlapping mosaics have to be applied one after another
+		for (size_t i = 0; i + 1 < first_rows.size(); ++i) {
+			core::utils::parallel_for(threads, first_rows[i], first_rows[i + 1], process);
+		}
+	}
+}
+
+}
+}
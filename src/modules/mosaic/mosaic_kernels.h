@@ -0,0 +1,54 @@
+/*!
+ * @file 		mosaic_kernels.h
+ * @author 		agent <agent@local>
+ * @date 		18.10.2026
+ * @copyright	Institute of Intermedia, CTU in Prague, 2026
+ * 				Distributed under modified BSD Licence, details in file doc/LICENSE
+ *
+ */
+
+#ifndef MOSAIC_KERNELS_H_
+#define MOSAIC_KERNELS_H_
+
+#include "yuri/core/utils/new_types.h"
+#include <vector>
+
+namespace yuri {
+namespace mosaic {
+
+struct mosaic_detail_t {
+	position_t radius;
+	position_t tile_size;
+	coordinates_t center;
+};
+
+/*!
+ * Returns rectangle possibly affected by a mosaic
+ */
+geometry_t get_mosaic_bounds(const mosaic_detail_t& mosaic);
+
+/*!
+ * Applies circular mosaics to a packed image.
+ *
+ * The area around each mosaic is divided into square tiles, every pixel inside the circle
+ * is replaced by average of its tile. Tile averages are computed from column sums
+ * accumulated over the tile rows, so every input pixel is read only once per mosaic.
+ *
+ * Mosaics are applied in order. Rows of tiles are processed in parallel,
+ * if the mosaics don't overlap, rows from all mosaics are processed at once.
+ *
+ * @param data_in	Input image
+ * @param data_out	Output image, can be the same as @em data_in
+ * @param linesize	Line size (in bytes) of both images
+ * @param bpp		Bytes per pixel (1 - 4)
+ * @param res		Image resolution
+ * @param mosaics	List of mosaics to apply
+ * @param threads	Number of threads to use
+ */
+void apply_mosaics(const uint8_t* data_in, uint8_t* data_out, size_t linesize, size_t bpp,
+		resolution_t res, const std::vector<mosaic_detail_t>& mosaics, size_t threads);
+
+}
+}
+
+#endif /* MOSAIC_KERNELS_H_ */
@@ -0,0 +1,106 @@
+/*!
+ * @file 		mosaic_test.cpp
+ * @author 		agent <agent@local>
+ * @date 		18.10.2026
+ * @copyright	Institute of Intermedia, CTU in Prague, 2026
+ * 				Distributed under modified BSD Licence, details in file doc/LICENSE
+ *
+ */
+
+#include "tests/catch.hpp"
+#include "mosaic_kernels.h"
+#include <cmath>
+#include <algorithm>
+
+namespace yuri {
+namespace mosaic {
+
+namespace {
+
+/*!
+ * Straightforward implementation, averaging every tile separately
+ * and testing every pixel against the circle.
+ */
+void reference_mosaic(const uint8_t* data_in, uint8_t* data_out, size_t linesize, size_t bpp, resolution_t res, const mosaic_detail_t& m)
+{
+	const position_t img_w = static_cast<position_t>(res.width);
+	const position_t img_h = static_cast<position_t>(res.height);
+	const position_t tile_count = 2 * m.radius / m.tile_size;
+	for (position_t tx = 0; tx <= tile_count; ++tx) {
+		for (position_t ty = 0; ty <= tile_count; ++ty) {
+			const position_t cx = m.center.x - m.radius + tx * m.tile_size;
+			const position_t cy = m.center.y - m.radius + ty * m.tile_size;
+			const position_t x0 = std::max<position_t>(cx, 0), x1 = std::min<position_t>(cx + m.tile_size, img_w);
+			const position_t y0 = std::max<position_t>(cy, 0), y1 = std::min<position_t>(cy + m.tile_size, img_h);
+			if (x1 <= x0 || y1 <= y0) continue;
+			std::vector<size_t> vals(bpp, 0);
+			for (position_t y = y0; y < y1; ++y) {
+				for (position_t x = x0; x < x1; ++x) {
+					for (size_t i = 0; i < bpp; ++i) vals[i] += data_in[y * linesize + x * bpp + i];
+				}
+			}
+			const size_t count = (x1 - x0) * (y1 - y0);
+			for (position_t y = y0; y < y1; ++y) {
+				for (position_t x = x0; x < x1; ++x) {
+					const position_t dx = x - m.center.x, dy = y - m.center.y;
+					if (static_cast<position_t>(std::sqrt(dx * dx + dy * dy)) > m.radius) continue;
+					for (size_t i = 0; i < bpp; ++i) data_out[y * linesize + x * bpp + i] = static_cast<uint8_t>(vals[i] / count);
+				}
+			}
+		}
+	}
+}
+
+std::vector<uint8_t> make_image(size_t size)
+{
+	std::vector<uint8_t> img(size);
+	uint8_t val = 17;
+	for (auto& v: img) {
+		v = val;
+		val = static_cast<uint8_t>(val * 31 + 11);
+	}
+	return img;
+}
+
+}
+
+TEST_CASE( "mosaic kernels", "[module]" ) {
+	const resolution_t res{157, 93};
+	const std::vector<mosaic_detail_t> mosaics = {
+			{30, 8, {40, 40}},
+			{17, 5, {150, 5}},
+			{25, 16, {-10, 80}},
+			{10, 3, {100, 60}},
+	};
+	for (size_t bpp = 1; bpp <= 4; ++bpp) {
+		const size_t linesize = res.width * bpp;
+		const auto input = make_image(linesize * res.height);
+		auto expected = input;
+		for (const auto& m: mosaics) {
+			reference_mosaic(input.data(), expected.data(), linesize, bpp, res, m);
+		}
+		for (size_t threads: {1, 3}) {
+			auto output = input;
+			apply_mosaics(input.data(), output.data(), linesize, bpp, res, mosaics, threads);
+			REQUIRE( output == expected );
+		}
+	}
+
+	SECTION("overlapping mosaics in place") {
+		const std::vector<mosaic_detail_t> overlapping = {
+				{30, 8, {40, 40}},
+				{20, 6, {60, 50}},
+		};
+		const size_t linesize = res.width * 3;
+		auto expected = make_image(linesize * res.height);
+		auto output = expected;
+		for (const auto& m: overlapping) {
+			reference_mosaic(expected.data(), expected.data(), linesize, 3, res, m);
+		}
+		apply_mosaics(output.data(), output.data(), linesize, 3, res, overlapping, 4);
+		REQUIRE( output == expected );
+	}
+}
+
+}
+}
@@ -0,0 +1,133 @@
+/*!
+ * @file 		TSDemuxer.cpp
+ * @author 		agent <agent@local>
+ * @date 		18.10.2026
+ * @copyright	Institute of Intermedia, CTU in Prague, 2026
+ * 				Distributed under modified BSD Licence, details in file doc/LICENSE
+ *
+ */
+
+#include "TSDemuxer.h"
+#include "yuri/core/Module.h"
+#include "yuri/core/socket/DatagramSocketGenerator.h"
+
+namespace yuri {
+namespace mpegts {
+
+IOTHREAD_GENERATOR(TSDemuxer)
+
+core::Parameters TSDemuxer::configure()
+{
+    core::Parameters p = core::IOThread::configure();
+    p.set_description("Native MPEG-TS demuxer. Outputs H.264, H.265, MPEG 2 video and AAC streams.");
+    p["program"]["Program number to demux, 0 for the first program"]                                     = 0;
+    p["packet_size"]["Size of TS packets, 188 for normal streams or 192 for M2TS"]                         = 188;
+    p["max_video"]["Number of video outputs"]                                                              = 1;
+    p["max_audio"]["Number of audio outputs (after video outputs)"]                                        = 1;
+    p["socket_type"]["Socket to receive the stream from, when port is set"]                               = "yuri_udp";
+    p["address"]["Address to bind to"]                                                                     = "0.0.0.0";
+    p["port"]["Port to receive the stream on. Set to 0 to read TS from input frames"]                     = 0;
+    p["rtp"]["Datagrams contain RTP packets with TS payload"]                                              = false;
+    return p;
+}
+
+TSDemuxer::TSDemuxer(const log::Log& log_, core::pwThreadBase parent, const core::Parameters& parameters)
+    : core::IOThread(log_, parent, 1, 2, std::string("ts_demuxer")),
+      program_(0),
+      packet_size_(ts_packet_size),
+      max_video_(1),
+      max_audio_(1),
+      socket_type_("yuri_udp"),
+      address_("0.0.0.0"),
+      port_(0),
+      rtp_(false)
+{
+    IOTHREAD_INIT(parameters)
+    resize(port_ ? 0 : 1, max_video_ + max_audio_);
+    parser_ = make_unique<TSParser>(
+        log, [this](const ts_stream_t& stream, core::pCompressedVideoFrame frame) { push_stream_frame(stream, std::move(frame)); }, program_,
+        packet_size_);
+}
+
+TSDemuxer::~TSDemuxer() noexcept
+{
+}
+
+void TSDemuxer::run()
+{
+    if (port_) {
+        receive_from_socket();
+    } else {
+        core::IOThread::run();
+    }
+    parser_->flush();
+    log_stats();
+}
+
+bool TSDemuxer::step()
+{
+    while (auto frame = std::dynamic_pointer_cast<core::CompressedVideoFrame>(pop_frame(0))) {
+        parser_->parse(frame->data(), frame->size());
+    }
+    return true;
+}
+
+void TSDemuxer::receive_from_socket()
+{
+    log[log::info] << "Initializing socket of type '" << socket_type_ << "'";
+    socket_ = core::DatagramSocketGenerator::get_instance().generate(socket_type_, log, "");
+    if (!socket_->bind(address_, port_)) {
+        log[log::fatal] << "Failed to bind socket!";
+        request_end(core::yuri_exit_interrupted);
+        return;
+    }
+    core::socket::DatagramBatch datagrams;
+    while (still_running()) {
+        if (!socket_->wait_for_data(get_latency()))
+            continue;
+        const auto count = datagrams.receive(*socket_);
+        for (size_t i = 0; i < count; ++i) {
+            const auto& d      = datagrams[i];
+            const auto  offset = rtp_ ? rtp_payload_offset(d.data, d.size) : 0;
+            if (rtp_ && !offset)
+                continue;
+            parser_->parse(d.data + offset, d.size - offset);
+        }
+    }
+}
+
+void TSDemuxer::push_stream_frame(const ts_stream_t& stream, core::pCompressedVideoFrame frame)
+{
+    if (stream.audio) {
+        if (stream.index < max_audio_)
+            push_frame(max_video_ + stream.index, std::move(frame));
+    } else if (stream.index < max_video_) {
+        push_frame(stream.index, std::move(frame));
+    }
+}
+
+void TSDemuxer::log_stats()
+{
+    const auto& stats = parser_->get_stats();
+    log[log::info] << "Processed " << stats.packets << " packets, " << stats.pes_packets << " PES packets (" << stats.dropped_pes << " dropped). "
+                   << stats.sync_losses << " sync losses (" << stats.skipped_bytes << " bytes skipped), " << stats.cc_errors
+                   << " continuity errors, " << stats.transport_errors << " transport errors, " << stats.crc_errors << " CRC errors";
+}
+
+bool TSDemuxer::set_param(const core::Parameter& param)
+{
+    if (assign_parameters(param)          //
+        (program_, "program")             //
+        (packet_size_, "packet_size")     //
+        (max_video_, "max_video")         //
+        (max_audio_, "max_audio")         //
+        (socket_type_, "socket_type")     //
+        (address_, "address")             //
+        (port_, "port")                   //
+        (rtp_, "rtp"))
+        return true;
+    return core::IOThread::set_param(param);
+}
+
+} /* namespace mpegts */
+} /* namespace yuri */
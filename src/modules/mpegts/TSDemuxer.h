@@ -0,0 +1,55 @@
+/*!
+ * @file 		TSDemuxer.h
+ * @author 		agent <agent@local>
+ * @date 		18.10.2026
+ * @copyright	Institute of Intermedia, CTU in Prague, 2026
+ * 				Distributed under modified BSD Licence, details in file doc/LICENSE
+ *
+ */
+
+#ifndef SRC_MODULES_MPEGTS_TSDEMUXER_H_
+#define SRC_MODULES_MPEGTS_TSDEMUXER_H_
+
+#include "TSParser.h"
+#include "yuri/core/thread/IOThread.h"
+#include "yuri/core/socket/DatagramSocket.h"
+
+namespace yuri {
+namespace mpegts {
+
+/*!
+ * Demuxes MPEG transport stream either from input frames (format mpeg2ts)
+ * or received directly from a datagram socket (optionally in RTP packets).
+ * Video streams are sent to first @em max_video outputs, audio streams to following @em max_audio outputs.
+ */
+class TSDemuxer : public core::IOThread {
+public:
+    IOTHREAD_GENERATOR_DECLARATION
+    static core::Parameters configure();
+    TSDemuxer(const log::Log& log_, core::pwThreadBase parent, const core::Parameters& parameters);
+    virtual ~TSDemuxer() noexcept;
+
+private:
+    virtual void run() override;
+    virtual bool step() override;
+    virtual bool set_param(const core::Parameter& param) override;
+
+    void receive_from_socket();
+    void push_stream_frame(const ts_stream_t& stream, core::pCompressedVideoFrame frame);
+    void log_stats();
+
+    uint16_t                                      program_;
+    size_t                                        packet_size_;
+    size_t                                        max_video_;
+    size_t                                        max_audio_;
+    std::string                                   socket_type_;
+    std::string                                   address_;
+    uint16_t                                      port_;
+    bool                                          rtp_;
+    std::shared_ptr<core::socket::DatagramSocket> socket_;
+    std::unique_ptr<TSParser>                     parser_;
+};
+
+} /* namespace mpegts */
+} /* namespace yuri */
+#endif /* SRC_MODULES_MPEGTS_TSDEMUXER_H_ */
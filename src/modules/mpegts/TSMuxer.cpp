@@ -0,0 +1,377 @@
+/*!
+ * @file 		TSMuxer.cpp
+ * @author 		agent <agent@local>
+ * @date 		19.10.2026
+ * @copyright	Institute of Intermedia, CTU in Prague, 2026
+ * 				Distributed under modified BSD Licence, details in file doc/LICENSE
+ *
+ */
+
+#include "TSMuxer.h"
+#include <algorithm>
+#include <cstring>
+
+namespace yuri {
+namespace mpegts {
+
+namespace {
+constexpr size_t  pes_header_size     = 14;
+//! Size of PES header with both PTS and DTS
+constexpr size_t  pes_header_size_dts = 19;
+constexpr size_t  max_streams     = 32;
+constexpr int64_t pcr_clock       = ts_clock * 300;
+
+void write_header(uint8_t* packet, uint16_t pid, bool start, uint8_t control, uint8_t cc)
+{
+    packet[0] = ts_sync_byte;
+    packet[1] = static_cast<uint8_t>((start ? 0x40 : 0x00) | ((pid >> 8) & 0x1F));
+    packet[2] = static_cast<uint8_t>(pid & 0xFF);
+    packet[3] = static_cast<uint8_t>((control << 4) | (cc & 0x0F));
+}
+
+//! Writes adaptation field of @em size bytes (including the length byte)
+void write_adaptation(uint8_t* data, size_t size, uint8_t flags)
+{
+    data[0] = static_cast<uint8_t>(size - 1);
+    if (size > 1) {
+        data[1] = flags;
+        std::fill(data + 2, data + size, 0xFF);
+    }
+}
+}
+
+TSMuxer::TSMuxer(const log::Log& log_, uint16_t program, uint16_t pmt_pid, uint16_t first_pid)
+    : log(log_),
+      program_(program),
+      pmt_pid_(pmt_pid),
+      first_pid_(first_pid),
+      rate_(0),
+      delay_(ts_clock / 2),
+      psi_interval_(ts_clock / 10),
+      pcr_interval_(ts_clock * 3 / 100),
+      pcr_stream_(0),
+      pat_cc_(0),
+      pmt_cc_(0),
+      pmt_version_(0),
+      pmt_sent_(false),
+      started_(false),
+      clock_(0),
+      clock_base_(0),
+      packets_since_base_(0),
+      last_psi_(0),
+      last_pcr_(0),
+      partial_packets_(0),
+      partial_clock_(0)
+{
+    buffer_.reserve(64 * ts_packets_per_datagram * ts_packet_size);
+}
+
+void TSMuxer::set_mux_rate(uint64_t rate)
+{
+    // Clock continues from current value with the new rate
+    clock_base_         = clock_;
+    packets_since_base_ = 0;
+    rate_               = rate;
+}
+
+int TSMuxer::add_stream(format_t format)
+{
+    const auto type = stream_type_from_format(format);
+    if (!type || streams_.size() >= max_streams) {
+        log[log::warning] << "Can't add stream with format " << format;
+        return -1;
+    }
+    const bool audio = is_audio_stream_type(type);
+    uint8_t    index = 0;
+    for (const auto& s : streams_) {
+        if (is_audio_stream_type(s.stream_type) == audio)
+            ++index;
+    }
+    streams_.push_back({ static_cast<uint16_t>(first_pid_ + streams_.size()), type, static_cast<uint8_t>((audio ? 0xC0 : 0xE0) + index), 0 });
+    log[log::info] << "Added " << (audio ? "audio" : "video") << " stream with PID " << streams_.back().pid;
+    if (!audio && is_audio_stream_type(streams_[pcr_stream_].stream_type)) {
+        pcr_stream_ = streams_.size() - 1;
+    }
+    if (pmt_sent_) {
+        // Changed PMT has to be sent as soon as possible
+        pmt_version_ = (pmt_version_ + 1) & 0x1F;
+        last_psi_    = clock_ - psi_interval_;
+        last_pcr_    = clock_ - pcr_interval_;
+    }
+    return static_cast<int>(streams_.size() - 1);
+}
+
+void TSMuxer::start(int64_t clock)
+{
+    if (started_)
+        return;
+    started_            = true;
+    clock_              = clock;
+    clock_base_         = clock;
+    packets_since_base_ = 0;
+    last_psi_           = clock - psi_interval_;
+    last_pcr_           = clock - pcr_interval_;
+}
+
+int64_t DtsGenerator::next(int64_t pts, int64_t duration)
+{
+    if (!reorder_)
+        return pts;
+    if (!frames_)
+        first_pts_ = pts;
+    pending_.push(pts);
+    int64_t dts;
+    if (pending_.size() > reorder_) {
+        dts = pending_.top();
+        pending_.pop();
+    } else {
+        dts = first_pts_ - static_cast<int64_t>(reorder_ - frames_) * duration;
+    }
+    // Frames reordered more than expected would break the order of DTS
+    if (frames_ && dts <= last_dts_)
+        dts = last_dts_ + 1;
+    ++frames_;
+    last_dts_ = dts;
+    return dts;
+}
+
+void TSMuxer::write_frame(size_t stream, const uint8_t* data, size_t size, int64_t pts, int64_t dts, bool random_access)
+{
+    if (stream >= streams_.size())
+        return;
+    start(dts - delay_);
+    if (rate_) {
+        fill(dts - delay_);
+    } else {
+        clock_ = std::max(clock_, dts - delay_);
+    }
+    auto& s = streams_[stream];
+
+    const bool has_dts                     = dts != pts;
+    const auto header_size                 = has_dts ? pes_header_size_dts : pes_header_size;
+    uint8_t    header[pes_header_size_dts] = { 0, 0, 1, s.stream_id, 0, 0, 0x84, 0x80, 5 };
+    const auto pes_length                  = header_size - 6 + size;
+    // Video PES packets may be unbounded
+    if (pes_length <= 0xFFFF || is_audio_stream_type(s.stream_type)) {
+        header[4] = static_cast<uint8_t>(pes_length > 0xFFFF ? 0 : pes_length >> 8);
+        header[5] = static_cast<uint8_t>(pes_length > 0xFFFF ? 0 : pes_length & 0xFF);
+    }
+    if (has_dts) {
+        header[7] = 0xC0;
+        header[8] = 10;
+        write_pes_timestamp(header + 9, 3, pts % pts_wrap);
+        write_pes_timestamp(header + 14, 1, dts % pts_wrap);
+    } else {
+        write_pes_timestamp(header + 9, 2, pts % pts_wrap);
+    }
+
+    size_t     offset = 0;
+    const auto total  = header_size + size;
+    while (offset < total) {
+        write_tables();
+        const bool start      = offset == 0;
+        const auto remaining  = total - offset;
+        size_t     adaptation = start && random_access ? 2 : 0;
+        if (remaining < ts_packet_size - 4 - adaptation) {
+            adaptation = ts_packet_size - 4 - remaining;
+        }
+        const auto payload_size = ts_packet_size - 4 - adaptation;
+
+        auto packet = next_packet();
+        write_header(packet, s.pid, start, adaptation ? 0x3 : 0x1, s.cc++);
+        if (adaptation)
+            write_adaptation(packet + 4, adaptation, start && random_access ? 0x40 : 0x00);
+        auto out  = packet + 4 + adaptation;
+        auto left = payload_size;
+        if (offset < header_size) {
+            const auto count = std::min(header_size - offset, left);
+            std::copy(header + offset, header + offset + count, out);
+            out += count;
+            left -= count;
+            offset += count;
+        }
+        std::copy(data + offset - header_size, data + offset - header_size + left, out);
+        offset += left;
+    }
+    ++stats_.frames;
+    if (rate_ && clock_ > dts) {
+        ++stats_.late_frames;
+    }
+    if (partial_packets_ == ts_packets_per_datagram)
+        finish_datagram();
+}
+
+void TSMuxer::fill(int64_t clock)
+{
+    if (!rate_)
+        return;
+    start(clock);
+    while (clock_ < clock) {
+        write_tables();
+        if (clock_ < clock)
+            write_null();
+    }
+    if (partial_packets_ == ts_packets_per_datagram)
+        finish_datagram();
+}
+
+void TSMuxer::flush()
+{
+    if (!partial_packets_)
+        return;
+    while (rate_ && partial_packets_ < ts_packets_per_datagram) {
+        write_null();
+    }
+    finish_datagram();
+}
+
+ts_datagram_t TSMuxer::get_datagram(size_t index) const
+{
+    const auto& info = datagrams_[index];
+    return { buffer_.data() + info.offset, info.size, info.clock };
+}
+
+void TSMuxer::remove_datagrams(size_t count)
+{
+    count = std::min(count, datagrams_.size());
+    datagrams_.erase(datagrams_.begin(), datagrams_.begin() + count);
+    const auto start = datagrams_.empty() ? buffer_.size() - partial_packets_ * ts_packet_size : datagrams_.front().offset;
+    // Moving the data to the front of the buffer is cheap when there's only a partial datagram left
+    if (datagrams_.empty() || start > buffer_.size() / 2) {
+        buffer_.erase(buffer_.begin(), buffer_.begin() + start);
+        for (auto& d : datagrams_) {
+            d.offset -= start;
+        }
+    }
+}
+
+uint8_t* TSMuxer::next_packet()
+{
+    if (partial_packets_ == ts_packets_per_datagram)
+        finish_datagram();
+    if (!partial_packets_)
+        partial_clock_ = clock_;
+    ++partial_packets_;
+    buffer_.resize(buffer_.size() + ts_packet_size);
+    ++stats_.packets;
+    ++packets_since_base_;
+    if (rate_) {
+        // Start of the next packet, computed from packet count to avoid accumulating rounding errors
+        const auto bits = packets_since_base_ * ts_packet_size * 8;
+        clock_ = clock_base_ + static_cast<int64_t>((bits / rate_) * ts_clock + (bits % rate_) * ts_clock / rate_);
+    }
+    return &buffer_[buffer_.size() - ts_packet_size];
+}
+
+void TSMuxer::write_tables()
+{
+    if (clock_ - last_psi_ >= psi_interval_) {
+        last_psi_ = clock_;
+        write_pat();
+        write_pmt();
+    }
+    if (!streams_.empty() && clock_ - last_pcr_ >= pcr_interval_) {
+        last_pcr_ = clock_;
+        write_pcr();
+    }
+}
+
+void TSMuxer::write_pcr()
+{
+    int64_t pcr = clock_ * 300;
+    if (rate_) {
+        const auto bits = packets_since_base_ * ts_packet_size * 8;
+        pcr = clock_base_ * 300 + static_cast<int64_t>((bits / rate_) * pcr_clock + (bits % rate_) * pcr_clock / rate_);
+    }
+    const auto base   = (pcr / 300) % pts_wrap;
+    const auto ext    = pcr % 300;
+    const auto& s     = streams_[pcr_stream_];
+    auto packet       = next_packet();
+    // Packet without payload doesn't increment continuity counter
+    write_header(packet, s.pid, false, 0x2, static_cast<uint8_t>(s.cc - 1));
+    write_adaptation(packet + 4, ts_packet_size - 4, 0x10);
+    packet[6]  = static_cast<uint8_t>(base >> 25);
+    packet[7]  = static_cast<uint8_t>(base >> 17);
+    packet[8]  = static_cast<uint8_t>(base >> 9);
+    packet[9]  = static_cast<uint8_t>(base >> 1);
+    packet[10] = static_cast<uint8_t>(((base & 1) << 7) | 0x7E | (ext >> 8));
+    packet[11] = static_cast<uint8_t>(ext & 0xFF);
+    ++stats_.pcr_packets;
+}
+
+void TSMuxer::write_section(uint16_t pid, uint8_t& cc, const uint8_t* section, size_t size)
+{
+    auto packet = next_packet();
+    write_header(packet, pid, true, 0x1, cc++);
+    packet[4] = 0; // pointer field
+    std::copy(section, section + size, packet + 5);
+    const auto crc = crc32_mpeg(section, size);
+    for (int i = 0; i < 4; ++i) {
+        packet[5 + size + i] = static_cast<uint8_t>(crc >> (24 - 8 * i));
+    }
+    std::fill(packet + 9 + size, packet + ts_packet_size, 0xFF);
+    ++stats_.psi_packets;
+}
+
+void TSMuxer::write_pat()
+{
+    const uint8_t section[] = { 0x00,
+                                0xB0,
+                                13,
+                                0x00,
+                                0x01,
+                                0xC1,
+                                0x00,
+                                0x00,
+                                static_cast<uint8_t>(program_ >> 8),
+                                static_cast<uint8_t>(program_ & 0xFF),
+                                static_cast<uint8_t>(0xE0 | (pmt_pid_ >> 8)),
+                                static_cast<uint8_t>(pmt_pid_ & 0xFF) };
+    write_section(pat_pid, pat_cc_, section, sizeof(section));
+}
+
+void TSMuxer::write_pmt()
+{
+    uint8_t    section[ts_packet_size];
+    const auto pcr_pid    = streams_.empty() ? null_pid : streams_[pcr_stream_].pid;
+    const auto length     = 13 + 5 * streams_.size();
+    section[0]            = 0x02;
+    section[1]            = static_cast<uint8_t>(0xB0 | (length >> 8));
+    section[2]            = static_cast<uint8_t>(length & 0xFF);
+    section[3]            = static_cast<uint8_t>(program_ >> 8);
+    section[4]            = static_cast<uint8_t>(program_ & 0xFF);
+    section[5]            = static_cast<uint8_t>(0xC1 | (pmt_version_ << 1));
+    section[6]            = 0x00;
+    section[7]            = 0x00;
+    section[8]            = static_cast<uint8_t>(0xE0 | (pcr_pid >> 8));
+    section[9]            = static_cast<uint8_t>(pcr_pid & 0xFF);
+    section[10]           = 0xF0;
+    section[11]           = 0x00;
+    size_t offset         = 12;
+    for (const auto& s : streams_) {
+        section[offset++] = s.stream_type;
+        section[offset++] = static_cast<uint8_t>(0xE0 | (s.pid >> 8));
+        section[offset++] = static_cast<uint8_t>(s.pid & 0xFF);
+        section[offset++] = 0xF0;
+        section[offset++] = 0x00;
+    }
+    write_section(pmt_pid_, pmt_cc_, section, offset);
+    pmt_sent_ = true;
+}
+
+void TSMuxer::write_null()
+{
+    auto packet = next_packet();
+    write_header(packet, null_pid, false, 0x1, 0);
+    std::fill(packet + 4, packet + ts_packet_size, 0xFF);
+    ++stats_.null_packets;
+}
+
+void TSMuxer::finish_datagram()
+{
+    const auto size = partial_packets_ * ts_packet_size;
+    datagrams_.push_back({ buffer_.size() - size, size, partial_clock_ });
+    partial_packets_ = 0;
+}
+}
+}
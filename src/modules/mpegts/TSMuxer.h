@@ -0,0 +1,194 @@
+/*!
+ * @file 		TSMuxer.h
+ * @author 		agent <agent@local>
+ * @date 		19.10.2026
+ * @copyright	Institute of Intermedia, CTU in Prague, 2026
+ * 				Distributed under modified BSD Licence, details in file doc/LICENSE
+ *
+ */
+
+#ifndef SRC_MODULES_MPEGTS_TSMUXER_H_
+#define SRC_MODULES_MPEGTS_TSMUXER_H_
+
+#include "ts_common.h"
+#include "yuri/log/Log.h"
+#include <functional>
+#include <queue>
+#include <vector>
+
+namespace yuri {
+namespace mpegts {
+
+//! Datagram of TS packets produced by TSMuxer
+struct ts_datagram_t {
+    const uint8_t* data;
+    size_t         size;
+    //! Mux clock (90kHz) of the first packet, i.e. the time the datagram should be sent at
+    int64_t        clock;
+};
+
+struct ts_muxer_stats_t {
+    size_t packets      = 0;
+    size_t null_packets = 0;
+    size_t pcr_packets  = 0;
+    size_t psi_packets  = 0;
+    size_t frames       = 0;
+    //! Frames that were not completely sent before their DTS, because of too low mux rate
+    size_t late_frames  = 0;
+};
+
+/*!
+ * Derives DTS for frames passed in decoding order with PTS only.
+ *
+ * DTS of a frame is the lowest PTS that was not used as DTS yet, once more than
+ * @em reorder frames are pending, so it never exceeds PTS of the frame.
+ * The first @em reorder frames get DTS preceding PTS of the first frame by whole frame durations.
+ * With @em reorder 0, DTS is the same as PTS.
+ */
+class DtsGenerator {
+public:
+    //! @param reorder	Maximal number of frames decoded before a frame with lower PTS (e.g. B-frames)
+    DtsGenerator(size_t reorder = 0) : reorder_(reorder), frames_(0), first_pts_(0), last_dts_(0) {}
+    //! Returns DTS for next frame, @em duration is used only for the first frames
+    int64_t next(int64_t pts, int64_t duration);
+
+private:
+    size_t                                                                    reorder_;
+    std::priority_queue<int64_t, std::vector<int64_t>, std::greater<int64_t>> pending_;
+    size_t                                                                    frames_;
+    int64_t                                                                   first_pts_;
+    int64_t                                                                   last_dts_;
+};
+
+/*!
+ * Multiplexer of a single program MPEG transport stream.
+ *
+ * Writes PAT, PMT, PCR and PES packets directly into datagrams of 7 TS packets.
+ *
+ * Output is timed by a 90kHz mux clock. With a mux rate set, the clock advances
+ * with every written packet and gaps are filled with null packets (CBR). Frames are
+ * written once the clock reaches their DTS minus delay, so the datagrams can be sent
+ * at times given by their clock. Without mux rate the stream is VBR and the clock
+ * follows DTS of written frames.
+ */
+class TSMuxer {
+public:
+    /*!
+     * @param program		Program number
+     * @param pmt_pid		PID of PMT
+     * @param first_pid		PID of the first elementary stream, following streams get next PIDs
+     */
+    TSMuxer(const log::Log& log_, uint16_t program = 1, uint16_t pmt_pid = 0x1000, uint16_t first_pid = 0x100);
+
+    //! Sets mux rate in bits per second, 0 for VBR stream without stuffing
+    void set_mux_rate(uint64_t rate);
+    //! Sets time (90kHz) between PTS of a frame and the time it's written to the stream
+    void set_delay(int64_t delay) { delay_ = delay; }
+    //! Sets intervals (90kHz) for repeating PAT/PMT and PCR
+    void set_psi_interval(int64_t interval) { psi_interval_ = interval; }
+    void set_pcr_interval(int64_t interval) { pcr_interval_ = interval; }
+
+    /*!
+     * Adds elementary stream to the program. PMT version is incremented if the stream is added
+     * after PMT was already sent. First video stream (or first stream if there's no video) carries PCR.
+     * @return index of the stream or -1 for unsupported format
+     */
+    int add_stream(format_t format);
+    size_t get_stream_count() const { return streams_.size(); }
+
+    /*!
+     * Writes a frame as a single PES packet.
+     * @param stream	Index of stream returned by add_stream()
+     * @param pts		Presentation timestamp (90kHz, not wrapped)
+     * @param random_access	Frame can be decoded without preceding frames
+     */
+    void write_frame(size_t stream, const uint8_t* data, size_t size, int64_t pts, bool random_access = false)
+    {
+        write_frame(stream, data, size, pts, pts, random_access);
+    }
+    /*!
+     * Writes a frame as a single PES packet, with decoding timestamp.
+     * Frames have to be written in decoding order, the mux clock follows their DTS.
+     * @param dts		Decoding timestamp (90kHz, not wrapped), written only if it differs from @em pts
+     */
+    void write_frame(size_t stream, const uint8_t* data, size_t size, int64_t pts, int64_t dts, bool random_access);
+
+    /*!
+     * Fills CBR stream with null packets (and PSI and PCR when due) until the mux clock reaches @em clock.
+     * Does nothing for VBR stream.
+     */
+    void fill(int64_t clock);
+
+    //! Completes partial datagram, filling it with null packets for CBR stream
+    void flush();
+
+    //! Returns current mux clock (90kHz)
+    int64_t get_clock() const { return clock_; }
+    bool    is_started() const { return started_; }
+
+    //! Returns number of completed datagrams
+    size_t        get_datagram_count() const { return datagrams_.size(); }
+    ts_datagram_t get_datagram(size_t index) const;
+    //! Removes first @em count completed datagrams
+    void          remove_datagrams(size_t count);
+
+    const ts_muxer_stats_t& get_stats() const { return stats_; }
+    void                    reset_stats() { stats_ = ts_muxer_stats_t{}; }
+
+private:
+    struct stream_t {
+        uint16_t pid;
+        uint8_t  stream_type;
+        uint8_t  stream_id;
+        uint8_t  cc;
+    };
+    struct datagram_info_t {
+        size_t  offset;
+        size_t  size;
+        int64_t clock;
+    };
+
+    //! Initializes mux clock, if it's not running yet
+    void     start(int64_t clock);
+    //! Returns space for next packet and advances the clock
+    uint8_t* next_packet();
+    //! Writes PSI and PCR packets if they're due
+    void     write_tables();
+    void     write_pcr();
+    void     write_section(uint16_t pid, uint8_t& cc, const uint8_t* section, size_t size);
+    void     write_null();
+    void     write_pat();
+    void     write_pmt();
+    void     finish_datagram();
+
+    log::Log                     log;
+    uint16_t                     program_;
+    uint16_t                     pmt_pid_;
+    uint16_t                     first_pid_;
+    uint64_t                     rate_;
+    int64_t                      delay_;
+    int64_t                      psi_interval_;
+    int64_t                      pcr_interval_;
+    std::vector<stream_t>        streams_;
+    size_t                       pcr_stream_;
+    uint8_t                      pat_cc_;
+    uint8_t                      pmt_cc_;
+    uint8_t                      pmt_version_;
+    bool                         pmt_sent_;
+    bool                         started_;
+    int64_t                      clock_;
+    int64_t                      clock_base_;
+    uint64_t                     packets_since_base_;
+    int64_t                      last_psi_;
+    int64_t                      last_pcr_;
+    //! Completed datagrams followed by the partial one
+    std::vector<uint8_t>         buffer_;
+    std::vector<datagram_info_t> datagrams_;
+    size_t                       partial_packets_;
+    int64_t                      partial_clock_;
+    ts_muxer_stats_t             stats_;
+};
+}
+}
+
+#endif /* SRC_MODULES_MPEGTS_TSMUXER_H_ */
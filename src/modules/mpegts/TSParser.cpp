@@ -0,0 +1,475 @@
+/*!
+ * @file 		TSParser.cpp
+ * @author 		agent <agent@local>
+ * @date 		18.10.2026
+ * @copyright	Institute of Intermedia, CTU in Prague, 2026
+ * 				Distributed under modified BSD Licence, details in file doc/LICENSE
+ *
+ */
+
+#include "TSParser.h"
+#include <cstring>
+
+namespace yuri {
+namespace mpegts {
+
+namespace {
+//! Initial size of PES buffers, they grow to the size of the largest PES packet
+constexpr size_t initial_pes_size = 64 * 1024;
+constexpr size_t npos             = static_cast<size_t>(-1);
+
+uint16_t read_be16(const uint8_t* data)
+{
+    return static_cast<uint16_t>((data[0] << 8) | data[1]);
+}
+}
+
+PesBufferPool::PesBufferPool(size_t block_size, size_t max_free) : block_size_(block_size), max_free_(max_free)
+{
+    free_.reserve(max_free_);
+}
+
+PesBufferPool::~PesBufferPool() noexcept
+{
+    for (auto& b : free_) {
+        delete[] b.first;
+    }
+}
+
+uint8_t* PesBufferPool::get(size_t size, size_t& capacity)
+{
+    {
+        lock_t _(mutex_);
+        block_size_ = std::max(block_size_, size);
+        while (!free_.empty()) {
+            auto b = free_.back();
+            free_.pop_back();
+            if (b.second >= size) {
+                capacity = b.second;
+                return b.first;
+            }
+            delete[] b.first;
+        }
+        capacity = block_size_;
+    }
+    return new uint8_t[capacity];
+}
+
+void PesBufferPool::put(uint8_t* buffer, size_t capacity) noexcept
+{
+    try {
+        lock_t _(mutex_);
+        // Buffers smaller than current block size would have to be reallocated anyway
+        if (capacity >= block_size_ && free_.size() < max_free_) {
+            free_.emplace_back(buffer, capacity);
+            return;
+        }
+    } catch (...) {
+    }
+    delete[] buffer;
+}
+
+core::pCompressedVideoFrame PesBufferPool::make_frame(format_t format, uint8_t* buffer, size_t capacity, size_t size)
+{
+    auto frame = core::CompressedVideoFrame::create_empty(format, resolution_t{ 0, 0 });
+    std::weak_ptr<PesBufferPool> pool = shared_from_this();
+    frame->get_data().set(buffer, size, [pool, capacity](void* mem) noexcept {
+        auto data = static_cast<uint8_t*>(mem);
+        if (auto p = pool.lock()) {
+            p->put(data, capacity);
+        } else {
+            delete[] data;
+        }
+    });
+    return frame;
+}
+
+size_t PesBufferPool::get_block_size() const
+{
+    lock_t _(mutex_);
+    return block_size_;
+}
+
+TSParser::TSParser(const log::Log& log_, frame_callback_t callback, uint16_t program, size_t packet_size)
+    : log(log_),
+      callback_(std::move(callback)),
+      program_(program),
+      packet_size_(std::max(packet_size, ts_packet_size)),
+      prefix_size_(packet_size_ - ts_packet_size),
+      pids_(8192),
+      pmt_pid_(null_pid),
+      pmt_version_(-1),
+      carry_size_(0),
+      has_pts_(false),
+      first_pts_(0),
+      last_pts_(0),
+      pts_offset_(0)
+{
+    log.set_label("[TS] ");
+    if (packet_size_ > carry_.size()) {
+        log[log::warning] << "Unsupported packet size " << packet_size_ << ", using " << ts_packet_size;
+        packet_size_ = ts_packet_size;
+        prefix_size_ = 0;
+    }
+    pids_[pat_pid].kind = pid_kind_t::pat;
+    pat_section_.data.reserve(1024);
+    pmt_section_.data.reserve(1024);
+}
+
+TSParser::~TSParser() noexcept
+{
+    for (auto& pes : pes_) {
+        release_pes(pes);
+    }
+}
+
+void TSParser::parse(const uint8_t* data, size_t size)
+{
+    if (carry_size_) {
+        // Complete the packet split between calls
+        const auto missing = std::min(packet_size_ - carry_size_, size);
+        std::copy(data, data + missing, carry_.data() + carry_size_);
+        carry_size_ += missing;
+        data += missing;
+        size -= missing;
+        if (carry_size_ < packet_size_)
+            return;
+        carry_size_ = 0;
+        if (carry_[prefix_size_] == ts_sync_byte) {
+            process_packet(carry_.data() + prefix_size_);
+        } else {
+            ++stats_.sync_losses;
+            stats_.skipped_bytes += packet_size_;
+        }
+    }
+    while (size >= packet_size_) {
+        // Sync byte of the following packet is checked as well, to catch false sync in garbage
+        if (data[prefix_size_] != ts_sync_byte || (size >= 2 * packet_size_ && data[packet_size_ + prefix_size_] != ts_sync_byte)) {
+            ++stats_.sync_losses;
+            const auto offset = find_sync(data + 1, size - 1);
+            if (offset == npos) {
+                stats_.skipped_bytes += size;
+                return;
+            }
+            stats_.skipped_bytes += offset + 1;
+            data += offset + 1;
+            size -= offset + 1;
+            continue;
+        }
+        process_packet(data + prefix_size_);
+        data += packet_size_;
+        size -= packet_size_;
+    }
+    if (size) {
+        std::copy(data, data + size, carry_.data());
+        carry_size_ = size;
+    }
+}
+
+void TSParser::flush()
+{
+    for (auto& pes : pes_) {
+        if (pes.active)
+            finish_pes(pes);
+    }
+}
+
+size_t TSParser::find_sync(const uint8_t* data, size_t size) const
+{
+    // Sync byte has to repeat in following packets, if there's enough data to verify it
+    for (size_t i = 0; i + prefix_size_ < size; ++i) {
+        if (data[i + prefix_size_] != ts_sync_byte)
+            continue;
+        bool valid = true;
+        for (size_t next = i + packet_size_ + prefix_size_; valid && next < size && next <= i + 3 * packet_size_; next += packet_size_) {
+            valid = data[next] == ts_sync_byte;
+        }
+        if (valid)
+            return i;
+    }
+    return npos;
+}
+
+void TSParser::process_packet(const uint8_t* packet)
+{
+    ++stats_.packets;
+    if (packet[1] & 0x80) {
+        ++stats_.transport_errors;
+        return;
+    }
+    const uint16_t pid   = read_be16(packet + 1) & 0x1FFF;
+    auto&          state = pids_[pid];
+    if (state.kind == pid_kind_t::none)
+        return;
+
+    const auto adaptation    = (packet[3] >> 4) & 0x03;
+    const int  cc            = packet[3] & 0x0F;
+    size_t     offset        = 4;
+    bool       discontinuity = false;
+    if (adaptation & 0x02) {
+        const size_t length = packet[4];
+        discontinuity       = length > 0 && (packet[5] & 0x80);
+        offset += 1 + length;
+    }
+    // Continuity counter increments only in packets with payload
+    if (!(adaptation & 0x01) || offset >= ts_packet_size)
+        return;
+
+    bool cc_error = false;
+    if (state.cc >= 0 && !discontinuity) {
+        if (cc == state.cc) {
+            // Duplicate packet
+            return;
+        }
+        if (cc != ((state.cc + 1) & 0x0F)) {
+            ++stats_.cc_errors;
+            cc_error = true;
+        }
+    }
+    state.cc = cc;
+
+    const bool unit_start = (packet[1] & 0x40) != 0;
+    const auto payload    = packet + offset;
+    const auto size       = ts_packet_size - offset;
+    switch (state.kind) {
+    case pid_kind_t::pat:
+        if (cc_error)
+            pat_section_.active = false;
+        process_section_payload(pat_section_, payload, size, unit_start, state.kind);
+        break;
+    case pid_kind_t::pmt:
+        if (cc_error)
+            pmt_section_.active = false;
+        process_section_payload(pmt_section_, payload, size, unit_start, state.kind);
+        break;
+    case pid_kind_t::pes: {
+        auto& pes = pes_[state.pes];
+        if (cc_error && pes.active)
+            pes.corrupted = true;
+        process_pes_payload(pes, payload, size, unit_start);
+    } break;
+    default:
+        break;
+    }
+}
+
+void TSParser::process_section_payload(section_state_t& section, const uint8_t* data, size_t size, bool unit_start, pid_kind_t kind)
+{
+    if (unit_start) {
+        const size_t pointer = data[0];
+        if (pointer + 1 > size) {
+            section.active = false;
+            return;
+        }
+        // Bytes before the pointer finish previous section
+        if (section.active && pointer) {
+            section.data.insert(section.data.end(), data + 1, data + 1 + pointer);
+            if (section.data.size() >= 3) {
+                const size_t length = 3 + (read_be16(section.data.data() + 1) & 0x0FFF);
+                if (section.data.size() >= length)
+                    process_section(section.data.data(), length, kind);
+            }
+        }
+        section.data.assign(data + 1 + pointer, data + size);
+        section.active = true;
+    } else if (section.active) {
+        section.data.insert(section.data.end(), data, data + size);
+    }
+    // There may be several sections in a packet, followed by stuffing
+    while (section.active && section.data.size() >= 3) {
+        if (section.data[0] == 0xFF) {
+            section.active = false;
+            break;
+        }
+        const size_t length = 3 + (read_be16(section.data.data() + 1) & 0x0FFF);
+        if (section.data.size() < length)
+            break;
+        process_section(section.data.data(), length, kind);
+        section.data.erase(section.data.begin(), section.data.begin() + length);
+    }
+}
+
+void TSParser::process_section(const uint8_t* data, size_t size, pid_kind_t kind)
+{
+    // Long section header (8 bytes) and CRC
+    if (size < 12 || !(data[1] & 0x80))
+        return;
+    if (crc32_mpeg(data, size) != 0) {
+        ++stats_.crc_errors;
+        return;
+    }
+    // Ignore sections that are not current yet
+    if (!(data[5] & 0x01))
+        return;
+    if (kind == pid_kind_t::pat && data[0] == 0x00) {
+        process_pat(data, size);
+    } else if (kind == pid_kind_t::pmt && data[0] == 0x02) {
+        process_pmt(data, size);
+    }
+}
+
+void TSParser::process_pat(const uint8_t* data, size_t size)
+{
+    for (size_t i = 8; i + 4 <= size - 4; i += 4) {
+        const auto program = read_be16(data + i);
+        const auto pid     = read_be16(data + i + 2) & 0x1FFF;
+        // Program 0 points to network information table
+        if (!program || (program_ && program != program_))
+            continue;
+        if (pid != pmt_pid_) {
+            if (pmt_pid_ != null_pid)
+                pids_[pmt_pid_] = pid_state_t{};
+            log[log::info] << "Found program " << program << " with PMT at PID " << pid;
+            pmt_pid_            = pid;
+            pmt_version_        = -1;
+            pmt_section_.active = false;
+            pids_[pid].kind     = pid_kind_t::pmt;
+        }
+        return;
+    }
+}
+
+void TSParser::process_pmt(const uint8_t* data, size_t size)
+{
+    const auto program = read_be16(data + 3);
+    const int  version = (data[5] >> 1) & 0x1F;
+    if ((program_ && program != program_) || version == pmt_version_)
+        return;
+    pmt_version_ = version;
+
+    // Drop streams from previous version of PMT
+    for (auto& pes : pes_) {
+        if (pes.active)
+            finish_pes(pes);
+        release_pes(pes);
+        pids_[pes.stream.pid] = pid_state_t{};
+    }
+    pes_.clear();
+    streams_.clear();
+
+    const size_t end    = size - 4;
+    size_t       offset = 12 + (read_be16(data + 10) & 0x0FFF);
+    size_t       video = 0, audio = 0;
+    while (offset + 5 <= end) {
+        const auto type        = data[offset];
+        const auto pid         = read_be16(data + offset + 1) & 0x1FFF;
+        const auto info_length = read_be16(data + offset + 3) & 0x0FFF;
+        offset += 5 + info_length;
+        const auto format = format_from_stream_type(type);
+        if (!format) {
+            log[log::debug] << "Ignoring stream at PID " << pid << " with unsupported type 0x" << std::hex << static_cast<int>(type) << std::dec;
+            continue;
+        }
+        if (pids_[pid].kind != pid_kind_t::none)
+            continue;
+        const bool  is_audio = is_audio_stream_type(type);
+        ts_stream_t stream   = { static_cast<uint16_t>(pid), type, format, is_audio, is_audio ? audio++ : video++ };
+        log[log::info] << "Found " << (is_audio ? "audio" : "video") << " stream at PID " << pid << ", type 0x" << std::hex << static_cast<int>(type)
+                       << std::dec;
+        pes_.emplace_back();
+        pes_.back().stream = stream;
+        pes_.back().pool   = std::make_shared<PesBufferPool>(initial_pes_size);
+        streams_.push_back(stream);
+        pids_[pid].kind = pid_kind_t::pes;
+        pids_[pid].pes  = pes_.size() - 1;
+    }
+}
+
+void TSParser::process_pes_payload(pes_state_t& pes, const uint8_t* data, size_t size, bool unit_start)
+{
+    if (unit_start) {
+        if (pes.active)
+            finish_pes(pes);
+        // PES header has to be in the first packet
+        if (size < 9 || data[0] != 0 || data[1] != 0 || data[2] != 1 || size < 9u + data[8]) {
+            ++stats_.dropped_pes;
+            return;
+        }
+        const size_t pes_length    = read_be16(data + 4);
+        const size_t header_length = 9 + data[8];
+        pes.pts                    = -1;
+        if ((data[7] & 0x80) && data[8] >= 5) {
+            pes.pts = read_pes_timestamp(data + 9);
+        }
+        pes.expected  = pes_length > header_length - 6 ? pes_length + 6 - header_length : 0;
+        pes.active    = true;
+        pes.corrupted = false;
+        pes.size      = 0;
+        if (!pes.buffer || pes.capacity < pes.expected) {
+            if (pes.buffer)
+                pes.pool->put(pes.buffer, pes.capacity);
+            pes.buffer = pes.pool->get(pes.expected, pes.capacity);
+        }
+        append(pes, data + header_length, size - header_length);
+    } else if (pes.active && !pes.corrupted) {
+        append(pes, data, size);
+    }
+    if (pes.active && pes.expected && pes.size >= pes.expected)
+        finish_pes(pes);
+}
+
+void TSParser::append(pes_state_t& pes, const uint8_t* data, size_t size)
+{
+    if (pes.expected && pes.size + size > pes.expected) {
+        // Stuffing after the PES packet
+        size = pes.expected - pes.size;
+    }
+    if (pes.size + size > pes.capacity) {
+        size_t capacity = 0;
+        auto   buffer   = pes.pool->get(std::max(pes.capacity * 2, pes.size + size), capacity);
+        std::memcpy(buffer, pes.buffer, pes.size);
+        pes.pool->put(pes.buffer, pes.capacity);
+        pes.buffer   = buffer;
+        pes.capacity = capacity;
+    }
+    std::memcpy(pes.buffer + pes.size, data, size);
+    pes.size += size;
+}
+
+void TSParser::finish_pes(pes_state_t& pes)
+{
+    pes.active = false;
+    if (pes.corrupted || !pes.size || (pes.expected && pes.size < pes.expected)) {
+        ++stats_.dropped_pes;
+        return;
+    }
+    ++stats_.pes_packets;
+    auto frame = pes.pool->make_frame(pes.stream.format, pes.buffer, pes.capacity, pes.size);
+    pes.buffer = nullptr;
+    if (pes.pts >= 0)
+        frame->set_timestamp(map_pts(pes.pts));
+    // Next PES gets a buffer sized for the largest PES seen so far
+    pes.buffer = pes.pool->get(0, pes.capacity);
+    if (callback_)
+        callback_(pes.stream, std::move(frame));
+}
+
+void TSParser::release_pes(pes_state_t& pes)
+{
+    if (pes.buffer) {
+        pes.pool->put(pes.buffer, pes.capacity);
+        pes.buffer = nullptr;
+    }
+}
+
+timestamp_t TSParser::map_pts(int64_t pts)
+{
+    auto value = pts + pts_offset_;
+    if (!has_pts_) {
+        has_pts_    = true;
+        first_pts_  = value;
+        last_pts_   = value;
+        start_time_ = timestamp_t{};
+    } else if (value < last_pts_ - pts_wrap / 2) {
+        // PTS wrapped around
+        pts_offset_ += pts_wrap;
+        value += pts_wrap;
+    } else if (value > last_pts_ + pts_wrap / 2 && pts_offset_ >= pts_wrap) {
+        // Packet from before the wrap
+        value -= pts_wrap;
+    }
+    last_pts_ = std::max(last_pts_, value);
+    return start_time_ + duration_t{ (value - first_pts_) * 1000000 / ts_clock };
+}
+}
+}
@@ -0,0 +1,167 @@
+/*!
+ * @file 		TSParser.h
+ * @author 		agent <agent@local>
+ * @date 		18.10.2026
+ * @copyright	Institute of Intermedia, CTU in Prague, 2026
+ * 				Distributed under modified BSD Licence, details in file doc/LICENSE
+ *
+ */
+
+#ifndef SRC_MODULES_MPEGTS_TSPARSER_H_
+#define SRC_MODULES_MPEGTS_TSPARSER_H_
+
+#include "ts_common.h"
+#include "yuri/core/frame/CompressedVideoFrame.h"
+#include "yuri/log/Log.h"
+#include <functional>
+
+namespace yuri {
+namespace mpegts {
+
+//! Elementary stream of the demuxed program
+struct ts_stream_t {
+    uint16_t pid;
+    uint8_t  stream_type;
+    format_t format;
+    bool     audio;
+    //! Index of the stream among video (or audio) streams of the program
+    size_t   index;
+};
+
+struct ts_parser_stats_t {
+    size_t packets          = 0;
+    //! Number of times the parser had to look for a sync byte and bytes skipped
+    size_t sync_losses      = 0;
+    size_t skipped_bytes    = 0;
+    //! Packets with transport error indicator set
+    size_t transport_errors = 0;
+    //! Discontinuities in continuity counter
+    size_t cc_errors        = 0;
+    size_t crc_errors       = 0;
+    size_t pes_packets      = 0;
+    //! PES packets dropped because of missing data
+    size_t dropped_pes      = 0;
+};
+
+/*!
+ * Pool of buffers for PES payload.
+ *
+ * Frames are created directly over the buffers and return them to the pool
+ * when released. Buffers are sized for the largest PES packet seen so far.
+ */
+class PesBufferPool : public std::enable_shared_from_this<PesBufferPool> {
+public:
+    PesBufferPool(size_t block_size, size_t max_free = 8);
+    ~PesBufferPool() noexcept;
+
+    //! Returns a buffer with at least @em size bytes, its real size is stored to @em capacity
+    uint8_t* get(size_t size, size_t& capacity);
+    //! Returns buffer to the pool
+    void put(uint8_t* buffer, size_t capacity) noexcept;
+    //! Creates a frame with first @em size bytes of @em buffer, that is returned to the pool with the frame
+    core::pCompressedVideoFrame make_frame(format_t format, uint8_t* buffer, size_t capacity, size_t size);
+
+    size_t get_block_size() const;
+
+private:
+    mutable mutex                               mutex_;
+    size_t                                      block_size_;
+    size_t                                      max_free_;
+    std::vector<std::pair<uint8_t*, size_t>>    free_;
+};
+
+/*!
+ * Demultiplexer of MPEG transport stream.
+ *
+ * Parses PAT and PMT of a selected program and reassembles PES packets
+ * of its H.264, H.265, MPEG 2 video and AAC streams into frames.
+ * Input data don't need to be aligned to TS packets.
+ * PTS are mapped to timestamps relative to the time the first PTS was seen.
+ */
+class TSParser {
+public:
+    using frame_callback_t = std::function<void(const ts_stream_t&, core::pCompressedVideoFrame)>;
+
+    /*!
+     * @param program		Program number to demux, 0 for the first program in PAT
+     * @param packet_size	Size of TS packets, 188 or 192 for M2TS streams with timecode prefix
+     */
+    TSParser(const log::Log& log_, frame_callback_t callback, uint16_t program = 0, size_t packet_size = ts_packet_size);
+    ~TSParser() noexcept;
+
+    //! Parses next chunk of the stream
+    void parse(const uint8_t* data, size_t size);
+    //! Outputs all unfinished PES packets
+    void flush();
+
+    const std::vector<ts_stream_t>& get_streams() const { return streams_; }
+    const ts_parser_stats_t&        get_stats() const { return stats_; }
+
+private:
+    enum class pid_kind_t : uint8_t { none, pat, pmt, pes };
+
+    struct section_state_t {
+        std::vector<uint8_t> data;
+        bool                 active = false;
+    };
+
+    struct pes_state_t {
+        ts_stream_t                    stream;
+        std::shared_ptr<PesBufferPool> pool;
+        uint8_t*                       buffer   = nullptr;
+        size_t                         capacity = 0;
+        size_t                         size     = 0;
+        //! Expected payload size, 0 if unknown
+        size_t                         expected = 0;
+        int64_t                        pts      = -1;
+        bool                           active   = false;
+        bool                           corrupted = false;
+    };
+
+    struct pid_state_t {
+        pid_kind_t kind = pid_kind_t::none;
+        int        cc   = -1;
+        //! Index to pes_ for PES pids
+        size_t     pes  = 0;
+    };
+
+    size_t find_sync(const uint8_t* data, size_t size) const;
+    void   process_packet(const uint8_t* packet);
+    void   process_section_payload(section_state_t& section, const uint8_t* data, size_t size, bool unit_start, pid_kind_t kind);
+    void   process_section(const uint8_t* data, size_t size, pid_kind_t kind);
+    void   process_pat(const uint8_t* data, size_t size);
+    void   process_pmt(const uint8_t* data, size_t size);
+    void   process_pes_payload(pes_state_t& pes, const uint8_t* data, size_t size, bool unit_start);
+    void   append(pes_state_t& pes, const uint8_t* data, size_t size);
+    void   finish_pes(pes_state_t& pes);
+    void   release_pes(pes_state_t& pes);
+    timestamp_t map_pts(int64_t pts);
+
+    log::Log                  log;
+    frame_callback_t          callback_;
+    uint16_t                  program_;
+    size_t                    packet_size_;
+    //! Bytes preceding the sync byte in every packet
+    size_t                    prefix_size_;
+    std::vector<pid_state_t>  pids_;
+    uint16_t                  pmt_pid_;
+    int                       pmt_version_;
+    section_state_t           pat_section_;
+    section_state_t           pmt_section_;
+    std::vector<pes_state_t>  pes_;
+    std::vector<ts_stream_t>  streams_;
+    //! Partial packet from previous call to parse()
+    std::array<uint8_t, 256>  carry_;
+    size_t                    carry_size_;
+
+    bool                      has_pts_;
+    int64_t                   first_pts_;
+    int64_t                   last_pts_;
+    int64_t                   pts_offset_;
+    timestamp_t               start_time_;
+    ts_parser_stats_t         stats_;
+};
+}
+}
+
+#endif /* SRC_MODULES_MPEGTS_TSPARSER_H_ */
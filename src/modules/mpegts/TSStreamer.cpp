@@ -0,0 +1,302 @@
+/*!
+ * @file 		TSStreamer.cpp
+ * @author 		agent <agent@local>
+ * @date 		19.10.2026
+ * @copyright	Institute of Intermedia, CTU in Prague, 2026
+ * 				Distributed under modified BSD Licence, details in file doc/LICENSE
+ *
+ */
+
+#include "TSStreamer.h"
+#include "yuri/core/Module.h"
+#include "yuri/core/socket/DatagramSocketGenerator.h"
+#include "yuri/core/utils/make_unique.h"
+#include <algorithm>
+
+namespace yuri {
+namespace mpegts {
+
+IOTHREAD_GENERATOR(TSStreamer)
+
+namespace {
+//! Clock of the first frame, so earlier frames from other streams don't get negative timestamps
+constexpr int64_t start_clock = ts_clock;
+//! Datagrams planned further in future are sent immediately
+const auto        max_wait    = 2_s;
+//! Datagrams sent later than this are counted as late
+const auto        late_limit  = 10_ms;
+
+int64_t to_clock(duration_t duration)
+{
+    return duration.value * 9 / 100;
+}
+
+duration_t from_clock(int64_t clock)
+{
+    return duration_t{ clock * 100 / 9 };
+}
+
+//! Checks whether a frame starts with a keyframe (or parameter sets), by looking at first few NAL units
+bool is_random_access(format_t format, const uint8_t* data, size_t size)
+{
+    if (format == core::compressed_frame::aac)
+        return true;
+    if (format != core::compressed_frame::h264 && format != core::compressed_frame::h265)
+        return false;
+    const auto end = std::min<size_t>(size, 256);
+    for (size_t i = 0; i + 3 < end; ++i) {
+        if (data[i] != 0 || data[i + 1] != 0 || data[i + 2] != 1)
+            continue;
+        const auto nal = data[i + 3];
+        if (format == core::compressed_frame::h264) {
+            const auto type = nal & 0x1F;
+            if (type == 5 || type == 7)
+                return true;
+        } else {
+            const auto type = (nal >> 1) & 0x3F;
+            if ((type >= 16 && type <= 21) || type == 32)
+                return true;
+        }
+    }
+    return false;
+}
+}
+
+core::Parameters TSStreamer::configure()
+{
+    core::Parameters p = core::IOThread::configure();
+    p.set_description("Native MPEG-TS muxer sending the stream over UDP or RTP. Accepts H.264, H.265, MPEG 2 video and AAC inputs.");
+    p["streams"]["Number of inputs, each of them carrying one elementary stream"]                          = 2;
+    p["socket_type"]["Socket used to send the stream"]                                                     = "yuri_udp";
+    p["address"]["Remote address"]                                                                         = "127.0.0.1";
+    p["port"]["Remote port. Set to 0 to output the stream as mpeg2ts frames instead"]                      = 1234;
+    p["rtp"]["Send TS packets in RTP packets (RFC 2250)"]                                                  = false;
+    p["ssrc"]["SSRC for RTP packets"]                                                                      = 0x1234;
+    p["mux_rate"]["Mux rate in bits per second for CBR stream filled with null packets. 0 for VBR stream"] = 0;
+    p["delay"]["Delay between sending a frame and its PTS (in seconds)"]                                   = 0.5;
+    p["psi_interval"]["Interval for repeating PAT and PMT (in seconds)"]                                   = 0.1;
+    p["pcr_interval"]["Interval between PCR values (in seconds)"]                                          = 0.03;
+    p["program"]["Program number"]                                                                         = 1;
+    p["pmt_pid"]["PID of PMT"]                                                                             = 0x1000;
+    p["first_pid"]["PID of the first elementary stream"]                                                   = 0x100;
+    p["reorder"]["Number of video frames decoded ahead of their presentation (B-frames), to derive DTS"]   = 0;
+    p["stats_interval"]["Interval for logging of statistics (in seconds), 0 to disable"]                   = 10.0;
+    return p;
+}
+
+TSStreamer::TSStreamer(const log::Log& log_, core::pwThreadBase parent, const core::Parameters& parameters)
+    : core::IOThread(log_, parent, 2, 1, std::string("ts_streamer")),
+      streams_(2),
+      socket_type_("yuri_udp"),
+      address_("127.0.0.1"),
+      port_(1234),
+      rtp_(false),
+      ssrc_(0x1234),
+      mux_rate_(0),
+      delay_(500_ms),
+      psi_interval_(100_ms),
+      pcr_interval_(30_ms),
+      program_(1),
+      pmt_pid_(0x1000),
+      first_pid_(0x100),
+      reorder_(0),
+      stats_interval_(10_s),
+      started_(false),
+      sequence_(0),
+      sent_datagrams_(0),
+      sent_bytes_(0),
+      late_datagrams_(0)
+{
+    IOTHREAD_INIT(parameters)
+    resize(streams_, 1);
+    input_streams_.resize(streams_, -1);
+    dts_generators_.resize(streams_);
+    muxer_ = make_unique<TSMuxer>(log, program_, pmt_pid_, first_pid_);
+    muxer_->set_mux_rate(mux_rate_);
+    muxer_->set_delay(to_clock(delay_));
+    muxer_->set_psi_interval(to_clock(psi_interval_));
+    muxer_->set_pcr_interval(to_clock(pcr_interval_));
+    // CBR stream has to be filled even when there are no input frames
+    if (mux_rate_)
+        set_latency(5_ms);
+}
+
+TSStreamer::~TSStreamer() noexcept
+{
+}
+
+void TSStreamer::run()
+{
+    if (port_) {
+        log[log::info] << "Initializing socket of type '" << socket_type_ << "'";
+        socket_ = core::DatagramSocketGenerator::get_instance().generate(socket_type_, log, "");
+        if (!socket_->connect(address_, port_)) {
+            log[log::fatal] << "Failed to connect socket!";
+            request_end(core::yuri_exit_interrupted);
+            return;
+        }
+    }
+    core::IOThread::run();
+}
+
+bool TSStreamer::step()
+{
+    const timestamp_t now;
+    for (size_t i = 0; i < streams_; ++i) {
+        while (auto frame = std::dynamic_pointer_cast<core::CompressedVideoFrame>(pop_frame(i))) {
+            mux_frame(i, frame, now);
+        }
+    }
+    if (started_) {
+        if (mux_rate_) {
+            muxer_->fill(clock_at(now));
+        } else {
+            muxer_->flush();
+        }
+    }
+    send_datagrams();
+    log_stats();
+    return true;
+}
+
+void TSStreamer::mux_frame(size_t input, const core::pCompressedVideoFrame& frame, timestamp_t now)
+{
+    auto& stream = input_streams_[input];
+    if (stream == -2)
+        return;
+    if (stream == -1) {
+        stream = muxer_->add_stream(frame->get_format());
+        if (stream < 0) {
+            log[log::error] << "Unsupported format on input " << input << ", ignoring the input";
+            stream = -2;
+            return;
+        }
+        // Audio frames are never reordered
+        dts_generators_[input] = DtsGenerator(frame->get_format() == core::compressed_frame::aac ? 0 : reorder_);
+    }
+    if (!started_) {
+        started_         = true;
+        first_timestamp_ = frame->get_timestamp();
+        start_time_      = now;
+    }
+    const auto pts = start_clock + to_clock(delay_) + to_clock(frame->get_timestamp() - first_timestamp_);
+    if (pts < 0) {
+        log[log::warning] << "Dropping frame with timestamp before start of the stream";
+        return;
+    }
+    // Frames carry only presentation time, DTS has to be derived for reordered frames
+    const auto duration = frame->get_duration() > 0_us ? to_clock(frame->get_duration()) : ts_clock / 25;
+    const auto dts      = dts_generators_[input].next(pts, duration);
+    muxer_->write_frame(static_cast<size_t>(stream), frame->data(), frame->size(), pts, dts,
+                        is_random_access(frame->get_format(), frame->data(), frame->size()));
+}
+
+int64_t TSStreamer::clock_at(timestamp_t time) const
+{
+    return start_clock + to_clock(time - start_time_);
+}
+
+void TSStreamer::send_datagrams()
+{
+    if (!port_) {
+        for (size_t i = 0; i < muxer_->get_datagram_count(); ++i) {
+            const auto d     = muxer_->get_datagram(i);
+            auto       frame = core::CompressedVideoFrame::create_empty(core::compressed_frame::mpeg2ts, resolution_t{ 0, 0 }, d.data, d.size);
+            frame->set_timestamp(start_time_ + from_clock(d.clock - start_clock));
+            push_frame(0, std::move(frame));
+        }
+        sent_datagrams_ += muxer_->get_datagram_count();
+        muxer_->remove_datagrams(muxer_->get_datagram_count());
+        return;
+    }
+    while (muxer_->get_datagram_count() && still_running()) {
+        const timestamp_t now;
+        const auto        count = muxer_->get_datagram_count();
+        rtp_headers_.resize(count * rtp_header_size);
+        parts_.clear();
+        datagrams_.clear();
+        // Send all datagrams that are due now at once
+        size_t due = 0;
+        for (; due < count; ++due) {
+            const auto d        = muxer_->get_datagram(due);
+            const auto send_at  = start_time_ + from_clock(d.clock - start_clock);
+            if (send_at > now && send_at - now < max_wait)
+                break;
+            if (now - send_at > late_limit)
+                ++late_datagrams_;
+            if (rtp_) {
+                auto header = &rtp_headers_[due * rtp_header_size];
+                write_rtp_header(header, rtp_payload_mp2t, static_cast<uint16_t>(sequence_ + due), static_cast<uint32_t>(d.clock), ssrc_);
+                parts_.push_back({ header, rtp_header_size });
+            }
+            parts_.push_back({ d.data, d.size });
+        }
+        if (!due) {
+            const auto d = muxer_->get_datagram(0);
+            ThreadBase::sleep(std::min(start_time_ + from_clock(d.clock - start_clock) - now, get_latency()));
+            continue;
+        }
+        const size_t parts_per_datagram = rtp_ ? 2 : 1;
+        for (size_t i = 0; i < due; ++i) {
+            datagrams_.push_back({ &parts_[i * parts_per_datagram], parts_per_datagram });
+        }
+        const auto sent = socket_->send_datagrams(datagrams_);
+        for (size_t i = 0; i < sent; ++i) {
+            sent_bytes_ += muxer_->get_datagram(i).size;
+        }
+        if (sent < due) {
+            log[log::warning] << "Failed to send " << (due - sent) << " datagrams";
+        }
+        // Unsent datagrams are dropped, the stream can't wait for them
+        sequence_ = static_cast<uint16_t>(sequence_ + due);
+        sent_datagrams_ += sent;
+        muxer_->remove_datagrams(due);
+    }
+}
+
+void TSStreamer::log_stats()
+{
+    if (stats_interval_ <= 0_us)
+        return;
+    const timestamp_t now;
+    if (now - last_stats_time_ < stats_interval_)
+        return;
+    const auto  elapsed = now - last_stats_time_;
+    const auto& stats   = muxer_->get_stats();
+    last_stats_time_    = now;
+    if (!stats.packets)
+        return;
+    log[log::info] << "Muxed " << stats.frames << " frames into " << stats.packets << " packets (" << stats.null_packets << " null, "
+                   << stats.pcr_packets << " PCR, " << stats.psi_packets << " PSI), sent " << sent_datagrams_ << " datagrams, "
+                   << (sent_bytes_ * 8.0 / (elapsed.value * 1e-6) / 1e6) << " Mbit/s. " << stats.late_frames << " frames late for mux rate, "
+                   << late_datagrams_ << " datagrams sent late";
+    muxer_->reset_stats();
+    sent_datagrams_ = 0;
+    sent_bytes_     = 0;
+    late_datagrams_ = 0;
+}
+
+bool TSStreamer::set_param(const core::Parameter& param)
+{
+    if (assign_parameters(param)                                                                        //
+        (streams_, "streams")                                                                           //
+        (socket_type_, "socket_type")                                                                   //
+        (address_, "address")                                                                           //
+        (port_, "port")                                                                                 //
+        (rtp_, "rtp")                                                                                   //
+        (ssrc_, "ssrc")                                                                                 //
+        (mux_rate_, "mux_rate")                                                                         //
+        (delay_, "delay", [](const core::Parameter& p) { return 1_s * p.get<double>(); })               //
+        (psi_interval_, "psi_interval", [](const core::Parameter& p) { return 1_s * p.get<double>(); }) //
+        (pcr_interval_, "pcr_interval", [](const core::Parameter& p) { return 1_s * p.get<double>(); }) //
+        (program_, "program")                                                                           //
+        (pmt_pid_, "pmt_pid")                                                                           //
+        (first_pid_, "first_pid")                                                                       //
+        (reorder_, "reorder")                                                                           //
+        (stats_interval_, "stats_interval", [](const core::Parameter& p) { return 1_s * p.get<double>(); }))
+        return true;
+    return core::IOThread::set_param(param);
+}
+
+} /* namespace mpegts */
+} /* namespace yuri */
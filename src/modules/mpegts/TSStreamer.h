@@ -0,0 +1,80 @@
+/*!
+ * @file 		TSStreamer.h
+ * @author 		agent <agent@local>
+ * @date 		19.10.2026
+ * @copyright	Institute of Intermedia, CTU in Prague, 2026
+ * 				Distributed under modified BSD Licence, details in file doc/LICENSE
+ *
+ */
+
+#ifndef SRC_MODULES_MPEGTS_TSSTREAMER_H_
+#define SRC_MODULES_MPEGTS_TSSTREAMER_H_
+
+#include "TSMuxer.h"
+#include "yuri/core/thread/IOThread.h"
+#include "yuri/core/frame/CompressedVideoFrame.h"
+#include "yuri/core/socket/DatagramSocket.h"
+
+namespace yuri {
+namespace mpegts {
+
+/*!
+ * Multiplexes compressed video and audio frames into MPEG transport stream
+ * and sends it over UDP (optionally in RTP packets) or outputs it as mpeg2ts frames.
+ * Each input carries one elementary stream.
+ */
+class TSStreamer : public core::IOThread {
+public:
+    IOTHREAD_GENERATOR_DECLARATION
+    static core::Parameters configure();
+    TSStreamer(const log::Log& log_, core::pwThreadBase parent, const core::Parameters& parameters);
+    virtual ~TSStreamer() noexcept;
+
+private:
+    virtual void run() override;
+    virtual bool step() override;
+    virtual bool set_param(const core::Parameter& param) override;
+
+    void    mux_frame(size_t input, const core::pCompressedVideoFrame& frame, timestamp_t now);
+    //! Returns mux clock corresponding to a time
+    int64_t clock_at(timestamp_t time) const;
+    //! Sends (or outputs) all datagrams produced by the muxer, each of them at the time given by its clock
+    void    send_datagrams();
+    void    log_stats();
+
+    size_t                                        streams_;
+    std::string                                   socket_type_;
+    std::string                                   address_;
+    uint16_t                                      port_;
+    bool                                          rtp_;
+    uint32_t                                      ssrc_;
+    uint64_t                                      mux_rate_;
+    duration_t                                    delay_;
+    duration_t                                    psi_interval_;
+    duration_t                                    pcr_interval_;
+    uint16_t                                      program_;
+    uint16_t                                      pmt_pid_;
+    uint16_t                                      first_pid_;
+    size_t                                        reorder_;
+    duration_t                                    stats_interval_;
+    std::shared_ptr<core::socket::DatagramSocket> socket_;
+    std::unique_ptr<TSMuxer>                      muxer_;
+    //! Muxer stream for each input, -1 for inputs without stream yet, -2 for unsupported inputs
+    std::vector<int>                              input_streams_;
+    std::vector<DtsGenerator>                     dts_generators_;
+    bool                                          started_;
+    timestamp_t                                   first_timestamp_;
+    timestamp_t                                   start_time_;
+    uint16_t                                      sequence_;
+    std::vector<uint8_t>                          rtp_headers_;
+    std::vector<core::socket::datagram_t>         parts_;
+    std::vector<core::socket::datagram_parts_t>   datagrams_;
+    size_t                                        sent_datagrams_;
+    size_t                                        sent_bytes_;
+    size_t                                        late_datagrams_;
+    timestamp_t                                   last_stats_time_;
+};
+
+} /* namespace mpegts */
+} /* namespace yuri */
+#endif /* SRC_MODULES_MPEGTS_TSSTREAMER_H_ */
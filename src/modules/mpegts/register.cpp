@@ -0,0 +1,23 @@
+/*!
+ * @file 		register.cpp
+ * @author 		agent <agent@local>
+ * @date 		18.10.2026
+ * @copyright	Institute of Intermedia, CTU in Prague, 2026
+ * 				Distributed under modified BSD Licence, details in file doc/LICENSE
+ *
+ */
+
+#include "TSDemuxer.h"
+#include "TSStreamer.h"
+
+#include "yuri/core/Module.h"
+
+namespace yuri {
+namespace mpegts {
+
+MODULE_REGISTRATION_BEGIN("mpegts")
+    REGISTER_IOTHREAD("ts_demuxer", TSDemuxer)
+    REGISTER_IOTHREAD("ts_streamer", TSStreamer)
+MODULE_REGISTRATION_END()
+}
+}
@@ -0,0 +1,527 @@
+/*!
+ * @file 		test_mpegts.cpp
+ * @author 		agent <agent@local>
+ * @date 		18.10.2026
+ * @copyright	Institute of Intermedia, CTU in Prague, 2026
+ * 				Distributed under modified BSD Licence, details in file doc/LICENSE
+ *
+ */
+
+#include "tests/catch.hpp"
+#include "TSParser.h"
+#include "TSMuxer.h"
+#include <map>
+#include <sstream>
+
+namespace yuri {
+namespace mpegts {
+
+namespace {
+
+constexpr uint16_t pmt_pid   = 0x100;
+constexpr uint16_t video_pid = 0x101;
+constexpr uint16_t audio_pid = 0x102;
+
+/*!
+ * Writes TS stream the same way as common muxers do, used to create
+ * the streams for the tests.
+ */
+struct ts_writer {
+    std::vector<uint8_t>        out;
+    std::map<uint16_t, uint8_t> cc;
+    //! Bytes before every packet (4 for M2TS)
+    size_t                      prefix = 0;
+
+    //! Writes a packet, returns number of payload bytes used
+    size_t packet(uint16_t pid, bool start, const uint8_t* payload, size_t size)
+    {
+        out.insert(out.end(), prefix, 0xAB);
+        const auto used = std::min<size_t>(size, 184);
+        out.push_back(ts_sync_byte);
+        out.push_back(static_cast<uint8_t>((start ? 0x40 : 0x00) | (pid >> 8)));
+        out.push_back(static_cast<uint8_t>(pid & 0xFF));
+        const bool adaptation = used < 184;
+        out.push_back(static_cast<uint8_t>((adaptation ? 0x30 : 0x10) | (cc[pid]++ & 0x0F)));
+        if (adaptation) {
+            // Adaptation field with stuffing to fill the packet
+            const auto length = 183 - used;
+            out.push_back(static_cast<uint8_t>(length));
+            if (length) {
+                out.push_back(0x00);
+                out.insert(out.end(), length - 1, 0xFF);
+            }
+        }
+        out.insert(out.end(), payload, payload + used);
+        return used;
+    }
+
+    void section(uint16_t pid, std::vector<uint8_t> section, bool corrupt_crc = false)
+    {
+        const auto length = section.size() + 4 - 3;
+        section[1]        = static_cast<uint8_t>(0xB0 | (length >> 8));
+        section[2]        = static_cast<uint8_t>(length & 0xFF);
+        auto crc          = crc32_mpeg(section.data(), section.size());
+        if (corrupt_crc)
+            crc ^= 1;
+        for (int i = 3; i >= 0; --i) {
+            section.push_back(static_cast<uint8_t>(crc >> (8 * i)));
+        }
+        section.insert(section.begin(), 0); // pointer field
+        section.resize(184, 0xFF);
+        packet(pid, true, section.data(), section.size());
+    }
+
+    void pat(bool corrupt_crc = false)
+    {
+        section(pat_pid, { 0x00, 0, 0, 0x00, 0x01, 0xC1, 0, 0, 0x00, 0x01, 0xE0 | (pmt_pid >> 8), pmt_pid & 0xFF }, corrupt_crc);
+    }
+
+    void pmt(uint8_t version = 0)
+    {
+        section(pmt_pid, { 0x02, 0, 0, 0x00, 0x01, static_cast<uint8_t>(0xC1 | (version << 1)), 0, 0, 0xE0 | (video_pid >> 8), video_pid & 0xFF,
+                           0xF0, 0x00,
+                           // Unsupported stream first
+                           0x03, 0xE1, 0x10, 0xF0, 0x00,
+                           // H.264 video with a descriptor
+                           stream_type::h264, 0xE0 | (video_pid >> 8), video_pid & 0xFF, 0xF0, 0x02, 0x0A, 0x00,
+                           // AAC audio
+                           stream_type::aac_adts, 0xE0 | (audio_pid >> 8), audio_pid & 0xFF, 0xF0, 0x00 });
+    }
+
+    //! Writes PES packet, video PES packets are unbounded
+    void pes(uint16_t pid, uint8_t stream_id, int64_t pts, const std::vector<uint8_t>& data, bool bounded)
+    {
+        std::vector<uint8_t> pes = { 0, 0, 1, stream_id, 0, 0, 0x80, 0x80, 5, 0, 0, 0, 0, 0 };
+        write_pes_timestamp(pes.data() + 9, 2, pts);
+        if (bounded) {
+            const auto length = pes.size() - 6 + data.size();
+            pes[4]            = static_cast<uint8_t>(length >> 8);
+            pes[5]            = static_cast<uint8_t>(length & 0xFF);
+        }
+        pes.insert(pes.end(), data.begin(), data.end());
+        for (size_t offset = 0; offset < pes.size();) {
+            offset += packet(pid, offset == 0, pes.data() + offset, pes.size() - offset);
+        }
+    }
+};
+
+std::vector<uint8_t> make_payload(size_t size, uint8_t seed)
+{
+    std::vector<uint8_t> data(size);
+    for (size_t i = 0; i < size; ++i) {
+        data[i] = static_cast<uint8_t>(i * 13 + seed);
+    }
+    return data;
+}
+
+struct received_frame_t {
+    ts_stream_t                 stream;
+    core::pCompressedVideoFrame frame;
+
+    std::vector<uint8_t> data() const { return { frame->data(), frame->data() + frame->size() }; }
+};
+
+struct test_parser {
+    std::stringstream             ss;
+    log::Log                      l;
+    std::vector<received_frame_t> frames;
+    TSParser                      parser;
+
+    test_parser(size_t packet_size = ts_packet_size)
+        : l(ss), parser(l, [this](const ts_stream_t& s, core::pCompressedVideoFrame f) { frames.push_back({ s, std::move(f) }); }, 0, packet_size)
+    {
+    }
+    //! Parses data split into chunks of @em chunk bytes
+    void parse(const std::vector<uint8_t>& data, size_t chunk)
+    {
+        for (size_t offset = 0; offset < data.size(); offset += chunk) {
+            parser.parse(data.data() + offset, std::min(chunk, data.size() - offset));
+        }
+    }
+};
+
+//! Stream with 3 video frames (one large) and 2 audio frames
+ts_writer make_stream(std::vector<std::vector<uint8_t>>& video, std::vector<std::vector<uint8_t>>& audio, size_t prefix = 0)
+{
+    ts_writer w;
+    w.prefix = prefix;
+    video    = { make_payload(1000, 1), make_payload(200000, 2), make_payload(184 - 14, 3) };
+    audio    = { make_payload(300, 4), make_payload(500, 5) };
+    w.pat();
+    w.pmt();
+    w.pes(video_pid, 0xE0, 90000, video[0], false);
+    w.pes(audio_pid, 0xC0, 90000, audio[0], true);
+    w.pes(video_pid, 0xE0, 90000 + 3600, video[1], false);
+    w.pes(audio_pid, 0xC0, 90000 + 1920, audio[1], true);
+    w.pes(video_pid, 0xE0, 90000 + 7200, video[2], false);
+    return w;
+}
+}
+
+TEST_CASE("ts crc", "[mpegts]")
+{
+    const std::string data = "123456789";
+    REQUIRE(crc32_mpeg(reinterpret_cast<const uint8_t*>(data.data()), data.size()) == 0x0376E6E7);
+}
+
+TEST_CASE("ts pes timestamp", "[mpegts]")
+{
+    uint8_t data[5];
+    for (int64_t ts : { int64_t{ 0 }, int64_t{ 90000 }, pts_wrap - 1, int64_t{ 0x123456789 } }) {
+        write_pes_timestamp(data, 2, ts);
+        REQUIRE(read_pes_timestamp(data) == ts);
+        REQUIRE((data[0] >> 4) == 2);
+    }
+}
+
+TEST_CASE("ts demuxer", "[mpegts]")
+{
+    std::vector<std::vector<uint8_t>> video, audio;
+    size_t                            prefix = 0;
+    size_t                            chunk  = 1316;
+    SECTION("aligned datagrams") {}
+    SECTION("unaligned chunks") { chunk = 1000; }
+    SECTION("small chunks") { chunk = 7; }
+    SECTION("m2ts") { prefix = 4; }
+
+    auto        w = make_stream(video, audio, prefix);
+    test_parser t(ts_packet_size + prefix);
+    t.parse(w.out, chunk);
+    REQUIRE(t.parser.get_streams().size() == 2);
+    REQUIRE(t.parser.get_streams()[0].format == core::compressed_frame::h264);
+    REQUIRE(t.parser.get_streams()[1].format == core::compressed_frame::aac);
+    REQUIRE(t.parser.get_streams()[1].audio);
+
+    // Last video frame is waiting for next PES packet
+    REQUIRE(t.frames.size() == 4);
+    t.parser.flush();
+    REQUIRE(t.frames.size() == 5);
+
+    std::vector<received_frame_t> v, a;
+    for (const auto& f : t.frames) {
+        (f.stream.audio ? a : v).push_back(f);
+    }
+    REQUIRE(v.size() == 3);
+    REQUIRE(a.size() == 2);
+    for (size_t i = 0; i < v.size(); ++i) {
+        REQUIRE(v[i].frame->get_format() == core::compressed_frame::h264);
+        REQUIRE(v[i].data() == video[i]);
+    }
+    for (size_t i = 0; i < a.size(); ++i) {
+        REQUIRE(a[i].frame->get_format() == core::compressed_frame::aac);
+        REQUIRE(a[i].data() == audio[i]);
+    }
+    REQUIRE(v[1].frame->get_timestamp() - v[0].frame->get_timestamp() == 40_ms);
+    REQUIRE(v[2].frame->get_timestamp() - v[0].frame->get_timestamp() == 80_ms);
+    REQUIRE(a[1].frame->get_timestamp() - a[0].frame->get_timestamp() == 21333_us);
+    REQUIRE(a[0].frame->get_timestamp() == v[0].frame->get_timestamp());
+
+    const auto& stats = t.parser.get_stats();
+    REQUIRE(stats.pes_packets == 5);
+    REQUIRE(stats.sync_losses == 0);
+    REQUIRE(stats.cc_errors == 0);
+    REQUIRE(stats.dropped_pes == 0);
+}
+
+TEST_CASE("ts demuxer errors", "[mpegts]")
+{
+    std::vector<std::vector<uint8_t>> video, audio;
+    auto                              w = make_stream(video, audio);
+    test_parser                       t;
+
+    SECTION("resync after garbage")
+    {
+        std::vector<uint8_t> data = { 0x47, 1, 2, 3, 0x47, 5 };
+        data.insert(data.end(), w.out.begin(), w.out.begin() + 3 * ts_packet_size);
+        // Garbage in the middle of the stream, containing sync bytes
+        data.insert(data.end(), 100, 0x47);
+        data.insert(data.end(), w.out.begin() + 3 * ts_packet_size, w.out.end());
+        t.parse(data, 1316);
+        t.parser.flush();
+        REQUIRE(t.parser.get_stats().sync_losses >= 2);
+        REQUIRE(t.parser.get_stats().skipped_bytes >= 106);
+        REQUIRE(t.frames.size() == 5);
+        REQUIRE(t.frames[1].data() == video[0]);
+    }
+    SECTION("lost packet drops the PES")
+    {
+        // Remove a packet from the middle of the large video frame
+        const auto offset = 20 * ts_packet_size;
+        REQUIRE(((w.out[offset + 1] & 0x1F) << 8 | w.out[offset + 2]) == video_pid);
+        w.out.erase(w.out.begin() + offset, w.out.begin() + offset + ts_packet_size);
+        t.parse(w.out, 1316);
+        t.parser.flush();
+        REQUIRE(t.parser.get_stats().cc_errors == 1);
+        REQUIRE(t.parser.get_stats().dropped_pes == 1);
+        REQUIRE(t.frames.size() == 4);
+    }
+    SECTION("duplicate packets are ignored")
+    {
+        const auto offset = 5 * ts_packet_size;
+        w.out.insert(w.out.begin() + offset, w.out.begin() + offset, w.out.begin() + offset + ts_packet_size);
+        t.parse(w.out, 1316);
+        t.parser.flush();
+        REQUIRE(t.parser.get_stats().cc_errors == 0);
+        REQUIRE(t.frames.size() == 5);
+        REQUIRE(t.frames[1].data() == video[0]);
+        REQUIRE(t.frames[3].data() == video[1]);
+    }
+    SECTION("corrupted PAT")
+    {
+        ts_writer bad;
+        bad.pat(true);
+        bad.out.insert(bad.out.end(), w.out.begin() + 2 * ts_packet_size, w.out.end());
+        t.parse(bad.out, 1316);
+        REQUIRE(t.parser.get_stats().crc_errors == 1);
+        REQUIRE(t.parser.get_streams().empty());
+        REQUIRE(t.frames.empty());
+    }
+}
+
+TEST_CASE("ts demuxer pts wrap", "[mpegts]")
+{
+    ts_writer w;
+    w.pat();
+    w.pmt();
+    const auto data = make_payload(500, 1);
+    for (int64_t i = 0; i < 4; ++i) {
+        w.pes(audio_pid, 0xC0, (pts_wrap - 2 * 3600 + i * 3600) % pts_wrap, data, true);
+    }
+    test_parser t;
+    t.parse(w.out, 1316);
+    REQUIRE(t.frames.size() == 4);
+    for (size_t i = 1; i < 4; ++i) {
+        REQUIRE(t.frames[i].frame->get_timestamp() - t.frames[i - 1].frame->get_timestamp() == 40_ms);
+    }
+}
+
+TEST_CASE("ts demuxer buffer pool", "[mpegts]")
+{
+    ts_writer w;
+    w.pat();
+    w.pmt();
+    const auto data = make_payload(500, 1);
+    w.pes(audio_pid, 0xC0, 0, data, true);
+    w.pes(audio_pid, 0xC0, 3600, data, true);
+    w.pes(audio_pid, 0xC0, 7200, data, true);
+
+    test_parser t;
+    t.parse(std::vector<uint8_t>(w.out.begin(), w.out.begin() + 5 * ts_packet_size), 1316);
+    REQUIRE(t.frames.size() == 1);
+    const auto first = &*t.frames[0].frame->data();
+    // Released frame returns its buffer to the pool
+    t.frames.clear();
+    t.parse(std::vector<uint8_t>(w.out.begin() + 5 * ts_packet_size, w.out.end()), 1316);
+    REQUIRE(t.frames.size() == 2);
+    REQUIRE((&*t.frames[0].frame->data() == first || &*t.frames[1].frame->data() == first));
+    REQUIRE(t.frames[1].data() == data);
+}
+
+namespace {
+//! Moves all datagrams from the muxer to a single buffer
+std::vector<uint8_t> take_datagrams(TSMuxer& muxer, std::vector<ts_datagram_t>* infos = nullptr)
+{
+    std::vector<uint8_t> data;
+    for (size_t i = 0; i < muxer.get_datagram_count(); ++i) {
+        const auto d = muxer.get_datagram(i);
+        REQUIRE(d.size % ts_packet_size == 0);
+        REQUIRE(d.size <= ts_packets_per_datagram * ts_packet_size);
+        data.insert(data.end(), d.data, d.data + d.size);
+        if (infos)
+            infos->push_back(d);
+    }
+    muxer.remove_datagrams(muxer.get_datagram_count());
+    return data;
+}
+
+uint16_t packet_pid(const uint8_t* packet)
+{
+    return static_cast<uint16_t>(((packet[1] & 0x1F) << 8) | packet[2]);
+}
+}
+
+TEST_CASE("ts muxer", "[mpegts]")
+{
+    std::stringstream ss;
+    log::Log          l(ss);
+    TSMuxer           muxer(l);
+    const auto        video_stream = muxer.add_stream(core::compressed_frame::h264);
+    const auto        audio_stream = muxer.add_stream(core::compressed_frame::aac);
+    REQUIRE(video_stream == 0);
+    REQUIRE(audio_stream == 1);
+    REQUIRE(muxer.add_stream(core::compressed_frame::jpeg) == -1);
+
+    std::vector<std::vector<uint8_t>> video = { make_payload(70000, 1), make_payload(5000, 2), make_payload(170, 3), make_payload(1, 4) };
+    std::vector<std::vector<uint8_t>> audio = { make_payload(400, 5), make_payload(183, 6), make_payload(600, 7) };
+    std::vector<ts_datagram_t>        infos;
+    std::vector<uint8_t>              stream;
+
+    SECTION("vbr")
+    {
+        for (size_t i = 0; i < video.size(); ++i) {
+            muxer.write_frame(video_stream, video[i].data(), video[i].size(), ts_clock + 3600 * i, i == 0);
+            if (i < audio.size())
+                muxer.write_frame(audio_stream, audio[i].data(), audio[i].size(), ts_clock + 3600 * i, true);
+            muxer.flush();
+        }
+        stream = take_datagrams(muxer, &infos);
+        REQUIRE(muxer.get_stats().null_packets == 0);
+        REQUIRE(muxer.get_stats().late_frames == 0);
+        REQUIRE(muxer.get_stats().frames == 7);
+    }
+    SECTION("cbr")
+    {
+        constexpr uint64_t rate = 20000000;
+        muxer.set_mux_rate(rate);
+        for (size_t i = 0; i < video.size(); ++i) {
+            muxer.write_frame(video_stream, video[i].data(), video[i].size(), ts_clock + 3600 * i, i == 0);
+            if (i < audio.size())
+                muxer.write_frame(audio_stream, audio[i].data(), audio[i].size(), ts_clock + 3600 * i, true);
+        }
+        const auto end_clock = ts_clock + 3600 * video.size();
+        muxer.fill(end_clock);
+        muxer.flush();
+        stream = take_datagrams(muxer, &infos);
+        REQUIRE(muxer.get_stats().null_packets > 0);
+        REQUIRE(muxer.get_stats().late_frames == 0);
+        // Stream has constant rate, starting at first PTS minus delay
+        const auto packets = stream.size() / ts_packet_size;
+        const auto start   = infos.front().clock;
+        REQUIRE(start == ts_clock - ts_clock / 2);
+        REQUIRE(packets >= (end_clock - start) * rate / ts_clock / (ts_packet_size * 8));
+        REQUIRE(packets <= (end_clock - start) * rate / ts_clock / (ts_packet_size * 8) + ts_packets_per_datagram);
+        for (size_t i = 0; i < infos.size(); ++i) {
+            REQUIRE(infos[i].size == ts_packets_per_datagram * ts_packet_size);
+            REQUIRE(infos[i].clock == start + static_cast<int64_t>(i * ts_packets_per_datagram * ts_packet_size * 8 * ts_clock / rate));
+        }
+        // PCR values follow position in the stream and repeat often enough
+        int64_t last_pcr = -1;
+        for (size_t i = 0; i < packets; ++i) {
+            const auto packet = &stream[i * ts_packet_size];
+            if (!(packet[3] & 0x20) || packet[4] < 7 || !(packet[5] & 0x10))
+                continue;
+            REQUIRE(packet_pid(packet) == 0x100);
+            const int64_t base = (int64_t{ packet[6] } << 25) | (packet[7] << 17) | (packet[8] << 9) | (packet[9] << 1) | (packet[10] >> 7);
+            const int64_t pcr  = base * 300 + (((packet[10] & 1) << 8) | packet[11]);
+            REQUIRE(pcr == start * 300 + static_cast<int64_t>(i * ts_packet_size * 8 * ts_clock * 300 / rate));
+            if (last_pcr >= 0)
+                REQUIRE(pcr - last_pcr <= (ts_clock * 3 / 100) * 300 + static_cast<int64_t>(2 * ts_packet_size * 8 * ts_clock * 300 / rate));
+            last_pcr = pcr;
+        }
+        REQUIRE(last_pcr >= 0);
+    }
+
+    test_parser t;
+    t.parse(stream, 1316);
+    t.parser.flush();
+    REQUIRE(t.parser.get_stats().cc_errors == 0);
+    REQUIRE(t.parser.get_stats().crc_errors == 0);
+    REQUIRE(t.parser.get_streams().size() == 2);
+    std::vector<received_frame_t> v, a;
+    for (const auto& f : t.frames) {
+        (f.stream.audio ? a : v).push_back(f);
+    }
+    REQUIRE(v.size() == video.size());
+    REQUIRE(a.size() == audio.size());
+    for (size_t i = 0; i < v.size(); ++i) {
+        REQUIRE(v[i].data() == video[i]);
+        REQUIRE(v[i].frame->get_timestamp() - v[0].frame->get_timestamp() == 40_ms * static_cast<int64_t>(i));
+    }
+    for (size_t i = 0; i < a.size(); ++i) {
+        REQUIRE(a[i].data() == audio[i]);
+    }
+}
+
+TEST_CASE("ts dts", "[mpegts]")
+{
+    SECTION("generator")
+    {
+        // I0 P3 B1 B2 P6 B4 B5 in decoding order
+        const std::vector<int64_t> pts = { 0, 3, 1, 2, 6, 4, 5 };
+        DtsGenerator               generator(1);
+        std::vector<int64_t>       dts;
+        for (auto p : pts) {
+            dts.push_back(generator.next(p, 1));
+        }
+        REQUIRE(dts == std::vector<int64_t>{ -1, 0, 1, 2, 3, 4, 5 });
+        DtsGenerator no_reorder;
+        REQUIRE(no_reorder.next(3, 1) == 3);
+        REQUIRE(no_reorder.next(1, 1) == 1);
+    }
+    SECTION("pes header")
+    {
+        std::stringstream ss;
+        log::Log          l(ss);
+        TSMuxer           muxer(l);
+        const auto        video_stream = muxer.add_stream(core::compressed_frame::h264);
+        const auto        data         = make_payload(1000, 1);
+        muxer.write_frame(video_stream, data.data(), data.size(), ts_clock + 7200, ts_clock, true);
+        muxer.write_frame(video_stream, data.data(), data.size(), ts_clock + 3600, ts_clock + 3600, false);
+        muxer.flush();
+        const auto           stream         = take_datagrams(muxer);
+        const int64_t        expected_pts[] = { ts_clock + 7200, ts_clock + 3600 };
+        std::vector<int64_t> headers;
+        for (size_t i = 0; i < stream.size(); i += ts_packet_size) {
+            const auto packet = &stream[i];
+            if (packet_pid(packet) != 0x100 || !(packet[1] & 0x40))
+                continue;
+            const auto pes = packet + 4 + ((packet[3] & 0x20) ? packet[4] + 1 : 0);
+            REQUIRE(headers.size() < 2);
+            REQUIRE(read_pes_timestamp(pes + 9) == expected_pts[headers.size()]);
+            if (headers.empty()) {
+                REQUIRE(pes[7] == 0xC0);
+                REQUIRE(pes[8] == 10);
+                REQUIRE(read_pes_timestamp(pes + 14) == ts_clock);
+            } else {
+                REQUIRE(pes[7] == 0x80);
+                REQUIRE(pes[8] == 5);
+            }
+            headers.push_back(pes[8]);
+        }
+        REQUIRE(headers.size() == 2);
+        test_parser t;
+        t.parse(stream, 1316);
+        t.parser.flush();
+        REQUIRE(t.frames.size() == 2);
+        REQUIRE(t.frames[0].data() == data);
+        REQUIRE(t.frames[1].frame->get_timestamp() - t.frames[0].frame->get_timestamp() == -40_ms);
+    }
+}
+
+TEST_CASE("ts muxer late streams and rate", "[mpegts]")
+{
+    std::stringstream ss;
+    log::Log          l(ss);
+    TSMuxer           muxer(l);
+    const auto        data = make_payload(20000, 1);
+
+    SECTION("stream added later")
+    {
+        const auto audio_stream = muxer.add_stream(core::compressed_frame::aac);
+        muxer.write_frame(audio_stream, data.data(), 500, ts_clock, true);
+        muxer.flush();
+        const auto video_stream = muxer.add_stream(core::compressed_frame::h265);
+        muxer.write_frame(video_stream, data.data(), data.size(), ts_clock + 3600, true);
+        muxer.write_frame(video_stream, data.data(), data.size(), ts_clock + 7200, false);
+        muxer.flush();
+        test_parser t;
+        t.parse(take_datagrams(muxer), 1316);
+        REQUIRE(t.parser.get_streams().size() == 2);
+        REQUIRE(t.parser.get_streams()[1].format == core::compressed_frame::h265);
+        REQUIRE(t.frames.size() == 3);
+    }
+    SECTION("too low mux rate")
+    {
+        const auto video_stream = muxer.add_stream(core::compressed_frame::h264);
+        // 20kB frames each 40ms need 4 Mbit/s
+        muxer.set_mux_rate(1000000);
+        for (int64_t i = 0; i < 50; ++i) {
+            muxer.write_frame(video_stream, data.data(), data.size(), ts_clock + 3600 * i, false);
+            take_datagrams(muxer);
+        }
+        REQUIRE(muxer.get_stats().late_frames > 0);
+        REQUIRE(muxer.get_stats().null_packets == 0);
+    }
+}
+}
+}
@@ -0,0 +1,152 @@
+/*!
+ * @file 		ts_common.h
+ * @author 		agent <agent@local>
+ * @date 		18.10.2026
+ * @copyright	Institute of Intermedia, CTU in Prague, 2026
+ * 				Distributed under modified BSD Licence, details in file doc/LICENSE
+ *
+ */
+
+#ifndef SRC_MODULES_MPEGTS_TS_COMMON_H_
+#define SRC_MODULES_MPEGTS_TS_COMMON_H_
+
+#include "yuri/core/utils/new_types.h"
+#include "yuri/core/frame/compressed_frame_types.h"
+#include <array>
+#include <cstdint>
+
+namespace yuri {
+namespace mpegts {
+
+constexpr size_t   ts_packet_size          = 188;
+constexpr uint8_t  ts_sync_byte            = 0x47;
+constexpr uint16_t pat_pid                 = 0x0000;
+constexpr uint16_t null_pid                = 0x1FFF;
+//! Clock of PTS, DTS and PCR base
+constexpr int64_t  ts_clock                = 90000;
+//! PTS and DTS have 33 bits
+constexpr int64_t  pts_wrap                = int64_t{ 1 } << 33;
+//! Number of TS packets in a datagram, as usual for TS over UDP and RTP
+constexpr size_t   ts_packets_per_datagram = 7;
+constexpr size_t   rtp_header_size         = 12;
+//! Static RTP payload type for MPEG 2 TS (RFC 3551)
+constexpr uint8_t  rtp_payload_mp2t        = 33;
+
+namespace stream_type {
+constexpr uint8_t mpeg2_video = 0x02;
+constexpr uint8_t aac_adts    = 0x0F;
+constexpr uint8_t h264        = 0x1B;
+constexpr uint8_t h265        = 0x24;
+}
+
+//! Returns yuri format for a PMT stream type, 0 for unsupported types
+inline format_t format_from_stream_type(uint8_t type)
+{
+    switch (type) {
+    case stream_type::mpeg2_video:
+        return core::compressed_frame::mpeg2;
+    case stream_type::aac_adts:
+        return core::compressed_frame::aac;
+    case stream_type::h264:
+        return core::compressed_frame::h264;
+    case stream_type::h265:
+        return core::compressed_frame::h265;
+    default:
+        return 0;
+    }
+}
+
+//! Returns PMT stream type for yuri format, 0 for unsupported formats
+inline uint8_t stream_type_from_format(format_t format)
+{
+    switch (format) {
+    case core::compressed_frame::mpeg2:
+        return stream_type::mpeg2_video;
+    case core::compressed_frame::aac:
+        return stream_type::aac_adts;
+    case core::compressed_frame::h264:
+        return stream_type::h264;
+    case core::compressed_frame::h265:
+        return stream_type::h265;
+    default:
+        return 0;
+    }
+}
+
+inline bool is_audio_stream_type(uint8_t type)
+{
+    return type == stream_type::aac_adts;
+}
+
+//! CRC32 used by PSI sections (polynomial 0x04C11DB7, no reflection)
+inline uint32_t crc32_mpeg(const uint8_t* data, size_t size)
+{
+    static const auto table = [] {
+        std::array<uint32_t, 256> t;
+        for (uint32_t i = 0; i < 256; ++i) {
+            uint32_t crc = i << 24;
+            for (int bit = 0; bit < 8; ++bit) {
+                crc = (crc & 0x80000000) ? (crc << 1) ^ 0x04C11DB7 : crc << 1;
+            }
+            t[i] = crc;
+        }
+        return t;
+    }();
+    uint32_t crc = 0xFFFFFFFF;
+    for (size_t i = 0; i < size; ++i) {
+        crc = (crc << 8) ^ table[((crc >> 24) ^ data[i]) & 0xFF];
+    }
+    return crc;
+}
+
+//! Reads 33bit PTS/DTS from 5 bytes of PES header
+inline int64_t read_pes_timestamp(const uint8_t* data)
+{
+    return (static_cast<int64_t>(data[0] & 0x0E) << 29) | (static_cast<int64_t>(data[1]) << 22) | (static_cast<int64_t>(data[2] & 0xFE) << 14)
+         | (static_cast<int64_t>(data[3]) << 7) | (static_cast<int64_t>(data[4]) >> 1);
+}
+
+/*!
+ * Returns offset of the payload in RTP packet (RFC 3550), skipping CSRC list and header extension.
+ * @return offset of the payload or 0 for invalid packets
+ */
+inline size_t rtp_payload_offset(const uint8_t* data, size_t size)
+{
+    if (size < 12 || (data[0] >> 6) != 2)
+        return 0;
+    size_t offset = 12 + 4 * (data[0] & 0x0F);
+    if ((data[0] & 0x10) && offset + 4 <= size) {
+        offset += 4 + 4 * ((data[offset + 2] << 8) | data[offset + 3]);
+    }
+    return offset < size ? offset : 0;
+}
+
+//! Writes RTP header (RFC 3550) without CSRC list and extensions
+inline void write_rtp_header(uint8_t* data, uint8_t payload_type, uint16_t sequence, uint32_t timestamp, uint32_t ssrc)
+{
+    data[0] = 0x80;
+    data[1] = payload_type & 0x7F;
+    data[2] = static_cast<uint8_t>(sequence >> 8);
+    data[3] = static_cast<uint8_t>(sequence);
+    for (int i = 0; i < 4; ++i) {
+        data[4 + i] = static_cast<uint8_t>(timestamp >> (24 - 8 * i));
+        data[8 + i] = static_cast<uint8_t>(ssrc >> (24 - 8 * i));
+    }
+}
+
+/*!
+ * Writes 33bit PTS/DTS as 5 bytes of PES header
+ * @param prefix	4 bit prefix (2 for PTS only, 3 for PTS followed by DTS, 1 for DTS)
+ */
+inline void write_pes_timestamp(uint8_t* data, uint8_t prefix, int64_t timestamp)
+{
+    data[0] = static_cast<uint8_t>((prefix << 4) | ((timestamp >> 29) & 0x0E) | 0x01);
+    data[1] = static_cast<uint8_t>(timestamp >> 22);
+    data[2] = static_cast<uint8_t>(((timestamp >> 14) & 0xFE) | 0x01);
+    data[3] = static_cast<uint8_t>(timestamp >> 7);
+    data[4] = static_cast<uint8_t>(((timestamp << 1) & 0xFE) | 0x01);
+}
+}
+}
+
+#endif /* SRC_MODULES_MPEGTS_TS_COMMON_H_ */
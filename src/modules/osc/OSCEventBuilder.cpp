@@ -0,0 +1,126 @@
+/*!
+ * @file 		OSCEventBuilder.cpp
+ * @author 		agent <agent@local>
+ * @date 		19.10.2026
+ * @copyright	Institute of Intermedia, CTU in Prague, 2026
+ * 				Distributed under modified BSD Licence, details in file doc/LICENSE
+ *
+ */
+
+#include "OSCEventBuilder.h"
+
+namespace yuri {
+namespace osc {
+
+namespace {
+bool has_event(char type)
+{
+	switch (type) {
+		case 'i': case 'h': case 'c': case 'r':
+		case 'f': case 'd':
+		case 's': case 'S':
+		case 'T': case 'F':
+		case 't':
+		case 'N': case 'I':
+			return true;
+		default:
+			return false;
+	}
+}
+
+template<class Event, class... Args>
+std::shared_ptr<Event> get_from(EventPool<Event>& pool, const event::pBasicEvent* element, Args&&... args)
+{
+	if (!element) return pool.get(std::forward<Args>(args)...);
+	// Elements are reused only if the vector is their last holder,
+	// so they can't come from the pool that holds a reference too
+	if (*element && element->use_count() == 1 &&
+			(*element)->get_type() == event::event_traits<Event>::event_type()) {
+		std::atomic_thread_fence(std::memory_order_acquire);
+		return std::static_pointer_cast<Event>(*element);
+	}
+	return std::make_shared<Event>(std::forward<Args>(args)...);
+}
+}
+
+OSCEventBuilder::OSCEventBuilder(size_t pool_size):
+ints_(pool_size),doubles_(pool_size),strings_(pool_size),bools_(pool_size),
+times_(pool_size),vectors_(pool_size),bang_(std::make_shared<event::EventBang>())
+{
+}
+
+event::pBasicEvent OSCEventBuilder::get_event(const osc_message_t& message)
+{
+	OSCArgumentReader reader(message);
+	osc_argument_t argument;
+	const auto count = std::count_if(message.types, message.types + message.types_size, has_event);
+	if (count < 2) {
+		while (reader.next(argument)) {
+			if (auto event = get_argument_event(argument, nullptr)) return event;
+		}
+		return {};
+	}
+	auto vector = vectors_.get();
+	auto& values = vector->get_value();
+	// New elements are allocated directly, so the vector stays their only holder
+	const event::pBasicEvent new_element;
+	size_t index = 0;
+	while (reader.next(argument)) {
+		if (index < values.size()) {
+			if (auto event = get_argument_event(argument, &values[index])) {
+				values[index++] = std::move(event);
+			}
+		} else if (auto event = get_argument_event(argument, &new_element)) {
+			values.push_back(std::move(event));
+			++index;
+		}
+	}
+	values.resize(index);
+	if (!index) return {};
+	return vector;
+}
+
+event::pBasicEvent OSCEventBuilder::get_argument_event(const osc_argument_t& argument, const event::pBasicEvent* element)
+{
+	switch (argument.type) {
+		case 'i':
+		case 'h':
+		case 'c':
+		case 'r': {
+			auto event = get_from(ints_, element, argument.int_value);
+			event->get_value() = argument.int_value;
+			return event;
+		}
+		case 'f':
+		case 'd': {
+			auto event = get_from(doubles_, element, argument.float_value);
+			event->get_value() = argument.float_value;
+			return event;
+		}
+		case 's':
+		case 'S': {
+			auto event = get_from(strings_, element);
+			event->get_value().assign(reinterpret_cast<const char*>(argument.data), argument.size);
+			return event;
+		}
+		case 'T':
+		case 'F': {
+			auto event = get_from(bools_, element);
+			event->get_value() = argument.type == 'T';
+			return event;
+		}
+		case 't': {
+			auto event = get_from(times_, element);
+			event->get_value() = osc_time_to_timestamp(argument.time_value);
+			return event;
+		}
+		case 'N':
+		case 'I':
+			return bang_;
+		default:
+			return {};
+	}
+}
+
+}
+}
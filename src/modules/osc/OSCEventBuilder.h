@@ -0,0 +1,89 @@
+/*!
+ * @file 		OSCEventBuilder.h
+ * @author 		agent <agent@local>
+ * @date 		19.10.2026
+ * @copyright	Institute of Intermedia, CTU in Prague, 2026
+ * 				Distributed under modified BSD Licence, details in file doc/LICENSE
+ *
+ */
+
+#ifndef SRC_MODULES_OSC_OSCEVENTBUILDER_H_
+#define SRC_MODULES_OSC_OSCEVENTBUILDER_H_
+
+#include "OSCPacket.h"
+#include <atomic>
+#include <memory>
+
+namespace yuri {
+namespace osc {
+
+/*!
+ * Ring of events reused once nobody else holds them.
+ *
+ * An event is reused only when the pool holds its last reference,
+ * so the consumers never see the value changing.
+ */
+template<class Event>
+class EventPool {
+public:
+	EventPool(size_t size = 0):events_(size),next_(0) {}
+	/*!
+	 * Returns an event not referenced anywhere else, the caller should set its value.
+	 * @param args Arguments used to construct a new event when none can be reused
+	 */
+	template<class... Args>
+	std::shared_ptr<Event> get(Args&&... args)
+	{
+		if (events_.empty()) return std::make_shared<Event>(std::forward<Args>(args)...);
+		auto& event = events_[next_];
+		if (++next_ == events_.size()) next_ = 0;
+		if (event && event.use_count() == 1) {
+			// Pairs with the release of the reference by the last consumer
+			std::atomic_thread_fence(std::memory_order_acquire);
+			return event;
+		}
+		event = std::make_shared<Event>(std::forward<Args>(args)...);
+		return event;
+	}
+private:
+	std::vector<std::shared_ptr<Event>>	events_;
+	size_t								next_;
+};
+
+/*!
+ * Converts arguments of OSC messages to events.
+ *
+ * Message with a single argument results in a simple event,
+ * more arguments are returned as an EventVector.
+ * Blobs and MIDI arguments are skipped.
+ *
+ * Elements of a reused vector are updated in place when possible,
+ * the simple events are taken from a pool for each type.
+ */
+class OSCEventBuilder {
+public:
+	//! @param pool_size Number of reused events of each type, 0 to allocate every event
+	OSCEventBuilder(size_t pool_size = 0);
+	//! Returns event for the message arguments, or an empty pointer if it has no supported arguments
+	event::pBasicEvent get_event(const osc_message_t& message);
+private:
+	/*!
+	 * Returns event for the argument.
+	 * @param element Vector element to reuse (may be empty), nullptr for events not stored in a vector
+	 */
+	event::pBasicEvent get_argument_event(const osc_argument_t& argument, const event::pBasicEvent* element);
+
+	EventPool<event::EventInt>		ints_;
+	EventPool<event::EventDouble>	doubles_;
+	EventPool<event::EventString>	strings_;
+	EventPool<event::EventBool>		bools_;
+	EventPool<event::EventTime>		times_;
+	EventPool<event::EventVector>	vectors_;
+	//! Bangs have no value, so a single event is shared
+	event::pBasicEvent				bang_;
+};
+
+}
+}
+
+#endif /* SRC_MODULES_OSC_OSCEVENTBUILDER_H_ */
@@ -0,0 +1,318 @@
+/*!
+ * @file 		OSCPacket.cpp
+ * @author 		agent <agent@local>
+ * @date 		19.10.2026
+ * @copyright	Institute of Intermedia, CTU in Prague, 2026
+ * 				Distributed under modified BSD Licence, details in file doc/LICENSE
+ *
+ */
+
+#include "OSCPacket.h"
+#include "yuri/event/EventHelpers.h"
+#include <chrono>
+#include <cstring>
+#include <limits>
+
+namespace yuri {
+namespace osc {
+
+namespace {
+//! Seconds between NTP epoch (1900) and unix epoch (1970)
+const uint64_t ntp_unix_offset = 2208988800ULL;
+const int64_t usec_per_sec = 1000000;
+
+int64_t system_time_usec()
+{
+	return std::chrono::duration_cast<std::chrono::microseconds>(
+			std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+size_t padded_size(size_t size)
+{
+	return (size + 3) & ~static_cast<size_t>(3);
+}
+
+//! Reads NUL terminated string, moving pos after its padding
+bool read_string(const uint8_t*& pos, const uint8_t* end, const uint8_t*& data, size_t& size)
+{
+	const auto terminator = std::find(pos, end, 0);
+	if (terminator == end) return false;
+	data = pos;
+	size = terminator - pos;
+	pos += std::min(padded_size(size + 1), static_cast<size_t>(end - pos));
+	return true;
+}
+
+void write_be32(std::vector<uint8_t>& buffer, uint32_t value)
+{
+	buffer.push_back(static_cast<uint8_t>(value >> 24));
+	buffer.push_back(static_cast<uint8_t>(value >> 16));
+	buffer.push_back(static_cast<uint8_t>(value >> 8));
+	buffer.push_back(static_cast<uint8_t>(value));
+}
+
+void write_be32(uint8_t* data, uint32_t value)
+{
+	data[0] = static_cast<uint8_t>(value >> 24);
+	data[1] = static_cast<uint8_t>(value >> 16);
+	data[2] = static_cast<uint8_t>(value >> 8);
+	data[3] = static_cast<uint8_t>(value);
+}
+
+void write_be64(std::vector<uint8_t>& buffer, uint64_t value)
+{
+	write_be32(buffer, static_cast<uint32_t>(value >> 32));
+	write_be32(buffer, static_cast<uint32_t>(value));
+}
+
+void write_padding(std::vector<uint8_t>& buffer)
+{
+	buffer.resize(padded_size(buffer.size()), 0);
+}
+
+void write_string(std::vector<uint8_t>& buffer, const std::string& value)
+{
+	buffer.insert(buffer.end(), value.begin(), value.end());
+	buffer.push_back(0);
+	write_padding(buffer);
+}
+
+//! Returns type tag for the event, or 0 for unsupported events
+char get_type_tag(const event::pBasicEvent& event)
+{
+	switch (event->get_type()) {
+		case event::event_type_t::integer_event: {
+			const auto value = event::get_value<event::EventInt>(event);
+			return (value >= std::numeric_limits<int32_t>::min() &&
+					value <= std::numeric_limits<int32_t>::max()) ? 'i' : 'h';
+		}
+		case event::event_type_t::double_event: return 'f';
+		case event::event_type_t::string_event: return 's';
+		case event::event_type_t::boolean_event: return event::get_value<event::EventBool>(event) ? 'T' : 'F';
+		case event::event_type_t::bang_event: return 'N';
+		case event::event_type_t::time_event: return 't';
+		default: return 0;
+	}
+}
+
+void write_value(std::vector<uint8_t>& buffer, char type, const event::pBasicEvent& event)
+{
+	switch (type) {
+		case 'i': write_be32(buffer, static_cast<uint32_t>(event::get_value<event::EventInt>(event))); break;
+		case 'h': write_be64(buffer, static_cast<uint64_t>(event::get_value<event::EventInt>(event))); break;
+		case 'f': {
+			const float value = static_cast<float>(event::get_value<event::EventDouble>(event));
+			uint32_t bits;
+			std::memcpy(&bits, &value, sizeof(bits));
+			write_be32(buffer, bits);
+		} break;
+		case 's': write_string(buffer, event::get_value<event::EventString>(event)); break;
+		case 't': write_be64(buffer, timestamp_to_osc_time(event::get_value<event::EventTime>(event))); break;
+		default: break;
+	}
+}
+
+//! Writes type tags and values of the event
+bool write_arguments(std::vector<uint8_t>& buffer, const event::pBasicEvent& event)
+{
+	buffer.push_back(',');
+	if (event->get_type() != event::event_type_t::vector_event) {
+		const char type = get_type_tag(event);
+		if (!type) return false;
+		buffer.push_back(type);
+		buffer.push_back(0);
+		write_padding(buffer);
+		write_value(buffer, type, event);
+		return true;
+	}
+	const auto& values = event::get_value<event::EventVector>(event);
+	for (const auto& value: values) {
+		const char type = get_type_tag(value);
+		if (!type) return false;
+		buffer.push_back(type);
+	}
+	buffer.push_back(0);
+	write_padding(buffer);
+	for (const auto& value: values) {
+		write_value(buffer, get_type_tag(value), value);
+	}
+	return true;
+}
+
+}
+
+timestamp_t osc_time_to_timestamp(uint64_t time_tag)
+{
+	const timestamp_t now;
+	if (time_tag == osc_time_immediate) return now;
+	const int64_t seconds = static_cast<int64_t>(time_tag >> 32) - static_cast<int64_t>(ntp_unix_offset);
+	const int64_t fraction = static_cast<int64_t>(((time_tag & 0xFFFFFFFFULL) * usec_per_sec) >> 32);
+	return now + duration_t{seconds * usec_per_sec + fraction - system_time_usec()};
+}
+
+uint64_t timestamp_to_osc_time(timestamp_t time)
+{
+	const int64_t usec = system_time_usec() + (time - timestamp_t{}).value;
+	const uint64_t seconds = static_cast<uint64_t>(usec / usec_per_sec) + ntp_unix_offset;
+	const uint64_t fraction = (static_cast<uint64_t>(usec % usec_per_sec) << 32) / usec_per_sec;
+	return (seconds << 32) | fraction;
+}
+
+bool parse_osc_message(const uint8_t* data, size_t size, osc_message_t& message)
+{
+	const uint8_t* pos = data;
+	const uint8_t* end = data + size;
+	const uint8_t* address = nullptr;
+	if (!read_string(pos, end, address, message.address_size) || !message.address_size) return false;
+	message.address = reinterpret_cast<const char*>(address);
+	message.types = "";
+	message.types_size = 0;
+	// Messages without type tags have no arguments
+	if (pos != end) {
+		if (*pos != ',') return false;
+		const uint8_t* types = nullptr;
+		if (!read_string(pos, end, types, message.types_size)) return false;
+		message.types = reinterpret_cast<const char*>(types) + 1;
+		--message.types_size;
+	}
+	message.arguments = pos;
+	message.end = end;
+	message.time_tag = osc_time_immediate;
+	return true;
+}
+
+OSCArgumentReader::OSCArgumentReader(const osc_message_t& message):
+type_(message.types),types_end_(message.types + message.types_size),
+pos_(message.arguments),end_(message.end)
+{
+}
+
+bool OSCArgumentReader::next(osc_argument_t& argument)
+{
+	// Array delimiters are ignored, the values are returned flattened
+	while (type_ != types_end_ && (*type_ == '[' || *type_ == ']')) ++type_;
+	if (type_ == types_end_) return false;
+	argument.type = *type_++;
+	const size_t available = end_ - pos_;
+	switch (argument.type) {
+		case 'i':
+		case 'c':
+		case 'r':
+		case 'm':
+			if (available < 4) return false;
+			argument.int_value = argument.type == 'i' ?
+					static_cast<int32_t>(read_be32(pos_)) : static_cast<int64_t>(read_be32(pos_));
+			pos_ += 4;
+			break;
+		case 'f': {
+			if (available < 4) return false;
+			const uint32_t bits = read_be32(pos_);
+			float value;
+			std::memcpy(&value, &bits, sizeof(value));
+			argument.float_value = value;
+			pos_ += 4;
+		} break;
+		case 'h':
+			if (available < 8) return false;
+			argument.int_value = static_cast<int64_t>(read_be64(pos_));
+			pos_ += 8;
+			break;
+		case 'd': {
+			if (available < 8) return false;
+			const uint64_t bits = read_be64(pos_);
+			std::memcpy(&argument.float_value, &bits, sizeof(bits));
+			pos_ += 8;
+		} break;
+		case 't':
+			if (available < 8) return false;
+			argument.time_value = read_be64(pos_);
+			pos_ += 8;
+			break;
+		case 's':
+		case 'S':
+			if (!read_string(pos_, end_, argument.data, argument.size)) return false;
+			break;
+		case 'b': {
+			if (available < 4) return false;
+			argument.size = read_be32(pos_);
+			if (argument.size > available - 4) return false;
+			argument.data = pos_ + 4;
+			pos_ += std::min(4 + padded_size(argument.size), available);
+		} break;
+		case 'T':
+		case 'F':
+		case 'N':
+		case 'I':
+			break;
+		default:
+			// Size of unknown types is not known, so the rest can't be read
+			return false;
+	}
+	return true;
+}
+
+OSCBundleWriter::OSCBundleWriter(size_t max_size, bool bundle):
+max_size_(max_size),bundle_(bundle),time_tag_(osc_time_immediate),messages_(0)
+{
+}
+
+void OSCBundleWriter::start_packet()
+{
+	packets_.push_back(buffer_.size());
+	if (bundle_) {
+		write_string(buffer_, "#bundle");
+		write_be64(buffer_, time_tag_);
+	}
+}
+
+bool OSCBundleWriter::add_message(const std::string& name, const event::pBasicEvent& event)
+{
+	if (!event) return false;
+	const size_t rollback = buffer_.size();
+	const bool new_packet = packets_.empty() || !bundle_;
+	if (new_packet) start_packet();
+	const size_t element_start = buffer_.size();
+	// Size of the bundle element is filled in after the message is written
+	if (bundle_) write_be32(buffer_, 0);
+	const size_t message_start = buffer_.size();
+	write_string(buffer_, name);
+	if (!write_arguments(buffer_, event)) {
+		buffer_.resize(rollback);
+		if (new_packet) packets_.pop_back();
+		return false;
+	}
+	if (bundle_) {
+		write_be32(&buffer_[element_start], static_cast<uint32_t>(buffer_.size() - message_start));
+		if (!new_packet && buffer_.size() - packets_.back() > max_size_) {
+			// The message doesn't fit into current bundle, so it's moved to a new one
+			buffer_.insert(buffer_.begin() + element_start, 16, 0);
+			std::copy_n("#bundle", 8, &buffer_[element_start]);
+			write_be32(&buffer_[element_start + 8], static_cast<uint32_t>(time_tag_ >> 32));
+			write_be32(&buffer_[element_start + 12], static_cast<uint32_t>(time_tag_));
+			packets_.push_back(element_start);
+		}
+	}
+	++messages_;
+	return true;
+}
+
+const std::vector<core::socket::datagram_t>& OSCBundleWriter::get_datagrams()
+{
+	datagrams_.clear();
+	for (size_t i = 0; i < packets_.size(); ++i) {
+		const size_t end = i + 1 < packets_.size() ? packets_[i + 1] : buffer_.size();
+		datagrams_.push_back({&buffer_[packets_[i]], end - packets_[i]});
+	}
+	return datagrams_;
+}
+
+void OSCBundleWriter::clear()
+{
+	buffer_.clear();
+	packets_.clear();
+	datagrams_.clear();
+	messages_ = 0;
+}
+
+}
+}
@@ -0,0 +1,172 @@
+/*!
+ * @file 		OSCPacket.h
+ * @author 		agent <agent@local>
+ * @date 		19.10.2026
+ * @copyright	Institute of Intermedia, CTU in Prague, 2026
+ * 				Distributed under modified BSD Licence, details in file doc/LICENSE
+ *
+ */
+
+#ifndef SRC_MODULES_OSC_OSCPACKET_H_
+#define SRC_MODULES_OSC_OSCPACKET_H_
+
+#include "yuri/core/utils/time_types.h"
+#include "yuri/core/socket/DatagramSocket.h"
+#include "yuri/event/BasicEvent.h"
+#include <algorithm>
+#include <string>
+#include <vector>
+
+namespace yuri {
+namespace osc {
+
+//! Time tag meaning 'immediately'
+const uint64_t osc_time_immediate = 1;
+//! Maximal nesting of bundles accepted by the parser
+const int max_bundle_depth = 8;
+
+//! Converts OSC (NTP) time tag to local time. Returns current time for osc_time_immediate.
+timestamp_t osc_time_to_timestamp(uint64_t time_tag);
+//! Converts local time to OSC (NTP) time tag
+uint64_t timestamp_to_osc_time(timestamp_t time);
+
+/*!
+ * OSC message, referencing the received data directly.
+ * The message is valid only as long as the data.
+ */
+struct osc_message_t {
+	const char*		address;
+	size_t			address_size;
+	//! Type tags without the leading ','
+	const char*		types;
+	size_t			types_size;
+	const uint8_t*	arguments;
+	const uint8_t*	end;
+	//! Time tag of the enclosing bundle, osc_time_immediate for messages outside of bundles
+	uint64_t		time_tag;
+};
+
+//! Single argument of a message
+struct osc_argument_t {
+	char			type;
+	//! Value for i, h, c, r and m arguments
+	int64_t			int_value;
+	//! Value for f and d arguments
+	double			float_value;
+	//! Value for t arguments
+	uint64_t		time_value;
+	//! Data for s, S and b arguments
+	const uint8_t*	data;
+	size_t			size;
+};
+
+/*!
+ * Parses single message (not a bundle)
+ * @return false for malformed data
+ */
+bool parse_osc_message(const uint8_t* data, size_t size, osc_message_t& message);
+
+inline bool is_osc_bundle(const uint8_t* data, size_t size)
+{
+	return size >= 8 && std::equal(data, data + 8, "#bundle");
+}
+
+inline uint32_t read_be32(const uint8_t* data)
+{
+	return (static_cast<uint32_t>(data[0]) << 24) | (data[1] << 16) | (data[2] << 8) | data[3];
+}
+
+inline uint64_t read_be64(const uint8_t* data)
+{
+	return (static_cast<uint64_t>(read_be32(data)) << 32) | read_be32(data + 4);
+}
+
+/*!
+ * Parses a packet and calls handler(const osc_message_t&) for every message in it,
+ * including the messages in nested bundles.
+ * @return false for malformed packets. Messages preceding the error are still passed to the handler.
+ */
+template<class Handler>
+bool parse_osc_packet(const uint8_t* data, size_t size, Handler&& handler,
+		uint64_t time_tag = osc_time_immediate, int depth = 0)
+{
+	if (is_osc_bundle(data, size)) {
+		if (size < 16 || depth >= max_bundle_depth) return false;
+		time_tag = read_be64(data + 8);
+		const uint8_t* pos = data + 16;
+		const uint8_t* end = data + size;
+		while (pos < end) {
+			if (end - pos < 4) return false;
+			const size_t element_size = read_be32(pos);
+			pos += 4;
+			if (element_size > static_cast<size_t>(end - pos)) return false;
+			if (!parse_osc_packet(pos, element_size, handler, time_tag, depth + 1)) return false;
+			pos += element_size;
+		}
+		return true;
+	}
+	osc_message_t message;
+	if (!parse_osc_message(data, size, message)) return false;
+	message.time_tag = time_tag;
+	handler(message);
+	return true;
+}
+
+//! Reads arguments of a message
+class OSCArgumentReader {
+public:
+	OSCArgumentReader(const osc_message_t& message);
+	/*!
+	 * Reads next argument
+	 * @return false at the end of the message or for truncated data
+	 */
+	bool next(osc_argument_t& argument);
+private:
+	const char*		type_;
+	const char*		types_end_;
+	const uint8_t*	pos_;
+	const uint8_t*	end_;
+};
+
+/*!
+ * Encodes events into OSC packets.
+ *
+ * When bundling is enabled, the messages are collected into bundles
+ * not exceeding the maximal size (a single larger message gets its own bundle).
+ * Otherwise every message is stored as a separate packet.
+ * All packets are stored in a single buffer reused between the calls.
+ */
+class OSCBundleWriter {
+public:
+	OSCBundleWriter(size_t max_size = 1472, bool bundle = true);
+
+	//! Sets time tag for bundles started after this call
+	void set_time_tag(uint64_t time_tag) { time_tag_ = time_tag; }
+	/*!
+	 * Appends a message for the event
+	 * @return false for events that can't be encoded
+	 */
+	bool add_message(const std::string& name, const event::pBasicEvent& event);
+	//! Returns all packets, valid until the writer is modified
+	const std::vector<core::socket::datagram_t>& get_datagrams();
+	size_t get_message_count() const { return messages_; }
+	bool empty() const { return packets_.empty(); }
+	//! Removes all packets, keeping the allocated buffers
+	void clear();
+private:
+	void start_packet();
+
+	size_t								max_size_;
+	bool								bundle_;
+	uint64_t							time_tag_;
+	std::vector<uint8_t>				buffer_;
+	//! Offsets of the packets in buffer_
+	std::vector<size_t>					packets_;
+	size_t								messages_;
+	std::vector<core::socket::datagram_t>	datagrams_;
+};
+
+}
+}
+
+#endif /* SRC_MODULES_OSC_OSCPACKET_H_ */
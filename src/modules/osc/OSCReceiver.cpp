@@ -8,10 +8,9 @@
  */
 
 #include "OSCReceiver.h"
-#include "OSC.h"
 #include "yuri/core/Module.h"
 #include "yuri/core/socket/DatagramSocketGenerator.h"
-#include <tuple>
+#include "yuri/core/utils/make_unique.h"
 
 namespace yuri {
 namespace osc {
@@ -25,6 +24,8 @@ core::Parameters OSCReceiver::configure()
 	p["socket_type"]="yuri_udp";
 	p["port"]=57120;
 	p["address"]="0.0.0.0";
+	p["time_tags"]["Emit events from bundles at the time specified by their time tags. When disabled, all events are emitted immediately."]=true;
+	p["event_pool"]["Number of events of each type reused for incoming messages. Set to 0 to allocate new events for every message."]=64;
 	//p->set_max_pipes(0,0);
 	return p;
 }
@@ -32,12 +33,12 @@ core::Parameters OSCReceiver::configure()
 
 OSCReceiver::OSCReceiver(const log::Log &log_, core::pwThreadBase parent, const core::Parameters &parameters):
 core::IOThread(log_,parent,0,0,std::string("osc_receiver")),
-event::BasicEventProducer(log),port_(2000),socket_type_("yuri_udp")
+event::BasicEventProducer(log),port_(2000),socket_type_("yuri_udp"),
+time_tags_(true),event_pool_(64),malformed_(0)
 {
 	set_latency(100_ms);
 	IOTHREAD_INIT(parameters)
-
-
+	builder_ = make_unique<OSCEventBuilder>(event_pool_);
 }
 
 OSCReceiver::~OSCReceiver() noexcept
@@ -58,30 +59,60 @@ void OSCReceiver::run()
 		return;
 	}
 	log[log::info] << "Socket initialized";
-	std::vector<uint8_t> buffer(65536);
-	ssize_t read_bytes=0;
+	// All available datagrams are read with a single call if possible
+	core::socket::DatagramBatch datagrams;
+	const auto handler = [this](const osc_message_t& message){ process_message(message); };
 	while(still_running()) {
-		if (socket_->wait_for_data(get_latency())) {
-			log[log::verbose_debug] << "reading data";
-			read_bytes = socket_->receive_datagram(&buffer[0],buffer.size());
-			if (read_bytes > 0) {
-				log[log::verbose_debug] << "Read " << read_bytes << " bytes";
-				auto first = buffer.begin();
-//				auto events_pair = process_data(first, first + read_bytes, log);
-				auto events_pair = parse_packet(first, first + read_bytes, log);
-				auto events = std::get<1>(events_pair);
-				if (events.empty()) continue;
-				if (events.size() == 1) {
-					emit_event(std::get<0>(events_pair), events[0]);
-				} else {
-					emit_event(std::get<0>(events_pair), std::make_shared<event::EventVector>(std::move(events)));
+		auto timeout = get_latency();
+		if (!scheduled_.empty()) {
+			const auto remaining = scheduled_.begin()->first - timestamp_t{};
+			timeout = remaining < timeout ? remaining : timeout;
+		}
+		if (timeout.value > 0 && socket_->wait_for_data(timeout)) {
+			const auto count = datagrams.receive(*socket_);
+			for (size_t i = 0; i < count; ++i) {
+				if (!datagrams[i].size) continue;
+				// Messages are parsed directly from the receive buffer
+				if (!parse_osc_packet(datagrams[i].data, datagrams[i].size, handler)) {
+					++malformed_;
+					log[log::debug] << "Malformed OSC packet of " << datagrams[i].size << " bytes";
 				}
 			}
 		}
+		emit_scheduled();
+	}
+	if (malformed_) {
+		log[log::warning] << "Received " << malformed_ << " malformed packets";
 	}
-//	IO_THREAD_POST_RUN
 	log[log::info] << "QUIT";
 }
+
+void OSCReceiver::process_message(const osc_message_t& message)
+{
+	auto event = builder_->get_event(message);
+	if (!event) return;
+	name_.assign(message.address, message.address_size);
+	if (time_tags_ && message.time_tag != osc_time_immediate) {
+		const auto time = osc_time_to_timestamp(message.time_tag);
+		if (time > timestamp_t{}) {
+			scheduled_.emplace(time, std::make_pair(name_, std::move(event)));
+			return;
+		}
+	}
+	emit_event(name_, std::move(event));
+}
+
+void OSCReceiver::emit_scheduled()
+{
+	if (scheduled_.empty()) return;
+	const timestamp_t now;
+	auto it = scheduled_.begin();
+	for (; it != scheduled_.end() && it->first <= now; ++it) {
+		emit_event(it->second.first, it->second.second);
+	}
+	scheduled_.erase(scheduled_.begin(), it);
+}
+
 bool OSCReceiver::set_param(const core::Parameter& param)
 {
 	if (param.get_name() == "socket_type") {
@@ -90,6 +121,10 @@ bool OSCReceiver::set_param(const core::Parameter& param)
 		address_ = param.get<std::string>();
 	} else if (param.get_name() == "port") {
 		port_ = param.get<uint16_t>();
+	} else if (param.get_name() == "time_tags") {
+		time_tags_ = param.get<bool>();
+	} else if (param.get_name() == "event_pool") {
+		event_pool_ = param.get<size_t>();
 	} else return core::IOThread::set_param(param);
 	return true;
 }
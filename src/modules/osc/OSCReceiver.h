@@ -13,6 +13,8 @@
 #include "yuri/core/thread/IOThread.h"
 #include "yuri/event/BasicEventProducer.h"
 #include "yuri/core/socket/DatagramSocket.h"
+#include "OSCEventBuilder.h"
+#include <map>
 
 namespace yuri {
 namespace osc {
@@ -28,12 +30,22 @@ private:
 
 	virtual void run() override;
 	virtual bool set_param(const core::Parameter& param) override;
-//	template<class Iterator>
-//	void process_data(Iterator& first, const Iterator& last);
+	//! Emits events for the message, or schedules them if the message has a time tag in future
+	void process_message(const osc_message_t& message);
+	//! Emits all scheduled events that are due
+	void emit_scheduled();
 	std::shared_ptr<core::socket::DatagramSocket> socket_;
 	uint16_t	port_;
 	std::string socket_type_;
 	std::string address_;
+	bool		time_tags_;
+	size_t		event_pool_;
+	std::unique_ptr<OSCEventBuilder> builder_;
+	//! Name of the current message, reused to avoid allocations
+	std::string name_;
+	//! Events from bundles with time tags in future
+	std::multimap<timestamp_t, std::pair<std::string, event::pBasicEvent>> scheduled_;
+	size_t		malformed_;
 };
 
 } /* namespace osc_receiver */
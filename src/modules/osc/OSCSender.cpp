@@ -8,9 +8,9 @@
  */
 
 #include "OSCSender.h"
-#include "OSC.h"
 #include "yuri/core/Module.h"
 #include "yuri/core/socket/DatagramSocketGenerator.h"
+#include "yuri/core/utils/make_unique.h"
 
 namespace yuri {
 namespace osc {
@@ -26,14 +26,20 @@ core::Parameters OSCSender::configure()
 	p["address"]["Remote address"]="127.0.0.1";
 	p["socket_type"]="yuri_udp";
 	p["port"]=57120;
+	p["bundle"]["Send the messages in bundles. When disabled, every message is sent in a separate packet."]=true;
+	p["max_size"]["Maximal size of a bundle in bytes"]=1472;
+	p["interval"]["Time (in seconds) to collect events for a single bundle. Set to 0 to send events as soon as possible."]=0.001;
+	p["delay"]["Delay (in seconds) of the time tag of the bundles, so the receiver can compensate the network jitter. Set to 0 to use immediate time tag."]=0.0;
 	return p;
 }
 
 
 OSCSender::OSCSender(const log::Log &log_, core::pwThreadBase parent, const core::Parameters &parameters):
-core::IOThread(log_,parent,1,1,std::string("osc_sender")),event::BasicEventConsumer(log)
+core::IOThread(log_,parent,1,1,std::string("osc_sender")),event::BasicEventConsumer(log),
+bundle_(true),max_size_(1472),interval_(1_ms),delay_(0_s)
 {
 	IOTHREAD_INIT(parameters)
+	writer_ = make_unique<OSCBundleWriter>(max_size_, bundle_);
 }
 
 OSCSender::~OSCSender() noexcept
@@ -53,8 +59,12 @@ void OSCSender::run()
 	log[log::info] << "Socket initialized";
 
 	while (still_running()) {
-		wait_for_events(get_latency());
+		if (!wait_for_events(get_latency())) continue;
+		// Events received during the interval are sent together
+		if (interval_.value > 0) ThreadBase::sleep(interval_);
+		writer_->set_time_tag(delay_.value > 0 ? timestamp_to_osc_time(timestamp_t{} + delay_) : osc_time_immediate);
 		process_events();
+		send_messages();
 	}
 }
 bool OSCSender::set_param(const core::Parameter& param)
@@ -65,6 +75,14 @@ bool OSCSender::set_param(const core::Parameter& param)
 		port_ = param.get<uint16_t>();
 	} else if (param.get_name() == "address") {
 		address_ = param.get<std::string>();
+	} else if (param.get_name() == "bundle") {
+		bundle_ = param.get<bool>();
+	} else if (param.get_name() == "max_size") {
+		max_size_ = param.get<size_t>();
+	} else if (param.get_name() == "interval") {
+		interval_ = 1_s * param.get<double>();
+	} else if (param.get_name() == "delay") {
+		delay_ = 1_s * param.get<double>();
 	} else {
 	    return core::IOThread::set_param(param);
 	}
@@ -73,12 +91,22 @@ bool OSCSender::set_param(const core::Parameter& param)
 
 bool OSCSender::do_process_event(const std::string& event_name, const event::pBasicEvent& event)
 {
-	std::string message=encode_osc(event_name, event, true);
-//	log[log::info] << "message size " << message.size();
-	if (!message.empty()) {
-		socket_->send_datagram(message);
+	if (!writer_->add_message(event_name, event)) {
+		log[log::debug] << "Unsupported event type for " << event_name;
 	}
 	return true;
 }
+
+void OSCSender::send_messages()
+{
+	if (writer_->empty()) return;
+	// Messages for all events processed in one step are sent together
+	const auto& datagrams = writer_->get_datagrams();
+	const auto sent = socket_->send_datagrams(datagrams);
+	if (sent < datagrams.size()) {
+		log[log::warning] << "Failed to send " << (datagrams.size() - sent) << " of " << datagrams.size() << " packets";
+	}
+	writer_->clear();
+}
 } /* namespace osc_sender */
 } /* namespace yuri */
@@ -13,6 +13,7 @@
 #include "yuri/core/thread/IOThread.h"
 #include "yuri/event/BasicEventConsumer.h"
 #include "yuri/core/socket/DatagramSocket.h"
+#include "OSCPacket.h"
 namespace yuri {
 namespace osc {
 
@@ -28,12 +29,19 @@ private:
 	virtual void run() override;
 	virtual bool set_param(const core::Parameter& param) override;
 	virtual bool do_process_event(const std::string& event_name, const event::pBasicEvent& event) override;
+	void send_messages();
 
 	std::shared_ptr<core::socket::DatagramSocket> socket_;
 
 	uint16_t	port_;
 	std::string socket_type_;
 	std::string address_;
+	bool		bundle_;
+	size_t		max_size_;
+	duration_t	interval_;
+	duration_t	delay_;
+	//! Messages waiting to be sent
+	std::unique_ptr<OSCBundleWriter> writer_;
 };
 
 } /* namespace osc_sender */
@@ -0,0 +1,203 @@
+/*!
+ * @file 		osc_benchmark.cpp
+ * @author 		agent <agent@local>
+ * @date 		19.10.2026
+ * @copyright	Institute of Intermedia, CTU in Prague, 2026
+ * 				Distributed under modified BSD Licence, details in file doc/LICENSE
+ *
+ * Throughput test of OSC encoding and parsing. Measures the bundle writer,
+ * the original parse_packet() and the zero-copy parser with pooled events,
+ * and finally streams bundles over loopback at a fixed message rate.
+ *
+ * Usage: osc_benchmark [messages] [rate in msgs/s] [seconds]
+ */
+
+#include "OSC.h"
+#include "OSCPacket.h"
+#include "OSCEventBuilder.h"
+#include <atomic>
+#include <cstdlib>
+#include <iostream>
+#include <thread>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+using namespace yuri;
+using namespace yuri::osc;
+
+namespace {
+
+const size_t sensor_count = 16;
+//! Messages collected before the bundles are finished, as in a single tick of osc_sender
+const size_t messages_per_tick = 64;
+
+void report(const std::string& name, size_t messages, timestamp_t start)
+{
+	const duration_t elapsed = timestamp_t{} - start;
+	const double seconds = elapsed.value / 1e6;
+	std::cout << name << ": " << messages << " messages in " << seconds << " s, "
+			<< static_cast<size_t>(messages / seconds) << " msgs/s\n";
+}
+
+using packets_t = std::vector<std::vector<uint8_t>>;
+
+//! Encodes messages with three floats, as sent by typical motion sensors
+packets_t encode(const std::vector<std::string>& names, size_t messages, bool bundle)
+{
+	std::vector<event::pBasicEvent> events;
+	for (size_t i = 0; i < names.size(); ++i) {
+		events.push_back(std::make_shared<event::EventVector>(std::vector<event::pBasicEvent>{
+			std::make_shared<event::EventDouble>(0.1 * i),
+			std::make_shared<event::EventDouble>(0.2 * i),
+			std::make_shared<event::EventDouble>(0.3 * i)}));
+	}
+	packets_t packets;
+	OSCBundleWriter writer(1472, bundle);
+	const timestamp_t start;
+	for (size_t i = 0; i < messages; ++i) {
+		writer.add_message(names[i % names.size()], events[i % events.size()]);
+		if (writer.get_message_count() == messages_per_tick || i + 1 == messages) {
+			for (const auto& datagram: writer.get_datagrams()) {
+				packets.emplace_back(datagram.data, datagram.data + datagram.size);
+			}
+			writer.clear();
+		}
+	}
+	report(bundle ? "encode bundles" : "encode messages", messages, start);
+	return packets;
+}
+
+void parse_legacy(const packets_t& packets, size_t messages)
+{
+	log::Log l(std::cerr);
+	l.set_quiet(true);
+	size_t parsed = 0;
+	const timestamp_t start;
+	for (const auto& packet: packets) {
+		auto first = packet.begin();
+		auto events_pair = parse_packet(first, packet.end(), l);
+		auto events = std::get<1>(events_pair);
+		if (events.size() > 1) {
+			auto event = std::make_shared<event::EventVector>(std::move(events));
+			++parsed;
+		} else if (!events.empty()) {
+			++parsed;
+		}
+	}
+	if (parsed != messages) std::cerr << "Parsed only " << parsed << " messages\n";
+	report("parse_packet", parsed, start);
+}
+
+size_t parse(const uint8_t* data, size_t size, OSCEventBuilder& builder, std::string& name)
+{
+	size_t parsed = 0;
+	parse_osc_packet(data, size, [&](const osc_message_t& message) {
+		name.assign(message.address, message.address_size);
+		if (builder.get_event(message)) ++parsed;
+	});
+	return parsed;
+}
+
+void parse_zero_copy(const std::string& test, const packets_t& packets, size_t messages, size_t pool_size)
+{
+	OSCEventBuilder builder(pool_size);
+	std::string name;
+	size_t parsed = 0;
+	const timestamp_t start;
+	for (const auto& packet: packets) {
+		parsed += parse(packet.data(), packet.size(), builder, name);
+	}
+	if (parsed != messages) std::cerr << "Parsed only " << parsed << " messages\n";
+	report(test, parsed, start);
+}
+
+//! Sends the packets over loopback at given rate and parses them in another thread
+void stream(const packets_t& packets, size_t rate, double seconds)
+{
+	const int receiver = ::socket(AF_INET, SOCK_DGRAM, 0);
+	const int sender = ::socket(AF_INET, SOCK_DGRAM, 0);
+	sockaddr_in addr{};
+	addr.sin_family = AF_INET;
+	addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	if (receiver < 0 || sender < 0 || ::bind(receiver, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0) {
+		std::cerr << "Failed to create sockets\n";
+		return;
+	}
+	socklen_t len = sizeof(addr);
+	::getsockname(receiver, reinterpret_cast<sockaddr*>(&addr), &len);
+	const int buffer_size = 8 << 20;
+	::setsockopt(receiver, SOL_SOCKET, SO_RCVBUF, &buffer_size, sizeof(buffer_size));
+	timeval timeout{0, 200000};
+	::setsockopt(receiver, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+	OSCEventBuilder builder;
+	std::string name;
+	std::vector<size_t> counts;
+	for (const auto& packet: packets) {
+		counts.push_back(parse(packet.data(), packet.size(), builder, name));
+	}
+
+	std::atomic<size_t> received{0};
+	std::atomic<bool> sending{true};
+	std::thread reader([&]() {
+		OSCEventBuilder receive_builder(64);
+		std::string address;
+		std::vector<uint8_t> buffer(65536);
+		for (;;) {
+			const auto size = ::recv(receiver, buffer.data(), buffer.size(), 0);
+			if (size > 0) {
+				received += parse(buffer.data(), size, receive_builder, address);
+			} else if (!sending) {
+				break;
+			}
+		}
+	});
+
+	// Packets are paced by the number of messages they carry
+	const size_t total = static_cast<size_t>(seconds * rate);
+	const timestamp_t start;
+	auto next = start;
+	size_t sent = 0;
+	for (size_t i = 0; sent < total; ++i) {
+		const auto& packet = packets[i % packets.size()];
+		const auto count = counts[i % packets.size()];
+		if (::sendto(sender, packet.data(), packet.size(), 0, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) > 0) {
+			sent += count;
+		}
+		next += duration_t{static_cast<int64_t>(1e6 * count / rate)};
+		const timestamp_t now;
+		if (next > now) std::this_thread::sleep_for(std::chrono::microseconds((next - now).value));
+	}
+	report("send at " + std::to_string(rate) + " msgs/s", sent, start);
+	sending = false;
+	reader.join();
+	std::cout << "received " << received << " of " << sent << " messages\n";
+	::close(receiver);
+	::close(sender);
+}
+
+}
+
+int main(int argc, char** argv)
+{
+	const size_t messages = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 1000000;
+	const size_t rate = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 100000;
+	const double seconds = argc > 3 ? std::strtod(argv[3], nullptr) : 2.0;
+
+	std::vector<std::string> names;
+	for (size_t i = 0; i < sensor_count; ++i) {
+		names.push_back("/sensor/" + std::to_string(i) + "/accel");
+	}
+	const auto messages_only = encode(names, messages, false);
+	const auto bundles = encode(names, messages, true);
+
+	parse_legacy(messages_only, messages);
+	parse_zero_copy("parse messages", messages_only, messages, 0);
+	parse_zero_copy("parse messages, pooled events", messages_only, messages, 64);
+	parse_zero_copy("parse bundles, pooled events", bundles, messages, 64);
+
+	stream(bundles, rate, seconds);
+	return 0;
+}
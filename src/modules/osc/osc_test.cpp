@@ -10,6 +10,8 @@
 #include "tests/catch.hpp"
 #include "yuri/core/utils/irange.h"
 #include "OSC.h"
+#include "OSCPacket.h"
+#include "OSCEventBuilder.h"
 namespace yuri {
 namespace osc {
 
@@ -133,5 +135,160 @@ TEST_CASE( "OSC Decoding", "[module]" ) {
 
 
 }
+namespace {
+	struct received_message_t {
+		std::string name;
+		event::pBasicEvent event;
+		uint64_t time_tag;
+	};
+
+	std::vector<received_message_t> parse_all(const uint8_t* data, size_t size, OSCEventBuilder& builder, bool& valid)
+	{
+		std::vector<received_message_t> messages;
+		valid = parse_osc_packet(data, size, [&](const osc_message_t& message){
+			messages.push_back({std::string(message.address, message.address_size), builder.get_event(message), message.time_tag});
+		});
+		return messages;
+	}
+}
+
+TEST_CASE( "OSC bundles", "[module]" ) {
+	OSCEventBuilder builder;
+	bool valid = false;
+
+	SECTION("messages in a bundle") {
+		OSCBundleWriter writer;
+		writer.set_time_tag(0x0102030405060708ULL);
+		REQUIRE( writer.add_message("/a", std::make_shared<event::EventInt>(test_value2)) );
+		REQUIRE( writer.add_message("/b", std::make_shared<event::EventString>(test_value1)) );
+		REQUIRE( writer.add_message("/c", std::make_shared<event::EventVector>(test_value7)) );
+		REQUIRE( !writer.add_message("/d", std::make_shared<event::EventDuration>(1_s)) );
+		REQUIRE( writer.get_message_count() == 3 );
+		const auto& datagrams = writer.get_datagrams();
+		REQUIRE( datagrams.size() == 1 );
+		REQUIRE( is_osc_bundle(datagrams[0].data, datagrams[0].size) );
+
+		const auto messages = parse_all(datagrams[0].data, datagrams[0].size, builder, valid);
+		REQUIRE( valid );
+		REQUIRE( messages.size() == 3 );
+		REQUIRE( messages[0].name == "/a" );
+		REQUIRE( messages[0].time_tag == 0x0102030405060708ULL );
+		REQUIRE( event::lex_cast_value<int32_t>(messages[0].event) == test_value2 );
+		REQUIRE( event::lex_cast_value<std::string>(messages[1].event) == test_value1 );
+		REQUIRE( messages[2].event->get_type() == event::event_type_t::vector_event );
+		const auto& values = event::get_value<event::EventVector>(messages[2].event);
+		REQUIRE( values.size() == 2 );
+		REQUIRE( event::lex_cast_value<float>(values[1]) == test_value3 );
+	}
+	SECTION("bundles are split by size") {
+		OSCBundleWriter writer(64);
+		for (int i = 0; i < 10; ++i) {
+			REQUIRE( writer.add_message("/value", std::make_shared<event::EventInt>(i)) );
+		}
+		const auto& datagrams = writer.get_datagrams();
+		REQUIRE( datagrams.size() > 1 );
+		int expected = 0;
+		for (const auto& datagram: datagrams) {
+			REQUIRE( datagram.size <= 64 );
+			for (const auto& message: parse_all(datagram.data, datagram.size, builder, valid)) {
+				REQUIRE( event::lex_cast_value<int>(message.event) == expected++ );
+			}
+			REQUIRE( valid );
+		}
+		REQUIRE( expected == 10 );
+		writer.clear();
+		REQUIRE( writer.empty() );
+	}
+	SECTION("messages without bundles") {
+		OSCBundleWriter writer(1472, false);
+		REQUIRE( writer.add_message(test_name, std::make_shared<event::EventInt>(test_value2)) );
+		REQUIRE( writer.add_message(test_name, std::make_shared<event::EventBang>()) );
+		const auto& datagrams = writer.get_datagrams();
+		REQUIRE( datagrams.size() == 2 );
+		REQUIRE( std::equal(test_string2.begin(), test_string2.end(), datagrams[0].data) );
+		REQUIRE( std::equal(test_string5.begin(), test_string5.end(), datagrams[1].data) );
+		const auto messages = parse_all(datagrams[0].data, datagrams[0].size, builder, valid);
+		REQUIRE( messages.size() == 1 );
+		REQUIRE( messages[0].time_tag == osc_time_immediate );
+	}
+	SECTION("nested bundles") {
+		OSCBundleWriter inner;
+		inner.set_time_tag(42);
+		REQUIRE( inner.add_message("/inner", std::make_shared<event::EventBool>(true)) );
+		const auto inner_data = inner.get_datagrams()[0];
+		std::vector<uint8_t> data = {'#', 'b', 'u', 'n', 'd', 'l', 'e', 0, 0, 0, 0, 0, 0, 0, 0, 1};
+		data.insert(data.end(), {0, 0, 0, static_cast<uint8_t>(inner_data.size)});
+		data.insert(data.end(), inner_data.data, inner_data.data + inner_data.size);
+		data.insert(data.end(), {0, 0, 0, static_cast<uint8_t>(test_string3.size())});
+		data.insert(data.end(), test_string3.begin(), test_string3.end());
+
+		auto messages = parse_all(data.data(), data.size(), builder, valid);
+		REQUIRE( valid );
+		REQUIRE( messages.size() == 2 );
+		REQUIRE( messages[0].name == "/inner" );
+		REQUIRE( messages[0].time_tag == 42 );
+		REQUIRE( messages[1].name == test_name );
+		REQUIRE( messages[1].time_tag == osc_time_immediate );
+
+		// Truncated element
+		data.pop_back();
+		messages = parse_all(data.data(), data.size(), builder, valid);
+		REQUIRE( !valid );
+		REQUIRE( messages.size() == 1 );
+	}
+}
+
+TEST_CASE( "OSC time tags", "[module]" ) {
+	const timestamp_t now;
+	REQUIRE( osc_time_to_timestamp(osc_time_immediate) >= now );
+	const auto time = now + 1500_ms;
+	const auto converted = osc_time_to_timestamp(timestamp_to_osc_time(time));
+	const auto difference = converted > time ? converted - time : time - converted;
+	REQUIRE( difference < 1_ms );
+}
+
+TEST_CASE( "OSC event pool", "[module]" ) {
+	OSCEventBuilder builder(4);
+	osc_message_t message;
+	auto parse = [&](const std::vector<char>& data) {
+		REQUIRE( parse_osc_message(reinterpret_cast<const uint8_t*>(data.data()), data.size(), message) );
+		return builder.get_event(message);
+	};
+
+	SECTION("simple events") {
+		auto event = parse(test_string2);
+		const auto first = event.get();
+		event.reset();
+		// The pool cycles through its slots before returning to the first one
+		for (int i = 0; i < 3; ++i) {
+			parse(test_string2);
+		}
+		event = parse(test_string2);
+		REQUIRE( event.get() == first );
+		REQUIRE( event::lex_cast_value<int32_t>(event) == test_value2 );
+		// Event still in use is never reused
+		for (int i = 0; i < 4; ++i) {
+			REQUIRE( parse(test_string2).get() != first );
+		}
+	}
+	SECTION("vectors") {
+		auto event = parse(test_string7);
+		const auto first = event.get();
+		const auto element = event::get_value<event::EventVector>(event)[0].get();
+		event.reset();
+		for (int i = 0; i < 3; ++i) {
+			parse(test_string6);
+		}
+		event = parse(test_string7);
+		REQUIRE( event.get() == first );
+		const auto& values = event::get_value<event::EventVector>(event);
+		REQUIRE( values.size() == 2 );
+		REQUIRE( values[0].get() == element );
+		REQUIRE( event::lex_cast_value<int32_t>(values[0]) == test_value2 );
+		REQUIRE( event::lex_cast_value<float>(values[1]) == test_value3 );
+	}
+}
+
+
 }
 }
@@ -29,13 +29,20 @@ core::Parameters Overlay::configure()
 //	p->set_max_pipes(1,1);
 	p["x"]["X offset"]=0;
 	p["y"]["Y offset"]=0;
+	p["fast"]["Use optimized blending engine for overlays with alpha channel"]=true;
+	p["keep_format"]["Keep format of the background image (otherwise images without alpha are extended to contain alpha). Requires fast=true"]=false;
+	p["alpha_mode"]["Interpretation of alpha in overlay image (straight, premultiplied). Requires fast=true"]="straight";
+	p["opacity"]["Opacity of the overlay (0.0 - 1.0). Requires fast=true"]=1.0;
+	p["threads"]["Number of threads to use for blending. Requires fast=true"]=1;
 	return p;
 }
 
 
 Overlay::Overlay(const log::Log &log_, core::pwThreadBase parent, const core::Parameters &parameters):
 		SpecializedMultiIOFilter<core::RawVideoFrame, core::RawVideoFrame>(log_,parent,1,std::string("overlay")),
-event::BasicEventConsumer(log)
+event::BasicEventConsumer(log),x_(0),y_(0),fast_(true),keep_format_(false),
+alpha_mode_(blend::alpha_mode_t::straight),opacity_(1.0),threads_(1),
+last_overlay_rect_{0, 0, 0, 0},last_opacity_(1.0)
 {
 	IOTHREAD_INIT(parameters)
 }
@@ -523,6 +530,52 @@ core::pRawVideoFrame Overlay::combine(core::pRawVideoFrame frame_0, const core::
 	}
 	return outframe;
 }
+core::pRawVideoFrame Overlay::fast_combine(const core::pRawVideoFrame& frame_0, const core::pRawVideoFrame& frame_1)
+{
+	const format_t fmt_0 = frame_0->get_format();
+	const format_t fmt_1 = frame_1->get_format();
+	if (!blender_ || blender_->get_base_format() != fmt_0 || blender_->get_overlay_format() != fmt_1) {
+		blender_ = blend::Blender::create(fmt_0, fmt_1, keep_format_, alpha_mode_);
+		if (!blender_) return {};
+		log[log::debug] << "Using blending engine for " << core::raw_format::get_format_name(fmt_0)
+				<< " + " << core::raw_format::get_format_name(fmt_1) << " -> "
+				<< core::raw_format::get_format_name(blender_->get_output_format());
+	}
+	const unsigned opacity = static_cast<unsigned>(std::min(std::max(opacity_, 0.0), 1.0) * 255.0 + 0.5);
+	// Only unique frame can be modified in place, otherwise we would change a frame still used by some other node.
+	if (is_frame_unique(frame_0) && blender_->get_output_format() == fmt_0) {
+		blender_->blend(*frame_0, *frame_1, *frame_0, x_, y_, opacity, threads_);
+		return frame_0;
+	}
+	auto outframe = core::RawVideoFrame::create_empty(blender_->get_output_format(), frame_0->get_resolution());
+	if (!outframe) return {};
+	outframe->copy_video_params(*frame_0);
+	blender_->blend(*frame_0, *frame_1, *outframe, x_, y_, opacity, threads_);
+	return outframe;
+}
+
+core::damage_t Overlay::compute_damage(const core::RawVideoFrame& frame_0, const core::RawVideoFrame& frame_1)
+{
+	core::damage_t damage = frame_0.get_damage();
+	const geometry_t rect {frame_1.get_width(), frame_1.get_height(), x_, y_};
+	if (rect.x != last_overlay_rect_.x || rect.y != last_overlay_rect_.y ||
+			rect.width != last_overlay_rect_.width || rect.height != last_overlay_rect_.height ||
+			opacity_ != last_opacity_) {
+		damage.push_back(last_overlay_rect_);
+		damage.push_back(rect);
+	} else if (frame_1.has_damage_info()) {
+		// Producers may redraw the same frame object (e.g. render_text), so only its damage tells what changed
+		for (const auto& d: frame_1.get_damage()) {
+			damage.push_back({d.width, d.height, d.x + x_, d.y + y_});
+		}
+	} else {
+		damage.push_back(rect);
+	}
+	last_overlay_rect_ = rect;
+	last_opacity_ = opacity_;
+	return damage;
+}
+
 std::vector<core::pFrame> Overlay::do_special_step(param_type frames)
 {
 	process_events();
@@ -530,11 +583,36 @@ std::vector<core::pFrame> Overlay::do_special_step(param_type frames)
 	core::pRawVideoFrame f1 = std::move(std::get<1>(frames));
 	std::get<0>(frames).reset();
 	if (!f0 || !f1) return {};
-	core::pRawVideoFrame outframe = dispatch(*this, std::move(f0), f1);
-	if (outframe) {
-		return {std::move(outframe)};
+	const bool track_damage = f0->has_damage_info();
+	core::damage_t damage;
+	if (track_damage) {
+		damage = compute_damage(*f0, *f1);
+		if (damage.empty() && last_output_ && last_output_->get_resolution() == f0->get_resolution()) {
+			// Nothing changed, so the last output can be sent again
+			if (last_output_->is_damaged()) {
+				last_output_ = std::dynamic_pointer_cast<core::RawVideoFrame>(last_output_->get_copy());
+				last_output_->set_damage({});
+			}
+			return {last_output_};
+		}
+	} else {
+		last_output_.reset();
+	}
+	core::pRawVideoFrame outframe;
+	if (fast_) {
+		outframe = fast_combine(f0, f1);
 	}
-	return {};
+	if (!outframe) {
+		outframe = dispatch(*this, std::move(f0), f1);
+	}
+	if (!outframe) return {};
+	if (track_damage) {
+		outframe->set_damage(damage);
+		last_output_ = outframe;
+	} else {
+		outframe->clear_damage_info();
+	}
+	return {std::move(outframe)};
 }
 bool Overlay::set_param(const core::Parameter& param)
 {
@@ -543,6 +621,28 @@ bool Overlay::set_param(const core::Parameter& param)
 		x_ = param.get<ssize_t>();
 	} else if (iequals(param.get_name(),"y")) {
 		y_ = param.get<ssize_t>();
+	} else if (iequals(param.get_name(),"fast")) {
+		fast_ = param.get<bool>();
+	} else if (iequals(param.get_name(),"keep_format")) {
+		keep_format_ = param.get<bool>();
+		blender_.reset();
+		last_output_.reset();
+	} else if (iequals(param.get_name(),"alpha_mode")) {
+		const auto mode = param.get<std::string>();
+		if (iequals(mode, "premultiplied")) {
+			alpha_mode_ = blend::alpha_mode_t::premultiplied;
+		} else if (iequals(mode, "straight")) {
+			alpha_mode_ = blend::alpha_mode_t::straight;
+		} else {
+			log[log::warning] << "Unknown alpha mode " << mode << ", using straight alpha";
+			alpha_mode_ = blend::alpha_mode_t::straight;
+		}
+		blender_.reset();
+		last_output_.reset();
+	} else if (iequals(param.get_name(),"opacity")) {
+		opacity_ = param.get<double>();
+	} else if (iequals(param.get_name(),"threads")) {
+		threads_ = param.get<size_t>();
 	} else return core::MultiIOFilter::set_param(param);
 	return true;
 }
@@ -556,6 +656,8 @@ bool Overlay::do_process_event(const std::string& event_name, const event::pBasi
 		x_ = get_value<event::EventInt>(event);
 	} else if (event_name == "y") {
 		y_ = get_value<event::EventInt>(event);
+	} else if (event_name == "opacity") {
+		opacity_ = event::lex_cast_value<double>(event);
 	} else return false;
 	}
 	catch (std::bad_cast&) {
@@ -14,6 +14,7 @@
 #include "yuri/core/thread/SpecializedMultiIOFilter.h"
 #include "yuri/event/BasicEventConsumer.h"
 #include "yuri/core/frame/RawVideoFrame.h"
+#include "blend.h"
 namespace yuri {
 namespace overlay {
 
@@ -33,10 +34,31 @@ private:
 	virtual std::vector<core::pFrame> do_special_step(param_type) override;
 	virtual bool set_param(const core::Parameter& param) override;
 	virtual bool do_process_event(const std::string& event_name, const event::pBasicEvent& event) override;
+	core::pRawVideoFrame fast_combine(const core::pRawVideoFrame& frame_0, const core::pRawVideoFrame& frame_1);
+	/*!
+	 * Computes regions of the output changed since the last frame.
+	 * Should be called only when the base frame carries damage info.
+	 * Overlay without damage info is considered changed as a whole.
+	 */
+	core::damage_t compute_damage(const core::RawVideoFrame& frame_0, const core::RawVideoFrame& frame_1);
 //	core::pBasicFrame frame_0;
 //	core::pBasicFrame frame_1;
 	ssize_t x_;
 	ssize_t y_;
+	//! Use the blending engine instead of the generic kernels where possible
+	bool fast_;
+	//! Output in the format of the background image
+	bool keep_format_;
+	blend::alpha_mode_t alpha_mode_;
+	//! Constant alpha applied to the overlay
+	double opacity_;
+	size_t threads_;
+	//! Blender for the last combination of formats
+	std::unique_ptr<blend::Blender> blender_;
+	//! Last output, reused when neither of the inputs changed
+	core::pRawVideoFrame last_output_;
+	geometry_t last_overlay_rect_;
+	double last_opacity_;
 };
 
 } /* namespace overlay */
@@ -0,0 +1,455 @@
+/*!
+ * @file 		blend.cpp
+ * @author 		agent <agent@local>
+ * @date 		18.10.2026
+ * @copyright	Institute of Intermedia, CTU in Prague, 2026
+ * 				Distributed under modified BSD Licence, details in file doc/LICENSE
+ *
+ */
+
+#include "blend.h"
+#include "yuri/core/frame/raw_frame_types.h"
+#include "yuri/core/utils/parallel_for.h"
+#include <cstring>
+#include <algorithm>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#define YURI_OVERLAY_SSE2 1
+#endif
+
+namespace yuri {
+namespace overlay {
+namespace blend {
+
+struct Blender::kernels_t {
+	using blend_fn 	= void(*)(const uint8_t*, const uint8_t*, uint8_t*, size_t, unsigned);
+	using opaque_fn	= void(*)(const uint8_t*, uint8_t*, size_t);
+	using copy_fn	= void(*)(const uint8_t*, uint8_t*, size_t);
+
+	//! Blends overlay over (unpacked) base pixels
+	blend_fn	blend;
+	//! Writes fully opaque overlay pixels
+	opaque_fn	opaque;
+	//! Copies base pixels to output, in native layouts of the frames
+	copy_fn		copy;
+	//! Copies unpacked base pixels to output (used only for yuyv422 base)
+	copy_fn		copy_unpacked;
+	//! Bytes per pixel in the base frame
+	size_t		base_bpp;
+	//! Bytes per pixel in the output frame
+	size_t		out_bpp;
+	//! Base image is yuyv422 and has to be unpacked before blending
+	bool		packed_base;
+	//! Output image is yuyv422 and has to be packed after blending
+	bool		packed_out;
+};
+
+namespace {
+
+inline unsigned div255(unsigned x)
+{
+	x += 128;
+	return (x + (x >> 8)) >> 8;
+}
+
+inline uint8_t saturate(unsigned x)
+{
+	return static_cast<uint8_t>(x > 255 ? 255 : x);
+}
+
+template<size_t ib, size_t ob, bool swap, bool premult>
+inline void blend_pixel(const uint8_t* b, const uint8_t* o, uint8_t* d, unsigned opacity)
+{
+	unsigned a  = o[3];
+	unsigned c0 = o[swap?2:0];
+	unsigned c1 = o[1];
+	unsigned c2 = o[swap?0:2];
+	if (opacity != 255) {
+		a = div255(a * opacity);
+		if (premult) {
+			c0 = div255(c0 * opacity);
+			c1 = div255(c1 * opacity);
+			c2 = div255(c2 * opacity);
+		}
+	}
+	const unsigned ia = 255 - a;
+	if (premult) {
+		const unsigned d3 = ib == 4 ? saturate(a + div255(b[ib == 4 ? 3 : 0] * ia)) : 255;
+		d[0] = saturate(c0 + div255(b[0] * ia));
+		d[1] = saturate(c1 + div255(b[1] * ia));
+		d[2] = saturate(c2 + div255(b[2] * ia));
+		if (ob == 4) d[ob == 4 ? 3 : 0] = static_cast<uint8_t>(d3);
+	} else {
+		const unsigned d3 = ib == 4 ? div255(255 * a + b[ib == 4 ? 3 : 0] * ia) : 255;
+		d[0] = static_cast<uint8_t>(div255(c0 * a + b[0] * ia));
+		d[1] = static_cast<uint8_t>(div255(c1 * a + b[1] * ia));
+		d[2] = static_cast<uint8_t>(div255(c2 * a + b[2] * ia));
+		if (ob == 4) d[ob == 4 ? 3 : 0] = static_cast<uint8_t>(d3);
+	}
+}
+
+#ifdef YURI_OVERLAY_SSE2
+inline __m128i div255_epu16(__m128i x)
+{
+	const __m128i t = _mm_add_epi16(x, _mm_set1_epi16(128));
+	return _mm_srli_epi16(_mm_add_epi16(t, _mm_srli_epi16(t, 8)), 8);
+}
+
+template<bool swap>
+inline __m128i swap_components(__m128i x)
+{
+	if (!swap) return x;
+	return _mm_shufflehi_epi16(_mm_shufflelo_epi16(x, _MM_SHUFFLE(3,0,1,2)), _MM_SHUFFLE(3,0,1,2));
+}
+
+inline __m128i broadcast_alpha(__m128i x)
+{
+	return _mm_shufflehi_epi16(_mm_shufflelo_epi16(x, _MM_SHUFFLE(3,3,3,3)), _MM_SHUFFLE(3,3,3,3));
+}
+
+/*!
+ * Blends two pixels, unpacked to 16bit components.
+ * Computes the same values as blend_pixel<4, 4, swap, premult>
+ */
+template<bool swap, bool premult>
+inline __m128i blend_2px(__m128i b, __m128i o, unsigned opacity)
+{
+	const __m128i c255 		= _mm_set1_epi16(255);
+	const __m128i alpha_mask= _mm_set_epi16(-1, 0, 0, 0, -1, 0, 0, 0);
+	o = swap_components<swap>(o);
+	__m128i a = broadcast_alpha(o);
+	if (opacity != 255) {
+		const __m128i op = _mm_set1_epi16(static_cast<short>(opacity));
+		a = div255_epu16(_mm_mullo_epi16(a, op));
+		if (premult) o = div255_epu16(_mm_mullo_epi16(o, op));
+	}
+	const __m128i ia = _mm_sub_epi16(c255, a);
+	if (premult) {
+		return _mm_add_epi16(o, div255_epu16(_mm_mullo_epi16(b, ia)));
+	}
+	o = _mm_or_si128(_mm_andnot_si128(alpha_mask, o), _mm_and_si128(alpha_mask, c255));
+	return div255_epu16(_mm_add_epi16(_mm_mullo_epi16(o, a), _mm_mullo_epi16(b, ia)));
+}
+
+/*!
+ * Blends 4 pixels at once, returns number of processed pixels.
+ */
+template<bool swap, bool premult>
+size_t blend_span_sse2(const uint8_t* b, const uint8_t* o, uint8_t* d, size_t n, unsigned opacity)
+{
+	const __m128i zero = _mm_setzero_si128();
+	size_t i = 0;
+	for (; i + 4 <= n; i += 4) {
+		const __m128i ov = _mm_loadu_si128(reinterpret_cast<const __m128i*>(o + 4 * i));
+		const __m128i bv = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + 4 * i));
+		const __m128i lo = blend_2px<swap, premult>(_mm_unpacklo_epi8(bv, zero), _mm_unpacklo_epi8(ov, zero), opacity);
+		const __m128i hi = blend_2px<swap, premult>(_mm_unpackhi_epi8(bv, zero), _mm_unpackhi_epi8(ov, zero), opacity);
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(d + 4 * i), _mm_packus_epi16(lo, hi));
+	}
+	return i;
+}
+#endif
+
+template<size_t ib, size_t ob, bool swap, bool premult>
+void blend_span(const uint8_t* b, const uint8_t* o, uint8_t* d, size_t n, unsigned opacity)
+{
+	size_t i = 0;
+#ifdef YURI_OVERLAY_SSE2
+	if (ib == 4 && ob == 4) {
+		i = blend_span_sse2<swap, premult>(b, o, d, n, opacity);
+	}
+#endif
+	b += i * ib;
+	o += i * 4;
+	d += i * ob;
+	for (; i < n; ++i) {
+		blend_pixel<ib, ob, swap, premult>(b, o, d, opacity);
+		b += ib;
+		o += 4;
+		d += ob;
+	}
+}
+
+template<size_t ob, bool swap>
+void opaque_span(const uint8_t* o, uint8_t* d, size_t n)
+{
+	if (ob == 4 && !swap) {
+		std::memcpy(d, o, n * 4);
+		return;
+	}
+	for (size_t i = 0; i < n; ++i) {
+		d[0] = o[swap?2:0];
+		d[1] = o[1];
+		d[2] = o[swap?0:2];
+		if (ob == 4) d[ob == 4 ? 3 : 0] = 255;
+		o += 4;
+		d += ob;
+	}
+}
+
+template<size_t ib, size_t ob>
+void copy_span(const uint8_t* b, uint8_t* d, size_t n)
+{
+	if (ib == ob) {
+		std::memcpy(d, b, n * ib);
+		return;
+	}
+	for (size_t i = 0; i < n; ++i) {
+		d[0] = b[0];
+		d[1] = b[1];
+		d[2] = b[2];
+		if (ob == 4) d[ob == 4 ? 3 : 0] = 255;
+		b += ib;
+		d += ob;
+	}
+}
+
+void unpack_yuyv(const uint8_t* s, uint8_t* d, size_t n)
+{
+	for (size_t i = 0; i + 1 < n; i += 2) {
+		const uint8_t u = s[1];
+		const uint8_t v = s[3];
+		*d++ = s[0];
+		*d++ = u;
+		*d++ = v;
+		*d++ = s[2];
+		*d++ = u;
+		*d++ = v;
+		s += 4;
+	}
+}
+
+void pack_yuyv(const uint8_t* s, uint8_t* d, size_t n)
+{
+	for (size_t i = 0; i + 1 < n; i += 2) {
+		*d++ = s[0];
+		*d++ = static_cast<uint8_t>((s[1] + s[4] + 1) / 2);
+		*d++ = s[3];
+		*d++ = static_cast<uint8_t>((s[2] + s[5] + 1) / 2);
+		s += 6;
+	}
+}
+
+template<size_t ib, size_t ob, bool swap>
+Blender::kernels_t make_kernels(alpha_mode_t mode)
+{
+	Blender::kernels_t k;
+	k.blend 		= mode == alpha_mode_t::premultiplied ? &blend_span<ib, ob, swap, true> : &blend_span<ib, ob, swap, false>;
+	k.opaque		= &opaque_span<ob, swap>;
+	k.copy			= &copy_span<ib, ob>;
+	k.copy_unpacked	= &copy_span<ib, ob>;
+	k.base_bpp		= ib;
+	k.out_bpp		= ob;
+	k.packed_base	= false;
+	k.packed_out	= false;
+	return k;
+}
+
+template<size_t ib, bool swap>
+Blender::kernels_t make_kernels(size_t ob, alpha_mode_t mode)
+{
+	return ob == 3 ? make_kernels<ib, 3, swap>(mode) : make_kernels<ib, 4, swap>(mode);
+}
+
+struct layout_t {
+	format_t	format;
+	size_t		bpp;
+	bool		yuv;
+	bool		bgr;
+	bool		alpha;
+	bool		packed;
+};
+
+using namespace core::raw_format;
+
+const std::vector<layout_t> supported_layouts = {
+	{rgb24,		3, false,	false,	false,	false},
+	{bgr24,		3, false,	true,	false,	false},
+	{rgba32,	4, false,	false,	true,	false},
+	{abgr32,	4, false,	true,	true,	false},
+	{bgra32,	4, false,	true,	true,	false},
+	{yuv444,	3, true,	false,	false,	false},
+	{yuva4444,	4, true,	false,	true,	false},
+	{yuyv422,	2, true,	false,	false,	true},
+};
+
+const layout_t* find_layout(format_t fmt)
+{
+	for (const auto& l: supported_layouts) {
+		if (l.format == fmt) return &l;
+	}
+	return nullptr;
+}
+
+format_t extended_format(const layout_t& base)
+{
+	if (base.alpha) return base.format;
+	if (base.yuv) return yuva4444;
+	return base.bgr ? abgr32 : rgba32;
+}
+
+}
+
+coverage_t classify(const uint8_t* overlay, size_t count, alpha_mode_t mode, unsigned opacity)
+{
+	if (!count || !opacity) return coverage_t::transparent;
+	const bool premult = mode == alpha_mode_t::premultiplied;
+	uint8_t and_alpha = 255;
+	uint8_t or_alpha = 0;
+	uint8_t or_all = 0;
+	size_t i = 0;
+#ifdef YURI_OVERLAY_SSE2
+	if (count >= 4) {
+		__m128i acc_and = _mm_set1_epi8(-1);
+		__m128i acc_or = _mm_setzero_si128();
+		for (; i + 4 <= count; i += 4) {
+			const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(overlay + 4 * i));
+			acc_and = _mm_and_si128(acc_and, v);
+			acc_or = _mm_or_si128(acc_or, v);
+		}
+		alignas(16) uint8_t ands[16];
+		alignas(16) uint8_t ors[16];
+		_mm_store_si128(reinterpret_cast<__m128i*>(ands), acc_and);
+		_mm_store_si128(reinterpret_cast<__m128i*>(ors), acc_or);
+		for (size_t j = 0; j < 16; j += 4) {
+			and_alpha &= ands[j + 3];
+			or_alpha |= ors[j + 3];
+			or_all |= ors[j] | ors[j + 1] | ors[j + 2] | ors[j + 3];
+		}
+	}
+#endif
+	for (; i < count; ++i) {
+		const uint8_t* p = overlay + 4 * i;
+		and_alpha &= p[3];
+		or_alpha |= p[3];
+		or_all |= p[0] | p[1] | p[2] | p[3];
+	}
+	if (premult ? !or_all : !or_alpha) return coverage_t::transparent;
+	if (and_alpha == 255 && opacity == 255) return coverage_t::opaque;
+	return coverage_t::mixed;
+}
+
+std::unique_ptr<Blender> Blender::create(format_t base_format, format_t overlay_format, bool keep_format, alpha_mode_t mode)
+{
+	const auto base = find_layout(base_format);
+	const auto ovr = find_layout(overlay_format);
+	if (!base || !ovr) return {};
+	if (!ovr->alpha || ovr->bpp != 4 || ovr->yuv != base->yuv) return {};
+	const bool swap = base->bgr != ovr->bgr;
+	const format_t out_format = keep_format ? base_format : extended_format(*base);
+	const size_t ib = base->packed ? 3 : base->bpp;
+	const size_t ob = keep_format ? ib : 4;
+
+	kernels_t k = ib == 3 ?
+				(swap ? make_kernels<3, true>(ob, mode) : make_kernels<3, false>(ob, mode)) :
+				(swap ? make_kernels<4, true>(ob, mode) : make_kernels<4, false>(ob, mode));
+	if (base->packed) {
+		k.packed_base = true;
+		k.packed_out = keep_format;
+		k.base_bpp = 2;
+		k.out_bpp = keep_format ? 2 : 4;
+		k.copy = keep_format ? &copy_span<2, 2> : nullptr;
+	}
+	return std::unique_ptr<Blender>(new Blender(base_format, overlay_format, out_format, keep_format, mode, k));
+}
+
+Blender::Blender(format_t base_format, format_t overlay_format, format_t output_format,
+		bool keep_format, alpha_mode_t mode, const kernels_t& kernels)
+:base_format_(base_format),overlay_format_(overlay_format),output_format_(output_format),
+ keep_format_(keep_format),mode_(mode),kernels_(new kernels_t(kernels))
+{
+}
+
+Blender::~Blender() noexcept
+{
+}
+
+void Blender::blend(const core::RawVideoFrame& base, const core::RawVideoFrame& overlay, core::RawVideoFrame& out,
+		ssize_t x, ssize_t y, unsigned opacity, size_t threads) const
+{
+	const kernels_t& k = *kernels_;
+	const bool in_place = &base == &out;
+	const resolution_t res = base.get_resolution();
+	const resolution_t ores = overlay.get_resolution();
+	const ssize_t width = res.width;
+	const ssize_t height = res.height;
+	if (k.packed_base) {
+		x -= x % 2;
+	}
+	const ssize_t x0 = std::min(std::max<ssize_t>(x, 0), width);
+	ssize_t x1 = std::min(std::max<ssize_t>(x + ores.width, 0), width);
+	const ssize_t y0 = std::min(std::max<ssize_t>(y, 0), height);
+	const ssize_t y1 = std::min(std::max<ssize_t>(y + ores.height, 0), height);
+	if (k.packed_base) {
+		x1 -= (x1 - x0) % 2;
+	}
+	const bool visible = x0 < x1 && y0 < y1 && opacity > 0;
+	if (in_place && !visible) return;
+
+	const uint8_t*	base_data	= PLANE_RAW_DATA(&base, 0);
+	const size_t	base_ls		= PLANE_DATA(&base, 0).get_line_size();
+	const uint8_t*	ovr_data	= PLANE_RAW_DATA(&overlay, 0);
+	const size_t	ovr_ls		= PLANE_DATA(&overlay, 0).get_line_size();
+	uint8_t*		out_data	= PLANE_RAW_DATA(&out, 0);
+	const size_t	out_ls		= PLANE_DATA(&out, 0).get_line_size();
+
+	auto copy_pixels = [&k](const uint8_t* brow, uint8_t* drow, ssize_t from, ssize_t to, uint8_t* tmp) {
+		if (from >= to) return;
+		if (k.copy) {
+			k.copy(brow + from * k.base_bpp, drow + from * k.out_bpp, to - from);
+			return;
+		}
+		for (ssize_t px = from; px < to; px += tile_size) {
+			const size_t n = std::min<ssize_t>(tile_size, to - px);
+			unpack_yuyv(brow + px * k.base_bpp, tmp, n);
+			k.copy_unpacked(tmp, drow + px * k.out_bpp, n);
+		}
+	};
+
+	auto process_lines = [&](size_t start, size_t end) {
+		uint8_t tmp_base[tile_size * 3];
+		uint8_t tmp_out[tile_size * 3];
+		for (ssize_t line = start; line < static_cast<ssize_t>(end); ++line) {
+			const uint8_t* brow = base_data + line * base_ls;
+			uint8_t* drow = out_data + line * out_ls;
+			if (!visible || line < y0 || line >= y1) {
+				if (!in_place) copy_pixels(brow, drow, 0, width, tmp_base);
+				continue;
+			}
+			if (!in_place) copy_pixels(brow, drow, 0, x0, tmp_base);
+			const uint8_t* orow = ovr_data + (line - y) * ovr_ls + (x0 - x) * 4;
+			for (ssize_t px = x0; px < x1; px += tile_size) {
+				const size_t n = std::min<ssize_t>(tile_size, x1 - px);
+				const uint8_t* o = orow + (px - x0) * 4;
+				const coverage_t cov = classify(o, n, mode_, opacity);
+				if (cov == coverage_t::transparent) {
+					if (!in_place) copy_pixels(brow, drow, px, px + n, tmp_base);
+					continue;
+				}
+				const uint8_t* b = brow + px * k.base_bpp;
+				uint8_t* d = drow + px * k.out_bpp;
+				uint8_t* dest = k.packed_out ? tmp_out : d;
+				if (cov == coverage_t::opaque) {
+					k.opaque(o, dest, n);
+				} else {
+					if (k.packed_base) {
+						unpack_yuyv(b, tmp_base, n);
+						b = tmp_base;
+					}
+					k.blend(b, o, dest, n, opacity);
+				}
+				if (k.packed_out) pack_yuyv(tmp_out, d, n);
+			}
+			if (!in_place) copy_pixels(brow, drow, x1, width, tmp_base);
+		}
+	};
+
+	const size_t first = in_place ? y0 : 0;
+	const size_t last = in_place ? y1 : height;
+	core::utils::parallel_for(threads, first, last, process_lines, 16);
+}
+
+}
+}
+}
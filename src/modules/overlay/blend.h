@@ -0,0 +1,114 @@
+/*!
+ * @file 		blend.h
+ * @author 		agent <agent@local>
+ * @date 		18.10.2026
+ * @copyright	Institute of Intermedia, CTU in Prague, 2026
+ * 				Distributed under modified BSD Licence, details in file doc/LICENSE
+ *
+ */
+
+#ifndef OVERLAY_BLEND_H_
+#define OVERLAY_BLEND_H_
+
+#include "yuri/core/frame/RawVideoFrame.h"
+#include <memory>
+
+namespace yuri {
+namespace overlay {
+namespace blend {
+
+enum class alpha_mode_t {
+	straight,
+	premultiplied
+};
+
+/*!
+ * Classification of a run of overlay pixels
+ */
+enum class coverage_t {
+	transparent,
+	opaque,
+	mixed
+};
+
+//! Number of pixels classified (and skipped) at once
+constexpr size_t tile_size = 32;
+
+/*!
+ * Alpha compositing engine for packed 8bit formats.
+ *
+ * The overlay has to have 4 bytes per pixel with alpha in the last byte
+ * (rgba32, abgr32, bgra32 or yuva4444). The base image can be any
+ * packed format of the same colour family (rgb24, bgr24, rgba32, abgr32, bgra32
+ * or yuv444, yuva4444, yuyv422).
+ *
+ * The blender is selected once for a combination of formats and can then
+ * be reused for all the frames with these formats.
+ * Overlay is processed in tiles of @em tile_size pixels. Fully transparent tiles
+ * are skipped (or just copied when not blending in place) and fully opaque tiles
+ * are copied without blending.
+ */
+class Blender {
+public:
+	/*!
+	 * Creates a blender for specified formats.
+	 * @param base_format		Format of the background image
+	 * @param overlay_format	Format of the overlay image
+	 * @param keep_format		Output the image in the format of the background image.
+	 * 							Otherwise the output is extended to contain alpha (and 444 sampling for YUV)
+	 * @param mode				Interpretation of alpha in overlay image
+	 * @return Blender instance or nullptr if the formats are not supported.
+	 */
+	static std::unique_ptr<Blender> create(format_t base_format, format_t overlay_format, bool keep_format, alpha_mode_t mode);
+
+	format_t get_base_format() const { return base_format_; }
+	format_t get_overlay_format() const { return overlay_format_; }
+	format_t get_output_format() const { return output_format_; }
+	alpha_mode_t get_mode() const { return mode_; }
+	bool get_keep_format() const { return keep_format_; }
+
+	/*!
+	 * Blends overlay into the base frame.
+	 *
+	 * @param base		Background image
+	 * @param overlay	Overlay image
+	 * @param out		Output frame, with resolution of the base image and output format.
+	 * 					Can be the same frame as @em base, then the blending is done in place
+	 * 					and pixels not affected by overlay are not touched at all.
+	 * @param x			Horizontal position of overlay (can be negative)
+	 * @param y			Vertical position of overlay (can be negative)
+	 * @param opacity	Constant alpha applied to the whole overlay (0 - 255)
+	 * @param threads	Number of threads (bands) to use
+	 */
+	void blend(const core::RawVideoFrame& base, const core::RawVideoFrame& overlay, core::RawVideoFrame& out,
+			ssize_t x, ssize_t y, unsigned opacity, size_t threads) const;
+
+	struct kernels_t;
+	~Blender() noexcept;
+private:
+	Blender(format_t base_format, format_t overlay_format, format_t output_format,
+			bool keep_format, alpha_mode_t mode, const kernels_t& kernels);
+
+	format_t		base_format_;
+	format_t		overlay_format_;
+	format_t		output_format_;
+	bool			keep_format_;
+	alpha_mode_t	mode_;
+	std::unique_ptr<kernels_t>
+					kernels_;
+};
+
+/*!
+ * Classifies a run of overlay pixels (4 bytes per pixel, alpha last)
+ * @param overlay	pointer to the first pixel
+ * @param count		number of pixels
+ * @param mode		alpha mode. For premultiplied alpha, only pixels with all components zero are transparent.
+ * @param opacity	Constant alpha (0 - 255)
+ */
+coverage_t classify(const uint8_t* overlay, size_t count, alpha_mode_t mode, unsigned opacity);
+
+}
+}
+}
+
+#endif /* OVERLAY_BLEND_H_ */
@@ -0,0 +1,171 @@
+/*!
+ * @file 		blend_test.cpp
+ * @author 		agent <agent@local>
+ * @date 		18.10.2026
+ * @copyright	Institute of Intermedia, CTU in Prague, 2026
+ * 				Distributed under modified BSD Licence, details in file doc/LICENSE
+ *
+ */
+
+#include "tests/catch.hpp"
+#include "blend.h"
+#include "yuri/core/frame/raw_frame_types.h"
+#include <cmath>
+
+namespace yuri {
+namespace overlay {
+
+using namespace core::raw_format;
+
+namespace {
+
+core::pRawVideoFrame make_frame(format_t fmt, resolution_t res, uint8_t seed)
+{
+	auto frame = core::RawVideoFrame::create_empty(fmt, res, false);
+	uint8_t val = seed;
+	for (auto& v: PLANE_DATA(frame, 0)) {
+		v = val;
+		val = static_cast<uint8_t>(val * 29 + 7);
+	}
+	return frame;
+}
+
+uint8_t reference(uint8_t b, uint8_t o, uint8_t a)
+{
+	return static_cast<uint8_t>(std::lround((b * (255.0 - a) + o * a) / 255.0));
+}
+
+}
+
+TEST_CASE( "overlay blend classification", "[module]" ) {
+	std::vector<uint8_t> px(4 * blend::tile_size, 0);
+	REQUIRE( blend::classify(px.data(), blend::tile_size, blend::alpha_mode_t::straight, 255) == blend::coverage_t::transparent );
+	for (size_t i = 0; i < blend::tile_size; ++i) px[4 * i + 3] = 255;
+	REQUIRE( blend::classify(px.data(), blend::tile_size, blend::alpha_mode_t::straight, 255) == blend::coverage_t::opaque );
+	REQUIRE( blend::classify(px.data(), blend::tile_size, blend::alpha_mode_t::straight, 128) == blend::coverage_t::mixed );
+	REQUIRE( blend::classify(px.data(), blend::tile_size, blend::alpha_mode_t::straight, 0) == blend::coverage_t::transparent );
+	px[4 * 5 + 3] = 12;
+	REQUIRE( blend::classify(px.data(), blend::tile_size, blend::alpha_mode_t::straight, 255) == blend::coverage_t::mixed );
+	std::fill(px.begin(), px.end(), 0);
+	px[4 * 7 + 1] = 10;
+	REQUIRE( blend::classify(px.data(), blend::tile_size, blend::alpha_mode_t::straight, 255) == blend::coverage_t::transparent );
+	REQUIRE( blend::classify(px.data(), blend::tile_size, blend::alpha_mode_t::premultiplied, 255) == blend::coverage_t::mixed );
+}
+
+TEST_CASE( "overlay blend straight alpha", "[module]" ) {
+	const resolution_t res{67, 9};
+	const resolution_t ores{45, 5};
+	const ssize_t x = 7;
+	const ssize_t y = 2;
+	auto base = make_frame(rgba32, res, 3);
+	auto ovr = make_frame(rgba32, ores, 11);
+	// Make some tiles fully transparent and fully opaque
+	for (dimension_t line = 0; line < ores.height; ++line) {
+		uint8_t* row = PLANE_RAW_DATA(ovr, 0) + line * PLANE_DATA(ovr, 0).get_line_size();
+		for (dimension_t col = 0; col < ores.width; ++col) {
+			if (line == 1) row[4 * col + 3] = 0;
+			if (line == 2) row[4 * col + 3] = 255;
+		}
+	}
+
+	SECTION("rgba32 onto rgba32") {
+		auto blender = blend::Blender::create(rgba32, rgba32, false, blend::alpha_mode_t::straight);
+		REQUIRE( blender );
+		REQUIRE( blender->get_output_format() == rgba32 );
+		auto out = core::RawVideoFrame::create_empty(rgba32, res, false);
+		blender->blend(*base, *ovr, *out, x, y, 255, 1);
+		const size_t bls = PLANE_DATA(base, 0).get_line_size();
+		const size_t ols = PLANE_DATA(ovr, 0).get_line_size();
+		for (ssize_t line = 0; line < static_cast<ssize_t>(res.height); ++line) {
+			for (ssize_t col = 0; col < static_cast<ssize_t>(res.width); ++col) {
+				const uint8_t* b = PLANE_RAW_DATA(base, 0) + line * bls + col * 4;
+				const uint8_t* d = PLANE_RAW_DATA(out, 0) + line * bls + col * 4;
+				if (line < y || line >= y + static_cast<ssize_t>(ores.height) || col < x || col >= x + static_cast<ssize_t>(ores.width)) {
+					for (int i = 0; i < 4; ++i) REQUIRE( d[i] == b[i] );
+					continue;
+				}
+				const uint8_t* o = PLANE_RAW_DATA(ovr, 0) + (line - y) * ols + (col - x) * 4;
+				for (int i = 0; i < 3; ++i) REQUIRE( d[i] == reference(b[i], o[i], o[3]) );
+				REQUIRE( d[3] == reference(b[3], 255, o[3]) );
+			}
+		}
+
+		SECTION("in place and threaded blending gives the same result") {
+			auto base2 = make_frame(rgba32, res, 3);
+			blender->blend(*base2, *ovr, *base2, x, y, 255, 4);
+			REQUIRE( std::equal(PLANE_DATA(out, 0).begin(), PLANE_DATA(out, 0).end(), PLANE_DATA(base2, 0).begin()) );
+		}
+	}
+	SECTION("rgba32 onto bgr24, keeping format") {
+		auto base3 = make_frame(bgr24, res, 5);
+		auto blender = blend::Blender::create(bgr24, rgba32, true, blend::alpha_mode_t::straight);
+		REQUIRE( blender );
+		REQUIRE( blender->get_output_format() == bgr24 );
+		auto orig = base3->get_copy();
+		blender->blend(*base3, *ovr, *base3, -3, -1, 255, 1);
+		const size_t bls = PLANE_DATA(base3, 0).get_line_size();
+		const size_t ols = PLANE_DATA(ovr, 0).get_line_size();
+		const auto& orig_plane = PLANE_DATA(std::dynamic_pointer_cast<core::RawVideoFrame>(orig), 0);
+		for (ssize_t line = 0; line < 4; ++line) {
+			for (ssize_t col = 0; col < 42; ++col) {
+				const uint8_t* b = orig_plane.data() + line * bls + col * 3;
+				const uint8_t* d = PLANE_RAW_DATA(base3, 0) + line * bls + col * 3;
+				const uint8_t* o = PLANE_RAW_DATA(ovr, 0) + (line + 1) * ols + (col + 3) * 4;
+				REQUIRE( d[0] == reference(b[0], o[2], o[3]) );
+				REQUIRE( d[1] == reference(b[1], o[1], o[3]) );
+				REQUIRE( d[2] == reference(b[2], o[0], o[3]) );
+			}
+		}
+	}
+}
+
+TEST_CASE( "overlay blend premultiplied alpha", "[module]" ) {
+	const resolution_t res{40, 4};
+	auto base = make_frame(rgba32, res, 1);
+	auto ovr = make_frame(rgba32, res, 2);
+	// Make the overlay properly premultiplied
+	for (size_t i = 0; i < PLANE_SIZE(ovr, 0); i += 4) {
+		uint8_t* p = PLANE_RAW_DATA(ovr, 0) + i;
+		for (int c = 0; c < 3; ++c) p[c] = static_cast<uint8_t>(p[c] * p[3] / 255);
+	}
+	auto blender = blend::Blender::create(rgba32, rgba32, false, blend::alpha_mode_t::premultiplied);
+	REQUIRE( blender );
+	auto out = core::RawVideoFrame::create_empty(rgba32, res, false);
+	blender->blend(*base, *ovr, *out, 0, 0, 255, 1);
+	for (size_t i = 0; i < PLANE_SIZE(ovr, 0); i += 4) {
+		const uint8_t* b = PLANE_RAW_DATA(base, 0) + i;
+		const uint8_t* o = PLANE_RAW_DATA(ovr, 0) + i;
+		const uint8_t* d = PLANE_RAW_DATA(out, 0) + i;
+		for (int c = 0; c < 4; ++c) {
+			const long expected = o[c] + std::lround(b[c] * (255.0 - o[3]) / 255.0);
+			REQUIRE( d[c] == std::min<long>(expected, 255) );
+		}
+	}
+}
+
+TEST_CASE( "overlay blend yuyv422", "[module]" ) {
+	const resolution_t res{64, 2};
+	auto base = make_frame(yuyv422, res, 9);
+	auto ovr = core::RawVideoFrame::create_empty(yuva4444, res, false);
+	for (size_t i = 0; i < PLANE_SIZE(ovr, 0); i += 4) {
+		uint8_t* p = PLANE_RAW_DATA(ovr, 0) + i;
+		p[0] = 200; p[1] = 100; p[2] = 50; p[3] = 255;
+	}
+	auto blender = blend::Blender::create(yuyv422, yuva4444, true, blend::alpha_mode_t::straight);
+	REQUIRE( blender );
+	blender->blend(*base, *ovr, *base, 0, 0, 255, 1);
+	for (size_t i = 0; i < PLANE_SIZE(base, 0); i += 4) {
+		const uint8_t* p = PLANE_RAW_DATA(base, 0) + i;
+		REQUIRE( p[0] == 200 );
+		REQUIRE( p[1] == 100 );
+		REQUIRE( p[2] == 200 );
+		REQUIRE( p[3] == 50 );
+	}
+	auto expanding = blend::Blender::create(yuyv422, yuva4444, false, blend::alpha_mode_t::straight);
+	REQUIRE( expanding );
+	REQUIRE( expanding->get_output_format() == yuva4444 );
+	REQUIRE_FALSE( blend::Blender::create(yuyv422, rgba32, false, blend::alpha_mode_t::straight) );
+}
+
+}
+}
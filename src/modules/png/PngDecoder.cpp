@@ -31,6 +31,7 @@ core::Parameters PngDecoder::configure()
 	core::Parameters p = core::SpecializedIOFilter<core::CompressedVideoFrame>::configure();
 	p.set_description("PngDecoder");
 	p["format"]["Output format. If not specified, the format of the image will be used"]="";
+	p["fast"]["Skip verification of checksums of the data"]=false;
 	return p;
 }
 
@@ -68,7 +69,7 @@ void report_warning(png_structp png_ptr, png_const_charp msg)
 PngDecoder::PngDecoder(const log::Log &log_, core::pwThreadBase parent, const core::Parameters &parameters):
 core::SpecializedIOFilter<core::CompressedVideoFrame>(log_,parent,std::string("png_decoder")),
 ConverterThread(),
-requested_format_(0)
+requested_format_(0),fast_(false)
 {
 	IOTHREAD_INIT(parameters)
 }
@@ -109,6 +110,12 @@ core::pFrame PngDecoder::do_special_single_step(core::pCompressedVideoFrame fram
 	try {
 		mem_buffer data_buffer { frame->data(), frame->size()};
 		png_set_read_fn(png_ptr,&data_buffer, read_data);
+		if (fast_) {
+			png_set_crc_action(png_ptr, PNG_CRC_QUIET_USE, PNG_CRC_QUIET_USE);
+#if defined(PNG_IGNORE_ADLER32) && defined(PNG_SET_OPTION_SUPPORTED)
+			png_set_option(png_ptr, PNG_IGNORE_ADLER32, PNG_OPTION_ON);
+#endif
+		}
 //		png_set_sig_bytes(png_ptr, 8);
 		png_read_info(png_ptr, info_ptr);
 		resolution_t image_res = { png_get_image_width(png_ptr, info_ptr),
@@ -204,14 +211,14 @@ core::pFrame PngDecoder::do_special_single_step(core::pCompressedVideoFrame fram
 		}
 
 		core::pRawVideoFrame frame_out = core::RawVideoFrame::create_empty(output_format, image_res, true);
-		std::vector<png_bytep> rows(image_res.height);
+		rows_.resize(image_res.height);
 		png_bytep data = PLANE_RAW_DATA(frame_out,0);
 		const size_t linesize = PLANE_DATA(frame_out,0).get_line_size();
 		for (size_t i=0;i<image_res.height;++i) {
-			rows[i]=data;
+			rows_[i]=data;
 			data+=linesize;
 		}
-		png_read_image(png_ptr, rows.data());
+		png_read_image(png_ptr, rows_.data());
 		return frame_out;
 	}
 	catch (std::runtime_error&) {}
@@ -223,6 +230,8 @@ bool PngDecoder::set_param(const core::Parameter& param)
 		std::string f = param.get<std::string>();
 		if (!f.empty()) requested_format_ = core::raw_format::parse_format(f);
 		else requested_format_ = 0;
+	} else if (param.get_name() == "fast") {
+		fast_ = param.get<bool>();
 	} else return core::SpecializedIOFilter<core::CompressedVideoFrame>::set_param(param);
 	return true;
 }
@@ -29,6 +29,9 @@ private:
 	virtual core::pFrame do_convert_frame(core::pFrame input_frame, format_t target_format) override;
 	virtual bool set_param(const core::Parameter& param) override;
 	format_t requested_format_;
+	bool fast_;
+	//! Row pointers, kept between frames
+	std::vector<uint8_t*> rows_;
 };
 
 } /* namespace png */
@@ -0,0 +1,469 @@
+/*!
+ * @file 		PngEncodeContext.cpp
+ * @author 		agent <agent@local>
+ * @date 		18.10.2026
+ * @copyright	Institute of Intermedia, CTU in Prague, 2026
+ * 				Distributed under modified BSD Licence, details in file doc/LICENSE
+ *
+ */
+
+#include "PngEncodeContext.h"
+#include "yuri/core/thread/FixedMemoryAllocator.h"
+#include "yuri/core/frame/raw_frame_types.h"
+#include "yuri/core/frame/compressed_frame_types.h"
+#include "yuri/core/utils.h"
+#include "yuri/core/utils/parallel_for.h"
+#include <algorithm>
+#include <cstring>
+#include <functional>
+#include <limits>
+#include <map>
+#include <stdexcept>
+
+namespace yuri {
+namespace png {
+
+namespace {
+
+//! Smallest block requested from the allocator
+constexpr size_t min_block_size = 64 * 1024;
+
+size_t get_block_size(size_t size)
+{
+	return next_power_2(std::max(size, min_block_size));
+}
+
+void return_block(uint8_t* data, size_t size)
+{
+	core::FixedMemoryAllocator::Deleter(size, data)(data);
+}
+
+struct png_format_t {
+	int color_type;
+	int depth;
+	//! Bits per pixel
+	size_t bpp;
+	//! Red and blue components have to be swapped
+	bool bgr;
+};
+
+bool get_png_format(format_t format, png_format_t& info)
+{
+	using namespace core::raw_format;
+	switch(format) {
+		case y8: info = {PNG_COLOR_TYPE_GRAY, 8, 8, false}; break;
+		case y16: info = {PNG_COLOR_TYPE_GRAY, 16, 16, false}; break;
+		case rgb24: info = {PNG_COLOR_TYPE_RGB, 8, 24, false}; break;
+		case rgb48: info = {PNG_COLOR_TYPE_RGB, 16, 48, false}; break;
+		case bgr24: info = {PNG_COLOR_TYPE_RGB, 8, 24, true}; break;
+		case bgr48: info = {PNG_COLOR_TYPE_RGB, 16, 48, true}; break;
+		case rgba32: info = {PNG_COLOR_TYPE_RGBA, 8, 32, false}; break;
+		case rgba64: info = {PNG_COLOR_TYPE_RGBA, 16, 64, false}; break;
+		case bgra32: info = {PNG_COLOR_TYPE_RGBA, 8, 32, true}; break;
+		case bgra64: info = {PNG_COLOR_TYPE_RGBA, 16, 64, true}; break;
+		default: return false;
+	}
+	return true;
+}
+
+void report_error(png_structp /*png_ptr*/, png_const_charp msg)
+{
+	throw std::runtime_error(std::string("Failed to encode PNG file: ")+msg);
+}
+
+void report_warning(png_structp, png_const_charp)
+{
+}
+
+void flush_data(png_structp)
+{
+}
+
+int get_libpng_filter(png_filter_t filter)
+{
+	switch (filter) {
+		case png_filter_t::none: return PNG_FILTER_NONE;
+		case png_filter_t::sub: return PNG_FILTER_SUB;
+		case png_filter_t::up: return PNG_FILTER_UP;
+		case png_filter_t::average: return PNG_FILTER_AVG;
+		case png_filter_t::paeth: return PNG_FILTER_PAETH;
+		default: return PNG_ALL_FILTERS;
+	}
+}
+
+inline void write_be32(uint8_t* data, uint32_t value)
+{
+	data[0] = static_cast<uint8_t>(value >> 24);
+	data[1] = static_cast<uint8_t>(value >> 16);
+	data[2] = static_cast<uint8_t>(value >> 8);
+	data[3] = static_cast<uint8_t>(value);
+}
+
+inline uint8_t paeth_predictor(int a, int b, int c)
+{
+	const int p = a + b - c;
+	const int pa = std::abs(p - a);
+	const int pb = std::abs(p - b);
+	const int pc = std::abs(p - c);
+	if (pa <= pb && pa <= pc) return static_cast<uint8_t>(a);
+	if (pb <= pc) return static_cast<uint8_t>(b);
+	return static_cast<uint8_t>(c);
+}
+
+/*!
+ * Filters a row with filter @em type. First @em bpp bytes have no left neighbour.
+ * Returns sum of absolute values of the filtered bytes (interpreted as signed),
+ * as used by libpng to select the best filter.
+ */
+size_t apply_filter(int type, const uint8_t* row, const uint8_t* prev, size_t length, size_t bpp, uint8_t* out)
+{
+	out[0] = static_cast<uint8_t>(type);
+	++out;
+	switch (type) {
+		case 0:
+			std::copy(row, row + length, out);
+			break;
+		case 1:
+			std::copy(row, row + bpp, out);
+			for (size_t i = bpp; i < length; ++i) out[i] = row[i] - row[i - bpp];
+			break;
+		case 2:
+			for (size_t i = 0; i < length; ++i) out[i] = row[i] - prev[i];
+			break;
+		case 3:
+			for (size_t i = 0; i < bpp; ++i) out[i] = row[i] - (prev[i] >> 1);
+			for (size_t i = bpp; i < length; ++i) out[i] = row[i] - ((row[i - bpp] + prev[i]) >> 1);
+			break;
+		case 4:
+			for (size_t i = 0; i < bpp; ++i) out[i] = row[i] - prev[i];
+			for (size_t i = bpp; i < length; ++i) {
+				out[i] = row[i] - paeth_predictor(row[i - bpp], prev[i], prev[i - bpp]);
+			}
+			break;
+	}
+	size_t sum = 0;
+	for (size_t i = 0; i < length; ++i) {
+		sum += std::abs(static_cast<int8_t>(out[i]));
+	}
+	return sum;
+}
+
+}
+
+png_filter_t parse_png_filter(const std::string& name)
+{
+	static const std::map<std::string, png_filter_t> filters = {
+			{"none", png_filter_t::none},
+			{"sub", png_filter_t::sub},
+			{"up", png_filter_t::up},
+			{"average", png_filter_t::average},
+			{"paeth", png_filter_t::paeth},
+			{"adaptive", png_filter_t::adaptive},
+	};
+	auto it = filters.find(name);
+	if (it == filters.end()) return png_filter_t::adaptive;
+	return it->second;
+}
+
+int parse_png_strategy(const std::string& name)
+{
+	static const std::map<std::string, int> strategies = {
+			{"default", Z_DEFAULT_STRATEGY},
+			{"filtered", Z_FILTERED},
+			{"huffman", Z_HUFFMAN_ONLY},
+			{"rle", Z_RLE},
+			{"fixed", Z_FIXED},
+	};
+	auto it = strategies.find(name);
+	if (it == strategies.end()) return Z_DEFAULT_STRATEGY;
+	return it->second;
+}
+
+bool is_png_supported_format(format_t format)
+{
+	png_format_t info;
+	return get_png_format(format, info);
+}
+
+PngEncodeContext::PngEncodeContext():
+data_(nullptr),capacity_(0),size_(0),size_hint_(min_block_size),
+stream_(),stream_valid_(false),stream_level_(0),stream_strategy_(0),
+band_size_(0),band_adler_(0),band_crc_(0),band_raw_size_(0)
+{
+}
+
+PngEncodeContext::~PngEncodeContext() noexcept
+{
+	if (stream_valid_) deflateEnd(&stream_);
+	release_buffer();
+}
+
+void PngEncodeContext::release_buffer()
+{
+	if (data_) {
+		return_block(data_, capacity_);
+		data_ = nullptr;
+		capacity_ = 0;
+	}
+	size_ = 0;
+}
+
+void PngEncodeContext::reserve(size_t size)
+{
+	if (size <= capacity_) return;
+	// Let's get big enough block and copy the data there.
+	const size_t new_capacity = get_block_size(size);
+	auto block = core::FixedMemoryAllocator::get_block(new_capacity);
+	if (data_) {
+		std::memcpy(block.first, data_, size_);
+		return_block(data_, capacity_);
+	}
+	data_ = block.first;
+	capacity_ = new_capacity;
+}
+
+void PngEncodeContext::append(const uint8_t* data, size_t length)
+{
+	if (size_ + length > capacity_) reserve(std::max(size_ + length, capacity_ * 2));
+	std::memcpy(data_ + size_, data, length);
+	size_ += length;
+}
+
+void PngEncodeContext::write_data(png_structp png_ptr, png_bytep data, png_size_t length)
+{
+	auto& context = *reinterpret_cast<PngEncodeContext*>(png_get_io_ptr(png_ptr));
+	context.append(data, length);
+}
+
+core::pCompressedVideoFrame PngEncodeContext::create_frame(const core::RawVideoFrame& frame)
+{
+	// Next frame will most probably have similar size, let's leave some space for it to grow
+	size_hint_ = size_ + size_ / 4;
+	auto outframe = core::CompressedVideoFrame::create_empty(core::compressed_frame::png, frame.get_resolution());
+	outframe->get_data().set(data_, size_, core::FixedMemoryAllocator::Deleter(capacity_, data_));
+	data_ = nullptr;
+	capacity_ = 0;
+	size_ = 0;
+	outframe->copy_video_params(frame);
+	return outframe;
+}
+
+core::pCompressedVideoFrame PngEncodeContext::encode(const core::RawVideoFrame& frame, const png_options_t& options)
+{
+	png_format_t fmt;
+	if (!get_png_format(frame.get_format(), fmt)) {
+		throw std::runtime_error("Unsupported format");
+	}
+	png_infop info_ptr = nullptr;
+	std::unique_ptr<png_struct, std::function<void(png_structp)>> png_ptrx (png_create_write_struct(PNG_LIBPNG_VER_STRING, nullptr, report_error, report_warning),
+			[&info_ptr](png_structp p){
+				if (p) png_destroy_write_struct(&p, &info_ptr);
+			});
+	png_structp png_ptr = png_ptrx.get();
+	if (!png_ptr) {
+		throw std::runtime_error("Failed to initialize png write");
+	}
+	info_ptr = png_create_info_struct(png_ptr);
+	if (!info_ptr) {
+		throw std::runtime_error("Failed to initialize png info");
+	}
+
+	size_ = 0;
+	reserve(size_hint_);
+	png_set_write_fn(png_ptr, this, write_data, flush_data);
+
+	const resolution_t res = frame.get_resolution();
+	png_set_IHDR(png_ptr, info_ptr, res.width, res.height, fmt.depth, fmt.color_type,
+			PNG_INTERLACE_NONE, PNG_COMPRESSION_TYPE_DEFAULT,
+			PNG_FILTER_TYPE_DEFAULT);
+	png_set_compression_level(png_ptr, options.level < 0 ? Z_DEFAULT_COMPRESSION : options.level);
+	png_set_compression_strategy(png_ptr, options.strategy);
+	png_set_filter(png_ptr, PNG_FILTER_TYPE_BASE, get_libpng_filter(options.filter));
+	if (fmt.bgr) png_set_bgr(png_ptr);
+
+	png_write_info(png_ptr, info_ptr);
+	rows_.resize(res.height);
+	const size_t line_size = frame[0].get_line_size();
+	const uint8_t* data = frame[0].data();
+	for (dimension_t i = 0; i < res.height; ++i) {
+		rows_[i] = const_cast<png_bytep>(data + i * line_size);
+	}
+	png_write_image(png_ptr, rows_.data());
+	png_write_end(png_ptr, info_ptr);
+	return create_frame(frame);
+}
+
+const uint8_t* PngEncodeContext::filter_row(const uint8_t* row, const uint8_t* prev, size_t length, size_t bpp, png_filter_t filter)
+{
+	if (filter != png_filter_t::adaptive) {
+		const int type = static_cast<int>(filter);
+		apply_filter(type, row, prev, length, bpp, filtered_[type].data());
+		return filtered_[type].data();
+	}
+	int best = 0;
+	size_t best_sum = std::numeric_limits<size_t>::max();
+	for (int type = 0; type < 5; ++type) {
+		const size_t sum = apply_filter(type, row, prev, length, bpp, filtered_[type].data());
+		if (sum < best_sum) {
+			best_sum = sum;
+			best = type;
+		}
+	}
+	return filtered_[best].data();
+}
+
+void PngEncodeContext::compress_band(const core::RawVideoFrame& frame, dimension_t first_line, dimension_t lines,
+		const png_options_t& options, bool last)
+{
+	png_format_t fmt;
+	if (!get_png_format(frame.get_format(), fmt)) {
+		throw std::runtime_error("Unsupported format");
+	}
+	const size_t length = frame.get_width() * fmt.bpp / 8;
+	const size_t bpp = (fmt.bpp + 7) / 8;
+	const size_t component = fmt.depth / 8;
+	const size_t line_size = frame[0].get_line_size();
+	const uint8_t* data = frame[0].data();
+
+	const int level = options.level < 0 ? Z_DEFAULT_COMPRESSION : options.level;
+	if (!stream_valid_ || stream_level_ != level || stream_strategy_ != options.strategy) {
+		if (stream_valid_) deflateEnd(&stream_);
+		stream_ = z_stream{};
+		stream_valid_ = deflateInit2(&stream_, level, Z_DEFLATED, -MAX_WBITS, 8, options.strategy) == Z_OK;
+		if (!stream_valid_) {
+			throw std::runtime_error("Failed to initialize deflate");
+		}
+		stream_level_ = level;
+		stream_strategy_ = options.strategy;
+	} else {
+		deflateReset(&stream_);
+	}
+
+	for (auto& f: filtered_) f.resize(length + 1);
+	for (auto& s: swapped_) s.resize(length);
+	zero_.resize(length, 0);
+	size_t swap_index = 0;
+	// Returns the row with R and B components in the order PNG expects
+	auto get_row = [&](dimension_t line) -> const uint8_t* {
+		const uint8_t* row = data + line * line_size;
+		if (!fmt.bgr) return row;
+		uint8_t* out = swapped_[swap_index++ & 1].data();
+		std::copy(row, row + length, out);
+		for (size_t i = 0; i < length; i += bpp) {
+			std::swap_ranges(out + i, out + i + component, out + i + 2 * component);
+		}
+		return out;
+	};
+
+	band_raw_size_ = lines * (length + 1);
+	band_.resize(deflateBound(&stream_, band_raw_size_) + 16);
+	stream_.next_out = band_.data();
+	stream_.avail_out = static_cast<uInt>(band_.size());
+	band_adler_ = adler32(0L, Z_NULL, 0);
+
+	const uint8_t* prev = first_line ? get_row(first_line - 1) : zero_.data();
+	for (dimension_t line = first_line; line < first_line + lines; ++line) {
+		const uint8_t* row = get_row(line);
+		const uint8_t* filtered = filter_row(row, prev, length, bpp, options.filter);
+		band_adler_ = adler32(band_adler_, filtered, static_cast<uInt>(length + 1));
+		stream_.next_in = const_cast<Bytef*>(filtered);
+		stream_.avail_in = static_cast<uInt>(length + 1);
+		// Bands other than the last one have to end on a byte boundary, so they can be concatenated
+		const int flush = line + 1 < first_line + lines ? Z_NO_FLUSH : (last ? Z_FINISH : Z_SYNC_FLUSH);
+		while (true) {
+			if (!stream_.avail_out) {
+				const size_t used = band_.size();
+				band_.resize(used * 2);
+				stream_.next_out = band_.data() + used;
+				stream_.avail_out = static_cast<uInt>(band_.size() - used);
+			}
+			const int ret = deflate(&stream_, flush);
+			if (ret == Z_STREAM_ERROR) {
+				throw std::runtime_error("Failed to compress data");
+			}
+			if (stream_.avail_in) continue;
+			if (flush == Z_FINISH && ret != Z_STREAM_END) continue;
+			if (flush == Z_SYNC_FLUSH && !stream_.avail_out) continue;
+			break;
+		}
+		prev = row;
+	}
+	band_size_ = band_.size() - stream_.avail_out;
+	band_crc_ = crc32(0L, band_.data(), static_cast<uInt>(band_size_));
+}
+
+core::pCompressedVideoFrame PngEncodeContext::encode_sliced(const core::RawVideoFrame& frame, const png_options_t& options,
+		size_t slices, std::vector<std::unique_ptr<PngEncodeContext>>& helpers)
+{
+	png_format_t fmt;
+	if (!get_png_format(frame.get_format(), fmt)) {
+		throw std::runtime_error("Unsupported format");
+	}
+	const resolution_t res = frame.get_resolution();
+	slices = std::max<size_t>(1, std::min<size_t>(slices, res.height));
+	const dimension_t band_height = static_cast<dimension_t>((res.height + slices - 1) / slices);
+	slices = (res.height + band_height - 1) / band_height;
+	while (helpers.size() < slices - 1) {
+		helpers.emplace_back(make_unique<PngEncodeContext>());
+	}
+	auto get_context = [&](size_t i) -> PngEncodeContext& { return i ? *helpers[i - 1] : *this; };
+
+	core::utils::parallel_for(slices, 0, slices, [&](size_t start, size_t end) {
+		for (size_t i = start; i < end; ++i) {
+			const dimension_t first_line = static_cast<dimension_t>(i * band_height);
+			get_context(i).compress_band(frame, first_line, std::min(band_height, res.height - first_line),
+					options, i == slices - 1);
+		}
+	});
+
+	// zlib header, data of all bands and adler32 of the uncompressed data
+	size_t idat_size = 2 + 4;
+	uLong adler = adler32(0L, Z_NULL, 0);
+	for (size_t i = 0; i < slices; ++i) {
+		const auto& context = get_context(i);
+		idat_size += context.band_size_;
+		adler = adler32_combine(adler, context.band_adler_, static_cast<z_off_t>(context.band_raw_size_));
+	}
+	if (idat_size > 0x7FFFFFFF) {
+		throw std::runtime_error("Compressed image too large");
+	}
+
+	size_ = 0;
+	reserve(8 + 25 + 12 + idat_size + 12);
+	static const uint8_t signature[8] = {0x89, 'P', 'N', 'G', 0x0D, 0x0A, 0x1A, 0x0A};
+	append(signature, sizeof(signature));
+
+	uint8_t ihdr[4 + 4 + 13 + 4] = {0, 0, 0, 13, 'I', 'H', 'D', 'R'};
+	write_be32(ihdr + 8, static_cast<uint32_t>(res.width));
+	write_be32(ihdr + 12, static_cast<uint32_t>(res.height));
+	ihdr[16] = static_cast<uint8_t>(fmt.depth);
+	ihdr[17] = static_cast<uint8_t>(fmt.color_type);
+	// Compression, filter and interlace methods are all 0
+	write_be32(ihdr + 21, static_cast<uint32_t>(crc32(0L, ihdr + 4, 4 + 13)));
+	append(ihdr, sizeof(ihdr));
+
+	const int level = options.level < 0 ? Z_DEFAULT_COMPRESSION : options.level;
+	const int level_flags = level == Z_DEFAULT_COMPRESSION ? 2 : (level < 2 ? 0 : (level < 6 ? 1 : (level == 6 ? 2 : 3)));
+	uint8_t idat[4 + 4 + 2] = {0, 0, 0, 0, 'I', 'D', 'A', 'T', 0x78, static_cast<uint8_t>(level_flags << 6)};
+	idat[9] += static_cast<uint8_t>((31 - ((idat[8] << 8) + idat[9]) % 31) % 31);
+	write_be32(idat, static_cast<uint32_t>(idat_size));
+	append(idat, sizeof(idat));
+	uLong crc = crc32(0L, idat + 4, 4 + 2);
+	for (size_t i = 0; i < slices; ++i) {
+		const auto& context = get_context(i);
+		append(context.band_.data(), context.band_size_);
+		crc = crc32_combine(crc, context.band_crc_, static_cast<z_off_t>(context.band_size_));
+	}
+	uint8_t trailer[4 + 4];
+	write_be32(trailer, static_cast<uint32_t>(adler));
+	crc = crc32(crc, trailer, 4);
+	write_be32(trailer + 4, static_cast<uint32_t>(crc));
+	append(trailer, sizeof(trailer));
+
+	static const uint8_t iend[12] = {0, 0, 0, 0, 'I', 'E', 'N', 'D', 0xAE, 0x42, 0x60, 0x82};
+	append(iend, sizeof(iend));
+	return create_frame(frame);
+}
+
+}
+}
@@ -0,0 +1,123 @@
+/*!
+ * @file 		PngEncodeContext.h
+ * @author 		agent <agent@local>
+ * @date 		18.10.2026
+ * @copyright	Institute of Intermedia, CTU in Prague, 2026
+ * 				Distributed under modified BSD Licence, details in file doc/LICENSE
+ *
+ */
+
+#ifndef PNGENCODECONTEXT_H_
+#define PNGENCODECONTEXT_H_
+
+#include "yuri/core/frame/RawVideoFrame.h"
+#include "yuri/core/frame/CompressedVideoFrame.h"
+#include <png.h>
+#include <zlib.h>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace yuri {
+namespace png {
+
+//! Filter applied to the rows before compression
+enum class png_filter_t {
+	none,
+	sub,
+	up,
+	average,
+	paeth,
+	//! Selects the best filter for each row separately
+	adaptive
+};
+
+struct png_options_t {
+	//! zlib compression level (0-9), -1 for the default level
+	int level;
+	//! zlib compression strategy
+	int strategy;
+	png_filter_t filter;
+};
+
+//! Parses filter name (none, sub, up, average, paeth, adaptive). Returns adaptive for unknown names.
+png_filter_t parse_png_filter(const std::string& name);
+//! Parses zlib strategy name (default, filtered, huffman, rle, fixed). Returns Z_DEFAULT_STRATEGY for unknown names.
+int parse_png_strategy(const std::string& name);
+//! Returns true for formats, that can be encoded by PngEncodeContext
+bool is_png_supported_format(format_t format);
+
+/*!
+ * PNG compressor.
+ *
+ * Encoded data are written directly to blocks from FixedMemoryAllocator,
+ * that are then passed to the output frame without any copy.
+ */
+class PngEncodeContext {
+public:
+	PngEncodeContext();
+	~PngEncodeContext() noexcept;
+	PngEncodeContext(const PngEncodeContext&) = delete;
+	PngEncodeContext& operator=(const PngEncodeContext&) = delete;
+
+	/*!
+	 * Encodes a frame using libpng.
+	 * @throw std::runtime_error when the frame can't be encoded
+	 */
+	core::pCompressedVideoFrame encode(const core::RawVideoFrame& frame, const png_options_t& options);
+
+	/*!
+	 * Encodes a frame in horizontal bands, each band filtered and deflated by a separate context in parallel.
+	 *
+	 * The bands are compressed as raw deflate streams ending on a byte boundary
+	 * and then concatenated into a single zlib stream, with checksums combined from the bands.
+	 * Compression ratio is slightly worse, as the bands don't share history.
+	 * This context compresses the first band, @em helpers are used for the others
+	 * (and created if there's not enough of them).
+	 *
+	 * @param slices	Requested number of bands
+	 * @throw std::runtime_error when the frame can't be encoded
+	 */
+	core::pCompressedVideoFrame encode_sliced(const core::RawVideoFrame& frame, const png_options_t& options,
+			size_t slices, std::vector<std::unique_ptr<PngEncodeContext>>& helpers);
+private:
+	static void write_data(png_structp png_ptr, png_bytep data, png_size_t length);
+	void release_buffer();
+	void reserve(size_t size);
+	void append(const uint8_t* data, size_t length);
+	core::pCompressedVideoFrame create_frame(const core::RawVideoFrame& frame);
+	void compress_band(const core::RawVideoFrame& frame, dimension_t first_line, dimension_t lines,
+			const png_options_t& options, bool last);
+	const uint8_t* filter_row(const uint8_t* row, const uint8_t* prev, size_t length, size_t bpp, png_filter_t filter);
+
+	//! Output buffer
+	uint8_t* data_;
+	size_t capacity_;
+	size_t size_;
+	//! Expected size of the encoded image, based on the previous frames
+	size_t size_hint_;
+
+	//! Deflate stream used to compress bands
+	z_stream stream_;
+	bool stream_valid_;
+	int stream_level_;
+	int stream_strategy_;
+	//! Compressed data of the last band and checksums of them
+	std::vector<uint8_t> band_;
+	size_t band_size_;
+	uLong band_adler_;
+	uLong band_crc_;
+	size_t band_raw_size_;
+	//! Rows with swapped color components
+	std::vector<uint8_t> swapped_[2];
+	//! Row of zeros, used as the previous row for the first line of the image
+	std::vector<uint8_t> zero_;
+	//! Filtered row for each filter type (including the filter byte)
+	std::vector<uint8_t> filtered_[5];
+	std::vector<png_bytep> rows_;
+};
+
+}
+}
+
+#endif /* PNGENCODECONTEXT_H_ */
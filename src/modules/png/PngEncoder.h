@@ -13,6 +13,8 @@
 #include "yuri/core/thread/SpecializedIOFilter.h"
 #include "yuri/core/frame/RawVideoFrame.h"
 #include "yuri/core/thread/ConverterThread.h"
+#include "yuri/core/utils/ordered_pool.h"
+#include "PngEncodeContext.h"
 namespace yuri {
 namespace png {
 
@@ -24,10 +26,25 @@ public:
 	PngEncoder(const log::Log &log_, core::pwThreadBase parent, const core::Parameters &parameters);
 	virtual ~PngEncoder() noexcept;
 private:
-	
+	using pool_type = core::utils::ordered_pool<core::pFrame, PngEncodeContext>;
+
+	virtual bool step() override;
+	virtual void finish_output() override;
 	virtual core::pFrame do_special_single_step(core::pRawVideoFrame frame) override;
 	virtual core::pFrame do_convert_frame(core::pFrame input_frame, format_t target_format) override;
 	virtual bool set_param(const core::Parameter& param) override;
+	core::pFrame encode(const core::pRawVideoFrame& frame);
+	//! Pushes frames finished by the worker pool in input order
+	void push_finished(size_t max_pending);
+
+	png_options_t options_;
+	size_t threads_;
+	size_t slices_;
+	//! Context used to encode frames in the main thread
+	std::unique_ptr<PngEncodeContext> context_;
+	//! Contexts used to compress bands other than the first one
+	std::vector<std::unique_ptr<PngEncodeContext>> slice_contexts_;
+	std::unique_ptr<pool_type> pool_;
 };
 
 } /* namespace png */
@@ -0,0 +1,126 @@
+/*!
+ * @file 		png_test.cpp
+ * @author 		agent <agent@local>
+ * @date 		18.10.2026
+ * @copyright	Institute of Intermedia, CTU in Prague, 2026
+ * 				Distributed under modified BSD Licence, details in file doc/LICENSE
+ *
+ */
+
+#include "tests/catch.hpp"
+#include "PngEncodeContext.h"
+#include "yuri/core/frame/raw_frame_types.h"
+#include "yuri/core/frame/raw_frame_params.h"
+#include <stdexcept>
+
+namespace yuri {
+namespace png {
+
+namespace {
+
+core::pRawVideoFrame make_frame(format_t format, resolution_t res)
+{
+	auto frame = core::RawVideoFrame::create_empty(format, res);
+	const size_t linesize = PLANE_DATA(frame, 0).get_line_size();
+	const size_t bpp = core::raw_format::get_fmt_bpp(format, 0) / 8;
+	uint8_t* data = PLANE_RAW_DATA(frame, 0);
+	for (dimension_t y = 0; y < res.height; ++y) {
+		for (dimension_t x = 0; x < res.width; ++x) {
+			for (size_t i = 0; i < bpp; ++i) {
+				// Mix of smooth areas and noise, so all the filters get used
+				data[y * linesize + x * bpp + i] = static_cast<uint8_t>(
+						x < res.width / 2 ? x * (i + 1) + y : (x * 7919 + y * 104729 + i * 31) >> 3);
+			}
+		}
+	}
+	return frame;
+}
+
+struct read_buffer_t {
+	const uint8_t* data;
+	size_t size;
+};
+
+void read_data(png_structp png_ptr, png_bytep data, png_size_t length)
+{
+	auto& buffer = *reinterpret_cast<read_buffer_t*>(png_get_io_ptr(png_ptr));
+	if (length > buffer.size) png_error(png_ptr, "Not enough data");
+	std::copy(buffer.data, buffer.data + length, data);
+	buffer.data += length;
+	buffer.size -= length;
+}
+
+void read_error(png_structp, png_const_charp msg)
+{
+	throw std::runtime_error(msg);
+}
+
+//! Decodes the image without any transformations
+std::vector<uint8_t> decode(const core::pCompressedVideoFrame& frame, resolution_t& res)
+{
+	png_structp png_ptr = png_create_read_struct(PNG_LIBPNG_VER_STRING, nullptr, read_error, nullptr);
+	png_infop info_ptr = png_create_info_struct(png_ptr);
+	std::vector<uint8_t> image;
+	try {
+		read_buffer_t buffer{frame->data(), frame->size()};
+		png_set_read_fn(png_ptr, &buffer, read_data);
+		png_read_info(png_ptr, info_ptr);
+		res = {png_get_image_width(png_ptr, info_ptr), png_get_image_height(png_ptr, info_ptr)};
+		const size_t row_size = png_get_rowbytes(png_ptr, info_ptr);
+		image.resize(row_size * res.height);
+		std::vector<png_bytep> rows(res.height);
+		for (dimension_t i = 0; i < res.height; ++i) rows[i] = image.data() + i * row_size;
+		png_read_image(png_ptr, rows.data());
+		png_read_end(png_ptr, nullptr);
+	}
+	catch (std::runtime_error&) {
+		png_destroy_read_struct(&png_ptr, &info_ptr, nullptr);
+		throw;
+	}
+	png_destroy_read_struct(&png_ptr, &info_ptr, nullptr);
+	return image;
+}
+
+}
+
+TEST_CASE( "png options", "[module]" ) {
+	REQUIRE( parse_png_filter("paeth") == png_filter_t::paeth );
+	REQUIRE( parse_png_filter("nonsense") == png_filter_t::adaptive );
+	REQUIRE( parse_png_strategy("rle") == Z_RLE );
+	REQUIRE( parse_png_strategy("") == Z_DEFAULT_STRATEGY );
+	REQUIRE( is_png_supported_format(core::raw_format::bgra64) );
+	REQUIRE( !is_png_supported_format(core::raw_format::yuyv422) );
+}
+
+TEST_CASE( "png encoding", "[module]" ) {
+	using namespace core::raw_format;
+	const resolution_t res{97, 61};
+	PngEncodeContext context;
+	std::vector<std::unique_ptr<PngEncodeContext>> helpers;
+
+	for (format_t format: {rgb24, y8, bgr24, bgra32, rgb48}) {
+		const auto frame = make_frame(format, res);
+		for (auto filter: {png_filter_t::none, png_filter_t::sub, png_filter_t::up,
+				png_filter_t::average, png_filter_t::paeth, png_filter_t::adaptive}) {
+			for (int strategy: {Z_DEFAULT_STRATEGY, Z_RLE, Z_HUFFMAN_ONLY}) {
+				const png_options_t options{strategy == Z_DEFAULT_STRATEGY ? -1 : 1, strategy, filter};
+				resolution_t decoded_res;
+				const auto expected = decode(context.encode(*frame, options), decoded_res);
+				REQUIRE( decoded_res == res );
+				if (format == rgb24 || format == y8) {
+					REQUIRE( std::equal(expected.begin(), expected.end(), PLANE_RAW_DATA(frame, 0)) );
+				}
+				for (size_t slices: {1, 3, 7, 200}) {
+					const auto sliced = context.encode_sliced(*frame, options, slices, helpers);
+					REQUIRE( sliced->get_resolution() == res );
+					// libpng verifies the CRC of all chunks and adler32 of the zlib stream
+					REQUIRE( decode(sliced, decoded_res) == expected );
+					REQUIRE( decoded_res == res );
+				}
+			}
+		}
+	}
+}
+
+}
+}
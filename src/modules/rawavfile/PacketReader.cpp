@@ -0,0 +1,179 @@
+/*!
+ * @file 		PacketReader.cpp
+ * @author 		agent <agent@local>
+ * @date 		18.10.2026
+ * @copyright	Institute of Intermedia, CTU in Prague, 2026
+ * 				Distributed under modified BSD Licence, details in file doc/LICENSE
+ *
+ */
+
+#include "PacketReader.h"
+#include <algorithm>
+#include <cerrno>
+#include <map>
+
+namespace yuri {
+namespace rawavfile {
+
+namespace {
+//! Maximal number of files kept in the index cache
+constexpr size_t max_cached_indices = 64;
+
+struct cached_index_t {
+    int64_t                       file_size;
+    std::vector<keyframe_entry_t> entries;
+};
+
+std::mutex                            index_cache_mutex;
+std::map<std::string, cached_index_t> index_cache;
+}
+
+PacketReader::PacketReader(AVFormatContext* ctx, const std::string& filename, size_t max_packets, size_t max_bytes, bool use_index_cache)
+    : ctx_(ctx),
+      filename_(filename),
+      max_packets_(std::max<size_t>(max_packets, 1)),
+      max_bytes_(max_bytes),
+      file_size_(ctx->pb ? avio_size(ctx->pb) : -1),
+      collect_index_(false),
+      bytes_(0),
+      end_(false),
+      stop_(false),
+      seek_pending_(false),
+      seek_stream_(-1),
+      seek_timestamp_(0),
+      seek_flags_(0),
+      seek_result_(false)
+{
+    // Files without known size (pipes, network streams) can't be reliably identified
+    if (use_index_cache && file_size_ > 0 && !load_cached_index()) {
+        collect_index_ = true;
+    }
+    thread_ = std::thread(&PacketReader::run, this);
+}
+
+PacketReader::~PacketReader() noexcept
+{
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        stop_ = true;
+        cond_.notify_all();
+    }
+    thread_.join();
+}
+
+PacketReader::read_result_t PacketReader::read(AVPacket& packet, duration_t timeout)
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    cond_.wait_for(lock, std::chrono::microseconds(timeout), [this]() { return !packets_.empty() || end_; });
+    if (packets_.empty()) {
+        return end_ ? read_result_t::end : read_result_t::empty;
+    }
+    auto p = std::move(packets_.front());
+    packets_.pop_front();
+    bytes_ -= p->size;
+    av_packet_move_ref(&packet, p.get());
+    cond_.notify_all();
+    return read_result_t::packet;
+}
+
+bool PacketReader::seek(int stream_index, int64_t timestamp, int flags)
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    seek_pending_   = true;
+    seek_stream_    = stream_index;
+    seek_timestamp_ = timestamp;
+    seek_flags_     = flags;
+    packets_.clear();
+    bytes_ = 0;
+    cond_.notify_all();
+    cond_.wait(lock, [this]() { return !seek_pending_; });
+    return seek_result_;
+}
+
+void PacketReader::run()
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (!stop_) {
+        if (seek_pending_) {
+            packets_.clear();
+            bytes_        = 0;
+            seek_result_  = av_seek_frame(ctx_, seek_stream_, seek_timestamp_, seek_flags_) >= 0;
+            end_          = false;
+            seek_pending_ = false;
+            // The index is complete only when the whole file was read from the beginning
+            if (collect_index_) {
+                index_.clear();
+                collect_index_ = seek_result_ && seek_timestamp_ == 0;
+            }
+            cond_.notify_all();
+            continue;
+        }
+        if (end_ || packets_.size() >= max_packets_ || (max_bytes_ && bytes_ >= max_bytes_)) {
+            cond_.wait(lock);
+            continue;
+        }
+        lock.unlock();
+        packet_t packet(av_packet_alloc());
+        const int ret = packet ? av_read_frame(ctx_, packet.get()) : AVERROR(ENOMEM);
+        if (ret == AVERROR(EAGAIN)) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        lock.lock();
+        if (seek_pending_ || ret == AVERROR(EAGAIN)) {
+            // The packet belongs to the position before the seek
+            continue;
+        }
+        if (ret < 0) {
+            end_ = true;
+            if (collect_index_) {
+                store_index();
+                collect_index_ = false;
+            }
+            cond_.notify_all();
+            continue;
+        }
+        if (collect_index_ && (packet->flags & AV_PKT_FLAG_KEY) && packet->pos >= 0) {
+            const auto timestamp = packet->dts != AV_NOPTS_VALUE ? packet->dts : packet->pts;
+            if (timestamp != AV_NOPTS_VALUE) {
+                index_.push_back({ packet->stream_index, packet->pos, timestamp, packet->size });
+            }
+        }
+        bytes_ += packet->size;
+        packets_.push_back(std::move(packet));
+        cond_.notify_all();
+    }
+}
+
+bool PacketReader::load_cached_index()
+{
+    std::unique_lock<std::mutex> lock(index_cache_mutex);
+    auto                         it = index_cache.find(filename_);
+    if (it == index_cache.end()) {
+        return false;
+    }
+    if (it->second.file_size != file_size_) {
+        // The file has changed since it was indexed
+        index_cache.erase(it);
+        return false;
+    }
+    for (const auto& e : it->second.entries) {
+        if (e.stream < 0 || static_cast<unsigned>(e.stream) >= ctx_->nb_streams) {
+            continue;
+        }
+        av_add_index_entry(ctx_->streams[e.stream], e.pos, e.timestamp, e.size, 0, AVINDEX_KEYFRAME);
+    }
+    return true;
+}
+
+void PacketReader::store_index()
+{
+    std::unique_lock<std::mutex> lock(index_cache_mutex);
+    if (index_cache.size() >= max_cached_indices && index_cache.find(filename_) == index_cache.end()) {
+        index_cache.erase(index_cache.begin());
+    }
+    index_cache[filename_] = cached_index_t{ file_size_, std::move(index_) };
+    index_.clear();
+}
+
+} /* namespace rawavfile */
+} /* namespace yuri */
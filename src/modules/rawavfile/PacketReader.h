@@ -0,0 +1,106 @@
+/*!
+ * @file 		PacketReader.h
+ * @author 		agent <agent@local>
+ * @date 		18.10.2026
+ * @copyright	Institute of Intermedia, CTU in Prague, 2026
+ * 				Distributed under modified BSD Licence, details in file doc/LICENSE
+ *
+ */
+
+#ifndef SRC_MODULES_RAWAVFILE_PACKETREADER_H_
+#define SRC_MODULES_RAWAVFILE_PACKETREADER_H_
+
+#include "avcommon.h"
+#include "yuri/core/utils/time_types.h"
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace yuri {
+namespace rawavfile {
+
+//! Keyframe position in a file, as needed by av_add_index_entry
+struct keyframe_entry_t {
+    int     stream;
+    int64_t pos;
+    int64_t timestamp;
+    int     size;
+};
+
+/*!
+ * Reads packets from an opened format context in a separate thread.
+ *
+ * The reader stays ahead of the consumer by at most @em max_packets packets
+ * and @em max_bytes bytes, so slow storage doesn't stall the decoding and pacing.
+ *
+ * Keyframes found during the first complete pass through a file are stored
+ * in a process wide cache. When the same file is opened again, the entries
+ * are added to the streams' indices, so seeking doesn't have to scan the file.
+ *
+ * The format context is not owned by the reader, but it mustn't be used
+ * by anybody else while the reader exists.
+ */
+class PacketReader {
+public:
+    enum class read_result_t {
+        //! A packet was returned
+        packet,
+        //! No packet available in time
+        empty,
+        //! End of file reached and all packets were returned
+        end
+    };
+
+    PacketReader(AVFormatContext* ctx, const std::string& filename, size_t max_packets, size_t max_bytes, bool use_index_cache);
+    ~PacketReader() noexcept;
+    PacketReader(const PacketReader&) = delete;
+    PacketReader& operator=(const PacketReader&) = delete;
+
+    /*!
+     * Moves next packet into @em packet, waiting at most @em timeout for it.
+     */
+    read_result_t read(AVPacket& packet, duration_t timeout);
+
+    /*!
+     * Drops all read ahead packets and seeks in the file (parameters as for av_seek_frame).
+     * Waits until the seek is finished.
+     */
+    bool seek(int stream_index, int64_t timestamp, int flags);
+
+private:
+    using packet_t = std::unique_ptr<AVPacket, AVPacketDeleter>;
+
+    void run();
+    bool load_cached_index();
+    void store_index();
+
+    AVFormatContext*              ctx_;
+    const std::string             filename_;
+    const size_t                  max_packets_;
+    const size_t                  max_bytes_;
+    int64_t                       file_size_;
+    bool                          collect_index_;
+    std::vector<keyframe_entry_t> index_;
+
+    std::deque<packet_t>    packets_;
+    size_t                  bytes_;
+    bool                    end_;
+    bool                    stop_;
+    bool                    seek_pending_;
+    int                     seek_stream_;
+    int64_t                 seek_timestamp_;
+    int                     seek_flags_;
+    bool                    seek_result_;
+    std::mutex              mutex_;
+    std::condition_variable cond_;
+    std::thread             thread_;
+};
+
+} /* namespace rawavfile */
+} /* namespace yuri */
+
+#endif /* SRC_MODULES_RAWAVFILE_PACKETREADER_H_ */
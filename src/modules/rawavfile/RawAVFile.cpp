@@ -129,15 +129,20 @@ core::Parameters RawAVFile::configure()
     p["enable_experimental"]["Enable experimental codecs"]                                         = true;
     p["ignore_timestamps"]["Ignore fps (similar to fps < 0), switchable at runtime"]               = false;
     p["audio_sample_rate"]["Force audio sample rate (0 for original)"]                             = 0;
-    p["emit_params_interval"]["Interval to resend SPS and PPS for h264 undecoded stream."
+    p["emit_params_interval"]["Interval (in IDR frames) to resend SPS and PPS for h264 undecoded stream. "
                               "Set to 0 to emit only once at the beginning, "
                               "negative values disables emiting completely."]
         = 1;
-    p["separate_extra_data"]["Send extradata for h264 (SPS, PPS) as separate frames instead of prepending them to IDR frames"] = false;
+    p["separate_extra_data"]["Send extradata for h264 (SPS, PPS) as separate frames instead of prepending them to IDR frames. "
+                             "Prepending requires copying of every IDR frame, separate frames allow passing packets without copying."] = true;
     p["threads"]["Number of threads. Set to 0 to auto select"]                                     = 0;
     p["thread_type"]["Type of threaded decoding - slice, frame or any"]                            = "any";
     p["keep_open"]["Keep player running after ending file in no-loop mode, waiting for next filename"] = false;
     p["black_on_end"]["Send a black frame after finishing playback"] = false;
+    p["read_ahead_packets"]["Maximal number of packets read in advance by the demuxing thread"] = 256;
+    p["read_ahead_size"]["Maximal size (in bytes) of packets read in advance by the demuxing thread. Set to 0 for no limit"] = 32 * 1024 * 1024;
+    p["index_cache"]["Remember keyframe positions of played files, so seeking in them (or looping) doesn't need to scan them again"] = true;
+    p["preopen"]["Open next file (from playlist or set by event) in advance, so the transition is gapless"] = true;
     return p;
 }
 
@@ -147,6 +152,10 @@ RawAVFile::RawAVFile(const log::Log& _log, core::pwThreadBase parent, const core
       BasicEventConsumer(log),
       BasicEventProducer(log),
       fmtctx_(nullptr, [](AVFormatContext* ctx) { avformat_close_input(&ctx); }),
+      read_ahead_packets_(256),
+      read_ahead_size_(32 * 1024 * 1024),
+      index_cache_(true),
+      preopen_(true),
       format_out_(0),
       video_format_out_(0),
       audio_format_out_(0),
@@ -164,7 +173,7 @@ RawAVFile::RawAVFile(const log::Log& _log, core::pwThreadBase parent, const core
       ignore_timestamps_(false),
       emit_params_interval_{ 1 },
       last_params_emitted_{ -1 },
-      separate_extra_data_{false},
+      separate_extra_data_{true},
       paused_(false)
 {
     IOTHREAD_INIT(parameters)
@@ -192,28 +201,78 @@ RawAVFile::RawAVFile(const log::Log& _log, core::pwThreadBase parent, const core
     }
 }
 
-bool RawAVFile::open_file(const std::string& filename)
+std::unique_ptr<AVFormatContext, AVFormatContextDeleter> RawAVFile::open_input(const std::string& filename)
 {
-    video_streams_.clear();
-    audio_streams_.clear();
-    frames_.clear();
     // ffmpeg needs locking of open/close functions...
     auto lock = libav::get_libav_lock();
+    AVFormatContext* ctx = nullptr;
+    if (avformat_open_input(&ctx, filename.c_str(), nullptr, nullptr) < 0 || !ctx) {
+        log[log::error] << "Failed to open " << filename;
+        return {};
+    }
+    std::unique_ptr<AVFormatContext, AVFormatContextDeleter> input(ctx);
+    if (avformat_find_stream_info(ctx, nullptr) < 0) {
+        log[log::fatal] << "Failed to retrieve stream info!";
+        return {};
+    }
+    return input;
+}
+
+void RawAVFile::preopen_next_file()
+{
+    if (!preopen_) {
+        return;
+    }
+    const auto next = peek_next_filename();
+    if (next.empty() || next == filename_ || next == preopened_filename_) {
+        return;
+    }
+    log[log::debug] << "Opening " << next << " in advance";
+    preopened_filename_ = next;
+    preopened_          = std::async(std::launch::async, [this, next]() { return open_input(next); });
+}
+
+void RawAVFile::close_file()
+{
+    // The reader uses the context, so it has to be stopped first
+    reader_.reset();
     if (fmtctx_) {
+        auto lock = libav::get_libav_lock();
         avformat_close_input(&fmtctx_.get_ptr_ref());
     }
-    fmtctx_.reset();
+}
 
-    avformat_open_input(&fmtctx_.get_ptr_ref(), filename.c_str(), nullptr, nullptr);
-    if (!fmtctx_) {
-        log[log::error] << "Failed to allocate Format context";
+bool RawAVFile::open_file(const std::string& filename)
+{
+    close_file();
+    std::unique_ptr<AVFormatContext, AVFormatContextDeleter> input;
+    if (preopened_.valid() && preopened_filename_ == filename) {
+        log[log::debug] << "Using file opened in advance";
+        input = preopened_.get();
+        preopened_filename_.clear();
+    } else {
+        input = open_input(filename);
+    }
+    if (!input) {
         return false;
     }
-
-    if (avformat_find_stream_info(fmtctx_, nullptr) < 0) {
-        log[log::fatal] << "Failed to retrieve stream info!";
+    fmtctx_.get_ptr_ref() = input.release();
+    if (!open_streams()) {
+        close_file();
         return false;
     }
+    reader_ = make_unique<PacketReader>(fmtctx_.get(), filename, read_ahead_packets_, read_ahead_size_, index_cache_);
+    emit_event("filename", filename_);
+    return true;
+}
+
+bool RawAVFile::open_streams()
+{
+    video_streams_.clear();
+    audio_streams_.clear();
+    frames_.clear();
+    // ffmpeg needs locking of open/close functions...
+    auto lock = libav::get_libav_lock();
 
     for (size_t i = 0; i < fmtctx_->nb_streams; ++i) {
         if (fmtctx_->streams[i]->codecpar->codec_type == AVMEDIA_TYPE_VIDEO) {
@@ -328,7 +387,23 @@ bool RawAVFile::open_file(const std::string& filename)
     }
 
     next_times_.resize(video_streams_.size(), timestamp_t{});
-    emit_event("filename", filename_);
+    return true;
+}
+
+bool RawAVFile::rewind()
+{
+    log[log::debug] << "Seeking to the beginning";
+    if (!reader_->seek(0, 0, AVSEEK_FLAG_BACKWARD)) {
+        log[log::warning] << "Failed to seek to the beginning";
+    }
+    if (decode_) {
+        for (auto& s : video_streams_) {
+            avcodec_flush_buffers(s.ctx.get());
+        }
+        for (auto& s : audio_streams_) {
+            avcodec_flush_buffers(s.ctx.get());
+        }
+    }
     return true;
 }
 
@@ -366,23 +441,18 @@ bool RawAVFile::process_file_end()
     emit_event("end", true);
 
             if (loop_ && !has_next_filename() && fmtctx_) {
-                log[log::debug] << "Seeking to the beginning";
-                av_seek_frame(fmtctx_, 0, 0, AVSEEK_FLAG_BACKWARD);
-                if (decode_) {
-                    for (auto &s: video_streams_) {
-                        avcodec_flush_buffers(s.ctx.get());
-                    }
-                    for (auto &s: audio_streams_) {
-                        avcodec_flush_buffers(s.ctx.get());
-                    }
-                }
-                return true;
+                return rewind();
             } else if (has_next_filename() && (loop_ || keep_open_)) {
-                filename_ = get_next_filename();
+                auto next = get_next_filename();
+                if (fmtctx_ && next == filename_) {
+                    // Same file again (e.g. playlist with single item), there's no need to open it again
+                    return rewind();
+                }
+                filename_ = std::move(next);
                 log[log::info] << "Opening: " << filename_;
                 return open_file(filename_);
             } else if (black_on_end_ || keep_open_) {
-                fmtctx_.reset();
+                close_file();
                 if (black_on_end_) {
                     if (!blank_converter_) {
                         blank_converter_ = make_unique<core::Convert>(log, get_this_ptr(), core::Convert::configure());
@@ -430,9 +500,14 @@ bool RawAVFile::process_undecoded_frame(index_t idx, const AVPacket& packet)
     size_t sps_pps_len = 0;
 
     if (format == core::compressed_frame::h264 || format == core::compressed_frame::avc1) {
+        if (packet.size <= nal_length_size) {
+            log[log::warning] << "Received too short packet (" << packet.size << " bytes), ignoring";
+            return false;
+        }
         const auto type = packet.data[nal_length_size] & 0x1fu;
-        // We emit extra data only for IDR frames when !separate_extra_data
-        const bool frame_usable_for_extradata = separate_extra_data_ || type == 5;
+        // Extra data are emitted only before IDR frames, where the decoder can start decoding.
+        // IDR packets may start with AUD or SEI, so the key frame flag is checked as well.
+        const bool frame_usable_for_extradata = type == 5 || (packet.flags & AV_PKT_FLAG_KEY);
 
         if (frame_usable_for_extradata && ((last_params_emitted_ < 0) || (emit_params_interval_ > 0 && (++last_params_emitted_ == emit_params_interval_)))) {
             if (separate_extra_data_) {
@@ -450,7 +525,8 @@ bool RawAVFile::process_undecoded_frame(index_t idx, const AVPacket& packet)
 
     core::pCompressedVideoFrame f;
     if ((extra_bytes + sps_pps_len) == 0) {
-        f = core::CompressedVideoFrame::create_empty(format, video_streams_[idx].resolution, packet.data, packet.size);
+        // The frame shares the buffer with the packet, so no copy is needed
+        f = libav::compressed_frame_from_packet(format, video_streams_[idx].resolution, packet);
     } else {
         f = core::CompressedVideoFrame::create_empty(format, video_streams_[idx].resolution, packet.size + extra_bytes + sps_pps_len);
         if (sps_pps_len > 0) {
@@ -463,6 +539,9 @@ bool RawAVFile::process_undecoded_frame(index_t idx, const AVPacket& packet)
         std::copy(packet.data, packet.data + packet.size, data_start + extra_bytes);
     }
 
+    if (!f) {
+        return false;
+    }
     frames_[idx] = f;
     log[log::debug] << "Pushing packet with size: " << f->size();
     duration_t dur = 1_s * packet.duration * video_streams_[idx].stream->avg_frame_rate.den / video_streams_[idx].stream->avg_frame_rate.num;
@@ -645,6 +724,8 @@ void RawAVFile::run()
             }
         }
 
+        preopen_next_file();
+
         if (paused_ || !push_ready_frames()) {
             sleep(get_latency());
             continue;
@@ -652,7 +733,11 @@ void RawAVFile::run()
 
         if (!keep_packet) {
             av_packet_unref(&packet);
-            if (av_read_frame(fmtctx_, &packet) < 0) {
+            const auto result = reader_->read(packet, get_latency());
+            if (result == PacketReader::read_result_t::empty) {
+                continue;
+            }
+            if (result == PacketReader::read_result_t::end) {
                 finishing = true;
             }
         }
@@ -725,6 +810,10 @@ bool RawAVFile::set_param(const core::Parameter& parameter)
         (threads_, "threads")                                                     //
         (keep_open_, "keep_open")                                                 //
         (black_on_end_, "black_on_end")                                           //
+        (read_ahead_packets_, "read_ahead_packets")                               //
+        (read_ahead_size_, "read_ahead_size")                                     //
+        (index_cache_, "index_cache")                                             //
+        (preopen_, "preopen")                                                     //
         .parsed<std::string>(thread_type_, "thread_type", libav::parse_thread_type)//
         )
         return true;
@@ -788,7 +877,14 @@ std::string RawAVFile::get_next_filename() {
     return n;
 }
 
-RawAVFile::~RawAVFile() noexcept = default;
+std::string RawAVFile::peek_next_filename() {
+    return next_filename_;
+}
+
+RawAVFile::~RawAVFile() noexcept
+{
+    close_file();
+}
 
 } /* namespace video */
 } /* namespace yuri */
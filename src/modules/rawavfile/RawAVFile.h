@@ -12,6 +12,7 @@
 #define AVDEMUXER_H_
 
 #include "avcommon.h"
+#include "PacketReader.h"
 #include "yuri/core/thread/IOFilter.h"
 #include "yuri/event/BasicEventConsumer.h"
 #include "yuri/event/BasicEventProducer.h"
@@ -21,6 +22,7 @@ extern "C" {
 #include <libavformat/avformat.h>
 }
 
+#include <future>
 #include <vector>
 
 namespace yuri {
@@ -41,6 +43,11 @@ protected:
     bool do_process_event(const std::string& event_name, const event::pBasicEvent& event) override;
 
     bool open_file(const std::string& filename);
+    bool open_streams();
+    void close_file();
+    bool rewind();
+    std::unique_ptr<AVFormatContext, AVFormatContextDeleter> open_input(const std::string& filename);
+    void preopen_next_file();
     bool push_ready_frames();
     bool process_file_end();
 
@@ -54,11 +61,20 @@ protected:
 
     virtual bool has_next_filename();
     virtual std::string get_next_filename();
+    //! Returns filename get_next_filename() would return, without advancing to it
+    virtual std::string peek_next_filename();
 protected:
     bool step() override;
 
 private:
     core::utils::managed_resource<AVFormatContext> fmtctx_;
+    std::unique_ptr<PacketReader> reader_;
+    size_t read_ahead_packets_;
+    size_t read_ahead_size_;
+    bool index_cache_;
+    bool preopen_;
+    std::string preopened_filename_;
+    std::future<std::unique_ptr<AVFormatContext, AVFormatContextDeleter>> preopened_;
 
     std::string filename_;
     std::string next_filename_;
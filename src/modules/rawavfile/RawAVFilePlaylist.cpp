@@ -83,5 +83,12 @@ namespace yuri {
             emit_event("playlist_position", playlist_index_);
             return playlist_[playlist_index_++];
         }
+
+        std::string RawAVFilePlaylist::peek_next_filename() {
+            if (playlist_.empty()) {
+                return {};
+            }
+            return playlist_[playlist_index_ % playlist_.size()];
+        }
     }
 }
\ No newline at end of file
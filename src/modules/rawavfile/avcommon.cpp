@@ -32,5 +32,19 @@ thread_type_t parse_thread_type(const std::string& type_string)
     return thread_type_t::any;
     
 }
+
+core::pCompressedVideoFrame compressed_frame_from_packet(format_t format, resolution_t resolution, const AVPacket& packet)
+{
+    if (packet.size <= 0) {
+        return {};
+    }
+    AVBufferRef* buf = packet.buf ? av_buffer_ref(packet.buf) : nullptr;
+    if (!buf) {
+        return core::CompressedVideoFrame::create_empty(format, resolution, packet.data, packet.size);
+    }
+    auto frame = core::CompressedVideoFrame::create_empty(format, resolution);
+    frame->get_data().set(packet.data, packet.size, AVBufferRefDeleter(buf));
+    return frame;
+}
 }
 }
@@ -11,6 +11,10 @@
 #define MODULES_RAWAVFILE_AVCOMMON_H_
 
 #include "yuri/libav/libav.h"
+#include "yuri/core/frame/CompressedVideoFrame.h"
+extern "C" {
+#include <libavformat/avformat.h>
+}
 
 namespace yuri {
 namespace libav {
@@ -18,6 +22,14 @@ enum class thread_type_t { any, slice, frame };
 
 int libav_thread_type(thread_type_t type) ;
 thread_type_t parse_thread_type(const std::string& type_string);
+
+/*!
+ * Creates compressed frame with the data of @em packet.
+ * The frame keeps a reference to the packet's buffer instead of copying the data,
+ * so the packet can be unreferenced (or reused) right after the call.
+ * Packets without reference counted buffer are copied.
+ */
+core::pCompressedVideoFrame compressed_frame_from_packet(format_t format, resolution_t resolution, const AVPacket& packet);
 }
     struct AVPacketDeleter {
         void operator()(AVPacket*p) {
@@ -25,6 +37,21 @@ thread_type_t parse_thread_type(const std::string& type_string);
             av_packet_free(&p);
         }
     };
+    struct AVFormatContextDeleter {
+        void operator()(AVFormatContext* c) {
+            avformat_close_input(&c);
+        }
+    };
+    /*!
+     * Deleter for uvector releasing a reference to AVBufferRef the data belong to.
+     */
+    struct AVBufferRefDeleter {
+        explicit AVBufferRefDeleter(AVBufferRef* buf) : buf(buf) {}
+        void operator()(void*) noexcept {
+            av_buffer_unref(&buf);
+        }
+        AVBufferRef* buf;
+    };
 }
 
 #endif /* MODULES_RAWAVFILE_AVCOMMON_H_ */
\ No newline at end of file
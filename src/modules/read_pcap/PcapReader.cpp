@@ -0,0 +1,417 @@
+/*!
+ * @file 		PcapReader.cpp
+ * @author 		agent <agent@local>
+ * @date 		19.10.2026
+ * @copyright	Institute of Intermedia, CTU in Prague, 2026
+ * 				Distributed under modified BSD Licence, details in file doc/LICENSE
+ *
+ */
+
+#include "PcapReader.h"
+#include "yuri/exception/InitializationFailed.h"
+#include <algorithm>
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <sstream>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace yuri {
+namespace pcap {
+
+namespace {
+
+const size_t file_header_size	= 24;
+const size_t record_header_size	= 16;
+
+const uint32_t magic_micro		= 0xa1b2c3d4;
+const uint32_t magic_nano		= 0xa1b23c4d;
+const uint32_t magic_pcapng		= 0x0a0d0d0a;
+
+namespace link_type {
+const uint32_t null				= 0;
+const uint32_t ethernet			= 1;
+const uint32_t raw_openbsd		= 12;
+const uint32_t raw				= 101;
+const uint32_t linux_sll		= 113;
+const uint32_t ipv4				= 228;
+const uint32_t ipv6				= 229;
+const uint32_t linux_sll2		= 276;
+}
+
+const uint16_t ethertype_ipv4	= 0x0800;
+const uint16_t ethertype_ipv6	= 0x86DD;
+const uint16_t ethertype_vlan	= 0x8100;
+const uint16_t ethertype_qinq	= 0x88A8;
+
+uint16_t read_be16(const uint8_t* data)
+{
+	return static_cast<uint16_t>((data[0] << 8) | data[1]);
+}
+
+uint32_t read_le32(const uint8_t* data)
+{
+	return static_cast<uint32_t>(data[0]) | (static_cast<uint32_t>(data[1]) << 8) |
+			(static_cast<uint32_t>(data[2]) << 16) | (static_cast<uint32_t>(data[3]) << 24);
+}
+
+uint32_t swap32(uint32_t value)
+{
+	return ((value & 0xFF) << 24) | ((value & 0xFF00) << 8) | ((value >> 8) & 0xFF00) | (value >> 24);
+}
+
+}
+
+bool operator==(const ip_address_t& a, const ip_address_t& b)
+{
+	if (a.version != b.version) return false;
+	return std::equal(a.bytes.begin(), a.bytes.begin() + (a.version == 4 ? 4 : 16), b.bytes.begin());
+}
+
+bool parse_ip_address(const std::string& text, ip_address_t& address)
+{
+	address.bytes.fill(0);
+	if (inet_pton(AF_INET, text.c_str(), address.bytes.data()) == 1) {
+		address.version = 4;
+		return true;
+	}
+	if (inet_pton(AF_INET6, text.c_str(), address.bytes.data()) == 1) {
+		address.version = 6;
+		return true;
+	}
+	return false;
+}
+
+PcapReader::PcapReader(const std::string& filename)
+:size_(0),position_(file_header_size),swapped_(false),nanoseconds_(false),link_type_(0)
+{
+	const int fd = ::open(filename.c_str(), O_RDONLY);
+	if (fd < 0) throw exception::InitializationFailed("Failed to open file " + filename);
+	struct stat st;
+	if (::fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < file_header_size) {
+		::close(fd);
+		throw exception::InitializationFailed("File " + filename + " is not a pcap file");
+	}
+	size_ = static_cast<size_t>(st.st_size);
+	// Read only mapping, the payloads are passed on without copying and must never be written to
+	void* mem = ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+	::close(fd);
+	if (mem == MAP_FAILED) throw exception::InitializationFailed("Failed to map file " + filename);
+	::madvise(mem, size_, MADV_SEQUENTIAL);
+	const auto size = size_;
+	mapping_ = std::shared_ptr<uint8_t>(static_cast<uint8_t*>(mem), [size](uint8_t* p) noexcept { ::munmap(p, size); });
+
+	const auto magic = read_le32(mapping_.get());
+	if (magic == magic_micro || magic == magic_nano) {
+		nanoseconds_ = magic == magic_nano;
+	} else if (swap32(magic) == magic_micro || swap32(magic) == magic_nano) {
+		swapped_ = true;
+		nanoseconds_ = swap32(magic) == magic_nano;
+	} else if (magic == magic_pcapng) {
+		throw exception::InitializationFailed("pcapng files are not supported, convert the file to pcap first");
+	} else {
+		throw exception::InitializationFailed("File " + filename + " is not a pcap file");
+	}
+	link_type_ = read32(mapping_.get() + 20) & 0xFFFF;
+	switch (link_type_) {
+		case link_type::null:
+		case link_type::ethernet:
+		case link_type::raw_openbsd:
+		case link_type::raw:
+		case link_type::linux_sll:
+		case link_type::ipv4:
+		case link_type::ipv6:
+		case link_type::linux_sll2:
+			break;
+		default:
+			throw exception::InitializationFailed("Unsupported link type " + std::to_string(link_type_));
+	}
+}
+
+PcapReader::~PcapReader() noexcept
+{
+}
+
+uint32_t PcapReader::read32(const uint8_t* data) const
+{
+	const auto value = read_le32(data);
+	return swapped_ ? swap32(value) : value;
+}
+
+void PcapReader::rewind()
+{
+	position_ = file_header_size;
+}
+
+bool PcapReader::next(pcap_packet_t& packet)
+{
+	const auto base = mapping_.get();
+	while (position_ + record_header_size <= size_) {
+		const auto header = base + position_;
+		const auto captured = read32(header + 8);
+		if (captured > size_ - position_ - record_header_size) {
+			// Incomplete last record
+			++stats_.truncated;
+			position_ = size_;
+			return false;
+		}
+		position_ += record_header_size + captured;
+		++stats_.records;
+		const auto sec = read32(header);
+		const auto frac = read32(header + 4);
+		packet.timestamp = duration_t{static_cast<int64_t>(sec) * 1000000 + (nanoseconds_ ? frac / 1000 : frac)};
+		if (parse_record(header + record_header_size, captured, packet)) {
+			++stats_.packets;
+			return true;
+		}
+	}
+	return false;
+}
+
+bool PcapReader::parse_record(const uint8_t* data, size_t size, pcap_packet_t& packet)
+{
+	size_t offset = 0;
+	uint16_t ethertype = 0;
+	switch (link_type_) {
+		case link_type::ethernet:
+			offset = 14;
+			if (size < offset) break;
+			ethertype = read_be16(data + 12);
+			while ((ethertype == ethertype_vlan || ethertype == ethertype_qinq) && offset + 4 <= size) {
+				ethertype = read_be16(data + offset + 2);
+				offset += 4;
+			}
+			break;
+		case link_type::linux_sll:
+			offset = 16;
+			if (size < offset) break;
+			ethertype = read_be16(data + 14);
+			break;
+		case link_type::linux_sll2:
+			offset = 20;
+			if (size < offset) break;
+			ethertype = read_be16(data);
+			break;
+		case link_type::null:
+			// Address family is in byte order of the capturing machine, IP version is used instead
+			offset = 4;
+			break;
+		default:
+			break;
+	}
+	if (offset > size) {
+		++stats_.truncated;
+		return false;
+	}
+	if (ethertype && ethertype != ethertype_ipv4 && ethertype != ethertype_ipv6) {
+		++stats_.non_ip;
+		return false;
+	}
+	return parse_ip(data + offset, size - offset, packet);
+}
+
+bool PcapReader::parse_ip(const uint8_t* data, size_t size, pcap_packet_t& packet)
+{
+	if (size < 1) {
+		++stats_.truncated;
+		return false;
+	}
+	const auto version = data[0] >> 4;
+	if (version == 4) {
+		const size_t header_size = (data[0] & 0x0F) * 4;
+		if (size < 20 || header_size < 20 || header_size > size) {
+			++stats_.truncated;
+			return false;
+		}
+		// Fragments can't be replayed as separate datagrams
+		if (read_be16(data + 6) & 0x3FFF) {
+			++stats_.unsupported;
+			return false;
+		}
+		size_t total = read_be16(data + 2);
+		// Packets captured before segmentation offload may have zero length
+		if (total == 0) total = size;
+		if (total < header_size) {
+			++stats_.truncated;
+			return false;
+		}
+		packet.protocol = data[9];
+		packet.src.version = 4;
+		packet.dst.version = 4;
+		std::copy(data + 12, data + 16, packet.src.bytes.begin());
+		std::copy(data + 16, data + 20, packet.dst.bytes.begin());
+		return parse_transport(data + header_size, size - header_size, total - header_size, packet);
+	}
+	if (version == 6) {
+		if (size < 40) {
+			++stats_.truncated;
+			return false;
+		}
+		packet.src.version = 6;
+		packet.dst.version = 6;
+		std::copy(data + 8, data + 24, packet.src.bytes.begin());
+		std::copy(data + 24, data + 40, packet.dst.bytes.begin());
+		size_t payload = read_be16(data + 4);
+		uint8_t next_header = data[6];
+		size_t offset = 40;
+		// Skip extension headers
+		while (next_header == 0 || next_header == 43 || next_header == 60 || next_header == 51) {
+			if (offset + 2 > size) {
+				++stats_.truncated;
+				return false;
+			}
+			const size_t length = next_header == 51 ? (data[offset + 1] + 2) * 4 : (data[offset + 1] + 1) * 8;
+			if (length > payload) {
+				++stats_.truncated;
+				return false;
+			}
+			next_header = data[offset];
+			offset += length;
+			payload -= length;
+		}
+		if (offset > size) {
+			++stats_.truncated;
+			return false;
+		}
+		packet.protocol = next_header;
+		return parse_transport(data + offset, size - offset, payload, packet);
+	}
+	++stats_.non_ip;
+	return false;
+}
+
+bool PcapReader::parse_transport(const uint8_t* data, size_t size, size_t ip_payload, pcap_packet_t& packet)
+{
+	size_t header_size = 0;
+	size_t payload = 0;
+	if (packet.protocol == ip_protocol::udp) {
+		if (size < 8 || ip_payload < 8) {
+			++stats_.truncated;
+			return false;
+		}
+		header_size = 8;
+		payload = read_be16(data + 4);
+		if (payload < 8 || payload > ip_payload) {
+			++stats_.truncated;
+			return false;
+		}
+		payload -= 8;
+	} else if (packet.protocol == ip_protocol::tcp) {
+		if (size < 20) {
+			++stats_.truncated;
+			return false;
+		}
+		header_size = (data[12] >> 4) * 4;
+		if (header_size < 20 || header_size > ip_payload) {
+			++stats_.truncated;
+			return false;
+		}
+		payload = ip_payload - header_size;
+	} else {
+		++stats_.unsupported;
+		return false;
+	}
+	if (header_size + payload > size) {
+		// Packet wasn't captured completely (snaplen)
+		++stats_.truncated;
+		return false;
+	}
+	packet.src_port = read_be16(data);
+	packet.dst_port = read_be16(data + 2);
+	packet.payload = data + header_size;
+	packet.size = payload;
+	return true;
+}
+
+PcapFilter::PcapFilter(const std::string& expression)
+{
+	std::istringstream ss(expression);
+	std::vector<std::string> tokens;
+	std::string token;
+	while (ss >> token) tokens.push_back(token);
+
+	auto fail = [&expression](const std::string& reason) {
+		throw exception::InitializationFailed("Invalid filter '" + expression + "': " + reason);
+	};
+	auto parse_port = [&fail](const std::string& text) {
+		size_t end = 0;
+		unsigned long value = 0;
+		try {
+			value = std::stoul(text, &end);
+		}
+		catch (std::exception&) {
+			fail("invalid port " + text);
+		}
+		if (end != text.size() || value > 0xFFFF) fail("invalid port " + text);
+		return static_cast<uint16_t>(value);
+	};
+
+	for (size_t i = 0; i < tokens.size();) {
+		if (!terms_.empty()) {
+			if (tokens[i] != "and" && tokens[i] != "&&") fail("expected 'and' instead of '" + tokens[i] + "'");
+			if (++i >= tokens.size()) fail("missing term after 'and'");
+		}
+		term_t term {term_kind_t::protocol, direction_t::any, false, 0, 0, 0, {}};
+		if (tokens[i] == "not" || tokens[i] == "!") {
+			term.negate = true;
+			if (++i >= tokens.size()) fail("missing term after 'not'");
+		}
+		if (tokens[i] == "src" || tokens[i] == "dst") {
+			term.direction = tokens[i] == "src" ? direction_t::src : direction_t::dst;
+			if (++i >= tokens.size()) fail("missing term after direction");
+		}
+		const auto& keyword = tokens[i++];
+		if (keyword == "udp" || keyword == "tcp") {
+			if (term.direction != direction_t::any) fail("direction can't be used with protocol");
+			term.protocol = keyword == "udp" ? ip_protocol::udp : ip_protocol::tcp;
+		} else if (keyword == "port" || keyword == "portrange" || keyword == "host") {
+			if (i >= tokens.size()) fail("missing value for " + keyword);
+			const auto& value = tokens[i++];
+			if (keyword == "port") {
+				term.kind = term_kind_t::port;
+				term.port_min = term.port_max = parse_port(value);
+			} else if (keyword == "portrange") {
+				term.kind = term_kind_t::port;
+				const auto dash = value.find('-');
+				if (dash == std::string::npos) fail("invalid port range " + value);
+				term.port_min = parse_port(value.substr(0, dash));
+				term.port_max = parse_port(value.substr(dash + 1));
+			} else {
+				term.kind = term_kind_t::host;
+				if (!parse_ip_address(value, term.address)) fail("invalid address " + value);
+			}
+		} else {
+			fail("unknown term '" + keyword + "'");
+		}
+		terms_.push_back(term);
+	}
+}
+
+bool PcapFilter::match(const pcap_packet_t& packet) const
+{
+	for (const auto& term: terms_) {
+		if (match_term(term, packet) == term.negate) return false;
+	}
+	return true;
+}
+
+bool PcapFilter::match_term(const term_t& term, const pcap_packet_t& packet) const
+{
+	switch (term.kind) {
+		case term_kind_t::protocol:
+			return packet.protocol == term.protocol;
+		case term_kind_t::port: {
+			auto in_range = [&term](uint16_t port) { return port >= term.port_min && port <= term.port_max; };
+			return (term.direction != direction_t::dst && in_range(packet.src_port)) ||
+					(term.direction != direction_t::src && in_range(packet.dst_port));
+		}
+		case term_kind_t::host:
+			return (term.direction != direction_t::dst && packet.src == term.address) ||
+					(term.direction != direction_t::src && packet.dst == term.address);
+	}
+	return false;
+}
+
+} /* namespace pcap */
+} /* namespace yuri */
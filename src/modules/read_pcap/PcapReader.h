@@ -0,0 +1,159 @@
+/*!
+ * @file 		PcapReader.h
+ * @author 		agent <agent@local>
+ * @date 		19.10.2026
+ * @copyright	Institute of Intermedia, CTU in Prague, 2026
+ * 				Distributed under modified BSD Licence, details in file doc/LICENSE
+ *
+ */
+
+#ifndef SRC_MODULES_READ_PCAP_PCAPREADER_H_
+#define SRC_MODULES_READ_PCAP_PCAPREADER_H_
+
+#include "yuri/core/utils/new_types.h"
+#include "yuri/core/utils/time_types.h"
+#include <array>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace yuri {
+namespace pcap {
+
+namespace ip_protocol {
+const uint8_t tcp = 6;
+const uint8_t udp = 17;
+}
+
+struct ip_address_t {
+	//! 4 for IPv4, 6 for IPv6
+	uint8_t					version;
+	//! IPv4 addresses use first 4 bytes
+	std::array<uint8_t, 16>	bytes;
+};
+
+bool operator==(const ip_address_t& a, const ip_address_t& b);
+
+/*!
+ * Parses IPv4 or IPv6 address
+ * @return false for invalid address
+ */
+bool parse_ip_address(const std::string& text, ip_address_t& address);
+
+//! UDP datagram or TCP segment read from the capture
+struct pcap_packet_t {
+	//! Capture time
+	duration_t		timestamp;
+	uint8_t			protocol;
+	ip_address_t	src;
+	ip_address_t	dst;
+	uint16_t		src_port;
+	uint16_t		dst_port;
+	//! Payload stored directly in the mapped file
+	const uint8_t*	payload;
+	size_t			size;
+};
+
+struct pcap_reader_stats_t {
+	//! All records in the capture
+	size_t	records		= 0;
+	//! UDP and TCP packets returned
+	size_t	packets		= 0;
+	//! Records that are not IPv4 or IPv6
+	size_t	non_ip		= 0;
+	//! IP fragments and protocols other than UDP and TCP
+	size_t	unsupported	= 0;
+	//! Packets not captured completely or malformed
+	size_t	truncated	= 0;
+};
+
+/*!
+ * Reader of pcap capture files (not pcapng).
+ *
+ * The file is mapped into memory and the packets are returned without copying,
+ * so the payload stays valid as long as the mapping (see get_mapping()) exists.
+ * The mapping is read only, the payload must not be modified.
+ * Supports Ethernet (with VLAN tags), Linux cooked (v1 and v2), BSD loopback
+ * and raw IP captures with micro or nanosecond timestamps in both byte orders.
+ */
+class PcapReader {
+public:
+	//! Maps the file, throws exception::InitializationFailed on failure
+	PcapReader(const std::string& filename);
+	~PcapReader() noexcept;
+
+	/*!
+	 * Reads next UDP or TCP packet
+	 * @return false at the end of the file
+	 */
+	bool next(pcap_packet_t& packet);
+	//! Restarts reading from the first packet
+	void rewind();
+
+	uint32_t get_link_type() const { return link_type_; }
+	//! Returns the mapped file, that keeps the payload of the packets valid
+	const std::shared_ptr<uint8_t>& get_mapping() const { return mapping_; }
+
+	const pcap_reader_stats_t& get_stats() const { return stats_; }
+	void reset_stats() { stats_ = pcap_reader_stats_t{}; }
+
+private:
+	//! Parses a record starting with link layer header
+	bool parse_record(const uint8_t* data, size_t size, pcap_packet_t& packet);
+	bool parse_ip(const uint8_t* data, size_t size, pcap_packet_t& packet);
+	bool parse_transport(const uint8_t* data, size_t size, size_t ip_payload, pcap_packet_t& packet);
+	uint32_t read32(const uint8_t* data) const;
+
+	std::shared_ptr<uint8_t>	mapping_;
+	size_t						size_;
+	size_t						position_;
+	bool						swapped_;
+	bool						nanoseconds_;
+	uint32_t					link_type_;
+	pcap_reader_stats_t			stats_;
+};
+
+/*!
+ * Simple subset of BPF filter expressions.
+ *
+ * Supports terms 'udp', 'tcp', '[src|dst] port N', '[src|dst] portrange N-M'
+ * and '[src|dst] host ADDRESS', each optionally prefixed with 'not',
+ * combined with 'and'. Empty expression matches all packets.
+ */
+class PcapFilter {
+public:
+	PcapFilter() = default;
+	//! Parses the expression, throws exception::InitializationFailed for invalid expressions
+	explicit PcapFilter(const std::string& expression);
+
+	bool match(const pcap_packet_t& packet) const;
+
+private:
+	enum class term_kind_t {
+		protocol,
+		port,
+		host
+	};
+	enum class direction_t {
+		any,
+		src,
+		dst
+	};
+	struct term_t {
+		term_kind_t		kind;
+		direction_t		direction;
+		bool			negate;
+		uint8_t			protocol;
+		uint16_t		port_min;
+		uint16_t		port_max;
+		ip_address_t	address;
+	};
+	bool match_term(const term_t& term, const pcap_packet_t& packet) const;
+
+	std::vector<term_t>	terms_;
+};
+
+} /* namespace pcap */
+} /* namespace yuri */
+
+#endif /* SRC_MODULES_READ_PCAP_PCAPREADER_H_ */
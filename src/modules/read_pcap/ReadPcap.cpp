@@ -1,167 +1,174 @@
-/*
- * ReadPcap.cpp
+/*!
+ * @file 		ReadPcap.cpp
+ * @author 		Zdenek Travnicek <v154c1@gmail.com>
+ * @date 		26.2.2013
+ * @date		19.10.2026
+ * @copyright	Institute of Intermedia, CTU in Prague, 2013 - 2026
+ * 				Distributed under modified BSD Licence, details in file doc/LICENSE
  *
- *  Created on: 26.2.2013
- *      Author: neneko
  */
 
 #include "ReadPcap.h"
 #include "yuri/core/Module.h"
-#include <iomanip>
-#include <arpa/inet.h>
+#include "yuri/core/frame/CompressedVideoFrame.h"
+#include "yuri/core/frame/compressed_frame_types.h"
+#include "yuri/core/frame/compressed_frame_params.h"
+#include "yuri/core/socket/DatagramSocketGenerator.h"
+#include "yuri/core/utils/make_unique.h"
 
 namespace yuri {
 namespace pcap {
 
-REGISTER("read_pcap",ReadPcap)
-IO_THREAD_GENERATOR(ReadPcap)
+IOTHREAD_GENERATOR(ReadPcap)
 
-core::pParameters ReadPcap::configure()
+MODULE_REGISTRATION_BEGIN("read_pcap")
+		REGISTER_IOTHREAD("read_pcap",ReadPcap)
+MODULE_REGISTRATION_END()
+
+namespace {
+//! Packets planned closer than this are sent without waiting
+const auto wait_tolerance = 50_us;
+}
+
+core::Parameters ReadPcap::configure()
 {
-	core::pParameters p = core::IOThread::configure();
-	p->set_description("ReadPcap module.");
-	(*p)["filename"]["File to read from"]=std::string();
-	p->set_max_pipes(1,1);
+	core::Parameters p = core::IOThread::configure();
+	p.set_description("Replays UDP and TCP payloads from a pcap file as frames or sends them to a socket.");
+	p["filename"]["File to read from"]=std::string();
+	p["filter"]["Filter for the packets, e.g. 'udp and dst port 5004'. Supports udp, tcp, [src|dst] port, portrange and host terms, 'not' and 'and'."]=std::string();
+	p["speed"]["Replay speed relative to the capture timing. Set to 0 to replay as fast as possible."]=1.0;
+	p["loops"]["Number of times to replay the file, 0 to repeat forever"]=1;
+	p["format"]["Format of output frames (e.g. mpeg2ts)"]="unidentified";
+	p["socket_type"]["Socket used to send the packets"]="yuri_udp";
+	p["address"]["Address to send the packets to"]="127.0.0.1";
+	p["port"]["Port to send the packets to. Set to 0 to output the packets as frames instead."]=0;
+	p["batch"]["Maximal number of packets sent at once"]=64;
 	return p;
 }
-namespace {
-struct pcap_header_ {
-	uint32_t 	magic;
-	struct {
-		uint16_t major;
-		uint16_t minor;
-	} version;
-	int32_t 	zone;
-	uint32_t	sigfigs;
-	uint32_t	snaplen;
-	uint32_t	network;
-};
-struct packet_header_ {
-	uint32_t 	sec;
-	uint32_t 	usec;
-	uint32_t 	len;
-	uint32_t 	orig_len;
-};
-struct ip_header_ {
-	uint8_t		mac_dest[6];
-	uint8_t		mac_src[6];
-	uint16_t	type;
-};
-struct ipv4_header_ {
-	uint8_t		version;//:4;
-//	uint8_t		header_length:4;
-	uint8_t		dsf;
-	uint16_t	total_length;
-	uint16_t	id;
-	uint16_t	flags;
-	uint8_t		ttl;
-	uint8_t		protocol;
-	uint16_t	checksum;
-	uint32_t	src_ip;
-	uint32_t	dst_ip;
-};
-struct udp_header_ {
-	uint16_t	src_port;
-	uint16_t	dst_port;
-	uint16_t	length;
-	uint16_t	checksum;
-};
-}
 
 
-ReadPcap::ReadPcap(log::Log &log_, core::pwThreadBase parent, core::Parameters &parameters):
-core::IOThread(log_,parent,1,1,std::string("ReadPcap")),packet_count(0),last_valid_size(0)
+ReadPcap::ReadPcap(const log::Log &log_, core::pwThreadBase parent, const core::Parameters &parameters):
+core::IOThread(log_,parent,0,1,std::string("read_pcap")),speed_(1.0),loops_(1),
+format_(core::compressed_frame::unidentified),socket_type_("yuri_udp"),address_("127.0.0.1"),
+port_(0),batch_size_(64),sent_packets_(0),sent_bytes_(0),failed_packets_(0)
 {
-	IO_THREAD_INIT("ReadPcap")
-	file_.open(filename_.c_str(),std::ios::in|std::ios::binary);
-	if (!file_.is_open()) throw exception::InitializationFailed("Failed to open open file");
-	pcap_header_ header;
-	file_.read(reinterpret_cast<char*>(&header),sizeof(pcap_header_));
-	if (!file_.good()) throw exception::InitializationFailed("Failed to read pcap file header");
-	log[log::info] << "Opened pcap file with version " << header.version.major << "."
-			<< header.version.major << ", with capture of network " << header.network <<"\n";
-	if (header.network != 1) throw exception::InitializationFailed("Only ethernet captures supported now");
-
+	IOTHREAD_INIT(parameters)
+	if (!batch_size_) batch_size_ = 1;
+	reader_ = make_unique<PcapReader>(filename_);
+	filter_ = PcapFilter(filter_expression_);
+	log[log::info] << "Opened pcap file " << filename_ << " with link type " << reader_->get_link_type();
+	batch_.reserve(batch_size_);
 }
 
-ReadPcap::~ReadPcap()
+ReadPcap::~ReadPcap() noexcept
 {
 }
 
 void ReadPcap::run()
 {
-	IO_THREAD_PRE_RUN
-	packet_header_ pkt_header;
-	std::vector<char> data;
-	while(still_running()) {
-		file_.read(reinterpret_cast<char*>(&pkt_header),sizeof(packet_header_));
-		if(!file_.good()) break;
-		if(pkt_header.len>65536) {
-			log[log::warning] << "Read packet with an invalid length " << pkt_header.len << ". Nothing to read anymore\n";
-			if (last_valid_size) pkt_header.len =  last_valid_size;
-			else {
-				log[log::error] << "No previous valid packet to guess size from, bailing out\n";
-				break;
-			}
-//			break;
-		} else last_valid_size = pkt_header.len;
-		log[log::debug] << "Read packet from time " << pkt_header.sec << "." <<std::setfill('0') << std::setw(6)  << pkt_header.usec
-				<< ". Captured " << pkt_header.len << "/" << pkt_header.orig_len << " bytes\n";
-
-		data.resize(pkt_header.len);
-		file_.read(&data[0],pkt_header.len);
-		if(!file_.good()) break;
-		packet_count++;
-		if (data.size() < sizeof(ip_header_)) {
-			log[log::warning] << "Packet too small to parse\n";
-			continue;
-		}
-		ip_header_ *ip_hdr = reinterpret_cast<ip_header_*>(&data[0]);
-		if (ip_hdr->type != 0x0008) {
-			log[log::warning] << "Packet is not an IPv4 packet\n";
-			continue;
+	if (port_) {
+		log[log::info] << "Initializing socket of type '" << socket_type_ << "'";
+		socket_ = core::DatagramSocketGenerator::get_instance().generate(socket_type_, log, "");
+		if (!socket_->connect(address_, port_)) {
+			log[log::fatal] << "Failed to connect socket!";
+			request_end(core::yuri_exit_interrupted);
+			return;
 		}
-		if (data.size() < sizeof(ip_header_)+sizeof(ipv4_header_)) {
-			log[log::warning] << "Packet too small to parse\n";
-			continue;
-		}
-		ipv4_header_ *ipv4_hdr = reinterpret_cast<ipv4_header_*>(&data[sizeof(ip_header_)]);
-		if (ipv4_hdr->protocol != 17) {
-			log[log::warning] << "Packet is not an UDP packet\n";
+	}
+
+	const timestamp_t start;
+	timestamp_t now = start;
+	pcap_packet_t packet;
+	bool has_packet = false;
+	duration_t first_time = 0_us;
+	duration_t last_time = 0_us;
+	// Time shift of the current loop, so the loops follow each other
+	duration_t loop_offset = 0_us;
+	size_t loop = 0;
+	while (still_running()) {
+		if (!reader_->next(packet)) {
+			if (!has_packet || (loops_ && ++loop >= loops_)) break;
+			reader_->rewind();
+			loop_offset += last_time - first_time;
 			continue;
 		}
-		uint8_t header_length = ipv4_hdr->version&0x0F;
-		if (header_length != 5) {
-			log[log::warning] << "Unsupported header size ("<<static_cast<int>(header_length)<<")\n";
-			continue;
+		if (!filter_.match(packet)) continue;
+		if (!has_packet) {
+			first_time = packet.timestamp;
+			has_packet = true;
 		}
-		if (data.size() < sizeof(ip_header_)+sizeof(ipv4_header_)+sizeof(udp_header_)) {
-			log[log::warning] << "Packet too small to parse\n";
-			continue;
+		last_time = packet.timestamp;
+		const auto offset = packet.timestamp - first_time + loop_offset;
+		if (speed_ > 0.0) {
+			const auto due = start + duration_t{static_cast<int64_t>(offset.value / speed_)};
+			// Current time is read only when the packet may not be due yet
+			if (due > now + wait_tolerance) {
+				now = timestamp_t{};
+				while (due > now + wait_tolerance && still_running()) {
+					flush_batch();
+					ThreadBase::sleep(std::min(due - now, get_latency()));
+					now = timestamp_t{};
+				}
+			}
 		}
-		udp_header_* udp_header = reinterpret_cast<udp_header_*>(&data[sizeof(ip_header_)+sizeof(ipv4_header_)]);
-		uint16_t data_len = ntohs(udp_header->length) - sizeof(udp_header_);
-		log[log::debug] << "Found UDP packet with " << data_len << " bytes of data\n";
-		core::pBasicFrame frame = allocate_frame_from_memory(reinterpret_cast<ubyte_t*>(&data[sizeof(ip_header_)+sizeof(ipv4_header_)+sizeof(udp_header_)]),data_len);
-		push_video_frame(0,frame,YURI_FMT_NONE,0,0);
+		emit_packet(packet, start + offset);
+	}
+	flush_batch();
+
+	const auto elapsed = timestamp_t{} - start;
+	const auto& stats = reader_->get_stats();
+	log[log::info] << "Replayed " << sent_packets_ << " packets (" << sent_bytes_ << " bytes) in " << elapsed
+			<< ", " << (elapsed.value ? sent_packets_ * 1e6 / elapsed.value : 0.0) << " packets/s";
+	log[log::info] << "Read " << stats.records << " records, " << stats.packets << " UDP/TCP packets, "
+			<< stats.non_ip << " non IP, " << stats.unsupported << " unsupported, " << stats.truncated << " truncated";
+	if (failed_packets_) {
+		log[log::warning] << "Failed to send " << failed_packets_ << " packets";
+	}
+	request_end(core::yuri_exit_finished);
+}
 
+void ReadPcap::emit_packet(const pcap_packet_t& packet, timestamp_t timestamp)
+{
+	if (port_) {
+		batch_.push_back({packet.payload, packet.size});
+		if (batch_.size() >= batch_size_) flush_batch();
+		return;
 	}
-	log[log::info] << "Read total " << packet_count << " packets\n";
-	IO_THREAD_POST_RUN
-	request_end(YURI_EXIT_OK);
-	/*if (!in[0]) return true;
-	core::pBasicFrame frame = in[0]->pop_frame();
-	if (!frame) return true;
-
-	if(!discard) push_raw_frame(0,frame);
-	return true;*/
+	// The payload is copied, as the frames may be modified in place further in the pipeline
+	// and the mapping is read only.
+	auto frame = core::CompressedVideoFrame::create_empty(format_, resolution_t{0, 0}, packet.payload, packet.size);
+	frame->set_timestamp(timestamp);
+	push_frame(0, std::move(frame));
+	++sent_packets_;
+	sent_bytes_ += packet.size;
 }
+
+void ReadPcap::flush_batch()
+{
+	if (batch_.empty()) return;
+	const auto sent = socket_->send_datagrams(batch_);
+	for (size_t i = 0; i < sent; ++i) {
+		sent_bytes_ += batch_[i].size;
+	}
+	sent_packets_ += sent;
+	failed_packets_ += batch_.size() - sent;
+	batch_.clear();
+}
+
 bool ReadPcap::set_param(const core::Parameter &param)
 {
-	if (param.name == "filename") {
-		filename_ = param.get<std::string>();
-	} else return core::IOThread::set_param(param);
-	return true;
+	if (assign_parameters(param)
+			(filename_, "filename")
+			(filter_expression_, "filter")
+			(speed_, "speed")
+			(loops_, "loops")
+			(format_, "format", [](const core::Parameter& p){ return core::compressed_frame::parse_format(p.get<std::string>()); })
+			(socket_type_, "socket_type")
+			(address_, "address")
+			(port_, "port")
+			(batch_size_, "batch"))
+		return true;
+	return core::IOThread::set_param(param);
 }
 
 } /* namespace pcap */
@@ -1,33 +1,66 @@
-/*
- * ReadPcap.h
+/*!
+ * @file 		ReadPcap.h
+ * @author 		Zdenek Travnicek <v154c1@gmail.com>
+ * @date 		26.2.2013
+ * @date		19.10.2026
+ * @copyright	Institute of Intermedia, CTU in Prague, 2013 - 2026
+ * 				Distributed under modified BSD Licence, details in file doc/LICENSE
  *
- *  Created on: 26.2.2013
- *      Author: neneko
  */
 
 #ifndef READPCAP_H_
 #define READPCAP_H_
 
-#include "yuri/core/IOThread.h"
-#include <fstream>
+#include "PcapReader.h"
+#include "yuri/core/thread/IOThread.h"
+#include "yuri/core/socket/DatagramSocket.h"
 
 namespace yuri {
 namespace pcap {
 
+/*!
+ * Replays UDP (or TCP) payloads from a pcap capture, either as frames
+ * or sent directly to a datagram socket.
+ *
+ * Packets sent to a socket are read directly from the mapping of the capture file,
+ * output frames get a copy of the payload.
+ */
 class ReadPcap: public core::IOThread
 {
 public:
-	virtual ~ReadPcap();
-	IO_THREAD_GENERATOR_DECLARATION
-	static core::pParameters configure();
+	IOTHREAD_GENERATOR_DECLARATION
+	static core::Parameters configure();
+	ReadPcap(const log::Log &log_, core::pwThreadBase parent, const core::Parameters &parameters);
+	virtual ~ReadPcap() noexcept;
 private:
-	ReadPcap(log::Log &log_, core::pwThreadBase parent, core::Parameters &parameters);
-	virtual void run();
-	virtual bool set_param(const core::Parameter &param);
+	virtual void run() override;
+	virtual bool set_param(const core::Parameter &param) override;
+
+	//! Outputs or sends all packets in the batch
+	void flush_batch();
+	/*!
+	 * Outputs or sends the packet
+	 * @param timestamp Capture time of the packet relative to the start of the replay
+	 */
+	void emit_packet(const pcap_packet_t& packet, timestamp_t timestamp);
+
 	std::string filename_;
-	std::ifstream file_;
-	size_t packet_count;
-	size_t last_valid_size;
+	std::string filter_expression_;
+	double speed_;
+	size_t loops_;
+	format_t format_;
+	std::string socket_type_;
+	std::string address_;
+	uint16_t port_;
+	size_t batch_size_;
+
+	std::unique_ptr<PcapReader> reader_;
+	PcapFilter filter_;
+	std::shared_ptr<core::socket::DatagramSocket> socket_;
+	std::vector<core::socket::datagram_t> batch_;
+	size_t sent_packets_;
+	size_t sent_bytes_;
+	size_t failed_packets_;
 };
 
 } /* namespace pcap */
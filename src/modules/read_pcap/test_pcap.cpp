@@ -0,0 +1,292 @@
+/*!
+ * @file 		test_pcap.cpp
+ * @author 		agent <agent@local>
+ * @date 		19.10.2026
+ * @copyright	Institute of Intermedia, CTU in Prague, 2026
+ * 				Distributed under modified BSD Licence, details in file doc/LICENSE
+ *
+ */
+
+#include "tests/catch.hpp"
+#include "PcapReader.h"
+#include "yuri/exception/InitializationFailed.h"
+#include <cstdio>
+#include <fstream>
+#include <unistd.h>
+
+namespace yuri {
+namespace pcap {
+
+namespace {
+
+using bytes_t = std::vector<uint8_t>;
+
+void append16(bytes_t& data, uint16_t value)
+{
+	data.push_back(static_cast<uint8_t>(value >> 8));
+	data.push_back(static_cast<uint8_t>(value));
+}
+
+//! Writes a pcap file with records in little or big endian
+struct pcap_writer {
+	bytes_t data;
+	bool big_endian;
+
+	pcap_writer(uint32_t link_type, bool nanoseconds = false, bool big_endian = false):big_endian(big_endian)
+	{
+		append32(nanoseconds ? 0xa1b23c4d : 0xa1b2c3d4);
+		append32(0x00040002);
+		append32(0);
+		append32(0);
+		append32(65535);
+		append32(link_type);
+	}
+	void append32(uint32_t value)
+	{
+		for (int i = 0; i < 4; ++i) {
+			data.push_back(static_cast<uint8_t>(value >> (big_endian ? 24 - 8 * i : 8 * i)));
+		}
+	}
+	void record(uint32_t sec, uint32_t frac, const bytes_t& packet, size_t captured = 0)
+	{
+		if (!captured) captured = packet.size();
+		append32(sec);
+		append32(frac);
+		append32(static_cast<uint32_t>(captured));
+		append32(static_cast<uint32_t>(packet.size()));
+		data.insert(data.end(), packet.begin(), packet.begin() + captured);
+	}
+};
+
+struct temp_file {
+	std::string name;
+	temp_file(const bytes_t& data)
+	{
+		char tmpl[] = "/tmp/yuri_pcap_testXXXXXX";
+		const int fd = mkstemp(tmpl);
+		REQUIRE(fd >= 0);
+		::close(fd);
+		name = tmpl;
+		std::ofstream(name, std::ios::binary).write(reinterpret_cast<const char*>(data.data()), data.size());
+	}
+	~temp_file() { std::remove(name.c_str()); }
+};
+
+bytes_t ethernet(uint16_t ethertype, const bytes_t& payload, bool vlan = false)
+{
+	bytes_t data = {0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11};
+	if (vlan) {
+		append16(data, 0x8100);
+		append16(data, 42);
+	}
+	append16(data, ethertype);
+	data.insert(data.end(), payload.begin(), payload.end());
+	return data;
+}
+
+bytes_t transport(uint8_t protocol, uint16_t src_port, uint16_t dst_port, const bytes_t& payload)
+{
+	bytes_t data;
+	append16(data, src_port);
+	append16(data, dst_port);
+	if (protocol == ip_protocol::udp) {
+		append16(data, static_cast<uint16_t>(payload.size() + 8));
+		append16(data, 0);
+	} else {
+		data.insert(data.end(), {0, 0, 0, 1, 0, 0, 0, 0, 0x50, 0x18, 0xFF, 0xFF, 0, 0, 0, 0});
+	}
+	data.insert(data.end(), payload.begin(), payload.end());
+	return data;
+}
+
+bytes_t ipv4(uint8_t protocol, const bytes_t& payload, uint8_t src = 1, uint16_t fragment = 0)
+{
+	bytes_t data = {0x45, 0};
+	append16(data, static_cast<uint16_t>(payload.size() + 20));
+	append16(data, 0);
+	append16(data, fragment);
+	data.insert(data.end(), {64, protocol, 0, 0, 10, 0, 0, src, 10, 0, 0, 2});
+	data.insert(data.end(), payload.begin(), payload.end());
+	return data;
+}
+
+bytes_t ipv6(uint8_t protocol, const bytes_t& payload)
+{
+	// With hop by hop options extension header
+	bytes_t data = {0x60, 0, 0, 0};
+	append16(data, static_cast<uint16_t>(payload.size() + 8));
+	data.insert(data.end(), {0, 64});
+	data.insert(data.end(), 15, 0);
+	data.push_back(1);
+	data.insert(data.end(), 15, 0);
+	data.push_back(2);
+	data.insert(data.end(), {protocol, 0, 1, 4, 0, 0, 0, 0});
+	data.insert(data.end(), payload.begin(), payload.end());
+	return data;
+}
+
+bytes_t payload(size_t size, uint8_t seed)
+{
+	bytes_t data(size);
+	for (size_t i = 0; i < size; ++i) data[i] = static_cast<uint8_t>(seed + i);
+	return data;
+}
+
+std::vector<pcap_packet_t> read_all(PcapReader& reader, const PcapFilter& filter = PcapFilter())
+{
+	std::vector<pcap_packet_t> packets;
+	pcap_packet_t packet;
+	while (reader.next(packet)) {
+		if (filter.match(packet)) packets.push_back(packet);
+	}
+	return packets;
+}
+
+bytes_t data_of(const pcap_packet_t& packet)
+{
+	return {packet.payload, packet.payload + packet.size};
+}
+
+//! Capture with various packets, the supported ones are UDP A (port 5004), B (port 6000), C (IPv6, port 5004) and TCP D (port 80)
+bytes_t make_capture()
+{
+	pcap_writer w(1);
+	w.record(10, 0, ethernet(0x0800, ipv4(ip_protocol::udp, transport(ip_protocol::udp, 1000, 5004, payload(100, 1)))));
+	w.record(10, 500, ethernet(0x0806, payload(28, 0)));
+	w.record(10, 1000, ethernet(0x0800, ipv4(ip_protocol::udp, transport(ip_protocol::udp, 1001, 6000, payload(1400, 2)), 3), true));
+	w.record(10, 2000, ethernet(0x0800, ipv4(ip_protocol::udp, transport(ip_protocol::udp, 1000, 5004, payload(1000, 0)), 1, 0x2000)));
+	w.record(10, 3000, ethernet(0x86DD, ipv6(ip_protocol::udp, transport(ip_protocol::udp, 1002, 5004, payload(50, 3)))));
+	w.record(10, 4000, ethernet(0x0800, ipv4(1, payload(64, 0))));
+	w.record(11, 0, ethernet(0x0800, ipv4(ip_protocol::tcp, transport(ip_protocol::tcp, 80, 40000, payload(500, 4)))));
+	// Packet truncated by snaplen
+	w.record(11, 1000, ethernet(0x0800, ipv4(ip_protocol::udp, transport(ip_protocol::udp, 1000, 5004, payload(1000, 0)))), 200);
+	return w.data;
+}
+}
+
+TEST_CASE("pcap reader", "[read_pcap]")
+{
+	temp_file file(make_capture());
+	PcapReader reader(file.name);
+	REQUIRE(reader.get_link_type() == 1);
+
+	auto packets = read_all(reader);
+	REQUIRE(packets.size() == 4);
+	REQUIRE(data_of(packets[0]) == payload(100, 1));
+	REQUIRE(packets[0].protocol == ip_protocol::udp);
+	REQUIRE(packets[0].src_port == 1000);
+	REQUIRE(packets[0].dst_port == 5004);
+	REQUIRE(packets[0].timestamp == 10_s);
+	ip_address_t address;
+	REQUIRE(parse_ip_address("10.0.0.1", address));
+	REQUIRE(packets[0].src == address);
+	REQUIRE(parse_ip_address("10.0.0.2", address));
+	REQUIRE(packets[0].dst == address);
+
+	REQUIRE(data_of(packets[1]) == payload(1400, 2));
+	REQUIRE(packets[1].timestamp == 10_s + 1_ms);
+
+	REQUIRE(data_of(packets[2]) == payload(50, 3));
+	REQUIRE(parse_ip_address("::1", address));
+	REQUIRE(packets[2].src == address);
+	REQUIRE(packets[2].dst_port == 5004);
+
+	REQUIRE(data_of(packets[3]) == payload(500, 4));
+	REQUIRE(packets[3].protocol == ip_protocol::tcp);
+	REQUIRE(packets[3].src_port == 80);
+
+	const auto& stats = reader.get_stats();
+	REQUIRE(stats.records == 8);
+	REQUIRE(stats.packets == 4);
+	REQUIRE(stats.non_ip == 1);
+	REQUIRE(stats.unsupported == 2);
+	REQUIRE(stats.truncated == 1);
+
+	// Packets stay valid in the mapping after rewind
+	reader.rewind();
+	REQUIRE(read_all(reader).size() == 4);
+	REQUIRE(data_of(packets[0]) == payload(100, 1));
+}
+
+TEST_CASE("pcap filter", "[read_pcap]")
+{
+	temp_file file(make_capture());
+	PcapReader reader(file.name);
+	auto count = [&reader](const std::string& expression) {
+		reader.rewind();
+		return read_all(reader, PcapFilter(expression)).size();
+	};
+	REQUIRE(count("") == 4);
+	REQUIRE(count("udp") == 3);
+	REQUIRE(count("not udp") == 1);
+	REQUIRE(count("tcp and port 80") == 1);
+	REQUIRE(count("udp and dst port 5004") == 2);
+	REQUIRE(count("src port 5004") == 0);
+	REQUIRE(count("portrange 5000-6000") == 3);
+	REQUIRE(count("dst portrange 5000-5999 and not host ::1") == 1);
+	REQUIRE(count("host 10.0.0.3") == 1);
+	REQUIRE(count("src host 10.0.0.2") == 0);
+	REQUIRE(count("udp && ! dst port 6000") == 2);
+
+	REQUIRE_THROWS_AS(PcapFilter("udp or tcp"), exception::InitializationFailed);
+	REQUIRE_THROWS_AS(PcapFilter("port"), exception::InitializationFailed);
+	REQUIRE_THROWS_AS(PcapFilter("port 70000"), exception::InitializationFailed);
+	REQUIRE_THROWS_AS(PcapFilter("host 10.0.0"), exception::InitializationFailed);
+	REQUIRE_THROWS_AS(PcapFilter("src udp"), exception::InitializationFailed);
+	REQUIRE_THROWS_AS(PcapFilter("icmp"), exception::InitializationFailed);
+}
+
+TEST_CASE("pcap formats", "[read_pcap]")
+{
+	SECTION("big endian with nanoseconds and raw IP")
+	{
+		pcap_writer w(101, true, true);
+		w.record(5, 1500000, ipv4(ip_protocol::udp, transport(ip_protocol::udp, 1, 2, payload(10, 0))));
+		w.record(5, 2500000, ipv6(ip_protocol::udp, transport(ip_protocol::udp, 1, 2, payload(20, 0))));
+		temp_file file(w.data);
+		PcapReader reader(file.name);
+		const auto packets = read_all(reader);
+		REQUIRE(packets.size() == 2);
+		REQUIRE(packets[0].timestamp == 5_s + 1500_us);
+		REQUIRE(packets[1].timestamp == 5_s + 2500_us);
+		REQUIRE(packets[1].size == 20);
+	}
+	SECTION("linux cooked capture")
+	{
+		pcap_writer w(113);
+		bytes_t sll(14, 0);
+		append16(sll, 0x0800);
+		const auto ip = ipv4(ip_protocol::udp, transport(ip_protocol::udp, 1, 2, payload(10, 0)));
+		sll.insert(sll.end(), ip.begin(), ip.end());
+		w.record(1, 0, sll);
+		temp_file file(w.data);
+		PcapReader reader(file.name);
+		REQUIRE(read_all(reader).size() == 1);
+	}
+	SECTION("incomplete last record")
+	{
+		pcap_writer w(1);
+		w.record(1, 0, ethernet(0x0800, ipv4(ip_protocol::udp, transport(ip_protocol::udp, 1, 2, payload(10, 0)))));
+		w.data.resize(w.data.size() - 5);
+		temp_file file(w.data);
+		PcapReader reader(file.name);
+		REQUIRE(read_all(reader).empty());
+		REQUIRE(reader.get_stats().truncated == 1);
+	}
+	SECTION("invalid files")
+	{
+		REQUIRE_THROWS_AS(PcapReader("/nonexistent/file.pcap"), exception::InitializationFailed);
+		temp_file text({'n', 'o', 't', ' ', 'a', ' ', 'p', 'c', 'a', 'p', ' ', 'f', 'i', 'l', 'e', ' ', 'a', 't', ' ', 'a', 'l', 'l', '!', '!', '!'});
+		REQUIRE_THROWS_AS(PcapReader(text.name), exception::InitializationFailed);
+		pcap_writer w(1);
+		w.data[0] = 0x0a; w.data[1] = 0x0d; w.data[2] = 0x0d; w.data[3] = 0x0a;
+		temp_file pcapng(w.data);
+		REQUIRE_THROWS_AS(PcapReader(pcapng.name), exception::InitializationFailed);
+		pcap_writer usb(189);
+		temp_file unsupported(usb.data);
+		REQUIRE_THROWS_AS(PcapReader(unsupported.name), exception::InitializationFailed);
+	}
+}
+
+}
+}
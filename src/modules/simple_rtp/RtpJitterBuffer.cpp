@@ -0,0 +1,409 @@
+/*!
+ * @file 		RtpJitterBuffer.cpp
+ * @author 		agent <agent@local>
+ * @date 		18.10.2026
+ * @copyright	Institute of Intermedia, CTU in Prague, 2026
+ * 				Distributed under modified BSD Licence, details in file doc/LICENSE
+ *
+ */
+
+#include "RtpJitterBuffer.h"
+#include "yuri/core/frame/compressed_frame_types.h"
+#include <algorithm>
+#include <cstring>
+
+namespace yuri {
+namespace simple_rtp {
+
+namespace {
+const uint8_t start_code[] = { 0, 0, 0, 1 };
+//! Consecutive late packets meaning the sequence numbers were restarted
+const size_t resync_late_packets = 16;
+
+uint16_t read_be16(const uint8_t* data)
+{
+    return static_cast<uint16_t>((data[0] << 8) | data[1]);
+}
+
+uint32_t read_be32(const uint8_t* data)
+{
+    return (static_cast<uint32_t>(data[0]) << 24) | (static_cast<uint32_t>(data[1]) << 16) | (static_cast<uint32_t>(data[2]) << 8)
+         | static_cast<uint32_t>(data[3]);
+}
+
+/*!
+ * Writes data to the output, or just counts them if there's no output.
+ * Partial NAL units may temporarily overrun the output before they're removed,
+ * so only data fitting into @em capacity are written.
+ */
+class frame_writer {
+public:
+    frame_writer(uint8_t* dest, size_t capacity) : dest_(dest), capacity_(capacity), offset_(0), nal_start_(0), in_fu_(false) {}
+
+    void write(const uint8_t* data, size_t size)
+    {
+        if (dest_ && offset_ < capacity_)
+            std::memcpy(dest_ + offset_, data, std::min(size, capacity_ - offset_));
+        offset_ += size;
+    }
+    void write(uint8_t value) { write(&value, 1); }
+
+    void single_nal(const uint8_t* nal, size_t size)
+    {
+        abort_fu();
+        write(start_code, sizeof(start_code));
+        write(nal, size);
+    }
+    //! Writes NAL units from an aggregation packet (STAP-A or AP) with 16bit sizes
+    void aggregated(const uint8_t* data, size_t size)
+    {
+        abort_fu();
+        for (size_t i = 0; i + 2 < size;) {
+            const size_t nal_size = read_be16(data + i);
+            i += 2;
+            if (!nal_size || i + nal_size > size)
+                break;
+            single_nal(data + i, nal_size);
+            i += nal_size;
+        }
+    }
+    void fu_start()
+    {
+        abort_fu();
+        nal_start_ = offset_;
+        in_fu_     = true;
+        write(start_code, sizeof(start_code));
+    }
+    void fu_end() { in_fu_ = false; }
+    bool in_fu() const { return in_fu_; }
+    //! Removes partially written NAL unit
+    void abort_fu()
+    {
+        if (in_fu_)
+            offset_ = nal_start_;
+        in_fu_ = false;
+    }
+    size_t size() const { return offset_; }
+
+private:
+    uint8_t* dest_;
+    size_t   capacity_;
+    size_t   offset_;
+    size_t   nal_start_;
+    bool     in_fu_;
+};
+}
+
+RtpJitterBuffer::RtpJitterBuffer(rtp_codec_t codec, size_t slots, size_t max_packet_size, duration_t latency, size_t batch)
+    : codec_(codec), max_packet_size_(max_packet_size), latency_(latency), batch_(batch), head_(0), highest_(0), started_(false),
+      ssrc_(0), late_run_(0)
+{
+    size_t ring_size = 1;
+    while (ring_size < slots && ring_size < 32768) {
+        ring_size <<= 1;
+    }
+    mask_ = static_cast<uint16_t>(ring_size - 1);
+    slots_.resize(ring_size);
+    // Every slot may hold a buffer, while another batch is being received
+    const auto buffers = ring_size + batch_;
+    storage_.resize(buffers * max_packet_size_);
+    free_buffers_.reserve(buffers);
+    pending_buffers_.reserve(batch_);
+    for (auto i = buffers; i > 0; --i) {
+        free_buffers_.push_back(static_cast<int32_t>(i - 1));
+    }
+}
+
+size_t RtpJitterBuffer::get_receive_buffers(core::socket::datagram_buffer_t* buffers, size_t max)
+{
+    for (auto b : pending_buffers_) {
+        free_buffers_.push_back(b);
+    }
+    pending_buffers_.clear();
+    const auto count = std::min({ max, batch_, free_buffers_.size() });
+    for (size_t i = 0; i < count; ++i) {
+        const auto b = free_buffers_.back();
+        free_buffers_.pop_back();
+        pending_buffers_.push_back(b);
+        buffers[i] = { buffer_data(b), max_packet_size_, 0 };
+    }
+    return count;
+}
+
+void RtpJitterBuffer::insert_received(const core::socket::datagram_buffer_t* buffers, size_t count, timestamp_t now)
+{
+    for (size_t i = 0; i < pending_buffers_.size(); ++i) {
+        if (i < count) {
+            insert_buffer(pending_buffers_[i], buffers[i].size, now);
+        } else {
+            free_buffers_.push_back(pending_buffers_[i]);
+        }
+    }
+    pending_buffers_.clear();
+}
+
+bool RtpJitterBuffer::insert(const uint8_t* data, size_t size, timestamp_t now)
+{
+    if (size > max_packet_size_ || free_buffers_.empty()) {
+        ++stats_.invalid;
+        return false;
+    }
+    const auto b = free_buffers_.back();
+    free_buffers_.pop_back();
+    std::copy(data, data + size, buffer_data(b));
+    return insert_buffer(b, size, now);
+}
+
+bool RtpJitterBuffer::insert_buffer(int32_t buffer, size_t size, timestamp_t now)
+{
+    const auto data = buffer_data(buffer);
+    auto       reject = [this, buffer](size_t& counter) {
+        ++counter;
+        free_buffers_.push_back(buffer);
+        return false;
+    };
+    // Datagrams filling whole buffer were probably truncated
+    if (size < RTPPacket::header_size || size >= max_packet_size_ || (data[0] >> 6) != 2)
+        return reject(stats_.invalid);
+    size_t offset = RTPPacket::header_size + 4 * (data[0] & 0x0F);
+    if (data[0] & 0x10) {
+        // Header extension
+        if (offset + 4 > size)
+            return reject(stats_.invalid);
+        offset += 4 + 4 * read_be16(data + offset + 2);
+    }
+    if (data[0] & 0x20) {
+        // Padding
+        const size_t padding = data[size - 1];
+        size                 = padding < size ? size - padding : 0;
+    }
+    if (offset >= size)
+        return reject(stats_.invalid);
+
+    const auto sequence = read_be16(data + 2);
+    const auto ssrc     = read_be32(data + 8);
+    if (started_) {
+        const auto behind = static_cast<uint16_t>(head_ - sequence);
+        const bool late   = static_cast<int16_t>(sequence - head_) < 0;
+        if (ssrc != ssrc_ || (late && (behind > mask_ || late_run_ + 1 >= resync_late_packets))) {
+            reset();
+            ++stats_.resyncs;
+        }
+    }
+    if (!started_) {
+        head_    = sequence;
+        highest_ = sequence;
+        ssrc_    = ssrc;
+        started_ = true;
+    }
+    if (static_cast<int16_t>(sequence - head_) < 0) {
+        ++late_run_;
+        return reject(stats_.late);
+    }
+    late_run_ = 0;
+    if (static_cast<uint16_t>(sequence - head_) > mask_) {
+        advance_head(static_cast<uint16_t>(sequence - mask_));
+    }
+    auto& s = slot(sequence);
+    if (s.buffer >= 0)
+        return reject(stats_.duplicates);
+    if (static_cast<int16_t>(sequence - highest_) < 0) {
+        ++stats_.reordered;
+    } else {
+        highest_ = sequence;
+    }
+    s.buffer         = buffer;
+    s.sequence       = sequence;
+    s.marker         = (data[1] & 0x80) != 0;
+    s.timestamp      = read_be32(data + 4);
+    s.payload_offset = offset;
+    s.payload_size   = size - offset;
+    s.arrival        = now;
+    ++stats_.received;
+    return true;
+}
+
+void RtpJitterBuffer::advance_head(uint16_t sequence)
+{
+    while (head_ != sequence) {
+        if (slot(head_).buffer >= 0) {
+            release(head_);
+        }
+        ++stats_.lost;
+        ++head_;
+    }
+}
+
+void RtpJitterBuffer::release(uint16_t sequence)
+{
+    auto& s = slot(sequence);
+    if (s.buffer >= 0) {
+        free_buffers_.push_back(s.buffer);
+        s.buffer = -1;
+    }
+}
+
+void RtpJitterBuffer::reset()
+{
+    for (auto& s : slots_) {
+        if (s.buffer >= 0) {
+            free_buffers_.push_back(s.buffer);
+            s.buffer = -1;
+        }
+    }
+    started_  = false;
+    late_run_ = 0;
+}
+
+bool RtpJitterBuffer::find_frame(frame_range_t& range) const
+{
+    if (!started_ || static_cast<int16_t>(highest_ - head_) < 0)
+        return false;
+    const size_t available = static_cast<uint16_t>(highest_ - head_) + 1;
+    size_t       i         = 0;
+    while (i < available && slot(head_ + i).buffer < 0) {
+        ++i;
+    }
+    if (i == available)
+        return false;
+
+    const auto& first = slot(head_ + i);
+    range.first       = head_;
+    range.count       = i + 1;
+    range.arrival     = first.arrival;
+    bool gap          = i > 0;
+    bool frame_end    = first.marker;
+    for (++i; i < available && !frame_end; ++i) {
+        const auto& s = slot(head_ + i);
+        if (s.buffer < 0) {
+            gap = true;
+            continue;
+        }
+        // Packet from next frame, so the marker got lost
+        if (s.timestamp != first.timestamp)
+            break;
+        range.count   = i + 1;
+        range.arrival = std::min(range.arrival, s.arrival);
+        frame_end     = s.marker;
+    }
+    range.complete = !gap && frame_end;
+    return true;
+}
+
+size_t RtpJitterBuffer::assemble(const frame_range_t& range, uint8_t* dest, size_t capacity) const
+{
+    frame_writer writer(dest, capacity);
+    for (size_t i = 0; i < range.count; ++i) {
+        const auto& s = slot(range.first + i);
+        if (s.buffer < 0) {
+            // Fragmented NAL unit can't be completed
+            writer.abort_fu();
+            continue;
+        }
+        const auto p    = buffer_data(s.buffer) + s.payload_offset;
+        const auto size = s.payload_size;
+        if (codec_ == rtp_codec_t::h264) {
+            const auto type = p[0] & 0x1F;
+            if (type > 0 && type < 24) {
+                writer.single_nal(p, size);
+            } else if (type == 24) {
+                // STAP-A
+                writer.aggregated(p + 1, size - 1);
+            } else if (type == 28 && size > 2) {
+                // FU-A
+                if (p[1] & 0x80) {
+                    writer.fu_start();
+                    writer.write(static_cast<uint8_t>((p[0] & 0xE0) | (p[1] & 0x1F)));
+                }
+                if (writer.in_fu()) {
+                    writer.write(p + 2, size - 2);
+                    if (p[1] & 0x40)
+                        writer.fu_end();
+                }
+            }
+        } else {
+            if (size < 2)
+                continue;
+            const auto type = (p[0] >> 1) & 0x3F;
+            if (type < 48) {
+                writer.single_nal(p, size);
+            } else if (type == 48) {
+                // Aggregation packet
+                writer.aggregated(p + 2, size - 2);
+            } else if (type == 49 && size > 3) {
+                // Fragmentation unit
+                if (p[2] & 0x80) {
+                    writer.fu_start();
+                    writer.write(static_cast<uint8_t>((p[0] & 0x81) | ((p[2] & 0x3F) << 1)));
+                    writer.write(p[1]);
+                }
+                if (writer.in_fu()) {
+                    writer.write(p + 3, size - 3);
+                    if (p[2] & 0x40)
+                        writer.fu_end();
+                }
+            }
+        }
+    }
+    writer.abort_fu();
+    return writer.size();
+}
+
+core::pCompressedVideoFrame RtpJitterBuffer::output_frame(const frame_range_t& range)
+{
+    core::pCompressedVideoFrame frame;
+    if (const auto size = assemble(range, nullptr, 0)) {
+        frame = core::CompressedVideoFrame::create_empty(
+            codec_ == rtp_codec_t::h264 ? core::compressed_frame::h264 : core::compressed_frame::h265, resolution_t{ 0, 0 }, size);
+        assemble(range, &(*frame->data()), size);
+    }
+    for (size_t i = 0; i < range.count; ++i) {
+        const uint16_t sequence = range.first + i;
+        if (slot(sequence).buffer < 0) {
+            ++stats_.lost;
+        } else {
+            release(sequence);
+        }
+    }
+    head_ = static_cast<uint16_t>(range.first + range.count);
+    ++stats_.frames;
+    if (!range.complete)
+        ++stats_.incomplete;
+    return frame;
+}
+
+core::pCompressedVideoFrame RtpJitterBuffer::pop_frame(timestamp_t now)
+{
+    frame_range_t range;
+    while (find_frame(range)) {
+        // Don't wait for missing packets when the ring is getting full
+        const bool full = static_cast<uint16_t>(highest_ - head_) >= mask_ - mask_ / 4;
+        if (!range.complete && !full && now - range.arrival < latency_)
+            return {};
+        if (auto frame = output_frame(range))
+            return frame;
+    }
+    return {};
+}
+
+core::pCompressedVideoFrame RtpJitterBuffer::flush()
+{
+    frame_range_t range;
+    while (find_frame(range)) {
+        if (auto frame = output_frame(range))
+            return frame;
+    }
+    return {};
+}
+
+void RtpJitterBuffer::get_missing(std::vector<uint16_t>& missing) const
+{
+    if (!started_ || static_cast<int16_t>(highest_ - head_) < 0)
+        return;
+    for (uint16_t sequence = head_; sequence != highest_; ++sequence) {
+        if (slot(sequence).buffer < 0)
+            missing.push_back(sequence);
+    }
+}
+}
+}
@@ -0,0 +1,147 @@
+/*!
+ * @file 		RtpJitterBuffer.h
+ * @author 		agent <agent@local>
+ * @date 		18.10.2026
+ * @copyright	Institute of Intermedia, CTU in Prague, 2026
+ * 				Distributed under modified BSD Licence, details in file doc/LICENSE
+ *
+ */
+
+#ifndef SRC_MODULES_SIMPLE_RTP_RTPJITTERBUFFER_H_
+#define SRC_MODULES_SIMPLE_RTP_RTPJITTERBUFFER_H_
+
+#include "RtpPacketizer.h"
+#include "yuri/core/frame/CompressedVideoFrame.h"
+#include "yuri/core/utils/time_types.h"
+
+namespace yuri {
+namespace simple_rtp {
+
+struct jitter_stats_t {
+    //! Packets accepted into the buffer
+    size_t received     = 0;
+    //! Packets that were missing when their frame was output, or dropped when the ring overflowed
+    size_t lost         = 0;
+    //! Packets that arrived after a packet with higher sequence number
+    size_t reordered    = 0;
+    //! Packets that arrived after their frame was already output
+    size_t late         = 0;
+    size_t duplicates   = 0;
+    //! Packets that were not valid RTP or didn't fit into a slot
+    size_t invalid      = 0;
+    size_t frames       = 0;
+    //! Frames output with some packets missing
+    size_t incomplete   = 0;
+    //! Times the buffer was reset because the stream was restarted
+    size_t resyncs      = 0;
+};
+
+/*!
+ * Reorders received H.264/H.265 RTP packets and assembles them into frames.
+ *
+ * Packets are stored in a ring of slots indexed by their sequence number.
+ * The slots use buffers from a fixed slab, so sockets can receive directly
+ * into them and no memory is allocated after construction.
+ * A frame is output once all its packets arrived, or after @em latency from
+ * arrival of its first packet. NAL units with missing fragments are left out
+ * from incomplete frames.
+ *
+ * The buffer is reset when the SSRC changes, when a packet arrives too far behind
+ * the already output ones, or after a run of late packets, as the sender was
+ * most likely restarted with new sequence numbers.
+ */
+class RtpJitterBuffer {
+public:
+    /*!
+     * @param slots				Number of packets in the ring, rounded up to a power of 2 (at most 32768)
+     * @param max_packet_size	Maximal size of a packet (including RTP header)
+     * @param latency			Maximal time to wait for missing packets
+     * @param batch				Maximal number of buffers returned by get_receive_buffers()
+     */
+    RtpJitterBuffer(rtp_codec_t codec, size_t slots, size_t max_packet_size, duration_t latency, size_t batch = 16);
+
+    /*!
+     * Returns up to @em max free buffers to receive packets into.
+     * The buffers have to be passed to insert_received() before next call.
+     */
+    size_t get_receive_buffers(core::socket::datagram_buffer_t* buffers, size_t max);
+    //! Inserts first @em count buffers filled by the socket, releases the rest
+    void insert_received(const core::socket::datagram_buffer_t* buffers, size_t count, timestamp_t now = timestamp_t{});
+    //! Copies a packet into the buffer. Returns false if the packet was rejected.
+    bool insert(const uint8_t* data, size_t size, timestamp_t now = timestamp_t{});
+
+    /*!
+     * Returns next frame if it's complete or its latency expired.
+     * @return assembled frame or nullptr if there's no frame ready
+     */
+    core::pCompressedVideoFrame pop_frame(timestamp_t now = timestamp_t{});
+    //! Returns next frame without waiting for missing packets, nullptr if there are no more packets
+    core::pCompressedVideoFrame flush();
+
+    /*!
+     * Appends sequence numbers of packets currently missing in the buffer to @em missing,
+     * usable to request retransmission (e.g. by RTCP NACK)
+     */
+    void get_missing(std::vector<uint16_t>& missing) const;
+
+    const jitter_stats_t& get_stats() const { return stats_; }
+    void                  reset_stats() { stats_ = jitter_stats_t{}; }
+    void                  set_latency(duration_t latency) { latency_ = latency; }
+
+private:
+    struct slot_t {
+        //! Index of the buffer in the slab, -1 for an empty slot
+        int32_t     buffer = -1;
+        uint16_t    sequence;
+        bool        marker;
+        uint32_t    timestamp;
+        size_t      payload_offset;
+        size_t      payload_size;
+        timestamp_t arrival;
+    };
+    //! Range of sequence numbers forming next frame
+    struct frame_range_t {
+        uint16_t    first;
+        size_t      count;
+        bool        complete;
+        timestamp_t arrival;
+    };
+
+    bool     insert_buffer(int32_t buffer, size_t size, timestamp_t now);
+    bool     find_frame(frame_range_t& range) const;
+    //! Depacketizes frame to @em dest (or just computes its size if @em dest is nullptr)
+    size_t   assemble(const frame_range_t& range, uint8_t* dest, size_t capacity) const;
+    core::pCompressedVideoFrame output_frame(const frame_range_t& range);
+    void     release(uint16_t sequence);
+    //! Drops all packets and starts again from the next received one
+    void     reset();
+    //! Drops packets to make space for @em sequence
+    void     advance_head(uint16_t sequence);
+    slot_t&       slot(uint16_t sequence) { return slots_[sequence & mask_]; }
+    const slot_t& slot(uint16_t sequence) const { return slots_[sequence & mask_]; }
+    uint8_t*      buffer_data(int32_t buffer) { return storage_.data() + buffer * max_packet_size_; }
+    const uint8_t* buffer_data(int32_t buffer) const { return storage_.data() + buffer * max_packet_size_; }
+
+    rtp_codec_t          codec_;
+    size_t               max_packet_size_;
+    duration_t           latency_;
+    size_t               batch_;
+    uint16_t             mask_;
+    std::vector<slot_t>  slots_;
+    std::vector<uint8_t> storage_;
+    std::vector<int32_t> free_buffers_;
+    std::vector<int32_t> pending_buffers_;
+    //! First sequence number that wasn't output yet
+    uint16_t             head_;
+    //! Highest sequence number received
+    uint16_t             highest_;
+    bool                 started_;
+    uint32_t             ssrc_;
+    //! Number of late packets received since the last accepted one
+    size_t               late_run_;
+    jitter_stats_t       stats_;
+};
+}
+}
+
+#endif /* SRC_MODULES_SIMPLE_RTP_RTPJITTERBUFFER_H_ */
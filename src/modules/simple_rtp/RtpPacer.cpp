@@ -0,0 +1,145 @@
+/*!
+ * @file 		RtpPacer.cpp
+ * @author 		agent <agent@local>
+ * @date 		18.10.2026
+ * @copyright	Institute of Intermedia, CTU in Prague, 2026
+ * 				Distributed under modified BSD Licence, details in file doc/LICENSE
+ *
+ */
+
+#include "RtpPacer.h"
+#include "yuri/core/thread/ThreadBase.h"
+#include <algorithm>
+#include <cmath>
+
+namespace yuri {
+namespace simple_rtp {
+
+namespace {
+size_t datagram_size(const core::socket::datagram_parts_t& datagram)
+{
+    size_t size = 0;
+    for (size_t i = 0; i < datagram.count; ++i) {
+        size += datagram.parts[i].size;
+    }
+    return size;
+}
+
+duration_t to_duration(double seconds)
+{
+    return duration_t{ static_cast<int64_t>(std::llround(seconds * 1e6)) };
+}
+}
+
+TokenBucket::TokenBucket(double rate, size_t depth, timestamp_t now)
+    : rate_(rate), depth_(depth), tokens_(static_cast<double>(depth)), last_update_(now)
+{
+}
+
+void TokenBucket::set_rate(double rate, timestamp_t now)
+{
+    refill(now);
+    rate_ = rate;
+}
+
+duration_t TokenBucket::get_delay(size_t size, timestamp_t now)
+{
+    if (rate_ <= 0.0)
+        return 0_us;
+    refill(now);
+    // Packets larger than the bucket are sent once the bucket is full
+    const auto needed = static_cast<double>(std::min(size, depth_));
+    if (tokens_ >= needed)
+        return 0_us;
+    return std::max(to_duration((needed - tokens_) / rate_), 1_us);
+}
+
+void TokenBucket::consume(size_t size)
+{
+    tokens_ -= static_cast<double>(size);
+}
+
+void TokenBucket::refill(timestamp_t now)
+{
+    if (now > last_update_) {
+        tokens_      = std::min(static_cast<double>(depth_), tokens_ + rate_ * (now - last_update_).value * 1e-6);
+        last_update_ = now;
+    }
+}
+
+RtpPacer::RtpPacer(double max_bitrate, double spread, size_t burst)
+    : max_rate_(max_bitrate / 8.0), spread_(spread), burst_(burst), bucket_(0.0, burst)
+{
+}
+
+size_t RtpPacer::send(core::socket::DatagramSocket& socket, const core::socket::datagram_parts_t* datagrams, size_t count, duration_t interval)
+{
+    if (!count)
+        return 0;
+    size_t total = 0;
+    for (size_t i = 0; i < count; ++i) {
+        total += datagram_size(datagrams[i]);
+    }
+    double rate = 0.0;
+    if (interval > 0_us && spread_ > 0.0) {
+        rate = total / (interval.value * 1e-6 * spread_);
+    }
+    if (max_rate_ > 0.0 && (rate <= 0.0 || rate > max_rate_)) {
+        rate = max_rate_;
+    }
+    const timestamp_t start;
+    bucket_.set_rate(rate, start);
+
+    size_t sent       = 0;
+    size_t sent_bytes = 0;
+    int    attempts   = 0;
+    while (sent < count) {
+        const timestamp_t now;
+        const auto        delay = bucket_.get_delay(datagram_size(datagrams[sent]), now);
+        if (delay > 0_us) {
+            core::ThreadBase::sleep(delay);
+            continue;
+        }
+        // Send all datagrams the bucket allows at once
+        size_t batch = 0;
+        size_t bytes = 0;
+        while (sent + batch < count) {
+            const auto size = datagram_size(datagrams[sent + batch]);
+            if (batch && bucket_.get_delay(size, now) > 0_us)
+                break;
+            bucket_.consume(size);
+            if (rate > 0.0) {
+                // Compare with the time the datagram should have been sent at the planned rate
+                const auto lateness = now - (start + to_duration((sent_bytes + bytes) / rate));
+                if (lateness > 0_us) {
+                    ++stats_.late_packets;
+                    stats_.total_lateness += lateness;
+                    stats_.max_lateness = std::max(stats_.max_lateness, lateness);
+                }
+            }
+            bytes += size;
+            ++batch;
+        }
+        const auto batch_sent = socket.send_datagrams(datagrams + sent, batch);
+        for (size_t i = 0; i < batch_sent; ++i) {
+            sent_bytes += datagram_size(datagrams[sent + i]);
+        }
+        sent += batch_sent;
+        if (batch_sent) {
+            attempts = 0;
+        } else if (++attempts >= 5) {
+            break;
+        }
+    }
+    const auto elapsed = timestamp_t{} - start;
+    ++stats_.frames;
+    stats_.packets += sent;
+    stats_.bytes += sent_bytes;
+    stats_.send_time += elapsed;
+    if (interval > 0_us && elapsed > interval) {
+        ++stats_.overruns;
+    }
+    return sent;
+}
+}
+}
@@ -0,0 +1,97 @@
+/*!
+ * @file 		RtpPacer.h
+ * @author 		agent <agent@local>
+ * @date 		18.10.2026
+ * @copyright	Institute of Intermedia, CTU in Prague, 2026
+ * 				Distributed under modified BSD Licence, details in file doc/LICENSE
+ *
+ */
+
+#ifndef SRC_MODULES_SIMPLE_RTP_RTPPACER_H_
+#define SRC_MODULES_SIMPLE_RTP_RTPPACER_H_
+
+#include "yuri/core/socket/DatagramSocket.h"
+#include "yuri/core/utils/time_types.h"
+
+namespace yuri {
+namespace simple_rtp {
+
+/*!
+ * Token bucket limiting the rate of sent data.
+ *
+ * Tokens (bytes) are added at @em rate per second, up to @em depth bytes.
+ */
+class TokenBucket {
+public:
+    TokenBucket(double rate, size_t depth, timestamp_t now = timestamp_t{});
+
+    //! Sets rate in bytes per second. Rate of 0 means unlimited.
+    void   set_rate(double rate, timestamp_t now = timestamp_t{});
+    double get_rate() const { return rate_; }
+    void   set_depth(size_t depth) { depth_ = depth; }
+
+    //! Returns time remaining until @em size bytes can be sent, 0 if they can be sent right now.
+    duration_t get_delay(size_t size, timestamp_t now = timestamp_t{});
+    //! Removes @em size bytes from the bucket. The bucket may go negative.
+    void consume(size_t size);
+
+private:
+    void refill(timestamp_t now);
+
+    double      rate_;
+    size_t      depth_;
+    double      tokens_;
+    timestamp_t last_update_;
+};
+
+struct pacer_stats_t {
+    size_t     frames         = 0;
+    size_t     packets        = 0;
+    size_t     bytes          = 0;
+    //! Packets sent later than planned and sum and maximum of the delays
+    size_t     late_packets   = 0;
+    duration_t total_lateness = 0_us;
+    duration_t max_lateness   = 0_us;
+    //! Frames that took longer to send than their interval
+    size_t     overruns       = 0;
+    //! Time spent sending the frames
+    duration_t send_time      = 0_us;
+};
+
+/*!
+ * Sends packets of a frame spread over the frame interval.
+ *
+ * The packets are sent at a rate that sends the whole frame in @em spread
+ * portion of the frame interval, but never faster than @em max_bitrate.
+ * Up to @em burst bytes may be sent at once.
+ */
+class RtpPacer {
+public:
+    /*!
+     * @param max_bitrate	Maximal bitrate in bits per second, 0 for unlimited
+     * @param spread		Portion of frame interval used to send the frame (0 - 1)
+     * @param burst			Maximal number of bytes sent at once
+     */
+    RtpPacer(double max_bitrate, double spread, size_t burst);
+
+    /*!
+     * Sends the datagrams of a frame. Blocks until all datagrams are sent.
+     * @param interval	Frame interval, 0 if not known. The datagrams are sent at maximal bitrate then.
+     * @return number of datagrams sent
+     */
+    size_t send(core::socket::DatagramSocket& socket, const core::socket::datagram_parts_t* datagrams, size_t count, duration_t interval);
+
+    const pacer_stats_t& get_stats() const { return stats_; }
+    void                 reset_stats() { stats_ = pacer_stats_t{}; }
+
+private:
+    double        max_rate_;
+    double        spread_;
+    size_t        burst_;
+    TokenBucket   bucket_;
+    pacer_stats_t stats_;
+};
+}
+}
+
+#endif /* SRC_MODULES_SIMPLE_RTP_RTPPACER_H_ */
@@ -0,0 +1,152 @@
+/*!
+ * @file 		RtpPacketizer.cpp
+ * @author 		agent <agent@local>
+ * @date 		18.10.2026
+ * @copyright	Institute of Intermedia, CTU in Prague, 2026
+ * 				Distributed under modified BSD Licence, details in file doc/LICENSE
+ *
+ */
+
+#include "RtpPacketizer.h"
+#include <algorithm>
+
+namespace yuri {
+namespace simple_rtp {
+
+namespace {
+
+struct data_view {
+    const uint8_t* ptr;
+    size_t         size;
+    size_t         remaining;
+};
+
+/*!
+ * Verifies that data have a valid start prefix
+ * @param data Input data
+ * @return size of the prefix
+ */
+size_t is_start_prefix(const data_view& data)
+{
+    if (data.size < 4)
+        return 0;
+    if (data.ptr[0] == 0 && data.ptr[1] == 0) {
+        if (data.ptr[2] == 1 && ((data.ptr[3] & 0x80) == 0)) {
+            return 3;
+        }
+        if (data.size > 4 && data.ptr[2] == 0 && data.ptr[3] == 1 && ((data.ptr[4] & 0x80) == 0)) {
+            return 4;
+        }
+    }
+    return 0;
+}
+
+/*!
+ * Returns a NAL unit with length and remaining data
+ * @param data - input data_view
+ * @param avc_size size of AVC length prefix. set to 0 to use start codes.
+ */
+data_view find_nal(data_view data, size_t avc_size)
+{
+    if (avc_size < 1) {
+        auto prefix_len = is_start_prefix(data);
+        if (!prefix_len)
+            return { nullptr, 0, 0 };
+        for (auto i = prefix_len; i < data.size; ++i) {
+            // Start code can't start with anything but zero byte
+            if (data.ptr[i] == 0 && is_start_prefix({ data.ptr + i, data.size - i, data.remaining })) {
+                return { data.ptr + prefix_len, i - prefix_len, data.size - i };
+            }
+        }
+        return { data.ptr + prefix_len, data.size - prefix_len, 0 };
+    }
+    if (data.size < avc_size)
+        return { nullptr, 0, 0 };
+    size_t len = 0;
+    while (avc_size-- > 0) {
+        len = (len << 8) | (*data.ptr++ & 0xFF);
+        --data.size;
+    }
+    const auto nal_size = std::min(data.size, len);
+    return { data.ptr, nal_size, data.size - nal_size };
+}
+}
+
+RtpPacketizer::RtpPacketizer(rtp_codec_t codec, size_t max_packet_size, uint8_t payload_type, uint32_t ssrc, uint16_t sequence)
+    : codec_(codec), max_packet_size_(max_packet_size), payload_type_(payload_type), ssrc_(ssrc), sequence_(sequence)
+{
+}
+
+size_t RtpPacketizer::packetize(const uint8_t* data, size_t size, size_t avc_size, uint32_t timestamp)
+{
+    packets_.clear();
+    data_view dv = { data, size, 0 };
+    auto      d  = find_nal(dv, avc_size);
+    while (d.size > 0) {
+        add_nal(d.ptr, d.size, timestamp);
+        dv = { d.ptr + d.size, d.remaining, 0 };
+        d  = find_nal(dv, avc_size);
+    }
+    if (!packets_.empty()) {
+        packets_.back().header[1] |= 0x80;
+    }
+
+    // Every datagram consists of the header stored in the packet and a payload in the frame
+    parts_.resize(packets_.size() * 2);
+    datagrams_.resize(packets_.size());
+    for (size_t i = 0; i < packets_.size(); ++i) {
+        parts_[2 * i]     = { packets_[i].header.data(), packets_[i].header_size };
+        parts_[2 * i + 1] = { packets_[i].payload, packets_[i].payload_size };
+        datagrams_[i]     = { &parts_[2 * i], 2 };
+    }
+    return packets_.size();
+}
+
+rtp_packet_ref_t& RtpPacketizer::add_packet(uint32_t timestamp)
+{
+    packets_.emplace_back();
+    auto& packet = packets_.back();
+    write_rtp_header(packet.header.data(), payload_type_, sequence_++, timestamp, ssrc_);
+    packet.header_size = RTPPacket::header_size;
+    return packet;
+}
+
+void RtpPacketizer::add_nal(const uint8_t* nal, size_t size, uint32_t timestamp)
+{
+    const size_t nal_header_size = codec_ == rtp_codec_t::h264 ? 1 : 2;
+    const size_t fu_header_size  = nal_header_size + 1;
+    if (size + RTPPacket::header_size <= max_packet_size_ || size <= nal_header_size
+        || max_packet_size_ <= RTPPacket::header_size + fu_header_size) {
+        // Single NAL unit packet
+        auto& packet        = add_packet(timestamp);
+        packet.payload      = nal;
+        packet.payload_size = size;
+        return;
+    }
+    // Fragmentation units
+    const size_t max_payload = max_packet_size_ - RTPPacket::header_size - fu_header_size;
+    uint8_t      fu_indicator[2];
+    uint8_t      fu_header;
+    if (codec_ == rtp_codec_t::h264) {
+        fu_indicator[0] = (nal[0] & 0xE0) | 28; // Type 28 (FU-A), F and NRI copied from the NAL
+        fu_header       = nal[0] & 0x1F;
+    } else {
+        fu_indicator[0] = (nal[0] & 0x81) | (49 << 1); // Type 49 (FU), F and layer id copied from the NAL
+        fu_indicator[1] = nal[1];
+        fu_header       = (nal[0] >> 1) & 0x3F;
+    }
+    for (size_t offset = nal_header_size; offset < size;) {
+        const auto payload_size = std::min(max_payload, size - offset);
+        auto&      packet       = add_packet(timestamp);
+        auto       header       = packet.header.data() + RTPPacket::header_size;
+        std::copy(fu_indicator, fu_indicator + nal_header_size, header);
+        header[nal_header_size] = fu_header | (offset == nal_header_size ? 0x80 : 0x00) // S bit
+                                | (offset + payload_size == size ? 0x40 : 0x00);        // E bit
+        packet.header_size += fu_header_size;
+        packet.payload      = nal + offset;
+        packet.payload_size = payload_size;
+        offset += payload_size;
+    }
+}
+}
+}
@@ -0,0 +1,82 @@
+/*!
+ * @file 		RtpPacketizer.h
+ * @author 		agent <agent@local>
+ * @date 		18.10.2026
+ * @copyright	Institute of Intermedia, CTU in Prague, 2026
+ * 				Distributed under modified BSD Licence, details in file doc/LICENSE
+ *
+ */
+
+#ifndef SRC_MODULES_SIMPLE_RTP_RTPPACKETIZER_H_
+#define SRC_MODULES_SIMPLE_RTP_RTPPACKETIZER_H_
+
+#include "rtp_packet.h"
+#include "yuri/core/socket/DatagramSocket.h"
+#include <array>
+
+namespace yuri {
+namespace simple_rtp {
+
+enum class rtp_codec_t { h264, h265 };
+
+//! Size of IPv4 and UDP headers, that have to fit into MTU together with RTP packet
+constexpr size_t ip_udp_header_size = 28;
+
+//! RTP packet referencing its payload in the frame data
+struct rtp_packet_ref_t {
+    //! RTP header followed by payload specific header (FU indicator/header)
+    std::array<uint8_t, 16> header;
+    size_t                  header_size;
+    const uint8_t*          payload;
+    size_t                  payload_size;
+
+    size_t size() const { return header_size + payload_size; }
+};
+
+/*!
+ * Splits H.264 (RFC 6184) or H.265 (RFC 7798) frames into RTP packets.
+ *
+ * NAL units are sent either as single NAL unit packets or fragmented into
+ * FU packets. The packets only reference the payload in the frame, so the frame
+ * has to stay valid until the packets are sent. Marker bit is set on the last
+ * packet of every frame.
+ */
+class RtpPacketizer {
+public:
+    /*!
+     * @param max_packet_size	Maximal size of RTP packet (including RTP header)
+     */
+    RtpPacketizer(rtp_codec_t codec, size_t max_packet_size, uint8_t payload_type, uint32_t ssrc, uint16_t sequence = 0);
+
+    /*!
+     * Splits a frame into packets, replacing packets from previous call.
+     * @param avc_size	Size of NAL unit length prefix, 0 for Annex B start codes.
+     * @return number of packets
+     */
+    size_t packetize(const uint8_t* data, size_t size, size_t avc_size, uint32_t timestamp);
+
+    const std::vector<rtp_packet_ref_t>& get_packets() const { return packets_; }
+    //! Returns the packets as datagrams for DatagramSocket::send_datagrams, valid until next call to packetize()
+    const std::vector<core::socket::datagram_parts_t>& get_datagrams() const { return datagrams_; }
+
+    uint16_t get_sequence() const { return sequence_; }
+    void     set_ssrc(uint32_t ssrc) { ssrc_ = ssrc; }
+    void     set_max_packet_size(size_t max_packet_size) { max_packet_size_ = max_packet_size; }
+
+private:
+    void add_nal(const uint8_t* nal, size_t size, uint32_t timestamp);
+    rtp_packet_ref_t& add_packet(uint32_t timestamp);
+
+    rtp_codec_t                                 codec_;
+    size_t                                      max_packet_size_;
+    uint8_t                                     payload_type_;
+    uint32_t                                    ssrc_;
+    uint16_t                                    sequence_;
+    std::vector<rtp_packet_ref_t>               packets_;
+    std::vector<core::socket::datagram_t>       parts_;
+    std::vector<core::socket::datagram_parts_t> datagrams_;
+};
+}
+}
+
+#endif /* SRC_MODULES_SIMPLE_RTP_RTPPACKETIZER_H_ */
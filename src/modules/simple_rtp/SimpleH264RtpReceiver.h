@@ -10,6 +10,7 @@
 #ifndef SimpleH264RtpReceiver_H_
 #define SimpleH264RtpReceiver_H_
 
+#include "RtpJitterBuffer.h"
 #include "yuri/core/thread/IOThread.h"
 #include "yuri/core/socket/DatagramSocket.h"
 
@@ -27,11 +28,17 @@ private:
     virtual void run() override;
     virtual bool set_param(const core::Parameter& param) override;
 
-    uint16_t                                      sequence_;
+    void log_stats(RtpJitterBuffer& jitter_buffer);
+
     std::shared_ptr<core::socket::DatagramSocket> socket_;
     std::string                                   address_;
     uint16_t                                      port_;
     std::string                                   socket_type_;
+    duration_t                                    jitter_latency_;
+    size_t                                        slots_;
+    size_t                                        max_packet_size_;
+    duration_t                                    stats_interval_;
+    timestamp_t                                   last_stats_time_;
 };
 
 } /* namespace simple_rtp */
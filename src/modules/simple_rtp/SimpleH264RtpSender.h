@@ -11,7 +11,8 @@
 #ifndef SIMPLEH264RTPSENDER_H_
 #define SIMPLEH264RTPSENDER_H_
 
-#include "rtp_packet.h"
+#include "RtpPacketizer.h"
+#include "RtpPacer.h"
 #include "yuri/core/frame/CompressedVideoFrame.h"
 #include "yuri/core/socket/DatagramSocket.h"
 #include "yuri/core/thread/SpecializedIOFilter.h"
@@ -32,14 +33,24 @@ private:
     void         run() override;
     virtual bool set_param(const core::Parameter& param) override;
 
-    bool send_rtp_packet(const RTPPacket& packet);
+    void log_stats();
+
     size_t                                        mtu_;
     uint32_t                                      ssrc_;
-    uint16_t                                      sequence_;
     std::shared_ptr<core::socket::DatagramSocket> socket_;
     std::string                                   address_;
     uint16_t                                      port_;
     std::string                                   socket_type_;
+    double                                        max_bitrate_;
+    double                                        spread_;
+    size_t                                        burst_;
+    duration_t                                    stats_interval_;
+    bool                                          segmentation_offload_;
+    RtpPacketizer                                 packetizer_;
+    RtpPacer                                      pacer_;
+    bool                                          has_last_frame_;
+    timestamp_t                                   last_frame_time_;
+    timestamp_t                                   last_stats_time_;
 };
 
 } /* namespace simple_rtp */
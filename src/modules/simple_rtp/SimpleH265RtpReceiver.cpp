@@ -12,7 +12,6 @@
 #include "yuri/core/frame/compressed_frame_types.h"
 #include "yuri/core/socket/DatagramSocketGenerator.h"
 #include "yuri/core/frame/CompressedVideoFrame.h"
-#include "rtp_packet.h"
 
 namespace yuri {
 namespace simple_rtp {
@@ -26,11 +25,22 @@ core::Parameters SimpleH265RtpReceiver::configure()
     p["address"]["Remote address"] = "127.0.0.1";
     p["socket_type"]               = "yuri_udp";
     p["port"]                      = 57120;
+    p["jitter_latency"]["Maximal time to wait for missing or reordered packets (in seconds)"] = 0.1;
+    p["slots"]["Number of packets the jitter buffer can hold"]                                = 1024;
+    p["max_packet_size"]["Maximal size of received RTP packet"]                               = 2048;
+    p["stats_interval"]["Interval for logging of reception statistics (in seconds), 0 to disable"] = 10.0;
     return p;
 }
 
 SimpleH265RtpReceiver::SimpleH265RtpReceiver(const log::Log& log_, core::pwThreadBase parent, const core::Parameters& parameters)
-    : core::IOThread(log_, parent, 0, 1, std::string("simple_rtp")), sequence_{ 0 }, address_{ "127.0.0.1" }, port_{ 0x1256 }, socket_type_{ "yuri_udp" }
+    : core::IOThread(log_, parent, 0, 1, std::string("simple_rtp")),
+      address_{ "127.0.0.1" },
+      port_{ 0x1256 },
+      socket_type_{ "yuri_udp" },
+      jitter_latency_(100_ms),
+      slots_(1024),
+      max_packet_size_(2048),
+      stats_interval_(10_s)
 {
     IOTHREAD_INIT(parameters)
 }
@@ -40,15 +50,10 @@ SimpleH265RtpReceiver::~SimpleH265RtpReceiver() noexcept
 }
 
 namespace {
-
-void add_data(std::vector<uint8_t>& buffer, size_t read_bytes, RTPPacket& packet)
-{
-    buffer.reserve(buffer.size() + read_bytes - RTPPacket::header_size - 1);
-    buffer.insert(buffer.end(), packet.data_begin() + 3, packet.data_begin() + read_bytes - RTPPacket::header_size);
+//! Maximal number of packets read at once
+constexpr size_t receive_batch = 16;
 }
 
-std::array<uint8_t, 4> h265_start_code = { 0, 0, 0, 1 };
-}
 void SimpleH265RtpReceiver::run()
 {
     log[log::info] << "Initializing socket of type '" << socket_type_ << "'";
@@ -61,70 +66,51 @@ void SimpleH265RtpReceiver::run()
     }
     log[log::info] << "Socket initialized";
 
-    std::vector<uint8_t> buffer;
-
-    // Allocate large packet
-    RTPPacket    packet(65535, 0, 0, 0, 0);
-    resolution_t res{ 0, 0 };
-    uint32_t     last_timestamp_ = 0;
+    // Packets are received directly into the jitter buffer
+    RtpJitterBuffer                                             jitter_buffer(rtp_codec_t::h265, slots_, max_packet_size_, jitter_latency_, receive_batch);
+    std::array<core::socket::datagram_buffer_t, receive_batch> datagrams;
     while (still_running()) {
         if (socket_->wait_for_data(get_latency())) {
-            log[log::verbose_debug] << "reading data";
-            const auto read_bytes = socket_->receive_datagram(&packet.data[0], packet.data.size());
-            if (sequence_ != packet.get_sequence()) {
-                log[log::warning] << "Missing packet(s)! Expected sequence " << sequence_ << ", got " << packet.get_sequence();
-            }
-            sequence_ = (packet.get_sequence() + 1) % 65536;
-            if (last_timestamp_ != packet.get_timestamp()) {
-                // We assume that frames with the same timestamp should be merged together
-                if (!buffer.empty()) {
-                    auto frame = core::CompressedVideoFrame::create_empty(core::compressed_frame::h265, res, buffer.data(), buffer.size());
-                    log[log::verbose_debug] << "Sending (single) frame with " << frame->size();
-                    push_frame(0, std::move(frame));
-                    buffer.clear();
-                }
-                last_timestamp_ = packet.get_timestamp();
-            }
-            if (read_bytes > RTPPacket::header_size) {
-                // TODO: verify RTP headers and stuff ...
-                auto data        = &(*packet.data_begin());
-                auto packet_type = (data[0]>>1) & 0x3F;
-                if (packet_type > 0 && packet_type < 48) {
-                    // Single NALU packet
-
-                    buffer.insert(buffer.end(), h265_start_code.begin(), h265_start_code.end());
-                    buffer.insert(buffer.end(), data, data + read_bytes - RTPPacket::header_size);
-                } else
-                    switch (packet_type) {
-                    case 49: {
-                        // Fragmentation Unit A
-                        if (data[2] & 0x80) {
-                            // Start of fragmented frame
-                            buffer.insert(buffer.end(), h265_start_code.begin(), h265_start_code.end());
-                            buffer.push_back((data[0] & 0x81) | ((data[2] & 0x3F)<<1));
-                            buffer.push_back(data[1]);
-                        }
-
-                        add_data(buffer, read_bytes, packet);
-                        if (data[2] & 0x40) {
-                            // End of fragmented frame
-                            // No special processing here at the moment
-                        }
-                    }; break;
-                    default:
-                        log[log::warning] << "Unsupported packet type";
-                    }
-            }
+            const auto count = jitter_buffer.get_receive_buffers(datagrams.data(), datagrams.size());
+            const auto read  = socket_->receive_datagrams(datagrams.data(), count);
+            log[log::verbose_debug] << "Read " << read << " packets";
+            jitter_buffer.insert_received(datagrams.data(), read);
+        }
+        while (auto frame = jitter_buffer.pop_frame()) {
+            log[log::verbose_debug] << "Sending frame with " << frame->size();
+            push_frame(0, std::move(frame));
         }
+        log_stats(jitter_buffer);
     }
 }
 
+void SimpleH265RtpReceiver::log_stats(RtpJitterBuffer& jitter_buffer)
+{
+    if (stats_interval_ <= 0_us)
+        return;
+    const timestamp_t now;
+    if (now - last_stats_time_ < stats_interval_)
+        return;
+    const auto& stats = jitter_buffer.get_stats();
+    last_stats_time_  = now;
+    if (!stats.received)
+        return;
+    log[log::info] << "Received " << stats.received << " packets, " << stats.frames << " frames (" << stats.incomplete << " incomplete). "
+                   << stats.lost << " packets lost, " << stats.reordered << " reordered, " << stats.late << " late, " << stats.duplicates
+                   << " duplicate, " << stats.invalid << " invalid, " << stats.resyncs << " resyncs";
+    jitter_buffer.reset_stats();
+}
+
 bool SimpleH265RtpReceiver::set_param(const core::Parameter& param)
 {
-    if (assign_parameters(param)       //
-        (address_, "address")          //
-        (port_, "port")                //
-        (socket_type_, "socket_type")) //
+    if (assign_parameters(param)                                                                             //
+        (address_, "address")                                                                                //
+        (port_, "port")                                                                                      //
+        (socket_type_, "socket_type")                                                                        //
+        (jitter_latency_, "jitter_latency", [](const core::Parameter& p) { return 1_s * p.get<double>(); }) //
+        (slots_, "slots")                                                                                    //
+        (max_packet_size_, "max_packet_size")                                                                //
+        (stats_interval_, "stats_interval", [](const core::Parameter& p) { return 1_s * p.get<double>(); }))
         return true;
 
     return core::IOThread::set_param(param);
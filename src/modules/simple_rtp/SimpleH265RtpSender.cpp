@@ -22,11 +22,16 @@ core::Parameters SimpleH265RtpSender::configure()
 {
     core::Parameters p = core::IOThread::configure();
     p.set_description("SimpleH265RtpSender");
-    p["mtu"]["MTU"]                = 1500;
+    p["mtu"]["MTU of the network. RTP packets are sized to fit into it with IPv4 and UDP headers."] = 1500;
     p["ssrc"]["SSRC"]              = 0;
     p["address"]["Remote address"] = "127.0.0.1";
     p["socket_type"]               = "yuri_udp";
     p["port"]                      = 57120;
+    p["max_bitrate"]["Maximal bitrate in bits per second, packets are never sent faster. 0 for unlimited."] = 0;
+    p["spread"]["Portion of frame interval used to send packets of the frame. Set to 0 to send frames at once (or at max_bitrate)."] = 0.9;
+    p["burst"]["Maximal number of bytes sent at once while pacing"] = 6000;
+    p["stats_interval"]["Interval for logging of pacing statistics (in seconds), 0 to disable"] = 10.0;
+    p["segmentation_offload"]["Let the kernel split the bursts into packets (UDP GSO). Packets of each burst leave back to back, so it's mostly useful with spread 0."] = false;
     return p;
 }
 
@@ -34,12 +39,26 @@ SimpleH265RtpSender::SimpleH265RtpSender(const log::Log& log_, core::pwThreadBas
     : base_type(log_, parent, std::string("simple_rtp")),
       mtu_(1500),
       ssrc_(0x1234),
-      sequence_{ 0 },
       address_{ "127.0.0.1" },
       port_{ 0x1256 },
-      socket_type_{ "yuri_udp" }
+      socket_type_{ "yuri_udp" },
+      max_bitrate_(0.0),
+      spread_(0.9),
+      burst_(6000),
+      stats_interval_(10_s),
+      segmentation_offload_(false),
+      packetizer_(rtp_codec_t::h265, mtu_ - ip_udp_header_size, 99, ssrc_),
+      pacer_(max_bitrate_, spread_, burst_),
+      has_last_frame_(false)
 {
     IOTHREAD_INIT(parameters)
+    if (mtu_ < ip_udp_header_size + RTPPacket::header_size + 64) {
+        log[log::warning] << "MTU " << mtu_ << " is too small, using 576";
+        mtu_ = 576;
+    }
+    packetizer_.set_max_packet_size(mtu_ - ip_udp_header_size);
+    packetizer_.set_ssrc(ssrc_);
+    pacer_ = RtpPacer(max_bitrate_, spread_, burst_);
 }
 
 SimpleH265RtpSender::~SimpleH265RtpSender() noexcept
@@ -56,130 +75,74 @@ void SimpleH265RtpSender::run()
         request_end(core::yuri_exit_interrupted);
         return;
     }
+    if (segmentation_offload_ && !socket_->enable_segmentation_offload(true)) {
+        log[log::warning] << "Socket doesn't support segmentation offload, sending packets separately";
+    }
     log[log::info] << "Socket initialized";
     base_type::run();
 }
 
-namespace {
-
-struct data_view {
-    uint8_t* ptr;
-    size_t   size;
-    size_t   remaining;
-};
-
-/*!
- * Verifies that data have a valid h265 start prefix
- * @param data Input data
- * @return size of the prefix
- */
-
-size_t is_start_prefix(const data_view& data)
-{
-    if (data.size < 4)
-        return 0;
-    if (data.ptr[0] == 0 && data.ptr[1] == 0) {
-        if (data.ptr[2] == 1 && ((data.ptr[3] & 0x80) == 0)) {
-            return 3;
-        }
-        if (data.size > 4 && data.ptr[2] == 0 && data.ptr[3] == 1 && ((data.ptr[4] & 0x80) == 0)) {
-            return 4;
-        }
-    }
-    return 0;
-}
-
-data_view find_nal(data_view data)
-{
-    auto preffix_len = is_start_prefix(data);
-    if (!preffix_len)
-        return { nullptr, 0, 0 };
-    // We should try to find other NALs here...
-    for (auto i = preffix_len; i < data.size; ++i) {
-        if (is_start_prefix({ data.ptr + i, data.size - i, data.remaining })) {
-            return { data.ptr + preffix_len, i - preffix_len, data.size - i };
-        }
-    }
-    return { data.ptr + preffix_len, data.size - preffix_len, 0 };
-}
-}
-
 core::pFrame SimpleH265RtpSender::do_special_single_step(core::pCompressedVideoFrame frame)
 {
     if (frame->get_format() != core::compressed_frame::h265) {
         log[log::warning] << "Unsupported frame format";
         return {};
     }
-    data_view dv        = { &(*frame)[0], frame->size(), 0 };
-    auto      d         = find_nal(dv);
-    auto      timestamp = 9 * (frame->get_timestamp() - core::utils::get_global_start_time()).value / 100;
-    while (d.size > 0) {
-        log[log::verbose_debug] << "Found nal (" << static_cast<int>((d.ptr[0]>>1) & 0x3F) << ") of size " << d.size << " in data block of " << dv.size << "B";
-
-        if (d.size < (mtu_ + RTPPacket::header_size)) {
-            // Packetize as single NAL unit packet
-            // TODO: set payload type and timestamp
-            RTPPacket packet(d.size, 99, sequence_++, timestamp, ssrc_);
-            std::copy(d.ptr, d.ptr + d.size, packet.data_begin());
-            packet.set_marker_bit();
-            send_rtp_packet(packet);
-            log[log::verbose_debug] << "Sent small packet " << sequence_;
-        } else {
-            // Fragment into multiple packets
-            auto    nal_head = d.ptr[0];
-            uint8_t fu_head1  = (nal_head & 0x81) | (49 <<1);   // Type 49 an copy  anf F
-            uint8_t fu_head2  = (d.ptr[1]);
-            nal_head         = ((nal_head >> 1) & 0x3F) | 0x80; // Set S bit
-            size_t offset    = 2;
-            for (auto remaining = d.size - 2; remaining > 0;) {
-                const auto size = std::min(mtu_ - 2, remaining);
-                RTPPacket  packet(size + 3, 99, sequence_++, timestamp, ssrc_);
-                auto       data = &(*packet.data_begin());
-                data[0]         = fu_head1;
-                data[1]         = fu_head2;
-                if (remaining == size) {
-                    nal_head |= 0x40; // Set E bit
-                    packet.set_marker_bit();
-                }
-                data[2]  = nal_head;
-                nal_head = nal_head & 0x3F; // Unset S and R bits
-                std::copy(d.ptr + offset, d.ptr + offset + size, packet.data_begin() + 3);
-                send_rtp_packet(packet);
-                remaining -= size;
-                offset += size;
-                log[log::verbose_debug] << "Sent FU packet " << sequence_ << " (" << size << ")";
-            }
-        }
-        dv.ptr       = d.ptr + d.size;
-        dv.size      = d.remaining;
-        dv.remaining = 0;
-
-        d = find_nal(dv);
+    const size_t avc_size = 0;
+    const auto timestamp = 9 * (frame->get_timestamp() - core::utils::get_global_start_time()).value / 100;
+    const auto count     = packetizer_.packetize(frame->data(), frame->size(), avc_size, static_cast<uint32_t>(timestamp));
+    log[log::verbose_debug] << "Frame of " << frame->size() << "B split into " << count << " packets";
+
+    // Frames without duration are spread over the interval since previous frame
+    auto interval = frame->get_duration();
+    if (interval <= 0_us && has_last_frame_) {
+        interval = std::min(frame->get_timestamp() - last_frame_time_, 1_s);
+    }
+    last_frame_time_ = frame->get_timestamp();
+    has_last_frame_  = true;
+
+    // Packets reference data in the frame, that stays valid until they're sent
+    const auto& datagrams = packetizer_.get_datagrams();
+    const auto  sent      = pacer_.send(*socket_, datagrams.data(), datagrams.size(), interval);
+    if (sent < count) {
+        log[log::error] << "Failed to send " << (count - sent) << " of " << count << " packets";
     }
+    log_stats();
     return {};
 }
 
-bool SimpleH265RtpSender::send_rtp_packet(const RTPPacket& packet)
+void SimpleH265RtpSender::log_stats()
 {
-	int i = 0;
-	while(i++ < 5) {
-		auto s = socket_->send_datagram(packet.data);
-		if (s == packet.data.size()) {
-			return true;
-		}
-	}
-	log[log::error] << "Failed to send packet with " << packet.data.size() <<" bytes";
-	return false;
+    if (stats_interval_ <= 0_us)
+        return;
+    const timestamp_t now;
+    if (now - last_stats_time_ < stats_interval_)
+        return;
+    const auto  elapsed = now - last_stats_time_;
+    const auto& stats   = pacer_.get_stats();
+    last_stats_time_    = now;
+    if (!stats.frames)
+        return;
+    log[log::info] << "Sent " << stats.frames << " frames in " << stats.packets << " packets, "
+                   << (stats.bytes * 8.0 / (elapsed.value * 1e-6) / 1e6) << " Mbit/s. "
+                   << stats.late_packets << " packets late (average " << (stats.late_packets ? stats.total_lateness.value / stats.late_packets : 0)
+                   << " us, max " << stats.max_lateness.value << " us), " << stats.overruns << " frames sent longer than frame interval";
+    pacer_.reset_stats();
 }
 
 bool SimpleH265RtpSender::set_param(const core::Parameter& param)
 {
-    if (assign_parameters(param)       //
-        (mtu_, "mtu")                  //
-        (ssrc_, "ssrc")                //
-        (address_, "address")          //
-        (port_, "port")                //
-        (socket_type_, "socket_type")) //
+    if (assign_parameters(param)                        //
+        (mtu_, "mtu")                                   //
+        (ssrc_, "ssrc")                                 //
+        (address_, "address")                           //
+        (port_, "port")                                 //
+        (socket_type_, "socket_type")                   //
+        (max_bitrate_, "max_bitrate")                   //
+        (spread_, "spread")                             //
+        (burst_, "burst")                               //
+        (segmentation_offload_, "segmentation_offload") //
+        (stats_interval_, "stats_interval", [](const core::Parameter& p) { return 1_s * p.get<double>(); }))
         return true;
     return base_type::set_param(param);
 }
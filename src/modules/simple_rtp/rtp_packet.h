@@ -17,24 +17,30 @@
 namespace yuri {
 namespace simple_rtp {
 
+//! Writes 12 bytes of RTP header (without CSRC list) to @em data
+inline void write_rtp_header(uint8_t* data, uint8_t payload_type, uint16_t sequence, uint32_t timestamp, uint32_t ssrc, bool marker = false)
+{
+    data[0]  = 0x80; // Version 2, other fields in byte 0 are set to 0
+    data[1]  = (payload_type & 0x7f) | (marker ? 0x80 : 0x00);
+    data[2]  = (sequence >> 8) & 0xFF;
+    data[3]  = sequence & 0xFF;
+    data[4]  = (timestamp >> 24) & 0xFF;
+    data[5]  = (timestamp >> 16) & 0xFF;
+    data[6]  = (timestamp >> 8) & 0xFF;
+    data[7]  = (timestamp >> 0) & 0xFF;
+    data[8]  = (ssrc >> 24) & 0xFF;
+    data[9]  = (ssrc >> 16) & 0xFF;
+    data[10] = (ssrc >> 8) & 0xFF;
+    data[11] = (ssrc >> 0) & 0xFF;
+}
+
 struct RTPPacket {
     using size_type                        = std::vector<uint8_t>::size_type;
     static constexpr size_type header_size = 12;
 
     RTPPacket(size_type size, uint8_t payload_type, uint16_t sequence, uint32_t timestamp, uint32_t ssrc) : data(header_size + size)
     {
-        data[0]  = 0x80; // Version 2, other fields in byte 0 are set to 0
-        data[1]  = payload_type & 0x7f;
-        data[2]  = (sequence >> 8) & 0xFF;
-        data[3]  = sequence & 0xFF;
-        data[4]  = (timestamp >> 24) & 0xFF;
-        data[5]  = (timestamp >> 16) & 0xFF;
-        data[6]  = (timestamp >> 8) & 0xFF;
-        data[7]  = (timestamp >> 0) & 0xFF;
-        data[8]  = (ssrc >> 24) & 0xFF;
-        data[9]  = (ssrc >> 16) & 0xFF;
-        data[10] = (ssrc >> 8) & 0xFF;
-        data[11] = (ssrc >> 0) & 0xFF;
+        write_rtp_header(data.data(), payload_type, sequence, timestamp, ssrc);
     }
 
     std::vector<uint8_t>::iterator       data_begin() { return data.begin() + header_size; }
@@ -0,0 +1,464 @@
+/*!
+ * @file 		test_rtp.cpp
+ * @author 		agent <agent@local>
+ * @date 		18.10.2026
+ * @copyright	Institute of Intermedia, CTU in Prague, 2026
+ * 				Distributed under modified BSD Licence, details in file doc/LICENSE
+ *
+ */
+
+#include "tests/catch.hpp"
+#include "RtpPacketizer.h"
+#include "RtpPacer.h"
+#include "RtpJitterBuffer.h"
+#include "yuri/core/frame/compressed_frame_types.h"
+#include <deque>
+#include <sstream>
+
+namespace yuri {
+namespace simple_rtp {
+
+namespace {
+std::vector<uint8_t> make_nal(uint8_t header, size_t size)
+{
+    std::vector<uint8_t> nal(size);
+    nal[0] = header;
+    for (size_t i = 1; i < size; ++i) {
+        nal[i] = static_cast<uint8_t>(i * 7 + 1);
+    }
+    return nal;
+}
+
+std::vector<uint8_t> annex_b(const std::vector<std::vector<uint8_t>>& nals)
+{
+    std::vector<uint8_t> data;
+    for (const auto& nal : nals) {
+        data.insert(data.end(), { 0, 0, 0, 1 });
+        data.insert(data.end(), nal.begin(), nal.end());
+    }
+    return data;
+}
+
+std::vector<uint8_t> gather(const core::socket::datagram_parts_t& datagram)
+{
+    std::vector<uint8_t> data;
+    for (size_t i = 0; i < datagram.count; ++i) {
+        data.insert(data.end(), datagram.parts[i].data, datagram.parts[i].data + datagram.parts[i].size);
+    }
+    return data;
+}
+
+//! Socket recording sent datagrams and time they were sent
+class RecordingSocket : public core::socket::DatagramSocket {
+public:
+    RecordingSocket(const log::Log& log_) : core::socket::DatagramSocket(log_) {}
+    std::vector<std::vector<uint8_t>> datagrams;
+    std::vector<timestamp_t>          times;
+
+private:
+    size_t do_send_datagram(const uint8_t* data, size_t size) override
+    {
+        datagrams.emplace_back(data, data + size);
+        times.emplace_back();
+        return size;
+    }
+    size_t do_receive_datagram(uint8_t*, size_t) override { return 0; }
+    bool   do_bind(const std::string&, core::socket::port_t) override { return true; }
+    bool   do_connect(const std::string&, core::socket::port_t) override { return true; }
+    bool   do_data_available() override { return false; }
+    bool   do_ready_to_send() override { return true; }
+    bool   do_wait_for_data(duration_t) override { return false; }
+};
+
+/*!
+ * Stand-in for a lossy UDP link. Sent datagrams are queued for receiving,
+ * with datagrams selected by their index dropped, duplicated or delayed.
+ */
+class LossySocket : public core::socket::DatagramSocket {
+public:
+    LossySocket(const log::Log& log_) : core::socket::DatagramSocket(log_), sent_(0) {}
+    std::vector<size_t> drop;
+    std::vector<size_t> duplicate;
+    //! Datagrams delivered after @em delay_by following datagrams
+    std::vector<size_t> delay;
+    size_t              delay_by = 3;
+    //! Dropped datagrams, so they can be delivered later
+    std::vector<std::vector<uint8_t>> dropped;
+
+private:
+    static bool contains(const std::vector<size_t>& v, size_t index) { return std::find(v.begin(), v.end(), index) != v.end(); }
+
+    size_t do_send_datagram(const uint8_t* data, size_t size) override
+    {
+        const auto index = sent_++;
+        if (contains(drop, index)) {
+            dropped.emplace_back(data, data + size);
+            return size;
+        }
+        if (contains(delay, index)) {
+            delayed_.push_back({ index + delay_by, { data, data + size } });
+        } else {
+            queue_.emplace_back(data, data + size);
+            if (contains(duplicate, index))
+                queue_.emplace_back(data, data + size);
+        }
+        for (auto it = delayed_.begin(); it != delayed_.end();) {
+            if (it->first <= index) {
+                queue_.push_back(std::move(it->second));
+                it = delayed_.erase(it);
+            } else {
+                ++it;
+            }
+        }
+        return size;
+    }
+    size_t do_receive_datagram(uint8_t* data, size_t size) override
+    {
+        if (queue_.empty())
+            return 0;
+        const auto d = std::move(queue_.front());
+        queue_.pop_front();
+        if (d.size() > size)
+            return 0;
+        std::copy(d.begin(), d.end(), data);
+        return d.size();
+    }
+    bool do_bind(const std::string&, core::socket::port_t) override { return true; }
+    bool do_connect(const std::string&, core::socket::port_t) override { return true; }
+    bool do_data_available() override { return !queue_.empty(); }
+    bool do_ready_to_send() override { return true; }
+    bool do_wait_for_data(duration_t) override { return !queue_.empty(); }
+
+    size_t                                                   sent_;
+    std::deque<std::vector<uint8_t>>                         queue_;
+    std::vector<std::pair<size_t, std::vector<uint8_t>>>     delayed_;
+};
+
+//! Receives everything waiting in the socket into the jitter buffer
+void receive_all(core::socket::DatagramSocket& socket, RtpJitterBuffer& jitter_buffer, timestamp_t now)
+{
+    std::array<core::socket::datagram_buffer_t, 4> buffers;
+    while (socket.data_available()) {
+        const auto count = jitter_buffer.get_receive_buffers(buffers.data(), buffers.size());
+        jitter_buffer.insert_received(buffers.data(), socket.receive_datagrams(buffers.data(), count), now);
+    }
+}
+
+std::vector<uint8_t> frame_data(const core::pCompressedVideoFrame& frame)
+{
+    return { frame->data(), frame->data() + frame->size() };
+}
+
+//! Frames with a small NAL unit and a large one, split to 1 + 3 packets
+std::vector<std::vector<uint8_t>> make_frames(size_t count)
+{
+    std::vector<std::vector<uint8_t>> frames;
+    for (size_t i = 0; i < count; ++i) {
+        auto large = make_nal(0x65, 250);
+        large[1]   = static_cast<uint8_t>(i);
+        frames.push_back(annex_b({ make_nal(0x06, 10), large }));
+    }
+    return frames;
+}
+}
+
+TEST_CASE("rtp packetizer h264", "[simple_rtp]")
+{
+    RtpPacketizer packetizer(rtp_codec_t::h264, 112, 99, 0x11223344, 65534);
+    const auto    small = make_nal(0x67, 20);
+    const auto    large = make_nal(0x65, 250);
+    const auto    frame = annex_b({ small, large });
+    // Small NAL in a single packet, large one split into 3 FU-A packets (max 98 bytes of payload)
+    REQUIRE(packetizer.packetize(frame.data(), frame.size(), 0, 1000) == 4);
+    const auto& packets   = packetizer.get_packets();
+    const auto& datagrams = packetizer.get_datagrams();
+    REQUIRE(datagrams.size() == 4);
+
+    std::vector<uint8_t> reassembled;
+    for (size_t i = 0; i < packets.size(); ++i) {
+        const auto data = gather(datagrams[i]);
+        REQUIRE(data.size() <= 112);
+        REQUIRE(data[0] == 0x80);
+        // Marker bit only on the last packet
+        REQUIRE(data[1] == (i == 3 ? 0x80 | 99 : 99));
+        REQUIRE(((data[2] << 8) | data[3]) == static_cast<uint16_t>(65534 + i));
+        REQUIRE(data[7] == (1000 & 0xFF));
+        REQUIRE(data[8] == 0x11);
+        // Payload is not copied
+        REQUIRE(packets[i].payload >= frame.data());
+        REQUIRE(packets[i].payload < frame.data() + frame.size());
+        if (i == 0) {
+            REQUIRE(std::equal(small.begin(), small.end(), data.begin() + 12, data.end()));
+            continue;
+        }
+        REQUIRE((data[12] & 0x1F) == 28);
+        REQUIRE((data[12] & 0xE0) == (0x65 & 0xE0));
+        REQUIRE((data[13] & 0x1F) == (0x65 & 0x1F));
+        REQUIRE(static_cast<bool>(data[13] & 0x80) == (i == 1));
+        REQUIRE(static_cast<bool>(data[13] & 0x40) == (i == 3));
+        reassembled.insert(reassembled.end(), data.begin() + 14, data.end());
+    }
+    REQUIRE(std::equal(large.begin() + 1, large.end(), reassembled.begin(), reassembled.end()));
+    REQUIRE(packetizer.get_sequence() == 2);
+
+    SECTION("avc length prefix")
+    {
+        std::vector<uint8_t> avc = { 0, 0, 0, static_cast<uint8_t>(small.size()) };
+        avc.insert(avc.end(), small.begin(), small.end());
+        REQUIRE(packetizer.packetize(avc.data(), avc.size(), 4, 2000) == 1);
+        REQUIRE(packetizer.get_packets()[0].payload == avc.data() + 4);
+        REQUIRE(packetizer.get_packets()[0].payload_size == small.size());
+    }
+}
+
+TEST_CASE("rtp packetizer h265", "[simple_rtp]")
+{
+    RtpPacketizer packetizer(rtp_codec_t::h265, 100, 96, 1);
+    // IDR_W_RADL (type 19) NAL with 2 byte header
+    auto       nal   = make_nal(19 << 1, 200);
+    nal[1]           = 0x01;
+    const auto frame = annex_b({ nal });
+    REQUIRE(packetizer.packetize(frame.data(), frame.size(), 0, 0) == 3);
+    std::vector<uint8_t> reassembled;
+    for (size_t i = 0; i < 3; ++i) {
+        const auto data = gather(packetizer.get_datagrams()[i]);
+        REQUIRE(data.size() <= 100);
+        REQUIRE(((data[12] >> 1) & 0x3F) == 49);
+        REQUIRE(data[13] == 0x01);
+        REQUIRE((data[14] & 0x3F) == 19);
+        REQUIRE(static_cast<bool>(data[14] & 0x80) == (i == 0));
+        REQUIRE(static_cast<bool>(data[14] & 0x40) == (i == 2));
+        reassembled.insert(reassembled.end(), data.begin() + 15, data.end());
+    }
+    REQUIRE(std::equal(nal.begin() + 2, nal.end(), reassembled.begin(), reassembled.end()));
+}
+
+TEST_CASE("token bucket", "[simple_rtp]")
+{
+    const timestamp_t start;
+    TokenBucket       bucket(1000.0, 500, start);
+    REQUIRE(bucket.get_delay(500, start) == 0_us);
+    bucket.consume(500);
+    REQUIRE(bucket.get_delay(100, start) == 100_ms);
+    REQUIRE(bucket.get_delay(100, start + 50_ms) == 50_ms);
+    REQUIRE(bucket.get_delay(100, start + 100_ms) == 0_us);
+    bucket.consume(100);
+    // Bucket never holds more than its depth, larger packets wait for a full bucket
+    REQUIRE(bucket.get_delay(2000, start + 10_s) == 0_us);
+    bucket.consume(2000);
+    REQUIRE(bucket.get_delay(100, start + 10_s) == 1600_ms);
+    bucket.set_rate(0.0, start + 10_s);
+    REQUIRE(bucket.get_delay(100000, start + 10_s) == 0_us);
+}
+
+TEST_CASE("rtp pacer", "[simple_rtp]")
+{
+    std::stringstream ss;
+    log::Log          l(ss);
+    RecordingSocket   socket(l);
+
+    std::vector<uint8_t>                        payload(1000, 0x55);
+    std::vector<core::socket::datagram_t>       parts(20, core::socket::datagram_t{ payload.data(), payload.size() });
+    std::vector<core::socket::datagram_parts_t> datagrams;
+    for (auto& p : parts) {
+        datagrams.push_back({ &p, 1 });
+    }
+
+    SECTION("packets are spread over the frame interval")
+    {
+        RtpPacer   pacer(0.0, 0.5, 2000);
+        const auto start = timestamp_t{};
+        REQUIRE(pacer.send(socket, datagrams.data(), datagrams.size(), 40_ms) == 20);
+        const auto elapsed = timestamp_t{} - start;
+        REQUIRE(socket.datagrams.size() == 20);
+        // 20 kB in 20 ms, first 2 kB sent immediately
+        REQUIRE(elapsed >= 17_ms);
+        REQUIRE(elapsed < 40_ms);
+        REQUIRE(socket.times[19] - socket.times[10] >= 8_ms);
+        const auto& stats = pacer.get_stats();
+        REQUIRE(stats.frames == 1);
+        REQUIRE(stats.packets == 20);
+        REQUIRE(stats.bytes == 20000);
+        REQUIRE(stats.overruns == 0);
+    }
+    SECTION("bitrate ceiling")
+    {
+        // 8 Mbit/s = 1 MB/s, so 20 kB take at least 18 ms even if the interval is shorter
+        RtpPacer   pacer(8e6, 0.9, 2000);
+        const auto start = timestamp_t{};
+        REQUIRE(pacer.send(socket, datagrams.data(), datagrams.size(), 1_ms) == 20);
+        REQUIRE(timestamp_t{} - start >= 17_ms);
+        REQUIRE(pacer.get_stats().overruns == 1);
+    }
+    SECTION("unlimited")
+    {
+        RtpPacer pacer(0.0, 0.0, 2000);
+        REQUIRE(pacer.send(socket, datagrams.data(), datagrams.size(), 1_s) == 20);
+        REQUIRE(pacer.get_stats().late_packets == 0);
+    }
+}
+TEST_CASE("rtp jitter buffer", "[simple_rtp]")
+{
+    std::stringstream ss;
+    log::Log          l(ss);
+    LossySocket       socket(l);
+    RtpPacketizer     packetizer(rtp_codec_t::h264, 112, 99, 1, 65530);
+    RtpJitterBuffer   jitter_buffer(rtp_codec_t::h264, 32, 256, 50_ms, 4);
+    const auto        frames = make_frames(9);
+    const timestamp_t start;
+
+    auto send_frame = [&](size_t i) {
+        packetizer.packetize(frames[i].data(), frames[i].size(), 0, static_cast<uint32_t>(i * 3600));
+        REQUIRE(socket.send_datagrams(packetizer.get_datagrams()) == 4);
+    };
+
+    SECTION("reordered and duplicated packets")
+    {
+        socket.delay     = { 1, 6, 17 };
+        socket.duplicate = { 9 };
+        for (size_t i = 0; i < 5; ++i) {
+            send_frame(i);
+        }
+        receive_all(socket, jitter_buffer, start);
+        // The last delayed packet is still missing
+        for (size_t i = 0; i < 4; ++i) {
+            auto frame = jitter_buffer.pop_frame(start);
+            REQUIRE(frame);
+            REQUIRE(frame_data(frame) == frames[i]);
+        }
+        REQUIRE(!jitter_buffer.pop_frame(start));
+        std::vector<uint16_t> missing;
+        jitter_buffer.get_missing(missing);
+        REQUIRE(missing == std::vector<uint16_t>{ static_cast<uint16_t>(65530 + 17) });
+        // Following packets flush the delayed one
+        send_frame(0);
+        receive_all(socket, jitter_buffer, start);
+        auto frame = jitter_buffer.pop_frame(start);
+        REQUIRE(frame);
+        REQUIRE(frame_data(frame) == frames[4]);
+        const auto& stats = jitter_buffer.get_stats();
+        REQUIRE(stats.reordered == 3);
+        REQUIRE(stats.duplicates == 1);
+        REQUIRE(stats.lost == 0);
+        REQUIRE(stats.frames == 5);
+        REQUIRE(stats.incomplete == 0);
+    }
+    SECTION("lost packets")
+    {
+        // Second fragment of frame 1 and the single NAL of frame 3
+        socket.drop = { 6, 12 };
+        for (size_t i = 0; i < 4; ++i) {
+            send_frame(i);
+        }
+        receive_all(socket, jitter_buffer, start);
+        REQUIRE(jitter_buffer.pop_frame(start));
+        // Frame 1 waits for the missing packet until the latency expires
+        REQUIRE(!jitter_buffer.pop_frame(start + 40_ms));
+        std::vector<uint16_t> missing;
+        jitter_buffer.get_missing(missing);
+        REQUIRE(missing.size() == 2);
+
+        auto frame = jitter_buffer.pop_frame(start + 50_ms);
+        REQUIRE(frame);
+        // Only the small NAL unit is left from the frame
+        REQUIRE(frame_data(frame) == annex_b({ make_nal(0x06, 10) }));
+        frame = jitter_buffer.pop_frame(start + 50_ms);
+        REQUIRE(frame);
+        REQUIRE(frame_data(frame) == frames[2]);
+        // Missing NAL before the fragments can't be detected, frame 3 is output whole without it
+        frame = jitter_buffer.pop_frame(start + 100_ms);
+        REQUIRE(frame);
+        REQUIRE(frame_data(frame) == std::vector<uint8_t>(frames[3].begin() + 14, frames[3].end()));
+
+        // Retransmitted packet arriving too late
+        REQUIRE(!jitter_buffer.insert(socket.dropped[0].data(), socket.dropped[0].size(), start + 100_ms));
+        const auto& stats = jitter_buffer.get_stats();
+        REQUIRE(stats.lost == 2);
+        REQUIRE(stats.late == 1);
+        REQUIRE(stats.frames == 4);
+        REQUIRE(stats.incomplete == 2);
+    }
+    SECTION("ring overflow")
+    {
+        // Frame 0 never completes and gets dropped, as 32 slots can't hold all following frames
+        socket.drop = { 3 };
+        for (size_t i = 0; i < frames.size(); ++i) {
+            send_frame(i);
+        }
+        receive_all(socket, jitter_buffer, start);
+        for (size_t i = 1; i < frames.size(); ++i) {
+            auto frame = jitter_buffer.pop_frame(start);
+            REQUIRE(frame);
+            REQUIRE(frame_data(frame) == frames[i]);
+        }
+        REQUIRE(!jitter_buffer.pop_frame(start + 1_s));
+        REQUIRE(jitter_buffer.get_stats().lost == 4);
+    }
+    SECTION("sender restart")
+    {
+        for (size_t i = 0; i < 3; ++i) {
+            send_frame(i);
+        }
+        receive_all(socket, jitter_buffer, start);
+        for (size_t i = 0; i < 3; ++i) {
+            REQUIRE(jitter_buffer.pop_frame(start));
+        }
+        // Next sequence number is 65530 + 12 = 6
+        auto send_restarted = [&](uint32_t ssrc, uint16_t sequence, size_t count) {
+            RtpPacketizer restarted(rtp_codec_t::h264, 112, 99, ssrc, sequence);
+            for (size_t i = 0; i < count; ++i) {
+                restarted.packetize(frames[i].data(), frames[i].size(), 0, static_cast<uint32_t>(i * 3600));
+                REQUIRE(socket.send_datagrams(restarted.get_datagrams()) == 4);
+            }
+            receive_all(socket, jitter_buffer, start);
+        };
+        const auto& stats = jitter_buffer.get_stats();
+
+        // New SSRC
+        send_restarted(2, 0, 1);
+        auto frame = jitter_buffer.pop_frame(start);
+        REQUIRE(frame);
+        REQUIRE(frame_data(frame) == frames[0]);
+        REQUIRE(stats.resyncs == 1);
+
+        // Same SSRC, sequence numbers far behind
+        send_restarted(2, 65436, 1);
+        frame = jitter_buffer.pop_frame(start);
+        REQUIRE(frame);
+        REQUIRE(frame_data(frame) == frames[0]);
+        REQUIRE(stats.resyncs == 2);
+
+        // Sequence numbers restarted within the ring, recovered after a run of late packets.
+        // The run ends with the last fragment of frame 3, so frame 4 is the first one output.
+        send_restarted(2, 65420, 5);
+        frame = jitter_buffer.pop_frame(start);
+        REQUIRE(frame);
+        REQUIRE(frame_data(frame) == frames[4]);
+        REQUIRE(stats.resyncs == 3);
+        REQUIRE(stats.late == 15);
+    }
+}
+
+TEST_CASE("rtp jitter buffer h265", "[simple_rtp]")
+{
+    RtpPacketizer   packetizer(rtp_codec_t::h265, 100, 96, 1);
+    RtpJitterBuffer jitter_buffer(rtp_codec_t::h265, 64, 1500, 50_ms);
+    auto            nal = make_nal(19 << 1, 200);
+    nal[1]              = 0x01;
+    const auto frame    = annex_b({ make_nal(1 << 1, 30), nal });
+    REQUIRE(packetizer.packetize(frame.data(), frame.size(), 0, 0) == 4);
+    std::vector<uint8_t> packet;
+    for (auto i : { 0, 3, 1, 2 }) {
+        const auto& p = packetizer.get_packets()[i];
+        packet.assign(p.header.begin(), p.header.begin() + p.header_size);
+        packet.insert(packet.end(), p.payload, p.payload + p.payload_size);
+        REQUIRE(jitter_buffer.insert(packet.data(), packet.size()));
+    }
+    auto out = jitter_buffer.pop_frame();
+    REQUIRE(out);
+    REQUIRE(out->get_format() == core::compressed_frame::h265);
+    REQUIRE(frame_data(out) == frame);
+    REQUIRE(jitter_buffer.get_stats().reordered == 2);
+}
+}
+}
@@ -9,19 +9,73 @@
 
 #include "YuriDatagram.h"
 
+#include <algorithm>
+#include <cerrno>
+#include <netinet/in.h>
 #include <sys/socket.h>
 #include <sys/un.h>
 #include <poll.h>
 #include <unistd.h>
 
+#ifndef SOL_UDP
+#define SOL_UDP 17
+#endif
+#ifndef UDP_SEGMENT
+#define UDP_SEGMENT 103
+#endif
+
 
 
 namespace yuri {
 namespace network {
 
+namespace {
+//! Maximal number of messages passed to a single sendmmsg/recvmmsg call
+constexpr size_t max_batch = 64;
+//! Maximal number of segments in a single UDP_SEGMENT send
+constexpr size_t max_segments = 64;
+//! Maximal number of buffers for a single sendmmsg call
+constexpr size_t max_iov = 1024;
+//! Maximal payload of a single UDP_SEGMENT send
+constexpr size_t max_segmented_size = 65507;
+
+size_t datagram_size(const core::socket::datagram_parts_t& datagram)
+{
+	size_t size = 0;
+	for (size_t i = 0; i < datagram.count; ++i) {
+		size += datagram.parts[i].size;
+	}
+	return size;
+}
+
+/*!
+ * Returns number of datagrams, starting with the first one, that can be sent as a single segmented buffer.
+ * All the datagrams have to have the same size, except for the last one, that may be shorter.
+ * @param max_parts Maximal number of buffers of all the datagrams together
+ */
+size_t segment_run(const core::socket::datagram_parts_t* datagrams, size_t count, size_t max_parts)
+{
+	const auto segment_size = datagram_size(datagrams[0]);
+	if (!segment_size) return 1;
+	size_t total = 0;
+	size_t parts = 0;
+	size_t i = 0;
+	for (; i < std::min(count, max_segments); ++i) {
+		const auto size = datagram_size(datagrams[i]);
+		if (size > segment_size || total + size > max_segmented_size || parts + datagrams[i].count > max_parts) break;
+		total += size;
+		parts += datagrams[i].count;
+		if (size < segment_size) {
+			++i;
+			break;
+		}
+	}
+	return std::max<size_t>(i, 1);
+}
+}
 
 YuriDatagram::YuriDatagram(const log::Log &log_, const std::string&, int domain):
-core::socket::DatagramSocket(log_),socket_(domain, SOCK_DGRAM, 0)
+core::socket::DatagramSocket(log_),socket_(domain, SOCK_DGRAM, 0),segmentation_offload_(false)
 {
  int optval = 1;
  if(setsockopt(get_socket(), SOL_SOCKET, SO_REUSEADDR,(void *) &optval, sizeof(optval)) <0){
@@ -52,6 +106,108 @@ size_t YuriDatagram::do_receive_datagram(uint8_t* data, size_t size)
 	return (read>0)?read:0;
 }
 
+size_t YuriDatagram::do_send_datagrams(const core::socket::datagram_t* datagrams, size_t count)
+{
+	constexpr size_t chunk = 256;
+	core::socket::datagram_parts_t parts[chunk];
+	size_t sent = 0;
+	while (sent < count) {
+		const auto batch = std::min(count - sent, chunk);
+		for (size_t i = 0; i < batch; ++i) {
+			parts[i] = {datagrams + sent + i, 1};
+		}
+		const auto batch_sent = do_send_datagram_parts(parts, batch);
+		sent += batch_sent;
+		if (batch_sent < batch) break;
+	}
+	return sent;
+}
+
+size_t YuriDatagram::do_send_datagram_parts(const core::socket::datagram_parts_t* datagrams, size_t count)
+{
+	constexpr size_t control_size = CMSG_SPACE(sizeof(uint16_t));
+	mmsghdr messages[max_batch];
+	iovec iov[max_iov];
+	// Array of cmsghdr ensures proper alignment of the control data
+	cmsghdr control[max_batch][(control_size + sizeof(cmsghdr) - 1) / sizeof(cmsghdr)];
+	size_t sent = 0;
+	while (sent < count) {
+		size_t msg_count = 0;
+		size_t iov_count = 0;
+		// Number of datagrams in each message
+		size_t msg_datagrams[max_batch];
+		size_t pos = sent;
+		while (pos < count && msg_count < max_batch && iov_count + datagrams[pos].count <= max_iov) {
+			auto& msg = messages[msg_count];
+			msg = mmsghdr{};
+			const size_t run = segmentation_offload_ ? segment_run(datagrams + pos, count - pos, max_iov - iov_count) : 1;
+			msg.msg_hdr.msg_iov = &iov[iov_count];
+			for (size_t i = 0; i < run; ++i) {
+				const auto& datagram = datagrams[pos + i];
+				for (size_t j = 0; j < datagram.count; ++j) {
+					iov[iov_count++] = { const_cast<uint8_t*>(datagram.parts[j].data), datagram.parts[j].size };
+				}
+			}
+			msg.msg_hdr.msg_iovlen = &iov[iov_count] - msg.msg_hdr.msg_iov;
+			if (run > 1) {
+				msg.msg_hdr.msg_control = control[msg_count];
+				msg.msg_hdr.msg_controllen = control_size;
+				auto cmsg = CMSG_FIRSTHDR(&msg.msg_hdr);
+				cmsg->cmsg_level = SOL_UDP;
+				cmsg->cmsg_type = UDP_SEGMENT;
+				cmsg->cmsg_len = CMSG_LEN(sizeof(uint16_t));
+				const uint16_t segment_size = static_cast<uint16_t>(datagram_size(datagrams[pos]));
+				std::copy_n(reinterpret_cast<const uint8_t*>(&segment_size), sizeof(segment_size), CMSG_DATA(cmsg));
+			}
+			msg_datagrams[msg_count++] = run;
+			pos += run;
+		}
+		if (!msg_count) {
+			// Single datagram with too many parts
+			break;
+		}
+		const int ret = ::sendmmsg(get_socket(), messages, msg_count, 0);
+		if (ret < 0) {
+			if (errno == EINTR) continue;
+			if (segmentation_offload_ && (errno == EIO || errno == EINVAL || errno == ENOPROTOOPT || errno == EOPNOTSUPP)) {
+				log[log::info] << "UDP segmentation offload not available, sending datagrams separately";
+				segmentation_offload_ = false;
+				continue;
+			}
+			break;
+		}
+		for (int i = 0; i < ret; ++i) {
+			sent += msg_datagrams[i];
+		}
+		if (static_cast<size_t>(ret) < msg_count) break;
+	}
+	return sent;
+}
+
+size_t YuriDatagram::do_receive_datagrams(core::socket::datagram_buffer_t* buffers, size_t max)
+{
+	mmsghdr messages[max_batch];
+	iovec iov[max_batch];
+	size_t received = 0;
+	while (received < max) {
+		const size_t batch = std::min(max - received, max_batch);
+		for (size_t i = 0; i < batch; ++i) {
+			iov[i] = { buffers[received + i].data, buffers[received + i].capacity };
+			messages[i] = mmsghdr{};
+			messages[i].msg_hdr.msg_iov = &iov[i];
+			messages[i].msg_hdr.msg_iovlen = 1;
+		}
+		const int ret = ::recvmmsg(get_socket(), messages, batch, MSG_DONTWAIT, nullptr);
+		if (ret < 0 && errno == EINTR) continue;
+		if (ret <= 0) break;
+		for (int i = 0; i < ret; ++i) {
+			buffers[received + i].size = messages[i].msg_len;
+		}
+		received += ret;
+		if (static_cast<size_t>(ret) < batch) break;
+	}
+	return received;
+}
 
 bool YuriDatagram::do_data_available()
 {
@@ -63,6 +219,20 @@ bool YuriDatagram::do_wait_for_data(duration_t duration)
 }
 
 
+bool YuriDatagram::do_enable_segmentation_offload(bool enable)
+{
+	segmentation_offload_ = false;
+	if (!enable) return true;
+	// Segment size 0 keeps the datagrams unsegmented, unless it's set for the individual sends
+	int segment_size = 0;
+	if (setsockopt(get_socket(), SOL_UDP, UDP_SEGMENT, &segment_size, sizeof(segment_size)) < 0) {
+		log[log::info] << "UDP segmentation offload not supported";
+		return false;
+	}
+	segmentation_offload_ = true;
+	return true;
+}
+
 bool YuriDatagram::do_ready_to_send() {
 	return socket_.ready_to_send();
 }
@@ -27,12 +27,19 @@ private:
 
 	virtual size_t do_send_datagram(const uint8_t* data, size_t size) override;
 	virtual size_t do_receive_datagram(uint8_t* data, size_t size) override;
+	virtual size_t do_send_datagrams(const core::socket::datagram_t* datagrams, size_t count) override;
+	virtual size_t do_send_datagram_parts(const core::socket::datagram_parts_t* datagrams, size_t count) override;
+	virtual size_t do_receive_datagrams(core::socket::datagram_buffer_t* buffers, size_t max) override;
 	virtual bool do_ready_to_send() override;
+	//! Checks that the kernel supports UDP_SEGMENT (Linux 4.18 or newer) before enabling it
+	virtual bool do_enable_segmentation_offload(bool enable) override;
 
 	virtual bool do_data_available() override;
 	virtual bool do_wait_for_data(duration_t duration) override;
 protected:
 	YuriNetSocket socket_;
+private:
+	bool segmentation_offload_;
 };
 
 }
@@ -61,6 +61,10 @@ bool YuriStreamSocket::do_wait_for_data(duration_t duration)
 {
 	return socket_.wait_for_data(duration);
 }
+int YuriStreamSocket::do_get_native_handle()
+{
+	return get_socket();
+}
 
 }
 }
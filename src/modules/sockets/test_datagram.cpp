@@ -0,0 +1,57 @@
+/*!
+ * @file 		test_datagram.cpp
+ * @author 		agent <agent@local>
+ * @date 		18.10.2026
+ * @copyright	Institute of Intermedia, CTU in Prague, 2026
+ * 				Distributed under modified BSD Licence, details in file doc/LICENSE
+ *
+ */
+
+#include "tests/catch.hpp"
+#include "YuriUdp.h"
+#include <sstream>
+
+namespace yuri {
+namespace network {
+
+TEST_CASE("udp batch send and receive", "[yuri_net]")
+{
+	std::stringstream ss;
+	log::Log l(ss);
+	const core::socket::port_t port = 47913;
+	YuriUdp receiver(l, "");
+	YuriUdp sender(l, "");
+	REQUIRE(receiver.bind("127.0.0.1", port));
+	REQUIRE(sender.connect("127.0.0.1", port));
+	// Kernels without UDP GSO fall back to sending the datagrams separately
+	sender.enable_segmentation_offload(true);
+
+	// Runs of equally sized datagrams, so some of them can be sent as a single segmented buffer
+	const std::vector<size_t> sizes = {1000, 1000, 1000, 1000, 1000, 1000, 1000, 300, 50, 50, 1200, 7, 1};
+	std::vector<std::vector<uint8_t>> data;
+	std::vector<core::socket::datagram_t> datagrams;
+	for (size_t i = 0; i < sizes.size(); ++i) {
+		data.emplace_back(sizes[i], static_cast<uint8_t>(i));
+	}
+	for (const auto& d: data) {
+		datagrams.push_back({d.data(), d.size()});
+	}
+	REQUIRE(sender.send_datagrams(datagrams) == sizes.size());
+
+	core::socket::DatagramBatch buffers(4, 2048);
+	size_t received = 0;
+	while (received < sizes.size() && receiver.wait_for_data(1_s)) {
+		const auto count = buffers.receive(receiver);
+		REQUIRE(count > 0);
+		REQUIRE(count <= buffers.capacity());
+		for (size_t i = 0; i < count; ++i, ++received) {
+			REQUIRE(buffers[i].size == sizes[received]);
+			REQUIRE(std::equal(buffers[i].data, buffers[i].data + buffers[i].size, data[received].begin()));
+		}
+	}
+	REQUIRE(received == sizes.size());
+	REQUIRE(!receiver.data_available());
+}
+
+}
+}
@@ -0,0 +1,440 @@
+/*!
+ * @file 		HttpReactor.cpp
+ * @author 		agent <agent@local>
+ * @date 		18.10.2026
+ * @copyright	Institute of Intermedia, CTU in Prague, 2026
+ * 				Distributed under modified BSD Licence, details in file doc/LICENSE
+ *
+ */
+
+#include "HttpReactor.h"
+#include "http_parser.h"
+#include "WebPageGenerator.h"
+#include <algorithm>
+#include <cerrno>
+#include <stdexcept>
+#include <fcntl.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+namespace yuri {
+namespace webserver {
+
+namespace {
+constexpr int    max_events          = 64;
+constexpr size_t read_size           = 16 * 1024;
+const duration_t idle_check_interval = 100_ms;
+
+bool set_nonblocking(int fd)
+{
+    const int flags = ::fcntl(fd, F_GETFL, 0);
+    return flags >= 0 && ::fcntl(fd, F_SETFL, flags | O_NONBLOCK) == 0;
+}
+}
+
+/*!
+ * Wakes up the event loop from other threads. It owns the eventfd, so streams
+ * holding a reference can still notify it safely after the reactor is gone.
+ */
+class HttpReactor::waker_t : public stream_listener_t {
+public:
+    waker_t() : fd(::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)) {}
+    ~waker_t() noexcept override
+    {
+        if (fd >= 0)
+            ::close(fd);
+    }
+    void notify() override
+    {
+        const uint64_t value = 1;
+        while (::write(fd, &value, sizeof(value)) < 0 && errno == EINTR) {
+        }
+    }
+    void clear()
+    {
+        uint64_t value;
+        while (::read(fd, &value, sizeof(value)) > 0) {
+        }
+    }
+    const int fd;
+};
+
+HttpReactor::output_t HttpReactor::make_output(std::string header, std::string body, std::string trailer)
+{
+    if (body.empty())
+        return output_t{ std::move(header), nullptr, nullptr, 0, std::move(trailer), 0 };
+    auto data = std::make_shared<std::string>(std::move(body));
+    return output_t{ std::move(header), data, data->data(), data->size(), std::move(trailer), 0 };
+}
+
+HttpReactor::HttpReactor(const log::Log& log_, int listen_fd, handler_t handler, reactor_config_t config)
+    : log(log_),
+      listen_fd_(listen_fd),
+      handler_(std::move(handler)),
+      config_(config),
+      epoll_fd_(::epoll_create1(EPOLL_CLOEXEC)),
+      waker_(std::make_shared<waker_t>()),
+      last_id_(0),
+      stop_(false)
+{
+    if (epoll_fd_ < 0 || waker_->fd < 0 || !set_nonblocking(listen_fd_)) {
+        if (epoll_fd_ >= 0)
+            ::close(epoll_fd_);
+        throw std::runtime_error("Failed to initialize event loop");
+    }
+    epoll_event ev{};
+    ev.events  = EPOLLIN;
+    ev.data.fd = listen_fd_;
+    ::epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, listen_fd_, &ev);
+    ev.data.fd = waker_->fd;
+    ::epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, waker_->fd, &ev);
+
+    for (size_t i = 0; i < std::max<size_t>(config_.workers, 1); ++i) {
+        workers_.emplace_back([this]() { worker(); });
+    }
+}
+
+HttpReactor::~HttpReactor() noexcept
+{
+    {
+        std::unique_lock<std::mutex> _(jobs_mutex_);
+        stop_ = true;
+        jobs_notify_.notify_all();
+    }
+    for (auto& w : workers_) {
+        w.join();
+    }
+    for (const auto& conn : connections_) {
+        ::close(conn.first);
+    }
+    ::epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, listen_fd_, nullptr);
+    ::close(epoll_fd_);
+}
+
+void HttpReactor::run_once(duration_t timeout)
+{
+    epoll_event events[max_events];
+    const int   count = ::epoll_wait(epoll_fd_, events, max_events, static_cast<int>((timeout.value + 999) / 1000));
+    for (int i = 0; i < count; ++i) {
+        const int fd = events[i].data.fd;
+        if (fd == listen_fd_) {
+            accept_connections();
+        } else if (fd == waker_->fd) {
+            waker_->clear();
+        } else {
+            auto it = connections_.find(fd);
+            if (it == connections_.end())
+                continue;
+            auto& conn = it->second;
+            if (events[i].events & EPOLLOUT) {
+                flush(conn);
+                if (connections_.find(fd) == connections_.end())
+                    continue;
+            }
+            if (events[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR)) {
+                read_data(conn);
+            }
+        }
+    }
+    process_results();
+    feed_streams();
+    close_idle_connections();
+}
+
+void HttpReactor::accept_connections()
+{
+    while (true) {
+        const int fd = ::accept4(listen_fd_, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) {
+            if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+                log[log::warning] << "Failed to accept connection";
+            }
+            if (errno == EINTR)
+                continue;
+            return;
+        }
+        epoll_event ev{};
+        ev.events  = EPOLLIN | EPOLLRDHUP;
+        ev.data.fd = fd;
+        if (::epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, fd, &ev) < 0) {
+            ::close(fd);
+            continue;
+        }
+        connections_[fd] = connection_t{ fd, ++last_id_, {}, {}, false, false, false, false, timestamp_t{}, {}, 0 };
+        log[log::debug] << "Connection accepted";
+    }
+}
+
+void HttpReactor::read_data(connection_t& conn)
+{
+    char buffer[read_size];
+    while (true) {
+        const auto count = ::recv(conn.fd, buffer, sizeof(buffer), 0);
+        if (count > 0) {
+            conn.input.append(buffer, count);
+            conn.last_activity = timestamp_t{};
+            continue;
+        }
+        if (count < 0 && errno == EINTR)
+            continue;
+        if (count < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+            break;
+        if (count < 0 || conn.read_closed) {
+            // Connection failed or hung up completely, the pending response (if any) can't be delivered anyway.
+            close_connection(conn.fd);
+            return;
+        }
+        // The peer has only shut down its side. Requests already received are still answered.
+        conn.read_closed = true;
+        update_events(conn);
+        break;
+    }
+    if (conn.stream) {
+        // Nothing else is processed on a streaming connection
+        conn.input.clear();
+        return;
+    }
+    dispatch_request(conn);
+}
+
+void HttpReactor::dispatch_request(connection_t& conn)
+{
+    if (conn.busy || conn.closing || conn.stream)
+        return;
+    request_t  request;
+    size_t     consumed = 0;
+    const auto result   = parse_request(conn.input, request, consumed);
+    if (result == parse_result_t::incomplete) {
+        if (conn.input.size() > config_.max_request_size) {
+            log[log::warning] << "Request too large, closing connection";
+            auto response = get_default_response(http_code::bad_request, "Request too large");
+            auto header   = prepare_response(response, false);
+            send_response(conn, make_output(std::move(header), std::move(response.data)), false);
+        } else if (conn.read_closed) {
+            // No other request can come, so close once the pending output is sent
+            conn.closing = true;
+            flush(conn);
+        }
+        return;
+    }
+    if (result == parse_result_t::invalid) {
+        log[log::warning] << "Failed to parse request";
+        auto response = get_default_response(http_code::bad_request);
+        auto header   = prepare_response(response, false);
+        send_response(conn, make_output(std::move(header), std::move(response.data)), false);
+        return;
+    }
+    conn.input.erase(0, consumed);
+    conn.busy             = true;
+    const bool keep_alive = keep_alive_requested(request);
+    {
+        std::unique_lock<std::mutex> _(jobs_mutex_);
+        jobs_.push_back(job_t{ conn.fd, conn.id, std::move(request), keep_alive });
+    }
+    jobs_notify_.notify_one();
+}
+
+void HttpReactor::send_response(connection_t& conn, output_t output, bool keep_alive)
+{
+    conn.output.push_back(std::move(output));
+    if (!keep_alive)
+        conn.closing = true;
+    flush(conn);
+}
+
+void HttpReactor::flush(connection_t& conn)
+{
+    while (!conn.output.empty()) {
+        auto&        out         = conn.output.front();
+        const size_t header_size = out.header.size();
+        const size_t body_end    = header_size + out.body_size;
+        iovec        iov[3];
+        int          iov_count = 0;
+        if (out.offset < header_size) {
+            iov[iov_count++] = { &out.header[out.offset], header_size - out.offset };
+        }
+        if (out.body_size && out.offset < body_end) {
+            const size_t body_offset = out.offset > header_size ? out.offset - header_size : 0;
+            iov[iov_count++]         = { const_cast<char*>(out.body) + body_offset, out.body_size - body_offset };
+        }
+        const size_t trailer_offset = out.offset > body_end ? out.offset - body_end : 0;
+        if (trailer_offset < out.trailer.size()) {
+            iov[iov_count++] = { &out.trailer[trailer_offset], out.trailer.size() - trailer_offset };
+        }
+        if (!iov_count) {
+            conn.output.pop_front();
+            continue;
+        }
+        msghdr msg{};
+        msg.msg_iov    = iov;
+        msg.msg_iovlen = iov_count;
+        const auto sent = ::sendmsg(conn.fd, &msg, MSG_NOSIGNAL);
+        if (sent < 0) {
+            if (errno == EINTR)
+                continue;
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                if (!conn.waiting_for_write) {
+                    conn.waiting_for_write = true;
+                    update_events(conn);
+                }
+                return;
+            }
+            close_connection(conn.fd);
+            return;
+        }
+        out.offset += sent;
+        conn.last_activity = timestamp_t{};
+    }
+    if (conn.waiting_for_write) {
+        conn.waiting_for_write = false;
+        update_events(conn);
+    }
+    if (conn.closing) {
+        close_connection(conn.fd);
+    }
+}
+
+void HttpReactor::update_events(connection_t& conn)
+{
+    epoll_event ev{};
+    // Hang ups and errors are reported even after the input was closed
+    if (!conn.read_closed)
+        ev.events |= EPOLLIN | EPOLLRDHUP;
+    if (conn.waiting_for_write)
+        ev.events |= EPOLLOUT;
+    ev.data.fd = conn.fd;
+    ::epoll_ctl(epoll_fd_, EPOLL_CTL_MOD, conn.fd, &ev);
+}
+
+void HttpReactor::close_connection(int fd)
+{
+    ::epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, fd, nullptr);
+    ::close(fd);
+    connections_.erase(fd);
+    streaming_.erase(fd);
+}
+
+void HttpReactor::process_results()
+{
+    std::deque<result_t> results;
+    {
+        std::unique_lock<std::mutex> _(results_mutex_);
+        std::swap(results, results_);
+    }
+    for (auto& result : results) {
+        auto it = connections_.find(result.fd);
+        // The connection may have been closed (and the descriptor reused) in the meantime
+        if (it == connections_.end() || it->second.id != result.id)
+            continue;
+        auto& conn = it->second;
+        conn.busy  = false;
+        if (result.stream) {
+            conn.stream        = std::move(result.stream);
+            conn.next_sequence = 0;
+            conn.stream->add_listener(waker_);
+            streaming_.insert(conn.fd);
+            log[log::debug] << "Starting stream";
+            send_response(conn, std::move(result.output), true);
+            continue;
+        }
+        send_response(conn, std::move(result.output), result.keep_alive);
+        // Continue with pipelined requests, if the connection is still open
+        it = connections_.find(result.fd);
+        if (it != connections_.end() && it->second.id == result.id) {
+            dispatch_request(it->second);
+        }
+    }
+}
+
+void HttpReactor::close_idle_connections()
+{
+    const timestamp_t now;
+    if (now - last_idle_check_ < idle_check_interval)
+        return;
+    last_idle_check_ = now;
+    std::vector<int> idle;
+    for (const auto& c : connections_) {
+        const auto& conn = c.second;
+        if (!conn.busy && !conn.stream && conn.output.empty() && now - conn.last_activity > config_.keepalive_timeout) {
+            idle.push_back(conn.fd);
+        }
+    }
+    for (auto fd : idle) {
+        log[log::debug] << "Closing idle connection";
+        close_connection(fd);
+    }
+}
+
+void HttpReactor::feed_streams()
+{
+    // feed_stream() may close the connection, so iterate over a copy
+    const std::vector<int> fds(streaming_.begin(), streaming_.end());
+    for (auto fd : fds) {
+        auto it = connections_.find(fd);
+        if (it != connections_.end())
+            feed_stream(it->second);
+    }
+}
+
+void HttpReactor::feed_stream(connection_t& conn)
+{
+    const int  fd   = conn.fd;
+    const auto mode = conn.stream->get_mode();
+    while (!conn.closing && conn.output.empty()) {
+        stream_chunk_t chunk;
+        const auto     result = conn.stream->get_next(conn.next_sequence, chunk);
+        if (result == HttpStream::next_result_t::none)
+            return;
+        if (result == HttpStream::next_result_t::closed) {
+            send_response(conn, make_output(prepare_stream_end(mode)), false);
+            return;
+        }
+        auto header = prepare_chunk_header(mode, chunk);
+        conn.output.push_back(output_t{ std::move(header), std::move(chunk.owner), reinterpret_cast<const char*>(chunk.data), chunk.size,
+                                        prepare_chunk_trailer(mode), 0 });
+        flush(conn);
+        // The connection could have been closed while sending
+        if (connections_.find(fd) == connections_.end())
+            return;
+    }
+}
+
+void HttpReactor::worker()
+{
+    while (true) {
+        job_t job;
+        {
+            std::unique_lock<std::mutex> lock(jobs_mutex_);
+            jobs_notify_.wait(lock, [this]() { return stop_ || !jobs_.empty(); });
+            if (stop_)
+                return;
+            job = std::move(jobs_.front());
+            jobs_.pop_front();
+        }
+        response_t response;
+        try {
+            response = handler_(job.request);
+        } catch (std::exception& e) {
+            log[log::warning] << "Failed to process request for " << job.request.url.path << " (" << e.what() << ")";
+            response = get_default_response(http_code::server_error, e.what());
+        }
+        result_t result{ job.fd, job.id, {}, job.keep_alive, std::move(response.stream) };
+        if (result.stream) {
+            response.stream = result.stream;
+            result.output   = make_output(prepare_stream_response(response));
+        } else {
+            auto header   = prepare_response(response, job.keep_alive);
+            result.output = make_output(std::move(header), std::move(response.data));
+        }
+        {
+            std::unique_lock<std::mutex> _(results_mutex_);
+            results_.push_back(std::move(result));
+        }
+        waker_->notify();
+    }
+}
+}
+}
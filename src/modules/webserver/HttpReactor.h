@@ -0,0 +1,148 @@
+/*!
+ * @file 		HttpReactor.h
+ * @author 		agent <agent@local>
+ * @date 		18.10.2026
+ * @copyright	Institute of Intermedia, CTU in Prague, 2026
+ * 				Distributed under modified BSD Licence, details in file doc/LICENSE
+ *
+ */
+
+#ifndef SRC_MODULES_WEBSERVER_HTTPREACTOR_H_
+#define SRC_MODULES_WEBSERVER_HTTPREACTOR_H_
+
+#include "common_types.h"
+#include "HttpStream.h"
+#include "yuri/log/Log.h"
+#include "yuri/core/utils/time_types.h"
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace yuri {
+namespace webserver {
+
+struct reactor_config_t {
+    //! Number of threads processing the requests
+    size_t     workers           = 4;
+    //! Idle keep-alive connections are closed after this time
+    duration_t keepalive_timeout = 5_s;
+    //! Maximal size of request header and body
+    size_t     max_request_size  = 1024 * 1024;
+};
+
+/*!
+ * Non-blocking HTTP/1.1 server loop based on epoll.
+ *
+ * All socket IO is done in the thread calling run_once(). Parsed requests are
+ * passed to a fixed pool of worker threads running the handler. Connections are
+ * kept open unless the client asks otherwise. Pipelined requests are processed
+ * one after another, so the responses are sent in the same order.
+ *
+ * Responses with a stream keep the connection open and send the chunks published
+ * to the stream. A connection has at most one chunk queued, so slow clients skip
+ * chunks instead of buffering them.
+ */
+class HttpReactor {
+public:
+    using handler_t = std::function<response_t(const request_t&)>;
+
+    /*!
+     * @param listen_fd	Listening socket. It's switched to non-blocking mode, but not closed by the reactor.
+     */
+    HttpReactor(const log::Log& log_, int listen_fd, handler_t handler, reactor_config_t config = {});
+    ~HttpReactor() noexcept;
+    HttpReactor(const HttpReactor&) = delete;
+    HttpReactor& operator=(const HttpReactor&) = delete;
+
+    //! Waits at most @em timeout for events and processes them
+    void run_once(duration_t timeout);
+
+    size_t connection_count() const { return connections_.size(); }
+
+private:
+    class waker_t;
+    //! Data sent as header, body and trailer. The body is shared, not owned by the output.
+    struct output_t {
+        std::string                 header;
+        std::shared_ptr<const void> owner;
+        const char*                 body;
+        size_t                      body_size;
+        std::string                 trailer;
+        size_t                      offset;
+    };
+    struct connection_t {
+        int                  fd;
+        uint64_t             id;
+        std::string          input;
+        std::deque<output_t> output;
+        //! A request from this connection is being processed by a worker
+        bool                 busy;
+        //! Close the connection once the output is sent
+        bool                 closing;
+        //! The peer has shut down its side, no more input will come
+        bool                 read_closed;
+        bool                 waiting_for_write;
+        timestamp_t          last_activity;
+        //! Stream sent over this connection (if any)
+        pHttpStream          stream;
+        uint64_t             next_sequence;
+    };
+    struct job_t {
+        int       fd;
+        uint64_t  id;
+        request_t request;
+        bool      keep_alive;
+    };
+    struct result_t {
+        int      fd;
+        uint64_t id;
+        output_t    output;
+        bool        keep_alive;
+        pHttpStream stream;
+    };
+
+    static output_t make_output(std::string header, std::string body = {}, std::string trailer = {});
+
+    void accept_connections();
+    void read_data(connection_t& conn);
+    void dispatch_request(connection_t& conn);
+    void send_response(connection_t& conn, output_t output, bool keep_alive);
+    void flush(connection_t& conn);
+    //! Updates the events watched for the connection
+    void update_events(connection_t& conn);
+    void close_connection(int fd);
+    void process_results();
+    void close_idle_connections();
+    //! Queues next chunk for connections with a stream, that have sent everything already
+    void feed_streams();
+    void feed_stream(connection_t& conn);
+    void worker();
+
+    log::Log                                log;
+    int                                     listen_fd_;
+    handler_t                               handler_;
+    reactor_config_t                        config_;
+    int                                     epoll_fd_;
+    std::shared_ptr<waker_t>                waker_;
+    uint64_t                                last_id_;
+    timestamp_t                             last_idle_check_;
+    std::unordered_map<int, connection_t>   connections_;
+    std::unordered_set<int>                 streaming_;
+
+    std::mutex              jobs_mutex_;
+    std::condition_variable jobs_notify_;
+    std::deque<job_t>       jobs_;
+    bool                    stop_;
+    std::mutex              results_mutex_;
+    std::deque<result_t>    results_;
+    std::vector<std::thread> workers_;
+};
+}
+}
+
+#endif /* SRC_MODULES_WEBSERVER_HTTPREACTOR_H_ */
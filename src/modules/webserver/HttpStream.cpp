@@ -0,0 +1,163 @@
+/*!
+ * @file 		HttpStream.cpp
+ * @author 		agent <agent@local>
+ * @date 		18.10.2026
+ * @copyright	Institute of Intermedia, CTU in Prague, 2026
+ * 				Distributed under modified BSD Licence, details in file doc/LICENSE
+ *
+ */
+
+#include "HttpStream.h"
+#include "http_parser.h"
+#include "WebPageGenerator.h"
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <cstring>
+
+namespace yuri {
+namespace webserver {
+
+namespace {
+const std::string crlf = "\r\n";
+
+bool is_one_of(const std::string& name, std::initializer_list<const char*> names)
+{
+    return std::any_of(names.begin(), names.end(), [&name](const char* n) {
+        return std::equal(name.begin(), name.end(), n, n + std::strlen(n), [](char x, char y) { return std::tolower(x) == std::tolower(y); });
+    });
+}
+}
+
+const std::string stream_boundary = "yuriframe";
+
+HttpStream::HttpStream(stream_mode_t mode, std::string content_type, size_t backlog)
+    : mode_(mode), content_type_(std::move(content_type)), backlog_(std::max<size_t>(backlog, 1)), sequence_(0), closed_(false)
+{
+}
+
+void HttpStream::publish(std::shared_ptr<const void> owner, const uint8_t* data, size_t size, std::string content_type, bool sync_point)
+{
+    // Empty chunk would end a chunked body
+    if (!size)
+        return;
+    std::vector<std::shared_ptr<stream_listener_t>> listeners;
+    {
+        std::unique_lock<std::mutex> _(mutex_);
+        if (closed_)
+            return;
+        chunks_.push_back(
+            stream_chunk_t{ std::move(owner), data, size, content_type.empty() ? content_type_ : std::move(content_type), ++sequence_, sync_point });
+        while (chunks_.size() > backlog_) {
+            chunks_.pop_front();
+        }
+        listeners.reserve(listeners_.size());
+        for (const auto& l : listeners_) {
+            if (auto listener = l.lock())
+                listeners.push_back(std::move(listener));
+        }
+        if (listeners.size() != listeners_.size()) {
+            listeners_.assign(listeners.begin(), listeners.end());
+        }
+    }
+    // Notify without holding the lock, listeners may call get_next() right away
+    for (const auto& listener : listeners) {
+        listener->notify();
+    }
+}
+
+void HttpStream::close()
+{
+    std::vector<std::weak_ptr<stream_listener_t>> listeners;
+    {
+        std::unique_lock<std::mutex> _(mutex_);
+        if (closed_)
+            return;
+        closed_ = true;
+        std::swap(listeners, listeners_);
+    }
+    for (const auto& l : listeners) {
+        if (auto listener = l.lock())
+            listener->notify();
+    }
+}
+
+HttpStream::next_result_t HttpStream::get_next(uint64_t& next_sequence, stream_chunk_t& chunk) const
+{
+    std::unique_lock<std::mutex> _(mutex_);
+    if (!chunks_.empty() && next_sequence >= chunks_.front().sequence && next_sequence <= chunks_.back().sequence) {
+        chunk         = chunks_[next_sequence - chunks_.front().sequence];
+        next_sequence = chunk.sequence + 1;
+        return next_result_t::chunk;
+    }
+    if (!chunks_.empty() && next_sequence < chunks_.front().sequence) {
+        // The client fell behind the backlog (or just connected), so it continues with the latest chunk it can decode from
+        const auto it = std::find_if(chunks_.rbegin(), chunks_.rend(), [](const stream_chunk_t& c) { return c.sync_point; });
+        if (it != chunks_.rend()) {
+            chunk         = *it;
+            next_sequence = chunk.sequence + 1;
+            return next_result_t::chunk;
+        }
+    }
+    return closed_ ? next_result_t::closed : next_result_t::none;
+}
+
+void HttpStream::add_listener(const std::shared_ptr<stream_listener_t>& listener)
+{
+    std::unique_lock<std::mutex> _(mutex_);
+    const auto it = std::find_if(listeners_.begin(), listeners_.end(), [&listener](const std::weak_ptr<stream_listener_t>& l) {
+        return !l.owner_before(listener) && !listener.owner_before(l);
+    });
+    if (it == listeners_.end())
+        listeners_.push_back(listener);
+}
+
+std::string prepare_stream_response(const response_t& response)
+{
+    const auto  mode   = response.stream->get_mode();
+    std::string header = prepare_response_header(response.code) + crlf;
+    for (const auto& param : response.parameters) {
+        if (is_one_of(param.first, { "Connection", "Content-Length", "Transfer-Encoding" }))
+            continue;
+        header += param.first + ": " + param.second + crlf;
+    }
+    if (!find_header(response.parameters, "Content-Type")) {
+        header += "Content-Type: ";
+        header += mode == stream_mode_t::multipart ? "multipart/x-mixed-replace; boundary=" + stream_boundary
+                                                   : response.stream->get_content_type();
+        header += crlf;
+    }
+    if (!find_header(response.parameters, "Cache-Control")) {
+        header += "Cache-Control: no-cache, no-store" + crlf;
+    }
+    if (mode == stream_mode_t::chunked) {
+        header += "Transfer-Encoding: chunked" + crlf;
+    }
+    header += "Connection: close" + crlf + crlf;
+    return header;
+}
+
+std::string prepare_chunk_header(stream_mode_t mode, const stream_chunk_t& chunk)
+{
+    if (mode == stream_mode_t::multipart) {
+        return "--" + stream_boundary + crlf + "Content-Type: " + chunk.content_type + crlf + "Content-Length: " + std::to_string(chunk.size)
+             + crlf + crlf;
+    }
+    char size[20];
+    std::snprintf(size, sizeof(size), "%zx", chunk.size);
+    return size + crlf;
+}
+
+std::string prepare_chunk_trailer(stream_mode_t)
+{
+    return crlf;
+}
+
+std::string prepare_stream_end(stream_mode_t mode)
+{
+    if (mode == stream_mode_t::multipart)
+        return "--" + stream_boundary + "--" + crlf;
+    return "0" + crlf + crlf;
+}
+}
+}
@@ -0,0 +1,116 @@
+/*!
+ * @file 		HttpStream.h
+ * @author 		agent <agent@local>
+ * @date 		18.10.2026
+ * @copyright	Institute of Intermedia, CTU in Prague, 2026
+ * 				Distributed under modified BSD Licence, details in file doc/LICENSE
+ *
+ */
+
+#ifndef SRC_MODULES_WEBSERVER_HTTPSTREAM_H_
+#define SRC_MODULES_WEBSERVER_HTTPSTREAM_H_
+
+#include "common_types.h"
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace yuri {
+namespace webserver {
+
+enum class stream_mode_t {
+    //! Every chunk is sent as a part of multipart/x-mixed-replace response (MJPEG)
+    multipart,
+    //! Chunks are concatenated into a single body sent with chunked transfer encoding
+    chunked
+};
+
+struct stream_chunk_t {
+    //! Keeps @em data alive while the chunk is being sent
+    std::shared_ptr<const void> owner;
+    const uint8_t*              data;
+    size_t                      size;
+    std::string                 content_type;
+    uint64_t                    sequence;
+    //! Clients can start receiving the stream with this chunk (e.g. it starts with a key frame)
+    bool                        sync_point;
+};
+
+//! Gets notified from the publishing thread, when a new chunk is available
+class stream_listener_t {
+public:
+    virtual ~stream_listener_t() noexcept = default;
+    virtual void notify()                 = 0;
+};
+
+/*!
+ * Source of data for long lived streaming responses.
+ *
+ * A resource publishes chunks (typically whole frames) and all connections subscribed
+ * to the stream send them. The data are not copied, every connection only holds
+ * a reference to the chunk it's currently sending.
+ *
+ * Only last @em backlog chunks are kept. Clients that are not able to keep up
+ * skip directly to the latest sync point instead of slowing down the publisher.
+ * New clients start at the latest sync point as well.
+ */
+class HttpStream {
+public:
+    enum class next_result_t { chunk, none, closed };
+
+    HttpStream(stream_mode_t mode, std::string content_type, size_t backlog = 1);
+    ~HttpStream() noexcept = default;
+    HttpStream(const HttpStream&) = delete;
+    HttpStream& operator=(const HttpStream&) = delete;
+
+    stream_mode_t      get_mode() const { return mode_; }
+    const std::string& get_content_type() const { return content_type_; }
+
+    /*!
+     * Publishes new chunk. @em owner has to keep @em data valid.
+     * @param sync_point	Clients may start with this chunk. Producers of streams that can't be decoded
+     * 						from any chunk (e.g. H.264) set it only for chunks starting with a key frame or parameter sets.
+     */
+    void publish(std::shared_ptr<const void> owner, const uint8_t* data, size_t size, std::string content_type = {}, bool sync_point = true);
+    //! Marks end of the stream, the connections are closed once they send the remaining data.
+    void close();
+
+    /*!
+     * Returns the chunk a client should send next.
+     *
+     * @param next_sequence	Sequence number of the chunk the client expects. Updated when a chunk is returned.
+     */
+    next_result_t get_next(uint64_t& next_sequence, stream_chunk_t& chunk) const;
+
+    //! Registers a listener. The listener is removed automatically when it expires.
+    void add_listener(const std::shared_ptr<stream_listener_t>& listener);
+
+private:
+    const stream_mode_t                          mode_;
+    const std::string                            content_type_;
+    const size_t                                 backlog_;
+    mutable std::mutex                           mutex_;
+    std::deque<stream_chunk_t>                   chunks_;
+    uint64_t                                     sequence_;
+    bool                                         closed_;
+    std::vector<std::weak_ptr<stream_listener_t>> listeners_;
+};
+
+using pHttpStream = std::shared_ptr<HttpStream>;
+
+//! Boundary separating parts of multipart streams
+extern const std::string stream_boundary;
+
+//! Prepares status line and header of a streaming response.
+std::string prepare_stream_response(const response_t& response);
+//! Prepares data preceding @em chunk in the response body
+std::string prepare_chunk_header(stream_mode_t mode, const stream_chunk_t& chunk);
+//! Prepares data following @em chunk in the response body
+std::string prepare_chunk_trailer(stream_mode_t mode);
+//! Prepares data ending the response body
+std::string prepare_stream_end(stream_mode_t mode);
+}
+}
+
+#endif /* SRC_MODULES_WEBSERVER_HTTPSTREAM_H_ */
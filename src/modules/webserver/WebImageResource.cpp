@@ -53,8 +53,11 @@ core::pFrame WebImageResource::do_special_single_step(core::pCompressedVideoFram
 {
     {
         std::unique_lock<std::mutex> _(frame_lock_);
+        // Frames marked as unchanged keep the etag, so clients can reuse their cached image
+        if (!last_frame_ || frame->is_damaged()) {
+            etag_ = distribution_(rnd_generator_);
+        }
         last_frame_ = frame;
-        etag_       = distribution_(rnd_generator_);
     }
     return frame;
 }
@@ -64,13 +67,15 @@ webserver::response_t WebImageResource::do_process_request(const webserver::requ
     core::pCompressedVideoFrame frame;
     auto                        it       = request.parameters.find("If-None-Match");
     uint64_t                    req_etag = (it != request.parameters.end()) ? lexical_cast<uint64_t>(it->second) : 0UL;
-
+    uint64_t                    etag     = 0;
     {
         std::unique_lock<std::mutex> _(frame_lock_);
-        if (req_etag == etag_) {
-            log[log::info] << "Returning 304, server already hs the latest image";
-        }
         frame = last_frame_;
+        etag  = etag_;
+    }
+    if (frame && req_etag == etag) {
+        log[log::debug] << "Returning 304, client already has the latest image";
+        throw not_modified(path_);
     }
 
     if (!frame)
@@ -80,7 +85,7 @@ webserver::response_t WebImageResource::do_process_request(const webserver::requ
     const std::string mime = fi.mime_types.empty() ? "image/jpeg" : fi.mime_types[0];
     return response_t{ http_code::ok,
                        { { "Content-Encoding", mime },
-                         { "Etag", std::to_string(etag_) },
+                         { "Etag", std::to_string(etag) },
                          { "Cache-Control", "must-revalidate, no-cache" }, //, no-store, must-revalidate"},
                          { "Pragma", "no-cache" },
                          { "Expires", "0" } },
@@ -124,7 +124,7 @@ url_t parse_url(const std::string& uri, const std::string& host)
 {
     url_t url;
     url.host = host;
-    boost::regex url_line("^([^?&#]+)");
+    static const boost::regex url_line("^([^?&#]+)");
 
     boost::smatch what;
     auto          start = uri.cbegin();
@@ -132,7 +132,7 @@ url_t parse_url(const std::string& uri, const std::string& host)
     if (regex_search(start, end, what, url_line, boost::match_default)) {
         url.path                    = std::string(what[1].first, what[1].second);
         auto                   next = what[0].second;
-        boost::regex           param_line("[?&]([^&=#]+)(=([^&#]+))?");
+        static const boost::regex param_line("[?&]([^&=#]+)(=([^&#]+))?");
         boost::sregex_iterator i(next, end, param_line, boost::match_default);
         boost::sregex_iterator j;
         while (i != j) {
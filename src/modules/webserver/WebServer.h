@@ -15,18 +15,12 @@
 #include "yuri/core/socket/StreamSocket.h"
 #include "common_types.h"
 #include "web_exceptions.h"
-#include <future>
-#include <deque>
-#include <condition_variable>
-#include <tuple>
+#include "HttpReactor.h"
+#include <boost/regex.hpp>
+#include <memory>
 namespace yuri {
 namespace webserver {
 
-struct client_info_t {
-    core::socket::pStreamSocket socket_;
-    std::future<response_t>     response_;
-};
-
 class WebServer;
 using pWebServer  = std::shared_ptr<WebServer>;
 using pwWebServer = std::weak_ptr<WebServer>;
@@ -39,11 +33,11 @@ pwWebServer find_webserver(const std::string& name);
 
 struct route_record {
     std::string  routing_spec;
+    //! routing_spec compiled in register_resource()
+    boost::regex regex;
     pWebResource resource;
 };
 
-using f_request_t = std::future<bool>;
-
 class WebServer : public core::IOThread {
 public:
     IOTHREAD_GENERATOR_DECLARATION
@@ -56,18 +50,13 @@ private:
     virtual void run() override;
     virtual bool set_param(const core::Parameter& param) override;
 
-    request_t read_request(core::socket::pStreamSocket socket);
-    bool reply_to_client(core::socket::pStreamSocket& socket, response_t response);
-    response_t auth_response(request_t request);
-    response_t find_response(request_t request);
+    response_t auth_response(const request_t& request);
+    response_t find_response(const request_t& request);
 
-    void response_thread();
-    void push_request(f_request_t request);
-    f_request_t pop_request();
     bool        authentication_needed();
     bool        verify_authentication(const request_t&);
 
-    bool process_request(core::socket::pStreamSocket client);
+    response_t process_request(const request_t& request);
     std::string server_name_;
     std::string socket_impl_;
     std::string address_;
@@ -76,15 +65,11 @@ private:
     std::string user_;
     std::string pass_;
     bool        cors_;
+    reactor_config_t reactor_config_;
 
     core::socket::pStreamSocket socket_;
     std::vector<route_record>   routing_;
     std::mutex                  routing_mutex_;
-
-    std::deque<f_request_t> requests_;
-    std::mutex              request_mutex_;
-
-    std::condition_variable request_notify_;
 };
 
 } /* namespace webserver */
@@ -0,0 +1,147 @@
+/*!
+ * @file 		WebStreamResource.cpp
+ * @author 		agent <agent@local>
+ * @date 		18.10.2026
+ * @copyright	Institute of Intermedia, CTU in Prague, 2026
+ * 				Distributed under modified BSD Licence, details in file doc/LICENSE
+ *
+ */
+#include "WebStreamResource.h"
+#include "yuri/core/Module.h"
+#include "yuri/core/frame/compressed_frame_types.h"
+#include "yuri/core/frame/compressed_frame_params.h"
+#include <algorithm>
+namespace yuri {
+namespace webserver {
+
+IOTHREAD_GENERATOR(WebStreamResource)
+
+namespace {
+bool is_image(format_t format)
+{
+    return format == core::compressed_frame::jpeg || format == core::compressed_frame::mjpg || format == core::compressed_frame::png;
+}
+
+/*!
+ * Checks whether clients can start decoding with the frame.
+ * H.264 and H.265 frames have to start with parameter sets or a key frame,
+ * other formats are assumed to be decodable from any frame.
+ */
+bool is_sync_point(format_t format, const uint8_t* data, size_t size)
+{
+    if (format != core::compressed_frame::h264 && format != core::compressed_frame::h265)
+        return true;
+    // Parameter sets and key frames follow at most few small NAL units (AUD, SEI)
+    const auto end = std::min<size_t>(size, 256);
+    for (size_t i = 0; i + 3 < end; ++i) {
+        if (data[i] != 0 || data[i + 1] != 0 || data[i + 2] != 1)
+            continue;
+        const auto nal = data[i + 3];
+        if (format == core::compressed_frame::h264) {
+            const auto type = nal & 0x1F;
+            if (type == 5 || type == 7)
+                return true;
+        } else {
+            const auto type = (nal >> 1) & 0x3F;
+            if ((type >= 16 && type <= 21) || type == 32)
+                return true;
+        }
+    }
+    return false;
+}
+
+std::string get_mime_type(format_t format)
+{
+    const auto& fi = core::compressed_frame::get_format_info(format);
+    if (!fi.mime_types.empty())
+        return fi.mime_types[0];
+    if (format == core::compressed_frame::mpeg2ts)
+        return "video/mp2t";
+    return "application/octet-stream";
+}
+}
+
+core::Parameters WebStreamResource::configure()
+{
+    core::Parameters p = base_type::configure();
+    p.set_description("Streams frames to web clients. JPEG/PNG as multipart (MJPEG), other formats with chunked transfer encoding.");
+    p["server_name"]["Name of server"] = "webserver";
+    p["path"]["Path of the resource"]  = "/stream";
+    p["backlog"]["Number of frames kept for clients of chunked streams. Clients falling behind more than this skip to the latest key frame."] = 32;
+    return p;
+}
+
+WebStreamResource::WebStreamResource(const log::Log& log_, core::pwThreadBase parent, const core::Parameters& parameters)
+    : base_type(log_, parent, std::string("web_stream")), WebResource(log_), server_name_("webserver"), path_("/stream"), backlog_(32), format_(0)
+{
+    IOTHREAD_INIT(parameters)
+}
+
+WebStreamResource::~WebStreamResource() noexcept
+{
+    std::unique_lock<std::mutex> _(stream_lock_);
+    if (stream_)
+        stream_->close();
+}
+
+void WebStreamResource::run()
+{
+    while (still_running() && !register_to_server(server_name_, path_, std::dynamic_pointer_cast<WebResource>(get_this_ptr()))) {
+        sleep(10_ms);
+    }
+    log[log::info] << "Registered to server";
+    base_type::run();
+    std::unique_lock<std::mutex> _(stream_lock_);
+    if (stream_)
+        stream_->close();
+}
+
+core::pFrame WebStreamResource::do_special_single_step(core::pCompressedVideoFrame frame)
+{
+    pHttpStream stream;
+    {
+        std::unique_lock<std::mutex> _(stream_lock_);
+        const auto format = frame->get_format();
+        if (!stream_ || format != format_) {
+            // Clients of the old stream can't continue with a different format
+            if (stream_)
+                stream_->close();
+            const auto image = is_image(format);
+            log[log::info] << "Streaming " << core::compressed_frame::get_format_name(format) << (image ? " as multipart" : " as chunked data");
+            stream_ = std::make_shared<HttpStream>(image ? stream_mode_t::multipart : stream_mode_t::chunked, get_mime_type(format),
+                                                   image ? 1 : backlog_);
+            format_ = format;
+        }
+        stream = stream_;
+    }
+    // The frame itself keeps the data alive, so all clients send the same buffer
+    stream->publish(frame, frame->data(), frame->size(), {}, is_sync_point(frame->get_format(), frame->data(), frame->size()));
+    return frame;
+}
+
+webserver::response_t WebStreamResource::do_process_request(const webserver::request_t&)
+{
+    pHttpStream stream;
+    {
+        std::unique_lock<std::mutex> _(stream_lock_);
+        stream = stream_;
+    }
+    if (!stream)
+        throw std::runtime_error("Stream not available yet");
+    log[log::debug] << "New client";
+    return response_t{ http_code::ok, { { "Pragma", "no-cache" } }, {}, stream };
+}
+
+bool WebStreamResource::set_param(const core::Parameter& param)
+{
+    if (assign_parameters(param)      //
+        (server_name_, "server_name") //
+        (path_, "path")               //
+        (backlog_, "backlog")) {
+        return true;
+    }
+    return base_type::set_param(param);
+}
+
+} /* namespace webserver */
+} /* namespace yuri */
@@ -0,0 +1,51 @@
+/*!
+ * @file 		WebStreamResource.h
+ * @author 		agent <agent@local>
+ * @date 		18.10.2026
+ * @copyright	Institute of Intermedia, CTU in Prague, 2026
+ * 				Distributed under modified BSD Licence, details in file doc/LICENSE
+ *
+ */
+
+#ifndef SRC_MODULES_WEBSERVER_WEBSTREAMRESOURCE_H_
+#define SRC_MODULES_WEBSERVER_WEBSTREAMRESOURCE_H_
+
+#include "yuri/core/thread/SpecializedIOFilter.h"
+#include "yuri/core/frame/CompressedVideoFrame.h"
+#include "WebResource.h"
+#include "HttpStream.h"
+
+namespace yuri {
+namespace webserver {
+
+/*!
+ * Pushes incoming frames to all connected clients.
+ *
+ * JPEG and PNG frames are sent as multipart/x-mixed-replace (MJPEG),
+ * other formats (H.264, MPEG TS, ...) as a single chunked body.
+ */
+class WebStreamResource : public core::SpecializedIOFilter<core::CompressedVideoFrame>, public WebResource {
+    using base_type = core::SpecializedIOFilter<core::CompressedVideoFrame>;
+
+public:
+    IOTHREAD_GENERATOR_DECLARATION
+    static core::Parameters configure();
+    WebStreamResource(const log::Log& log_, core::pwThreadBase parent, const core::Parameters& parameters);
+    virtual ~WebStreamResource() noexcept;
+
+private:
+    virtual void         run() override;
+    virtual core::pFrame do_special_single_step(core::pCompressedVideoFrame frame) override;
+    virtual bool set_param(const core::Parameter& param) override;
+    virtual webserver::response_t do_process_request(const webserver::request_t& request) override;
+    std::string  server_name_;
+    std::string  path_;
+    size_t       backlog_;
+    format_t     format_;
+    pHttpStream  stream_;
+    std::mutex   stream_lock_;
+};
+}
+}
+
+#endif /* SRC_MODULES_WEBSERVER_WEBSTREAMRESOURCE_H_ */
@@ -12,6 +12,7 @@
 #define SRC_MODULES_WEBSERVER_COMMON_TYPES_H_
 #include <string>
 #include <map>
+#include <memory>
 #include "yuri/core/socket/StreamSocket.h"
 
 namespace yuri {
@@ -36,6 +37,8 @@ enum class http_code {
     service_unavailable = 503
 };
 
+class HttpStream;
+
 using parameters_t = std::map<std::string, std::string>;
 
 struct url_t {
@@ -55,12 +58,16 @@ struct request_t {
     parameters_t                parameters;
     std::string                 method;
     core::socket::pStreamSocket client;
+    std::string                 version;
+    std::string                 body;
 };
 
 struct response_t {
     http_code    code;
     parameters_t parameters;
     std::string  data;
+    //! When set, the connection is kept open and data from the stream are sent instead of @em data
+    std::shared_ptr<HttpStream> stream = {};
 };
 }
 }
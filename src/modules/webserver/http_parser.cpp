@@ -0,0 +1,170 @@
+/*!
+ * @file 		http_parser.cpp
+ * @author 		agent <agent@local>
+ * @date 		18.10.2026
+ * @copyright	Institute of Intermedia, CTU in Prague, 2026
+ * 				Distributed under modified BSD Licence, details in file doc/LICENSE
+ *
+ */
+
+#include "http_parser.h"
+#include "WebPageGenerator.h"
+#include <algorithm>
+#include <cctype>
+
+namespace yuri {
+namespace webserver {
+
+namespace {
+const std::string crlf = "\r\n";
+
+bool iequals(const std::string& a, const std::string& b)
+{
+    return a.size() == b.size()
+        && std::equal(a.begin(), a.end(), b.begin(), [](char x, char y) { return std::tolower(x) == std::tolower(y); });
+}
+
+bool icontains(const std::string& haystack, const std::string& needle)
+{
+    return std::search(haystack.begin(), haystack.end(), needle.begin(), needle.end(), [](char x, char y) {
+               return std::tolower(x) == std::tolower(y);
+           })
+        != haystack.end();
+}
+
+std::string trim(const std::string& str)
+{
+    const auto first = str.find_first_not_of(" \t");
+    if (first == std::string::npos)
+        return {};
+    const auto last = str.find_last_not_of(" \t");
+    return str.substr(first, last - first + 1);
+}
+
+/*!
+ * Finds end of the request header. Empty line may be terminated with either \r\n or just \n.
+ * @return position after the empty line or npos
+ */
+size_t find_header_end(const std::string& data, size_t start)
+{
+    for (auto pos = data.find('\n', start); pos != std::string::npos; pos = data.find('\n', pos + 1)) {
+        if (pos + 1 < data.size() && data[pos + 1] == '\n')
+            return pos + 2;
+        if (pos + 2 < data.size() && data[pos + 1] == '\r' && data[pos + 2] == '\n')
+            return pos + 3;
+    }
+    return std::string::npos;
+}
+
+//! Returns the line starting at @em pos without line terminator and moves @em pos after it
+std::string get_line(const std::string& data, size_t& pos)
+{
+    const auto end = data.find('\n', pos);
+    auto       len = end - pos;
+    if (len > 0 && data[end - 1] == '\r')
+        --len;
+    auto line = data.substr(pos, len);
+    pos       = end + 1;
+    return line;
+}
+
+bool parse_request_line(const std::string& line, request_t& request)
+{
+    const auto method_end = line.find(' ');
+    if (method_end == std::string::npos || method_end == 0)
+        return false;
+    const auto target_end = line.rfind(' ');
+    if (target_end == method_end)
+        return false;
+    request.method = line.substr(0, method_end);
+    if (!std::all_of(request.method.begin(), request.method.end(), [](char c) { return c >= 'A' && c <= 'Z'; }))
+        return false;
+    request.version = line.substr(target_end + 1);
+    if (request.version != "HTTP/1.1" && request.version != "HTTP/1.0")
+        return false;
+    const auto target = line.substr(method_end + 1, target_end - method_end - 1);
+    if (target.empty())
+        return false;
+    request.url = parse_url(target);
+    return true;
+}
+}
+
+parse_result_t parse_request(const std::string& data, request_t& request, size_t& consumed)
+{
+    // Empty lines before request line should be ignored
+    const auto start = data.find_first_not_of("\r\n");
+    if (start == std::string::npos)
+        return parse_result_t::incomplete;
+    const auto header_end = find_header_end(data, start);
+    if (header_end == std::string::npos)
+        return parse_result_t::incomplete;
+
+    size_t pos = start;
+    if (!parse_request_line(get_line(data, pos), request))
+        return parse_result_t::invalid;
+
+    request.parameters.clear();
+    while (pos < header_end) {
+        const auto line = get_line(data, pos);
+        if (line.empty())
+            break;
+        const auto colon = line.find(':');
+        if (colon == std::string::npos || colon == 0)
+            return parse_result_t::invalid;
+        request.parameters[line.substr(0, colon)] = trim(line.substr(colon + 1));
+    }
+
+    if (find_header(request.parameters, "Transfer-Encoding"))
+        return parse_result_t::invalid;
+
+    size_t body_size = 0;
+    if (const auto length = find_header(request.parameters, "Content-Length")) {
+        if (length->empty() || length->size() > 18 || !std::all_of(length->begin(), length->end(), [](char c) { return c >= '0' && c <= '9'; }))
+            return parse_result_t::invalid;
+        body_size = std::stoull(*length);
+    }
+    if (data.size() - header_end < body_size)
+        return parse_result_t::incomplete;
+    request.body = data.substr(header_end, body_size);
+    consumed     = header_end + body_size;
+    return parse_result_t::complete;
+}
+
+const std::string* find_header(const parameters_t& parameters, const std::string& name)
+{
+    auto it = parameters.find(name);
+    if (it != parameters.end())
+        return &it->second;
+    for (const auto& p : parameters) {
+        if (iequals(p.first, name))
+            return &p.second;
+    }
+    return nullptr;
+}
+
+bool keep_alive_requested(const request_t& request)
+{
+    const auto connection = find_header(request.parameters, "Connection");
+    if (request.version == "HTTP/1.1")
+        return !connection || !icontains(*connection, "close");
+    return connection && icontains(*connection, "keep-alive");
+}
+
+std::string prepare_response(const response_t& response, bool keep_alive)
+{
+    std::string header = prepare_response_header(response.code) + crlf;
+    for (const auto& param : response.parameters) {
+        if (iequals(param.first, "Connection"))
+            continue;
+        header += param.first + ": " + param.second + crlf;
+    }
+    if (!find_header(response.parameters, "Content-Length")) {
+        header += "Content-Length: " + std::to_string(response.data.size()) + crlf;
+    }
+    header += keep_alive ? "Connection: keep-alive" : "Connection: close";
+    header += crlf + crlf;
+    return header;
+}
+}
+}
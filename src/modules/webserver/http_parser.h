@@ -0,0 +1,51 @@
+/*!
+ * @file 		http_parser.h
+ * @author 		agent <agent@local>
+ * @date 		18.10.2026
+ * @copyright	Institute of Intermedia, CTU in Prague, 2026
+ * 				Distributed under modified BSD Licence, details in file doc/LICENSE
+ *
+ */
+
+#ifndef SRC_MODULES_WEBSERVER_HTTP_PARSER_H_
+#define SRC_MODULES_WEBSERVER_HTTP_PARSER_H_
+
+#include "common_types.h"
+
+namespace yuri {
+namespace webserver {
+
+enum class parse_result_t {
+    //! More data are needed
+    incomplete,
+    //! Request was parsed
+    complete,
+    //! The data are not a valid (or supported) request
+    invalid
+};
+
+/*!
+ * Parses single HTTP request from the beginning of @em data.
+ *
+ * Request body is read only when Content-Length is specified, chunked requests
+ * are not supported. Values of header fields are stored without surrounding whitespace.
+ *
+ * @param consumed	Set to the size of the request (including body), when it's complete.
+ */
+parse_result_t parse_request(const std::string& data, request_t& request, size_t& consumed);
+
+//! Finds header field with case insensitive @em name. Returns nullptr if the field is not present.
+const std::string* find_header(const parameters_t& parameters, const std::string& name);
+
+//! Returns true if the connection should be kept open after responding to @em request.
+bool keep_alive_requested(const request_t& request);
+
+/*!
+ * Prepares status line and header fields of the response (including the empty line ending the header).
+ * Content-Length and Connection are added to the fields from @em response.
+ */
+std::string prepare_response(const response_t& response, bool keep_alive);
+}
+}
+
+#endif /* SRC_MODULES_WEBSERVER_HTTP_PARSER_H_ */
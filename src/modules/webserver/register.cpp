@@ -12,6 +12,7 @@
 #include "WebServer.h"
 #include "WebStaticResource.h"
 #include "WebImageResource.h"
+#include "WebStreamResource.h"
 #include "WebControlResource.h"
 #include "WebDataResource.h"
 #include "yuri/core/Module.h"
@@ -25,6 +26,7 @@ MODULE_REGISTRATION_BEGIN("webserver")
 		REGISTER_IOTHREAD("webserver",WebServer)
 		REGISTER_IOTHREAD("web_static",WebStaticResource)
 		REGISTER_IOTHREAD("web_image",WebImageResource)
+		REGISTER_IOTHREAD("web_stream",WebStreamResource)
 		REGISTER_IOTHREAD("web_control",WebControlResource)
 		REGISTER_IOTHREAD("web_directory",WebDirectoryResource)
 		REGISTER_IOTHREAD("web_data",WebDataResource)
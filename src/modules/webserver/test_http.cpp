@@ -0,0 +1,345 @@
+/*!
+ * @file 		test_http.cpp
+ * @author 		agent <agent@local>
+ * @date 		18.10.2026
+ * @copyright	Institute of Intermedia, CTU in Prague, 2026
+ * 				Distributed under modified BSD Licence, details in file doc/LICENSE
+ *
+ */
+
+#include "tests/catch.hpp"
+#include "http_parser.h"
+#include "HttpReactor.h"
+#include "HttpStream.h"
+#include <atomic>
+#include <sstream>
+#include <thread>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace yuri {
+namespace webserver {
+
+TEST_CASE("http request parsing", "[webserver]")
+{
+    request_t request;
+    size_t    consumed = 0;
+
+    SECTION("simple request")
+    {
+        const std::string data = "GET /image?a=1&b=x HTTP/1.1\r\nHost: localhost\r\nIf-None-Match:  123 \r\n\r\n";
+        REQUIRE(parse_request(data, request, consumed) == parse_result_t::complete);
+        REQUIRE(consumed == data.size());
+        REQUIRE(request.method == "GET");
+        REQUIRE(request.version == "HTTP/1.1");
+        REQUIRE(request.url.path == "/image");
+        REQUIRE(request.url.params["a"] == "1");
+        REQUIRE(request.url.params["b"] == "x");
+        REQUIRE(request.parameters["If-None-Match"] == "123");
+        REQUIRE(keep_alive_requested(request));
+    }
+    SECTION("incomplete request")
+    {
+        REQUIRE(parse_request("GET / HTTP/1.1\r\nHost: loc", request, consumed) == parse_result_t::incomplete);
+        REQUIRE(parse_request("", request, consumed) == parse_result_t::incomplete);
+        REQUIRE(parse_request("POST / HTTP/1.1\r\nContent-Length: 5\r\n\r\nabc", request, consumed) == parse_result_t::incomplete);
+    }
+    SECTION("pipelined requests with body")
+    {
+        const std::string first  = "POST /a HTTP/1.1\r\ncontent-length: 3\r\n\r\nabc";
+        const std::string second = "GET /b HTTP/1.0\n\n";
+        const std::string data   = first + second;
+        REQUIRE(parse_request(data, request, consumed) == parse_result_t::complete);
+        REQUIRE(consumed == first.size());
+        REQUIRE(request.body == "abc");
+        REQUIRE(parse_request(data.substr(consumed), request, consumed) == parse_result_t::complete);
+        REQUIRE(consumed == second.size());
+        REQUIRE(request.url.path == "/b");
+        REQUIRE(!keep_alive_requested(request));
+    }
+    SECTION("invalid requests")
+    {
+        REQUIRE(parse_request("GET /\r\n\r\n", request, consumed) == parse_result_t::invalid);
+        REQUIRE(parse_request("GET / HTTP/2.0\r\n\r\n", request, consumed) == parse_result_t::invalid);
+        REQUIRE(parse_request("GET / HTTP/1.1\r\nbroken header\r\n\r\n", request, consumed) == parse_result_t::invalid);
+        REQUIRE(parse_request("GET / HTTP/1.1\r\nContent-Length: x\r\n\r\n", request, consumed) == parse_result_t::invalid);
+    }
+    SECTION("connection header")
+    {
+        REQUIRE(parse_request("GET / HTTP/1.1\r\nConnection: close\r\n\r\n", request, consumed) == parse_result_t::complete);
+        REQUIRE(!keep_alive_requested(request));
+        REQUIRE(parse_request("GET / HTTP/1.0\r\nConnection: Keep-Alive\r\n\r\n", request, consumed) == parse_result_t::complete);
+        REQUIRE(keep_alive_requested(request));
+    }
+}
+
+TEST_CASE("http response header", "[webserver]")
+{
+    const response_t response{ http_code::ok, { { "Connection", "upgrade" }, { "Etag", "1" } }, "hello" };
+    REQUIRE(prepare_response(response, true) == "HTTP/1.1 200 OK\r\nEtag: 1\r\nContent-Length: 5\r\nConnection: keep-alive\r\n\r\n");
+    REQUIRE(prepare_response(response, false) == "HTTP/1.1 200 OK\r\nEtag: 1\r\nContent-Length: 5\r\nConnection: close\r\n\r\n");
+}
+
+TEST_CASE("http stream", "[webserver]")
+{
+    const auto make_data = [](const std::string& str) { return std::make_shared<const std::string>(str); };
+    const auto publish   = [&make_data](HttpStream& stream, const std::string& str) {
+        auto data = make_data(str);
+        stream.publish(data, reinterpret_cast<const uint8_t*>(data->data()), data->size());
+    };
+    stream_chunk_t chunk;
+
+    SECTION("new client starts with the latest chunk")
+    {
+        HttpStream stream(stream_mode_t::multipart, "image/jpeg");
+        uint64_t   next = 0;
+        REQUIRE(stream.get_next(next, chunk) == HttpStream::next_result_t::none);
+        publish(stream, "a");
+        publish(stream, "bb");
+        REQUIRE(stream.get_next(next, chunk) == HttpStream::next_result_t::chunk);
+        REQUIRE(std::string(reinterpret_cast<const char*>(chunk.data), chunk.size) == "bb");
+        REQUIRE(chunk.content_type == "image/jpeg");
+        REQUIRE(stream.get_next(next, chunk) == HttpStream::next_result_t::none);
+        stream.close();
+        REQUIRE(stream.get_next(next, chunk) == HttpStream::next_result_t::closed);
+    }
+    SECTION("slow client skips to the latest chunk")
+    {
+        HttpStream stream(stream_mode_t::chunked, "video/h264", 3);
+        publish(stream, "1");
+        uint64_t next = 0;
+        REQUIRE(stream.get_next(next, chunk) == HttpStream::next_result_t::chunk);
+        publish(stream, "2");
+        publish(stream, "3");
+        // Within the backlog, nothing is skipped
+        REQUIRE(stream.get_next(next, chunk) == HttpStream::next_result_t::chunk);
+        REQUIRE(chunk.data[0] == '2');
+        for (auto c : { "4", "5", "6", "7" }) {
+            publish(stream, c);
+        }
+        REQUIRE(stream.get_next(next, chunk) == HttpStream::next_result_t::chunk);
+        REQUIRE(chunk.data[0] == '7');
+        // Remaining chunks are sent before the stream ends
+        publish(stream, "8");
+        stream.close();
+        publish(stream, "9");
+        REQUIRE(stream.get_next(next, chunk) == HttpStream::next_result_t::chunk);
+        REQUIRE(chunk.data[0] == '8');
+        REQUIRE(stream.get_next(next, chunk) == HttpStream::next_result_t::closed);
+    }
+    SECTION("clients start at sync points")
+    {
+        HttpStream stream(stream_mode_t::chunked, "video/h264", 3);
+        const auto publish_frame = [&make_data, &stream](const std::string& str, bool sync_point) {
+            auto data = make_data(str);
+            stream.publish(data, reinterpret_cast<const uint8_t*>(data->data()), data->size(), {}, sync_point);
+        };
+        uint64_t next = 0;
+        // No chunk to start with yet
+        publish_frame("p", false);
+        REQUIRE(stream.get_next(next, chunk) == HttpStream::next_result_t::none);
+        publish_frame("1", true);
+        publish_frame("2", false);
+        REQUIRE(stream.get_next(next, chunk) == HttpStream::next_result_t::chunk);
+        REQUIRE(chunk.data[0] == '1');
+        REQUIRE(chunk.sync_point);
+        // Within the backlog, the chunks are sent regardless of sync points
+        REQUIRE(stream.get_next(next, chunk) == HttpStream::next_result_t::chunk);
+        REQUIRE(chunk.data[0] == '2');
+        for (auto c : { "3", "4", "5", "6" }) {
+            publish_frame(c, false);
+        }
+        // Lagging client waits for next sync point
+        REQUIRE(stream.get_next(next, chunk) == HttpStream::next_result_t::none);
+        publish_frame("7", true);
+        publish_frame("8", false);
+        REQUIRE(stream.get_next(next, chunk) == HttpStream::next_result_t::chunk);
+        REQUIRE(chunk.data[0] == '7');
+        REQUIRE(stream.get_next(next, chunk) == HttpStream::next_result_t::chunk);
+        REQUIRE(chunk.data[0] == '8');
+    }
+    SECTION("framing")
+    {
+        chunk = stream_chunk_t{ nullptr, nullptr, 26, "image/png", 1, true };
+        REQUIRE(prepare_chunk_header(stream_mode_t::multipart, chunk) == "--" + stream_boundary + "\r\nContent-Type: image/png\r\nContent-Length: 26\r\n\r\n");
+        REQUIRE(prepare_chunk_header(stream_mode_t::chunked, chunk) == "1a\r\n");
+        REQUIRE(prepare_chunk_trailer(stream_mode_t::chunked) == "\r\n");
+        REQUIRE(prepare_stream_end(stream_mode_t::chunked) == "0\r\n\r\n");
+        REQUIRE(prepare_stream_end(stream_mode_t::multipart) == "--" + stream_boundary + "--\r\n");
+
+        const response_t response{ http_code::ok, { { "Connection", "keep-alive" } }, {}, std::make_shared<HttpStream>(stream_mode_t::chunked, "video/mp2t") };
+        REQUIRE(prepare_stream_response(response) == "HTTP/1.1 200 OK\r\nContent-Type: video/mp2t\r\nCache-Control: no-cache, no-store\r\n"
+                                                      "Transfer-Encoding: chunked\r\nConnection: close\r\n\r\n");
+    }
+}
+
+namespace {
+int listen_on_loopback(uint16_t& port)
+{
+    const int   fd = ::socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in addr{};
+    addr.sin_family      = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port        = 0;
+    ::bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr));
+    ::listen(fd, 16);
+    socklen_t len = sizeof(addr);
+    ::getsockname(fd, reinterpret_cast<sockaddr*>(&addr), &len);
+    port = ntohs(addr.sin_port);
+    return fd;
+}
+
+int connect_to(uint16_t port)
+{
+    const int   fd = ::socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in addr{};
+    addr.sin_family      = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port        = htons(port);
+    ::connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr));
+    return fd;
+}
+
+//! Reads until the peer closes the connection or @em expected bytes are read
+std::string read_all(int fd, size_t expected)
+{
+    std::string data;
+    char        buffer[4096];
+    while (data.size() < expected) {
+        const auto count = ::recv(fd, buffer, sizeof(buffer), 0);
+        if (count <= 0)
+            break;
+        data.append(buffer, count);
+    }
+    return data;
+}
+}
+
+TEST_CASE("http reactor", "[webserver]")
+{
+    std::stringstream ss;
+    log::Log          l(ss);
+    uint16_t          port      = 0;
+    const int         listen_fd = listen_on_loopback(port);
+    REQUIRE(listen_fd >= 0);
+    {
+        reactor_config_t config;
+        config.workers = 2;
+        HttpReactor reactor(l, listen_fd, [](const request_t& request) {
+            return response_t{ http_code::ok, {}, request.url.path };
+        }, config);
+        std::atomic<bool> running{ true };
+        std::thread       loop([&]() {
+            while (running) {
+                reactor.run_once(10_ms);
+            }
+        });
+
+        const std::string ok_header = "HTTP/1.1 200 OK\r\nContent-Length: 2\r\n";
+        SECTION("pipelined requests are answered in order")
+        {
+            const int fd = connect_to(port);
+            const std::string requests = "GET /a HTTP/1.1\r\n\r\nGET /b HTTP/1.1\r\n\r\nGET /c HTTP/1.1\r\nConnection: close\r\n\r\n";
+            ::send(fd, requests.data(), requests.size(), 0);
+            const auto data = read_all(fd, 1 << 20);
+            const std::string expected = ok_header + "Connection: keep-alive\r\n\r\n/a" +
+                                         ok_header + "Connection: keep-alive\r\n\r\n/b" +
+                                         ok_header + "Connection: close\r\n\r\n/c";
+            REQUIRE(data == expected);
+            ::close(fd);
+        }
+        SECTION("connection is kept open")
+        {
+            const int fd = connect_to(port);
+            const std::string expected = ok_header + "Connection: keep-alive\r\n\r\n/x";
+            for (int i = 0; i < 3; ++i) {
+                const std::string request = "GET /x HTTP/1.1\r\nHost: localhost\r\n\r\n";
+                ::send(fd, request.data(), request.size(), 0);
+                REQUIRE(read_all(fd, expected.size()) == expected);
+            }
+            ::close(fd);
+        }
+        SECTION("requests are answered after the client shuts down its side")
+        {
+            const int fd = connect_to(port);
+            const std::string requests = "GET /a HTTP/1.1\r\n\r\nGET /b HTTP/1.1\r\n\r\n";
+            ::send(fd, requests.data(), requests.size(), 0);
+            ::shutdown(fd, SHUT_WR);
+            const auto data = read_all(fd, 1 << 20);
+            const std::string expected = ok_header + "Connection: keep-alive\r\n\r\n/a" +
+                                         ok_header + "Connection: keep-alive\r\n\r\n/b";
+            REQUIRE(data == expected);
+            ::close(fd);
+        }
+        SECTION("invalid request closes connection")
+        {
+            const int fd = connect_to(port);
+            const std::string request = "HELLO\r\n\r\n";
+            ::send(fd, request.data(), request.size(), 0);
+            const auto data = read_all(fd, 1 << 20);
+            REQUIRE(data.compare(0, 24, "HTTP/1.1 400 Bad Request") == 0);
+            ::close(fd);
+        }
+        running = false;
+        loop.join();
+    }
+    ::close(listen_fd);
+}
+
+TEST_CASE("http reactor streaming", "[webserver]")
+{
+    std::stringstream ss;
+    log::Log          l(ss);
+    uint16_t          port      = 0;
+    const int         listen_fd = listen_on_loopback(port);
+    REQUIRE(listen_fd >= 0);
+    auto stream = std::make_shared<HttpStream>(stream_mode_t::multipart, "image/jpeg");
+    {
+        HttpReactor reactor(l, listen_fd, [&stream](const request_t& request) {
+            if (request.url.path == "/stream")
+                return response_t{ http_code::ok, {}, {}, stream };
+            return response_t{ http_code::ok, {}, "x" };
+        });
+        std::atomic<bool> running{ true };
+        std::thread       loop([&]() {
+            while (running) {
+                reactor.run_once(10_ms);
+            }
+        });
+
+        const std::string header = "HTTP/1.1 200 OK\r\nContent-Type: multipart/x-mixed-replace; boundary=" + stream_boundary
+                                 + "\r\nCache-Control: no-cache, no-store\r\nConnection: close\r\n\r\n";
+        const auto part = [](const std::string& data) {
+            return "--" + stream_boundary + "\r\nContent-Type: image/jpeg\r\nContent-Length: " + std::to_string(data.size()) + "\r\n\r\n" + data + "\r\n";
+        };
+        auto frame = std::make_shared<const std::string>("first");
+        stream->publish(frame, reinterpret_cast<const uint8_t*>(frame->data()), frame->size());
+
+        const int         fd[2]   = { connect_to(port), connect_to(port) };
+        const std::string request = "GET /stream HTTP/1.1\r\n\r\nGET /ignored HTTP/1.1\r\n\r\n";
+        for (auto f : fd) {
+            ::send(f, request.data(), request.size(), 0);
+            // The latest frame is sent right after the header
+            const auto expected = header + part("first");
+            REQUIRE(read_all(f, expected.size()) == expected);
+        }
+        frame = std::make_shared<const std::string>("second frame");
+        stream->publish(frame, reinterpret_cast<const uint8_t*>(frame->data()), frame->size());
+        for (auto f : fd) {
+            const auto expected = part("second frame");
+            REQUIRE(read_all(f, expected.size()) == expected);
+        }
+        stream->close();
+        for (auto f : fd) {
+            REQUIRE(read_all(f, 1 << 20) == "--" + stream_boundary + "--\r\n");
+            ::close(f);
+        }
+        running = false;
+        loop.join();
+    }
+    ::close(listen_fd);
+}
+}
+}
@@ -0,0 +1,172 @@
+/*!
+ * @file 		webserver_benchmark.cpp
+ * @author 		agent <agent@local>
+ * @date 		18.10.2026
+ * @copyright	Institute of Intermedia, CTU in Prague, 2026
+ * 				Distributed under modified BSD Licence, details in file doc/LICENSE
+ *
+ * Load test of HttpReactor. Starts the event loop on loopback and lets
+ * several clients request a fixed resource, both over keep-alive connections
+ * and with a new connection for every request.
+ *
+ * Usage: webserver_benchmark [clients] [requests per client] [response size] [workers]
+ */
+
+#include "HttpReactor.h"
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <iostream>
+#include <thread>
+#include <vector>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+using namespace yuri;
+using namespace yuri::webserver;
+
+namespace {
+
+int listen_on_loopback(uint16_t& port)
+{
+    const int   fd = ::socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in addr{};
+    addr.sin_family      = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (fd < 0 || ::bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0 || ::listen(fd, 1024) < 0) {
+        return -1;
+    }
+    socklen_t len = sizeof(addr);
+    ::getsockname(fd, reinterpret_cast<sockaddr*>(&addr), &len);
+    port = ntohs(addr.sin_port);
+    return fd;
+}
+
+int connect_to(uint16_t port)
+{
+    const int   fd = ::socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in addr{};
+    addr.sin_family      = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port        = htons(port);
+    if (::connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0) {
+        ::close(fd);
+        return -1;
+    }
+    int one = 1;
+    ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    return fd;
+}
+
+//! Reads one response with Content-Length. Returns false on error.
+bool read_response(int fd, std::string& buffer)
+{
+    char data[65536];
+    while (true) {
+        const auto header_end = buffer.find("\r\n\r\n");
+        if (header_end != std::string::npos) {
+            const auto length_pos = buffer.find("Content-Length: ");
+            if (length_pos == std::string::npos || length_pos > header_end)
+                return false;
+            const size_t length = std::strtoul(buffer.c_str() + length_pos + 16, nullptr, 10);
+            if (buffer.size() >= header_end + 4 + length) {
+                buffer.erase(0, header_end + 4 + length);
+                return true;
+            }
+        }
+        const auto count = ::recv(fd, data, sizeof(data), 0);
+        if (count <= 0)
+            return false;
+        buffer.append(data, count);
+    }
+}
+
+void run_test(const std::string& name, uint16_t port, size_t clients, size_t requests, bool keep_alive)
+{
+    const std::string request = keep_alive ? "GET /image HTTP/1.1\r\nHost: localhost\r\n\r\n"
+                                           : "GET /image HTTP/1.1\r\nHost: localhost\r\nConnection: close\r\n\r\n";
+    std::atomic<size_t>      completed{ 0 };
+    std::atomic<size_t>      failed{ 0 };
+    std::vector<std::thread> threads;
+    const timestamp_t        start;
+    for (size_t c = 0; c < clients; ++c) {
+        threads.emplace_back([&]() {
+            int         fd = -1;
+            std::string buffer;
+            for (size_t i = 0; i < requests; ++i) {
+                if (fd < 0) {
+                    fd = connect_to(port);
+                    buffer.clear();
+                }
+                if (fd < 0 || ::send(fd, request.data(), request.size(), MSG_NOSIGNAL) != static_cast<ssize_t>(request.size())
+                    || !read_response(fd, buffer)) {
+                    ++failed;
+                    if (fd >= 0)
+                        ::close(fd);
+                    fd = -1;
+                    continue;
+                }
+                ++completed;
+                if (!keep_alive) {
+                    ::close(fd);
+                    fd = -1;
+                }
+            }
+            if (fd >= 0)
+                ::close(fd);
+        });
+    }
+    for (auto& t : threads) {
+        t.join();
+    }
+    const duration_t elapsed = timestamp_t{} - start;
+    const double     seconds = elapsed.value / 1e6;
+    std::cout << name << ": " << completed << " requests in " << seconds << " s, " << (completed / seconds) << " req/s";
+    if (failed) {
+        std::cout << ", " << failed << " failed";
+    }
+    std::cout << "\n";
+}
+}
+
+int main(int argc, char** argv)
+{
+    const size_t clients   = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 32;
+    const size_t requests  = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 1000;
+    const size_t body_size = argc > 3 ? std::strtoul(argv[3], nullptr, 10) : 32 * 1024;
+    const size_t workers   = argc > 4 ? std::strtoul(argv[4], nullptr, 10) : 4;
+
+    uint16_t  port      = 0;
+    const int listen_fd = listen_on_loopback(port);
+    if (listen_fd < 0) {
+        std::cerr << "Failed to listen on loopback\n";
+        return 1;
+    }
+    log::Log l(std::cerr);
+    l.set_quiet(true);
+    const std::string body(body_size, 'x');
+
+    reactor_config_t config;
+    config.workers = workers;
+    HttpReactor reactor(l, listen_fd, [&body](const request_t&) {
+        return response_t{ http_code::ok, { { "Content-Type", "image/jpeg" } }, body };
+    }, config);
+    std::atomic<bool> running{ true };
+    std::thread       loop([&]() {
+        while (running) {
+            reactor.run_once(10_ms);
+        }
+    });
+
+    std::cout << clients << " clients, " << requests << " requests each, " << body_size << " B responses, " << workers << " workers\n";
+    run_test("keep-alive", port, clients, requests, true);
+    run_test("connection per request", port, clients, std::max<size_t>(requests / 10, 1), false);
+
+    running = false;
+    loop.join();
+    ::close(listen_fd);
+    return 0;
+}
@@ -12,8 +12,12 @@
 #include "yuri/core/frame/CompressedVideoFrame.h"
 #include "yuri/core/frame/raw_frame_types.h"
 #include "yuri/core/frame/compressed_frame_types.h"
+#include "yuri/core/thread/FixedMemoryAllocator.h"
+#include "yuri/core/utils.h"
+#include <algorithm>
 #include <cstdarg>
 #include <cstdio>
+#include <cstring>
 namespace yuri {
 namespace x264 {
 
@@ -50,6 +54,8 @@ core::Parameters X264Encoder::configure()
 	p["threads"]["Number of threads to use (0 for default)"]=0;
 	p["fps"]["Override framerate in incomming frames. (set to 0 to use value specified in frames)"]=fraction_t{25,1};
 	p["bframes"]["Override bframe count, use -1 for default value, 0 to disable bframes."] = -1;
+	p["low_latency"]["Disable lookahead and bframes and output every slice as a separate frame as soon as it's encoded."] = false;
+	p["slices"]["Number of slices per frame (0 for default). In low latency mode, defaults to number of threads."] = 0;
 	return p;
 }
 
@@ -58,9 +64,55 @@ namespace {
 std::map<format_t, int>supported_formats = {
 		{core::raw_format::yuv420p, X264_CSP_I420},
 		{core::raw_format::yuv422p, X264_CSP_I422},
-		{core::raw_format::yuv444p, X264_CSP_I444}
+		{core::raw_format::yuv444p, X264_CSP_I444},
+		{core::raw_format::nv12, X264_CSP_NV12},
+#ifdef X264_CSP_YUYV
+		// Packed formats are supported since x264 build 157
+		{core::raw_format::yuyv422, X264_CSP_YUYV},
+		{core::raw_format::uyvy422, X264_CSP_UYVY},
+#endif
 };
 
+bool is_422(int csp)
+{
+#ifdef X264_CSP_YUYV
+	if (csp == X264_CSP_YUYV || csp == X264_CSP_UYVY) return true;
+#endif
+	return csp == X264_CSP_I422;
+}
+
+bool profile_supports_422(const std::string& profile)
+{
+	return profile == "high422" || profile == "high444";
+}
+
+//! Returns the requested profile, or the lowest profile able to encode the colorspace when it's not sufficient
+std::string get_profile(const std::string& profile, int csp)
+{
+	if (csp == X264_CSP_I444 && profile != "high444") return "high444";
+	if (is_422(csp) && !profile_supports_422(profile)) return "high422";
+	return profile;
+}
+
+//! Smallest block requested from the allocator
+constexpr size_t min_block_size = 4096;
+
+core::pCompressedVideoFrame create_pooled_frame(size_t capacity, const x264_param_t& params)
+{
+	capacity = next_power_2(std::max(capacity, min_block_size));
+	auto block = core::FixedMemoryAllocator::get_block(capacity);
+	auto frame = core::CompressedVideoFrame::create_empty(core::compressed_frame::h264,
+			resolution_t{static_cast<dimension_t>(params.i_width), static_cast<dimension_t>(params.i_height)});
+	frame->get_data().set(block.first, capacity, block.second);
+	return frame;
+}
+
+bool is_vcl_nal(int type)
+{
+	return type == NAL_SLICE || type == NAL_SLICE_DPA || type == NAL_SLICE_DPB ||
+			type == NAL_SLICE_DPC || type == NAL_SLICE_IDR;
+}
+
 std::map<int, log::debug_flags> x264_log_levels = {
 		{X264_LOG_NONE, log::info},
 		{X264_LOG_ERROR, log::error},
@@ -88,73 +140,117 @@ void yuri_log(void* priv, int level,  const char *psz, va_list params)
 }
 
 X264Encoder::X264Encoder(const log::Log &log_, core::pwThreadBase parent, const core::Parameters &parameters):
-base_type(log_,parent,std::string("x264")),encoder_(nullptr),
+base_type(log_,parent,std::string("x264")),event::BasicEventProducer(log),encoder_(nullptr),
 frame_number_(0),preset_("ultrafast"),tune_("zerolatency"),profile_("baseline"),bitrate_(-1),
 max_bitrate_(-1),cabac_(true),threads_(0),
-encoded_frames_(0),bframes_(-1)
+encoded_frames_(0),bframes_(-1),low_latency_(false),slices_(0),next_mb_(0)
 {
 	IOTHREAD_INIT(parameters)
-	set_supported_formats(supported_formats);
+	auto formats = supported_formats;
+#ifdef X264_CSP_YUYV
+	// Packed formats are offered only if they don't raise the profile,
+	// otherwise the converters would prefer them over yuv420p
+	if (!profile_supports_422(profile_)) {
+		formats.erase(core::raw_format::yuyv422);
+		formats.erase(core::raw_format::uyvy422);
+	}
+#endif
+	set_supported_formats(formats);
 }
 
 X264Encoder::~X264Encoder() noexcept
 {
 	if (encoder_) {
 		x264_encoder_close(encoder_);
-		x264_picture_clean(&picture_in_);
 	}
 }
 
-core::pFrame X264Encoder::do_special_single_step(core::pRawVideoFrame frame)
+bool X264Encoder::init_encoder(const core::pRawVideoFrame& frame, int csp)
 {
-	auto it = supported_formats.find(frame->get_format());
-	if (it == supported_formats.end()) return {};
 	const auto res = frame->get_resolution();
-	if (!encoder_) {
-		x264_param_default_preset(&params_, preset_.c_str(), tune_.c_str());
-
-		params_.i_width = res.width;
-		params_.i_height = res.height;
-		// TODO: set proper fps
-		const auto dur = frame->get_duration();
-		fraction_t fps;
-		if (fps_.get_value() > 0) {
-			fps = fps_;
-		} else if (dur > 0.1_us) {
-			fps = fraction_t{dur/1_ms, 1000};
+	x264_param_default_preset(&params_, preset_.c_str(), tune_.c_str());
+
+	params_.i_width = res.width;
+	params_.i_height = res.height;
+	// TODO: set proper fps
+	const auto dur = frame->get_duration();
+	fraction_t fps;
+	if (fps_.get_value() > 0) {
+		fps = fps_;
+	} else if (dur > 0.1_us) {
+		fps = fraction_t{dur/1_ms, 1000};
+	} else {
+		fps = fraction_t{25,1};
+	}
+	log[log::info] << "Using framerate: " << fps;
+	params_.i_fps_num = fps.num;
+	params_.i_fps_den = fps.denom;
+	params_.i_csp = csp;
+	params_.b_repeat_headers = 1;
+	params_.pf_log = &yuri_log;
+	params_.p_log_private = &log;
+	if (bframes_ >= 0) {
+		params_.i_bframe = bframes_;
+	}
+
+	params_.i_threads = threads_;
+	params_.b_cabac = cabac_?1:0;
+	if (bitrate_ >= 0) {
+		params_.rc.i_rc_method = X264_RC_ABR;
+		params_.rc.i_bitrate = bitrate_ * 8;
+
+		if (max_bitrate_ >= 0) {
+			params_.rc.i_vbv_max_bitrate = max_bitrate_ * 8;
 		} else {
-			fps = fraction_t{25,1};
-		}
-		log[log::info] << "Using framerate: " << fps;
-		params_.i_fps_num = fps.num;
-		params_.i_fps_den = fps.denom;
-		params_.i_csp = it->second;
-		params_.b_repeat_headers = 1;
-		params_.pf_log = &yuri_log;
-		params_.p_log_private = &log;
-		if (bframes_ >= 0) {
-			params_.i_bframe = bframes_;
+			params_.rc.i_vbv_max_bitrate = bitrate_ * 8 * 1.2;
 		}
-
-		params_.i_threads = threads_;
-		params_.b_cabac = cabac_?1:0;
-		if (bitrate_ >= 0) {
-			params_.rc.i_rc_method = X264_RC_ABR;
-			params_.rc.i_bitrate = bitrate_ * 8;
-
-			if (max_bitrate_ >= 0) {
-				params_.rc.i_vbv_max_bitrate = max_bitrate_ * 8;
-			} else {
-				params_.rc.i_vbv_max_bitrate = bitrate_ * 8 * 1.2;
-			}
-			params_.rc.i_vbv_buffer_size = params_.rc.i_vbv_max_bitrate;
+		params_.rc.i_vbv_buffer_size = params_.rc.i_vbv_max_bitrate;
+	}
+	if (slices_ > 0) {
+		params_.i_slice_count = slices_;
+	}
+	if (low_latency_) {
+		// Every frame has to be encoded in the call it was passed in,
+		// so the slices can be sent immediately.
+		params_.i_bframe = 0;
+		params_.rc.i_lookahead = 0;
+		params_.i_sync_lookahead = 0;
+		params_.b_vfr_input = 0;
+		params_.rc.b_mb_tree = 0;
+		params_.b_sliced_threads = 1;
+		if (slices_ <= 0) {
+			params_.i_slice_count = std::max(threads_, 1);
 		}
+		params_.nalu_process = &X264Encoder::process_nal;
+	}
 
-		x264_param_apply_profile(&params_, profile_.c_str());
+	const auto profile = get_profile(profile_, csp);
+	if (profile != profile_) {
+		log[log::warning] << "Profile " << profile_ << " doesn't support format " << frame->get_format_name() << ", using " << profile;
+	}
+	if (x264_param_apply_profile(&params_, profile.c_str()) < 0) {
+		log[log::warning] << "Failed to apply profile " << profile << ", encoding without profile restrictions";
+	}
 
-		x264_picture_alloc(&picture_in_, it->second, res.width, res.height);
+	x264_picture_init(&picture_in_);
+	encoder_ = x264_encoder_open(&params_);
+	if (!encoder_) {
+		log[log::error] << "Failed to open encoder";
+		return false;
+	}
+	return true;
+}
 
-		encoder_ = x264_encoder_open(&params_);
+core::pFrame X264Encoder::do_special_single_step(core::pRawVideoFrame frame)
+{
+	auto it = supported_formats.find(frame->get_format());
+	if (it == supported_formats.end()) return {};
+	const auto res = frame->get_resolution();
+	if (!encoder_) {
+		if (!init_encoder(frame, it->second)) {
+			request_end(core::yuri_exit_interrupted);
+			return {};
+		}
 	} else {
 		if (res.width != static_cast<dimension_t>(params_.i_width) ||
 				res.height != static_cast<dimension_t>(params_.i_height)) {
@@ -163,43 +259,106 @@ core::pFrame X264Encoder::do_special_single_step(core::pRawVideoFrame frame)
 		}
 
 	}
-	frame_data_.clear();
+	const int64_t pts = frame_number_++;
+	pending_[pts] = {frame, timestamp_t{}};
+
+	// The planes are used directly, without any copy
 	picture_in_.img.i_csp = it->second;
-	picture_in_.i_pts = frame_number_++;
+	picture_in_.i_pts = pts;
+	picture_in_.opaque = this;
 	picture_in_.img.i_plane = frame->get_planes_count();
-	std::vector<uint8_t*> orig_planes(picture_in_.img.i_plane);
 	for (int i = 0;i < picture_in_.img.i_plane; ++i) {
-		orig_planes[i]=picture_in_.img.plane[i];
 		picture_in_.img.i_stride[i]=PLANE_DATA(frame,i).get_line_size();
 		picture_in_.img.plane[i]=PLANE_RAW_DATA(frame,i);
 	}
 	x264_nal_t* nals;
 	int nal_count = 0;
 	Timer t0;
-	if (x264_encoder_encode(encoder_, &nals, &nal_count, &picture_in_, &picture_out_)) {
-		for (int i=0;i<nal_count;++i) {
-			process_nal(nals[i]);
+	core::pCompressedVideoFrame outframe;
+	if (x264_encoder_encode(encoder_, &nals, &nal_count, &picture_in_, &picture_out_) > 0) {
+		// In low latency mode, the NALs were already sent from process_nal()
+		if (!low_latency_) {
+			outframe = create_frame(nals, nal_count);
 		}
+		finish_frame(picture_out_.i_pts, outframe);
 	}
 	for (int i = 0;i < picture_in_.img.i_plane; ++i) {
-		picture_in_.img.plane[i]=orig_planes[i];
+		picture_in_.img.plane[i]=nullptr;
 	}
 	++encoded_frames_;
 	encoding_time_+=t0.get_duration();
 	if (encoded_frames_ >= 100) {
-		log[log::debug] << "Encoding " << encoded_frames_ << " took: " << encoding_time_ << ", that's " << encoding_time_/encoded_frames_ << " per frame";
+		log[log::debug] << "Encoding " << encoded_frames_ << " took: " << encoding_time_ << ", that's " << encoding_time_/encoded_frames_ << " per frame"
+				<< ", latency " << latency_/encoded_frames_ << " (max " << max_latency_ << ")";
 		encoded_frames_ = 0;
 		encoding_time_=0_ms;
+		latency_ = 0_ms;
+		max_latency_ = 0_ms;
 	}
-	return {core::CompressedVideoFrame::create_empty(core::compressed_frame::h264,
-					resolution_t{static_cast<dimension_t>(params_.i_width), static_cast<dimension_t>(params_.i_height)},
-					&frame_data_[0], frame_data_.size())};
+	return outframe;
 }
 
+core::pCompressedVideoFrame X264Encoder::create_frame(const x264_nal_t* nals, int nal_count)
+{
+	size_t size = 0;
+	for (int i = 0; i < nal_count; ++i) {
+		size += nals[i].i_payload;
+	}
+	auto frame = create_pooled_frame(size, params_);
+	uint8_t* data = frame->data();
+	for (int i = 0; i < nal_count; ++i) {
+		std::memcpy(data, nals[i].p_payload, nals[i].i_payload);
+		data += nals[i].i_payload;
+	}
+	frame->get_data().resize(size);
+	return frame;
+}
+
+void X264Encoder::finish_frame(int64_t pts, const core::pCompressedVideoFrame& outframe)
+{
+	auto it = pending_.find(pts);
+	if (it == pending_.end()) return;
+	if (outframe) {
+		outframe->copy_video_params(*it->second.frame);
+	}
+	const auto latency = timestamp_t{} - it->second.start;
+	latency_ += latency;
+	max_latency_ = std::max(max_latency_, latency);
+	emit_event("latency", latency);
+	// With B-frames, the frames are output in decoding order, so the older frames may still be pending
+	pending_.erase(it);
+}
 
-void X264Encoder::process_nal(x264_nal_t& nal)
+void X264Encoder::process_nal(x264_t* h, x264_nal_t* nal, void* opaque)
 {
-	frame_data_.insert(frame_data_.end(), nal.p_payload, nal.p_payload + nal.i_payload);
+	reinterpret_cast<X264Encoder*>(opaque)->output_slice(h, nal);
+}
+
+void X264Encoder::output_slice(x264_t* h, x264_nal_t* nal)
+{
+	auto frame = create_pooled_frame(nal->i_payload * 3 / 2 + 5 + 64, params_);
+	x264_nal_encode(h, frame->data(), nal);
+	frame->get_data().resize(nal->i_payload);
+
+	std::unique_lock<std::mutex> _(slice_mutex_);
+	// Encoding is synchronous in low latency mode, so the last pending frame is the one being encoded
+	if (!pending_.empty()) {
+		frame->copy_video_params(*pending_.rbegin()->second.frame);
+	}
+	if (!is_vcl_nal(nal->i_type)) {
+		// Parameter sets and SEI are written before the slices
+		push_frame(0, std::move(frame));
+		return;
+	}
+	// With sliced threads, the slices may be finished out of order
+	slices_waiting_[nal->i_first_mb] = {nal->i_last_mb, std::move(frame)};
+	const int mb_count = ((params_.i_width + 15) / 16) * ((params_.i_height + 15) / 16);
+	for (auto it = slices_waiting_.find(next_mb_); it != slices_waiting_.end(); it = slices_waiting_.find(next_mb_)) {
+		next_mb_ = it->second.first + 1;
+		if (next_mb_ >= mb_count) next_mb_ = 0;
+		push_frame(0, std::move(it->second.second));
+		slices_waiting_.erase(it);
+	}
 }
 
 bool X264Encoder::set_param(const core::Parameter& param)
@@ -213,7 +372,9 @@ bool X264Encoder::set_param(const core::Parameter& param)
 			(cabac_, "cabac")
 			(threads_, "threads")
 			(fps_, "fps")
-			(bframes_, "bframes"))
+			(bframes_, "bframes")
+			(low_latency_, "low_latency")
+			(slices_, "slices"))
 		return true;
 	return base_type::set_param(param);
 }
@@ -12,6 +12,10 @@
 
 #include "yuri/core/thread/SpecializedIOFilter.h"
 #include "yuri/core/frame/RawVideoFrame.h"
+#include "yuri/core/frame/CompressedVideoFrame.h"
+#include "yuri/event/BasicEventProducer.h"
+#include <map>
+#include <mutex>
 //#include "yuri/core/thread/ConverterThread.h"
 #ifndef _STDINT_H
 // x264 expects stdint.h to be included ot emits a warning. We include <cstdint>, this is simply to prevent that warning.
@@ -23,7 +27,7 @@ extern "C" {
 namespace yuri {
 namespace x264 {
 
-class X264Encoder: public core::SpecializedIOFilter<core::RawVideoFrame>//, public core::ConverterThread
+class X264Encoder: public core::SpecializedIOFilter<core::RawVideoFrame>, public event::BasicEventProducer//, public core::ConverterThread
 {
 	using base_type = core::SpecializedIOFilter<core::RawVideoFrame>;
 public:
@@ -35,7 +39,15 @@ private:
 	virtual core::pFrame do_special_single_step(core::pRawVideoFrame frame) override;
 	virtual bool set_param(const core::Parameter& param) override;
 
-	void process_nal(x264_nal_t& nal);
+	bool init_encoder(const core::pRawVideoFrame& frame, int csp);
+	//! Copies all NALs into a single pooled frame
+	core::pCompressedVideoFrame create_frame(const x264_nal_t* nals, int nal_count);
+	//! Called by x264 for every finished NAL, when slice output is enabled
+	static void process_nal(x264_t* h, x264_nal_t* nal, void* opaque);
+	void output_slice(x264_t* h, x264_nal_t* nal);
+	//! Stores params of the input frame for the frame that x264 outputs
+	void finish_frame(int64_t pts, const core::pCompressedVideoFrame& outframe);
+
 	x264_param_t params_;
 	x264_picture_t picture_in_;
 	x264_picture_t picture_out_;
@@ -50,10 +62,24 @@ private:
 	bool cabac_;
 	int threads_;
 	fraction_t fps_;
-	std::vector<uint8_t> frame_data_;
 	duration_t encoding_time_;
 	size_t encoded_frames_;
 	int bframes_;
+	bool low_latency_;
+	int slices_;
+
+	struct pending_frame_t {
+		core::pRawVideoFrame frame;
+		timestamp_t start;
+	};
+	//! Frames passed to x264 that were not output yet, indexed by pts
+	std::map<int64_t, pending_frame_t> pending_;
+	std::mutex slice_mutex_;
+	//! Encoded slices waiting for the preceding slices of the same frame
+	std::map<int, std::pair<int, core::pCompressedVideoFrame>> slices_waiting_;
+	int next_mb_;
+	duration_t latency_;
+	duration_t max_latency_;
 };
 
 } /* namespace x264 */
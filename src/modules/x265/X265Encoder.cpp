@@ -12,6 +12,10 @@
 #include "yuri/core/frame/CompressedVideoFrame.h"
 #include "yuri/core/frame/raw_frame_types.h"
 #include "yuri/core/frame/compressed_frame_types.h"
+#include "yuri/core/thread/FixedMemoryAllocator.h"
+#include "yuri/core/utils.h"
+#include <algorithm>
+#include <cstring>
 
 namespace yuri {
 namespace x265 {
@@ -47,21 +51,47 @@ core::Parameters X265Encoder::configure()
 	p["profile"]["X265 profile. Available values: ("+profiles+")"]="main";
 	p["preset"]["X265 preset. Available values: ("+presets+")"]="ultrafast";
 	p["tune"]["X265 tune. Available values: ("+tunes+")"]="zero-latency";
+	p["low_latency"]["Disable lookahead, bframes and frame threads and output every NAL as a separate frame."] = false;
+	p["slices"]["Number of slices per frame (0 for default)"] = 0;
 	return p;
 }
 
 namespace {
 std::map<format_t, int>supported_formats = {
 		{core::raw_format::yuv420p, X265_CSP_I420},
-//		{core::raw_format::yuv422p, X265_CSP_I422},
+		{core::raw_format::yuv422p, X265_CSP_I422},
 		{core::raw_format::yuv444p, X265_CSP_I444}
 };
 
+//! Returns the requested profile, or a profile able to encode the colorspace when it's not sufficient
+std::string get_profile(const std::string& profile, int csp)
+{
+	if (csp == X265_CSP_I444 && profile.find("444") == std::string::npos) return "main444-8";
+	if (csp == X265_CSP_I422 && profile.find("422") == std::string::npos &&
+			profile.find("444") == std::string::npos) return "main422-8";
+	return profile;
+}
+
+//! Smallest block requested from the allocator
+constexpr size_t min_block_size = 4096;
+
+core::pCompressedVideoFrame create_pooled_frame(size_t capacity, const x265_param& params)
+{
+	capacity = next_power_2(std::max(capacity, min_block_size));
+	auto block = core::FixedMemoryAllocator::get_block(capacity);
+	auto frame = core::CompressedVideoFrame::create_empty(core::compressed_frame::h265,
+			resolution_t{static_cast<dimension_t>(params.sourceWidth), static_cast<dimension_t>(params.sourceHeight)});
+	frame->get_data().set(block.first, capacity, block.second);
+	return frame;
+}
+
 }
 
 X265Encoder::X265Encoder(const log::Log &log_, core::pwThreadBase parent, const core::Parameters &parameters):
-base_type(log_,parent,std::string("x265")),encoder_(nullptr),
-frame_number_(0),preset_("ultrafast"),tune_("zerolatency"),profile_("main")
+base_type(log_,parent,std::string("x265")),event::BasicEventProducer(log),
+picture_in_(nullptr),picture_out_(nullptr),encoder_(nullptr),
+frame_number_(0),preset_("ultrafast"),tune_("zerolatency"),profile_("main"),
+low_latency_(false),slices_(0),encoded_frames_(0)
 {
 	IOTHREAD_INIT(parameters)
 	set_supported_formats(supported_formats);
@@ -82,38 +112,61 @@ X265Encoder::~X265Encoder() noexcept
 	}
 }
 
+bool X265Encoder::init_encoder(const core::pRawVideoFrame& frame, int csp)
+{
+	const auto res = frame->get_resolution();
+	x265_param_default_preset(&params_, preset_.c_str(), tune_.c_str());
+
+	params_.sourceWidth = res.width;
+	params_.sourceHeight = res.height;
+	params_.fpsNum=25;
+	params_.fpsDenom = 1;
+	params_.internalCsp = csp;
+	// Parameter sets are sent with every key frame, so the stream can be joined at any time
+	params_.bRepeatHeaders = 1;
+	if (slices_ > 0) {
+		params_.maxSlices = slices_;
+	}
+	if (low_latency_) {
+		// Every frame is output from the call it was passed in
+		params_.bframes = 0;
+		params_.lookaheadDepth = 0;
+		params_.frameNumThreads = 1;
+		params_.rc.cuTree = 0;
+	}
+
+	const auto profile = get_profile(profile_, csp);
+	if (profile != profile_) {
+		log[log::warning] << "Profile " << profile_ << " doesn't support format " << frame->get_format_name() << ", using " << profile;
+	}
+	if (x265_param_apply_profile(&params_, profile.c_str()) < 0) {
+		log[log::warning] << "Failed to apply profile " << profile << ", encoding without profile restrictions";
+	}
+
+	picture_in_ = x265_picture_alloc();
+	x265_picture_init(&params_, picture_in_);
+	picture_in_->bitDepth = 8;
+	picture_out_ = x265_picture_alloc();
+	x265_picture_init(&params_, picture_out_);
+	picture_out_->bitDepth = 8;
+	encoder_ = x265_encoder_open(&params_);
+	if (!encoder_) {
+		log[log::error] << "Failed to open encoder";
+		return false;
+	}
+	return true;
+}
+
 core::pFrame X265Encoder::do_special_single_step(core::pRawVideoFrame frame)
 {
 	auto it = supported_formats.find(frame->get_format());
 	if (it == supported_formats.end()) return {};
 	const auto res = frame->get_resolution();
 	if (!encoder_) {
-		x265_param_default_preset(&params_, preset_.c_str(), tune_.c_str());
-
-		params_.sourceWidth = res.width;
-		params_.sourceHeight = res.height;
-		params_.fpsNum=25;
-		params_.fpsDenom = 1;
-		params_.internalCsp = it->second;
-
-		x265_param_apply_profile(&params_, profile_.c_str());
-
-		picture_in_ = x265_picture_alloc();
-		x265_picture_init(&params_, picture_in_);
-		picture_in_->bitDepth = 8;
-		picture_out_ = x265_picture_alloc();
-		x265_picture_init(&params_, picture_out_);
-		picture_out_->bitDepth = 8;
-		encoder_ = x265_encoder_open(&params_);
-		unsigned int nheader = 0;
-		x265_nal *nals;
-		if (x265_encoder_headers(encoder_, &nals, &nheader) < 0) {
-			log[log::error] << "Failed to encode headers!";
+		if (!init_encoder(frame, it->second)) {
+			request_end(core::yuri_exit_interrupted);
 			return {};
 		}
-		for (unsigned int i=0;i<nheader;++i) {
-			process_nal(nals[i]);
-		}
 	} else {
 		if (res.width != static_cast<dimension_t>(params_.sourceWidth) ||
 				res.height != static_cast<dimension_t>(params_.sourceHeight)) {
@@ -121,35 +174,74 @@ core::pFrame X265Encoder::do_special_single_step(core::pRawVideoFrame frame)
 			return {};
 		}
 	}
+	const int64_t pts = frame_number_++;
+	pending_[pts] = {frame, timestamp_t{}};
+
+	// The planes are used directly, without any copy
 	picture_in_->colorSpace = it->second;
-	picture_in_->pts = frame_number_++;
-//	picture_in_.img.i_plane = frame->get_planes_count();
-	std::vector<void*> orig_planes(frame->get_planes_count());
+	picture_in_->pts = pts;
 	for (size_t i = 0;i < frame->get_planes_count(); ++i) {
-		orig_planes[i]=picture_in_->planes[i];
 		picture_in_->stride[i]=PLANE_DATA(frame,i).get_line_size();
 		picture_in_->planes[i]=PLANE_RAW_DATA(frame,i);
 	}
 	x265_nal* nals;
 	unsigned int nal_count = 0;
-	if (x265_encoder_encode(encoder_, &nals, &nal_count, picture_in_, picture_out_)) {
-		for (unsigned int i=0;i<nal_count;++i) {
-			process_nal(nals[i]);
+	if (x265_encoder_encode(encoder_, &nals, &nal_count, picture_in_, picture_out_) > 0 && nal_count) {
+		std::vector<core::pCompressedVideoFrame> outframes;
+		if (low_latency_) {
+			// Every NAL goes out separately, so the receiver can start decoding before the whole frame arrives
+			for (unsigned int i = 0; i < nal_count; ++i) {
+				outframes.push_back(create_frame(&nals[i], 1));
+			}
+		} else {
+			outframes.push_back(create_frame(nals, nal_count));
+		}
+		finish_frame(picture_out_->pts, outframes);
+		for (auto& f: outframes) {
+			push_frame(0, std::move(f));
 		}
 	}
 	for (size_t i = 0; i < frame->get_planes_count(); ++i) {
-		picture_in_->planes[i]=orig_planes[i];
+		picture_in_->planes[i]=nullptr;
+	}
+	if (++encoded_frames_ >= 100) {
+		log[log::debug] << "Average latency for last " << encoded_frames_ << " frames: " << latency_/encoded_frames_ << " (max " << max_latency_ << ")";
+		encoded_frames_ = 0;
+		latency_ = 0_ms;
+		max_latency_ = 0_ms;
 	}
-
 	return {};
 }
 
-void X265Encoder::process_nal(x265_nal& nal)
+core::pCompressedVideoFrame X265Encoder::create_frame(const x265_nal* nals, unsigned int nal_count)
 {
-	auto frame = core::CompressedVideoFrame::create_empty(core::compressed_frame::h265,
-			resolution_t{static_cast<dimension_t>(params_.sourceWidth), static_cast<dimension_t>(params_.sourceHeight)},
-			nal.payload, nal.sizeBytes);
-	push_frame(0, std::move(frame));
+	size_t size = 0;
+	for (unsigned int i = 0; i < nal_count; ++i) {
+		size += nals[i].sizeBytes;
+	}
+	auto frame = create_pooled_frame(size, params_);
+	uint8_t* data = frame->data();
+	for (unsigned int i = 0; i < nal_count; ++i) {
+		std::memcpy(data, nals[i].payload, nals[i].sizeBytes);
+		data += nals[i].sizeBytes;
+	}
+	frame->get_data().resize(size);
+	return frame;
+}
+
+void X265Encoder::finish_frame(int64_t pts, const std::vector<core::pCompressedVideoFrame>& outframes)
+{
+	auto it = pending_.find(pts);
+	if (it == pending_.end()) return;
+	for (const auto& f: outframes) {
+		f->copy_video_params(*it->second.frame);
+	}
+	const auto latency = timestamp_t{} - it->second.start;
+	latency_ += latency;
+	max_latency_ = std::max(max_latency_, latency);
+	emit_event("latency", latency);
+	// With B-frames, the frames are output in decoding order, so the older frames may still be pending
+	pending_.erase(it);
 }
 
 bool X265Encoder::set_param(const core::Parameter& param)
@@ -160,6 +252,10 @@ bool X265Encoder::set_param(const core::Parameter& param)
 		tune_ = param.get<std::string>();
 	} else if (param.get_name() == "profile") {
 		profile_ = param.get<std::string>();
+	} else if (param.get_name() == "low_latency") {
+		low_latency_ = param.get<bool>();
+	} else if (param.get_name() == "slices") {
+		slices_ = param.get<int>();
 	} else return base_type::set_param(param);
 	return true;
 }
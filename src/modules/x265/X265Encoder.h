@@ -12,6 +12,10 @@
 
 #include "yuri/core/thread/SpecializedIOFilter.h"
 #include "yuri/core/frame/RawVideoFrame.h"
+#include "yuri/core/frame/CompressedVideoFrame.h"
+#include "yuri/event/BasicEventProducer.h"
+#include <map>
+#include <vector>
 //#include "yuri/core/thread/ConverterThread.h"
 extern "C" {
 #include <x265.h>
@@ -20,7 +24,7 @@ extern "C" {
 namespace yuri {
 namespace x265 {
 
-class X265Encoder:  public core::SpecializedIOFilter<core::RawVideoFrame>//, public core::ConverterThread
+class X265Encoder:  public core::SpecializedIOFilter<core::RawVideoFrame>, public event::BasicEventProducer//, public core::ConverterThread
 {
 	using base_type = core::SpecializedIOFilter<core::RawVideoFrame>;
 public:
@@ -33,7 +37,11 @@ private:
 	virtual core::pFrame do_special_single_step(core::pRawVideoFrame frame) override;
 	virtual bool set_param(const core::Parameter& param) override;
 
-	void process_nal(x265_nal& nal);
+	bool init_encoder(const core::pRawVideoFrame& frame, int csp);
+	//! Copies NALs into a single pooled frame
+	core::pCompressedVideoFrame create_frame(const x265_nal* nals, unsigned int nal_count);
+	//! Stores params of the input frame for the frame that x265 outputs
+	void finish_frame(int64_t pts, const std::vector<core::pCompressedVideoFrame>& outframes);
 	x265_param params_;
 	x265_picture* picture_in_;
 	x265_picture* picture_out_;
@@ -45,6 +53,18 @@ private:
 	std::string preset_;
 	std::string tune_;
 	std::string profile_;
+	bool low_latency_;
+	int slices_;
+
+	struct pending_frame_t {
+		core::pRawVideoFrame frame;
+		timestamp_t start;
+	};
+	//! Frames passed to x265 that were not output yet, indexed by pts
+	std::map<int64_t, pending_frame_t> pending_;
+	size_t encoded_frames_;
+	duration_t latency_;
+	duration_t max_latency_;
 };
 
 } /* namespace x265 */
@@ -0,0 +1,78 @@
+/*!
+ * @file 		test_frame_damage.cpp
+ * @author 		agent <agent@local>
+ * @date 		18.10.2026
+ * @copyright	Institute of Intermedia, CTU in Prague, 2026
+ * 				Distributed under BSD Licence, details in file doc/LICENSE
+ *
+ */
+
+#include "catch.hpp"
+#include "yuri/core/frame/RawVideoFrame.h"
+#include "yuri/core/frame/raw_frame_types.h"
+
+namespace yuri {
+namespace core {
+
+TEST_CASE("frame damage", "[frame]")
+{
+    auto frame = RawVideoFrame::create_empty(raw_format::rgb24, resolution_t{ 100, 50 }, false);
+    REQUIRE(frame);
+
+    SECTION("frames without damage info are completely damaged")
+    {
+        REQUIRE_FALSE(frame->has_damage_info());
+        REQUIRE(frame->is_damaged());
+        frame->add_damage({ 10, 10, 0, 0 });
+        REQUIRE_FALSE(frame->has_damage_info());
+        const auto bounds = frame->get_damage_bounds();
+        REQUIRE(bounds.width == 100);
+        REQUIRE(bounds.height == 50);
+    }
+    SECTION("empty damage marks unchanged frame")
+    {
+        frame->set_damage({});
+        REQUIRE(frame->has_damage_info());
+        REQUIRE_FALSE(frame->is_damaged());
+        REQUIRE_FALSE(frame->get_damage_bounds());
+    }
+    SECTION("damage is clipped to the frame")
+    {
+        frame->set_damage({ { 20, 20, -10, -5 }, { 10, 10, 200, 0 } });
+        REQUIRE(frame->get_damage().size() == 1);
+        const auto& rect = frame->get_damage()[0];
+        REQUIRE(rect.x == 0);
+        REQUIRE(rect.y == 0);
+        REQUIRE(rect.width == 10);
+        REQUIRE(rect.height == 15);
+
+        frame->add_damage({ 5, 5, 90, 40 });
+        const auto bounds = frame->get_damage_bounds();
+        REQUIRE(bounds.x == 0);
+        REQUIRE(bounds.y == 0);
+        REQUIRE(bounds.width == 95);
+        REQUIRE(bounds.height == 45);
+
+        frame->clear_damage_info();
+        REQUIRE_FALSE(frame->has_damage_info());
+        REQUIRE(frame->get_damage().empty());
+    }
+    SECTION("damage is not copied with the frame")
+    {
+        frame->set_damage({});
+        auto copy = std::dynamic_pointer_cast<RawVideoFrame>(frame->get_copy());
+        REQUIRE_FALSE(copy->has_damage_info());
+        REQUIRE(copy->is_damaged());
+    }
+    SECTION("damage can be copied explicitly")
+    {
+        frame->set_damage({ { 1, 2, 3, 4 } });
+        auto copy = std::dynamic_pointer_cast<RawVideoFrame>(frame->get_copy());
+        copy->copy_damage_info(*frame);
+        REQUIRE(copy->has_damage_info());
+        REQUIRE(copy->get_damage().size() == 1);
+        REQUIRE(copy->get_damage()[0].y == 4);
+    }
+}
+}
+}
@@ -0,0 +1,114 @@
+/*!
+ * @file 		test_ordered_pool.cpp
+ * @author 		agent <agent@local>
+ * @date 		18.10.2026
+ * @copyright	Institute of Intermedia, CTU in Prague, 2026
+ * 				Distributed under modified BSD Licence, details in file doc/LICENSE
+ *
+ */
+
+#include "catch.hpp"
+#include "yuri/core/utils/ordered_pool.h"
+#include <atomic>
+#include <chrono>
+#include <stdexcept>
+#include <vector>
+
+namespace yuri {
+namespace core {
+namespace utils {
+
+namespace {
+struct counter_state {
+	int jobs = 0;
+};
+}
+
+TEST_CASE("ordered pool") {
+	std::atomic<int> states{0};
+	ordered_pool<int, counter_state> pool(4, [&states]() {
+		++states;
+		return std::unique_ptr<counter_state>(new counter_state);
+	});
+	REQUIRE(pool.workers() == 4);
+	int result = -1;
+	REQUIRE(!pool.try_pop(result));
+	REQUIRE(!pool.pop(result));
+
+	SECTION("results are returned in order") {
+		for (int i = 0; i < 50; ++i) {
+			pool.submit([i](counter_state& s) {
+				++s.jobs;
+				// Earlier jobs take longer, so they finish out of order
+				std::this_thread::sleep_for(std::chrono::microseconds((50 - i) * 20));
+				return i;
+			});
+		}
+		REQUIRE(pool.pending() == 50);
+		for (int i = 0; i < 50; ++i) {
+			REQUIRE(pool.pop(result));
+			REQUIRE(result == i);
+		}
+		REQUIRE(pool.pending() == 0);
+		REQUIRE(states <= 4);
+	}
+	SECTION("exceptions are passed to the caller") {
+		pool.submit([](counter_state&) -> int { throw std::runtime_error("failed"); });
+		pool.submit([](counter_state&) { return 5; });
+		REQUIRE_THROWS_AS(pool.pop(result), std::runtime_error);
+		REQUIRE(pool.pop(result));
+		REQUIRE(result == 5);
+	}
+	SECTION("finished results are popped up to the limit") {
+		for (int i = 0; i < 8; ++i) {
+			pool.submit([i](counter_state&) -> int {
+				if (i == 3) throw std::runtime_error("failed");
+				return i;
+			});
+		}
+		std::vector<int> results;
+		size_t errors = 0;
+		const auto handler = [&results](int r) { results.push_back(r); };
+		const auto on_error = [&errors](const std::exception&) { ++errors; };
+		pool.pop_finished(2, handler, on_error);
+		REQUIRE(pool.pending() <= 2);
+		REQUIRE(results.size() == 8 - pool.pending());
+		while (pool.pending()) pool.pop_finished(0, handler, on_error);
+		REQUIRE(results == (std::vector<int>{0, 1, 2, 0, 4, 5, 6, 7}));
+		REQUIRE(errors == 1);
+		pool.pop_finished(0, handler, on_error);
+		REQUIRE(results.size() == 8);
+	}
+	SECTION("draining returns a result for every submitted job") {
+		for (int i = 0; i < 20; ++i) {
+			pool.submit([i](counter_state&) {
+				std::this_thread::sleep_for(std::chrono::microseconds(200));
+				return i;
+			});
+		}
+		std::vector<int> results;
+		pool.pop_finished(0, [&results](int r) { results.push_back(r); }, [](const std::exception&) {});
+		REQUIRE(results.size() == 20);
+		REQUIRE(pool.pending() == 0);
+	}
+}
+
+TEST_CASE("ordered pool runs queued jobs before destruction") {
+	std::atomic<int> finished{0};
+	{
+		ordered_pool<int, counter_state> pool(2, []() {
+			return std::unique_ptr<counter_state>(new counter_state);
+		});
+		for (int i = 0; i < 20; ++i) {
+			pool.submit([&finished](counter_state&) {
+				std::this_thread::sleep_for(std::chrono::microseconds(200));
+				return ++finished;
+			});
+		}
+	}
+	REQUIRE(finished == 20);
+}
+
+}
+}
+}
@@ -0,0 +1,57 @@
+/*!
+ * @file 		test_parallel_for.cpp
+ * @author 		agent <agent@local>
+ * @date 		19.10.2026
+ * @copyright	Institute of Intermedia, CTU in Prague, 2026
+ * 				Distributed under modified BSD Licence, details in file doc/LICENSE
+ *
+ */
+
+#include "catch.hpp"
+#include "yuri/core/utils/parallel_for.h"
+#include <atomic>
+#include <stdexcept>
+#include <vector>
+
+namespace yuri {
+namespace core {
+namespace utils {
+
+TEST_CASE("parallel for") {
+	std::vector<std::atomic<int>> items(1000);
+	for (auto& i: items) i = 0;
+
+	SECTION("every item is processed once") {
+		for (size_t threads: {0, 1, 3, 8, 2000}) {
+			for (auto& i: items) i = 0;
+			parallel_for(threads, 0, items.size(), [&items](size_t start, size_t end) {
+				for (size_t i = start; i < end; ++i) ++items[i];
+			});
+			for (const auto& i: items) REQUIRE(i == 1);
+		}
+	}
+	SECTION("nested calls") {
+		parallel_for(4, 0, 10, [&items](size_t start, size_t end) {
+			for (size_t row = start; row < end; ++row) {
+				parallel_for(4, row * 100, (row + 1) * 100, [&items](size_t s, size_t e) {
+					for (size_t i = s; i < e; ++i) ++items[i];
+				});
+			}
+		});
+		for (const auto& i: items) REQUIRE(i == 1);
+	}
+	SECTION("exceptions are passed to the caller") {
+		REQUIRE_THROWS_AS(parallel_for(4, 0, 100, [](size_t start, size_t) {
+			if (start == 0) throw std::runtime_error("failed");
+		}), std::runtime_error);
+		// The pool stays usable
+		parallel_for(4, 0, items.size(), [&items](size_t start, size_t end) {
+			for (size_t i = start; i < end; ++i) ++items[i];
+		});
+		for (const auto& i: items) REQUIRE(i == 1);
+	}
+}
+
+}
+}
+}
@@ -35,6 +35,13 @@ CompressedVideoFrame::~CompressedVideoFrame() noexcept
 
 }
 
+pFrame CompressedVideoFrame::do_get_copy() const
+{
+	auto frame = std::make_shared<CompressedVideoFrame>(get_format(), get_resolution(), data_.data(), data_.size());
+	copy_parameters(*frame);
+	return frame;
+}
+
 
 
 
@@ -71,8 +71,7 @@ public:
 //	template<class... Args>
 //	void						emplace_back(Args&&... args) { data_.emplace_back(std::forward<Args>(args)...); }
 private:
-	// TODO Implement this!
-	EXPORT virtual pFrame	do_get_copy() const { return pFrame(); }
+	EXPORT virtual pFrame	do_get_copy() const;
 	EXPORT virtual size_t	do_get_size() const noexcept { return size(); };
 
 	vector_type data_;
@@ -15,7 +15,8 @@ namespace core {
 
 
 VideoFrame::VideoFrame(format_t format, resolution_t resolution, interlace_t interlace, field_order_t field_order)
-:Frame(format),resolution_(resolution), interlacing_(interlace),field_order_(field_order)
+:Frame(format),resolution_(resolution), interlacing_(interlace),field_order_(field_order),
+has_damage_(false)
 {
 
 }
@@ -45,6 +46,44 @@ void VideoFrame::copy_video_params(const VideoFrame &other)
 	copy_basic_params(other);
 }
 
+void VideoFrame::set_damage(const damage_t& damage)
+{
+	has_damage_ = true;
+	damage_.clear();
+	for (const auto& rect: damage) {
+		add_damage(rect);
+	}
+}
+
+void VideoFrame::add_damage(const geometry_t& rect)
+{
+	if (!has_damage_) return;
+	const auto clipped = intersection(rect, resolution_);
+	if (clipped) damage_.push_back(clipped);
+}
+
+void VideoFrame::clear_damage_info()
+{
+	has_damage_ = false;
+	damage_.clear();
+}
+
+geometry_t VideoFrame::get_damage_bounds() const
+{
+	if (!has_damage_) return resolution_.get_geometry();
+	geometry_t bounds {0, 0, 0, 0};
+	for (const auto& rect: damage_) {
+		bounds = bounding_box(bounds, rect);
+	}
+	return bounds;
+}
+
+void VideoFrame::copy_damage_info(const VideoFrame& other)
+{
+	has_damage_ = other.has_damage_;
+	damage_ = other.damage_;
+}
+
 void VideoFrame::copy_parameters(Frame& other) const
 {
 	try {
@@ -11,6 +11,7 @@
 #ifndef VIDEOFRAME_H_
 #define VIDEOFRAME_H_
 #include "Frame.h"
+#include <vector>
 
 namespace yuri {
 namespace core {
@@ -18,6 +19,11 @@ namespace core {
 class VideoFrame;
 typedef std::shared_ptr<VideoFrame> pVideoFrame;
 
+/*!
+ * List of rectangles changed since the previous frame in the stream.
+ */
+typedef std::vector<geometry_t> damage_t;
+
 class VideoFrame: public Frame
 {
 public:
@@ -71,6 +77,48 @@ public:
 	 */
 	EXPORT void 	copy_video_params(const VideoFrame &other);
 
+	/*!
+	 * Returns true if the frame carries information about changed regions.
+	 * Frames without this information should be treated as completely changed.
+	 */
+	EXPORT bool			has_damage_info() const { return has_damage_; }
+	/*!
+	 * Returns list of regions changed since previous frame.
+	 * Empty list with damage info set means the frame is identical to the previous one.
+	 */
+	EXPORT const damage_t&	get_damage() const { return damage_; }
+	/*!
+	 * Sets list of changed regions. Rectangles are clipped to the frame
+	 * and empty ones are skipped.
+	 * @param damage changed regions, pass empty list to mark frame as unchanged
+	 */
+	EXPORT void			set_damage(const damage_t& damage);
+	/*!
+	 * Adds a changed region. Does nothing for frames without damage info,
+	 * as these are considered to be completely changed anyway.
+	 * @param rect changed region
+	 */
+	EXPORT void			add_damage(const geometry_t& rect);
+	/*!
+	 * Removes damage info, marking the whole frame as changed.
+	 */
+	EXPORT void			clear_damage_info();
+	/*!
+	 * Returns true if any part of the frame changed.
+	 */
+	EXPORT bool			is_damaged() const { return !has_damage_ || !damage_.empty(); }
+	/*!
+	 * Returns bounding box of all changed regions (whole frame for frames without damage info)
+	 */
+	EXPORT geometry_t	get_damage_bounds() const;
+	/*!
+	 * Copies damage info from other frame.
+	 * Copies of frames (get_copy()) don't carry damage info, so only nodes that know
+	 * how the copy relates to the previous output should call this.
+	 * @param other Source frame
+	 */
+	EXPORT void			copy_damage_info(const VideoFrame& other);
+
 protected:
 	/*!
 	 * Copies parameters from the frame to other frame.
@@ -82,6 +130,8 @@ private:
 	resolution_t	resolution_;
 	interlace_t		interlacing_;
 	field_order_t	field_order_;
+	bool			has_damage_;
+	damage_t		damage_;
 };
 
 }
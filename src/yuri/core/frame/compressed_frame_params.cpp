@@ -40,6 +40,7 @@ namespace {
             {hap,{hap,"HAP", {"HAP"}, {"video/hap"} }},
             {ycocg_dxt5,{ycocg_dxt5,"YCoCg DXT5", {"YCoCg_DXT"}, {"video/ycocg_dxt5"} }},
 			{jpegxs,{jpegxs,"JPEGXS", {"JPEGXS"}, {"video/jpegxs"} }},
+			{aac,	{aac,	"AAC (ADTS)", {"AAC"}, {"audio/aac"} }},
 	};
 
 	bool do_add_format(const compressed_frame_info_t& info)
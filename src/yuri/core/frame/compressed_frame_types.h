@@ -37,6 +37,8 @@ const format_t h265			= 0x1000f;
 const format_t avc1			= 0x10010;
 
 const format_t hap			= 0x10011;
+// AAC audio in ADTS stream
+const format_t aac			= 0x10012;
 
 // YCoCg Scaled in DXT5
 const format_t ycocg_dxt5   = 0x10020;
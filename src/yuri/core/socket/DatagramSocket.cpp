@@ -31,6 +31,18 @@ size_t DatagramSocket::send_datagram(const uint8_t* data, size_t size) {
 size_t DatagramSocket::receive_datagram(uint8_t* data, size_t size) {
 	return do_receive_datagram(data, size);
 }
+size_t DatagramSocket::send_datagrams(const datagram_t* datagrams, size_t count) {
+	if (!count) return 0;
+	return do_send_datagrams(datagrams, count);
+}
+size_t DatagramSocket::send_datagrams(const datagram_parts_t* datagrams, size_t count) {
+	if (!count) return 0;
+	return do_send_datagram_parts(datagrams, count);
+}
+size_t DatagramSocket::receive_datagrams(datagram_buffer_t* buffers, size_t max) {
+	if (!max) return 0;
+	return do_receive_datagrams(buffers, max);
+}
 bool DatagramSocket::bind(const std::string& url, port_t port) {
 	return do_bind(url, port);
 }
@@ -44,10 +56,69 @@ bool DatagramSocket::data_available() {
 bool DatagramSocket::ready_to_send() {
 	return do_ready_to_send();
 }
+bool DatagramSocket::enable_segmentation_offload(bool enable) {
+	return do_enable_segmentation_offload(enable);
+}
 bool DatagramSocket::wait_for_data(duration_t duration) {
 	return do_wait_for_data(duration);
 }
 
+size_t DatagramSocket::do_send_datagrams(const datagram_t* datagrams, size_t count)
+{
+	size_t sent = 0;
+	while (sent < count && do_send_datagram(datagrams[sent].data, datagrams[sent].size) == datagrams[sent].size) {
+		++sent;
+	}
+	return sent;
+}
+
+size_t DatagramSocket::do_send_datagram_parts(const datagram_parts_t* datagrams, size_t count)
+{
+	std::vector<uint8_t> buffer;
+	size_t sent = 0;
+	for (; sent < count; ++sent) {
+		const auto& datagram = datagrams[sent];
+		if (datagram.count == 1) {
+			if (do_send_datagram(datagram.parts[0].data, datagram.parts[0].size) != datagram.parts[0].size) break;
+			continue;
+		}
+		buffer.clear();
+		for (size_t i = 0; i < datagram.count; ++i) {
+			buffer.insert(buffer.end(), datagram.parts[i].data, datagram.parts[i].data + datagram.parts[i].size);
+		}
+		if (do_send_datagram(buffer.data(), buffer.size()) != buffer.size()) break;
+	}
+	return sent;
+}
+
+bool DatagramSocket::do_enable_segmentation_offload(bool)
+{
+	return false;
+}
+
+size_t DatagramSocket::do_receive_datagrams(datagram_buffer_t* buffers, size_t max)
+{
+	size_t received = 0;
+	while (received < max && (received == 0 || do_data_available())) {
+		buffers[received].size = do_receive_datagram(buffers[received].data, buffers[received].capacity);
+		if (!buffers[received].size) break;
+		++received;
+	}
+	return received;
+}
+
+DatagramBatch::DatagramBatch(size_t count, size_t max_size)
+:data_(count * max_size)
+{
+	for (size_t i = 0; i < count; ++i) {
+		buffers_.push_back({&data_[i * max_size], max_size, 0});
+	}
+}
+
+size_t DatagramBatch::receive(DatagramSocket& socket)
+{
+	return socket.receive_datagrams(buffers_);
+}
 
 }
 }
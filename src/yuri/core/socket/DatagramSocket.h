@@ -21,6 +21,28 @@ namespace core {
 namespace socket {
 
 typedef uint16_t port_t;
+
+//! Datagram to be sent with DatagramSocket::send_datagrams()
+struct datagram_t {
+	const uint8_t*	data;
+	size_t			size;
+};
+
+//! Datagram composed of several buffers (e.g. a header and a payload stored elsewhere)
+struct datagram_parts_t {
+	const datagram_t*	parts;
+	size_t				count;
+};
+
+//! Buffer for a datagram received with DatagramSocket::receive_datagrams()
+struct datagram_buffer_t {
+	uint8_t*		data;
+	//! Size of the buffer
+	size_t			capacity;
+	//! Size of received datagram
+	size_t			size;
+};
+
 class DatagramSocket;
 typedef std::shared_ptr<DatagramSocket> pDatagramSocket;
 class DatagramSocket {
@@ -62,6 +84,15 @@ public:
 	 */
 	EXPORT bool ready_to_send();
 
+	/*!
+	 * Enables sending runs of equally sized datagrams from send_datagrams() as a single buffer
+	 * segmented by the kernel (UDP GSO). The segments leave as a single burst,
+	 * so it shouldn't be used for streams that have to be paced.
+	 * Disabled by default.
+	 * @return true if the socket supports segmentation offload
+	 */
+	EXPORT bool enable_segmentation_offload(bool enable);
+
 	/*!
 	 * Sends datagram
 	 * @param data Pinter to data to send
@@ -100,6 +131,37 @@ public:
 	template<typename T>
 	size_t send_datagram(const std::basic_string<T>& data);
 
+	/*!
+	 * Sends several datagrams at once. Implementations may send them with a single system call.
+	 * @param datagrams Pointer to first datagram to send
+	 * @param count Number of datagrams
+	 * @return number of datagrams completely sent. Datagrams are sent in order,
+	 * so the remaining ones start at @em datagrams + returned value.
+	 */
+	EXPORT size_t send_datagrams(const datagram_t* datagrams, size_t count);
+
+	/*!
+	 * Convenience wrapper for sending all datagrams stored in a std::vector
+	 * @param datagrams Datagrams to send
+	 * @return number of datagrams completely sent
+	 */
+	size_t send_datagrams(const std::vector<datagram_t>& datagrams);
+
+	/*!
+	 * Sends several datagrams at once, each of them gathered from several buffers.
+	 * @param datagrams Pointer to first datagram to send
+	 * @param count Number of datagrams
+	 * @return number of datagrams completely sent.
+	 */
+	EXPORT size_t send_datagrams(const datagram_parts_t* datagrams, size_t count);
+
+	/*!
+	 * Convenience wrapper for sending all datagrams stored in a std::vector
+	 * @param datagrams Datagrams to send
+	 * @return number of datagrams completely sent
+	 */
+	size_t send_datagrams(const std::vector<datagram_parts_t>& datagrams);
+
 	/*!
 	 * Receives a single datagram from socket
 	 * @param data Pointer to location to store the data
@@ -133,6 +195,23 @@ public:
 	template<typename T, size_t N>
 	size_t receive_datagram(std::array<T, N>& data);
 
+	/*!
+	 * Receives several datagrams at once. The method doesn't wait for data,
+	 * it returns datagrams that are already available (at least one,
+	 * if data_available() returned true).
+	 * @param buffers Buffers to receive the datagrams into. Size of each datagram is stored in its buffer.
+	 * @param max Maximal number of datagrams to receive
+	 * @return number of datagrams received
+	 */
+	EXPORT size_t receive_datagrams(datagram_buffer_t* buffers, size_t max);
+
+	/*!
+	 * Convenience wrapper, receives at most @em buffers.size() datagrams into a std::vector of buffers
+	 * @param buffers Buffers to receive the datagrams into
+	 * @return number of datagrams received
+	 */
+	size_t receive_datagrams(std::vector<datagram_buffer_t>& buffers);
+
 protected:
 	log::Log	log;
 private:
@@ -144,8 +223,58 @@ private:
 	virtual bool do_data_available() = 0;
 	virtual bool do_ready_to_send() = 0;
 	virtual bool do_wait_for_data(duration_t duration) = 0;
+	/*!
+	 * Default implementations of batch methods use do_send_datagram and do_receive_datagram
+	 * for every datagram. Sockets supporting batched IO should override them.
+	 */
+	virtual size_t do_send_datagrams(const datagram_t* datagrams, size_t count);
+	virtual size_t do_receive_datagrams(datagram_buffer_t* buffers, size_t max);
+	//! Default implementation copies the parts into a temporary buffer
+	virtual size_t do_send_datagram_parts(const datagram_parts_t* datagrams, size_t count);
+	//! Default implementation doesn't support segmentation offload
+	virtual bool do_enable_segmentation_offload(bool enable);
+};
+
+/*!
+ * Buffers for receiving a batch of datagrams with DatagramSocket::receive_datagrams().
+ * Received datagrams stay valid until the next call to receive().
+ */
+class DatagramBatch {
+public:
+	/*!
+	 * @param count Maximal number of datagrams received at once
+	 * @param max_size Size of buffer for each datagram
+	 */
+	EXPORT DatagramBatch(size_t count = 16, size_t max_size = 65536);
+	/*!
+	 * Receives datagrams that are already available
+	 * @return number of datagrams received
+	 */
+	EXPORT size_t receive(DatagramSocket& socket);
+	//! Returns the buffer of @em index-th received datagram
+	const datagram_buffer_t& operator[](size_t index) const { return buffers_[index]; }
+	//! Maximal number of datagrams received at once
+	size_t capacity() const { return buffers_.size(); }
+private:
+	std::vector<uint8_t>			data_;
+	std::vector<datagram_buffer_t>	buffers_;
 };
 
+inline size_t DatagramSocket::send_datagrams(const std::vector<datagram_t>& datagrams)
+{
+	return send_datagrams(datagrams.data(), datagrams.size());
+}
+
+inline size_t DatagramSocket::send_datagrams(const std::vector<datagram_parts_t>& datagrams)
+{
+	return send_datagrams(datagrams.data(), datagrams.size());
+}
+
+inline size_t DatagramSocket::receive_datagrams(std::vector<datagram_buffer_t>& buffers)
+{
+	return receive_datagrams(buffers.data(), buffers.size());
+}
+
 
 template<typename T>
 size_t DatagramSocket::send_datagram(const T* data, size_t size)
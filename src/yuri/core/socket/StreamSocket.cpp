@@ -62,6 +62,10 @@ bool StreamSocket::wait_for_data(duration_t duration)
 {
 	return do_wait_for_data(duration);
 }
+int StreamSocket::get_native_handle()
+{
+	return do_get_native_handle();
+}
 
 }
 }
@@ -83,6 +83,12 @@ public:
 	EXPORT bool data_available();
 
 	EXPORT bool wait_for_data(duration_t duration);
+
+	/*!
+	 * Returns OS handle of the socket (file descriptor), for use with poll/epoll.
+	 * @return native handle or -1 if the implementation doesn't have one.
+	 */
+	EXPORT int get_native_handle();
 protected:
 	log::Log		log;
 private:
@@ -95,6 +101,7 @@ private:
 
 	virtual bool do_data_available() = 0;
 	virtual bool do_wait_for_data(duration_t duration) = 0;
+	virtual int do_get_native_handle() { return -1; }
 
 
 };
@@ -61,7 +61,7 @@ void IOThread::run()
     } catch (std::runtime_error& e) {
         log[log::debug] << "Thread failed: " << e.what();
     }
-
+    finish_output();
     close_pipes();
 }
 
@@ -70,6 +70,10 @@ bool IOThread::step()
 {
     throw std::runtime_error("This method should be never called!");
 }
+
+void IOThread::finish_output()
+{
+}
 position_t IOThread::get_no_in_ports()
 {
     lock_t _(port_lock_);
@@ -132,6 +132,12 @@ protected:
      */
     EXPORT virtual bool step();
 
+    /*!
+     * Called when the main loop of IOThread::run() ends, before the output pipes are closed.
+     * Classes processing frames asynchronously should push the frames still in flight here.
+     */
+    EXPORT virtual void finish_output();
+
     /*!
      * Pushes a frame into output pipe @em index
      *
@@ -159,6 +159,22 @@ inline resolution_t intersection(const resolution_t& rect1, const resolution_t&
 	return {std::min(rect1.width, rect2.width), std::min(rect1.height, rect2.height)};
 }
 
+/*!
+ * Returns the smallest rectangle containing both rectangles.
+ * Empty rectangles are ignored.
+ */
+inline geometry_t bounding_box(const geometry_t& rect1, const geometry_t& rect2)
+{
+	if (!rect1) return rect2;
+	if (!rect2) return rect1;
+	geometry_t rect_out;
+	rect_out.x = std::min(rect1.x, rect2.x);
+	rect_out.y = std::min(rect1.y, rect2.y);
+	rect_out.width = geometry_max_x(rect1) > geometry_max_x(rect2) ? geometry_max_x(rect1) - rect_out.x : geometry_max_x(rect2) - rect_out.x;
+	rect_out.height = geometry_max_y(rect1) > geometry_max_y(rect2) ? geometry_max_y(rect1) - rect_out.y : geometry_max_y(rect2) - rect_out.y;
+	return rect_out;
+}
+
 //template<class Stream>
 inline std::ostream& operator<<(std::ostream& os, const resolution_t& res)
 {
@@ -0,0 +1,197 @@
+/*!
+ * @file 		ordered_pool.h
+ * @author 		agent <agent@local>
+ * @date 		18.10.2026
+ * @copyright	Institute of Intermedia, CTU in Prague, 2026
+ * 				Distributed under modified BSD Licence, details in file doc/LICENSE
+ *
+ */
+
+#ifndef SRC_YURI_CORE_UTILS_ORDERED_POOL_H_
+#define SRC_YURI_CORE_UTILS_ORDERED_POOL_H_
+
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace yuri {
+namespace core {
+namespace utils {
+
+/*!
+ * Pool of worker threads processing jobs concurrently
+ * and returning their results in the order the jobs were submitted.
+ *
+ * Every worker owns an instance of @em State, created by the factory passed to the constructor
+ * (returning std::unique_ptr<State>), and passes it to every job it runs. This way expensive contexts (codecs etc.)
+ * are created once per worker and reused for all the jobs.
+ *
+ * Exceptions thrown by a job are rethrown from pop() or try_pop().
+ * The destructor waits until all submitted jobs are run, results not popped by then are discarded.
+ */
+template<class Result, class State>
+class ordered_pool {
+public:
+	using job_type = std::function<Result(State&)>;
+
+	template<class Factory>
+	ordered_pool(size_t workers, Factory factory):
+		stop_(false)
+	{
+		if (workers < 1) workers = 1;
+		for (size_t i = 0; i < workers; ++i) {
+			workers_.emplace_back([this, factory]() {
+				auto state = factory();
+				run(*state);
+			});
+		}
+	}
+
+	~ordered_pool() noexcept
+	{
+		{
+			std::unique_lock<std::mutex> lock(mutex_);
+			stop_ = true;
+		}
+		job_cv_.notify_all();
+		for (auto& w: workers_) {
+			w.join();
+		}
+	}
+
+	ordered_pool(const ordered_pool&) = delete;
+	ordered_pool& operator=(const ordered_pool&) = delete;
+
+	size_t workers() const
+	{
+		return workers_.size();
+	}
+
+	//! Number of submitted jobs whose results weren't popped yet
+	size_t pending() const
+	{
+		std::unique_lock<std::mutex> lock(mutex_);
+		return slots_.size();
+	}
+
+	void submit(job_type job)
+	{
+		{
+			std::unique_lock<std::mutex> lock(mutex_);
+			slots_.emplace_back(new slot_t(std::move(job)));
+			queued_.push_back(slots_.back().get());
+		}
+		job_cv_.notify_one();
+	}
+
+	/*!
+	 * Returns result of the oldest job if it's already finished.
+	 * @return false if there's no pending job or the oldest one isn't finished yet.
+	 */
+	bool try_pop(Result& result)
+	{
+		std::unique_lock<std::mutex> lock(mutex_);
+		if (slots_.empty() || !slots_.front()->done) return false;
+		return pop_front(result);
+	}
+
+	/*!
+	 * Waits for the oldest job and returns its result.
+	 * @return false if there are no pending jobs.
+	 */
+	bool pop(Result& result)
+	{
+		std::unique_lock<std::mutex> lock(mutex_);
+		if (slots_.empty()) return false;
+		done_cv_.wait(lock, [this]{ return slots_.front()->done; });
+		return pop_front(result);
+	}
+
+	/*!
+	 * Passes finished results to @em handler in submission order.
+	 * Waits for the oldest jobs while more than @em max_pending jobs are pending,
+	 * then stops at the first job that isn't finished yet.
+	 * @param handler Called with every result, or with a default constructed one when the job failed
+	 * @param on_error Called with the exception thrown by a failed job
+	 */
+	template<class Handler, class ErrorHandler>
+	void pop_finished(size_t max_pending, Handler handler, ErrorHandler on_error)
+	{
+		while (true) {
+			Result result{};
+			try {
+				if (pending() > max_pending) {
+					if (!pop(result)) return;
+				} else if (!try_pop(result)) {
+					return;
+				}
+			}
+			catch (std::exception& e) {
+				on_error(e);
+			}
+			handler(std::move(result));
+		}
+	}
+
+private:
+	struct slot_t {
+		explicit slot_t(job_type job):job(std::move(job)),done(false) {}
+		job_type job;
+		Result result;
+		std::exception_ptr error;
+		bool done;
+	};
+
+	void run(State& state)
+	{
+		std::unique_lock<std::mutex> lock(mutex_);
+		while (true) {
+			job_cv_.wait(lock, [this]{ return stop_ || !queued_.empty(); });
+			// Queued jobs are still run when stopping
+			if (queued_.empty()) return;
+			slot_t* slot = queued_.front();
+			queued_.pop_front();
+			lock.unlock();
+			try {
+				slot->result = slot->job(state);
+			}
+			catch (...) {
+				slot->error = std::current_exception();
+			}
+			slot->job = nullptr;
+			lock.lock();
+			slot->done = true;
+			done_cv_.notify_all();
+		}
+	}
+
+	bool pop_front(Result& result)
+	{
+		auto slot = std::move(slots_.front());
+		slots_.pop_front();
+		if (slot->error) std::rethrow_exception(slot->error);
+		result = std::move(slot->result);
+		return true;
+	}
+
+	mutable std::mutex mutex_;
+	std::condition_variable job_cv_;
+	std::condition_variable done_cv_;
+	//! All unfinished jobs in submission order
+	std::deque<std::unique_ptr<slot_t>> slots_;
+	//! Jobs not yet picked by any worker
+	std::deque<slot_t*> queued_;
+	bool stop_;
+	std::vector<std::thread> workers_;
+};
+
+}
+}
+}
+
+#endif /* SRC_YURI_CORE_UTILS_ORDERED_POOL_H_ */
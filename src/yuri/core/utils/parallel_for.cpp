@@ -0,0 +1,142 @@
+/*!
+ * @file 		parallel_for.cpp
+ * @author 		agent <agent@local>
+ * @date 		19.10.2026
+ * @copyright	Institute of Intermedia, CTU in Prague, 2026
+ * 				Distributed under modified BSD Licence, details in file doc/LICENSE
+ *
+ */
+
+#include "parallel_for.h"
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace yuri {
+namespace core {
+namespace utils {
+
+namespace {
+
+//! Bands of a single run_bands() call, claimed one by one by the participating threads
+struct bands_job_t {
+	bands_job_t(size_t count, const std::function<void(size_t)>& band):
+		band(band),count(count),next(0),finished(0) {}
+
+	//! Processes bands until there are none left to claim
+	void process()
+	{
+		for (size_t i = next++; i < count; i = next++) {
+			try {
+				band(i);
+			}
+			catch (...) {
+				std::unique_lock<std::mutex> lock(mutex);
+				if (!error) error = std::current_exception();
+			}
+			if (++finished == count) {
+				std::unique_lock<std::mutex> lock(mutex);
+				done_cv.notify_all();
+			}
+		}
+	}
+
+	const std::function<void(size_t)>& band;
+	const size_t count;
+	std::atomic<size_t> next;
+	std::atomic<size_t> finished;
+	std::mutex mutex;
+	std::condition_variable done_cv;
+	std::exception_ptr error;
+};
+
+/*!
+ * Workers shared by all run_bands() calls. The pool grows up to the largest
+ * number of helpers requested so far and the workers live until the process exits.
+ */
+class band_workers {
+public:
+	band_workers():stop_(false) {}
+	~band_workers() noexcept
+	{
+		{
+			std::unique_lock<std::mutex> lock(mutex_);
+			stop_ = true;
+		}
+		cv_.notify_all();
+		for (auto& w: workers_) {
+			w.join();
+		}
+	}
+
+	void submit(const std::shared_ptr<bands_job_t>& job, size_t helpers)
+	{
+		{
+			std::unique_lock<std::mutex> lock(mutex_);
+			while (workers_.size() < helpers) {
+				workers_.emplace_back([this]{ run(); });
+			}
+			for (size_t i = 0; i < helpers; ++i) {
+				queue_.push_back(job);
+			}
+		}
+		if (helpers == 1) cv_.notify_one();
+		else cv_.notify_all();
+	}
+private:
+	void run()
+	{
+		std::unique_lock<std::mutex> lock(mutex_);
+		while (true) {
+			cv_.wait(lock, [this]{ return stop_ || !queue_.empty(); });
+			if (stop_) return;
+			auto job = std::move(queue_.front());
+			queue_.pop_front();
+			lock.unlock();
+			// Jobs already processed by other threads return immediately
+			job->process();
+			job.reset();
+			lock.lock();
+		}
+	}
+
+	std::mutex mutex_;
+	std::condition_variable cv_;
+	std::deque<std::shared_ptr<bands_job_t>> queue_;
+	bool stop_;
+	std::vector<std::thread> workers_;
+};
+
+band_workers& get_band_workers()
+{
+	static band_workers workers;
+	return workers;
+}
+
+}
+
+void run_bands(size_t count, size_t helpers, const std::function<void(size_t)>& band)
+{
+	if (!count) return;
+	helpers = std::min(helpers, count - 1);
+	if (!helpers) {
+		for (size_t i = 0; i < count; ++i) band(i);
+		return;
+	}
+	auto job = std::make_shared<bands_job_t>(count, band);
+	get_band_workers().submit(job, helpers);
+	job->process();
+	// Only bands already running in other threads remain, so this can't wait for a queued job
+	std::unique_lock<std::mutex> lock(job->mutex);
+	job->done_cv.wait(lock, [&job]{ return job->finished == job->count; });
+	if (job->error) std::rethrow_exception(job->error);
+}
+
+}
+}
+}
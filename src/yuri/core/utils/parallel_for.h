@@ -0,0 +1,68 @@
+/*!
+ * @file 		parallel_for.h
+ * @author 		agent <agent@local>
+ * @date 		18.10.2026
+ * @copyright	Institute of Intermedia, CTU in Prague, 2026
+ * 				Distributed under modified BSD Licence, details in file doc/LICENSE
+ *
+ */
+
+#ifndef SRC_YURI_CORE_UTILS_PARALLEL_FOR_H_
+#define SRC_YURI_CORE_UTILS_PARALLEL_FOR_H_
+
+#include "platform.h"
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+
+namespace yuri {
+namespace core {
+namespace utils {
+
+/*!
+ * Calls band(i) for every i in [0, count), using up to @em helpers threads
+ * from a process wide worker pool in addition to the calling thread.
+ * The calling thread processes bands as well, so nested calls can't deadlock.
+ * Returns after all bands are processed, rethrowing the first exception thrown by a band.
+ */
+EXPORT void run_bands(size_t count, size_t helpers, const std::function<void(size_t)>& band);
+
+/*!
+ * Splits range [start, end) into (at most) @em threads consecutive bands
+ * and calls f(band_start, band_end) for each of them.
+ *
+ * The bands are processed by the calling thread and the workers of a pool
+ * shared by the whole process, so no threads are started per call.
+ * The method returns after all bands are processed.
+ * Bands are never shorter than @em min_band items (except the last one).
+ *
+ * @param threads	Number of bands to use. Values 0 and 1 process the range serially.
+ * @param start		First item of the range
+ * @param end		One past the last item of the range
+ * @param f			Functor called as f(size_t, size_t)
+ * @param min_band	Minimal number of items in a band
+ */
+template<class F>
+void parallel_for(size_t threads, size_t start, size_t end, F&& f, size_t min_band = 1)
+{
+	if (end <= start) return;
+	const size_t total = end - start;
+	if (min_band < 1) min_band = 1;
+	threads = std::min(threads, total / min_band);
+	if (threads < 2) {
+		f(start, end);
+		return;
+	}
+	const size_t band = (total + threads - 1) / threads;
+	const size_t count = (total + band - 1) / band;
+	run_bands(count, count - 1, [&](size_t i) {
+		const size_t band_start = start + i * band;
+		f(band_start, std::min(band_start + band, end));
+	});
+}
+
+}
+}
+}
+
+#endif /* SRC_YURI_CORE_UTILS_PARALLEL_FOR_H_ */